@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Simulated time of the DFU download of a 144 KiB image to the x86_app
+ * partition, with the flash and host timings of dfu_sim.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dfu_sim.h"
+#include <partition.h>
+
+#ifdef CONFIG_USB_DFU_PIPELINE
+#define VARIANT "pipelined"
+#else
+#define VARIANT "synchronous"
+#endif
+
+#define IMAGE_SIZE (DFU_SIM_APP_PAGES * PAGE_SIZE)
+
+static uint8_t image_a[IMAGE_SIZE];
+static uint8_t image_b[IMAGE_SIZE];
+static uint8_t image_c[IMAGE_SIZE];
+
+static void report(const char *name, const struct dfu_sim_result *res)
+{
+    printf("%-11s %-14s %6.1f ms %6.1f KiB/s %3u erases %6u words %4u polls\n",
+           VARIANT, name, res->us / 1000.0,
+           IMAGE_SIZE / 1024.0 / (res->us / 1000000.0),
+           res->erases, res->words, res->polls);
+}
+
+int main(void)
+{
+    struct dfu_sim_result res;
+    unsigned int i;
+
+    srand(1);
+    for (i = 0; i < IMAGE_SIZE; i++) {
+        image_a[i] = rand();
+        image_b[i] = rand();
+    }
+    /* One page in ten changed */
+    memcpy(image_c, image_b, IMAGE_SIZE);
+    for (i = 0; i < DFU_SIM_APP_PAGES; i += 10)
+        image_c[i * PAGE_SIZE + 7] ^= 0x5a;
+
+    dfu_sim_init();
+    dfu_sim_download(image_a, IMAGE_SIZE, &res);
+    report("erased flash", &res);
+    dfu_sim_download(image_b, IMAGE_SIZE, &res);
+    report("new image", &res);
+    dfu_sim_download(image_b, IMAGE_SIZE, &res);
+    report("same image", &res);
+    dfu_sim_download(image_c, IMAGE_SIZE, &res);
+    report("10% changed", &res);
+    return 0;
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SoC memory, flash driver and USB host models for the host build of dnx(),
+ * see dfu_sim.h.
+ */
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "dfu_sim.h"
+#include "scss_registers.h"
+#include <dfu.h>
+#include <usb/usb.h>
+#include <usb/usb_api.h>
+#include <usb/usb_driver_interface.h>
+#include <bootlogic.h>
+#include <reboot.h>
+#include <soc_flash.h>
+#include <partition.h>
+#include <mem.h>
+#include <printk.h>
+#include <gpio/soc_gpio.h>
+#include <utils.h>
+#include "usb_setup.h"
+
+/* Class specific requests, see dfu.c */
+#define DFU_DETACH          0x00
+#define DFU_DNLOAD          0x01
+#define DFU_GETSTATUS       0x03
+#define DFU_CLRSTATUS       0x04
+#define DFU_ABORT           0x06
+
+/* Pages of the flash, up to the end of the sensor_core partition */
+#define FLASH_PAGES (ARC_PAGE_START + ARC_PAGE_NR)
+
+#define AONC_HZ 32768
+
+/* quark_se.c and dfu.c */
+extern uint8_t usb_gpio;
+extern volatile int dfu_reset;
+void dnx(void);
+int ClassHandleReq(usb_device_request_t *setup_packet, uint32_t *len,
+                   uint8_t **data);
+
+int dfu_sim_fail_page = -1;
+int dfu_sim_abort_after = -1;
+
+enum host_step {
+    HOST_DNLOAD,        /* next block of the image */
+    HOST_MANIFEST,      /* zero length DFU_DNLOAD */
+    HOST_GETSTATUS,
+    HOST_ABORT,
+    HOST_DETACH,
+    HOST_DONE,
+};
+
+static struct {
+    const uint8_t *image;
+    unsigned int len;
+    unsigned int block;     /* blocks sent */
+    int manifest;           /* the zero length DFU_DNLOAD was sent */
+    enum host_step step;
+    uint64_t next_us;       /* time of the next request */
+} host;
+
+static struct dfu_sim_result *result;
+static uint64_t sim_us;
+static jmp_buf sim_reboot;
+static uint8_t ep0_data[PAGE_SIZE];
+
+static void advance(uint64_t us)
+{
+    sim_us += us;
+    MMIO_REG_VAL_FROM_BASE(SCSS_REGISTER_BASE, SCSS_AONC_CNT) =
+        (uint32_t)(sim_us * AONC_HZ / 1000000);
+}
+
+static void map(uintptr_t addr, size_t size)
+{
+    void *p = mmap((void *)addr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (p != (void *)addr) {
+        fprintf(stderr, "cannot map %#lx\n", (unsigned long)addr);
+        exit(2);
+    }
+}
+
+void dfu_sim_init(void)
+{
+    static int mapped;
+
+    if (!mapped) {
+        map(BASE_FLASH_ADDR, FLASH_PAGES * PAGE_SIZE);
+        map(SCSS_REGISTER_BASE, 4096);
+        mapped = 1;
+    }
+    memset(dfu_sim_page(0), 0xff, FLASH_PAGES * PAGE_SIZE);
+    usb_gpio = 1;
+}
+
+uint32_t *dfu_sim_page(unsigned int page)
+{
+    return (uint32_t *)(uintptr_t)(BASE_FLASH_ADDR + page * PAGE_SIZE);
+}
+
+/* Flash driver */
+
+int soc_flash_block_erase(unsigned int start_block, unsigned int block_count)
+{
+    if (start_block + block_count > FLASH_PAGES)
+        return DRV_RC_OUT_OF_MEM;
+    advance((uint64_t)block_count * DFU_SIM_ERASE_US);
+    memset(dfu_sim_page(start_block), 0xff, block_count * PAGE_SIZE);
+    result->erases += block_count;
+    return DRV_RC_OK;
+}
+
+int soc_flash_write(uint32_t address, unsigned int len, unsigned int *retlen,
+                    uint32_t *data)
+{
+    uint32_t *flash = dfu_sim_page(0) + address / 4;
+    unsigned int i;
+
+    *retlen = 0;
+    if (address % 4 || address / 4 + len > FLASH_PAGES * PAGE_SIZE / 4)
+        return DRV_RC_OUT_OF_MEM;
+    if (dfu_sim_fail_page >= 0 &&
+        address / PAGE_SIZE == DFU_SIM_APP_PAGE + (unsigned int)dfu_sim_fail_page)
+        return DRV_RC_CHECK_FAIL;
+
+    for (i = 0; i < len; i++) {
+        if (flash[i] != 0xffffffff)
+            result->dirty++;
+        flash[i] &= data[i];
+    }
+    advance((uint64_t)len * DFU_SIM_WORD_US);
+    result->words += len;
+    *retlen = len;
+    return DRV_RC_OK;
+}
+
+/* USB host */
+
+static void request(uint8_t type, uint8_t req, uint16_t value, uint16_t len)
+{
+    usb_device_request_t setup;
+    uint32_t data_len = len;
+    uint8_t *data = ep0_data;
+
+    setup.bmRequestType = type;
+    setup.bRequest = req;
+    USETW(setup.wValue, value);
+    USETW(setup.wIndex, 0);
+    USETW(setup.wLength, len);
+    ClassHandleReq(&setup, &data_len, &data);
+}
+
+static void host_get_status(void)
+{
+    unsigned int poll_ms;
+
+    request(UT_READ_CLASS_INTERFACE, DFU_GETSTATUS, 0, 6);
+    result->polls++;
+    poll_ms = ep0_data[1] | ep0_data[2] << 8 | ep0_data[3] << 16;
+
+    if (ep0_data[4] == dfuERROR) {
+        result->status = ep0_data[0];
+        result->error_block = host.manifest ? (int)host.block
+                                            : (int)host.block - 1;
+        host.step = HOST_DETACH;
+        host.next_us = sim_us + DFU_SIM_STATUS_US;
+    } else if (ep0_data[4] == dfuDNBUSY) {
+        host.next_us = sim_us + poll_ms * 1000;
+    } else if (host.manifest) {
+        host.step = HOST_DETACH;
+        host.next_us = sim_us + DFU_SIM_STATUS_US;
+    } else if (dfu_sim_abort_after >= 0 &&
+               host.block == (unsigned int)dfu_sim_abort_after) {
+        host.step = HOST_ABORT;
+        host.next_us = sim_us + DFU_SIM_STATUS_US;
+    } else if (host.block * PAGE_SIZE < host.len) {
+        host.step = HOST_DNLOAD;
+        host.next_us = sim_us + DFU_SIM_BLOCK_US;
+    } else {
+        host.step = HOST_MANIFEST;
+        host.next_us = sim_us + DFU_SIM_STATUS_US;
+    }
+}
+
+void poll_usb(void)
+{
+    unsigned int len;
+
+    if (sim_us < host.next_us) {
+        advance(DFU_SIM_LOOP_US);
+        return;
+    }
+
+    switch (host.step) {
+    case HOST_DNLOAD:
+        len = host.len - host.block * PAGE_SIZE;
+        if (len > PAGE_SIZE)
+            len = PAGE_SIZE;
+        memcpy(ep0_data, host.image + host.block * PAGE_SIZE, len);
+        request(UT_WRITE_CLASS_INTERFACE, DFU_DNLOAD, host.block, len);
+        host.block++;
+        host.step = HOST_GETSTATUS;
+        host.next_us = sim_us + DFU_SIM_STATUS_US;
+        break;
+    case HOST_MANIFEST:
+        request(UT_WRITE_CLASS_INTERFACE, DFU_DNLOAD, host.block, 0);
+        host.manifest = 1;
+        host.step = HOST_GETSTATUS;
+        host.next_us = sim_us + DFU_SIM_STATUS_US;
+        break;
+    case HOST_GETSTATUS:
+        host_get_status();
+        break;
+    case HOST_ABORT:
+        request(UT_WRITE_CLASS_INTERFACE, DFU_ABORT, 0, 0);
+        host.step = HOST_DETACH;
+        host.next_us = sim_us + DFU_SIM_STATUS_US;
+        break;
+    case HOST_DETACH:
+        request(UT_WRITE_CLASS_INTERFACE, DFU_DETACH, 0, 0);
+        host.step = HOST_DONE;
+        break;
+    case HOST_DONE:
+        advance(DFU_SIM_LOOP_US);
+        break;
+    }
+}
+
+void dfu_sim_download(const uint8_t *image, unsigned int len,
+                      struct dfu_sim_result *res)
+{
+    memset(res, 0, sizeof(*res));
+    res->status = statusOK;
+    res->error_block = -1;
+    result = res;
+
+    memset(&host, 0, sizeof(host));
+    host.image = image;
+    host.len = len;
+    host.step = HOST_DNLOAD;
+    host.next_us = DFU_SIM_BLOCK_US;
+    sim_us = 0;
+    advance(0);
+    dfu_reset = 0;
+
+    /* As dfu-util, clear the error of a previous download */
+    request(UT_WRITE_CLASS_INTERFACE, DFU_CLRSTATUS, 0, 0);
+    request(UT_WRITE_INTERFACE, UR_SET_INTERFACE, DFU_SIM_ALT, 0);
+
+    if (setjmp(sim_reboot) == 0) {
+        dnx();
+        fprintf(stderr, "dnx() returned without reboot\n");
+        exit(2);
+    }
+}
+
+/* Bootloader and USB driver stubs */
+
+void reboot(enum boot_targets target)
+{
+    result->us = sim_us;
+    longjmp(sim_reboot, 1);
+}
+
+enum boot_targets get_boot_target(void)
+{
+    return TARGET_MAIN;
+}
+
+int printk(int level, const char *fmt, ...)
+{
+    return 0;
+}
+
+void *balloc(uint32_t size)
+{
+    return malloc(size);
+}
+
+void bfree(void *buffer)
+{
+    free(buffer);
+}
+
+uint8_t soc_gpio_set_config(uint8_t port_id, uint8_t bit,
+                            gpio_cfg_data_t *config)
+{
+    return DRV_RC_OK;
+}
+
+uint8_t soc_gpio_read(uint8_t port_id, uint8_t bit)
+{
+    return 1;
+}
+
+void platform_usb_init(void)
+{
+}
+
+void platform_usb_release(void)
+{
+}
+
+int usb_driver_init(uint32_t base_addr)
+{
+    return 0;
+}
+
+void usb_shared_interface_init(void)
+{
+}
+
+int usb_interface_init(struct usb_interface_init_data *init_data)
+{
+    return 0;
+}
+
+usb_device_descriptor_t dfu_device_desc;
+struct dfu_usb_descriptor dfu_config_desc;
+usb_string_descriptor_t dfu_strings_desc[13];
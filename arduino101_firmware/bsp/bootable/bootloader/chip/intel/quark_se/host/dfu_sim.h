@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of the DFU download path of quark_se.c and dfu.c. The flash,
+ * the OTP and the SCSS registers are memory mapped at their addresses on the
+ * SoC, the flash driver and the USB host are timing models sharing one
+ * simulated clock:
+ *  - a page erase takes DFU_SIM_ERASE_US, a word is programmed in
+ *    DFU_SIM_WORD_US; programming a word that is not erased is counted,
+ *  - the host behaves like dfu-util: each block takes DFU_SIM_BLOCK_US on
+ *    the bus, then it polls DFU_GETSTATUS every DFU_SIM_STATUS_US until
+ *    the device is no longer busy. The controller receives the data stage
+ *    on its own, the request is handled by the next poll_usb() call,
+ *  - an iteration of the dnx() loop with nothing to do takes
+ *    DFU_SIM_LOOP_US.
+ */
+
+#ifndef __DFU_SIM_H__
+#define __DFU_SIM_H__
+
+#include <stdint.h>
+
+#define DFU_SIM_ERASE_US  2000
+#define DFU_SIM_WORD_US   10
+#define DFU_SIM_BLOCK_US  2000
+#define DFU_SIM_STATUS_US 1000
+#define DFU_SIM_LOOP_US   5
+
+/* Alternate setting of the x86_app partition, and its first page */
+#define DFU_SIM_ALT       2
+#define DFU_SIM_APP_PAGE  32
+#define DFU_SIM_APP_PAGES 72
+
+struct dfu_sim_result {
+    uint64_t us;            /* from the first block to the reboot */
+    unsigned int erases;    /* pages erased */
+    unsigned int words;     /* words programmed */
+    unsigned int dirty;     /* words programmed without an erase */
+    unsigned int polls;     /* DFU_GETSTATUS requests */
+    int status;             /* DFU status reported to the host */
+    int error_block;        /* block whose request reported it, or -1 */
+};
+
+/** Flash write of this page fails, -1 for none */
+extern int dfu_sim_fail_page;
+
+/** The host aborts after that many blocks, -1 for a complete download */
+extern int dfu_sim_abort_after;
+
+/**
+ * Map the memory of the SoC, the flash is erased.
+ */
+void dfu_sim_init(void);
+
+/**
+ * Return the address of a flash page.
+ */
+uint32_t *dfu_sim_page(unsigned int page);
+
+/**
+ * Download an image to the x86_app partition through dnx().
+ *
+ * @param image image to download
+ * @param len   size of the image in bytes, a multiple of 4
+ * @param res   measurements of the download
+ */
+void dfu_sim_download(const uint8_t *image, unsigned int len,
+                      struct dfu_sim_result *res);
+
+#endif /* __DFU_SIM_H__ */
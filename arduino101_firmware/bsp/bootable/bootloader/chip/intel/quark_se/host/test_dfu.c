@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the DFU download of dnx() into the flash, built with and without
+ * CONFIG_USB_DFU_PIPELINE:
+ *  - the flash holds the image, whatever it held before, and no word is
+ *    programmed without an erase,
+ *  - the end of the last page is erased,
+ *  - a flash error is reported to the host, at the latest by the request
+ *    that follows the next block or by the end of the download, and no
+ *    page is written after it,
+ *  - when the host aborts, the blocks already acknowledged are written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dfu_sim.h"
+#include <dfu.h>
+#include <partition.h>
+
+#ifdef CONFIG_USB_DFU_PIPELINE
+#define TEST_NAME "test_dfu"
+#else
+#define TEST_NAME "test_dfu_sync"
+#endif
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define IMAGE_SIZE (DFU_SIM_APP_PAGES * PAGE_SIZE)
+
+static uint8_t image_a[IMAGE_SIZE];
+static uint8_t image_b[IMAGE_SIZE];
+
+static void fill(uint8_t *image, unsigned int seed)
+{
+    unsigned int i;
+
+    srand(seed);
+    for (i = 0; i < IMAGE_SIZE; i++)
+        image[i] = rand();
+}
+
+/* Pages first to first + count - 1 of the partition hold the image */
+static int holds(const uint8_t *image, unsigned int first, unsigned int count)
+{
+    return memcmp(dfu_sim_page(DFU_SIM_APP_PAGE + first),
+                  image + first * PAGE_SIZE, count * PAGE_SIZE) == 0;
+}
+
+static int erased(unsigned int page, unsigned int offset)
+{
+    const uint8_t *p = (const uint8_t *)dfu_sim_page(DFU_SIM_APP_PAGE + page);
+    unsigned int i;
+
+    for (i = offset; i < PAGE_SIZE; i++)
+        if (p[i] != 0xff)
+            return 0;
+    return 1;
+}
+
+static void check_download(void)
+{
+    struct dfu_sim_result res;
+    unsigned int tail = 10 * PAGE_SIZE + 100;
+
+    dfu_sim_init();
+
+    /* Erased flash, then another image, then the same one */
+    dfu_sim_download(image_a, IMAGE_SIZE, &res);
+    CHECK(res.status == statusOK);
+    CHECK(holds(image_a, 0, DFU_SIM_APP_PAGES));
+    CHECK(res.dirty == 0);
+
+    dfu_sim_download(image_b, IMAGE_SIZE, &res);
+    CHECK(res.status == statusOK);
+    CHECK(holds(image_b, 0, DFU_SIM_APP_PAGES));
+    CHECK(res.dirty == 0);
+
+    dfu_sim_download(image_b, IMAGE_SIZE, &res);
+    CHECK(res.status == statusOK);
+    CHECK(holds(image_b, 0, DFU_SIM_APP_PAGES));
+    CHECK(res.dirty == 0);
+
+    /* A short image, the last block is not a full page */
+    dfu_sim_download(image_a, tail, &res);
+    CHECK(res.status == statusOK);
+    CHECK(holds(image_a, 0, 10));
+    CHECK(memcmp(dfu_sim_page(DFU_SIM_APP_PAGE + 10), image_a + 10 * PAGE_SIZE,
+                 100) == 0);
+    CHECK(erased(10, 100));
+    CHECK(holds(image_b, 11, DFU_SIM_APP_PAGES - 11));
+    CHECK(res.dirty == 0);
+}
+
+static void check_error(int page)
+{
+    struct dfu_sim_result res;
+    int last;
+
+    dfu_sim_init();
+    dfu_sim_download(image_a, IMAGE_SIZE, &res);
+
+    dfu_sim_fail_page = page;
+    dfu_sim_download(image_b, IMAGE_SIZE, &res);
+    dfu_sim_fail_page = -1;
+
+    CHECK(res.status == errWRITE);
+    /* Reported by the status poll of the failed block, of the next one,
+     * or by the end of the download */
+    CHECK(res.error_block >= page);
+    CHECK(res.error_block <= page + 1);
+    last = res.error_block < DFU_SIM_APP_PAGES ? res.error_block
+                                               : DFU_SIM_APP_PAGES - 1;
+    /* Nothing is written after the failed page but the pages already
+     * acknowledged */
+    CHECK(holds(image_b, 0, page));
+    if (last + 1 < DFU_SIM_APP_PAGES)
+        CHECK(holds(image_a, last + 1, DFU_SIM_APP_PAGES - last - 1));
+    CHECK(res.dirty == 0);
+
+    /* The next download starts afresh */
+    dfu_sim_download(image_b, IMAGE_SIZE, &res);
+    CHECK(res.status == statusOK);
+    CHECK(holds(image_b, 0, DFU_SIM_APP_PAGES));
+}
+
+static void check_abort(void)
+{
+    struct dfu_sim_result res;
+
+    dfu_sim_init();
+    dfu_sim_download(image_a, IMAGE_SIZE, &res);
+
+    dfu_sim_abort_after = 30;
+    dfu_sim_download(image_b, IMAGE_SIZE, &res);
+    dfu_sim_abort_after = -1;
+
+    CHECK(res.status == statusOK);
+    CHECK(holds(image_b, 0, 30));
+    CHECK(holds(image_a, 30, DFU_SIM_APP_PAGES - 30));
+    CHECK(res.dirty == 0);
+}
+
+int main(void)
+{
+    fill(image_a, 1);
+    fill(image_b, 2);
+
+    check_download();
+    check_error(0);
+    check_error(20);
+    check_error(DFU_SIM_APP_PAGES - 1);
+    check_abort();
+
+    printf("%s %s\n", failures ? "FAIL" : "PASS", TEST_NAME);
+    return failures ? 1 : 0;
+}
@@ -48,6 +48,10 @@
 #include <dfu.h>
 #endif
 
+#if defined(CONFIG_USB_DFU_DELTA)
+#include <dfu_delta.h>
+#endif
+
 #if defined(CONFIG_SWD)
 #include <swd/swd.h>
 #endif
@@ -59,6 +63,8 @@
 
 #include <mem.h>
 #include <bootlogic.h>
+#include <reboot.h>
+#include <soc_flash.h>
 
 #ifndef NULL
 #define NULL 0
@@ -101,6 +107,14 @@ void set_oscillator(int internal)
 	}
 }
 
+#if defined(CONFIG_USB) && defined(CONFIG_USB_DFU) && defined(CONFIG_DNX)
+/* The USB driver allocates with an int size */
+static void *usb_balloc(int size)
+{
+	return balloc(size);
+}
+#endif
+
 /* Soc Specific initialization */
 void soc_init(void)
 {
@@ -122,7 +136,7 @@ void soc_init(void)
 
 #if defined(CONFIG_USB) && defined(CONFIG_USB_DFU) && defined(CONFIG_DNX)
 	usb_driver_os_dep->printk = printk;
-	usb_driver_os_dep->alloc = balloc;
+	usb_driver_os_dep->alloc = usb_balloc;
 	usb_driver_os_dep->free = bfree;
 
 	SET_PIN_MODE(7, QRK_PMUX_SEL_MODEA);
@@ -174,6 +188,152 @@ void usb_init(void)
  */
 extern int dfu_reset;
 uint8_t dfu_busy;
+
+#ifdef CONFIG_USB_DFU_PIPELINE
+/*
+ * Pipelined download: a block is copied into one of two page buffers and
+ * the DFU_DNLOAD request completes at once. The page is then erased and
+ * programmed from the dnx() loop, one step per iteration, so that the
+ * host can send the next block into the other buffer meanwhile. The host
+ * is only held in dfuDNBUSY while both buffers are pending.
+ *
+ * A flash error is reported by the first request that follows it: the
+ * status poll, the next DFU_DNLOAD, or the zero length DFU_DNLOAD that
+ * ends the download.
+ */
+
+/* Number of words programmed per dnx() loop iteration */
+#define DFU_PROGRAM_CHUNK 64
+
+struct dfu_page {
+	uint32_t block;		/* flash block to write */
+	uint32_t len;		/* number of words to program */
+	uint32_t done;		/* number of words already programmed */
+	uint8_t erase;		/* block must be erased first */
+	uint32_t data[PAGE_SIZE / 4];
+};
+
+static struct dfu_page dfu_pages[2];
+static uint8_t dfu_page_head;	/* oldest pending page */
+static uint8_t dfu_page_count;	/* number of pending pages */
+static int dfu_page_status = statusOK;
+static struct dfu_ops *dfu_page_ops;
+
+static void dfu_flash_process(void)
+{
+	struct dfu_page *page = &dfu_pages[dfu_page_head];
+	unsigned int len;
+	unsigned int retlen;
+
+	if (dfu_page_count == 0)
+		return;
+
+	if (page->erase) {
+		page->erase = 0;
+		if (soc_flash_block_erase(page->block, 1) != 0) {
+			dfu_page_status = errERASE;
+			goto error;
+		}
+		return;
+	}
+
+	len = page->len - page->done;
+	if (len > DFU_PROGRAM_CHUNK)
+		len = DFU_PROGRAM_CHUNK;
+	if (len > 0) {
+		if (soc_flash_write(page->block * PAGE_SIZE + page->done * 4,
+				    len, &retlen,
+				    page->data + page->done) != DRV_RC_OK) {
+			dfu_page_status = errWRITE;
+			goto error;
+		}
+		page->done += len;
+	}
+	if (page->done == page->len) {
+		dfu_page_head ^= 1;
+		dfu_page_count--;
+	}
+	return;
+
+error:
+	pr_info("Flash error on block %d\n", page->block);
+	/* Drop the pending pages, the download has failed */
+	dfu_page_count = 0;
+	dfu_page_ops->state = dfuERROR;
+	dfu_page_ops->status = dfu_page_status;
+}
+
+/*
+ * Queue the programming of a flash block, data is padded with erased words
+ * up to the page size. Unchanged blocks are skipped.
+ */
+static int dfu_flash_program(unsigned int block, const uint32_t *data,
+			     unsigned int len)
+{
+	uint32_t *flash = (uint32_t *)(uintptr_t)(BASE_FLASH_ADDR
+						   + block * PAGE_SIZE);
+	struct dfu_page *page;
+	int unchanged = 1;
+	int blank = 1;
+	int i;
+
+	/* Both buffers are in use, wait for the oldest one */
+	while (dfu_page_count == 2)
+		dfu_flash_process();
+	if (dfu_page_status != statusOK)
+		return dfu_page_status;
+
+	page = &dfu_pages[(dfu_page_head + dfu_page_count) & 1];
+	/* The end of the page is erased, as when the whole page is written */
+	for (i = 0; i < PAGE_SIZE / 4; i++) {
+		page->data[i] = (i < len) ? data[i] : 0xffffffff;
+		if (flash[i] != page->data[i])
+			unchanged = 0;
+		if (flash[i] != 0xffffffff)
+			blank = 0;
+	}
+	if (unchanged)
+		return statusOK;
+
+	page->block = block;
+	page->len = len;
+	page->done = 0;
+	page->erase = !blank;
+	dfu_page_count++;
+	return statusOK;
+}
+
+/* No buffer is free for the next block */
+static int dfu_flash_busy(struct dfu_ops *ops)
+{
+	return dfu_page_count == 2;
+}
+
+/* Complete the pending writes */
+static void dfu_flash_drain(void)
+{
+	while (dfu_page_count)
+		dfu_flash_process();
+}
+#else
+static int dfu_flash_program(unsigned int block, const uint32_t *data,
+			     unsigned int len)
+{
+	unsigned int retlen;
+	int ret;
+
+	pr_info("Flash erase: %d \n", block);
+	ret = soc_flash_block_erase(block, 1);
+	pr_info("Flash return %d\n", ret);
+	pr_info("Flash write: %x len %d\n", BASE_FLASH_ADDR + block * PAGE_SIZE,
+		len * 4);
+	ret = soc_flash_write(block * PAGE_SIZE, len, &retlen,
+			      (uint32_t *)data);
+	pr_info("Flash return %d len:%d\n", ret, retlen);
+	return (ret == DRV_RC_OK) ? statusOK : errWRITE;
+}
+#endif
+
 void dnx(void)
 {
 	uint32_t saved_date, current_date;
@@ -195,7 +355,14 @@ void dnx(void)
 	       (dfu_busy || ((saved_date + timeout_ticks) > current_date))) {
 		current_date = get_32k_time();
 		poll_usb();
+#ifdef CONFIG_USB_DFU_PIPELINE
+		dfu_flash_process();
+#endif
 	}
+#ifdef CONFIG_USB_DFU_PIPELINE
+	/* The host may reset the device before the end of the download */
+	dfu_flash_drain();
+#endif
 	platform_usb_release();
 	if (dfu_reset)
 		reboot(TARGET_MAIN);
@@ -255,34 +422,112 @@ void dfu_forbidden_transfer(struct dfu_ops *ops)
 	ops->status = errTARGET;
 }
 
+static uint32_t dfu_forbidden_read(struct dfu_ops *ops)
+{
+	dfu_forbidden_transfer(ops);
+	return 0;
+}
+
+#ifdef CONFIG_USB_DFU_DELTA
+static unsigned int dfu_delta_block;	/* first block of the patched partition */
+static uint8_t dfu_delta_active;
+
+static int dfu_delta_program(unsigned int page, const uint32_t *data)
+{
+	return dfu_flash_program(dfu_delta_block + page, data, PAGE_SIZE / 4);
+}
+#endif
+
 void dfu_flash_write(struct dfu_ops *ops)
 {
 	usb_device_request_t *setup_packet = ops->device_request;
-	int retlen;
-	int ret;
-	unsigned int address = (flash_blocks[ops->alternate].block_start
-				+ UGETW(setup_packet->wValue)) * PAGE_SIZE;
 	unsigned int start_blk = flash_blocks[ops->alternate].block_start;
+	int status;
+
+	if (UGETW(setup_packet->wValue) == 0) {
+#ifdef CONFIG_USB_DFU_PIPELINE
+		/* A new download clears the error of the previous one */
+		dfu_page_status = statusOK;
+#endif
+#ifdef CONFIG_USB_DFU_DELTA
+		dfu_delta_active = dfu_delta_is_patch(ops->data, ops->len);
+		if (dfu_delta_active) {
+			dfu_delta_block = start_blk;
+			dfu_delta_begin((const uint8_t *)(BASE_FLASH_ADDR
+							  + start_blk * PAGE_SIZE),
+					flash_blocks[ops->alternate].block_count,
+					dfu_delta_program);
+		}
+#endif
+	}
+#ifdef CONFIG_USB_DFU_PIPELINE
+	dfu_page_ops = ops;
+#endif
 
+#ifdef CONFIG_USB_DFU_DELTA
+	if (dfu_delta_active) {
+		status = dfu_delta_push(ops->data, ops->len);
+	} else
+#endif
 	if (UGETW(setup_packet->wValue)
-	    > flash_blocks[ops->alternate].block_count - 1) {
-		ops->state = dfuERROR;
-		ops->status = errADDRESS;
-		return;
+	    > flash_blocks[ops->alternate].block_count - 1
+	    || ops->len > PAGE_SIZE) {
+		status = errADDRESS;
+	} else {
+		status = dfu_flash_program(start_blk + UGETW(setup_packet->wValue),
+					   (uint32_t *)ops->data, ops->len / 4);
 	}
 
-	pr_info("Flash erase: %d \n", start_blk + UGETW(setup_packet->wValue));
-	ret = soc_flash_block_erase(start_blk + UGETW(setup_packet->wValue), 1);
-	pr_info("Flash return %d\n", ret);
-	pr_info("Flash write: %x len %d\n", 0x40000000 + address, ops->len);
-	if ((ret = soc_flash_write(address, ops->len / 4, &retlen,
-			      (unsigned char *)(ops->data))) == DRV_RC_OK){
-	    ops->state = dfuDNLOAD_IDLE;
+	if (status == statusOK) {
+#ifdef CONFIG_USB_DFU_PIPELINE
+		/* Hold the host until a buffer is free, see DFU_GETSTATUS */
+		ops->state = dfu_flash_busy(ops) ? dfuDNBUSY : dfuDNLOAD_IDLE;
+#else
+		ops->state = dfuDNLOAD_IDLE;
+#endif
 	} else {
-	    ops->state = dfuERROR;
-	    ops->status = errWRITE;
+		ops->state = dfuERROR;
+		ops->status = status;
 	}
-	pr_info("Flash return %d len:%d\n", ret, retlen);
+}
+
+/* Complete the download once the last block has been received */
+static void dfu_flash_flush(struct dfu_ops *ops)
+{
+	int status = statusOK;
+
+#ifdef CONFIG_USB_DFU_PIPELINE
+	dfu_flash_drain();
+	status = dfu_page_status;
+#endif
+#ifdef CONFIG_USB_DFU_DELTA
+	if (dfu_delta_active) {
+		dfu_delta_active = 0;
+		if (status == statusOK)
+			status = dfu_delta_end();
+#ifdef CONFIG_USB_DFU_PIPELINE
+		/* dfu_delta_end() clears the journal */
+		dfu_flash_drain();
+		if (status == statusOK)
+			status = dfu_page_status;
+#endif
+	}
+#endif
+	if (status != statusOK) {
+		ops->state = dfuERROR;
+		ops->status = status;
+	}
+}
+
+/* Write the blocks already received when the host aborts the download */
+static void dfu_flash_abort(struct dfu_ops *ops)
+{
+#ifdef CONFIG_USB_DFU_PIPELINE
+	dfu_flash_drain();
+#endif
+#ifdef CONFIG_USB_DFU_DELTA
+	dfu_delta_active = 0;
+#endif
 }
 
 uint32_t dfu_flash_read(struct dfu_ops *ops)
@@ -355,12 +600,11 @@ uint32_t dfu_swd_read(struct dfu_ops * ops)
 		ops->state = dfuERROR;
 		ops->status = errWRITE;
 	}
-
-	return 0;
 #endif
+	return 0;
 }
 
-uint32_t dfu_swd_write(struct dfu_ops * ops)
+void dfu_swd_write(struct dfu_ops * ops)
 {
 #if defined(CONFIG_SWD)
 	usb_device_request_t *setup_packet = ops->device_request;
@@ -376,14 +620,15 @@ uint32_t dfu_swd_write(struct dfu_ops * ops)
 	if (address > BLE_CORE_FLASH_SIZE - PAGE_SIZE) {
 		ops->state = dfuIDLE;
 		ops->len = 0;
-		return 0;
+		return;
 	}
 
 	ret = swd_load_image(address, (uint32_t *) (ops->data), ops->len);
-	if (ret == SWD_ERROR_OK) {
+	if (ret == SWD_ERROR_OK)
 		ret =
 		    swd_verify_image(address, (uint32_t *) (ops->data),
 				     ops->len);
+	if (ret == SWD_ERROR_OK) {
 		ops->state = dfuDNLOAD_IDLE;
 	} else {
 		ops->state = dfuERROR;
@@ -394,6 +639,9 @@ uint32_t dfu_swd_write(struct dfu_ops * ops)
 
 void dfu_set_alternate(struct dfu_ops *ops)
 {
+	ops->flush = NULL;
+	ops->abort = NULL;
+	ops->busy = NULL;
 	switch (ops->alternate) {
 	case 0: /* rom */
 		ops->write = dfu_forbidden_transfer;
@@ -411,6 +659,11 @@ void dfu_set_alternate(struct dfu_ops *ops)
 	case 7: /* arc.bin */
 		ops->write = dfu_flash_write;
 		ops->read = dfu_flash_read;
+		ops->flush = dfu_flash_flush;
+		ops->abort = dfu_flash_abort;
+#ifdef CONFIG_USB_DFU_PIPELINE
+		ops->busy = dfu_flash_busy;
+#endif
 		break;
 	case 8:
 		/* ble_core */
@@ -419,7 +672,7 @@ void dfu_set_alternate(struct dfu_ops *ops)
 		break;
 	default:
 		ops->write = dfu_forbidden_transfer;
-		ops->read = dfu_forbidden_transfer;
+		ops->read = dfu_forbidden_read;
 		break;
 	}
 }
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Request and data phases of hw_btfu_dap.c before the PHY was rewritten with
+ * request tables and word shifts. test_swd_phy.cpp checks that the current
+ * PHY clocks the same bits.
+ */
+
+static btfu_dap_error_t ref_readReg(uint8_t ap, int reg, uint32_t *data)
+{
+    int i;
+    uint32_t cb = 0;
+    uint32_t parity;
+    uint32_t b;
+    uint32_t ack = 0;
+    btfu_dap_error_t ret = SWD_ERROR_OK;
+
+    /* Initalize output variable */
+    *data = 0;
+
+    /* Convert to int */
+    int _read = (int) 1;
+
+    int A2 = reg & 0x1;
+    int A3 = (reg >> 1) & 0x1;
+
+    /* Calulate parity */
+    parity = (ap + _read + A2 + A3) & 0x1;
+
+    swd_gpio_set_output(NRF_SWDIO_PIN);
+
+    /* Send request */
+    WRITE_BIT(1);
+    WRITE_BIT(ap);
+    WRITE_BIT(_read);
+    WRITE_BIT(A2);
+    WRITE_BIT(A3);
+    WRITE_BIT(parity);
+    WRITE_BIT(0);
+    WRITE_BIT(1);
+
+    /* Turnaround */
+    swd_gpio_set_input(NRF_SWDIO_PIN);
+
+    SWCLK_CYCLE();
+
+    /* Read ACK */
+    for (i = 0; i < 3; i++) {
+        READ_A_BIT(b);
+        ack |= b << i;
+    }
+
+    /* Verify that ACK is OK */
+    if (ack == ACK_OK) {
+
+        for (i = 0; i < 32; i++) {
+            /* Read bit */
+            READ_A_BIT(b);
+            *data |= b << i;
+
+            /* Keep track of expected parity */
+            if (b)
+                cb = !cb;
+        }
+
+        /* Read parity bit */
+        READ_A_BIT(parity);
+
+        /* Verify parity */
+        if (cb == parity) {
+            ret = SWD_ERROR_OK;
+        } else {
+            ret = SWD_ERROR_PARITY;
+        }
+
+    } else if (ack == ACK_WAIT) {
+        ret = SWD_ERROR_WAIT;
+    } else if (ack == ACK_FAULT) {
+        ret = SWD_ERROR_FAULT;
+    } else {
+        /* Line not driven. Protocol error */
+        ret = SWD_ERROR_PROTOCOL;
+    }
+
+    /* Turnaround */
+    SWCLK_CYCLE();
+
+    /* 8-cycle idle period. Make sure transaction
+     * is clocked through DAP. */
+    swd_gpio_set_output(NRF_SWDIO_PIN);
+
+    for (i = 0; i < 8; i++) {
+        WRITE_BIT(0);
+    }
+
+    return ret;
+}
+
+
+/**********************************************************
+ * Writes to a DP or AP register.
+ *
+ * @param ap
+ *   If this parameter is true, write to AP register.
+ *   If false write to DP register.
+ *
+ * @param reg
+ *   The register number [0-3] to write to
+ *
+ * @param data
+ *   The value to write to the register
+ **********************************************************/
+static btfu_dap_error_t ref_writeReg(uint8_t ap, int reg, uint32_t data,
+                                 uint8_t ignoreAck)
+{
+    uint32_t ack = 0;
+    int i;
+    uint32_t parity = 0;
+    uint32_t b;
+    btfu_dap_error_t ret = SWD_ERROR_OK;
+
+    /* Convert to int */
+    int _read = (int) 0;
+
+    /* Calulate address bits */
+    int A2 = reg & 0x1;
+    int A3 = (reg >> 1) & 0x1;
+
+    /* Calculate parity */
+    parity = (ap + _read + A2 + A3) & 0x1;
+
+    swd_gpio_set_output(NRF_SWDIO_PIN);
+
+  /* Write request */
+    WRITE_BIT(1);
+    WRITE_BIT(ap);
+    WRITE_BIT(_read);
+    WRITE_BIT(A2);
+    WRITE_BIT(A3);
+    WRITE_BIT(parity);
+    WRITE_BIT(0);
+    WRITE_BIT(1);
+
+    swd_gpio_set_input(NRF_SWDIO_PIN);
+
+    /* Turnaround */
+    SWCLK_CYCLE();
+
+    /* Read acknowledge */
+    for (i = 0; i < 3; i++) {
+        READ_A_BIT(b);
+        ack |= b << i;
+    }
+
+    if (ack == ACK_OK || ignoreAck == 1) {
+        /* Turnaround */
+        SWCLK_CYCLE();
+        swd_gpio_set_output(NRF_SWDIO_PIN);
+
+        /* Write data */
+        parity = 0;
+        for (i = 0; i < 32; i++) {
+            b = (data >> i) & 0x1;
+            WRITE_BIT(b);
+            if (b)
+                parity = !parity;
+        }
+
+        /* Write parity bit */
+        WRITE_BIT(parity);
+
+    } else if (ack == ACK_WAIT) {
+        ret = SWD_ERROR_WAIT;
+    } else if (ack == ACK_FAULT) {
+        ret = SWD_ERROR_FAULT;
+    } else {
+        /* Line not driven. Protocol error */
+        ret = SWD_ERROR_PROTOCOL;
+    }
+
+    /* 8-cycle idle period. Make sure transaction
+     * is clocked through DAP. */
+    swd_gpio_set_output(NRF_SWDIO_PIN);
+
+    for (i = 0; i < 8; i++) {
+        WRITE_BIT(0);
+    }
+
+    return ret;
+
+}
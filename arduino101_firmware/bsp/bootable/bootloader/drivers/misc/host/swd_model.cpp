@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <map>
+#include <string>
+#include <string.h>
+#include "swd_model.h"
+
+extern "C" {
+#include <swd/swd.h>
+}
+
+#define DIO_BIT (1u << NRF_SWDIO_PIN)
+#define CLK_BIT (1u << NRF_SWCLK_PIN)
+
+#define GPIO_DR  (SOC_GPIO_BASE_ADDR + SOC_GPIO_SWPORTA_DR)
+#define GPIO_DDR (SOC_GPIO_BASE_ADDR + SOC_GPIO_SWPORTA_DDR)
+#define GPIO_EXT (SOC_GPIO_BASE_ADDR + SOC_GPIO_EXT_PORTA)
+
+/* Consecutive high bits that reset the line */
+#define LINE_RESET_BITS 50
+
+#define DP_CTRL_PWRUPREQ  (DP_CTRL_CDBGPWRUPREQ | DP_CTRL_CSYSPWRUPREQ)
+#define DP_CTRL_STICKY    (DP_CTRL_STICKYORUN | DP_CTRL_STICKYCMP | \
+                           DP_CTRL_STICKYERR | DP_CTRL_WDATAERR)
+#define AP_CSW_ADDRINC_MSK 0x30
+
+#define DHCSR_DBGKEY   0xA05F0000
+#define DHCSR_C_HALT   (1 << 1)
+#define AIRCR_VECTKEY  0x05FA0000
+
+#define UICR_SIZE      0x100
+
+enum link_state {
+    LINK_RESET,    /* after a line reset, waiting for the idle bits */
+    LINK_IDLE,     /* waiting for a start bit */
+    LINK_REQUEST,  /* receiving the request header */
+    LINK_TRN_ACK,  /* turnaround before the acknowledge */
+    LINK_ACK,      /* sending the acknowledge */
+    LINK_RDATA,    /* sending the read data and parity */
+    LINK_TRN_WDATA,/* turnaround before the write data */
+    LINK_WDATA,    /* receiving the write data and parity */
+    LINK_TRN_END,  /* turnaround back to the host */
+    LINK_LOCKOUT,  /* protocol error, silent until the next line reset */
+};
+
+static struct {
+    /* GPIO */
+    uint32_t dr;
+    uint32_t ddr;
+    std::map<uint32_t, uint32_t> soc_regs;
+
+    /* Line */
+    enum link_state state;
+    uint32_t ones;
+    uint16_t shift;
+    bool swd_mode;      /* the JTAG-to-SWD sequence was received */
+    bool need_idcode;   /* the first request after a reset reads IDCODE */
+    uint32_t request;
+    int bits;
+    bool drive;         /* the target drives SWDIO */
+    uint64_t out;       /* bits driven by the target, LSB first */
+    uint32_t ack;
+    uint64_t wdata;
+
+    /* SW-DP */
+    uint32_t ctrl;
+    uint32_t select;
+    uint32_t rdbuff;
+
+    /* AHB-AP */
+    uint32_t csw;
+    uint32_t tar;
+
+    /* nRF51 */
+    uint32_t flash[SWD_MODEL_FLASH_SIZE / 4];
+    uint32_t uicr[UICR_SIZE / 4];
+    std::map<uint32_t, uint32_t> regs;
+    uint32_t nvmc_config;
+    uint32_t busy;      /* cycles left to program or erase the flash */
+    bool halted;
+    bool reset_st;
+
+    /* Test controls */
+    uint32_t inject_wait;
+    bool inject_parity;
+    bool tracing;
+    std::string trace;
+
+    struct swd_model_stats stats;
+    const char *error;
+} m;
+
+static void model_error(const char *error)
+{
+    if (m.error == NULL) {
+        m.error = error;
+    }
+    m.stats.errors++;
+}
+
+static void model_advance(uint32_t cycles)
+{
+    m.busy = m.busy > cycles ? m.busy - cycles : 0;
+}
+
+static bool is_flash(uint32_t addr)
+{
+    return addr < SWD_MODEL_FLASH_SIZE;
+}
+
+static bool is_uicr(uint32_t addr)
+{
+    return addr >= NRF_UICR_BASE && addr < NRF_UICR_BASE + UICR_SIZE;
+}
+
+/* Target memory, as seen by the AHB-AP */
+static uint32_t mem_read(uint32_t addr)
+{
+    uint32_t value;
+
+    if (is_flash(addr)) {
+        return m.flash[addr / 4];
+    }
+    if (is_uicr(addr)) {
+        return m.uicr[(addr - NRF_UICR_BASE) / 4];
+    }
+    if (addr == (uint32_t)(uintptr_t)&NRF_NVMC->READY) {
+        return m.busy ? NVMC_READY_READY_Busy : 1;
+    }
+    if (addr == (uint32_t)(uintptr_t)&NRF_FICR->CODEPAGESIZE) {
+        return NRF_PAGESIZE;
+    }
+    if (addr == (uint32_t)(uintptr_t)&NRF_FICR->CODESIZE) {
+        return SWD_MODEL_FLASH_SIZE / NRF_PAGESIZE;
+    }
+    if (addr == (uint32_t)(uintptr_t)&NRF_FICR->PPFC) {
+        return FICR_PPFC_PPFC_NotPresent;
+    }
+    if (addr == CoreDebug_BASE) {
+        /* DHCSR, S_RESET_ST is cleared by the read */
+        value = (m.halted ? CoreDebug_DHCSR_S_HALT_Msk : 0) |
+                (m.reset_st ? CoreDebug_DHCSR_S_RESET_ST_Msk : 0);
+        m.reset_st = false;
+        return value;
+    }
+    return m.regs[addr];
+}
+
+static void flash_program(uint32_t *word, uint32_t value)
+{
+    if (m.nvmc_config != NVMC_CONFIG_WEN_Wen) {
+        model_error("flash written without NVMC write enable");
+        return;
+    }
+    /* Programming only clears bits */
+    *word &= value;
+    m.busy = SWD_MODEL_WRITE_CYCLES;
+    m.stats.flash_writes++;
+}
+
+static void mem_write(uint32_t addr, uint32_t value)
+{
+    if (is_flash(addr)) {
+        flash_program(&m.flash[addr / 4], value);
+    } else if (is_uicr(addr)) {
+        flash_program(&m.uicr[(addr - NRF_UICR_BASE) / 4], value);
+    } else if (addr == (uint32_t)(uintptr_t)&NRF_NVMC->CONFIG) {
+        m.nvmc_config = value;
+    } else if (addr == (uint32_t)(uintptr_t)&NRF_NVMC->ERASEPAGE) {
+        if (m.nvmc_config != NVMC_CONFIG_WEN_Een || !is_flash(value)) {
+            model_error("bad page erase");
+            return;
+        }
+        memset(&m.flash[(value & ~(NRF_PAGESIZE - 1)) / 4], 0xff,
+               NRF_PAGESIZE);
+        m.busy = SWD_MODEL_ERASE_CYCLES;
+    } else if (addr == (uint32_t)(uintptr_t)&NRF_NVMC->ERASEALL) {
+        if (m.nvmc_config != NVMC_CONFIG_WEN_Een) {
+            model_error("erase all without NVMC erase enable");
+            return;
+        }
+        memset(m.flash, 0xff, sizeof(m.flash));
+        memset(m.uicr, 0xff, sizeof(m.uicr));
+        m.busy = SWD_MODEL_ERASE_CYCLES;
+    } else if (addr == CoreDebug_BASE) {
+        if ((value & 0xffff0000) == DHCSR_DBGKEY) {
+            m.halted = value & DHCSR_C_HALT;
+        }
+    } else if (addr == SCB_BASE + offsetof(struct scb_struct, AIRCR)) {
+        if ((value & 0xffff0000) == AIRCR_VECTKEY &&
+            (value & SYSTEM_CTRL_BLOCK_SYS_RESET_MASK)) {
+            /* Halts on reset when VC_CORERESET is set */
+            m.reset_st = true;
+            m.halted = m.regs[CoreDebug_BASE +
+                              offsetof(struct coredebug_struct, DEMCR)] &
+                       CoreDebug_DEMCR_VC_CORERESET_Msk;
+        }
+    } else {
+        m.regs[addr] = value;
+    }
+}
+
+static void tar_increment(void)
+{
+    /* The TAR auto-increment wraps in 1KB blocks */
+    if ((m.csw & AP_CSW_ADDRINC_MSK) == AP_CSW_AUTO_INCREMENT) {
+        m.tar = (m.tar & ~NRF51_TAR_WRAP) | ((m.tar + 4) & NRF51_TAR_WRAP);
+    }
+}
+
+/* AP reads are posted: they return the result of the previous AP read */
+static uint32_t ap_read(int reg)
+{
+    uint32_t posted = m.rdbuff;
+
+    switch (((m.select >> 4) & 0xf) << 4 | reg << 2) {
+    case AP_CSW << 2:
+        m.rdbuff = m.csw;
+        break;
+    case AP_TAR << 2:
+        m.rdbuff = m.tar;
+        break;
+    case AP_DRW << 2:
+        m.rdbuff = mem_read(m.tar);
+        tar_increment();
+        break;
+    case 0xf0 | AP_IDR << 2:
+        m.rdbuff = NRF51_APB_AP_ID_1;
+        break;
+    default:
+        m.rdbuff = 0;
+        break;
+    }
+    return posted;
+}
+
+static void ap_write(int reg, uint32_t value)
+{
+    switch (((m.select >> 4) & 0xf) << 4 | reg << 2) {
+    case AP_CSW << 2:
+        m.csw = value;
+        break;
+    case AP_TAR << 2:
+        m.tar = value;
+        break;
+    case AP_DRW << 2:
+        mem_write(m.tar, value);
+        tar_increment();
+        break;
+    default:
+        model_error("write to an unknown AP register");
+        break;
+    }
+}
+
+static uint32_t dp_read(int reg)
+{
+    switch (reg) {
+    case DP_IDCODE:
+        return NRF51_DPID_1;
+    case DP_CTRL:
+        return m.ctrl;
+    case DP_RDBUFF:
+        return m.rdbuff;
+    default:
+        return 0;
+    }
+}
+
+static void dp_write(int reg, uint32_t value)
+{
+    switch (reg) {
+    case DP_ABORT:
+        if (value & DP_ABORT_STKCMPCLR)
+            m.ctrl &= ~DP_CTRL_STICKYCMP;
+        if (value & DP_ABORT_STKERRCLR)
+            m.ctrl &= ~DP_CTRL_STICKYERR;
+        if (value & DP_ABORT_WDERRCLR)
+            m.ctrl &= ~DP_CTRL_WDATAERR;
+        if (value & DP_ABORT_ORUNERRCLR)
+            m.ctrl &= ~DP_CTRL_STICKYORUN;
+        break;
+    case DP_STAT:
+        /* Power is acknowledged at once */
+        m.ctrl = (m.ctrl & DP_CTRL_STICKY) | (value & DP_CTRL_PWRUPREQ) |
+                 ((value & DP_CTRL_PWRUPREQ) << 1);
+        break;
+    case DP_SELECT:
+        m.select = value;
+        break;
+    default:
+        model_error("write to an unknown DP register");
+        break;
+    }
+}
+
+/* Decodes a request header and prepares the acknowledge */
+static void link_request(void)
+{
+    uint32_t ap = (m.request >> 1) & 1;
+    uint32_t rnw = (m.request >> 2) & 1;
+    int reg = (m.request >> 3) & 3;
+    uint32_t parity = (m.request >> 5) & 1;
+    uint32_t data;
+
+    if (((m.request >> 6) & 3) != 2 ||
+        parity != (uint32_t)__builtin_parity(m.request & 0x1e)) {
+        model_error("bad request header");
+        m.state = LINK_LOCKOUT;
+        return;
+    }
+    if (m.need_idcode && (ap || !rnw || reg != DP_IDCODE)) {
+        model_error("the first request after a line reset must read IDCODE");
+        m.state = LINK_LOCKOUT;
+        return;
+    }
+    m.need_idcode = false;
+    m.stats.requests++;
+
+    m.ack = ACK_OK;
+    if (ap) {
+        if (m.inject_wait || m.busy) {
+            if (m.inject_wait)
+                m.inject_wait--;
+            m.ack = ACK_WAIT;
+            m.stats.waits++;
+        } else if ((m.ctrl & DP_CTRL_STICKY) ||
+                   (m.ctrl & DP_CTRL_CDBGPWRUPACK) == 0) {
+            m.ctrl |= DP_CTRL_STICKYERR;
+            m.ack = ACK_FAULT;
+            m.stats.faults++;
+        }
+    }
+
+    m.out = m.ack;
+    if (m.ack == ACK_OK && rnw) {
+        data = ap ? ap_read(reg) : dp_read(reg);
+        m.out |= ((uint64_t)data << 3) |
+                 ((uint64_t)(__builtin_parity(data) ^ m.inject_parity) << 35);
+        m.inject_parity = false;
+    }
+    m.state = LINK_TRN_ACK;
+}
+
+/* Rising edge of SWCLK */
+static void link_clock(void)
+{
+    bool host = m.ddr & DIO_BIT;
+    uint32_t bit = host ? !!(m.dr & DIO_BIT) : 1;
+
+    m.stats.cycles++;
+    model_advance(1);
+    if (m.tracing) {
+        m.trace += host ? (bit ? '1' : '0') : 'z';
+    }
+    if (host && m.drive) {
+        model_error("SWDIO driven by both sides");
+    }
+
+    if (host && bit) {
+        if (++m.ones == LINE_RESET_BITS) {
+            m.state = LINK_RESET;
+            m.need_idcode = true;
+            m.drive = false;
+        }
+    } else {
+        m.ones = 0;
+    }
+
+    switch (m.state) {
+    case LINK_RESET:
+        m.shift = (m.shift >> 1) | (bit << 15);
+        if (m.shift == JTAG2SWD) {
+            m.swd_mode = true;
+        } else if (!bit && m.swd_mode) {
+            m.state = LINK_IDLE;
+        }
+        break;
+    case LINK_IDLE:
+        if (!host) {
+            model_error("SWDIO not driven between requests");
+        } else if (bit) {
+            m.request = 1;
+            m.bits = 1;
+            m.state = LINK_REQUEST;
+        } else {
+            m.stats.idle_cycles++;
+        }
+        break;
+    case LINK_REQUEST:
+        if (!host) {
+            model_error("SWDIO not driven during a request");
+        }
+        m.request |= bit << m.bits;
+        if (++m.bits == 8) {
+            link_request();
+        }
+        break;
+    case LINK_TRN_ACK:
+        m.drive = true;
+        m.bits = (m.ack == ACK_OK && ((m.request >> 2) & 1)) ? 36 : 3;
+        m.state = LINK_ACK;
+        break;
+    case LINK_ACK:
+    case LINK_RDATA:
+        m.out >>= 1;
+        if (--m.bits == 0) {
+            m.drive = false;
+            if (m.ack == ACK_OK && !((m.request >> 2) & 1)) {
+                m.state = LINK_TRN_WDATA;
+            } else {
+                m.state = LINK_TRN_END;
+            }
+        }
+        break;
+    case LINK_TRN_WDATA:
+        m.wdata = 0;
+        m.bits = 0;
+        m.state = LINK_WDATA;
+        break;
+    case LINK_WDATA:
+        if (!host) {
+            model_error("SWDIO not driven during write data");
+        }
+        m.wdata |= (uint64_t)bit << m.bits;
+        if (++m.bits == 33) {
+            uint32_t data = (uint32_t)m.wdata;
+
+            if ((m.wdata >> 32) != (uint32_t)__builtin_parity(data)) {
+                model_error("write data parity");
+                m.ctrl |= DP_CTRL_WDATAERR;
+            } else if ((m.request >> 1) & 1) {
+                ap_write((m.request >> 3) & 3, data);
+            } else {
+                dp_write((m.request >> 3) & 3, data);
+            }
+            m.state = LINK_IDLE;
+        }
+        break;
+    case LINK_TRN_END:
+        m.state = LINK_IDLE;
+        break;
+    case LINK_LOCKOUT:
+        break;
+    }
+}
+
+static uint32_t line_level(void)
+{
+    if (m.drive) {
+        return m.out & 1;
+    }
+    if (m.ddr & DIO_BIT) {
+        return !!(m.dr & DIO_BIT);
+    }
+    /* Pulled up */
+    return 1;
+}
+
+static uint32_t soc_read(uint32_t addr)
+{
+    switch (addr) {
+    case GPIO_DR:
+        return m.dr;
+    case GPIO_DDR:
+        return m.ddr;
+    case GPIO_EXT:
+        if (m.tracing) {
+            m.trace += (m.dr & CLK_BIT) ? 'r' : 'R';
+        }
+        return line_level() << NRF_SWDIO_PIN;
+    default:
+        return m.soc_regs[addr];
+    }
+}
+
+static void soc_write(uint32_t addr, uint32_t value)
+{
+    switch (addr) {
+    case GPIO_DR:
+        if (!(m.dr & CLK_BIT) && (value & CLK_BIT) && (m.ddr & CLK_BIT)) {
+            m.dr = value;
+            link_clock();
+        }
+        m.dr = value;
+        break;
+    case GPIO_DDR:
+        if (m.tracing && ((m.ddr ^ value) & DIO_BIT)) {
+            m.trace += (value & DIO_BIT) ? 'O' : 'I';
+        }
+        m.ddr = value;
+        break;
+    default:
+        m.soc_regs[addr] = value;
+        break;
+    }
+}
+
+swd_model_reg::operator uint32_t() const
+{
+    return soc_read(addr);
+}
+
+swd_model_reg &swd_model_reg::operator=(uint32_t value)
+{
+    soc_write(addr, value);
+    return *this;
+}
+
+swd_model_reg &swd_model_reg::operator|=(uint32_t value)
+{
+    soc_write(addr, soc_read(addr) | value);
+    return *this;
+}
+
+swd_model_reg &swd_model_reg::operator&=(uint32_t value)
+{
+    soc_write(addr, soc_read(addr) & value);
+    return *this;
+}
+
+extern "C" {
+
+void swd_model_init(void)
+{
+    m.dr = m.ddr = 0;
+    m.soc_regs.clear();
+    m.state = LINK_LOCKOUT;
+    m.ones = 0;
+    m.shift = 0;
+    m.swd_mode = false;
+    m.need_idcode = true;
+    m.drive = false;
+    m.ctrl = m.select = m.rdbuff = 0;
+    m.csw = m.tar = 0;
+    memset(m.flash, 0xff, sizeof(m.flash));
+    memset(m.uicr, 0xff, sizeof(m.uicr));
+    m.regs.clear();
+    m.nvmc_config = NVMC_CONFIG_WEN_Ren;
+    m.busy = 0;
+    m.halted = false;
+    m.reset_st = false;
+    m.inject_wait = 0;
+    m.inject_parity = false;
+    m.tracing = false;
+    m.trace.clear();
+    memset(&m.stats, 0, sizeof(m.stats));
+    m.error = NULL;
+}
+
+const struct swd_model_stats *swd_model_get_stats(void)
+{
+    return &m.stats;
+}
+
+const char *swd_model_error(void)
+{
+    return m.error;
+}
+
+uint32_t swd_model_peek(uint32_t addr)
+{
+    if (is_flash(addr)) {
+        return m.flash[addr / 4];
+    }
+    return m.regs[addr];
+}
+
+void swd_model_poke(uint32_t addr, uint32_t value)
+{
+    if (is_flash(addr)) {
+        m.flash[addr / 4] = value;
+    } else {
+        m.regs[addr] = value;
+    }
+}
+
+void swd_model_inject_wait(uint32_t count)
+{
+    m.inject_wait = count;
+}
+
+void swd_model_inject_parity(void)
+{
+    m.inject_parity = true;
+}
+
+void swd_model_trace_start(void)
+{
+    m.trace.clear();
+    m.tracing = true;
+}
+
+const char *swd_model_trace_stop(void)
+{
+    m.tracing = false;
+    return m.trace.c_str();
+}
+
+void mdelay(uint32_t delay)
+{
+    model_advance(delay * SWD_MODEL_MS_CYCLES);
+}
+
+}
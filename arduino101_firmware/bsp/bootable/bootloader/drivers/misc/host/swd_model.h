@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SWD_MODEL_H
+#define SWD_MODEL_H
+
+/*
+ * Host model of the nRF51 SWD target, to run the SWD driver on a host.
+ *
+ * The GPIO registers accessed by hw_btfu_dap.c are routed to the model by
+ * scss_registers.h of this directory. The model decodes the SWD line at each
+ * rising edge of SWCLK, answers as the SW-DP and AHB-AP of the nRF51, and
+ * emulates the flash controller (NVMC) and the debug registers used by
+ * swd.c. Time is counted in SWCLK cycles: a word takes
+ * SWD_MODEL_WRITE_CYCLES to program, and the AHB-AP answers WAIT meanwhile.
+ */
+
+#include <stdint.h>
+
+/* Cycles to program a flash word, 43us with a 1MHz SWCLK */
+#define SWD_MODEL_WRITE_CYCLES 43
+/* Cycles to erase a page or the whole flash */
+#define SWD_MODEL_ERASE_CYCLES 21000
+/* Cycles counted for each millisecond of mdelay() */
+#define SWD_MODEL_MS_CYCLES    1000
+
+#define SWD_MODEL_FLASH_SIZE   (256 * 1024)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct swd_model_stats {
+    uint32_t cycles;       /*!< SWCLK cycles */
+    uint32_t idle_cycles;  /*!< cycles clocked between requests */
+    uint32_t requests;     /*!< valid request headers */
+    uint32_t waits;        /*!< WAIT acknowledges */
+    uint32_t faults;       /*!< FAULT acknowledges */
+    uint32_t flash_writes; /*!< flash words programmed */
+    uint32_t errors;       /*!< protocol or target errors */
+};
+
+/** Powers the target on, with its flash erased */
+void swd_model_init(void);
+
+/** Counters since swd_model_init() */
+const struct swd_model_stats *swd_model_get_stats(void);
+
+/** First error detected since swd_model_init(), NULL if none */
+const char *swd_model_error(void);
+
+/** Reads or writes the target memory without going through SWD */
+uint32_t swd_model_peek(uint32_t addr);
+void swd_model_poke(uint32_t addr, uint32_t value);
+
+/** Answers WAIT to the next count AP accesses */
+void swd_model_inject_wait(uint32_t count);
+
+/** Sends the next read data with a wrong parity bit */
+void swd_model_inject_parity(void);
+
+/**
+ * Records the line as seen by the target, one character per event:
+ * '0'/'1' host bit clocked, 'z' clock while the host does not drive SWDIO,
+ * 'O'/'I' SWDIO direction change, 'r'/'R' SWDIO sampled with SWCLK high/low.
+ */
+void swd_model_trace_start(void);
+const char *swd_model_trace_stop(void);
+
+#ifdef __cplusplus
+}
+
+/* A register of the SoC, accessed by the MMIO macros */
+class swd_model_reg {
+public:
+    explicit swd_model_reg(uint32_t addr) : addr(addr) {}
+    operator uint32_t() const;
+    swd_model_reg &operator=(uint32_t value);
+    swd_model_reg &operator|=(uint32_t value);
+    swd_model_reg &operator&=(uint32_t value);
+private:
+    uint32_t addr;
+};
+
+static inline swd_model_reg swd_model_mmio(uint32_t addr)
+{
+    return swd_model_reg(addr);
+}
+#endif
+
+#endif /* SWD_MODEL_H */
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks swd.c programming the nRF51 flash through the SWD target model, and
+ * compares the SWCLK cycles with the word by word programming used before
+ * auto-increment writes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "swd/swd.h"
+#include "swd_model.h"
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static uint32_t image[4096];
+
+/* Word by word programming: TAR and DRW written for every word, then NVMC
+ * polled until the word is programmed */
+static uint8_t load_image_by_word(uint32_t addr, const uint32_t *data,
+                                  uint32_t len)
+{
+    uint32_t i;
+    uint8_t timeout;
+
+    hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&NRF_NVMC->CONFIG, NVMC_CONFIG_WEN_Wen);
+    for (i = 0; i < len / 4; i++) {
+        hw_BtfuDapWriteMem(addr + i * 4, data[i]);
+        timeout = NVMC_WRITE_TIMEOUT;
+        while (hw_BtfuDapReadMem((uint32_t)(uintptr_t)&NRF_NVMC->READY) ==
+               NVMC_READY_READY_Busy && --timeout);
+        if (timeout == 0) {
+            return SWD_ERROR_FLASH_WRITE_FAILED;
+        }
+    }
+    return SWD_ERROR_OK;
+}
+
+static void connect(void)
+{
+    swd_model_init();
+    hw_BtfuDapInit();
+    hw_BtfuDapHardReset();
+    CHECK(swd_connect_to_target() == SWD_ERROR_OK);
+    CHECK(swd_unlock_target() == SWD_ERROR_OK);
+}
+
+static int flash_matches(uint32_t addr, const uint32_t *data, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < (len + 3) / 4; i++) {
+        if (swd_model_peek(addr + i * 4) != data[i]) {
+            printf("flash 0x%x: 0x%x instead of 0x%x\n", addr + i * 4,
+                   swd_model_peek(addr + i * 4), data[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Programs, verifies and dumps len bytes at addr */
+static uint32_t check_load(uint32_t addr, uint32_t len)
+{
+    static uint32_t dump[4096];
+    uint32_t cycles;
+    uint32_t i;
+
+    for (i = 0; i < ARRAY_SIZE(image); i++) {
+        image[i] = rand() ^ (rand() << 16);
+    }
+
+    CHECK(swd_erase_all() == SWD_ERROR_OK);
+    cycles = swd_model_get_stats()->cycles;
+    CHECK(swd_load_image(addr, image, len) == SWD_ERROR_OK);
+    cycles = swd_model_get_stats()->cycles - cycles;
+    CHECK(flash_matches(addr, image, len));
+    /* Words around the image are left erased */
+    CHECK(addr == 0 || swd_model_peek(addr - 4) == 0xffffffff);
+    CHECK(swd_model_peek(addr + ((len + 3) & ~3)) == 0xffffffff);
+
+    CHECK(swd_verify_image(addr, image, len) == SWD_ERROR_OK);
+    memset(dump, 0, sizeof(dump));
+    CHECK(swd_dump_image(addr, dump, len) == SWD_ERROR_OK);
+    CHECK(memcmp(dump, image, (len + 3) & ~3) == 0);
+
+    /* A single bit flipped is reported by the verification */
+    swd_model_poke(addr + (len / 8) * 4,
+                   swd_model_peek(addr + (len / 8) * 4) ^ 0x100);
+    CHECK(swd_verify_image(addr, image, len) ==
+          SWD_ERROR_FLASH_WRITE_FAILED);
+    return cycles;
+}
+
+int main(void)
+{
+    uint32_t cycles, by_word, len = 8 * 1024;
+
+    connect();
+
+    /* Start inside a TAR wrap block, end inside another one */
+    cycles = check_load(NRF_REGION0_LEN + 0x2f8, len);
+    /* Start on a TAR wrap boundary, length not a multiple of 4 */
+    check_load(NRF_REGION0_LEN, 1023);
+    check_load(NRF_REGION0_LEN + 4, 4);
+
+    /* The programming is also checked when the AP is stalled longer */
+    swd_model_inject_wait(SWD_RETRY_COUNT / 2);
+    check_load(NRF_REGION0_LEN + 0x400, 64);
+
+    CHECK(swd_erase_all() == SWD_ERROR_OK);
+    by_word = swd_model_get_stats()->cycles;
+    CHECK(load_image_by_word(NRF_REGION0_LEN + 0x2f8, image, len) ==
+          SWD_ERROR_OK);
+    by_word = swd_model_get_stats()->cycles - by_word;
+    CHECK(flash_matches(NRF_REGION0_LEN + 0x2f8, image, len));
+
+    printf("%u bytes programmed in %u SWCLK cycles, %u word by word (x%.1f)\n",
+           len, cycles, by_word, (double)by_word / cycles);
+    CHECK(cycles < by_word);
+
+    CHECK(swd_model_error() == NULL);
+    if (swd_model_error()) {
+        printf("model error: %s\n", swd_model_error());
+    }
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures != 0;
+}
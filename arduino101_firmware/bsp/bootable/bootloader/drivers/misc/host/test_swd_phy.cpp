@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the SWD PHY of hw_btfu_dap.c against the SWD target model:
+ * - the request table matches the header of the SWD protocol,
+ * - each transaction clocks the same bits as the previous implementation,
+ *   including WAIT and parity errors,
+ * - batched transactions return the same results without idle cycles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "swd_model.h"
+
+extern "C" {
+#include "../hw_btfu_dap.c"
+#include "hw_btfu_dap_ref.c"
+}
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* Scratch RAM of the nRF51 */
+#define RAM_ADDR 0x20000000
+
+enum inject { NONE, WAIT, PARITY };
+
+struct transaction {
+    uint8_t ap;
+    uint8_t rnw;
+    int reg;
+    uint32_t data;
+    enum inject inject;
+};
+
+struct result {
+    btfu_dap_error_t ret;
+    uint32_t data;
+
+    bool operator==(const result &r) const
+    {
+        return ret == r.ret && data == r.data;
+    }
+};
+
+typedef btfu_dap_error_t (*read_fn)(uint8_t ap, int reg, uint32_t *data);
+typedef btfu_dap_error_t (*write_fn)(uint8_t ap, int reg, uint32_t data,
+                                     uint8_t ignore_ack);
+
+static std::vector<transaction> transactions(void)
+{
+    std::vector<transaction> t;
+    int i;
+
+    /* Power up, select AP bank 0 and auto-increment from RAM_ADDR */
+    t.push_back({0, 1, DP_IDCODE, 0, NONE});
+    t.push_back({0, 0, DP_STAT, DP_CTRL_CSYSPWRUPREQ | DP_CTRL_CDBGPWRUPREQ,
+                 NONE});
+    t.push_back({0, 1, DP_CTRL, 0, NONE});
+    t.push_back({0, 0, DP_SELECT, 0, NONE});
+    t.push_back({1, 0, AP_CSW,
+                 (uint32_t)(AP_CSW_DEFAULT | AP_CSW_AUTO_INCREMENT), NONE});
+    t.push_back({1, 0, AP_TAR, RAM_ADDR, NONE});
+    /* Words of every parity */
+    for (i = 0; i < 16; i++) {
+        t.push_back({1, 0, AP_DRW, (uint32_t)(rand() ^ (rand() << 16)),
+                     NONE});
+    }
+    t.push_back({1, 0, AP_DRW, 0xffffffff, WAIT});
+    t.push_back({1, 0, AP_DRW, 0, NONE});
+    t.push_back({1, 0, AP_TAR, RAM_ADDR, NONE});
+    for (i = 0; i < 18; i++) {
+        t.push_back({1, 1, AP_DRW, 0, i == 5 ? WAIT : NONE});
+    }
+    t.push_back({1, 1, AP_CSW, 0, PARITY});
+    t.push_back({0, 1, DP_RDBUFF, 0, NONE});
+    /* Select the ID bank, read the AP ID */
+    t.push_back({0, 0, DP_SELECT, 0xf0, NONE});
+    t.push_back({1, 1, AP_IDR, 0, NONE});
+    t.push_back({0, 1, DP_RDBUFF, 0, NONE});
+    t.push_back({0, 0, DP_SELECT, 0, NONE});
+    return t;
+}
+
+/* Runs the transactions from a line reset and returns the line trace */
+static std::string run(const std::vector<transaction> &t, read_fn rd,
+                       write_fn wr, bool batch, std::vector<result> &results)
+{
+    std::string trace;
+
+    swd_model_init();
+    hw_BtfuDapInit();
+    JTAG_to_SWD_Sequence();
+    swd_model_trace_start();
+    if (batch) {
+        hw_BtfuDapBatchBegin();
+    }
+    results.clear();
+    for (const transaction &x : t) {
+        result r = {SWD_ERROR_OK, 0};
+
+        if (x.inject == WAIT) {
+            swd_model_inject_wait(1);
+        } else if (x.inject == PARITY) {
+            swd_model_inject_parity();
+        }
+        if (x.rnw) {
+            r.ret = rd(x.ap, x.reg, &r.data);
+        } else {
+            r.ret = wr(x.ap, x.reg, x.data, 0);
+        }
+        results.push_back(r);
+    }
+    if (batch) {
+        hw_BtfuDapBatchEnd();
+    }
+    trace = swd_model_trace_stop();
+    CHECK(swd_model_error() == NULL);
+    if (swd_model_error()) {
+        printf("model error: %s\n", swd_model_error());
+    }
+    return trace;
+}
+
+static void check_request_table(void)
+{
+    uint32_t ap, rnw, reg, header;
+
+    for (ap = 0; ap < 2; ap++) {
+        for (rnw = 0; rnw < 2; rnw++) {
+            for (reg = 0; reg < 4; reg++) {
+                /* start, APnDP, RnW, A[2:3], parity, stop, park */
+                header = 1 | ap << 1 | rnw << 2 | reg << 3 |
+                         ((ap + rnw + (reg & 1) + (reg >> 1)) & 1) << 5 |
+                         0 << 6 | 1 << 7;
+                CHECK(swd_request[ap << 3 | rnw << 2 | reg] == header);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    std::vector<transaction> t = transactions();
+    std::vector<result> ref, phy, batch;
+    std::string ref_trace, phy_trace;
+    uint32_t cycles, idle, batch_cycles, batch_idle, errors = 0;
+    size_t i;
+
+    check_request_table();
+
+    ref_trace = run(t, ref_readReg, ref_writeReg, false, ref);
+    phy_trace = run(t, readReg, writeReg, false, phy);
+    cycles = swd_model_get_stats()->cycles;
+    idle = swd_model_get_stats()->idle_cycles;
+    CHECK(ref_trace == phy_trace);
+    CHECK(ref == phy);
+
+    for (i = 0; i < t.size(); i++) {
+        if (t[i].inject == WAIT) {
+            CHECK(phy[i].ret == SWD_ERROR_WAIT);
+        } else if (t[i].inject == PARITY) {
+            CHECK(phy[i].ret == SWD_ERROR_PARITY);
+        } else {
+            CHECK(phy[i].ret == SWD_ERROR_OK);
+        }
+        errors += phy[i].ret != SWD_ERROR_OK;
+    }
+    CHECK(phy[0].data == NRF51_DPID_1);
+
+    run(t, readReg, writeReg, true, batch);
+    batch_cycles = swd_model_get_stats()->cycles;
+    batch_idle = swd_model_get_stats()->idle_cycles;
+    CHECK(batch == phy);
+    /* The idle period is only clocked after errors and at the end */
+    CHECK(idle - batch_idle == 8 * (t.size() - errors - 1));
+
+    printf("%u transactions: %u SWCLK cycles, %u batched\n",
+           (unsigned int)t.size(), cycles, batch_cycles);
+
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures != 0;
+}
@@ -29,17 +29,6 @@
 
 #include <swd/hw_btfu_dap.h>
 
-/*!
- * GPIO configuration structure
- */
-static gpio_cfg_data_t pin_cfg = {
-  .gpio_type = GPIO_OUTPUT,
-  .int_type = LEVEL,
-  .int_polarity = ACTIVE_LOW,
-  .int_debounce= DEBOUNCE_OFF,
-  .int_ls_sync =LS_SYNC_OFF,
-  .gpio_cb = NULL};
-
 #define swd_gpio_set_input(pin)                                                \
   do {                                                                         \
         MMIO_REG_VAL_FROM_BASE((SOC_GPIO_BASE_ADDR + SOC_GPIO_SWPORTA_DDR), 0) \
@@ -52,6 +41,98 @@ static gpio_cfg_data_t pin_cfg = {
         |= (1 << pin);                                                        \
   } while(0)
 
+/* The port data register is written from a local copy during transactions,
+ * instead of being read back at every clock edge */
+#define SWD_PORT_DR \
+    MMIO_REG_VAL_FROM_BASE((SOC_GPIO_BASE_ADDR + SOC_GPIO_SWPORTA_DR), 0)
+#define SWD_CLK_BIT (1 << NRF_SWCLK_PIN)
+#define SWD_DIO_BIT (1 << NRF_SWDIO_PIN)
+
+/* Request header, sent LSB first: start, APnDP, RnW, A[2:3], parity, stop,
+ * park */
+#define SWD_REQUEST(ap, rnw, reg)                                    \
+    (0x81 | ((ap) << 1) | ((rnw) << 2) | ((reg) << 3) |              \
+     ((((ap) + (rnw) + ((reg) & 1) + ((reg) >> 1)) & 1) << 5))
+#define SWD_REQUEST_REGS(ap, rnw)                                    \
+    SWD_REQUEST(ap, rnw, 0), SWD_REQUEST(ap, rnw, 1),                \
+    SWD_REQUEST(ap, rnw, 2), SWD_REQUEST(ap, rnw, 3)
+
+/* Indexed by (ap << 3) | (rnw << 2) | reg */
+static const uint8_t swd_request[16] = {
+    SWD_REQUEST_REGS(0, 0), SWD_REQUEST_REGS(0, 1),
+    SWD_REQUEST_REGS(1, 0), SWD_REQUEST_REGS(1, 1),
+};
+
+static uint8_t swd_batch;
+
+static inline void swd_delay(void)
+{
+#if SWD_CLOCK_DELAY > 0
+    int i;
+
+    for (i = 0; i < SWD_CLOCK_DELAY; i++)
+        __asm__ __volatile__("");
+#endif
+}
+
+/* Clocks out the n low bits of data, LSB first. SWDIO changes on the
+ * falling edge and the target samples it on the rising edge. */
+static inline uint32_t swd_write_bits(uint32_t dr, uint32_t data, int n)
+{
+    while (n--) {
+        dr = (data & 1) ? (dr | SWD_DIO_BIT) : (dr & ~SWD_DIO_BIT);
+        SWD_PORT_DR = dr & ~SWD_CLK_BIT;
+        swd_delay();
+        SWD_PORT_DR = dr | SWD_CLK_BIT;
+        swd_delay();
+        data >>= 1;
+    }
+    return dr | SWD_CLK_BIT;
+}
+
+/* Clocks in n bits, LSB first */
+static inline uint32_t swd_read_bits(uint32_t dr, int n)
+{
+    uint32_t data = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        SWD_PORT_DR = dr & ~SWD_CLK_BIT;
+        swd_delay();
+        data |= (uint32_t)SWDIO_IN() << i;
+        SWD_PORT_DR = dr | SWD_CLK_BIT;
+        swd_delay();
+    }
+    return data;
+}
+
+/* Clock cycle without changing SWDIO, for turnarounds */
+static inline void swd_cycle(uint32_t dr)
+{
+    SWD_PORT_DR = dr & ~SWD_CLK_BIT;
+    swd_delay();
+    SWD_PORT_DR = dr | SWD_CLK_BIT;
+    swd_delay();
+}
+
+/* Idle period, make sure the last transaction is clocked through DAP. */
+static inline void swd_idle(uint32_t dr)
+{
+    swd_write_bits(dr, 0, 8);
+}
+
+void hw_BtfuDapBatchBegin(void)
+{
+    swd_batch = 1;
+}
+
+void hw_BtfuDapBatchEnd(void)
+{
+    swd_batch = 0;
+    swd_gpio_set_output(NRF_SWDIO_PIN);
+    swd_idle(SWD_PORT_DR);
+}
+
 //------------------------------------------------------------------------------
 // Private Function Definitions
 //------------------------------------------------------------------------------
@@ -461,66 +542,36 @@ static btfu_dap_error_t writeDP(int reg, uint32_t data)
  **********************************************************/
 static btfu_dap_error_t readReg(uint8_t ap, int reg, uint32_t *data)
 {
-    int i;
-    uint32_t cb = 0;
+    uint32_t dr = SWD_PORT_DR;
+    uint32_t ack;
     uint32_t parity;
-    uint32_t b;
-    uint32_t ack = 0;
     btfu_dap_error_t ret = SWD_ERROR_OK;
 
     /* Initalize output variable */
     *data = 0;
 
-    /* Convert to int */
-    int _read = (int) 1;
-
-    int A2 = reg & 0x1;
-    int A3 = (reg >> 1) & 0x1;
-
-    /* Calulate parity */
-    parity = (ap + _read + A2 + A3) & 0x1;
-
     swd_gpio_set_output(NRF_SWDIO_PIN);
 
     /* Send request */
-    WRITE_BIT(1);
-    WRITE_BIT(ap);
-    WRITE_BIT(_read);
-    WRITE_BIT(A2);
-    WRITE_BIT(A3);
-    WRITE_BIT(parity);
-    WRITE_BIT(0);
-    WRITE_BIT(1);
+    dr = swd_write_bits(dr, swd_request[(ap << 3) | (1 << 2) | reg], 8);
 
     /* Turnaround */
     swd_gpio_set_input(NRF_SWDIO_PIN);
 
-    SWCLK_CYCLE();
+    swd_cycle(dr);
 
     /* Read ACK */
-    for (i = 0; i < 3; i++) {
-        READ_A_BIT(b);
-        ack |= b << i;
-    }
+    ack = swd_read_bits(dr, 3);
 
     /* Verify that ACK is OK */
     if (ack == ACK_OK) {
-
-        for (i = 0; i < 32; i++) {
-            /* Read bit */
-            READ_A_BIT(b);
-            *data |= b << i;
-
-            /* Keep track of expected parity */
-            if (b)
-                cb = !cb;
-        }
+        *data = swd_read_bits(dr, 32);
 
         /* Read parity bit */
-        READ_A_BIT(parity);
+        parity = swd_read_bits(dr, 1);
 
         /* Verify parity */
-        if (cb == parity) {
+        if (__builtin_parity(*data) == parity) {
             ret = SWD_ERROR_OK;
         } else {
             ret = SWD_ERROR_PARITY;
@@ -536,15 +587,14 @@ static btfu_dap_error_t readReg(uint8_t ap, int reg, uint32_t *data)
     }
 
     /* Turnaround */
-    SWCLK_CYCLE();
+    swd_cycle(dr);
 
-    /* 8-cycle idle period. Make sure transaction
-     * is clocked through DAP. */
     swd_gpio_set_output(NRF_SWDIO_PIN);
 
-    for (i = 0; i < 8; i++) {
-        WRITE_BIT(0);
-    }
+    /* 8-cycle idle period. Make sure transaction
+     * is clocked through DAP. */
+    if (!swd_batch || ret != SWD_ERROR_OK)
+        swd_idle(dr);
 
     return ret;
 }
@@ -565,61 +615,31 @@ static btfu_dap_error_t readReg(uint8_t ap, int reg, uint32_t *data)
 static btfu_dap_error_t writeReg(uint8_t ap, int reg, uint32_t data,
                                  uint8_t ignoreAck)
 {
-    uint32_t ack = 0;
-    int i;
-    uint32_t parity = 0;
-    uint32_t b;
+    uint32_t dr = SWD_PORT_DR;
+    uint32_t ack;
     btfu_dap_error_t ret = SWD_ERROR_OK;
 
-    /* Convert to int */
-    int _read = (int) 0;
-
-    /* Calulate address bits */
-    int A2 = reg & 0x1;
-    int A3 = (reg >> 1) & 0x1;
-
-    /* Calculate parity */
-    parity = (ap + _read + A2 + A3) & 0x1;
-
     swd_gpio_set_output(NRF_SWDIO_PIN);
 
-  /* Write request */
-    WRITE_BIT(1);
-    WRITE_BIT(ap);
-    WRITE_BIT(_read);
-    WRITE_BIT(A2);
-    WRITE_BIT(A3);
-    WRITE_BIT(parity);
-    WRITE_BIT(0);
-    WRITE_BIT(1);
+    /* Write request */
+    dr = swd_write_bits(dr, swd_request[(ap << 3) | reg], 8);
 
     swd_gpio_set_input(NRF_SWDIO_PIN);
 
     /* Turnaround */
-    SWCLK_CYCLE();
+    swd_cycle(dr);
 
     /* Read acknowledge */
-    for (i = 0; i < 3; i++) {
-        READ_A_BIT(b);
-        ack |= b << i;
-    }
+    ack = swd_read_bits(dr, 3);
 
     if (ack == ACK_OK || ignoreAck == 1) {
         /* Turnaround */
-        SWCLK_CYCLE();
+        swd_cycle(dr);
         swd_gpio_set_output(NRF_SWDIO_PIN);
 
-        /* Write data */
-        parity = 0;
-        for (i = 0; i < 32; i++) {
-            b = (data >> i) & 0x1;
-            WRITE_BIT(b);
-            if (b)
-                parity = !parity;
-        }
-
-        /* Write parity bit */
-        WRITE_BIT(parity);
+        /* Write data and parity bit */
+        dr = swd_write_bits(dr, data, 32);
+        dr = swd_write_bits(dr, __builtin_parity(data), 1);
 
     } else if (ack == ACK_WAIT) {
         ret = SWD_ERROR_WAIT;
@@ -630,14 +650,12 @@ static btfu_dap_error_t writeReg(uint8_t ap, int reg, uint32_t data,
         ret = SWD_ERROR_PROTOCOL;
     }
 
-    /* 8-cycle idle period. Make sure transaction
-     * is clocked through DAP. */
     swd_gpio_set_output(NRF_SWDIO_PIN);
 
-    for (i = 0; i < 8; i++) {
-        WRITE_BIT(0);
-    }
+    /* 8-cycle idle period. Make sure transaction
+     * is clocked through DAP. */
+    if (!swd_batch || ret != SWD_ERROR_OK)
+        swd_idle(dr);
 
     return ret;
-
 }
@@ -108,7 +108,7 @@ uint8_t swd_unlock_target(void)
    uint32_t value;
 
    /* Check for a preprogrammed Nordic - if so we can't flash it ourselves */
-   value = hw_BtfuDapReadMem((uint32_t)&(NRF_FICR->PPFC));
+   value = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(NRF_FICR->PPFC));
    if ( (value & FICR_PPFC_PPFC_Msk) != FICR_PPFC_PPFC_NotPresent )
    {  /* also NRF_FICR->CLENR0 and NRF_FICR->CONFIGID->FWID != 0xFFFFFFFF
          but lets not check everything */
@@ -117,7 +117,7 @@ uint8_t swd_unlock_target(void)
    }
 
    /* Unlock the MPU Write/erase protection in debug mode. */
-   hw_BtfuDapWriteMem((uint32_t)&(NRF_MPU->DISABLEINDEBUG), MPU_DISABLEINDEBUG_DISABLEINDEBUG_Disabled);
+   hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(NRF_MPU->DISABLEINDEBUG), MPU_DISABLEINDEBUG_DISABLEINDEBUG_Disabled);
 
   return SWD_ERROR_OK;
 }
@@ -129,14 +129,14 @@ uint8_t swd_soft_reset_target(void)
   uint8_t timeout = DEBUG_EVENT_RETRY_COUNT;
 
   /* Clear the VC_CORERESET bit */
-  hw_BtfuDapWriteMem((uint32_t)&(core_debug->DEMCR), 0);
+  hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(core_debug->DEMCR), 0);
 
   /* Do a dummy read of sticky bit to make sure it is cleared */
-  hw_BtfuDapReadMem((uint32_t)&(core_debug->DHCSR));
-  dhcsr = hw_BtfuDapReadMem((uint32_t)&(core_debug->DHCSR));
+  hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(core_debug->DHCSR));
+  dhcsr = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(core_debug->DHCSR));
 
   /* Reset CPU */
-  hw_BtfuDapWriteMem((uint32_t)&(scb->AIRCR), SYSTEM_CTRL_BLOCK_RESET_CMD);
+  hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(scb->AIRCR), SYSTEM_CTRL_BLOCK_RESET_CMD);
 
   /* Wait for reset to complete */
 
@@ -145,7 +145,7 @@ uint8_t swd_soft_reset_target(void)
   mdelay(1);
   do {
     mdelay(1);
-    dhcsr = hw_BtfuDapReadMem((uint32_t)&(core_debug->DHCSR));
+    dhcsr = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(core_debug->DHCSR));
     timeout--;
   } while ( !(dhcsr & CoreDebug_DHCSR_S_RESET_ST_Msk) && timeout > 0 );
 
@@ -158,7 +158,7 @@ uint8_t swd_soft_reset_target(void)
   timeout = DEBUG_EVENT_RETRY_COUNT;
   do {
     mdelay(1);
-    dhcsr = hw_BtfuDapReadMem((uint32_t)&(core_debug->DHCSR));
+    dhcsr = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(core_debug->DHCSR));
     timeout--;
   } while ( (dhcsr & CoreDebug_DHCSR_S_RESET_ST_Msk) && timeout > 0 );
 
@@ -177,7 +177,7 @@ uint8_t swd_soft_reset_target(void)
 uint8_t swd_debug_mode_reset_to_normal(void)
 {
    /* Set the Enable in the Power->Reset register */
-   hw_BtfuDapWriteMem((uint32_t)&(NRF_POWER->RESET), POWER_RESET_RESET_Enabled);
+   hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(NRF_POWER->RESET), POWER_RESET_RESET_Enabled);
 
    hw_BtfuDapHardReset();
    hw_BtfuDapHibernate();
@@ -198,16 +198,16 @@ static uint8_t reset_and_halt_target(void)
   }
 
   /* Set halt-on-reset bit */
-  hw_BtfuDapWriteMem((uint32_t)&(core_debug->DEMCR), CoreDebug_DEMCR_VC_CORERESET_Msk);
+  hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(core_debug->DEMCR), CoreDebug_DEMCR_VC_CORERESET_Msk);
 
   /* Clear exception state and reset target */
-  hw_BtfuDapWriteMem((uint32_t)&(scb->AIRCR), SYSTEM_CTRL_BLOCK_RESET_CMD);
+  hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(scb->AIRCR), SYSTEM_CTRL_BLOCK_RESET_CMD);
 
   /* Wait for target to reset */
   do {
     mdelay(1);
     timeout--;
-    dhcsr = hw_BtfuDapReadMem((uint32_t)&(core_debug->DHCSR));
+    dhcsr = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(core_debug->DHCSR));
   } while ( dhcsr & CoreDebug_DHCSR_S_RESET_ST_Msk );
 
   /* Check if we timed out */
@@ -230,10 +230,10 @@ uint8_t swd_halt_target(void)
   uint32_t dhcsr;
   uint8_t timeout = DEBUG_EVENT_RETRY_COUNT;
 
-  hw_BtfuDapWriteMem((uint32_t)&(core_debug->DHCSR), STOP_CMD);
+  hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(core_debug->DHCSR), STOP_CMD);
 
   do {
-    dhcsr = hw_BtfuDapReadMem((uint32_t)&(core_debug->DHCSR));
+    dhcsr = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(core_debug->DHCSR));
     timeout--;
   } while ( !(dhcsr & CoreDebug_DHCSR_S_HALT_Msk) && timeout > 0 );
 
@@ -247,13 +247,13 @@ uint8_t swd_halt_target(void)
 
 void swd_run_target(void)
 {
-  hw_BtfuDapWriteMem((uint32_t)&(core_debug->DHCSR), RUN_CMD);
+  hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(core_debug->DHCSR), RUN_CMD);
 }
 
 
 void swd_step_target(void)
 {
-  hw_BtfuDapWriteMem((uint32_t)&(core_debug->DHCSR), STEP_CMD);
+  hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(core_debug->DHCSR), STEP_CMD);
 }
 
 uint8_t swd_init(void)
@@ -285,11 +285,11 @@ uint8_t write_nvmc_config(uint32_t value)
     uint8_t timeOut;
 
     // Enable erase
-    hw_BtfuDapWriteMem((uint32_t) & (NRF_NVMC->CONFIG), value);
+    hw_BtfuDapWriteMem((uint32_t)(uintptr_t) & (NRF_NVMC->CONFIG), value);
     // Wait until it takes effect
     timeOut = NVMC_MODE_TIMEOUT;
     do {
-        mscStatus = hw_BtfuDapReadMem((uint32_t) & (NRF_NVMC->READY));
+        mscStatus = hw_BtfuDapReadMem((uint32_t)(uintptr_t) & (NRF_NVMC->READY));
         timeOut--;
     } while (mscStatus == NVMC_READY_READY_Busy && timeOut > 0);
 
@@ -333,6 +333,7 @@ uint8_t swd_dump_image(uint32_t addr, uint32_t *fw_image, uint32_t len)
 
     /* Set autoincrement on TAR */
     hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT | AP_CSW_AUTO_INCREMENT);
+    hw_BtfuDapBatchBegin();
 
     /* Initialize the TAR unless it is on a wrap boundary if so it will be done in the loop */
     if ((addr & NRF51_TAR_WRAP) != 0) {
@@ -363,6 +364,7 @@ uint8_t swd_dump_image(uint32_t addr, uint32_t *fw_image, uint32_t len)
 
     /* Disable autoincrement on TAR */
     hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT);
+    hw_BtfuDapBatchEnd();
 
     return SWD_ERROR_OK;
 }
@@ -370,7 +372,12 @@ uint8_t swd_dump_image(uint32_t addr, uint32_t *fw_image, uint32_t len)
  /*! \fn       uint8_t swd_load_image(uint32_t addr, const uint32_t *fw_image, uint32_t len)
  *
  *  \brief     Writes a firmware segment to Nordic internal flash using
- *             direct writes to the NVMC registers.
+ *             direct writes in autoincrement mode.
+ *
+ *             The NVMC stalls the AHB-AP while a word is being written,
+ *             which is reported as a WAIT acknowledge and retried by
+ *             hw_BtfuDapWriteAP(): the next word is clocked out while the
+ *             previous one is programmed, without polling NVMC READY.
  *
  * \param      Start address in Nordic flash for the write
  *                       Writes are always 32bit writes so the address
@@ -399,18 +406,27 @@ uint8_t swd_load_image(uint32_t addr, const uint32_t *fw_image, uint32_t len)
     if ((ret = write_nvmc_config(NVMC_CONFIG_WEN_Wen)) != SWD_ERROR_OK)
         return ret;
 
+    /* Set autoincrement on TAR */
+    hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT | AP_CSW_AUTO_INCREMENT);
+    hw_BtfuDapBatchBegin();
+
+    /* Initialize the TAR unless it is on a wrap boundary if so it will be done in the loop */
+    if ((addr & NRF51_TAR_WRAP) != 0) {
+        hw_BtfuDapWriteAP(AP_TAR, addr);
+    }
+
     // Write loop
     do {
-        // Write the data
-        hw_BtfuDapWriteMem(addr, *fw_image);
-        // Wait until write complete - max 43usec according to data sheet
-        timeOut = NVMC_WRITE_TIMEOUT;
-        do {
-            mscStatus = hw_BtfuDapReadMem((uint32_t) & (NRF_NVMC->READY));
-            timeOut--;
-        } while (mscStatus == NVMC_READY_READY_Busy && timeOut > 0);
-
-        if (mscStatus == NVMC_READY_READY_Busy) {
+        /* TAR must be initialized at every TAR wrap boundary
+         * because the autoincrement wraps around at these */
+        if ((addr & NRF51_TAR_WRAP) == 0) {
+            hw_BtfuDapWriteAP(AP_TAR, addr);
+        }
+
+        // Write the data, retried while the previous word is programmed
+        if (hw_BtfuDapWriteAP(AP_DRW, *fw_image) != SWD_ERROR_OK) {
+            hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT);
+            hw_BtfuDapBatchEnd();
             return SWD_ERROR_FLASH_WRITE_FAILED;
         }
 
@@ -419,6 +435,21 @@ uint8_t swd_load_image(uint32_t addr, const uint32_t *fw_image, uint32_t len)
         fw_image++;  //4 byte increment.
     } while (len > 0);
 
+    /* Disable autoincrement on TAR */
+    hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT);
+    hw_BtfuDapBatchEnd();
+
+    // Wait until the last write completes - max 43usec according to data sheet
+    timeOut = NVMC_WRITE_TIMEOUT;
+    do {
+        mscStatus = hw_BtfuDapReadMem((uint32_t)(uintptr_t) & (NRF_NVMC->READY));
+        timeOut--;
+    } while (mscStatus == NVMC_READY_READY_Busy && timeOut > 0);
+
+    if (mscStatus == NVMC_READY_READY_Busy) {
+        return SWD_ERROR_FLASH_WRITE_FAILED;
+    }
+
     // Write of the segment suceeded.
     return SWD_ERROR_OK;
 }
@@ -434,13 +465,13 @@ uint8_t swd_erase_all(void)
         return ret;
 
     // Start erase
-    hw_BtfuDapWriteMem((uint32_t) & (NRF_NVMC->ERASEALL),
+    hw_BtfuDapWriteMem((uint32_t)(uintptr_t) & (NRF_NVMC->ERASEALL),
                        NVMC_ERASEALL_ERASEALL_Erase);
     // Wait until erase is complete - typical 21ms according to datasheet
     timeOut = NVMC_ERASE_TIMEOUT;
     do {
         mdelay(1);
-        mscStatus = hw_BtfuDapReadMem((uint32_t) & (NRF_NVMC->READY));
+        mscStatus = hw_BtfuDapReadMem((uint32_t)(uintptr_t) & (NRF_NVMC->READY));
         timeOut--;
     } while (mscStatus == NVMC_READY_READY_Busy && timeOut > 0);
 
@@ -457,7 +488,7 @@ uint8_t swd_erase_all(void)
     // Erase completed now verify erase of each section
     if ((hw_BtfuDapReadMem(0x0) != 0xFFFFFFFF)
             || (hw_BtfuDapReadMem(NRF_REGION0_LEN) != 0xFFFFFFFF)
-            || (hw_BtfuDapReadMem((uint32_t) & NRF_UICR->CLENR0) != 0xFFFFFFFF)) {
+            || (hw_BtfuDapReadMem((uint32_t)(uintptr_t) & NRF_UICR->CLENR0) != 0xFFFFFFFF)) {
         return SWD_ERROR_DEVICE_ERASE_FAILED;
     }
 
@@ -479,14 +510,14 @@ uint8_t swd_page_erase(uint8_t page_num)
          return ret;
 
     // Start erase
-       hw_BtfuDapWriteMem((uint32_t)&(NRF_NVMC->ERASEPAGE),p_page) ;
+       hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(NRF_NVMC->ERASEPAGE),p_page) ;
 
    // Wait until erase is complete - typical 21ms according to datasheet
      timeOut = NVMC_ERASE_TIMEOUT;
      do
      {
         mdelay(1);
-        mscStatus = hw_BtfuDapReadMem((uint32_t)&(NRF_NVMC->READY));
+        mscStatus = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(NRF_NVMC->READY));
         timeOut--;
      } while (mscStatus == NVMC_READY_READY_Busy && timeOut > 0);
 
@@ -518,6 +549,7 @@ uint8_t swd_verify_image(uint32_t addr, const uint32_t *fw_image, uint32_t len)
 
     /* Set autoincrement on TAR */
     hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT | AP_CSW_AUTO_INCREMENT);
+    hw_BtfuDapBatchBegin();
 
     /* Initialize the TAR unless it is on a wrap boundary if so it will be done in the loop */
     if ((addr & NRF51_TAR_WRAP) != 0) {
@@ -543,6 +575,7 @@ uint8_t swd_verify_image(uint32_t addr, const uint32_t *fw_image, uint32_t len)
 //                       addr, value, *fw_image);
             /* Disable autoincrement on TAR */
             hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT);
+            hw_BtfuDapBatchEnd();
             return SWD_ERROR_FLASH_WRITE_FAILED;
         }
         len -= 4;
@@ -552,6 +585,7 @@ uint8_t swd_verify_image(uint32_t addr, const uint32_t *fw_image, uint32_t len)
 
     /* Disable autoincrement on TAR */
     hw_BtfuDapWriteAP(AP_CSW, AP_CSW_DEFAULT);
+    hw_BtfuDapBatchEnd();
 
     return SWD_ERROR_OK;
 }
@@ -562,8 +596,8 @@ uint8_t swd_flash_erase_region1_pages(uint32_t size)
    uint8_t timeOut;
 
    /* Recover the flash information */
-   uint32_t pagesize = hw_BtfuDapReadMem((uint32_t)&(NRF_FICR->CODEPAGESIZE));
-   uint32_t memsize =  hw_BtfuDapReadMem((uint32_t)&(NRF_FICR->CODESIZE));
+   uint32_t pagesize = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(NRF_FICR->CODEPAGESIZE));
+   uint32_t memsize =  hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(NRF_FICR->CODESIZE));
    uint32_t addr = NRF_REGION0_LEN;
 
    /* This is a known value lets just check it and then use the define afterward */
@@ -599,13 +633,13 @@ uint8_t swd_flash_erase_region1_pages(uint32_t size)
    do
    {
       // Start erase
-      hw_BtfuDapWriteMem((uint32_t)&(NRF_NVMC->ERASEPAGE), addr);
+      hw_BtfuDapWriteMem((uint32_t)(uintptr_t)&(NRF_NVMC->ERASEPAGE), addr);
       // Wait until erase is complete - typical 21ms according to datasheet
       timeOut = NVMC_ERASE_TIMEOUT;
       do
       {
          mdelay(1);
-         mscStatus = hw_BtfuDapReadMem((uint32_t)&(NRF_NVMC->READY));
+         mscStatus = hw_BtfuDapReadMem((uint32_t)(uintptr_t)&(NRF_NVMC->READY));
          timeOut--;
       } while (mscStatus == NVMC_READY_READY_Busy && timeOut > 0);
 
@@ -5,3 +5,4 @@ cflags-y += -Wno-error -w
 #cflags-y += -DDEBUG_EP0
 
 obj-y	+= dfu.o
+obj-$(CONFIG_USB_DFU_DELTA)	+= dfu_delta.o
@@ -62,7 +62,10 @@ static struct dfu_ops dfu_ops = {
 	.device_request = NULL,
 	.erase = NULL,
 	.write = NULL,
-	.read = NULL
+	.read = NULL,
+	.flush = NULL,
+	.abort = NULL,
+	.busy = NULL
 };
 
 /*
@@ -76,7 +79,6 @@ void * _memset(void *b, uint8_t c, int len)
   if (b == NULL) return NULL;
 
   unsigned char *ptr = (unsigned char *)b;
-  int i = 0;
   while(len > 0)
   {
       *ptr = c;
@@ -87,22 +89,22 @@ void * _memset(void *b, uint8_t c, int len)
   return(b);
 }
 
-int _memcmp(void * ptr_dest, void * ptr_src, int size)
+int _memcmp(const void * ptr_dest, const void * ptr_src, int size)
 {
 
     // checking memory pointers
     if ((ptr_dest == NULL) || (ptr_src == NULL)) return -1;
 
     // byte by byte copy
-    uint8_t *pdest = (uint8_t*) ptr_dest;
-    uint8_t *psrc = (uint8_t*) ptr_src;
+    const uint8_t *pdest = (const uint8_t*) ptr_dest;
+    const uint8_t *psrc = (const uint8_t*) ptr_src;
     int index = 0;
 
     for(index = 0; index < size; ++index)
     {
 
-      uint8_t d = *((uint8_t*)pdest);
-      uint8_t s = *((uint8_t*)psrc);
+      uint8_t d = *pdest;
+      uint8_t s = *psrc;
 
       if (s < d)
       {
@@ -172,6 +174,8 @@ void do_dfu_download(usb_device_request_t *setup_packet, uint32_t *len)
 	} else {
 		/* Download complete */
 		dfu_ops.state = dfuIDLE;
+		if (dfu_ops.flush)
+			dfu_ops.flush(&dfu_ops);
 		dfu_ops.alternate = -1;
 	}
 
@@ -205,6 +209,9 @@ void do_dfu_upload(usb_device_request_t *setup_packet, uint32_t *len)
 void do_dfu_abort(usb_device_request_t *setup_packet, uint32_t *len)
 {
 	pr_debug("%s\n", __func__);
+	/* The blocks already acknowledged still reach the flash */
+	if (dfu_ops.abort)
+		dfu_ops.abort(&dfu_ops);
 	dfu_ops.state = dfuIDLE;
 }
 
@@ -227,7 +234,7 @@ void do_dfu_reset(void)
 	dfu_reset = 1;
 }
 
-extern uint32_t dfu_busy;
+extern uint8_t dfu_busy;
 int ClassHandleReq(usb_device_request_t *setup_packet, uint32_t *len,
 		   uint8_t **data)
 {
@@ -252,7 +259,10 @@ int ClassHandleReq(usb_device_request_t *setup_packet, uint32_t *len,
 		dfu_buffer[5] = 0;	/* status string */
 		*len = 6;
 
-		if (dfu_ops.state == dfuDNBUSY)
+		/* While the device cannot take the next block, the host
+		 * polls again after bwPollTimeout */
+		if (dfu_ops.state == dfuDNBUSY &&
+		    !(dfu_ops.busy && dfu_ops.busy(&dfu_ops)))
 			dfu_ops.state = dfuDNLOAD_IDLE;
 		break;
 
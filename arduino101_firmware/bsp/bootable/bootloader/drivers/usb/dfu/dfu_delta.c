@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dfu.h>
+#include <dfu_delta.h>
+#include <partition.h>
+#include <utils.h>
+
+enum {
+	DELTA_HEADER,
+	DELTA_PAGE,
+	DELTA_RUN,
+	DELTA_DATA,
+	DELTA_DONE,
+	DELTA_ERROR
+};
+
+/* Old pages kept: the ones a window may reach back to, and the current one */
+#define DELTA_SLOTS (DFU_DELTA_BACKUP_PAGES + 1)
+#define DELTA_NO_PAGE 0xffffffff
+
+static struct {
+	const uint8_t *base;		/* current content of the partition */
+	unsigned int page_nr;
+	unsigned int journal;		/* first page of the journal */
+	dfu_delta_write_t write;
+	int state;
+	int status;
+	unsigned int page;		/* page being built */
+	int skip;			/* the page is already written */
+	int lost;			/* old content of the page is lost */
+	unsigned int runs;		/* runs left for the page */
+	unsigned int offset;		/* current run */
+	unsigned int len;
+	unsigned int field_size;	/* size of the field being received */
+	unsigned int field_len;		/* bytes of the field received */
+	union {
+		struct dfu_delta_header header;
+		struct dfu_delta_page page;
+		struct dfu_delta_run run;
+		uint8_t bytes[sizeof(struct dfu_delta_header)];
+	} field;
+	struct dfu_delta_header header;
+	struct dfu_delta_page desc;	/* description of the page being built */
+	uint32_t data[PAGE_SIZE / 4];
+	/* Old content of the last pages, also saved in the journal */
+	uint32_t backup[DELTA_SLOTS][PAGE_SIZE / 4];
+	unsigned int backup_page[DELTA_SLOTS];
+} delta;
+
+static uint32_t delta_sum(const uint32_t *words, unsigned int count)
+{
+	uint32_t sum = 0;
+
+	while (count--)
+		sum += *words++;
+	return sum;
+}
+
+static uint32_t delta_page_sum(const uint32_t *words)
+{
+	uint32_t sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < PAGE_SIZE / 4; i++)
+		sum = sum * 33 + words[i];
+	return sum;
+}
+
+static const uint32_t *delta_flash(unsigned int page)
+{
+	return (const uint32_t *)(delta.base + page * PAGE_SIZE);
+}
+
+static void delta_backup(unsigned int page, const uint32_t *old)
+{
+	unsigned int slot = page % DELTA_SLOTS;
+	unsigned int i;
+
+	for (i = 0; i < PAGE_SIZE / 4; i++)
+		delta.backup[slot][i] = old[i];
+	delta.backup_page[slot] = page;
+}
+
+/* Byte of the old partition, the pages already written are in backup */
+static uint8_t delta_old_byte(uint32_t offset)
+{
+	unsigned int page = offset / PAGE_SIZE;
+	unsigned int slot = page % DELTA_SLOTS;
+
+	if (delta.backup_page[slot] == page)
+		return ((uint8_t *)delta.backup[slot])[offset % PAGE_SIZE];
+	return delta.base[offset];
+}
+
+/* Check that the old content of a page is still available */
+static int delta_old_page(unsigned int page)
+{
+	if (delta.backup_page[page % DELTA_SLOTS] == page)
+		return 1;
+	if (page == delta.page)
+		return !delta.lost;
+	return page > delta.page;
+}
+
+/*
+ * Find where the old content of the page is. After an interrupted patch,
+ * the page may be already written, or half erased with its old content in
+ * the journal.
+ */
+static void delta_find_page(void)
+{
+	unsigned int page = delta.page;
+	const uint32_t *saved =
+		delta_flash(delta.journal + 1 + page % DELTA_SLOTS);
+	uint32_t sum = delta_page_sum(delta_flash(page));
+
+	delta.skip = sum == delta.desc.new_sum;
+	delta.lost = 0;
+	if (page >= delta.header.base_pages)
+		delta.lost = 1;
+	else if (sum == delta.desc.old_sum)
+		delta_backup(page, delta_flash(page));
+	else if (delta_page_sum(saved) == delta.desc.old_sum)
+		delta_backup(page, saved);
+	else
+		delta.lost = 1;
+}
+
+static int delta_start_page(void)
+{
+	uint8_t *data = (uint8_t *)delta.data;
+	uint32_t src = delta.field.page.src;
+	unsigned int i;
+
+	delta.desc = delta.field.page;
+	delta_find_page();
+	delta.runs = delta.desc.run_count;
+	if (delta.skip)
+		return statusOK;
+
+	if (src == DFU_DELTA_SRC_BLANK) {
+		for (i = 0; i < PAGE_SIZE / 4; i++)
+			delta.data[i] = 0xffffffff;
+	} else {
+		if (src + PAGE_SIZE > delta.header.base_pages * PAGE_SIZE ||
+		    src / PAGE_SIZE + DFU_DELTA_BACKUP_PAGES < delta.page)
+			return errADDRESS;
+		/* The old pages are gone, only a full image can be downloaded */
+		if (!delta_old_page(src / PAGE_SIZE) ||
+		    (src % PAGE_SIZE && !delta_old_page(src / PAGE_SIZE + 1)))
+			return errFIRMWARE;
+		for (i = 0; i < PAGE_SIZE; i++)
+			data[i] = delta_old_byte(src + i);
+	}
+	return statusOK;
+}
+
+static int delta_end_page(void)
+{
+	unsigned int page = delta.page++;
+	const uint32_t *old = delta_flash(page);
+	int status;
+	unsigned int i;
+
+	if (delta.skip)
+		return statusOK;
+	for (i = 0; i < PAGE_SIZE / 4; i++)
+		if (old[i] != delta.data[i])
+			break;
+	if (i == PAGE_SIZE / 4)
+		return statusOK;
+
+	/* Save the old page in the journal before it is erased */
+	if (!delta.lost) {
+		status = delta.write(delta.journal + 1 + page % DELTA_SLOTS,
+				     delta.backup[page % DELTA_SLOTS]);
+		if (status != statusOK)
+			return status;
+	}
+	return delta.write(page, delta.data);
+}
+
+static int delta_start(void)
+{
+	const uint32_t *journal = delta_flash(delta.journal);
+	const uint32_t *header = (const uint32_t *)&delta.header;
+	unsigned int i;
+
+	if (delta.header.magic != DFU_DELTA_MAGIC)
+		return errFILE;
+	/* Without room for the journal, an interrupted patch is lost */
+	if (delta.header.page_count + DFU_DELTA_JOURNAL_PAGES > delta.page_nr ||
+	    delta.header.base_pages + DFU_DELTA_JOURNAL_PAGES > delta.page_nr)
+		return errADDRESS;
+	delta.journal = delta.page_nr - DFU_DELTA_JOURNAL_PAGES;
+
+	for (i = 0; i < sizeof(delta.header) / 4; i++)
+		if (journal[i] != header[i])
+			break;
+	/* Resume the patch in progress, or the clearing of its journal */
+	if (i == sizeof(delta.header) / 4 ||
+	    delta_sum(delta_flash(0), delta.header.page_count * PAGE_SIZE / 4)
+	    == delta.header.new_sum)
+		return statusOK;
+
+	/* Refuse a patch made against another image */
+	if (delta_sum(delta_flash(0), delta.header.base_pages * PAGE_SIZE / 4)
+	    != delta.header.base_sum)
+		return errFIRMWARE;
+
+	for (i = 0; i < PAGE_SIZE / 4; i++)
+		delta.data[i] = i < sizeof(delta.header) / 4 ?
+			header[i] : 0xffffffff;
+	return delta.write(delta.journal, delta.data);
+}
+
+/* Handle a complete field, or the end of the data of a run */
+static int delta_field(void)
+{
+	int status = statusOK;
+
+	switch (delta.state) {
+	case DELTA_HEADER:
+		delta.header = delta.field.header;
+		status = delta_start();
+		if (status != statusOK)
+			return status;
+		delta.state = delta.header.page_count ? DELTA_PAGE : DELTA_DONE;
+		break;
+	case DELTA_PAGE:
+		status = delta_start_page();
+		if (status != statusOK)
+			return status;
+		delta.state = DELTA_RUN;
+		break;
+	case DELTA_RUN:
+		delta.offset = delta.field.run.offset;
+		delta.len = delta.field.run.len;
+		if (delta.offset + delta.len > PAGE_SIZE)
+			return errFILE;
+		delta.runs--;
+		delta.state = DELTA_DATA;
+		break;
+	}
+
+	if (delta.state == DELTA_DATA && delta.len == 0)
+		delta.state = DELTA_RUN;
+	if (delta.state == DELTA_RUN && delta.runs == 0) {
+		status = delta_end_page();
+		if (delta.page == delta.header.page_count)
+			delta.state = DELTA_DONE;
+		else
+			delta.state = DELTA_PAGE;
+	}
+
+	if (delta.state == DELTA_PAGE)
+		delta.field_size = sizeof(struct dfu_delta_page);
+	else if (delta.state == DELTA_RUN)
+		delta.field_size = sizeof(struct dfu_delta_run);
+	return status;
+}
+
+int dfu_delta_is_patch(const void *data, uint32_t len)
+{
+	return len >= sizeof(struct dfu_delta_header) &&
+		((const struct dfu_delta_header *)data)->magic == DFU_DELTA_MAGIC;
+}
+
+void dfu_delta_begin(const uint8_t *base, unsigned int page_nr,
+		     dfu_delta_write_t write)
+{
+	unsigned int i;
+
+	/* Fields are received in delta.field.bytes */
+	BUILD_BUG_ON(sizeof(struct dfu_delta_page) > sizeof(delta.field.bytes));
+	BUILD_BUG_ON(sizeof(struct dfu_delta_run) > sizeof(delta.field.bytes));
+
+	delta.base = base;
+	delta.page_nr = page_nr;
+	delta.write = write;
+	delta.state = DELTA_HEADER;
+	delta.status = statusOK;
+	delta.page = 0;
+	delta.field_size = sizeof(struct dfu_delta_header);
+	delta.field_len = 0;
+	for (i = 0; i < DELTA_SLOTS; i++)
+		delta.backup_page[i] = DELTA_NO_PAGE;
+}
+
+int dfu_delta_push(const uint8_t *data, uint32_t len)
+{
+	unsigned int count;
+
+	while (len && delta.status == statusOK) {
+		if (delta.state == DELTA_DONE) {
+			/* Trailing bytes are ignored */
+			break;
+		}
+		if (delta.state == DELTA_DATA) {
+			count = len < delta.len ? len : delta.len;
+			for (; count; count--, len--, delta.len--)
+				((uint8_t *)delta.data)[delta.offset++] = *data++;
+			if (delta.len == 0)
+				delta.status = delta_field();
+			continue;
+		}
+		delta.field.bytes[delta.field_len++] = *data++;
+		len--;
+		if (delta.field_len == delta.field_size) {
+			delta.field_len = 0;
+			delta.status = delta_field();
+		}
+	}
+	if (delta.status != statusOK)
+		delta.state = DELTA_ERROR;
+	return delta.status;
+}
+
+int dfu_delta_end(void)
+{
+	unsigned int i;
+
+	if (delta.status != statusOK)
+		return delta.status;
+	if (delta.state != DELTA_DONE)
+		return errNOTDONE;
+	if (delta_sum(delta_flash(0), delta.header.page_count * PAGE_SIZE / 4)
+	    != delta.header.new_sum)
+		return errVERIFY;
+
+	/* The patch is complete, clear the journal */
+	for (i = 0; i < PAGE_SIZE / 4; i++)
+		delta.data[i] = 0xffffffff;
+	return delta.write(delta.journal, delta.data);
+}
@@ -111,7 +111,16 @@ struct dfu_ops {
 	void (*erase)(struct dfu_ops *opsj);
 	void (*write)(struct dfu_ops *ops);
 	uint32_t (*read)(struct dfu_ops *ops);
+	/* Complete the writes still pending at the end of a download */
+	void (*flush)(struct dfu_ops *ops);
+	/* Complete the writes still pending when a download is aborted */
+	void (*abort)(struct dfu_ops *ops);
+	/* Non zero while the device cannot take the next block */
+	int (*busy)(struct dfu_ops *ops);
 };
 
+void dfu_set_alternate(struct dfu_ops *ops);
+void do_dfu_reset(void);
+
 
 #endif /* _DFU_H_ */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DFU_DELTA_H_
+#define _DFU_DELTA_H_
+
+#include <stdint.h>
+
+/*
+ * Differential update of a flash partition.
+ *
+ * A delta download is a patch stream applied in place against the current
+ * content of the partition, it is recognized by the magic number at the
+ * start of its first block. All fields are little endian.
+ *
+ * The stream starts with a struct dfu_delta_header, followed by one
+ * struct dfu_delta_page per page of the new image, in increasing order.
+ * Each page is built from a PAGE_SIZE window of the old partition,
+ * starting at any byte offset, then patched by run_count runs: a
+ * struct dfu_delta_run followed by len bytes that replace the page content
+ * at offset.
+ *
+ * Pages are rewritten as they are built, the old content of the last
+ * DFU_DELTA_BACKUP_PAGES pages written is kept in RAM. A window must lie in
+ * the base_pages of the old image and must not start before
+ * (page - DFU_DELTA_BACKUP_PAGES) * PAGE_SIZE.
+ *
+ * The last DFU_DELTA_JOURNAL_PAGES pages of the partition hold a journal, so
+ * that a patch interrupted by a reset or a power loss can be downloaded
+ * again: the header of the patch in progress, then the old content of the
+ * last pages written, saved before each page is erased. Pages already
+ * matching their new_sum are skipped. A patch that leaves no room for the
+ * journal is refused, the full image must be downloaded instead.
+ *
+ * The patch generator is tools/scripts/dfu/dfu_delta.py.
+ */
+
+#define DFU_DELTA_MAGIC 0x32544c44	/* "DLT2" */
+#define DFU_DELTA_SRC_BLANK 0xffffffff	/* window of an erased page */
+#define DFU_DELTA_BACKUP_PAGES 2
+/* Header of the patch in progress, then one page per backup */
+#define DFU_DELTA_JOURNAL_PAGES (DFU_DELTA_BACKUP_PAGES + 2)
+
+struct dfu_delta_header {
+	uint32_t magic;
+	uint16_t page_count;	/* pages of the new image */
+	uint16_t base_pages;	/* pages covered by base_sum */
+	uint32_t base_sum;	/* sum of the words of the old partition */
+	uint32_t new_sum;	/* sum of the words of the new image */
+};
+
+/*
+ * The page sums are computed as sum = sum * 33 + word over the words of the
+ * page, so that moving words inside a page changes the sum.
+ */
+struct dfu_delta_page {
+	uint32_t src;		/* window offset in the old partition */
+	uint16_t run_count;
+	uint16_t reserved;
+	uint32_t old_sum;	/* sum of the old page, if below base_pages */
+	uint32_t new_sum;	/* sum of the new page */
+};
+
+struct dfu_delta_run {
+	uint16_t offset;
+	uint16_t len;
+};
+
+/* Write a page of the partition, returns a DFU status code */
+typedef int (*dfu_delta_write_t)(unsigned int page, const uint32_t *data);
+
+/**
+ * Check if a download is a patch stream.
+ *
+ * @param data first block of the download
+ * @param len size of the block
+ *
+ * @return non zero if the download is a patch stream
+ */
+int dfu_delta_is_patch(const void *data, uint32_t len);
+
+/**
+ * Start patching a partition.
+ *
+ * @param base address of the partition in the memory map
+ * @param page_nr number of pages of the partition
+ * @param write function that writes the patched pages
+ */
+void dfu_delta_begin(const uint8_t *base, unsigned int page_nr,
+		     dfu_delta_write_t write);
+
+/**
+ * Apply the next block of the patch stream.
+ *
+ * @param data block of the patch stream
+ * @param len size of the block
+ *
+ * @return statusOK or the DFU status code of the error
+ */
+int dfu_delta_push(const uint8_t *data, uint32_t len);
+
+/**
+ * Check that the patch was completely applied.
+ *
+ * The pages written must have reached the flash. On success, the journal
+ * is cleared with one more write, that must reach the flash as well.
+ *
+ * @return statusOK or the DFU status code of the error
+ */
+int dfu_delta_end(void);
+
+#endif /* _DFU_DELTA_H_ */
@@ -96,7 +96,7 @@ typedef enum btfu_dap_error_tag {
 /* Bit fields for the CSW register */
 #define AP_CSW_32BIT_TRANSFER   0x02
 #define AP_CSW_AUTO_INCREMENT   0x10	//only used in some cases
-#define AP_CSW_DBG_SW_ENABLE    (1 << 31)
+#define AP_CSW_DBG_SW_ENABLE    (1U << 31)
 #define AP_CSW_DEFAULT (AP_CSW_32BIT_TRANSFER | AP_CSW_DBG_SW_ENABLE)
 
 /* Error bits in CTRL/STAT */
@@ -113,7 +113,7 @@ typedef enum btfu_dap_error_tag {
 #define DP_CTRL_CDBGPWRUPREQ  (1 << 28)
 #define DP_CTRL_CDBGPWRUPACK  (1 << 29)
 #define DP_CTRL_CSYSPWRUPREQ  (1 << 30)
-#define DP_CTRL_CSYSPWRUPACK  (1 << 31)
+#define DP_CTRL_CSYSPWRUPACK  (1U << 31)
 
 /* Error clear bits in ABORT */
 /* From http://infocenter.arm.com/help/topic/com.arm.doc.ddi0314h/DDI0314H_coresight_components_trm.pdf */
@@ -127,6 +127,12 @@ typedef enum btfu_dap_error_tag {
  * a WAIT response */
 #define SWD_RETRY_COUNT 200
 
+/* Number of busy loops in each half period of SWCLK, 0 for the fastest
+ * clock the GPIO allows */
+#ifndef SWD_CLOCK_DELAY
+#define SWD_CLOCK_DELAY 0
+#endif
+
 /* Number of times to retry the connection sequence */
 #define CONNECT_RETRY_COUNT 3
 
@@ -234,4 +240,9 @@ extern void hw_BtfuDapWriteMem(uint32_t addr, uint32_t data);
 
 extern btfu_dap_error_t hw_BtfuDapReadAP(int reg, uint32_t * data);
 extern btfu_dap_error_t hw_BtfuDapWriteAP(int reg, uint32_t data);
+
+/* Between these calls, transactions are sent back to back and the idle
+ * cycles are only clocked at the end of the batch */
+extern void hw_BtfuDapBatchBegin(void);
+extern void hw_BtfuDapBatchEnd(void);
 #endif // !HW_BTFU_DAP_H
@@ -178,7 +178,7 @@ extern uint8_t swd_dump_image(uint32_t addr, uint32_t *fw_image, uint32_t len);
 /*! \fn      uint8_t swd_load_image(uint32_t addr, const uint32_t *fw_image, uint32_t len)
 *
 *  \brief    Writes a firmware segment to Nordic internal flash using
-*            direct writes to the NVMC registers.
+*            direct writes in autoincrement mode.
 *
 * \param     addr      Start address in Nordic flash for the write
 * \param     fw_image  Pointer the the data to write
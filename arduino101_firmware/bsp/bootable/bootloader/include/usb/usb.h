@@ -41,6 +41,8 @@
 #ifndef _USB_H_
 #define _USB_H_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -49,7 +51,7 @@ extern "C" {
 typedef unsigned char u_int8_t;
 typedef unsigned char u_char;
 typedef unsigned short u_int16_t;
-typedef unsigned long int u_int32_t;
+typedef uint32_t u_int32_t;
 typedef unsigned int u_int;
 typedef unsigned long int u_long;
 /*
@@ -47,6 +47,14 @@
  */
 typedef void (*gpio_callback_fn)(bool , void*);
 
+/**
+ *  GPIO port callback function.
+ *
+ *  Called once per interrupt with the mask of the pins that triggered it,
+ *  the levels of all the port pins and the callback argument.
+ */
+typedef void (*gpio_port_callback_fn)(uint32_t, uint32_t, void*);
+
 /**
  *  GPIO context structure for deep sleep recovery.
  */
@@ -75,6 +83,9 @@ typedef struct gpio_info_struct
     uint32_t            gpio_int_mask;     /*!< SSS Interrupt Routing Mask Registers */
     gpio_callback_fn   *gpio_cb;           /*!< Array of user callback functions for user */
     void              **gpio_cb_arg;       /*!< Array of user priv data for callbacks */
+    gpio_port_callback_fn port_cb;         /*!< Port callback for the pins of port_cb_mask */
+    void               *port_cb_arg;       /*!< User priv data for the port callback */
+    uint32_t            port_cb_mask;      /*!< Pins handled by the port callback */
     uint8_t             is_init;           /*!< Init state of GPIO port */
     struct gpio_pm_ctxt pm_context;        /*!< Context for deep sleep recovery */
 } gpio_info_t, *gpio_info_pt;
@@ -55,6 +55,20 @@ typedef enum {
     SBA_TRANSFER              /*!< Read and write */
 } SBA_REQUEST_TYPE;
 
+/**
+ * Request priority classes.
+ *
+ * Pending transactions of a class are executed before the ones of the
+ * classes below it, in the order of the list. A transaction being executed
+ * is never interrupted.
+ */
+typedef enum {
+    SBA_PRIO_NORMAL = 0,      /*!< Default class */
+    SBA_PRIO_HIGH,            /*!< Latency sensitive requests, e.g. sensor reads */
+    SBA_PRIO_BULK,            /*!< Long transfers, e.g. flash accesses */
+    SBA_PRIO_COUNT
+} SBA_PRIORITY;
+
 /**
  * List of all controllers in system ( IA and SS )
  */
@@ -92,6 +106,8 @@ typedef struct sba_request {
     int8_t                    status;               /*!< 0 if ok, -1 if error */
     void                     *priv_data;            /*!< User private data */
     void (*callback)(struct sba_request *);         /*!< Callback */
+    uint8_t                   priority;             /*!< Priority class (SBA_PRIORITY) of the transaction, must be set (0 is SBA_PRIO_NORMAL) */
+    struct sba_request       *chain;                /*!< Next segment of the transaction, must be set (NULL for the last one) */
 }sba_request_t;
 
 /**
@@ -132,8 +148,9 @@ struct sba_master_cfg_data {
     SBA_BUSID  bus_id;                          /*!< Controller ID */
     union sba_config config;                    /*!< SBA config*/
     /* internal fields */
-    list_head_t    request_list;                /*!< List to store requests */
+    list_head_t    request_list[SBA_PRIO_COUNT]; /*!< Lists to store requests, one per priority class */
     sba_request_t *current_request;             /*!< current request pointer */
+    sba_request_t *current_segment;             /*!< segment of the current request being executed */
     uint8_t        controller_initialised;      /*!< Controller initialized flag */
     struct pm_wakelock sba_wakelock;            /*!< Power manager wakelock */
     struct clk_gate_info_s* clk_gate_info;      /*!< clock gate data */
@@ -175,12 +192,23 @@ DRIVER_API_RC sba_init(struct sba_master_cfg_data* sba_dev);
 *
 *  Configuration parameters must be valid or an error is returned - see return values below.
 *
+*  A request may be the first segment of a transaction: the segments linked by its
+*  chain field are executed back to back from the completion interrupt, on the bus and
+*  with the slave address of the first one. The SPI chip select stays asserted across
+*  the segments and is released after the last one; a chained transaction is rejected
+*  on an SPI controller that cannot hold its chip select.
+*  The priority and chain fields must be initialised by the caller.
+*  The callback of the first request is called once, when the last segment is complete
+*  or when a segment fails, with the status of the transaction.
+*  The request is queued according to its priority class.
+*
 *  @param request      : pointer to the request structure
 *
 *  @return
 *           - DRV_RC_OK on success,
 *           - DRV_RC_INVALID_CONFIG        - if any configuration parameters are not valid
-*           - DRV_RC_INVALID_OPERATION     - if both Rx and Tx while it is not implemented
+*           - DRV_RC_INVALID_OPERATION     - if both Rx and Tx while it is not implemented,
+*                                            or if the bus cannot execute a chained transaction
 *           - DRV_RC_CONTROLLER_IN_USE     - when device is busy
 *           - DRV_RC_FAIL                  otherwise
 */
@@ -114,6 +114,22 @@ DRIVER_API_RC soc_gpio_deconfig(struct device *dev, uint8_t bit);
  */
 DRIVER_API_RC soc_gpio_port_deconfig(struct device *dev);
 
+/**
+ * Set the port callback of a GPIO port
+ *
+ * The interrupts of the pins of mask are reported to the port callback,
+ * with a single call per interrupt, instead of the callbacks of the pins.
+ *
+ * @param dev              GPIO device to use
+ * @param mask             pins handled by the port callback
+ * @param cb               port callback, NULL to remove it
+ * @param arg              argument passed to the port callback
+ *
+ * @return
+ *          - RC_OK on success
+ */
+DRIVER_API_RC soc_gpio_set_port_callback(struct device *dev, uint32_t mask, gpio_port_callback_fn cb, void *arg);
+
 /**
  * Get callback argument pointer for a specific pin
  *
@@ -198,6 +214,33 @@ DRIVER_API_RC soc_gpio_read(struct device *dev, uint8_t bit, bool *value);
  */
 DRIVER_API_RC soc_gpio_write_port(struct device *dev, uint32_t value);
 
+/**
+ * Write a value to the masked bits of a given port
+ *
+ * The other bits of the port keep their current output value.
+ *
+ * @param dev              GPIO device to use
+ * @param mask             bits of the port to update
+ * @param value            value to write to the masked bits
+ *
+ * @return
+ *          - DRV_RC_OK on success
+ *          - DRV_RC_CONTROLLER_NOT_ACCESSIBLE if mask selects a non existing bit
+ */
+DRIVER_API_RC soc_gpio_write_port_masked(struct device *dev, uint32_t mask, uint32_t value);
+
+/**
+ * Toggle the masked bits of a given port
+ *
+ * @param dev              GPIO device to use
+ * @param mask             bits of the port to toggle
+ *
+ * @return
+ *          - DRV_RC_OK on success
+ *          - DRV_RC_CONTROLLER_NOT_ACCESSIBLE if mask selects a non existing bit
+ */
+DRIVER_API_RC soc_gpio_toggle_port(struct device *dev, uint32_t mask);
+
 /**
  * Read a given port
  *
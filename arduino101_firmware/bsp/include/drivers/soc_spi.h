@@ -145,6 +145,32 @@ DRIVER_API_RC soc_spi_clock_disable(struct sba_master_cfg_data* sba_dev);
 */
 DRIVER_API_RC soc_spi_transfer(SOC_SPI_CONTROLLER controller_id, uint8_t *tx_data, uint32_t tx_data_len, uint8_t *rx_data, uint32_t rx_data_len, int full_duplex, SPI_SLAVE_ENABLE slave);
 
+/**
+*  Function to keep the chip select asserted between transfers
+*
+*  While hold is set, the chip select stays asserted at the end of each transfer, so that
+*  the next transfer to the same slave continues the same bus transaction. Clearing it
+*  releases a chip select left asserted by a completed transfer.
+*  Only SPI master 0, whose chip selects are driven by GPIOs, supports it.
+*
+*  @param  controller_id   : SPI controller identifier
+*  @param  hold            : 1 to keep the chip select asserted, 0 to release it
+*
+*  @return
+*          - RC_OK                   -   on success
+*          - RC_INVALID_OPERATION    -   if the controller cannot hold its chip select
+*/
+DRIVER_API_RC soc_spi_cs_hold(SOC_SPI_CONTROLLER controller_id, int hold);
+
+/**
+*  Function to check whether a controller can hold its chip select across transfers
+*
+*  @param  controller_id   : SPI controller identifier
+*
+*  @return 1 if soc_spi_cs_hold() can keep the chip select asserted, 0 otherwise
+*/
+int soc_spi_cs_hold_supported(SOC_SPI_CONTROLLER controller_id);
+
 /**
 *  Function to determine controllers current state
 *
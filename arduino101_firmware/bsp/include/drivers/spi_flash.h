@@ -34,6 +34,7 @@
 
 #include "drivers/data_type.h"
 #include "infra/device.h"
+#include "util/list.h"
 
 /**
  * @defgroup flash_spi_driver External SPI Flash
@@ -182,6 +183,48 @@ DRIVER_API_RC spi_flash_get_rdid(struct device *dev, uint32_t *rdid);
 DRIVER_API_RC spi_flash_ioctl(struct device *dev, uint32_t *result,
 			      uint8_t ioctl);
 
+#ifdef CONFIG_SPI_FLASH_ASYNC
+/**
+ * Asynchronous request types
+ */
+typedef enum {
+	SPI_FLASH_REQ_READ = 0, /*!< Read bytes */
+	SPI_FLASH_REQ_WRITE     /*!< Program bytes, the area must be erased */
+} SPI_FLASH_REQUEST_TYPE;
+
+/**
+ * Asynchronous SPI flash request.
+ *
+ * The request is owned by the driver from spi_flash_submit() until its
+ * callback is called, and must not be modified meanwhile.
+ */
+struct spi_flash_request {
+	list_t list;                  /*!< Driver queue link */
+	SPI_FLASH_REQUEST_TYPE type;  /*!< Request type */
+	uint32_t address;             /*!< Address (in bytes) in flash */
+	unsigned int len;             /*!< Number of bytes to transfer */
+	uint8_t *data;                /*!< Buffer to read into or to write from */
+	DRIVER_API_RC status;         /*!< Request result, set before the callback */
+	unsigned int retlen;          /*!< Number of bytes successfully transferred */
+	void *priv_data;              /*!< Caller data */
+	void (*callback)(struct spi_flash_request *req); /*!< Completion callback */
+};
+
+/**
+ *  Queue a read or write request on SPI flash.
+ *
+ *  Requests are executed in submission order, without blocking the caller.
+ *  The callback may be called in interrupt context.
+ *
+ *  @param  dev             : spi flash device to use
+ *  @param  req             : request to execute
+ *
+ *  @return  DRV_RC_OK if the request is queued else DRIVER_API_RC error code,
+ *           the callback is not called on error
+ */
+DRIVER_API_RC spi_flash_submit(struct device *dev, struct spi_flash_request *req);
+#endif
+
 /** @} */
 
 #endif  /* SPI_FLASH_H_ */
@@ -104,6 +104,7 @@
  * callback is called when the transfer completes.
  * The first parameter of the callback is the actual number of bytes
  * transfered.
+ * Several reads can be queued, they complete in order.
  *
  * @param  idx the index of the ACM interface to use
  * @param  buffer the buffer to read from acm interface
@@ -111,7 +112,7 @@
  * @param  xfer_done the callback function called when transfer is complete
  *                  this function will be called in the interrupt context
  * @param  data the data passed to the transfer complete callback
- * @return  0 if success DRV_RC_BUSY if a request is already pending
+ * @return  0 if success.
  */
 int acm_read(int idx, uint8_t *buffer, int len,
 	     void (*xfer_done)(int, void*), void * data);
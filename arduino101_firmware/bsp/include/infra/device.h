@@ -93,6 +93,11 @@ struct __attribute__((packed, aligned(4))) bus {
 
 /**
  * Device driver management structure
+ *
+ * The suspend and resume callbacks may return -EINPROGRESS to complete the
+ * operation asynchronously, the driver then calls @ref device_pm_complete
+ * (@ref bus_pm_complete for a bus driver) from its completion handler.
+ * The operations of the devices which do not depend on each other overlap.
  */
 struct driver {
 	int	(*init)(struct device *dev);                            /*!< Pointer to the function to call for device init */
@@ -120,6 +125,8 @@ void list_devices(void);
  * Suspends all devices in the device tree of current CPU.
  *
  * This function calls the suspend callback of all devices in the device tree.
+ * The tree is suspended from its leaves: a bus is suspended once all its
+ * children are, and the devices at the same depth are suspended together.
  * If a suspend callback fails for something else than shutdown, all devices are resumed.
  *
  * @param state suspend type (for shutdown/deepsleep/sleep etc...).
@@ -132,6 +139,8 @@ int suspend_devices(PM_POWERSTATE state);
  * Resumes all devices in the device tree of current CPU.
  *
  * This function calls the resume callback of all devices in the device tree.
+ * A device is resumed once its parent bus is, and the devices at the same
+ * depth are resumed together.
  *
  * @return 0 if success else -1.
  */
@@ -173,6 +182,48 @@ int init_all_devices(void);
  */
 struct device *get_device(uint8_t id);
 
+/**
+ * Completes an asynchronous suspend or resume of a device.
+ *
+ * This function may be called from an interrupt handler.
+ *
+ * @param dev the device whose suspend or resume callback returned -EINPROGRESS
+ * @param ret 0 if the operation succeeded, a negative error code otherwise
+ */
+void device_pm_complete(struct device *dev, int ret);
+
+/**
+ * Completes an asynchronous suspend or resume of a bus device.
+ *
+ * @see device_pm_complete
+ */
+void bus_pm_complete(struct bus *dev, int ret);
+
+#ifdef CONFIG_DEVICE_PM_STATS
+/**
+ * Suspend and resume times of a device, in 32 kHz ticks.
+ *
+ * The times include the asynchronous completion of the operations, they
+ * saturate at 0xffff.
+ */
+struct device_pm_stats {
+	uint16_t suspend_time;  /*!< Duration of the last suspend */
+	uint16_t suspend_max;   /*!< Longest suspend */
+	uint16_t resume_time;   /*!< Duration of the last resume */
+	uint16_t resume_max;    /*!< Longest resume */
+};
+
+/**
+ * Gets the suspend and resume times of a device.
+ *
+ * @param id    ID of the device
+ * @param stats the structure to fill
+ *
+ * @return 0 if success, -EINVAL if the device is not found.
+ */
+int device_get_pm_stats(uint8_t id, struct device_pm_stats *stats);
+#endif
+
 /** @} */
 
 #endif /* __DEVICE_H__ */
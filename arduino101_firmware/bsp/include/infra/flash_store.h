@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __INFRA_FLASH_STORE_H__
+#define __INFRA_FLASH_STORE_H__
+
+#include <stdint.h>
+
+/**
+ * @defgroup infra_flash_store Flash key/value store
+ * Log-structured key/value store over NOR flash.
+ *
+ * Values are appended to a log of flash sectors instead of being rewritten
+ * in place, so that updating a value only programs a few bytes. Appends are
+ * combined in a RAM page buffer and programmed a page at a time. Sectors
+ * holding only overwritten values are reclaimed by a garbage collector that
+ * also moves cold data out of the least erased sectors to level wear.
+ *
+ * Each record is protected by a CRC: a record torn by a reset is dropped
+ * when the store is mounted, and all the records before it are kept.
+ *
+ * The store is not reentrant, the caller must serialize its accesses.
+ * @ingroup infra
+ * @{
+ */
+
+/** Size of the write-combining buffer, must divide the sector size */
+#define FLASH_STORE_PAGE_SIZE   256
+
+/** Invalid key, keys are in the [0, FLASH_STORE_INVALID_KEY[ range */
+#define FLASH_STORE_INVALID_KEY 0xffff
+
+struct flash_store;
+
+/**
+ * Flash access functions of a store.
+ *
+ * Addresses are byte offsets in the flash device. Programs are 4 bytes
+ * aligned and never program twice the same byte between erases.
+ * All functions return 0 on success, a negative error code otherwise.
+ */
+struct flash_store_ops {
+    int (*read)(struct flash_store *fs, uint32_t addr, void *buf, unsigned int len);
+    int (*program)(struct flash_store *fs, uint32_t addr, const void *buf, unsigned int len);
+    int (*erase)(struct flash_store *fs, uint32_t addr);   /*!< erase the sector at addr */
+    int (*erase_size)(struct flash_store *fs, uint32_t *size); /*!< erase unit of the device */
+};
+
+/** Run-time information of a sector, private to the store */
+struct flash_store_sector {
+    uint32_t seq;           /*!< Position in the log, FLASH_STORE_FREE_SEQ if free */
+    uint32_t erase_count;   /*!< Number of erase cycles of the sector */
+    uint16_t live;          /*!< Bytes of records that are still current */
+};
+
+/** Index entry, private to the store */
+struct flash_store_entry {
+    uint16_t key;
+    uint16_t len;           /*!< Value length, FLASH_STORE_DELETED for a deletion */
+    uint32_t addr;          /*!< Address of the record */
+};
+
+/**
+ * Store descriptor.
+ *
+ * The fields before the private part are set by the user before
+ * flash_store_mount().
+ */
+struct flash_store {
+    const struct flash_store_ops *ops;  /*!< Flash access functions */
+    void *priv;                         /*!< Flash device, for ops */
+    uint32_t base;                      /*!< Address of the first sector */
+    uint32_t sector_size;               /*!< Sector size, a multiple of the erase unit */
+    uint16_t sector_count;              /*!< Number of sectors, at least 3 */
+    uint16_t max_keys;                  /*!< Number of keys of the RAM index */
+
+    /* Statistics, reset by flash_store_mount() */
+    uint32_t stat_user_bytes;           /*!< Bytes written by the user */
+    uint32_t stat_flash_bytes;          /*!< Bytes programmed to flash */
+    uint32_t stat_erases;               /*!< Sectors erased */
+
+    /* Private */
+    uint32_t erase_size;                /*!< Erase unit of the device */
+    struct flash_store_sector *sectors;
+    struct flash_store_entry *index;
+    uint16_t key_count;
+    uint16_t free_count;
+    uint16_t head;                      /*!< Sector being written */
+    uint32_t head_off;                  /*!< Offset of the next record in head */
+    uint32_t seq;                       /*!< Position of head in the log */
+    uint32_t wbuf_addr;                 /*!< Page cached in wbuf */
+    uint16_t wbuf_flushed;              /*!< Bytes of wbuf already programmed */
+    uint16_t wbuf_fill;                 /*!< Bytes of wbuf in use */
+    uint8_t wbuf[FLASH_STORE_PAGE_SIZE];
+};
+
+/**
+ * Mount a store, formatting the sectors that do not belong to it.
+ *
+ * @param fs store to mount, with its user fields set
+ *
+ * The base and the sector size must be multiples of the erase unit of the
+ * device.
+ *
+ * @return 0 on success, -EINVAL on bad geometry, -ENOMEM if the index is
+ *         too small for the keys found, -EIO on flash error
+ */
+int flash_store_mount(struct flash_store *fs);
+
+/**
+ * Write a value.
+ *
+ * The value is buffered in RAM, see flash_store_sync().
+ *
+ * @param fs   store
+ * @param key  key of the value
+ * @param data value
+ * @param len  length of the value
+ *
+ * @return 0 on success, -EINVAL on bad parameter, -ENOMEM if the index is
+ *         full, -ENOSPC if the store is full, -EIO on flash error
+ */
+int flash_store_write(struct flash_store *fs, uint16_t key, const void *data,
+                      unsigned int len);
+
+/**
+ * Read a value.
+ *
+ * @param fs   store
+ * @param key  key of the value
+ * @param data buffer to read into
+ * @param len  size of the buffer
+ *
+ * @return length of the value, which is truncated to len, -ENOENT if the
+ *         key does not exist, -EIO on flash error
+ */
+int flash_store_read(struct flash_store *fs, uint16_t key, void *data,
+                     unsigned int len);
+
+/**
+ * Delete a value.
+ *
+ * @param fs   store
+ * @param key  key of the value
+ *
+ * @return 0 on success, -ENOENT if the key does not exist, or as
+ *         flash_store_write()
+ */
+int flash_store_delete(struct flash_store *fs, uint16_t key);
+
+/**
+ * Program the buffered writes to flash.
+ *
+ * Writes are buffered until a page is complete, call this function to make
+ * them persistent.
+ *
+ * @param fs   store
+ *
+ * @return 0 on success, -EIO on flash error
+ */
+int flash_store_sync(struct flash_store *fs);
+
+/**
+ * Reclaim one sector if the store is short of free sectors.
+ *
+ * The store reclaims sectors itself when it is full. This function is meant
+ * to be called from a low priority context so that writes seldom have to.
+ *
+ * @param fs   store
+ *
+ * @return 1 if a sector was reclaimed, 0 if there was no need to, a negative
+ *         error code otherwise
+ */
+int flash_store_gc(struct flash_store *fs);
+
+#ifdef CONFIG_SPI_FLASH_INTEL_QRK
+/** Access functions for a spi_flash device, priv is the struct device */
+extern const struct flash_store_ops flash_store_spi_ops;
+#endif
+
+#ifdef CONFIG_SOC_FLASH
+/** Access functions for the SOC flash, priv is unused */
+extern const struct flash_store_ops flash_store_soc_ops;
+#endif
+
+/** @} */
+
+#endif /* __INFRA_FLASH_STORE_H__ */
@@ -34,6 +34,9 @@
 
 #include "infra/ipc_requests.h"
 #include "infra/message.h"
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+#include "util/list.h"
+#endif
 
 /**
  * @defgroup ipc IPC layer
@@ -84,6 +87,63 @@ void ipc_init(int tx_channel, int rx_channel, int tx_ack_channel,
  */
 int ipc_request_sync_int(int request_id, int param1, int param2, void *ptr);
 
+/**
+ * Requests a synchronous IPC call, busy-waiting for the answer.
+ *
+ * Same as ipc_request_sync_int(), for contexts where the caller must not
+ * sleep, such as panic handlers.
+ *
+ * @param request_id the synchronous request id
+ * @param param1 the first param for the request
+ * @param param2 the second param for the request
+ * @param ptr the third param for the request
+ *
+ * @return the synchronous command response.
+ */
+int ipc_request_sync_poll(int request_id, int param1, int param2, void *ptr);
+
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+/**
+ * Asynchronous IPC request.
+ *
+ * The request belongs to the IPC layer from ipc_request_submit() until its
+ * callback is called.
+ */
+struct ipc_request {
+	list_t list;      /*!< private: pending requests list */
+	int request_id;   /*!< the synchronous request id */
+	int param1;       /*!< the first param for the request */
+	int param2;       /*!< the second param for the request */
+	void *ptr;        /*!< the third param for the request */
+	int ret;          /*!< the remote answer, valid in the callback */
+	uint16_t seq;     /*!< private: sequence number on the wire */
+	/** Completion callback, called from the mailbox interrupt with interrupts
+	 * locked */
+	void (*callback)(struct ipc_request *req);
+	void *priv;       /*!< caller data */
+};
+
+/**
+ * Queues an IPC request to the remote CPU.
+ *
+ * Requests are sent in order, one at a time. The callback is called when the
+ * remote acknowledges the request.
+ *
+ * @param req the request to send
+ */
+void ipc_request_submit(struct ipc_request *req);
+#endif
+
+#ifdef CONFIG_IPC_MSG_RING
+/**
+ * Delivers the messages and message frees posted by the remote CPU on the
+ * shared message ring.
+ *
+ * Called from the IPC interrupt when the remote rings the doorbell.
+ */
+void ipc_msg_ring_drain(void);
+#endif
+
 /**
  * Polling mode polling call.
  *
@@ -96,6 +96,10 @@
  * The message is for power management (deep sleep).
  */
 #define IPC_REQUEST_INFRA_PM           0x18
+/**
+ * Messages were posted on the shared message ring (doorbell).
+ */
+#define IPC_REQUEST_MSG_RING           0x19
 
 /** @} */
 #endif
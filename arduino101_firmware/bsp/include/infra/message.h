@@ -76,11 +76,15 @@ typedef enum {
  * prio: priority of the message.
  * class: class of the message
  * type: type of message
+ * shared: message is reference counted, see message_share()
+ * ref: message is a struct message_ref
  */
 struct msg_flags {
 	uint16_t f_prio: 8;
 	uint16_t f_class: 3;
 	uint16_t f_type: 2;
+	uint16_t f_shared: 1;
+	uint16_t f_ref: 1;
 };
 
 /**
@@ -135,10 +139,41 @@ struct message * message_alloc(int size, OS_ERR_TYPE * err);
 /**
  * Free an allocated message
  *
+ * A shared message is only freed when its last reference is released.
+ *
  * @param message the message allocated with message_alloc()
  */
 void message_free(struct message *message);
 
+#ifdef CONFIG_PORT_SHARED_MESSAGES
+/**
+ * Envelope used to deliver a shared message to a port.
+ *
+ * The envelope is freed by port_process_message() which passes the shared
+ * message to the port handler instead.
+ */
+struct message_ref {
+	/** Envelope header, holds the destination port */
+	struct message m;
+	/** The shared message */
+	struct message *ref;
+};
+
+/**
+ * Copy a message into a new reference counted message.
+ *
+ * The returned message holds one reference, released with message_free().
+ * A shared message must not be modified, and can only be delivered to ports
+ * of the local cpu with port_send_message_ref().
+ *
+ * @param message the message to copy
+ * @param err the eventual return code pointer, see message_alloc()
+ *
+ * @return the shared message or NULL if allocation failed and err != NULL
+ */
+struct message * message_share(const struct message *message, OS_ERR_TYPE * err);
+#endif
+
 /** @} */
 /** @} */
 #endif /* __INFRA_MESSAGE_H_ */
@@ -190,6 +190,20 @@ int pm_core_specific_deepsleep(int auto_wake_time);
  */
 void pm_core_specific_ack_error();
 
+/**
+ * Wakelock hold time statistics.
+ *
+ * Hold times are counted from pm_wakelock_acquire to the release or the
+ * timeout of the wakelock.
+ */
+struct pm_wakelock_stats {
+    uint32_t acquire_count; /*!< Number of times the wakelock was acquired */
+    uint32_t expire_count;  /*!< Number of times the wakelock timed out */
+    uint32_t total_time;    /*!< Cumulated hold time in ms */
+    uint32_t max_time;      /*!< Longest hold time in ms */
+    uint32_t acquire_time;  /*!< Time in ms of the last acquisition */
+};
+
 /**
  * Wakelock managing structure.
  *
@@ -203,11 +217,15 @@ void pm_core_specific_ack_error();
  * A component using wakelocks should allocate a struct pm_wakelock.
  */
 struct pm_wakelock {
-    list_t list;         /*!< Internal list management member */
+    struct pm_wakelock *next; /*!< Internal list management member */
+    struct pm_wakelock *prev; /*!< Internal list management member */
     int id;              /*!< Client identifier for the hook. must be platform global */
     uint32_t timeout;    /*!< Wakelock timeout in ms (used to release the wakelock after a timeout) */
     uint32_t start_time; /*!< Start time in ms (used to compute expiration time) */
     unsigned int lock;   /*!< Lock to avoid acquiring a lock several times */
+#ifdef CONFIG_WAKELOCK_STATS
+    struct pm_wakelock_stats stats; /*!< Hold time statistics */
+#endif
 };
 
 /**
@@ -254,6 +272,27 @@ int pm_wakelock_release(struct pm_wakelock *wl);
  */
 bool pm_wakelock_is_list_empty();
 
+/**
+ * Checks if a wakelock is held.
+ *
+ * @param id the identifier of the wakelock, as defined in wakelock_ids.h
+ *
+ * @return true if at least one wakelock with this identifier is acquired
+ */
+bool pm_wakelock_is_held(int id);
+
+#ifdef CONFIG_WAKELOCK_STATS
+/**
+ * Gets the hold time statistics of a wakelock.
+ *
+ * @param wl    the wakelock
+ * @param stats the structure to fill, the hold time of a wakelock still
+ *              acquired is not accounted yet
+ */
+void pm_wakelock_get_stats(const struct pm_wakelock *wl,
+                           struct pm_wakelock_stats *stats);
+#endif
+
 /**
  * Checks that all deep sleep blockers are released.
  *
@@ -93,6 +93,22 @@ void port_process_message(struct message * msg);
  */
 int port_send_message(struct message * msg);
 
+#ifdef CONFIG_PORT_SHARED_MESSAGES
+/**
+ * Deliver a shared message to a port of the local cpu.
+ *
+ * A reference is taken on the message and released by the receiver with
+ * message_free(). The destination port of the message itself is not
+ * modified.
+ *
+ * @param msg the message returned by message_share()
+ * @param port_id the destination port
+ *
+ * @return E_OS_OK if the message was queued, an error code otherwise
+ */
+int port_send_message_ref(struct message * msg, uint16_t port_id);
+#endif
+
 /**
  * Set the port id of the given port.
  *
@@ -158,6 +174,73 @@ uint16_t queue_process_message(T_QUEUE queue);
  */
 uint16_t queue_process_message_wait(T_QUEUE queue, uint32_t timeout, OS_ERR_TYPE* err);
 
+#ifdef CONFIG_PORT_STATS
+/** Number of buckets of the message length histogram */
+#define PORT_STATS_LEN_BUCKETS 6
+
+/**
+ * Statistics of a port.
+ *
+ * Latencies and handler times are in microseconds.
+ */
+struct port_stats {
+	/** Messages sent to the port */
+	uint32_t sent;
+	/** Messages dispatched to the port handler */
+	uint32_t received;
+	/** Messages that could not be queued */
+	uint32_t dropped;
+	/** Sent messages by length: up to 16, 32, 64, 128, 256 bytes, and more */
+	uint32_t len_hist[PORT_STATS_LEN_BUCKETS];
+	/** Messages sent to the port and not dispatched yet */
+	uint16_t depth;
+	/** Maximum value of depth */
+	uint16_t max_depth;
+	/** Number of enqueue to dispatch latency samples */
+	uint32_t latency_count;
+	/** Sum of the enqueue to dispatch latency samples */
+	uint32_t latency_total;
+	/** Longest enqueue to dispatch latency */
+	uint32_t latency_max;
+	/** Longest time spent in the port handler */
+	uint32_t handler_max;
+	/** Identifier of the message that took handler_max */
+	uint16_t handler_max_msg_id;
+};
+
+/**
+ * Get the statistics of a port.
+ *
+ * @param port_id the port
+ * @param stats   the structure to fill
+ */
+void port_stats_get(uint16_t port_id, struct port_stats * stats);
+
+/**
+ * Reset the statistics of all ports.
+ */
+void port_stats_reset(void);
+
+/**
+ * Log the statistics of all ports that sent or received messages.
+ */
+void port_stats_dump(void);
+
+/**
+ * Copy the statistics of all ports that sent or received messages to a
+ * buffer.
+ *
+ * The snapshot is the number of ports as a uint16_t followed, for each
+ * port, by the port id as a uint16_t and its struct port_stats.
+ *
+ * @param buf  the buffer to fill
+ * @param size the size of buf
+ *
+ * @return the snapshot length, or -1 if buf is too small
+ */
+int port_stats_snapshot(void * buf, int size);
+#endif
+
 /**
  * Multi CPU support APIs.
  */
@@ -45,4 +45,6 @@
 #define OPENCORE_WAKELOCK   0xb0 /*!< open core wakelock for pool sensor data */
 #define NFC_WAKELOCK        0xc0 /*!< nfc devices wakelock base */
 
+#define WAKELOCK_ID_MAX     0x100 /*!< wakelock ids are below this value */
+
 #endif /* _WAKELOCK_IDS_H_ */
@@ -39,7 +39,14 @@
 #define CPU_ID_HOST 3
 #define NUM_CPU     4
 
+/* Size of the CDC-ACM ring buffers, a power of 2. Both cores must be built
+ * with the same value. */
+#ifndef SERIAL_BUFFER_SIZE
 #define SERIAL_BUFFER_SIZE 256
+#endif
+#if (SERIAL_BUFFER_SIZE & (SERIAL_BUFFER_SIZE - 1)) != 0
+#error "SERIAL_BUFFER_SIZE must be a power of 2"
+#endif
 
 struct cdc_ring_buffer
 {
@@ -62,6 +69,24 @@ struct cdc_acm_shared_data {
     int device_open;
 };
 
+/* Number of entries of an IPC message ring, a power of 2 */
+#define IPC_MSG_RING_SIZE 32
+
+/**
+ * Single producer / single consumer IPC message ring. The head is only
+ * written by the producing core and the tail by the consuming one.
+ */
+struct ipc_msg_ring {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t entries[IPC_MSG_RING_SIZE];
+};
+
+struct ipc_msg_rings {
+    /** Ring 0 goes from QRK to ARC, ring 1 from ARC to QRK */
+    struct ipc_msg_ring ring[2];
+};
+
 /**
  * QRK / ARC global shared structure. This structure lies in the beginning of
  * the RAM.
@@ -110,6 +135,22 @@ struct platform_shared_block_ {
      */
     struct cdc_acm_shared_data  * cdc_acm_buffers;
 
+    /* Pointer to the shared message rings used by IPC.
+     *
+     * The QRK core allocates the rings and sets this pointer prior to
+     * starting ARC.
+     */
+    struct ipc_msg_rings * ipc_msg_rings;
+
+    /* Set by ARC when it uses the shared message rings.
+     *
+     * QRK clears it prior to starting ARC, and keeps sending its messages
+     * through the mailbox until it is set: an ARC firmware without the rings
+     * never reads them. Being the last member, it moves none of the others
+     * for a firmware built without it.
+     */
+    uint8_t arc_ipc_msg_ring;
+
 };
 
 #define RAM_START           0xA8000000
@@ -209,6 +250,7 @@ typedef enum {
 	MLAYER_CLK_GATE   = 33,
 	QRK_CLK_GATE      = 34,
 	NFC_STN54E_ID     = 35,
+	DEVICE_ID_COUNT
 } DEVICE_ID;
 
 #endif
@@ -40,6 +40,7 @@ typedef struct cbuffer {
     uint8_t saturation_flag;
     uint8_t *buf;
     uint32_t buf_size;
+    uint32_t dropped;   /* records dropped by cb_push_record() on saturation */
 } cbuffer_t;
 
 /**
@@ -91,4 +92,35 @@ int32_t cb_pop(cbuffer_t *src, const uint32_t offset, uint8_t *dst, const uint8_
  * @return -2 if error, -1 if not found; else index in cbuffer buf where first found
  */
 int32_t cb_find(const uint8_t byte, const cbuffer_t *src, const uint32_t start, const uint32_t stop, const uint32_t cnt);
+
+/**
+ * Write a record to a cbuffer.
+ *
+ * The record is stored after a one byte length header. When there is not
+ * enough room, the oldest records are dropped as a whole and counted in
+ * dst->dropped. A cbuffer must either be accessed with the record functions
+ * only, or not at all.
+ *
+ * @param dst     cbuffer in which to write
+ * @param src     Pointer to the record
+ * @param length  Length of the record
+ *
+ * @return -1  if bad length,
+ *          0  if no error,
+ *          1  if older records were dropped
+ */
+int32_t cb_push_record(cbuffer_t *dst, const uint8_t *src, const uint8_t length);
+
+/**
+ * Read the oldest record of a cbuffer.
+ *
+ * @param src         cbuffer from which to read
+ * @param dst         Pointer to destination
+ * @param max_length  Size of the destination
+ *
+ * @return -1  if the record is larger than max_length, it is dropped
+ *          0  if the cbuffer is empty
+ *          length of the record otherwise
+ */
+int32_t cb_pop_record(cbuffer_t *src, uint8_t *dst, const uint32_t max_length);
 #endif /* __CBUFFER_H */
@@ -187,6 +187,19 @@ void* soc_gpio_get_callback_arg(struct device *dev, uint8_t pin)
     return gpio_dev->gpio_cb_arg[pin];
 }
 
+DRIVER_API_RC soc_gpio_set_port_callback(struct device *dev, uint32_t mask, gpio_port_callback_fn cb, void *arg)
+{
+    gpio_info_pt gpio_dev = (gpio_info_pt)dev->priv;
+    uint32_t saved = interrupt_lock();
+
+    gpio_dev->port_cb = cb;
+    gpio_dev->port_cb_arg = arg;
+    gpio_dev->port_cb_mask = cb ? mask : 0;
+    interrupt_unlock(saved);
+
+    return DRV_RC_OK;
+}
+
 DRIVER_API_RC soc_gpio_set_config(struct device *dev, uint8_t bit, gpio_cfg_data_t *config)
 {
     gpio_info_pt gpio_dev = (gpio_info_pt)dev->priv;
@@ -371,6 +384,39 @@ DRIVER_API_RC soc_gpio_write_port(struct device *dev, uint32_t value)
     return DRV_RC_OK;
 }
 
+DRIVER_API_RC soc_gpio_write_port_masked(struct device *dev, uint32_t mask, uint32_t value)
+{
+    gpio_info_pt gpio_dev = (gpio_info_pt)dev->priv;
+    uint32_t saved;
+    uint32_t dr;
+
+    // Check pin mask
+    if (gpio_dev->no_bits < 32 && (mask >> gpio_dev->no_bits)) {
+        return DRV_RC_CONTROLLER_NOT_ACCESSIBLE;
+    }
+    /* read/modify/write the masked bits in a single register access */
+    saved = interrupt_lock();
+    dr = MMIO_REG_VAL_FROM_BASE(gpio_dev->reg_base, SOC_GPIO_SWPORTA_DR);
+    MMIO_REG_VAL_FROM_BASE(gpio_dev->reg_base, SOC_GPIO_SWPORTA_DR) = (dr & ~mask) | (value & mask);
+    interrupt_unlock(saved);
+    return DRV_RC_OK;
+}
+
+DRIVER_API_RC soc_gpio_toggle_port(struct device *dev, uint32_t mask)
+{
+    gpio_info_pt gpio_dev = (gpio_info_pt)dev->priv;
+    uint32_t saved;
+
+    // Check pin mask
+    if (gpio_dev->no_bits < 32 && (mask >> gpio_dev->no_bits)) {
+        return DRV_RC_CONTROLLER_NOT_ACCESSIBLE;
+    }
+    saved = interrupt_lock();
+    MMIO_REG_VAL_FROM_BASE(gpio_dev->reg_base, SOC_GPIO_SWPORTA_DR) ^= mask;
+    interrupt_unlock(saved);
+    return DRV_RC_OK;
+}
+
 DRIVER_API_RC soc_gpio_read(struct device *dev, uint8_t bit, bool *value)
 {
     gpio_info_pt gpio_dev = (gpio_info_pt)dev->priv;
@@ -416,17 +462,22 @@ static void soc_gpio_ISR_proc(struct device *dev)
     uint32_t status = MMIO_REG_VAL_FROM_BASE(gpio_dev->reg_base, SOC_GPIO_INTSTATUS);
     // Clear interrupt flag (write 1 to clear)
     MMIO_REG_VAL_FROM_BASE(gpio_dev->reg_base, SOC_GPIO_PORTA_EOI) = status;
+    // Pin levels, read once for all the pins
+    uint32_t levels = MMIO_REG_VAL_FROM_BASE(gpio_dev->reg_base, SOC_GPIO_EXT_PORTA);
 
-    for (i=0; i<gpio_dev->no_bits; i++) {
-        if ((status & (1 << i))) {
-            if (gpio_dev->gpio_cb[i]) {
-                (gpio_dev->gpio_cb[i])(
-                        !!(MMIO_REG_VAL_FROM_BASE(gpio_dev->reg_base, SOC_GPIO_EXT_PORTA) & (1 << i)),
-                        gpio_dev->gpio_cb_arg[i]);
-            } else {
-                pr_info(LOG_MODULE_DRV, "spurious isr: %d on %d", i, dev->id);
-                soc_gpio_mask_interrupt(dev, i);
-            }
+    if (status & gpio_dev->port_cb_mask) {
+        gpio_dev->port_cb(status & gpio_dev->port_cb_mask, levels, gpio_dev->port_cb_arg);
+        status &= ~gpio_dev->port_cb_mask;
+    }
+
+    while (status) {
+        i = __builtin_ctz(status);
+        status &= status - 1;
+        if (gpio_dev->gpio_cb[i]) {
+            (gpio_dev->gpio_cb[i])(!!(levels & (1 << i)), gpio_dev->gpio_cb_arg[i]);
+        } else {
+            pr_info(LOG_MODULE_DRV, "spurious isr: %d on %d", i, dev->id);
+            soc_gpio_mask_interrupt(dev, i);
         }
     }
 }
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sequential read and write throughput of spi_flash.c on the W25Q16DV model
+ * of spi_flash_sim.c, in simulated time: 64 KiB in 4 KiB requests through
+ * the synchronous API, and with CONFIG_SPI_FLASH_ASYNC, the 16 requests
+ * submitted at once.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "spi_flash_sim.h"
+#include "drivers/spi_flash.h"
+
+#ifdef CONFIG_SPI_FLASH_ASYNC
+#define VARIANT "async"
+#else
+#define VARIANT "sync"
+#endif
+
+#define TOTAL   (64 * 1024)
+#define CHUNK   4096
+
+static uint8_t data[TOTAL];
+static uint8_t readback[TOTAL];
+
+static uint64_t start_us;
+static struct sim_stats start_stats;
+
+static void begin(void)
+{
+    start_us = sim_now();
+    start_stats = sim_stats;
+}
+
+static void report(const char *name)
+{
+    uint64_t us = sim_now() - start_us;
+
+    printf("%-5s %-12s %6.1f KiB/s %6.1f transfers/KiB %5u status reads %3.0f%% bus busy\n",
+           VARIANT, name, TOTAL / 1024.0 / (us / 1e6),
+           (sim_stats.transfers - start_stats.transfers) / (TOTAL / 1024.0),
+           sim_stats.status_reads - start_stats.status_reads,
+           100.0 * (sim_stats.bus_us - start_stats.bus_us) / us);
+}
+
+static void sync_bench(struct device *dev)
+{
+    unsigned int retlen;
+    uint32_t address;
+
+    begin();
+    for (address = 0; address < TOTAL; address += CHUNK) {
+        if (spi_flash_write_byte(dev, address, CHUNK, &retlen, data + address) != DRV_RC_OK) {
+            printf("write failed\n");
+        }
+    }
+    report("write");
+
+    begin();
+    for (address = 0; address < TOTAL; address += CHUNK) {
+        if (spi_flash_read_byte(dev, address, CHUNK, &retlen, readback + address) != DRV_RC_OK) {
+            printf("read failed\n");
+        }
+    }
+    report("read");
+}
+
+#ifdef CONFIG_SPI_FLASH_ASYNC
+static struct spi_flash_request requests[TOTAL / CHUNK];
+static unsigned int pending;
+static volatile int all_done;
+
+static void request_done(struct spi_flash_request *req)
+{
+    if (req->status != DRV_RC_OK) {
+        printf("request failed\n");
+    }
+    all_done = (--pending == 0);
+}
+
+static void async_bench(struct device *dev, SPI_FLASH_REQUEST_TYPE type, uint8_t *buffer)
+{
+    unsigned int i;
+
+    begin();
+    all_done = 0;
+    pending = TOTAL / CHUNK;
+    for (i = 0; i < TOTAL / CHUNK; i++) {
+        requests[i].type = type;
+        requests[i].address = TOTAL + i * CHUNK;
+        requests[i].len = CHUNK;
+        requests[i].data = buffer + i * CHUNK;
+        requests[i].callback = request_done;
+        spi_flash_submit(dev, &requests[i]);
+    }
+    sim_run(&all_done);
+    report(type == SPI_FLASH_REQ_WRITE ? "queued write" : "queued read");
+}
+#endif
+
+int main(void)
+{
+    struct device *dev;
+    unsigned int i;
+
+    for (i = 0; i < TOTAL; i++)
+        data[i] = i * 13 + (i >> 9);
+
+    dev = sim_flash_init();
+    if (dev == NULL) {
+        printf("init failed\n");
+        return 1;
+    }
+    sync_bench(dev);
+    if (memcmp(readback, data, TOTAL) != 0) {
+        printf("read back differs\n");
+        return 1;
+    }
+#ifdef CONFIG_SPI_FLASH_ASYNC
+    async_bench(dev, SPI_FLASH_REQ_WRITE, data);
+    memset(readback, 0, TOTAL);
+    async_bench(dev, SPI_FLASH_REQ_READ, readback);
+    if (memcmp(readback, data, TOTAL) != 0) {
+        printf("read back differs\n");
+        return 1;
+    }
+#endif
+    return 0;
+}
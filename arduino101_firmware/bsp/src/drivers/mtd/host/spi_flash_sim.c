@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * W25Q16DV, SBA bus and OS layer models for the host build of spi_flash.c,
+ * see spi_flash_sim.h.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spi_flash_sim.h"
+#include "drivers/spi_flash.h"
+#include "drivers/serial_bus_access.h"
+#include "infra/log.h"
+#include "infra/pm.h"
+#include "os/os.h"
+#include "../spi_flash_w25qxxdv_defs.h"
+
+#define MAX_EVENTS 8
+
+struct sim_event {
+    uint64_t at;
+    void (*fn)(void *arg);
+    void *arg;
+};
+
+struct sim_timer {
+    T_ENTRY_POINT callback;
+    void *priv;
+    uint32_t delay;
+    int event;                  /* pending event, -1 if stopped */
+};
+
+struct sim_semaphore {
+    uint32_t count;
+};
+
+struct sim_stats sim_stats;
+unsigned int sim_program_us = SIM_PROGRAM_US;
+int32_t sim_fail_page = -1;
+
+static struct sim_event events[MAX_EVENTS];
+static int event_count;
+static uint64_t now_us;
+static uint64_t bus_free_us;    /* end of the last transfer queued */
+
+static uint8_t *flash;
+static int wel;
+static int pfail;
+static uint64_t busy_until;
+
+static struct bus sim_bus;
+static struct sba_device sim_device = {
+    .dev.parent = &sim_bus,
+    .dev.driver = &spi_flash_driver,
+};
+
+/* Events */
+
+static int schedule(uint64_t at, void (*fn)(void *), void *arg)
+{
+    int i;
+
+    if (event_count == MAX_EVENTS) {
+        fprintf(stderr, "too many pending events\n");
+        exit(2);
+    }
+    for (i = 0; i < MAX_EVENTS; i++) {
+        if (events[i].fn == NULL) {
+            events[i].at = at;
+            events[i].fn = fn;
+            events[i].arg = arg;
+            event_count++;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void cancel(int event)
+{
+    events[event].fn = NULL;
+    event_count--;
+}
+
+/* Run the next event if it is due before the deadline, return 0 if none */
+static int run_next(uint64_t deadline)
+{
+    void (*fn)(void *);
+    void *arg;
+    int next = -1;
+    int i;
+
+    for (i = 0; i < MAX_EVENTS; i++) {
+        if (events[i].fn != NULL && (next < 0 || events[i].at < events[next].at)) {
+            next = i;
+        }
+    }
+    if (next < 0 || events[next].at > deadline) {
+        return 0;
+    }
+    if (events[next].at > now_us) {
+        now_us = events[next].at;
+    }
+    fn = events[next].fn;
+    arg = events[next].arg;
+    cancel(next);
+    fn(arg);
+    return 1;
+}
+
+uint64_t sim_now(void)
+{
+    return now_us;
+}
+
+void sim_run(volatile int *done)
+{
+    while (!*done) {
+        if (!run_next(UINT64_MAX)) {
+            fprintf(stderr, "deadlock: nothing left to run\n");
+            exit(2);
+        }
+    }
+}
+
+/* W25Q16DV */
+
+static uint32_t command_address(const uint8_t *tx)
+{
+    return (uint32_t)tx[1] << 16 | (uint32_t)tx[2] << 8 | tx[3];
+}
+
+static void flash_command(uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len, uint64_t end)
+{
+    uint32_t address, i;
+    int busy = busy_until > end;
+
+    if (busy && tx[0] != FLASH_CMD_RDSR) {
+        sim_stats.busy_errors++;
+        return;
+    }
+
+    switch (tx[0]) {
+    case FLASH_CMD_RDP:
+        break;
+    case FLASH_CMD_RDID:
+        rx[0] = FLASH_RDID_VALUE & 0xff;
+        rx[1] = (FLASH_RDID_VALUE >> 8) & 0xff;
+        rx[2] = (FLASH_RDID_VALUE >> 16) & 0xff;
+        break;
+    case FLASH_CMD_RDSR:
+        rx[0] = (busy ? FLASH_WIP_BIT : 0) | (wel ? FLASH_WEL_BIT : 0);
+        sim_stats.status_reads++;
+        break;
+    case FLASH_CMD_RDSCUR:
+        rx[0] = pfail ? FLASH_SECR_PFAIL_BIT : 0;
+        break;
+    case FLASH_CMD_WREN:
+        wel = 1;
+        break;
+    case FLASH_CMD_READ:
+    case FLASH_CMD_FASTREAD:
+        address = command_address(tx);
+        for (i = 0; i < rx_len; i++) {
+            rx[i] = flash[(address + i) % FLASH_SIZE];
+        }
+        break;
+    case FLASH_CMD_PP:
+        if (!wel) {
+            break;
+        }
+        wel = 0;
+        address = command_address(tx);
+        pfail = (sim_fail_page >= 0 &&
+                 address / FLASH_PAGE_SIZE == (uint32_t)sim_fail_page / FLASH_PAGE_SIZE);
+        busy_until = end + sim_program_us;
+        if (pfail) {
+            break;
+        }
+        for (i = 4; i < tx_len; i++) {
+            // The address wraps within the page
+            uint32_t a = (address & ~(FLASH_PAGE_SIZE - 1)) |
+                         ((address + i - 4) & (FLASH_PAGE_SIZE - 1));
+            if (flash[a] != 0xff) {
+                sim_stats.dirty++;
+            }
+            flash[a] &= tx[i];
+        }
+        break;
+    case FLASH_CMD_SE:
+        if (!wel) {
+            break;
+        }
+        wel = 0;
+        address = command_address(tx) & ~(FLASH_SECTOR_SIZE - 1);
+        memset(flash + address, 0xff, FLASH_SECTOR_SIZE);
+        busy_until = end + SIM_ERASE_US;
+        break;
+    default:
+        fprintf(stderr, "unexpected flash command %02x\n", tx[0]);
+        exit(2);
+    }
+}
+
+/* SBA bus */
+
+static void sba_complete(void *arg)
+{
+    struct sba_request *req = arg;
+
+    req->status = 0;
+    if (req->callback) {
+        req->callback(req);
+    }
+}
+
+DRIVER_API_RC sba_exec_dev_request(struct sba_device *dev, struct sba_request *req)
+{
+    uint64_t us = (uint64_t)(req->tx_len + req->rx_len) * 8 * 1000 / SIM_SPI_KHZ
+                  + SIM_TRANSFER_US;
+    uint64_t end;
+
+    // The driver waits for each transfer before starting the next one
+    if (bus_free_us > now_us) {
+        fprintf(stderr, "transfer started while the bus is busy\n");
+        exit(2);
+    }
+    end = now_us + us;
+    bus_free_us = end;
+    sim_stats.transfers++;
+    sim_stats.bus_us += us;
+    // The flash state is sampled at the end of the transfer
+    flash_command(req->tx_buff, req->tx_len, req->rx_buff, req->rx_len, end);
+    schedule(end, sba_complete, req);
+    return DRV_RC_OK;
+}
+
+/* OS layer */
+
+uint32_t interrupt_lock(void)
+{
+    return 0;
+}
+
+void interrupt_unlock(uint32_t key)
+{
+}
+
+void *balloc(uint32_t size, OS_ERR_TYPE *err)
+{
+    return malloc(size);
+}
+
+OS_ERR_TYPE bfree(void *buffer)
+{
+    free(buffer);
+    return E_OS_OK;
+}
+
+T_SEMAPHORE semaphore_create(uint32_t initialCount, OS_ERR_TYPE *err)
+{
+    struct sim_semaphore *sem = calloc(1, sizeof(*sem));
+
+    sem->count = initialCount;
+    return sem;
+}
+
+void semaphore_delete(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
+{
+    free(semaphore);
+}
+
+void semaphore_give(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
+{
+    ((struct sim_semaphore *)semaphore)->count++;
+}
+
+OS_ERR_TYPE semaphore_take(T_SEMAPHORE semaphore, int timeout)
+{
+    struct sim_semaphore *sem = semaphore;
+    uint64_t deadline = (timeout == OS_WAIT_FOREVER) ? UINT64_MAX
+                        : now_us + (uint64_t)timeout * 1000;
+
+    while (sem->count == 0) {
+        if (!run_next(deadline)) {
+            if (deadline == UINT64_MAX) {
+                fprintf(stderr, "deadlock: semaphore never given\n");
+                exit(2);
+            }
+            now_us = deadline;
+            return E_OS_ERR_BUSY;
+        }
+    }
+    sem->count--;
+    return E_OS_OK;
+}
+
+static void timer_expire(void *arg)
+{
+    struct sim_timer *timer = arg;
+
+    timer->event = -1;
+    timer->callback(timer->priv);
+}
+
+T_TIMER timer_create(T_ENTRY_POINT callback, void *privData, uint32_t delay,
+                     bool repeat, bool startup, OS_ERR_TYPE *err)
+{
+    struct sim_timer *timer = calloc(1, sizeof(*timer));
+
+    timer->callback = callback;
+    timer->priv = privData;
+    timer->delay = delay;
+    timer->event = -1;
+    if (startup) {
+        timer_start(timer, delay, err);
+    }
+    return timer;
+}
+
+void timer_start(T_TIMER tmr, uint32_t delay, OS_ERR_TYPE *err)
+{
+    struct sim_timer *timer = tmr;
+
+    if (timer->event >= 0) {
+        cancel(timer->event);
+    }
+    timer->event = schedule(now_us + (uint64_t)delay * 1000, timer_expire, timer);
+    if (err) {
+        *err = E_OS_OK;
+    }
+}
+
+void timer_delete(T_TIMER tmr, OS_ERR_TYPE *err)
+{
+    struct sim_timer *timer = tmr;
+
+    if (timer->event >= 0) {
+        cancel(timer->event);
+    }
+    free(timer);
+}
+
+/* Infra */
+
+void pm_wakelock_init(struct pm_wakelock *wli, int id)
+{
+}
+
+int pm_wakelock_acquire(struct pm_wakelock *wl, unsigned int timeout)
+{
+    return 0;
+}
+
+int pm_wakelock_release(struct pm_wakelock *wl)
+{
+    return 0;
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    return 0;
+}
+
+/* Setup */
+
+struct device *sim_flash_init(void)
+{
+    if (flash == NULL) {
+        flash = malloc(FLASH_SIZE);
+    }
+    memset(flash, 0xff, FLASH_SIZE);
+    wel = 0;
+    pfail = 0;
+    busy_until = 0;
+    memset(&sim_stats, 0, sizeof(sim_stats));
+
+    if (sim_device.dev.driver->init(&sim_device.dev) != 0) {
+        return NULL;
+    }
+    return &sim_device.dev;
+}
+
+uint8_t *sim_flash_data(void)
+{
+    return flash;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of spi_flash.c: the SBA bus executes the transfers on a model
+ * of the W25Q16DV, and the OS layer runs on a simulated clock.
+ *
+ * A transfer takes (tx_len + rx_len) * 8 SPI clock cycles at SIM_SPI_KHZ,
+ * the bus speed of the Quark SE device tree, plus SIM_TRANSFER_US of setup
+ * and interrupt handling. A page program takes sim_program_us, by default
+ * SIM_PROGRAM_US, a sector erase SIM_ERASE_US (typical W25Q16DV figures). Timers expire after their
+ * delay in ms, as with the 1 ms system tick.
+ *
+ * A task blocked in semaphore_take() runs the pending events, in time
+ * order, until the semaphore is given or the timeout expires.
+ */
+
+#ifndef __SPI_FLASH_SIM_H__
+#define __SPI_FLASH_SIM_H__
+
+#include <stdint.h>
+#include "infra/device.h"
+
+#define SIM_SPI_KHZ       250
+#define SIM_TRANSFER_US   30
+#define SIM_PROGRAM_US    700
+#define SIM_ERASE_US      45000
+
+struct sim_stats {
+    unsigned int transfers;     /* SBA transfers */
+    unsigned int status_reads;  /* RDSR commands */
+    unsigned int busy_errors;   /* commands sent while a program or erase
+                                   is in progress */
+    unsigned int dirty;         /* bytes programmed without an erase */
+    uint64_t bus_us;            /* time the bus was busy */
+};
+
+extern struct sim_stats sim_stats;
+
+/** Duration of a page program */
+extern unsigned int sim_program_us;
+
+/** Programs of the page at this address fail, -1 for none */
+extern int32_t sim_fail_page;
+
+/**
+ * Return the simulated time in us.
+ */
+uint64_t sim_now(void);
+
+/**
+ * Run the pending events until *done is set.
+ */
+void sim_run(volatile int *done);
+
+/**
+ * Initialize the flash model (erased) and the spi flash device.
+ *
+ * @return the device, or NULL if the driver init failed
+ */
+struct device *sim_flash_init(void);
+
+/**
+ * Return the content of the flash model.
+ */
+uint8_t *sim_flash_data(void);
+
+#endif /* __SPI_FLASH_SIM_H__ */
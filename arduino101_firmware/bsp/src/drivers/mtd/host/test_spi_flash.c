@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks spi_flash.c against the W25Q16DV model of spi_flash_sim.c, built
+ * with and without CONFIG_SPI_FLASH_ASYNC:
+ *  - writes across pages and reads return the data, no command is sent
+ *    while a program or erase is in progress,
+ *  - a failed page program stops the write and is reported,
+ *  - asynchronous requests complete in submission order, the synchronous
+ *    API is refused meanwhile.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "spi_flash_sim.h"
+#include "drivers/spi_flash.h"
+
+#ifdef CONFIG_SPI_FLASH_ASYNC
+#define TEST_NAME "test_spi_flash"
+#else
+#define TEST_NAME "test_spi_flash_sync"
+#endif
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static uint8_t pattern[4096];
+static uint8_t buffer[4096];
+
+static void check_write_read(struct device *dev)
+{
+    unsigned int retlen;
+    unsigned int i;
+
+    CHECK(spi_flash_write_byte(dev, 100, 3000, &retlen, pattern) == DRV_RC_OK);
+    CHECK(retlen == 3000);
+    CHECK(memcmp(sim_flash_data() + 100, pattern, 3000) == 0);
+    CHECK(sim_flash_data()[99] == 0xff && sim_flash_data()[3100] == 0xff);
+
+    memset(buffer, 0, sizeof(buffer));
+    CHECK(spi_flash_read_byte(dev, 100, 3000, &retlen, buffer) == DRV_RC_OK);
+    CHECK(retlen == 3000);
+    CHECK(memcmp(buffer, pattern, 3000) == 0);
+
+    CHECK(spi_flash_sector_erase(dev, 0, 1) == DRV_RC_OK);
+    for (i = 0; i < 4096 && sim_flash_data()[i] == 0xff; i++)
+        ;
+    CHECK(i == 4096);
+
+    CHECK(sim_stats.busy_errors == 0);
+    CHECK(sim_stats.dirty == 0);
+}
+
+static void check_program_fail(struct device *dev)
+{
+    unsigned int retlen;
+
+    sim_fail_page = 4096 + 512;
+    CHECK(spi_flash_write_byte(dev, 4096, 1024, &retlen, pattern) == DRV_RC_CHECK_FAIL);
+    sim_fail_page = -1;
+    CHECK(retlen == 512);
+    CHECK(memcmp(sim_flash_data() + 4096, pattern, 512) == 0);
+    CHECK(sim_flash_data()[4096 + 512] == 0xff);
+}
+
+#ifdef CONFIG_SPI_FLASH_ASYNC
+#define REQUESTS 4
+
+static int completed[REQUESTS];
+static int completions;
+static volatile int all_done;
+
+static void request_done(struct spi_flash_request *req)
+{
+    completed[completions++] = (int)(intptr_t)req->priv_data;
+    all_done = (completions == REQUESTS);
+}
+
+static void check_async(struct device *dev)
+{
+    struct spi_flash_request req[REQUESTS];
+    unsigned int retlen;
+    int i;
+
+    memset(req, 0, sizeof(req));
+    memset(buffer, 0, sizeof(buffer));
+    for (i = 0; i < REQUESTS; i++) {
+        req[i].type = SPI_FLASH_REQ_WRITE;
+        req[i].address = 8192 + i * 1000;
+        req[i].len = 1000;
+        req[i].data = pattern + i * 1000;
+        req[i].priv_data = (void *)(intptr_t)i;
+        req[i].callback = request_done;
+    }
+    // The read of the first write is queued behind it
+    req[1].type = SPI_FLASH_REQ_READ;
+    req[1].address = 8192;
+    req[1].data = buffer;
+
+    completions = 0;
+    all_done = 0;
+    // Slowest page program of the W25Q16DV, the end is polled several times
+    sim_program_us = 3000;
+    for (i = 0; i < REQUESTS; i++) {
+        CHECK(spi_flash_submit(dev, &req[i]) == DRV_RC_OK);
+    }
+    CHECK(spi_flash_read_byte(dev, 0, 4, &retlen, buffer + 2000) == DRV_RC_CONTROLLER_IN_USE);
+
+    sim_run(&all_done);
+    sim_program_us = SIM_PROGRAM_US;
+    CHECK(completions == REQUESTS);
+    for (i = 0; i < REQUESTS; i++) {
+        CHECK(completed[i] == i);
+        CHECK(req[i].status == DRV_RC_OK);
+        CHECK(req[i].retlen == 1000);
+    }
+    CHECK(memcmp(buffer, pattern, 1000) == 0);
+    CHECK(memcmp(sim_flash_data() + 8192, pattern, 1000) == 0);
+    CHECK(memcmp(sim_flash_data() + 8192 + 2000, pattern + 2000, 2000) == 0);
+    CHECK(sim_flash_data()[8192 + 1000] == 0xff);
+
+    // The device is free again
+    CHECK(spi_flash_read_byte(dev, 8192, 4, &retlen, buffer) == DRV_RC_OK);
+    CHECK(sim_stats.busy_errors == 0);
+    CHECK(sim_stats.dirty == 0);
+}
+#endif
+
+int main(void)
+{
+    struct device *dev;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(pattern); i++)
+        pattern[i] = i * 7 + (i >> 8);
+
+    dev = sim_flash_init();
+    CHECK(dev != NULL);
+    if (dev != NULL) {
+        check_write_read(dev);
+        check_program_fail(dev);
+#ifdef CONFIG_SPI_FLASH_ASYNC
+        check_async(dev);
+#endif
+    }
+
+    printf("%s %s\n", failures ? "FAIL" : "PASS", TEST_NAME);
+    return failures ? 1 : 0;
+}
@@ -51,7 +51,27 @@
 #define SPI_FLASH_WAKELOCK_TIMEOUT 1000
 
 #define SBA_TIMEOUT    1000
-#define DEVICE_MUTEX_DELAY OS_NO_WAIT
+
+#ifdef CONFIG_SPI_FLASH_FAST_READ
+#define SPI_FLASH_READ_CMD      FLASH_CMD_FASTREAD
+#define SPI_FLASH_READ_CMD_LEN  5 /* command, address and a dummy byte */
+#else
+#define SPI_FLASH_READ_CMD      FLASH_CMD_READ
+#define SPI_FLASH_READ_CMD_LEN  4
+#endif
+
+#ifdef CONFIG_SPI_FLASH_ASYNC
+/*! Steps of an asynchronous request */
+enum {
+        ASYNC_WAKEUP,   /*!< Release flash from deep power down */
+        ASYNC_READ,     /*!< Read data */
+        ASYNC_WREN,     /*!< Enable write */
+        ASYNC_WEL,      /*!< Check write enable latch */
+        ASYNC_PROGRAM,  /*!< Program a page */
+        ASYNC_WIP,      /*!< Poll for the end of the page program */
+        ASYNC_RDSCUR    /*!< Check program result */
+};
+#endif
 
 /*! Flash memory management structure */
 typedef struct spi_flash_info {
@@ -69,8 +89,19 @@ typedef struct spi_flash_info {
     T_SEMAPHORE        spi_timer_sem;                /*!< Semaphore to wait for spi_timer event */
     T_SEMAPHORE        spi_sync_sem;                 /*!< Semaphore to wait for and spi transfer to complete */
     uint8_t            tx_buffer[FLASH_PAGE_SIZE+4]; /*!< Buffer used to store tx data during write operation */
-    T_MUTEX            device_mtx;                   /*!< Device in use mutex */
+    uint8_t            busy;                         /*!< Device in use flag */
     struct pm_wakelock wakelock;                     /*!< wakelock */
+#ifdef CONFIG_SPI_FLASH_ASYNC
+    struct device     *dev;                          /*!< Device driven by this structure */
+    list_head_t        async_queue;                  /*!< Pending asynchronous requests */
+    struct spi_flash_request *async_req;             /*!< Asynchronous request being executed */
+    uint8_t            async_step;                   /*!< Step of the request being executed */
+    unsigned int       async_count;                  /*!< Bytes of the page being programmed */
+    uint8_t            async_cmd[SPI_FLASH_READ_CMD_LEN]; /*!< Command of the current step */
+    uint8_t            async_status;                 /*!< Register read by the current step */
+    unsigned int       async_steps;                  /*!< Transfers completed, to detect a stuck request */
+    struct spi_flash_request sync_req;               /*!< Request of the synchronous API */
+#endif
 } spi_flash_info_t, *spi_flash_info_pt;
 
 /*! Erase operations list */
@@ -104,6 +135,11 @@ DRIVER_API_RC spi_flash_get_rdid(struct device *dev, uint32_t *rdid);
 // Device driver callback functions
 static void spi_timer_sync_callback(void* priv);
 static void spi_completion_callback(struct sba_request *req);
+#ifdef CONFIG_SPI_FLASH_ASYNC
+static void spi_async_callback(struct sba_request *req);
+static void spi_async_poll(struct spi_flash_info *flash_dev);
+static void spi_async_complete(struct spi_flash_info *flash_dev, DRIVER_API_RC status);
+#endif
 
 static int spi_flash_init(struct device *device)
 {
@@ -130,13 +166,15 @@ static int spi_flash_init(struct device *device)
     flash_dev->block_count = flash_dev->mem_size/flash_dev->block_size;
     flash_dev->large_block_count = flash_dev->mem_size/flash_dev->large_block_size;
 
-    // Create mutex for device multiple access protection
-    if ((flash_dev->device_mtx = mutex_create(NULL)) == NULL) {
-        goto exit_dev_mutex;
-    }
+    flash_dev->busy = 0;
+#ifdef CONFIG_SPI_FLASH_ASYNC
+    flash_dev->dev = device;
+    list_init(&flash_dev->async_queue);
+    flash_dev->async_req = NULL;
+#endif
     // Create a taken semaphore for non blocking waits
     if ((flash_dev->spi_timer_sem = semaphore_create(0, NULL)) == NULL) {
-        goto exit_sem;
+        goto exit_dev;
     }
     // Create a taken semaphore for spi sync transfers
     if ((flash_dev->spi_sync_sem = semaphore_create(0, NULL)) == NULL) {
@@ -149,6 +187,8 @@ static int spi_flash_init(struct device *device)
     // Init sba_request struct
     flash_dev->req.request_type = SBA_TRANSFER;
     flash_dev->req.addr.cs = dev->addr.cs;
+    flash_dev->req.priority = SBA_PRIO_BULK;
+    flash_dev->req.chain = NULL;
 
     // Link driver priv data to device
     device->priv = flash_dev;
@@ -170,9 +210,7 @@ exit_timer:
     semaphore_delete(flash_dev->spi_sync_sem, NULL);
 exit_spi_sem:
     semaphore_delete(flash_dev->spi_timer_sem, NULL);
-exit_sem:
-    mutex_delete(flash_dev->device_mtx, NULL);
-exit_dev_mutex:
+exit_dev:
     bfree(flash_dev);
     return -!!ret; // -1 if error else 0
 }
@@ -197,8 +235,31 @@ struct driver spi_flash_driver = {.init = spi_flash_init,
 // * spi flash driver internal functions *
 // ***************************************
 
+static DRIVER_API_RC spi_flash_lock(struct spi_flash_info *flash_dev)
+{
+    uint32_t saved = interrupt_lock();
+    uint8_t busy = flash_dev->busy;
+
+    flash_dev->busy = 1;
+    interrupt_unlock(saved);
+    return busy ? DRV_RC_CONTROLLER_IN_USE : DRV_RC_OK;
+}
+
+static void spi_flash_unlock(struct spi_flash_info *flash_dev)
+{
+    flash_dev->busy = 0;
+}
+
 static void spi_timer_sync_callback(void* priv)
 {
+#ifdef CONFIG_SPI_FLASH_ASYNC
+    struct spi_flash_info *flash_dev = (struct spi_flash_info*)priv;
+
+    if (flash_dev->async_req != NULL && flash_dev->async_step == ASYNC_WIP) {
+        spi_async_poll(flash_dev);
+        return;
+    }
+#endif
     // Unlock spi timer mutex to notify that the wait is complete
     semaphore_give(((struct spi_flash_info*)priv)->spi_timer_sem, NULL);
 }
@@ -261,18 +322,14 @@ DRIVER_API_RC spi_flash_get_rdid(struct device *dev, uint32_t *rdid)
 {
     uint8_t command;
     DRIVER_API_RC ret;
-    OS_ERR_TYPE ret_os;
     struct spi_flash_info* flash_dev = (struct spi_flash_info*)dev->priv;
 
     if (!flash_dev->is_init) {
         return DRV_RC_INVALID_OPERATION;
     }
-    // Take spi device mutex
-    if ((ret_os = mutex_lock(flash_dev->device_mtx, DEVICE_MUTEX_DELAY)) != E_OS_OK) {
-        if (ret_os == E_OS_ERR_BUSY) {
-            return DRV_RC_CONTROLLER_IN_USE;
-        }
-        return DRV_RC_FAIL;
+    // Take spi device
+    if ((ret = spi_flash_lock(flash_dev)) != DRV_RC_OK) {
+        return ret;
     }
     pm_wakelock_acquire(&flash_dev->wakelock, SPI_FLASH_WAKELOCK_TIMEOUT);
     // wake up the flash
@@ -292,9 +349,9 @@ DRIVER_API_RC spi_flash_get_rdid(struct device *dev, uint32_t *rdid)
     // put the flash to sleep
     spi_flash_sleep(dev, false);
 exit_mutex:
-    // Give device mutex
+    // Give device
     pm_wakelock_release(&flash_dev->wakelock);
-    mutex_unlock(flash_dev->device_mtx, NULL);
+    spi_flash_unlock(flash_dev);
     return ret;
 }
 
@@ -359,12 +416,290 @@ static DRIVER_API_RC spi_flash_write_enable(struct device *dev)
     return (status & FLASH_WEL_BIT) ? DRV_RC_OK : DRV_RC_FAIL;
 }
 
+#ifdef CONFIG_SPI_FLASH_ASYNC
+// *************************************
+// * spi flash asynchronous operations *
+// *************************************
+
+static void spi_async_send(struct spi_flash_info *flash_dev, uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len)
+{
+    DRIVER_API_RC ret;
+
+    flash_dev->req.tx_len    = tx_len;
+    flash_dev->req.tx_buff   = tx;
+    flash_dev->req.rx_len    = rx_len;
+    flash_dev->req.rx_buff   = rx;
+    flash_dev->req.priv_data = flash_dev;
+    flash_dev->req.callback  = spi_async_callback;
+
+    if ((ret = sba_exec_dev_request((struct sba_device*)flash_dev->dev, &flash_dev->req)) != DRV_RC_OK) {
+        spi_async_complete(flash_dev, ret);
+    }
+}
+
+static void spi_async_start(struct spi_flash_info *flash_dev)
+{
+    pm_wakelock_acquire(&flash_dev->wakelock, SPI_FLASH_WAKELOCK_TIMEOUT);
+    // wake up the flash
+    flash_dev->async_step = ASYNC_WAKEUP;
+    flash_dev->async_cmd[0] = FLASH_CMD_RDP;
+    spi_async_send(flash_dev, flash_dev->async_cmd, 1, NULL, 0);
+}
+
+static void spi_async_complete(struct spi_flash_info *flash_dev, DRIVER_API_RC status)
+{
+    struct spi_flash_request *req = flash_dev->async_req;
+    struct spi_flash_request *next;
+    uint32_t saved;
+
+    req->status = status;
+    if (status != DRV_RC_OK) {
+        req->retlen -= req->len;
+    }
+
+    pm_wakelock_release(&flash_dev->wakelock);
+
+    // Chain the next request, or give the device back
+    saved = interrupt_lock();
+    next = (struct spi_flash_request *)list_get(&flash_dev->async_queue);
+    flash_dev->async_req = next;
+    if (next == NULL) {
+        spi_flash_unlock(flash_dev);
+    }
+    interrupt_unlock(saved);
+
+    req->callback(req);
+    if (next != NULL) {
+        spi_async_start(flash_dev);
+    }
+}
+
+// Program the next page of a write request
+static void spi_async_program(struct spi_flash_info *flash_dev)
+{
+    struct spi_flash_request *req = flash_dev->async_req;
+
+    flash_dev->async_count = FLASH_PAGE_SIZE - (req->address & (FLASH_PAGE_SIZE-1));
+    if (flash_dev->async_count > req->len) {
+        flash_dev->async_count = req->len;
+    }
+    flash_dev->tx_buffer[0] = FLASH_CMD_PP;
+    flash_dev->tx_buffer[1] = (uint8_t)(req->address >> 16);
+    flash_dev->tx_buffer[2] = (uint8_t)(req->address >> 8);
+    flash_dev->tx_buffer[3] = (uint8_t)req->address;
+    memcpy((uint8_t*)(flash_dev->tx_buffer)+4, req->data, flash_dev->async_count);
+    flash_dev->async_step = ASYNC_PROGRAM;
+    spi_async_send(flash_dev, flash_dev->tx_buffer, flash_dev->async_count+4, NULL, 0);
+}
+
+// Read the status register, the page program is in progress
+static void spi_async_poll(struct spi_flash_info *flash_dev)
+{
+    flash_dev->async_cmd[0] = FLASH_CMD_RDSR;
+    spi_async_send(flash_dev, flash_dev->async_cmd, 1, &flash_dev->async_status, 1);
+}
+
+static void spi_async_callback(struct sba_request *sba_req)
+{
+    struct spi_flash_info *flash_dev = (struct spi_flash_info*)sba_req->priv_data;
+    struct spi_flash_request *req = flash_dev->async_req;
+    OS_ERR_TYPE ret_os;
+
+    flash_dev->async_steps++;
+    if (sba_req->status != 0) {
+        spi_async_complete(flash_dev, DRV_RC_FAIL);
+        return;
+    }
+
+    switch (flash_dev->async_step) {
+    case ASYNC_WAKEUP:
+        if (req->type == SPI_FLASH_REQ_READ) {
+            flash_dev->async_step = ASYNC_READ;
+            flash_dev->async_cmd[0] = SPI_FLASH_READ_CMD;
+            flash_dev->async_cmd[1] = (uint8_t)(req->address >> 16);
+            flash_dev->async_cmd[2] = (uint8_t)(req->address >> 8);
+            flash_dev->async_cmd[3] = (uint8_t)req->address;
+#ifdef CONFIG_SPI_FLASH_FAST_READ
+            flash_dev->async_cmd[4] = 0; // dummy byte
+#endif
+            spi_async_send(flash_dev, flash_dev->async_cmd, SPI_FLASH_READ_CMD_LEN, req->data, req->len);
+            break;
+        }
+        // fall through
+    case ASYNC_RDSCUR:
+        if (flash_dev->async_step == ASYNC_RDSCUR) {
+            if (flash_dev->async_status & FLASH_SECR_PFAIL_BIT) {
+                spi_async_complete(flash_dev, DRV_RC_CHECK_FAIL);
+                break;
+            }
+            req->address += flash_dev->async_count;
+            req->data += flash_dev->async_count;
+            req->len -= flash_dev->async_count;
+            if (req->len == 0) {
+                spi_async_complete(flash_dev, DRV_RC_OK);
+                break;
+            }
+        }
+        // Enable write operation for the next page
+        flash_dev->async_step = ASYNC_WREN;
+        flash_dev->async_cmd[0] = FLASH_CMD_WREN;
+        spi_async_send(flash_dev, flash_dev->async_cmd, 1, NULL, 0);
+        break;
+    case ASYNC_READ:
+        req->len = 0;
+        spi_async_complete(flash_dev, DRV_RC_OK);
+        break;
+    case ASYNC_WREN:
+        flash_dev->async_step = ASYNC_WEL;
+        flash_dev->async_cmd[0] = FLASH_CMD_RDSR;
+        spi_async_send(flash_dev, flash_dev->async_cmd, 1, &flash_dev->async_status, 1);
+        break;
+    case ASYNC_WEL:
+        if (!(flash_dev->async_status & FLASH_WEL_BIT)) {
+            spi_async_complete(flash_dev, DRV_RC_FAIL);
+            break;
+        }
+        spi_async_program(flash_dev);
+        break;
+    case ASYNC_PROGRAM:
+        // Let the program operation progress before polling its status
+        flash_dev->async_step = ASYNC_WIP;
+        timer_start(flash_dev->spi_timer, FLASH_PAGE_PROGRAM_MS, &ret_os);
+        break;
+    case ASYNC_WIP:
+        if (flash_dev->async_status & FLASH_WIP_BIT) {
+            timer_start(flash_dev->spi_timer, FLASH_PAGE_PROGRAM_MS, &ret_os);
+            break;
+        }
+        // Check for success
+        flash_dev->async_step = ASYNC_RDSCUR;
+        flash_dev->async_cmd[0] = FLASH_CMD_RDSCUR;
+        spi_async_send(flash_dev, flash_dev->async_cmd, 1, &flash_dev->async_status, 1);
+        break;
+    }
+}
+
+static DRIVER_API_RC spi_async_check(struct spi_flash_info *flash_dev, struct spi_flash_request *req)
+{
+    // Check input parameters
+    if ((!flash_dev->is_init) || (req->len == 0) || (req->callback == NULL)) {
+        return DRV_RC_INVALID_OPERATION;
+    }
+    if((req->len+req->address) > flash_dev->mem_size) {
+        return DRV_RC_OUT_OF_MEM;
+    }
+    req->status = DRV_RC_OK;
+    req->retlen = req->len;
+    return DRV_RC_OK;
+}
+
+DRIVER_API_RC spi_flash_submit(struct device *dev, struct spi_flash_request *req)
+{
+    struct spi_flash_info* flash_dev = (struct spi_flash_info*)dev->priv;
+    DRIVER_API_RC ret;
+    uint32_t saved;
+
+    if ((ret = spi_async_check(flash_dev, req)) != DRV_RC_OK) {
+        return ret;
+    }
+
+    saved = interrupt_lock();
+    if (flash_dev->async_req != NULL) {
+        // Queue behind the request being executed
+        list_add(&flash_dev->async_queue, &req->list);
+        interrupt_unlock(saved);
+        return DRV_RC_OK;
+    }
+    if (flash_dev->busy) {
+        interrupt_unlock(saved);
+        return DRV_RC_CONTROLLER_IN_USE;
+    }
+    flash_dev->busy = 1;
+    flash_dev->async_req = req;
+    interrupt_unlock(saved);
+
+    spi_async_start(flash_dev);
+    return DRV_RC_OK;
+}
+
+static void spi_flash_sync_callback(struct spi_flash_request *req)
+{
+    // The caller does not wait anymore if the request timed out
+    if (req->priv_data != NULL) {
+        semaphore_give((T_SEMAPHORE)req->priv_data, NULL);
+    }
+}
+
+// Execute a request and wait for its completion
+static DRIVER_API_RC spi_flash_sync_request(struct device *dev, SPI_FLASH_REQUEST_TYPE type, uint32_t address, unsigned int len, unsigned int *retlen, uint8_t *data)
+{
+    struct spi_flash_info* flash_dev = (struct spi_flash_info*)dev->priv;
+    struct spi_flash_request *req = &flash_dev->sync_req;
+    DRIVER_API_RC ret;
+    OS_ERR_TYPE ret_os;
+    unsigned int steps;
+    uint32_t saved;
+
+    *retlen = 0;
+
+    // Own the device so that the semaphore has a single waiter and the
+    // request is free, requests submitted meanwhile are chained after it
+    if ((ret = spi_flash_lock(flash_dev)) != DRV_RC_OK) {
+        return ret;
+    }
+    req->type = type;
+    req->address = address;
+    req->len = len;
+    req->data = data;
+    req->priv_data = flash_dev->spi_sync_sem;
+    req->callback = spi_flash_sync_callback;
+    if ((ret = spi_async_check(flash_dev, req)) != DRV_RC_OK) {
+        spi_flash_unlock(flash_dev);
+        return ret;
+    }
+
+    flash_dev->async_req = req;
+    spi_async_start(flash_dev);
+
+    // Wait for the request, each of its transfers must complete within
+    // SBA_TIMEOUT (the request is always completed, by the sba callback or
+    // on error, unless the transfer is stuck)
+    do {
+        steps = flash_dev->async_steps;
+        ret_os = semaphore_take(flash_dev->spi_sync_sem, SBA_TIMEOUT);
+    } while (ret_os == E_OS_ERR_BUSY && flash_dev->async_steps != steps);
+
+    if (ret_os != E_OS_OK) {
+        saved = interrupt_lock();
+        if (flash_dev->async_req == req) {
+            // Give up, the device stays in use until the transfer ends
+            req->priv_data = NULL;
+            interrupt_unlock(saved);
+            return (ret_os == E_OS_ERR_BUSY) ? DRV_RC_TIMEOUT : DRV_RC_FAIL;
+        }
+        interrupt_unlock(saved);
+        // Completed meanwhile, the callback gives the semaphore
+        semaphore_take(flash_dev->spi_sync_sem, OS_WAIT_FOREVER);
+    }
+    *retlen = req->retlen;
+    return req->status;
+}
+
+DRIVER_API_RC spi_flash_read_byte(struct device *dev, uint32_t address, unsigned int len, unsigned int *retlen, uint8_t *data)
+{
+    return spi_flash_sync_request(dev, SPI_FLASH_REQ_READ, address, len, retlen, data);
+}
+
+DRIVER_API_RC spi_flash_write_byte(struct device *dev, uint32_t address, unsigned int len, unsigned int *retlen, uint8_t *data)
+{
+    return spi_flash_sync_request(dev, SPI_FLASH_REQ_WRITE, address, len, retlen, data);
+}
+#else
 DRIVER_API_RC spi_flash_read_byte(struct device *dev, uint32_t address, unsigned int len, unsigned int *retlen, uint8_t *data)
 {
     DRIVER_API_RC ret = DRV_RC_OK;
-    OS_ERR_TYPE ret_os;
     struct spi_flash_info* flash_dev = (struct spi_flash_info*)dev->priv;
-    uint8_t command[4];
+    uint8_t command[SPI_FLASH_READ_CMD_LEN];
 
     *retlen = 0;
 
@@ -376,12 +711,9 @@ DRIVER_API_RC spi_flash_read_byte(struct device *dev, uint32_t address, unsigned
         return DRV_RC_OUT_OF_MEM;
     }
 
-    // Take spi device mutex
-    if ((ret_os = mutex_lock(flash_dev->device_mtx, DEVICE_MUTEX_DELAY)) != E_OS_OK) {
-        if (ret_os == E_OS_ERR_BUSY) {
-            return DRV_RC_CONTROLLER_IN_USE;
-        }
-        return DRV_RC_FAIL;
+    // Take spi device
+    if ((ret = spi_flash_lock(flash_dev)) != DRV_RC_OK) {
+        return ret;
     }
     pm_wakelock_acquire(&flash_dev->wakelock, SPI_FLASH_WAKELOCK_TIMEOUT);
 
@@ -390,12 +722,15 @@ DRIVER_API_RC spi_flash_read_byte(struct device *dev, uint32_t address, unsigned
         goto exit_mutex;
     }
 
-    command[0] = FLASH_CMD_READ;
+    command[0] = SPI_FLASH_READ_CMD;
     command[1] = (uint8_t)(address >> 16);
     command[2] = (uint8_t)(address >> 8);
     command[3] = (uint8_t)address;
+#ifdef CONFIG_SPI_FLASH_FAST_READ
+    command[4] = 0; // dummy byte
+#endif
 
-    flash_dev->req.tx_len  = 4;
+    flash_dev->req.tx_len  = SPI_FLASH_READ_CMD_LEN;
     flash_dev->req.tx_buff = command;
     flash_dev->req.rx_len  = len;
     flash_dev->req.rx_buff = data;
@@ -409,23 +744,15 @@ DRIVER_API_RC spi_flash_read_byte(struct device *dev, uint32_t address, unsigned
     // put the flash to sleep
     spi_flash_sleep(dev, false);
 exit_mutex:
-    // Give device mutex
+    // Give device
     pm_wakelock_release(&flash_dev->wakelock);
-    mutex_unlock(flash_dev->device_mtx, NULL);
-    return ret;
-}
-
-DRIVER_API_RC spi_flash_read(struct device *dev, uint32_t address, unsigned int len, unsigned int *retlen, uint32_t *data)
-{
-    DRIVER_API_RC ret = spi_flash_read_byte(dev, address, len<<2, retlen, (uint8_t*)data);
-    *retlen = (*retlen >> 2);
+    spi_flash_unlock(flash_dev);
     return ret;
 }
 
 DRIVER_API_RC spi_flash_write_byte(struct device *dev, uint32_t address, unsigned int len, unsigned int *retlen, uint8_t *data)
 {
     DRIVER_API_RC ret = DRV_RC_OK;
-    OS_ERR_TYPE ret_os;
     struct spi_flash_info* flash_dev = (struct spi_flash_info*)dev->priv;
     uint8_t status;
 
@@ -439,12 +766,9 @@ DRIVER_API_RC spi_flash_write_byte(struct device *dev, uint32_t address, unsigne
         return DRV_RC_OUT_OF_MEM;
     }
 
-    // Take spi device mutex
-    if ((ret_os = mutex_lock(flash_dev->device_mtx, DEVICE_MUTEX_DELAY)) != E_OS_OK) {
-        if (ret_os == E_OS_ERR_BUSY) {
-            return DRV_RC_CONTROLLER_IN_USE;
-        }
-        return DRV_RC_FAIL;
+    // Take spi device
+    if ((ret = spi_flash_lock(flash_dev)) != DRV_RC_OK) {
+        return ret;
     }
     pm_wakelock_acquire(&flash_dev->wakelock, SPI_FLASH_WAKELOCK_TIMEOUT);
 
@@ -514,9 +838,17 @@ DRIVER_API_RC spi_flash_write_byte(struct device *dev, uint32_t address, unsigne
 exit_wakeup:
     spi_flash_sleep(dev, false);
 exit_mutex:
-    // Give device mutex
+    // Give device
     pm_wakelock_release(&flash_dev->wakelock);
-    mutex_unlock(flash_dev->device_mtx, NULL);
+    spi_flash_unlock(flash_dev);
+    return ret;
+}
+#endif
+
+DRIVER_API_RC spi_flash_read(struct device *dev, uint32_t address, unsigned int len, unsigned int *retlen, uint32_t *data)
+{
+    DRIVER_API_RC ret = spi_flash_read_byte(dev, address, len<<2, retlen, (uint8_t*)data);
+    *retlen = (*retlen >> 2);
     return ret;
 }
 
@@ -575,12 +907,9 @@ static DRIVER_API_RC spi_flash_erase(struct device *dev, ER_TYPE er_type, unsign
         return DRV_RC_OUT_OF_MEM;
     }
 
-    // Take spi device mutex
-    if ((ret_os = mutex_lock(flash_dev->device_mtx, DEVICE_MUTEX_DELAY)) != E_OS_OK) {
-        if (ret_os == E_OS_ERR_BUSY) {
-            return DRV_RC_CONTROLLER_IN_USE;
-        }
-        return DRV_RC_FAIL;
+    // Take spi device
+    if ((ret = spi_flash_lock(flash_dev)) != DRV_RC_OK) {
+        return ret;
     }
     pm_wakelock_acquire(&flash_dev->wakelock, SPI_FLASH_WAKELOCK_TIMEOUT);
 
@@ -647,9 +976,9 @@ static DRIVER_API_RC spi_flash_erase(struct device *dev, ER_TYPE er_type, unsign
 exit_wakeup:
     spi_flash_sleep(dev, false);
 exit_mutex:
-    // Give device mutex
+    // Give device
     pm_wakelock_release(&flash_dev->wakelock);
-    mutex_unlock(flash_dev->device_mtx, NULL);
+    spi_flash_unlock(flash_dev);
     return ret;
 }
 
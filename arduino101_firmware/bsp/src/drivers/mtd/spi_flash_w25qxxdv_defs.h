@@ -74,6 +74,7 @@
 #define FLASH_BLOCK_SIZE      (0x10000)   // block size in units of bytes (65536)
 
 // nominal operation timings (see p.67 w25q16dv of datasheet)
+#define FLASH_PAGE_PROGRAM_MS       (1) // 256B
 #define FLASH_SECTOR_ERASE_MS       (60) //4KB
 #define FLASH_BLOCK_ERASE_MS        (150) // 32KB
 #define FLASH_LARGE_BLOCK_ERASE_MS  (180) // 64KB?
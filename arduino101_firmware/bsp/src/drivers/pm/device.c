@@ -32,10 +32,32 @@
 #include <stddef.h>
 #include <errno.h>
 
+#include "os/os.h"
 #include "infra/device.h"
 #include "infra/log.h"
+#include "infra/time.h"
 #include "machine.h"
 
+/** Maximum duration of the asynchronous operations of a suspend/resume step (32 kHz ticks) */
+#define DEVICE_PM_TIMEOUT	(32768 / 10)
+
+/**
+ * \brief Device of the suspend/resume schedule
+ */
+struct device_pm_node {
+	void *dev;                      /*!< struct device, or struct bus if is_bus */
+	uint8_t is_bus;                 /*!< dev is a bus device */
+	uint8_t depth;                  /*!< depth in the device tree, 0 for the root */
+	uint8_t started;                /*!< operation started by the current step */
+	volatile uint8_t pending;       /*!< asynchronous operation in progress */
+	volatile int ret;               /*!< result of the operation */
+#ifdef CONFIG_DEVICE_PM_STATS
+	uint32_t start_time;            /*!< start of the operation */
+	volatile uint32_t end_time;     /*!< completion of the operation */
+	struct device_pm_stats stats;   /*!< suspend/resume times */
+#endif
+};
+
 /**
  * \brief Root device driver
  */
@@ -56,6 +78,25 @@ static struct bus root_device = {
 	.driver		= &root_driver
 };
 
+/**
+ * \brief Initialized devices, sorted by depth in the order of the tree walk
+ */
+static struct device_pm_node device_nodes[DEVICE_ID_COUNT];
+static uint8_t device_node_count;
+static uint8_t device_max_depth;
+
+/**
+ * \brief Initialized device of each id
+ */
+static struct device *device_table[DEVICE_ID_COUNT];
+
+/**
+ * \brief Number of asynchronous operations in progress
+ */
+static volatile uint8_t device_pm_pending;
+
+static uint8_t node_id(struct device_pm_node *node);
+
 static void print_device(struct bus *device, int level)
 {
 	unsigned int i;
@@ -78,38 +119,100 @@ static void print_device(struct bus *device, int level)
 void list_devices(void)
 {
 	print_device(&root_device, 0);
+#ifdef CONFIG_DEVICE_PM_STATS
+	unsigned int i;
+	struct device_pm_stats *stats;
+
+	for (i = 0; i < device_node_count; i++) {
+		stats = &device_nodes[i].stats;
+		pr_info(LOG_MODULE_DRV, "dev %d suspend %d/%d resume %d/%d",
+			node_id(&device_nodes[i]),
+			stats->suspend_time, stats->suspend_max,
+			stats->resume_time, stats->resume_max);
+	}
+#endif
 }
 
-static struct device *find_device(struct bus *device, uint8_t id)
+static uint8_t node_id(struct device_pm_node *node)
 {
-	unsigned int i;
-	struct device *ret = NULL;
+	return node->is_bus ? ((struct bus *)node->dev)->id :
+	       ((struct device *)node->dev)->id;
+}
 
-	// Check if device is valid
-	if ((device == NULL) || (device->powerstate == PM_NOT_INIT))
-		return NULL;
+static struct bus *node_parent(struct device_pm_node *node)
+{
+	return node->is_bus ? ((struct bus *)node->dev)->parent :
+	       ((struct device *)node->dev)->parent;
+}
+
+static PM_POWERSTATE node_powerstate(struct device_pm_node *node)
+{
+	return node->is_bus ? ((struct bus *)node->dev)->powerstate :
+	       ((struct device *)node->dev)->powerstate;
+}
+
+static void node_set_powerstate(struct device_pm_node *node,
+				PM_POWERSTATE state)
+{
+	if (node->is_bus)
+		((struct bus *)node->dev)->powerstate = state;
+	else
+		((struct device *)node->dev)->powerstate = state;
+}
 
-	if (device->id == id)
-		return (struct device *)device;
+/**
+ * Adds an initialized device to the schedule and to the id table.
+ *
+ * The nodes stay sorted by depth, a device keeps its tree walk order among
+ * the devices of the same depth.
+ */
+static int register_device(void *dev, uint8_t is_bus)
+{
+	struct device_pm_node *node;
+	struct bus *parent;
+	uint8_t depth = 0;
+	unsigned int i;
+	uint8_t id;
 
-	// Check devices
-	for (i = 0; i < device->dev_child_count; i++) {
-		if ((device->dev_child[i]->powerstate != PM_NOT_INIT) &&
-		    (device->dev_child[i]->id == id))
-			return device->dev_child[i];
+	if (device_node_count >= DEVICE_ID_COUNT) {
+		pr_error(LOG_MODULE_DRV, "too many devices");
+		return -ENOMEM;
 	}
-	// Check buses
-	for (i = 0;
-	     (i < device->bus_child_count) &&
-	     (!(ret = find_device(&device->bus_child[i], id)));
-	     i++) ;
 
-	return ret;
+	parent = is_bus ? ((struct bus *)dev)->parent :
+		 ((struct device *)dev)->parent;
+	for (; parent; parent = parent->parent)
+		depth++;
+
+	// Insert the device after the last one of its depth
+	for (i = device_node_count; (i > 0) && (device_nodes[i - 1].depth > depth); i--)
+		device_nodes[i] = device_nodes[i - 1];
+	node = &device_nodes[i];
+	node->dev = dev;
+	node->is_bus = is_bus;
+	node->depth = depth;
+	node->started = 0;
+	node->pending = 0;
+	node->ret = 0;
+#ifdef CONFIG_DEVICE_PM_STATS
+	node->stats = (struct device_pm_stats){0};
+#endif
+	device_node_count++;
+	if (depth > device_max_depth)
+		device_max_depth = depth;
+
+	// The first device of an id wins, as in the tree walk
+	id = is_bus ? ((struct bus *)dev)->id : ((struct device *)dev)->id;
+	if ((id < DEVICE_ID_COUNT) && (device_table[id] == NULL))
+		device_table[id] = (struct device *)dev;
+	return 0;
 }
 
 struct device *get_device(uint8_t id)
 {
-	return find_device(&root_device, id);
+	if (id >= DEVICE_ID_COUNT)
+		return NULL;
+	return device_table[id];
 }
 
 static int init_device(struct device *device)
@@ -122,49 +225,7 @@ static int init_device(struct device *device)
 		return ret;
 	}
 	device->powerstate = PM_RUNNING;
-	return 0;
-}
-
-static int resume_device(struct device *device)
-{
-	int ret = 0;
-
-	if (device->powerstate <= PM_SHUTDOWN) {
-		pr_error(LOG_MODULE_DRV, "device %d cannot resume (%d)",
-			 device->id,
-			 device->powerstate);
-		return -EINVAL;
-	}
-
-	if (device->powerstate == PM_RUNNING)
-		// Device already running
-		return 0;
-
-	pr_debug(LOG_MODULE_DRV, "resume dev %d", device->id);
-	if (!(device->driver->resume) || (!(ret = device->driver->resume(device))))
-		device->powerstate = PM_RUNNING;
-	return ret;
-}
-
-static int suspend_device(struct device *device, PM_POWERSTATE state)
-{
-	int ret;
-
-	if (device->powerstate <= state)
-		// device already suspended
-		return 0;
-
-	pr_debug(LOG_MODULE_DRV, "suspend dev %d", device->id);
-
-	if (!(device->driver->suspend) ||
-	    (!(ret = device->driver->suspend(device, state)))) {
-		device->powerstate = state;
-		return 0;
-	}
-	pr_error(LOG_MODULE_DRV, "suspend (%d) failed for dev %d (%d)", state,
-		 device->id,
-		 ret);
-	return ret;
+	return register_device(device, 0);
 }
 
 static int init_bus_device(struct bus *device)
@@ -179,6 +240,8 @@ static int init_bus_device(struct bus *device)
 		return ret;
 	}
 	device->powerstate = PM_RUNNING;
+	if ((ret = register_device(device, 1)))
+		return ret;
 
 	// Init devices first
 	for (i = 0; (i < device->dev_child_count) && (!ret); i++) {
@@ -209,123 +272,223 @@ static int init_bus_device(struct bus *device)
 	return 0;
 }
 
-static int resume_bus_device(struct bus *device)
+/**
+ * Records the result of the operation of a device.
+ *
+ * Called with the synchronous result of a callback, or from the driver
+ * completion handler for an asynchronous operation.
+ */
+static void node_complete(struct device_pm_node *node, int ret)
+{
+	uint32_t saved = interrupt_lock();
+
+	if (node->pending) {
+		node->ret = ret;
+#ifdef CONFIG_DEVICE_PM_STATS
+		node->end_time = get_uptime_32k();
+#endif
+		node->pending = 0;
+		device_pm_pending--;
+	}
+	interrupt_unlock(saved);
+}
+
+static void complete_device(void *dev, int ret)
 {
 	unsigned int i;
-	int ret = 0;
-	int fail = 0;
 
-	pr_debug(LOG_MODULE_DRV, "resume bus %d", device->id);
-	if (device->powerstate <= PM_SHUTDOWN) {
-		pr_error(LOG_MODULE_DRV, "device %d not ready for resume (%d)",
-			 device->id,
-			 device->powerstate);
-		return -EINVAL;
+	for (i = 0; i < device_node_count; i++) {
+		if (device_nodes[i].dev == dev) {
+			node_complete(&device_nodes[i], ret);
+			return;
+		}
 	}
+}
 
-	if (device->powerstate == PM_RUNNING)
-		// Device already running
-		return 0;
+void device_pm_complete(struct device *dev, int ret)
+{
+	complete_device(dev, ret);
+}
 
-	if ((device->driver->resume) && (ret = device->driver->resume(device)))
-		return ret;
-	// Current device resumed
-	device->powerstate = PM_RUNNING;
+void bus_pm_complete(struct bus *dev, int ret)
+{
+	complete_device(dev, ret);
+}
 
-	// Resume all child devices
-	for (i = 0; (i < device->dev_child_count) && (!ret); i++) {
-		ret = resume_device(device->dev_child[i]);
-		if (ret) {
-			fail = ret;
-			pr_error(LOG_MODULE_DRV,
-				 "failed to resume device %d (%d)",
-				 device->dev_child[i]->id,
-				 ret);
+/**
+ * Starts the suspend or resume of a device.
+ *
+ * @return 0 if the device does not need the operation or completed it,
+ *         -EINPROGRESS if the operation completes asynchronously,
+ *         a negative error code otherwise.
+ */
+static int node_start(struct device_pm_node *node, PM_POWERSTATE state)
+{
+	struct bus *parent = node_parent(node);
+	int ret = 0;
+	uint32_t saved;
+
+	if (state == PM_RUNNING) {
+		if (node_powerstate(node) == PM_RUNNING)
+			// Device already running
+			return 0;
+		if (node_powerstate(node) <= PM_SHUTDOWN) {
+			pr_error(LOG_MODULE_DRV, "device %d cannot resume (%d)",
+				 node_id(node),
+				 node_powerstate(node));
+			return -EINVAL;
 		}
+		if (parent && (parent->powerstate != PM_RUNNING))
+			// Parent bus failed to resume, already reported
+			return 0;
+		pr_debug(LOG_MODULE_DRV, "resume dev %d", node_id(node));
+	} else {
+		if (node_powerstate(node) <= state)
+			// Device already suspended
+			return 0;
+		pr_debug(LOG_MODULE_DRV, "suspend dev %d", node_id(node));
 	}
-	// Resume all child buses
-	for (i = 0; (i < device->bus_child_count) && (!ret); i++) {
-		ret = resume_bus_device(&device->bus_child[i]);
-		if (ret) {
-			fail = ret;
-			pr_error(LOG_MODULE_DRV,
-				 "failed to resume bus device %d (%d)",
-				 device->bus_child[i].id,
-				 ret);
-		}
+
+	node->started = 1;
+	node->ret = -EINPROGRESS;
+	saved = interrupt_lock();
+	node->pending = 1;
+	device_pm_pending++;
+	interrupt_unlock(saved);
+#ifdef CONFIG_DEVICE_PM_STATS
+	node->start_time = get_uptime_32k();
+#endif
+
+	if (node->is_bus) {
+		struct bus *bus = (struct bus *)node->dev;
+
+		if (state == PM_RUNNING)
+			ret = bus->driver->resume ? bus->driver->resume(bus) : 0;
+		else
+			ret = bus->driver->suspend ?
+			      bus->driver->suspend(bus, state) : 0;
+	} else {
+		struct device *dev = (struct device *)node->dev;
+
+		if (state == PM_RUNNING)
+			ret = dev->driver->resume ? dev->driver->resume(dev) : 0;
+		else
+			ret = dev->driver->suspend ?
+			      dev->driver->suspend(dev, state) : 0;
 	}
 
-	return fail;
+	if (ret != -EINPROGRESS)
+		node_complete(node, ret);
+	return ret;
 }
 
-static int suspend_bus_device(struct bus *device, PM_POWERSTATE state)
+#ifdef CONFIG_DEVICE_PM_STATS
+static void node_update_stats(struct device_pm_node *node, PM_POWERSTATE state)
 {
-	int i;
-	int dev_index, bus_index;
-	int ret = 0;
+	uint32_t time = node->end_time - node->start_time;
+
+	if (time > 0xffff)
+		time = 0xffff;
+	if (state == PM_RUNNING) {
+		node->stats.resume_time = time;
+		if (time > node->stats.resume_max)
+			node->stats.resume_max = time;
+	} else {
+		node->stats.suspend_time = time;
+		if (time > node->stats.suspend_max)
+			node->stats.suspend_max = time;
+	}
+}
 
-	// Validate input argument
-	if (state == PM_NOT_INIT)
-		return -EINVAL;
-	if (device->powerstate <= state)
-		// Device already suspended
-		return 0;
+int device_get_pm_stats(uint8_t id, struct device_pm_stats *stats)
+{
+	unsigned int i;
 
-	// Suspend bus devices first
-	for (i = device->bus_child_count - 1; i >= 0; i--) {
-		if ((ret = suspend_bus_device(&device->bus_child[i], state))) {
-			if (state > PM_SHUTDOWN) {
-				// Resume bus devices
-				bus_index = i;
-				goto exit_buses;
-			}
-			// Suspend operation aborted
-			return ret;
+	for (i = 0; i < device_node_count; i++) {
+		if (node_id(&device_nodes[i]) == id) {
+			*stats = device_nodes[i].stats;
+			return 0;
 		}
 	}
+	return -EINVAL;
+}
+#endif
 
-	// Then suspend devices
-	for (i = device->dev_child_count - 1; i >= 0; i--) {
-		if ((ret = suspend_device(device->dev_child[i], state))) {
-			if (state > PM_SHUTDOWN) {
-				// Resume other devices and buses
-				bus_index = -1;
-				dev_index = i;
-				goto exit_devices;
-			}
-			// Suspend operation aborted
-			return ret;
-		}
+/**
+ * Suspends or resumes the devices at a given depth of the device tree.
+ *
+ * The devices of a depth do not depend on each other: the callbacks of all
+ * of them are called before waiting for the asynchronous completions, so
+ * that their latencies overlap. A suspend stops at the first failure.
+ *
+ * @param depth depth of the devices in the tree
+ * @param state suspend state, PM_RUNNING to resume
+ *
+ * @return 0 if success, the error of the last failed device otherwise.
+ */
+static int device_pm_step(uint8_t depth, PM_POWERSTATE state)
+{
+	struct device_pm_node *node;
+	unsigned int first, last, i;
+	uint32_t saved, start;
+	int ret = 0;
+	int err;
+
+	for (first = 0; (first < device_node_count) &&
+	     (device_nodes[first].depth < depth); first++) ;
+	for (last = first; (last < device_node_count) &&
+	     (device_nodes[last].depth == depth); last++)
+		device_nodes[last].started = 0;
+
+	// Resume in tree walk order, suspend in reverse order
+	for (i = 0; i < last - first; i++) {
+		node = &device_nodes[(state == PM_RUNNING) ?
+				     first + i : last - 1 - i];
+		err = node_start(node, state);
+		if ((err == 0) || (err == -EINPROGRESS))
+			continue;
+		ret = err;
+		if (state != PM_RUNNING)
+			// Do not start the other suspends
+			break;
 	}
 
-	// Suspend current bus device
-	pr_debug(LOG_MODULE_DRV, "suspend bus %d", device->id);
-	if ((device->driver->suspend) &&
-	    (ret = device->driver->suspend(device, state))) {
-		pr_error(LOG_MODULE_DRV, "suspend (%d) failed for dev %d (%d)",
-			 state, device->id,
-			 ret);
-		if (state > PM_SHUTDOWN) {
-			// Resume other devices and buses
-			bus_index = device->bus_child_count;
-			dev_index = device->dev_child_count;
-			goto exit_devices;
+	// Wait for the asynchronous operations
+	start = get_uptime_32k();
+	while (device_pm_pending &&
+	       (get_uptime_32k() - start < DEVICE_PM_TIMEOUT)) ;
+
+	for (i = first; i < last; i++) {
+		node = &device_nodes[i];
+		if (!node->started)
+			continue;
+		saved = interrupt_lock();
+		if (node->pending) {
+			// Late completions are ignored
+			node->pending = 0;
+			device_pm_pending--;
+			node->ret = -ETIMEDOUT;
 		}
-		// Suspend operation aborted
-		return ret;
+		interrupt_unlock(saved);
+		if (node->ret) {
+			if (state == PM_RUNNING)
+				pr_error(LOG_MODULE_DRV,
+					 "failed to resume device %d (%d)",
+					 node_id(node),
+					 node->ret);
+			else
+				pr_error(LOG_MODULE_DRV,
+					 "suspend (%d) failed for dev %d (%d)",
+					 state, node_id(node),
+					 node->ret);
+			ret = node->ret;
+			continue;
+		}
+		node_set_powerstate(node, state);
+#ifdef CONFIG_DEVICE_PM_STATS
+		node_update_stats(node, state);
+#endif
 	}
-	device->powerstate = state;
-	return 0;
-
-exit_devices:
-	// Resume devices
-
-	for (; (++dev_index) < device->dev_child_count; )
-		resume_device(device->dev_child[dev_index]);
-exit_buses:
-	// Resume bus devices
-	for (; (++bus_index) < device->bus_child_count; )
-		resume_bus_device(&device->bus_child[bus_index]);
 	return ret;
 }
 
@@ -349,10 +512,39 @@ int init_devices(struct device **pf_devices, unsigned int dev_count,
 
 int resume_devices(void)
 {
-	return resume_bus_device(&root_device);
+	unsigned int depth;
+	int ret;
+	int fail = 0;
+
+	// Parent buses are resumed before their children
+	for (depth = 0; depth <= device_max_depth; depth++) {
+		if ((ret = device_pm_step(depth, PM_RUNNING)))
+			fail = ret;
+	}
+	return fail;
 }
 
 int suspend_devices(PM_POWERSTATE state)
 {
-	return suspend_bus_device(&root_device, state);
+	int depth;
+	int ret;
+
+	// Validate input argument
+	if (state == PM_NOT_INIT)
+		return -EINVAL;
+	if (root_device.powerstate <= state)
+		// Device already suspended
+		return 0;
+
+	// Children are suspended before their parent bus
+	for (depth = device_max_depth; depth >= 0; depth--) {
+		if ((ret = device_pm_step(depth, state))) {
+			if (state > PM_SHUTDOWN)
+				// Resume the devices already suspended
+				resume_devices();
+			// Suspend operation aborted
+			return ret;
+		}
+	}
+	return 0;
 }
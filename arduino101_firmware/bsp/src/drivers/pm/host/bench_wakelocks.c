@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host benchmark of pm_wakelock_acquire() and pm_wakelock_release() with
+ * many other wakelocks held, as drivers like spi_flash take a wakelock per
+ * I/O while others are held.
+ *
+ * The held wakelocks expire between 100 ms and 5 s, and were acquired in a
+ * random order. A pair of acquire and release of another wakelock is timed
+ * for a timeout that expires before all of them, one in the middle and an
+ * infinite one, and the timer restarts it causes are counted. Time does not
+ * advance, so that no wakelock expires.
+ *
+ * Built against wakelocks.c, and against the sorted list it replaced
+ * (wakelocks_legacy.c) as bench_wakelocks_legacy.
+ */
+
+/* time.h and os.h both declare timer_create() and timer_delete() */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+#include <stdio.h>
+#include <stdlib.h>
+#include "os/os.h"
+#include "infra/pm.h"
+#include "infra/device.h"
+#include "infra/log.h"
+
+#ifndef VARIANT
+#define VARIANT "current"
+#endif
+
+#define MAX_HELD    256
+#define ITERATIONS  100000
+
+static struct pm_wakelock held[MAX_HELD];
+static struct pm_wakelock probe;
+
+static uint32_t now_ms = 1000;
+static uint32_t timer_starts;
+static uint32_t timer_stops;
+static int timer;
+
+/* OS layer */
+
+uint32_t interrupt_lock(void)
+{
+    return 0;
+}
+
+void interrupt_unlock(uint32_t flags)
+{
+}
+
+uint32_t get_time_ms(void)
+{
+    return now_ms;
+}
+
+T_TIMER timer_create(T_ENTRY_POINT callback, void *privData, uint32_t delay,
+                     bool repeat, bool startup, OS_ERR_TYPE *err)
+{
+    return &timer;
+}
+
+void timer_start(T_TIMER tmr, uint32_t delay, OS_ERR_TYPE *err)
+{
+    timer_starts++;
+}
+
+void timer_stop(T_TIMER tmr, OS_ERR_TYPE *err)
+{
+    timer_stops++;
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    return 0;
+}
+
+void pm_wakelock_set_any_wakelock_taken_on_cpu(bool wl_status)
+{
+}
+
+struct device *get_device(uint8_t id)
+{
+    return NULL;
+}
+
+const struct pm_suspend_blocker pm_blockers[1];
+const uint8_t pm_blocker_size = 0;
+
+/* Benchmark */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int hold(int count)
+{
+    int order[MAX_HELD];
+    int errors = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    for (i = count - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int tmp = order[i];
+
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (i = 0; i < count; i++) {
+        struct pm_wakelock *wl = &held[order[i]];
+
+        pm_wakelock_init(wl, order[i] + 1);
+        errors += pm_wakelock_acquire(wl, 100 + order[i] * 4900 / count) != 0;
+    }
+    return errors;
+}
+
+static int unhold(int count)
+{
+    int errors = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        errors += pm_wakelock_release(&held[i]) != 0;
+    }
+    return errors;
+}
+
+static int run(int count, unsigned int timeout, const char *name)
+{
+    uint32_t starts, stops;
+    uint64_t start;
+    int errors = hold(count);
+    int i;
+
+    starts = timer_starts;
+    stops = timer_stops;
+    start = now_ns();
+    for (i = 0; i < ITERATIONS; i++) {
+        errors += pm_wakelock_acquire(&probe, timeout) != 0;
+        errors += pm_wakelock_release(&probe) != 0;
+    }
+    printf("%-8s %4d held, %-8s timeout: %6.1f ns/pair, "
+           "%.2f timer starts and %.2f stops/pair\n",
+           VARIANT, count, name, (double)(now_ns() - start) / ITERATIONS,
+           (double)(timer_starts - starts) / ITERATIONS,
+           (double)(timer_stops - stops) / ITERATIONS);
+
+    errors += unhold(count);
+    if (!pm_wakelock_is_list_empty()) {
+        errors++;
+    }
+    return errors;
+}
+
+int main(void)
+{
+    static const int counts[] = { 0, 8, 64, MAX_HELD };
+    int errors = 0;
+    unsigned int i;
+
+    srand(1);
+    pm_wakelock_init_mgr();
+    pm_wakelock_init(&probe, 0);
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        errors += run(counts[i], 50, "first");
+        errors += run(counts[i], 2500, "middle");
+        errors += run(counts[i], WAKELOCK_FOREVER, "infinite");
+    }
+    if (errors) {
+        printf("%s: %d calls failed\n", VARIANT, errors);
+    }
+    return errors ? 1 : 0;
+}
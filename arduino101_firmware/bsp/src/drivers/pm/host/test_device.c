@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host check of the device tree power management of device.c, with mock
+ * drivers that take a configurable time to suspend and resume.
+ *
+ * Time is a 32 kHz tick counter. A synchronous mock driver advances it by
+ * its latency. An asynchronous one returns -EINPROGRESS and completes when
+ * the counter reaches its latency, from the "interrupt" delivered by
+ * get_uptime_32k() while interrupts are unlocked.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include "infra/device.h"
+#include "infra/log.h"
+#include "machine.h"
+
+#define MAX_PENDING	16
+/* Scheduling overhead allowed per device, in ticks */
+#define TICK_SLACK	4
+
+enum mock_mode {
+	MOCK_SYNC,      /* the callback takes the latency */
+	MOCK_ASYNC,     /* the driver completes after the latency */
+	MOCK_EARLY,     /* the driver completes before returning -EINPROGRESS */
+	MOCK_HANG,      /* the driver never completes */
+};
+
+struct mock {
+	enum mock_mode mode;
+	uint16_t suspend_ticks;
+	uint16_t resume_ticks;
+	int suspend_ret;
+	uint8_t is_bus;
+	uint8_t suspends;
+	uint8_t resumes;
+};
+
+struct completion {
+	void *dev;
+	uint8_t is_bus;
+	uint32_t due;
+};
+
+static uint32_t now;
+static int locked;
+static struct completion pending[MAX_PENDING];
+static int pending_count;
+static int failures;
+
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			printf("%s:%d: check failed: %s\n", __FILE__,	\
+			       __LINE__, #cond);			\
+			failures++;					\
+		}							\
+	} while (0)
+
+uint32_t interrupt_lock(void)
+{
+	uint32_t saved = locked;
+
+	locked = 1;
+	return saved;
+}
+
+void interrupt_unlock(uint32_t saved)
+{
+	locked = saved;
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+	return 0;
+}
+
+static void deliver(void)
+{
+	struct completion c;
+	int i;
+
+	for (i = 0; i < pending_count; i++) {
+		if ((int32_t)(now - pending[i].due) < 0)
+			continue;
+		c = pending[i];
+		pending[i] = pending[--pending_count];
+		i--;
+		if (c.is_bus)
+			bus_pm_complete(c.dev, 0);
+		else
+			device_pm_complete(c.dev, 0);
+	}
+}
+
+uint32_t get_uptime_32k(void)
+{
+	uint32_t t = now++;
+
+	if (!locked)
+		deliver();
+	return t;
+}
+
+static void complete_later(void *dev, uint8_t is_bus, uint16_t ticks)
+{
+	CHECK(pending_count < MAX_PENDING);
+	pending[pending_count].dev = dev;
+	pending[pending_count].is_bus = is_bus;
+	pending[pending_count].due = now + ticks;
+	pending_count++;
+}
+
+static int mock_op(void *dev, struct mock *mock, uint16_t ticks, int ret)
+{
+	if (ret)
+		return ret;
+	switch (mock->mode) {
+	case MOCK_SYNC:
+		now += ticks;
+		return 0;
+	case MOCK_ASYNC:
+		complete_later(dev, mock->is_bus, ticks);
+		return -EINPROGRESS;
+	case MOCK_EARLY:
+		if (mock->is_bus)
+			bus_pm_complete(dev, 0);
+		else
+			device_pm_complete(dev, 0);
+		return -EINPROGRESS;
+	default:
+		return -EINPROGRESS;
+	}
+}
+
+static int dev_suspend(struct device *dev, PM_POWERSTATE state)
+{
+	struct mock *mock = dev->priv;
+
+	mock->suspends++;
+	return mock_op(dev, mock, mock->suspend_ticks, mock->suspend_ret);
+}
+
+static int dev_resume(struct device *dev)
+{
+	struct mock *mock = dev->priv;
+
+	// The parent bus is resumed first
+	CHECK(dev->parent->powerstate == PM_RUNNING);
+	mock->resumes++;
+	return mock_op(dev, mock, mock->resume_ticks, 0);
+}
+
+static int bus_suspend(struct bus *bus, PM_POWERSTATE state)
+{
+	struct mock *mock = bus->priv;
+	unsigned int i;
+
+	// The children are suspended first
+	for (i = 0; i < bus->dev_child_count; i++)
+		CHECK(bus->dev_child[i]->powerstate <= state);
+	for (i = 0; i < bus->bus_child_count; i++)
+		CHECK(bus->bus_child[i].powerstate <= state);
+	mock->suspends++;
+	return mock_op(bus, mock, mock->suspend_ticks, mock->suspend_ret);
+}
+
+static int bus_resume(struct bus *bus)
+{
+	struct mock *mock = bus->priv;
+
+	CHECK(bus->parent->powerstate == PM_RUNNING);
+	mock->resumes++;
+	return mock_op(bus, mock, mock->resume_ticks, 0);
+}
+
+static struct driver mock_driver = {
+	.init		= NULL,
+	.suspend	= dev_suspend,
+	.resume		= dev_resume
+};
+
+static struct bus_driver mock_bus_driver = {
+	.init		= NULL,
+	.suspend	= bus_suspend,
+	.resume		= bus_resume
+};
+
+/*
+ * root
+ *  +- dev 1, dev 2, bus 10, bus 11
+ *  bus 10
+ *   +- dev 3, dev 4, bus 12
+ *   bus 12
+ *    +- dev 5
+ *  bus 11
+ *   +- dev 6, dev 1 (same id as the first dev 1)
+ */
+static struct mock m1 = { MOCK_SYNC, 10, 5 };
+static struct mock m2 = { MOCK_ASYNC, 300, 200 };
+static struct mock m3 = { MOCK_ASYNC, 400, 300 };
+static struct mock m4 = { MOCK_ASYNC, 250, 250 };
+static struct mock m5 = { MOCK_ASYNC, 500, 100 };
+static struct mock m6 = { MOCK_SYNC, 50, 50 };
+static struct mock m7 = { MOCK_EARLY, 0, 0 };
+static struct mock m10 = { MOCK_ASYNC, 100, 100, 0, 1 };
+static struct mock m11 = { MOCK_SYNC, 20, 20, 0, 1 };
+static struct mock m12 = { MOCK_SYNC, 0, 0, 0, 1 };
+
+static struct device d1 = { .priv = &m1, .driver = &mock_driver, .id = 1 };
+static struct device d2 = { .priv = &m2, .driver = &mock_driver, .id = 2 };
+static struct device d3 = { .priv = &m3, .driver = &mock_driver, .id = 3 };
+static struct device d4 = { .priv = &m4, .driver = &mock_driver, .id = 4 };
+static struct device d5 = { .priv = &m5, .driver = &mock_driver, .id = 5 };
+static struct device d6 = { .priv = &m6, .driver = &mock_driver, .id = 6 };
+static struct device d7 = { .priv = &m7, .driver = &mock_driver, .id = 1 };
+
+static struct device *bus12_devices[] = { &d5 };
+static struct bus bus10_buses[] = {
+	{ .priv = &m12, .driver = &mock_bus_driver, .id = 12,
+	  LINK_DEVICES_TO_BUS(bus12_devices), LINK_BUSES_TO_BUS_NULL },
+};
+static struct device *bus10_devices[] = { &d3, &d4 };
+static struct device *bus11_devices[] = { &d6, &d7 };
+static struct bus root_buses[] = {
+	{ .priv = &m10, .driver = &mock_bus_driver, .id = 10,
+	  LINK_DEVICES_TO_BUS(bus10_devices), LINK_BUSES_TO_BUS(bus10_buses) },
+	{ .priv = &m11, .driver = &mock_bus_driver, .id = 11,
+	  LINK_DEVICES_TO_BUS(bus11_devices), LINK_BUSES_TO_BUS_NULL },
+};
+static struct device *root_devices[] = { &d1, &d2 };
+
+static struct mock *mocks[] = {
+	&m1, &m2, &m3, &m4, &m5, &m6, &m7, &m10, &m11, &m12
+};
+
+#define MOCK_COUNT (sizeof(mocks) / sizeof(mocks[0]))
+
+static void check_states(PM_POWERSTATE state)
+{
+	CHECK(d1.powerstate == state);
+	CHECK(d2.powerstate == state);
+	CHECK(d3.powerstate == state);
+	CHECK(d4.powerstate == state);
+	CHECK(d5.powerstate == state);
+	CHECK(d6.powerstate == state);
+	CHECK(d7.powerstate == state);
+	CHECK(root_buses[0].powerstate == state);
+	CHECK(root_buses[1].powerstate == state);
+	CHECK(bus10_buses[0].powerstate == state);
+}
+
+static void reset_counts(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < MOCK_COUNT; i++) {
+		mocks[i]->suspends = 0;
+		mocks[i]->resumes = 0;
+	}
+}
+
+static void check_counts(int suspends, int resumes)
+{
+	unsigned int i;
+
+	for (i = 0; i < MOCK_COUNT; i++) {
+		CHECK(mocks[i]->suspends == suspends);
+		CHECK(mocks[i]->resumes == resumes);
+	}
+	reset_counts();
+}
+
+/*
+ * Longest time of a suspend or resume: at each depth, the synchronous
+ * drivers run one after the other, and the asynchronous ones overlap with
+ * each other and with the synchronous drivers called after them.
+ */
+static uint32_t schedule_ticks(int suspend)
+{
+	static const uint8_t depth[MOCK_COUNT] = { 1, 1, 2, 2, 3, 2, 2, 1, 1, 2 };
+	uint32_t sync[4] = { 0 }, async[4] = { 0 };
+	uint32_t ticks, total = 0;
+	unsigned int i;
+
+	for (i = 0; i < MOCK_COUNT; i++) {
+		ticks = suspend ? mocks[i]->suspend_ticks :
+			mocks[i]->resume_ticks;
+		if (mocks[i]->mode == MOCK_SYNC)
+			sync[depth[i]] += ticks;
+		else if (ticks > async[depth[i]])
+			async[depth[i]] = ticks;
+	}
+	for (i = 0; i < 4; i++)
+		total += sync[i] + async[i];
+	return total;
+}
+
+static uint32_t serial_ticks(int suspend)
+{
+	uint32_t total = 0;
+	unsigned int i;
+
+	for (i = 0; i < MOCK_COUNT; i++)
+		total += suspend ? mocks[i]->suspend_ticks :
+			 mocks[i]->resume_ticks;
+	return total;
+}
+
+static void check_lookup(void)
+{
+	CHECK(get_device(1) == &d1);
+	CHECK(get_device(4) == &d4);
+	CHECK(get_device(12) == (struct device *)&bus10_buses[0]);
+	CHECK(get_device(ROOT_DEVICE_ID) != NULL);
+	CHECK(get_device(7) == NULL);
+	CHECK(get_device(DEVICE_ID_COUNT) == NULL);
+	CHECK(get_device(255) == NULL);
+}
+
+static void check_suspend_resume(void)
+{
+	struct device_pm_stats stats;
+	uint32_t start, suspend, resume;
+
+	reset_counts();
+	start = now;
+	CHECK(suspend_devices(PM_SUSPENDED) == 0);
+	suspend = now - start;
+	check_states(PM_SUSPENDED);
+	check_counts(1, 0);
+
+	start = now;
+	CHECK(resume_devices() == 0);
+	resume = now - start;
+	check_states(PM_RUNNING);
+	check_counts(0, 1);
+
+	CHECK(pending_count == 0);
+	CHECK(suspend <= schedule_ticks(1) + TICK_SLACK * MOCK_COUNT);
+	CHECK(resume <= schedule_ticks(0) + TICK_SLACK * MOCK_COUNT);
+	CHECK(suspend < serial_ticks(1));
+	CHECK(resume < serial_ticks(0));
+	printf("suspend %u ticks, resume %u ticks (serial %u, %u)\n",
+	       suspend, resume, serial_ticks(1), serial_ticks(0));
+
+	CHECK(device_get_pm_stats(5, &stats) == 0);
+	CHECK(stats.suspend_time >= 500);
+	CHECK(stats.suspend_time <= 500 + TICK_SLACK);
+	CHECK(stats.resume_time >= 100);
+	CHECK(stats.resume_time <= 100 + TICK_SLACK);
+	CHECK(device_get_pm_stats(1, &stats) == 0);
+	CHECK(stats.suspend_time >= 10);
+	CHECK(stats.suspend_time <= 10 + TICK_SLACK);
+	CHECK(device_get_pm_stats(7, &stats) == -EINVAL);
+}
+
+static void check_failure(void)
+{
+	/*
+	 * A failed suspend resumes the devices already suspended. The
+	 * devices of a depth are suspended in reverse order: 7, 6, 12, 4, 3.
+	 */
+	reset_counts();
+	m4.suspend_ret = -EIO;
+	CHECK(suspend_devices(PM_SUSPENDED) == -EIO);
+	m4.suspend_ret = 0;
+	check_states(PM_RUNNING);
+	CHECK(m5.suspends == 1 && m5.resumes == 1);
+	CHECK(m7.suspends == 1 && m7.resumes == 1);
+	CHECK(m6.suspends == 1 && m6.resumes == 1);
+	CHECK(m12.suspends == 1 && m12.resumes == 1);
+	CHECK(m4.suspends == 1 && m4.resumes == 0);
+	CHECK(m3.suspends == 0 && m3.resumes == 0);
+	CHECK(m10.suspends == 0 && m10.resumes == 0);
+	CHECK(m1.suspends == 0 && m1.resumes == 0);
+}
+
+static void check_timeout(void)
+{
+	struct device_pm_stats stats;
+	uint32_t start;
+
+	// A driver that does not complete fails the suspend after a timeout
+	m3.mode = MOCK_HANG;
+	start = now;
+	CHECK(suspend_devices(PM_SUSPENDED) == -ETIMEDOUT);
+	CHECK(now - start >= 32768 / 10);
+	check_states(PM_RUNNING);
+	// A late completion is ignored
+	device_pm_complete(&d3, 0);
+	CHECK(d3.powerstate == PM_RUNNING);
+	m3.mode = MOCK_ASYNC;
+
+	// The next suspend does not wait for the lost completion
+	start = now;
+	CHECK(suspend_devices(PM_SUSPENDED) == 0);
+	CHECK(now - start <= schedule_ticks(1) + TICK_SLACK * MOCK_COUNT);
+	CHECK(resume_devices() == 0);
+	CHECK(device_get_pm_stats(3, &stats) == 0);
+	CHECK(stats.suspend_max >= 400 && stats.suspend_max <= 400 + TICK_SLACK);
+}
+
+static void check_shutdown(void)
+{
+	// A failed shutdown leaves the devices stopped
+	reset_counts();
+	m6.suspend_ret = -EIO;
+	CHECK(suspend_devices(PM_SHUTDOWN) == -EIO);
+	m6.suspend_ret = 0;
+	CHECK(d5.powerstate == PM_SHUTDOWN);
+	CHECK(d6.powerstate == PM_RUNNING);
+	CHECK(d1.powerstate == PM_RUNNING);
+	CHECK(m5.resumes == 0);
+}
+
+int main(void)
+{
+	CHECK(init_devices(root_devices, 2, root_buses, 2) == 0);
+	check_states(PM_RUNNING);
+
+	check_lookup();
+	check_suspend_resume();
+	check_failure();
+	check_timeout();
+	check_shutdown();
+
+	printf("%s\n", failures ? "FAIL" : "PASS");
+	return failures != 0;
+}
@@ -33,12 +33,17 @@
 #include "infra/pm.h"
 #include "infra/device.h"
 #include "infra/log.h"
+#include "infra/wakelock_ids.h"
 #include <stdbool.h>
 #include <errno.h>
+#include <string.h>
 
 /*! Wakelock management structure */
 struct pm_wakelock_mgr {
-    list_head_t wl_list;      /*!< List that contains locked wakelocks, ordered by timeout */
+    struct pm_wakelock *held; /*!< Locked wakelocks, not ordered */
+    uint8_t     held_count[WAKELOCK_ID_MAX]; /*!< Locked wakelocks per id, ids can be shared */
+    uint32_t    deadline;     /*!< Expiration time wl_timer is started for */
+    uint8_t     timer_armed;  /*!< wl_timer is started */
     T_TIMER     wl_timer;     /*!< Timer to wait for next wakelock to expire */
     uint8_t     is_init;      /*!< Init state of wakelock structure */
     void        (*cb)(void*); /*!< Callback function to call when wakelock list is empty */
@@ -50,14 +55,59 @@ static void pm_wakelock_timeout_callback(void* priv);
 
 static volatile struct pm_wakelock_mgr pm_wakelock_inst = {
                             .is_init = 0,
-                            .wl_list = {.head=NULL, .tail=NULL},
+                            .held = NULL,
                             .cb = NULL,
                             .cb_priv = NULL};
 
+/* Adds a wakelock to the locked wakelocks, interrupts must be locked */
+static void pm_wakelock_link(struct pm_wakelock *wl)
+{
+    wl->prev = NULL;
+    wl->next = pm_wakelock_inst.held;
+    if (wl->next) {
+        wl->next->prev = wl;
+    }
+    pm_wakelock_inst.held = wl;
+
+    if ((unsigned int)wl->id < WAKELOCK_ID_MAX) {
+        pm_wakelock_inst.held_count[wl->id]++;
+    }
+}
+
+/* Removes a wakelock from the locked wakelocks, interrupts must be locked */
+static void pm_wakelock_unlink(struct pm_wakelock *wl, uint32_t current_time)
+{
+    if (wl->prev) {
+        wl->prev->next = wl->next;
+    } else {
+        pm_wakelock_inst.held = wl->next;
+    }
+    if (wl->next) {
+        wl->next->prev = wl->prev;
+    }
+    wl->next = wl->prev = NULL;
+    wl->lock = 0;
+
+    if ((unsigned int)wl->id < WAKELOCK_ID_MAX) {
+        pm_wakelock_inst.held_count[wl->id]--;
+    }
+
+#ifdef CONFIG_WAKELOCK_STATS
+    uint32_t hold_time = current_time - wl->stats.acquire_time;
+
+    wl->stats.total_time += hold_time;
+    if (hold_time > wl->stats.max_time) {
+        wl->stats.max_time = hold_time;
+    }
+#else
+    (void)current_time;
+#endif
+}
+
 static void pm_wakelock_timeout_callback(void* priv)
 {
-    int time_diff = 0;
     bool spurious_irq = true;
+    int next_timeout = WAKELOCK_MAX_TIMEOUT + 1;
 
     struct pm_wakelock_mgr *wl_mgr = (struct pm_wakelock_mgr*)priv;
     uint32_t current_time = (uint32_t)get_time_ms();
@@ -65,71 +115,60 @@ static void pm_wakelock_timeout_callback(void* priv)
     // Lock IRQs as this function runs in timer task context
     uint32_t saved = interrupt_lock();
 
-    list_t *l = wl_mgr->wl_list.head;
+    struct pm_wakelock *wl = wl_mgr->held;
 
-    // Remove all expired wakelocks
-    while (l) {
-        time_diff = (int)(((struct pm_wakelock*)l)->timeout) - \
-                    (int)(current_time - ((struct pm_wakelock*)l)->start_time);
-        if (time_diff > 0) {
-            // Unexpired wakelock found, stop
-            break;
-        }
+    wl_mgr->timer_armed = 0;
 
-        // Remove expired wakelock from list
-        wl_mgr->wl_list.head = l->next;
-        spurious_irq = false;
-
-        if (((struct pm_wakelock*)l)->timeout == WAKELOCK_MAX_TIMEOUT+1) {
-            // Infinite wakelock expired, insert it again at end of list
-            pr_warning(LOG_MODULE_DRV, "infinite wakelock %d hold for %d ms", ((struct pm_wakelock*)l)->id, WAKELOCK_MAX_TIMEOUT);
-            // Update start_time to reset infinite wakelock
-            ((struct pm_wakelock*)l)->start_time = current_time;
-
-            if (wl_mgr->wl_list.head != NULL) {
-                // Other wakelocks are in the list, put infinite wl at end of list
-                wl_mgr->wl_list.tail->next = l;
-                l->next = NULL;
-                wl_mgr->wl_list.tail = l;
-                // Select next wakelock to check for timeout
-                l = wl_mgr->wl_list.head;
+    // Remove all expired wakelocks and find the next one to expire
+    while (wl) {
+        struct pm_wakelock *next = wl->next;
+        int time_diff = (int)wl->timeout - (int)(current_time - wl->start_time);
+
+        if (time_diff <= 0) {
+            spurious_irq = false;
+            if (wl->timeout == WAKELOCK_MAX_TIMEOUT+1) {
+                // Infinite wakelock expired, update start_time to reset it
+                pr_warning(LOG_MODULE_DRV, "infinite wakelock %d hold for %d ms", wl->id, WAKELOCK_MAX_TIMEOUT);
+                wl->start_time = current_time;
+                time_diff = wl->timeout;
             } else {
-                // Infinite wakelock is the only one in the list
-                // Restore list head and stop
-                wl_mgr->wl_list.head = l;
-                // Set time_diff to restart wl timer
-                time_diff = ((struct pm_wakelock*)l)->timeout;
-                break;
+                // Normal wakelock expired, release it
+                pm_wakelock_unlink(wl, current_time);
+#ifdef CONFIG_WAKELOCK_STATS
+                wl->stats.expire_count++;
+#endif
+                pr_warning(LOG_MODULE_DRV, "wakelock %d expired", wl->id);
+                wl = next;
+                continue;
             }
-        } else {
-            // Normal wakelock expired, release it
-            ((struct pm_wakelock*)l)->lock = 0;
-            pr_warning(LOG_MODULE_DRV, "wakelock %d expired", ((struct pm_wakelock*)l)->id);
-            // Select next wakelock to check for timeout
-            l = l->next;
         }
+        if (time_diff < next_timeout) {
+            next_timeout = time_diff;
+        }
+        wl = next;
     }
 
-    if (l == NULL) {
-        // all timers expired
-        wl_mgr->wl_list.head = wl_mgr->wl_list.tail = NULL;
+    if (wl_mgr->held != NULL) {
+        // Restart timer for the next wakelock to expire. Releases in the
+        // meantime make the timer fire early, it is then restarted here.
+        wl_mgr->deadline = current_time + next_timeout;
+        wl_mgr->timer_armed = 1;
+        timer_stop(wl_mgr->wl_timer, NULL);
+        timer_start(wl_mgr->wl_timer, next_timeout, NULL);
+        interrupt_unlock(saved);
+        return;
     }
     // Unlock IRQs
     interrupt_unlock(saved);
 
-    if (l != NULL) {
-        // Restart timer
-        timer_start(wl_mgr->wl_timer, time_diff, NULL);
+    // Check for spurious IRQ else we will call the callback function for nothing
+    if (spurious_irq) {
+        pr_error(LOG_MODULE_DRV, "Wakelock: spurious IRQ detected");
     } else {
-        // Check for spurious IRQ else we will call the callback function for nothing
-        if (spurious_irq) {
-            pr_error(LOG_MODULE_DRV, "Wakelock: spurious IRQ detected");
-        } else {
-            pm_wakelock_set_any_wakelock_taken_on_cpu(false);
-            // Call callback function to notify that all wakelocks are free
-            if (pm_wakelock_inst.cb != NULL) {
-                pm_wakelock_inst.cb(pm_wakelock_inst.cb_priv);
-            }
+        pm_wakelock_set_any_wakelock_taken_on_cpu(false);
+        // Call callback function to notify that all wakelocks are free
+        if (pm_wakelock_inst.cb != NULL) {
+            pm_wakelock_inst.cb(pm_wakelock_inst.cb_priv);
         }
     }
 }
@@ -161,13 +200,14 @@ void pm_wakelock_init(struct pm_wakelock *wli, int id)
     wli->lock = 0;
     wli->id = id;
     wli->timeout = 0;
-    wli->list.next = NULL;
+    wli->next = wli->prev = NULL;
+#ifdef CONFIG_WAKELOCK_STATS
+    memset(&wli->stats, 0, sizeof(wli->stats));
+#endif
 }
 
 int pm_wakelock_acquire(struct pm_wakelock *wl, unsigned int timeout)
 {
-    list_t *l;
-
     if (timeout > WAKELOCK_MAX_TIMEOUT) {
         // Error in input parameters
         return -EINVAL;
@@ -195,37 +235,22 @@ int pm_wakelock_acquire(struct pm_wakelock *wl, unsigned int timeout)
     wl->lock = 1;
 
     wl->start_time = current_time;
-
-    if (!(l = pm_wakelock_inst.wl_list.head)) {
-        // List empty, add first item in the list
-        pm_wakelock_inst.wl_list.head = pm_wakelock_inst.wl_list.tail = (list_t*)wl;
-        wl->list.next = NULL;
-        // The list is empty so timer is not running: start it
-        timer_start(pm_wakelock_inst.wl_timer, timeout, NULL);
-    } else if (timeout < (int)(((struct pm_wakelock*)l)->timeout) -
-                         (int)(current_time - ((struct pm_wakelock*)l)->start_time)) {
-        // Insert before first item in the list
-        wl->list.next = l;
-        pm_wakelock_inst.wl_list.head = (list_t*)wl;
-        // We need to restart the timer on the new timeout
-        timer_stop(pm_wakelock_inst.wl_timer, NULL);
-        timer_start(pm_wakelock_inst.wl_timer, timeout, NULL);
-    } else {
-        // Insert item anywhere in the list
-        for (; l->next; (l = l->next)) {
-            int time_diff = (int)(((struct pm_wakelock*)(l->next))->timeout) - \
-                            (int)(current_time - ((struct pm_wakelock*)(l->next))->start_time);
-            if (timeout < time_diff) {
-                break;
-            }
-        }
-        // Check if wl item is the last item
-        if(!(l->next)) {
-            pm_wakelock_inst.wl_list.tail = (list_t*)wl;
+#ifdef CONFIG_WAKELOCK_STATS
+    wl->stats.acquire_time = current_time;
+    wl->stats.acquire_count++;
+#endif
+
+    pm_wakelock_link(wl);
+
+    // The timer is only restarted when this wakelock expires first
+    if (!pm_wakelock_inst.timer_armed ||
+        (int)(current_time + timeout - pm_wakelock_inst.deadline) < 0) {
+        pm_wakelock_inst.deadline = current_time + timeout;
+        if (pm_wakelock_inst.timer_armed) {
+            timer_stop(pm_wakelock_inst.wl_timer, NULL);
         }
-
-        wl->list.next = l->next;
-        l->next = (list_t*)wl;
+        pm_wakelock_inst.timer_armed = 1;
+        timer_start(pm_wakelock_inst.wl_timer, timeout, NULL);
     }
 
     interrupt_unlock(saved);
@@ -234,7 +259,6 @@ int pm_wakelock_acquire(struct pm_wakelock *wl, unsigned int timeout)
 
 int pm_wakelock_release(struct pm_wakelock *wl)
 {
-    list_t *l;
     int ret = 0;
 
     // Lock IRQs
@@ -244,53 +268,20 @@ int pm_wakelock_release(struct pm_wakelock *wl)
         ret = -EINVAL;
         goto exit;
     }
-    // Release wakelock
-    wl->lock = 0;
-    l = pm_wakelock_inst.wl_list.head;
-
-    if (l == (list_t*)wl) {
-        // release first item in the wakelock list
-        pm_wakelock_inst.wl_list.head = wl->list.next;
-
-        // Check if there is only one item in the wakelock list
-        if (pm_wakelock_inst.wl_list.tail == (list_t*)wl) {
-            pm_wakelock_inst.wl_list.head = pm_wakelock_inst.wl_list.tail = NULL;
-
-            // Stop the timer as all wakelocks have expired
-            timer_stop(pm_wakelock_inst.wl_timer, NULL);
-
-            pm_wakelock_set_any_wakelock_taken_on_cpu(false);
-            // Call callback function to notify that all wakelocks are free
-            if (pm_wakelock_inst.cb != NULL) {
-                pm_wakelock_inst.cb(pm_wakelock_inst.cb_priv);
-            }
-        } else {
-            uint32_t current_time = (uint32_t)get_time_ms();
-            int time_diff = (int)(((struct pm_wakelock*)(l->next))->timeout) -
-                            (int)(current_time - ((struct pm_wakelock*)(l->next))->start_time);
-            if (time_diff > 0) {
-                // Restart timer for next wakelock to expire
-                timer_stop(pm_wakelock_inst.wl_timer, NULL);
-                timer_start(pm_wakelock_inst.wl_timer, time_diff, NULL);
-            }
-        }
-        goto exit;
-    }
+    // Release wakelock, the timer is left running if other wakelocks
+    // are locked
+    pm_wakelock_unlink(wl, (uint32_t)get_time_ms());
 
-    // Find wakelock in the list
-    for (; (l->next) && (l->next != (list_t*)wl); (l = l->next));
-
-    if (l->next != NULL) {
-        // Item before wl found, remove wl item from the list
-        l->next = wl->list.next;
+    if (pm_wakelock_inst.held == NULL) {
+        // Stop the timer as all wakelocks are released
+        pm_wakelock_inst.timer_armed = 0;
+        timer_stop(pm_wakelock_inst.wl_timer, NULL);
 
-        // Check if wl item is the last one in the list
-        if (pm_wakelock_inst.wl_list.tail == (list_t*)wl) {
-            pm_wakelock_inst.wl_list.tail = l;
+        pm_wakelock_set_any_wakelock_taken_on_cpu(false);
+        // Call callback function to notify that all wakelocks are free
+        if (pm_wakelock_inst.cb != NULL) {
+            pm_wakelock_inst.cb(pm_wakelock_inst.cb_priv);
         }
-    } else {
-        //wl list clear
-        ret = -ENOENT;
     }
 exit:
     interrupt_unlock(saved);
@@ -299,8 +290,26 @@ exit:
 
 bool pm_wakelock_is_list_empty()
 {
-    return (pm_wakelock_inst.wl_list.head == NULL ? true : false);
+    return (pm_wakelock_inst.held == NULL ? true : false);
+}
+
+bool pm_wakelock_is_held(int id)
+{
+    if ((unsigned int)id >= WAKELOCK_ID_MAX) {
+        return false;
+    }
+    return pm_wakelock_inst.held_count[id] != 0;
+}
+
+#ifdef CONFIG_WAKELOCK_STATS
+void pm_wakelock_get_stats(const struct pm_wakelock *wl,
+                           struct pm_wakelock_stats *stats)
+{
+    uint32_t saved = interrupt_lock();
+    *stats = wl->stats;
+    interrupt_unlock(saved);
 }
+#endif
 
 void pm_wakelock_set_list_empty_cb(void (*cb)(void*), void* priv)
 {
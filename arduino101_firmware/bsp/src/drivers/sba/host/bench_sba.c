@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Latencies of serial_bus_access.c on the SPI models of sba_sim.c, in
+ * simulated time, on SPI master 0 at 250 KHz:
+ *  - a sensor read (1 byte command, 6 bytes of data) every 20 ms, while a
+ *    flash client keeps 4 page reads (4 byte command, 256 bytes of data)
+ *    queued, a sample being missed when the previous read is still
+ *    pending: all in the same class as before the priority classes, then
+ *    the sensor in SBA_PRIO_HIGH and the flash in SBA_PRIO_BULK,
+ *  - back to back register reads (1 byte register address, then 6 bytes
+ *    of data), the two segments as separate requests, the task submitting
+ *    the second one once woken by the first one, then chained. Separate
+ *    requests release the chip select in between, which the sensor would
+ *    not accept: they only give the timing.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sba_sim.h"
+
+#define DURATION_US   (2 * 1000 * 1000)
+#define SENSOR_US     20000
+#define FLASH_QUEUE   4
+#define PAGE          256
+#define READS         1000
+
+static sba_request_t flash_req[FLASH_QUEUE];
+static uint8_t flash_cmd[FLASH_QUEUE][4];
+static uint8_t flash_data[FLASH_QUEUE][PAGE];
+static unsigned int flash_pages;
+
+static sba_request_t sensor_req;
+static sba_request_t sensor_data_req;
+static uint8_t sensor_cmd[1];
+static uint8_t sensor_data[6];
+static uint64_t sensor_submitted;
+static int sensor_pending;
+static unsigned int sensor_reads;
+static unsigned int sensor_missed;
+static uint64_t sensor_total_us;
+static uint64_t sensor_max_us;
+
+static int stop;
+
+static void flash_done(sba_request_t *req)
+{
+    flash_pages++;
+    if (!stop) {
+        sba_exec_request(req);
+    }
+}
+
+static void sensor_done(sba_request_t *req)
+{
+    uint64_t us = sim_now() - sensor_submitted;
+
+    sensor_pending = 0;
+    sensor_reads++;
+    sensor_total_us += us;
+    if (us > sensor_max_us) {
+        sensor_max_us = us;
+    }
+}
+
+static void sensor_read(void *arg)
+{
+    if (stop) {
+        return;
+    }
+    if (sensor_pending) {
+        sensor_missed++;
+    } else {
+        sensor_pending = 1;
+        sensor_submitted = sim_now();
+        sba_exec_request(&sensor_req);
+    }
+    sim_at(sim_now() + SENSOR_US, sensor_read, NULL);
+}
+
+static void end(void *arg)
+{
+    stop = 1;
+}
+
+static void init_request(sba_request_t *req, SBA_REQUEST_TYPE type, uint8_t *tx, uint32_t tx_len,
+                         uint8_t *rx, uint32_t rx_len, SBA_PRIORITY priority,
+                         void (*callback)(sba_request_t *))
+{
+    memset(req, 0, sizeof(*req));
+    req->request_type = type;
+    req->tx_buff = tx;
+    req->tx_len = tx_len;
+    req->rx_buff = rx;
+    req->rx_len = rx_len;
+    req->bus_id = SBA_SPI_MASTER_0;
+    req->addr.cs = SPI_SE_1;
+    req->priority = priority;
+    req->callback = callback;
+}
+
+static void bench_load(const char *name, SBA_PRIORITY sensor, SBA_PRIORITY flash)
+{
+    int i;
+
+    sim_init();
+    stop = 0;
+    flash_pages = 0;
+    sensor_pending = 0;
+    sensor_reads = 0;
+    sensor_missed = 0;
+    sensor_total_us = 0;
+    sensor_max_us = 0;
+
+    init_request(&sensor_req, SBA_TRANSFER, sensor_cmd, sizeof(sensor_cmd),
+                 sensor_data, sizeof(sensor_data), sensor, sensor_done);
+    for (i = 0; i < FLASH_QUEUE; i++) {
+        init_request(&flash_req[i], SBA_TRANSFER, flash_cmd[i], sizeof(flash_cmd[i]),
+                     flash_data[i], PAGE, flash, flash_done);
+        sba_exec_request(&flash_req[i]);
+    }
+    sim_at(SENSOR_US / 2, sensor_read, NULL);
+    sim_at(DURATION_US, end, NULL);
+    sim_run_all();
+
+    printf("%-24s sensor latency %6.0f us avg %6llu us max, %3u/%3u samples missed, flash %5.1f KiB/s\n",
+           name, (double)sensor_total_us / sensor_reads, (unsigned long long)sensor_max_us,
+           sensor_missed, sensor_missed + sensor_reads,
+           flash_pages * PAGE / 1024.0 / (sim_now() / 1e6));
+}
+
+static void register_read(void *arg);
+
+static void register_done(sba_request_t *req)
+{
+    if (++sensor_reads < READS) {
+        sim_wakeup(register_read, NULL);
+    }
+}
+
+static void register_data(void *arg)
+{
+    sba_exec_request(&sensor_data_req);
+}
+
+static void register_address_done(sba_request_t *req)
+{
+    sim_wakeup(register_data, NULL);
+}
+
+static void register_read(void *arg)
+{
+    sba_exec_request(&sensor_req);
+}
+
+static void bench_register_reads(const char *name, int chained)
+{
+    uint64_t us;
+
+    sim_init();
+    sensor_reads = 0;
+
+    init_request(&sensor_data_req, SBA_RX, NULL, 0, sensor_data, sizeof(sensor_data),
+                 SBA_PRIO_HIGH, register_done);
+    init_request(&sensor_req, SBA_TX, sensor_cmd, sizeof(sensor_cmd), NULL, 0,
+                 SBA_PRIO_HIGH, register_address_done);
+    if (chained) {
+        sensor_req.chain = &sensor_data_req;
+        sensor_req.callback = register_done;
+    }
+    register_read(NULL);
+    sim_run_all();
+
+    us = sim_now();
+    printf("%-24s %6.1f us/read, %6.0f reads/s, %4.2f chip selects/read\n",
+           name, (double)us / READS, READS / (us / 1e6),
+           (double)sim_stats.cs_asserts / READS);
+}
+
+int main(void)
+{
+    bench_load("one class", SBA_PRIO_NORMAL, SBA_PRIO_NORMAL);
+    bench_load("sensor high, flash bulk", SBA_PRIO_HIGH, SBA_PRIO_BULK);
+    bench_register_reads("separate requests", 0);
+    bench_register_reads("chained", 1);
+    return 0;
+}
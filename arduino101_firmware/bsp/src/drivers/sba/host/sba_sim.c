@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SoC SPI and OS layer models for the host build of serial_bus_access.c,
+ * see sba_sim.h.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sba_sim.h"
+#include "drivers/soc_spi.h"
+#include "infra/log.h"
+#include "infra/pm.h"
+#include "os/os.h"
+
+#define MAX_EVENTS      32
+#define SIM_CONTROLLERS 2
+
+struct sim_event {
+    uint64_t at;
+    uint64_t seq;               /* events due at the same time run in order */
+    void (*fn)(void *arg);
+    void *arg;
+};
+
+struct sim_spi {
+    spi_cfg_data_t cfg;
+    int clocked;
+    int busy;
+    int fail;                   /* the transfer in progress fails */
+    int hold;
+    SPI_SLAVE_ENABLE cs;        /* chip select asserted, 0 for none */
+};
+
+struct sim_stats sim_stats;
+struct sim_transfer sim_trace[SIM_TRACE_SIZE];
+int sim_fail_transfer = -1;
+
+static struct sim_event events[MAX_EVENTS];
+static int event_count;
+static uint64_t event_seq;
+static uint64_t now_us;
+
+static struct sim_spi spi[SIM_CONTROLLERS];
+
+static struct sba_master_cfg_data sim_sba_cfg[SIM_CONTROLLERS];
+static struct bus sim_buses[SIM_CONTROLLERS];
+
+/* Events */
+
+void sim_at(uint64_t at, void (*fn)(void *), void *arg)
+{
+    int i;
+
+    if (event_count == MAX_EVENTS) {
+        fprintf(stderr, "too many pending events\n");
+        exit(2);
+    }
+    for (i = 0; i < MAX_EVENTS; i++) {
+        if (events[i].fn == NULL) {
+            events[i].at = at < now_us ? now_us : at;
+            events[i].seq = event_seq++;
+            events[i].fn = fn;
+            events[i].arg = arg;
+            event_count++;
+            return;
+        }
+    }
+}
+
+void sim_wakeup(void (*fn)(void *), void *arg)
+{
+    sim_at(now_us + SIM_WAKEUP_US, fn, arg);
+}
+
+/* Run the next event, return 0 if none */
+static int run_next(void)
+{
+    void (*fn)(void *);
+    void *arg;
+    int next = -1;
+    int i;
+
+    for (i = 0; i < MAX_EVENTS; i++) {
+        if (events[i].fn != NULL &&
+            (next < 0 || events[i].at < events[next].at ||
+             (events[i].at == events[next].at && events[i].seq < events[next].seq))) {
+            next = i;
+        }
+    }
+    if (next < 0) {
+        return 0;
+    }
+    now_us = events[next].at;
+    fn = events[next].fn;
+    arg = events[next].arg;
+    events[next].fn = NULL;
+    event_count--;
+    fn(arg);
+    return 1;
+}
+
+uint64_t sim_now(void)
+{
+    return now_us;
+}
+
+void sim_run(volatile int *done)
+{
+    while (!*done) {
+        if (!run_next()) {
+            fprintf(stderr, "deadlock: nothing left to run\n");
+            exit(2);
+        }
+    }
+}
+
+void sim_run_all(void)
+{
+    while (run_next()) {
+    }
+}
+
+/* SoC SPI */
+
+static void spi_complete(void *arg)
+{
+    struct sim_spi *s = arg;
+    int fail = s->fail;
+
+    s->busy = 0;
+    s->fail = 0;
+    // As transfer_complete(): only master 0 keeps its chip select asserted
+    if (!(s == &spi[SOC_SPI_MASTER_0] && s->hold)) {
+        s->cs = 0;
+    }
+    if (fail) {
+        sim_stats.errors++;
+        if (s->cfg.cb_err) {
+            s->cfg.cb_err(s->cfg.cb_err_data);
+        }
+    } else if (s->cfg.cb_xfer) {
+        s->cfg.cb_xfer(s->cfg.cb_xfer_data);
+    }
+}
+
+DRIVER_API_RC soc_spi_set_config(SOC_SPI_CONTROLLER controller_id, spi_cfg_data_t *config)
+{
+    if (controller_id >= SIM_CONTROLLERS) {
+        return DRV_RC_INVALID_CONFIG;
+    }
+    spi[controller_id].cfg = *config;
+    return DRV_RC_OK;
+}
+
+DRIVER_API_RC soc_spi_clock_enable(struct sba_master_cfg_data *sba_dev)
+{
+    spi[get_bus_id_from_sba(sba_dev->bus_id)].clocked = 1;
+    return DRV_RC_OK;
+}
+
+DRIVER_API_RC soc_spi_clock_disable(struct sba_master_cfg_data *sba_dev)
+{
+    spi[get_bus_id_from_sba(sba_dev->bus_id)].clocked = 0;
+    return DRV_RC_OK;
+}
+
+DRIVER_API_RC soc_spi_transfer(SOC_SPI_CONTROLLER controller_id, uint8_t *tx_data, uint32_t tx_data_len,
+                               uint8_t *rx_data, uint32_t rx_data_len, int full_duplex, SPI_SLAVE_ENABLE slave)
+{
+    struct sim_spi *s = &spi[controller_id];
+    struct sim_transfer *t = NULL;
+    uint32_t bytes = full_duplex ? rx_data_len : tx_data_len + rx_data_len;
+    uint64_t us = (uint64_t)bytes * 8 * 1000 / s->cfg.speed + SIM_TRANSFER_US;
+    uint32_t i;
+
+    if (s->busy) {
+        return DRV_RC_CONTROLLER_IN_USE;
+    }
+    if (full_duplex && rx_data_len < tx_data_len) {
+        return DRV_RC_INVALID_OPERATION;
+    }
+    if (!s->clocked) {
+        fprintf(stderr, "transfer on a gated controller\n");
+        exit(2);
+    }
+    if (sim_stats.transfers < SIM_TRACE_SIZE) {
+        t = &sim_trace[sim_stats.transfers];
+        t->start = now_us;
+        t->end = now_us + us;
+        t->controller = controller_id;
+        t->tx_len = tx_data_len;
+        t->rx_len = rx_data_len;
+        t->cs = slave;
+        t->cs_asserted = s->cs != slave;
+    }
+    if (s->cs != slave) {
+        sim_stats.cs_asserts++;
+    }
+    s->cs = slave;
+    // The slave answers with the number of the transfer
+    for (i = 0; i < rx_data_len; i++) {
+        rx_data[i] = (uint8_t)sim_stats.transfers;
+    }
+    s->fail = (int)sim_stats.transfers == sim_fail_transfer;
+    s->busy = 1;
+    sim_stats.transfers++;
+    sim_stats.bus_us += us;
+    sim_at(now_us + us, spi_complete, s);
+    return DRV_RC_OK;
+}
+
+DRIVER_API_RC soc_spi_cs_hold(SOC_SPI_CONTROLLER controller_id, int hold)
+{
+    struct sim_spi *s = &spi[controller_id];
+
+    if (controller_id != SOC_SPI_MASTER_0) {
+        return hold ? DRV_RC_INVALID_OPERATION : DRV_RC_OK;
+    }
+    s->hold = hold;
+    if (!hold && !s->busy) {
+        s->cs = 0;
+    }
+    return DRV_RC_OK;
+}
+
+int soc_spi_cs_hold_supported(SOC_SPI_CONTROLLER controller_id)
+{
+    return controller_id == SOC_SPI_MASTER_0;
+}
+
+int sim_cs_asserted(int controller)
+{
+    return spi[controller].cs != 0;
+}
+
+int sim_clocked(int controller)
+{
+    return spi[controller].clocked;
+}
+
+/* OS layer and infra */
+
+uint32_t interrupt_lock(void)
+{
+    return 0;
+}
+
+void interrupt_unlock(uint32_t key)
+{
+}
+
+void panic(int err)
+{
+    sim_stats.panics++;
+}
+
+void pm_wakelock_init(struct pm_wakelock *wli, int id)
+{
+    wli->id = id;
+    wli->lock = 0;
+}
+
+int pm_wakelock_acquire(struct pm_wakelock *wl, unsigned int timeout)
+{
+    if (!wl->lock) {
+        wl->lock = 1;
+        sim_stats.wakelocks++;
+    }
+    return 0;
+}
+
+int pm_wakelock_release(struct pm_wakelock *wl)
+{
+    if (wl->lock) {
+        wl->lock = 0;
+        sim_stats.wakelocks--;
+    }
+    return 0;
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    return 0;
+}
+
+/* Setup */
+
+int sim_init(void)
+{
+    int i;
+
+    memset(events, 0, sizeof(events));
+    event_count = 0;
+    event_seq = 0;
+    now_us = 0;
+    memset(spi, 0, sizeof(spi));
+    memset(&sim_stats, 0, sizeof(sim_stats));
+    memset(sim_trace, 0, sizeof(sim_trace));
+    sim_fail_transfer = -1;
+
+    for (i = 0; i < SIM_CONTROLLERS; i++) {
+        memset(&sim_sba_cfg[i], 0, sizeof(sim_sba_cfg[i]));
+        sim_sba_cfg[i].bus_id = SBA_SPI_MASTER_0 + i;
+        sim_sba_cfg[i].config.spi_config.speed = SIM_SPI_KHZ;
+        sim_sba_cfg[i].config.spi_config.txfr_mode = SPI_TX_RX;
+        sim_sba_cfg[i].config.spi_config.data_frame_size = SPI_8_BIT;
+        sim_sba_cfg[i].config.spi_config.slave_enable = SPI_SE_1;
+        sim_sba_cfg[i].config.spi_config.bus_mode = SPI_BUSMODE_0;
+        sim_sba_cfg[i].config.spi_config.spi_mode_type = SPI_MASTER;
+
+        memset(&sim_buses[i], 0, sizeof(sim_buses[i]));
+        sim_buses[i].id = i;
+        sim_buses[i].driver = &serial_bus_access_driver;
+        sim_buses[i].priv = &sim_sba_cfg[i];
+        if (sim_buses[i].driver->init(&sim_buses[i]) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of serial_bus_access.c: the SoC SPI masters 0 and 1 are
+ * modelled on a simulated clock, with the interface of soc_spi.h.
+ *
+ * A transfer takes (tx_len + rx_len) * 8 SPI clock cycles at the speed of
+ * the bus configuration (max(tx_len, rx_len) in full duplex), plus
+ * SIM_TRANSFER_US of setup and interrupt handling. Its completion callback
+ * then runs, in interrupt context, as transfer_complete() of the driver.
+ * As in intel_qrk_spi.c, only master 0 can hold its chip select: it stays
+ * asserted at the end of a transfer while the hold is set.
+ *
+ * A task woken by a completion callback runs SIM_WAKEUP_US later, see
+ * sim_wakeup().
+ *
+ * SBA_SPI_MASTER_0 and SBA_SPI_MASTER_1 are initialised with the bus
+ * configuration of the quark soc_config.c (250 KHz).
+ */
+
+#ifndef __SBA_SIM_H__
+#define __SBA_SIM_H__
+
+#include <stdint.h>
+#include "drivers/serial_bus_access.h"
+
+#define SIM_SPI_KHZ       250
+#define SIM_TRANSFER_US   30
+#define SIM_WAKEUP_US     50
+
+#define SIM_TRACE_SIZE    64
+
+/* A transfer of the trace */
+struct sim_transfer {
+    uint64_t start;             /* us */
+    uint64_t end;               /* us */
+    int controller;
+    uint32_t tx_len;
+    uint32_t rx_len;
+    SPI_SLAVE_ENABLE cs;
+    int cs_asserted;            /* the chip select was asserted by this transfer */
+};
+
+struct sim_stats {
+    unsigned int transfers;
+    unsigned int cs_asserts;    /* high to low edges of the chip selects */
+    int wakelocks;              /* wakelocks held */
+    unsigned int panics;
+    unsigned int errors;        /* failed transfers */
+    uint64_t bus_us;            /* time the buses were busy */
+};
+
+extern struct sim_stats sim_stats;
+
+/** The first transfers since sim_init() */
+extern struct sim_transfer sim_trace[SIM_TRACE_SIZE];
+
+/** Transfer, counted from 0 since sim_init(), that ends with an error; -1 for none */
+extern int sim_fail_transfer;
+
+/**
+ * Return the simulated time in us.
+ */
+uint64_t sim_now(void);
+
+/**
+ * Run fn(arg) at the simulated time at.
+ */
+void sim_at(uint64_t at, void (*fn)(void *arg), void *arg);
+
+/**
+ * Run fn(arg) when a task woken now gets to run, SIM_WAKEUP_US later.
+ */
+void sim_wakeup(void (*fn)(void *arg), void *arg);
+
+/**
+ * Run the pending events until *done is set.
+ */
+void sim_run(volatile int *done);
+
+/**
+ * Run all the pending events.
+ */
+void sim_run_all(void);
+
+/**
+ * Return 1 if the chip select of the SPI controller is asserted.
+ */
+int sim_cs_asserted(int controller);
+
+/**
+ * Return 1 if the clock of the SPI controller is ungated.
+ */
+int sim_clocked(int controller);
+
+/**
+ * Reset the clock, the buses and the statistics, and initialize the SBA
+ * bus devices.
+ *
+ * @return 0 on success
+ */
+int sim_init(void);
+
+#endif /* __SBA_SIM_H__ */
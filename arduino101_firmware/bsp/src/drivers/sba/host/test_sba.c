@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks serial_bus_access.c on the SPI models of sba_sim.c:
+ *  - the segments of a transaction run back to back from the completion
+ *    interrupt, with the chip select asserted from the first to the last,
+ *    and the callback of the first request is called once,
+ *  - a failed or refused segment ends the transaction, the next one still
+ *    runs,
+ *  - a chain is refused on a controller that cannot hold its chip select,
+ *  - pending transactions run by priority class, in order within a class,
+ *    a transaction being executed is not interrupted,
+ *  - the clock and the wakelock are released once the bus is idle.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sba_sim.h"
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define REQUESTS 8
+
+static sba_request_t req[REQUESTS];
+static uint8_t tx[REQUESTS][8];
+static uint8_t rx[REQUESTS][8];
+
+/* Requests completed, in order */
+static int done[REQUESTS];
+static int done_count;
+static int8_t status[REQUESTS];
+/* Chip select state when the callback of each request was called */
+static int cs_at_done[REQUESTS];
+
+static void callback(sba_request_t *r)
+{
+    int i = (int)(r - req);
+
+    status[i] = r->status;
+    cs_at_done[i] = sim_cs_asserted(r->bus_id);
+    done[done_count++] = i;
+}
+
+static sba_request_t *setup(int i, SBA_BUSID bus, SBA_PRIORITY priority, sba_request_t *chain)
+{
+    memset(&req[i], 0, sizeof(req[i]));
+    memset(rx[i], 0xff, sizeof(rx[i]));
+    req[i].request_type = SBA_TRANSFER;
+    req[i].tx_buff = tx[i];
+    req[i].tx_len = 1 + i % 3;
+    req[i].rx_buff = rx[i];
+    req[i].rx_len = 2;
+    req[i].bus_id = bus;
+    req[i].addr.cs = SPI_SE_1;
+    req[i].priority = priority;
+    req[i].chain = chain;
+    req[i].callback = callback;
+    return &req[i];
+}
+
+static void reset(void)
+{
+    CHECK(sim_init() == 0);
+    done_count = 0;
+    memset(done, -1, sizeof(done));
+}
+
+static void check_idle(int controller)
+{
+    CHECK(!sim_cs_asserted(controller));
+    CHECK(!sim_clocked(controller));
+    CHECK(sim_stats.wakelocks == 0);
+    CHECK(sim_stats.panics == 0);
+}
+
+static void check_single(void)
+{
+    reset();
+    CHECK(sba_exec_request(setup(0, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL)) == DRV_RC_OK);
+    CHECK(sim_clocked(SOC_SPI_MASTER_0));
+    CHECK(sim_stats.wakelocks == 1);
+    sim_run_all();
+
+    CHECK(done_count == 1 && done[0] == 0 && status[0] == 0);
+    CHECK(sim_stats.transfers == 1 && sim_stats.cs_asserts == 1);
+    CHECK(rx[0][0] == 0 && rx[0][1] == 0);
+    check_idle(SOC_SPI_MASTER_0);
+}
+
+static void check_chain(void)
+{
+    int i;
+
+    reset();
+    // 0 -> 1 -> 2, only the callback of 0 is called
+    setup(2, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL);
+    setup(1, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, &req[2]);
+    setup(0, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, &req[1]);
+    // The bus and address of the segments are the ones of the first request
+    req[1].bus_id = req[2].bus_id = SBA_SPI_MASTER_1;
+    req[1].addr.cs = req[2].addr.cs = SPI_SE_2;
+    req[2].request_type = SBA_RX;
+    CHECK(sba_exec_request(&req[0]) == DRV_RC_OK);
+    sim_run_all();
+
+    CHECK(done_count == 1 && done[0] == 0 && status[0] == 0);
+    // The chip select is released before the callback...
+    CHECK(!cs_at_done[0]);
+    CHECK(sim_stats.transfers == 3);
+    for (i = 0; i < 3; i++) {
+        CHECK(sim_trace[i].controller == SOC_SPI_MASTER_0);
+        CHECK(sim_trace[i].cs == SPI_SE_1);
+        CHECK(sim_trace[i].tx_len == (i == 2 ? 0 : req[i].tx_len));
+        CHECK(rx[i][0] == i && rx[i][1] == i);
+        // ... and not released between segments, which start from the interrupt
+        CHECK(sim_trace[i].cs_asserted == (i == 0));
+        CHECK(i == 0 || sim_trace[i].start == sim_trace[i - 1].end);
+    }
+    CHECK(sim_stats.cs_asserts == 1);
+    check_idle(SOC_SPI_MASTER_0);
+
+    // The chip select of the next transaction is asserted again
+    CHECK(sba_exec_request(setup(3, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL)) == DRV_RC_OK);
+    sim_run_all();
+    CHECK(done_count == 2 && done[1] == 3 && !cs_at_done[3]);
+    CHECK(sim_stats.cs_asserts == 2);
+}
+
+static void check_failed_segment(void)
+{
+    reset();
+    setup(2, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL);
+    setup(1, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, &req[2]);
+    setup(0, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, &req[1]);
+    setup(3, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL);
+    sim_fail_transfer = 1;
+    CHECK(sba_exec_request(&req[0]) == DRV_RC_OK);
+    CHECK(sba_exec_request(&req[3]) == DRV_RC_OK);
+    sim_run_all();
+
+    // The last segment is not sent, the chip select is released
+    CHECK(done_count == 2 && done[0] == 0 && done[1] == 3);
+    CHECK(status[0] == -1 && status[3] == 0);
+    CHECK(sim_stats.transfers == 3 && sim_stats.errors == 1);
+    CHECK(sim_trace[2].tx_len == req[3].tx_len && sim_trace[2].cs_asserted);
+    check_idle(SOC_SPI_MASTER_0);
+
+    // A segment refused by the controller ends the transaction too
+    reset();
+    setup(1, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL);
+    setup(0, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, &req[1]);
+    req[1].full_duplex = 1;
+    req[1].tx_len = 3;
+    CHECK(sba_exec_request(&req[0]) == DRV_RC_OK);
+    sim_run_all();
+    CHECK(done_count == 1 && done[0] == 0 && status[0] == -1);
+    CHECK(sim_stats.transfers == 1);
+    check_idle(SOC_SPI_MASTER_0);
+}
+
+static void check_refused(void)
+{
+    reset();
+    setup(1, SBA_SPI_MASTER_1, SBA_PRIO_NORMAL, NULL);
+    setup(0, SBA_SPI_MASTER_1, SBA_PRIO_NORMAL, &req[1]);
+    CHECK(sba_exec_request(&req[0]) == DRV_RC_INVALID_OPERATION);
+    CHECK(sim_stats.transfers == 0);
+    check_idle(SOC_SPI_MASTER_1);
+
+    // Single requests are accepted
+    CHECK(sba_exec_request(setup(2, SBA_SPI_MASTER_1, SBA_PRIO_NORMAL, NULL)) == DRV_RC_OK);
+    sim_run_all();
+    CHECK(done_count == 1 && done[0] == 2 && status[2] == 0);
+    check_idle(SOC_SPI_MASTER_1);
+
+    CHECK(sba_exec_request(setup(3, SBA_SPI_MASTER_0, SBA_PRIO_COUNT, NULL)) == DRV_RC_INVALID_CONFIG);
+    CHECK(sim_stats.transfers == 1);
+}
+
+static void check_priorities(void)
+{
+    static const int order[] = { 0, 3, 4, 2, 5, 1 };
+    unsigned int i;
+
+    reset();
+    // 0 runs, the other ones are queued while it does
+    CHECK(sba_exec_request(setup(0, SBA_SPI_MASTER_0, SBA_PRIO_BULK, NULL)) == DRV_RC_OK);
+    CHECK(sba_exec_request(setup(1, SBA_SPI_MASTER_0, SBA_PRIO_BULK, NULL)) == DRV_RC_OK);
+    CHECK(sba_exec_request(setup(2, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL)) == DRV_RC_OK);
+    CHECK(sba_exec_request(setup(3, SBA_SPI_MASTER_0, SBA_PRIO_HIGH, NULL)) == DRV_RC_OK);
+    CHECK(sba_exec_request(setup(4, SBA_SPI_MASTER_0, SBA_PRIO_HIGH, NULL)) == DRV_RC_OK);
+    CHECK(sba_exec_request(setup(5, SBA_SPI_MASTER_0, SBA_PRIO_NORMAL, NULL)) == DRV_RC_OK);
+    sim_run_all();
+
+    CHECK(done_count == 6);
+    for (i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        CHECK(done[i] == order[i]);
+    }
+    check_idle(SOC_SPI_MASTER_0);
+}
+
+static void submit_high(void *arg)
+{
+    CHECK(sba_exec_request(setup(3, SBA_SPI_MASTER_0, SBA_PRIO_HIGH, NULL)) == DRV_RC_OK);
+}
+
+static void check_not_interrupted(void)
+{
+    reset();
+    setup(2, SBA_SPI_MASTER_0, SBA_PRIO_BULK, NULL);
+    setup(1, SBA_SPI_MASTER_0, SBA_PRIO_BULK, &req[2]);
+    setup(0, SBA_SPI_MASTER_0, SBA_PRIO_BULK, &req[1]);
+    CHECK(sba_exec_request(&req[0]) == DRV_RC_OK);
+    // Submitted during the first segment
+    sim_at(1, submit_high, NULL);
+    sim_run_all();
+
+    CHECK(done_count == 2 && done[0] == 0 && done[1] == 3);
+    CHECK(sim_stats.transfers == 4);
+    CHECK(sim_trace[3].tx_len == req[3].tx_len && sim_trace[3].cs_asserted);
+    CHECK(sim_stats.cs_asserts == 2);
+    check_idle(SOC_SPI_MASTER_0);
+}
+
+int main(void)
+{
+    check_single();
+    check_chain();
+    check_failed_segment();
+    check_refused();
+    check_priorities();
+    check_not_interrupted();
+
+    printf("%s test_sba\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -105,56 +105,162 @@ static int pm_sba_init(struct bus *dev)
     return 0;
 }
 
-DRIVER_API_RC sba_clock_state(struct sba_master_cfg_data* sba_dev, int enabled){
-    DRIVER_API_RC rc = DRV_RC_OK;
+/*
+ * Bus operations, called through sba_ops_table[] indexed by SBA bus id
+ */
+struct sba_bus_ops {
+    DRIVER_API_RC (*exec)(sba_request_t *request, uint8_t *tx, uint32_t tx_len,
+                          uint8_t *rx, uint32_t rx_len);                /*!< Starts the transfer of a segment */
+    DRIVER_API_RC (*clock)(struct sba_master_cfg_data* sba_dev, int enabled); /*!< Gates or ungates the controller clock */
+    DRIVER_API_RC (*check)(sba_request_t *request);                     /*!< Checks that the bus can execute a transaction (optional) */
+    void (*release)(uint32_t bus_id);                                   /*!< Releases the bus at the end of a transaction (optional) */
+};
 
-    switch(sba_dev->bus_id){
 #ifdef CONFIG_INTEL_QRK_SPI
-        case (SBA_SPI_MASTER_0):
-        case (SBA_SPI_MASTER_1):
-        case (SBA_SPI_SLAVE_0):
-            if (enabled){
-                rc = soc_spi_clock_enable(sba_dev);
-            } else {
-                rc = soc_spi_clock_disable(sba_dev);
-            }
-            break;
+static DRIVER_API_RC sba_soc_spi_exec(sba_request_t *request, uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len)
+{
+    DRIVER_API_RC rc;
+
+    // The chip select is held from the first segment of a transaction, until release
+    if (request->chain != NULL &&
+        (rc = soc_spi_cs_hold(get_bus_id_from_sba(request->bus_id), 1)) != DRV_RC_OK) {
+        return rc;
+    }
+    return soc_spi_transfer(get_bus_id_from_sba(request->bus_id), tx, tx_len, rx, rx_len, request->full_duplex, request->addr.cs);
+}
+
+static DRIVER_API_RC sba_soc_spi_clock(struct sba_master_cfg_data* sba_dev, int enabled)
+{
+    return enabled ? soc_spi_clock_enable(sba_dev) : soc_spi_clock_disable(sba_dev);
+}
+
+static DRIVER_API_RC sba_soc_spi_check(sba_request_t *request)
+{
+    if (request->chain != NULL && !soc_spi_cs_hold_supported(get_bus_id_from_sba(request->bus_id))) {
+        return DRV_RC_INVALID_OPERATION;
+    }
+    return DRV_RC_OK;
+}
+
+static void sba_soc_spi_release(uint32_t bus_id)
+{
+    soc_spi_cs_hold(get_bus_id_from_sba(bus_id), 0);
+}
+
+static const struct sba_bus_ops sba_soc_spi_ops = {
+    .exec = sba_soc_spi_exec,
+    .clock = sba_soc_spi_clock,
+    .check = sba_soc_spi_check,
+    .release = sba_soc_spi_release
+};
 #endif
+
 #ifdef CONFIG_SS_SPI
-        case (SBA_SS_SPI_MASTER_0):
-        case (SBA_SS_SPI_MASTER_1):
-            if (enabled){
-                rc = ss_spi_clock_enable(sba_dev);
-            } else {
-                rc = ss_spi_clock_disable(sba_dev);
-            }
-            break;
+static DRIVER_API_RC sba_ss_spi_exec(sba_request_t *request, uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len)
+{
+    return ss_spi_transfer(get_bus_id_from_sba(request->bus_id), tx, tx_len, rx, rx_len, request->addr.cs);
+}
+
+static DRIVER_API_RC sba_ss_spi_clock(struct sba_master_cfg_data* sba_dev, int enabled)
+{
+    return enabled ? ss_spi_clock_enable(sba_dev) : ss_spi_clock_disable(sba_dev);
+}
+
+static DRIVER_API_RC sba_ss_spi_check(sba_request_t *request)
+{
+    // The chip select is driven by the controller and cannot be held across segments
+    return request->chain != NULL ? DRV_RC_INVALID_OPERATION : DRV_RC_OK;
+}
+
+static const struct sba_bus_ops sba_ss_spi_ops = {
+    .exec = sba_ss_spi_exec,
+    .clock = sba_ss_spi_clock,
+    .check = sba_ss_spi_check
+};
 #endif
+
 #ifdef CONFIG_INTEL_QRK_I2C
-        case(SBA_I2C_MASTER_0):
-        case(SBA_I2C_MASTER_1):
-            if (enabled){
-                rc = soc_i2c_clock_enable(sba_dev);
-            } else {
-                rc = soc_i2c_clock_disable(sba_dev);
-            }
-            break;
+static DRIVER_API_RC sba_soc_i2c_exec(sba_request_t *request, uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len)
+{
+    uint32_t id = get_bus_id_from_sba(request->bus_id);
+
+    if (request->request_type == SBA_RX) {
+        return soc_i2c_read(id, rx, rx_len, request->addr.slave_addr);
+    } else if (request->request_type == SBA_TX) {
+        return soc_i2c_write(id, tx, tx_len, request->addr.slave_addr);
+    }
+    return soc_i2c_transfer(id, tx, tx_len, rx, rx_len, request->addr.slave_addr);
+}
+
+static DRIVER_API_RC sba_soc_i2c_clock(struct sba_master_cfg_data* sba_dev, int enabled)
+{
+    return enabled ? soc_i2c_clock_enable(sba_dev) : soc_i2c_clock_disable(sba_dev);
+}
+
+static const struct sba_bus_ops sba_soc_i2c_ops = {
+    .exec = sba_soc_i2c_exec,
+    .clock = sba_soc_i2c_clock
+};
 #endif
+
 #ifdef CONFIG_SS_I2C
-        case (SBA_SS_I2C_MASTER_0):         //I2C_SS
-        case (SBA_SS_I2C_MASTER_1):
-            if (enabled){
-                rc = ss_i2c_clock_enable(sba_dev);
-            } else {
-                rc = ss_i2c_clock_disable(sba_dev);
-            }
-            break;
+static DRIVER_API_RC sba_ss_i2c_exec(sba_request_t *request, uint8_t *tx, uint32_t tx_len, uint8_t *rx, uint32_t rx_len)
+{
+    uint32_t id = get_bus_id_from_sba(request->bus_id);
+
+    if (request->request_type == SBA_RX) {
+        return ss_i2c_read(id, rx, rx_len, request->addr.slave_addr);
+    } else if (request->request_type == SBA_TX) {
+        return ss_i2c_write(id, tx, tx_len, request->addr.slave_addr);
+    }
+    return ss_i2c_transfer(id, tx, tx_len, rx, rx_len, request->addr.slave_addr);
+}
+
+static DRIVER_API_RC sba_ss_i2c_clock(struct sba_master_cfg_data* sba_dev, int enabled)
+{
+    return enabled ? ss_i2c_clock_enable(sba_dev) : ss_i2c_clock_disable(sba_dev);
+}
+
+static const struct sba_bus_ops sba_ss_i2c_ops = {
+    .exec = sba_ss_i2c_exec,
+    .clock = sba_ss_i2c_clock
+};
 #endif
-        default:
-            rc = DRV_RC_INVALID_OPERATION;
-            break;
-        }
-    return rc;
+
+static const struct sba_bus_ops *sba_ops_table[NB_BUS] = {
+#ifdef CONFIG_INTEL_QRK_SPI
+        [SBA_SPI_MASTER_0]    = &sba_soc_spi_ops,
+        [SBA_SPI_MASTER_1]    = &sba_soc_spi_ops,
+        [SBA_SPI_SLAVE_0]     = &sba_soc_spi_ops,
+#endif
+#ifdef CONFIG_INTEL_QRK_I2C
+        [SBA_I2C_MASTER_0]    = &sba_soc_i2c_ops,
+        [SBA_I2C_MASTER_1]    = &sba_soc_i2c_ops,
+#endif
+#ifdef CONFIG_SS_SPI
+        [SBA_SS_SPI_MASTER_0] = &sba_ss_spi_ops,
+        [SBA_SS_SPI_MASTER_1] = &sba_ss_spi_ops,
+#endif
+#ifdef CONFIG_SS_I2C
+        [SBA_SS_I2C_MASTER_0] = &sba_ss_i2c_ops,
+        [SBA_SS_I2C_MASTER_1] = &sba_ss_i2c_ops
+#endif
+};
+
+/*
+ * Order in which the request lists of the priority classes are served
+ */
+static const uint8_t sba_prio_order[SBA_PRIO_COUNT] = {
+        SBA_PRIO_HIGH,
+        SBA_PRIO_NORMAL,
+        SBA_PRIO_BULK
+};
+
+DRIVER_API_RC sba_clock_state(struct sba_master_cfg_data* sba_dev, int enabled){
+    if (((unsigned int)sba_dev->bus_id) >= NB_BUS || !sba_ops_table[sba_dev->bus_id]) {
+        return DRV_RC_INVALID_OPERATION;
+    }
+    return sba_ops_table[sba_dev->bus_id]->clock(sba_dev, enabled);
 }
 
 static DRIVER_API_RC sba_clock_enable(struct sba_master_cfg_data* sba_dev){
@@ -195,6 +301,23 @@ struct bus_driver serial_bus_access_driver = {.init = pm_sba_init,
 
 void sba_err_callback(uint32_t bus_id);
 
+/*
+ * Returns the first pending request of the highest priority class, or NULL
+ */
+static sba_request_t *sba_next_request(struct sba_master_cfg_data* sba_dev)
+{
+    sba_request_t *request;
+    int i;
+
+    for (i = 0; i < SBA_PRIO_COUNT; i++) {
+        request = (sba_request_t *)list_get(&sba_dev->request_list[sba_prio_order[i]]);
+        if (request != NULL) {
+            return request;
+        }
+    }
+    return NULL;
+}
+
 /*! \fn     static void sba_generic_callback(uint32_t bus_id, int8_t status)
 *
 *  \brief   Function executed when SPI or I2C read, write or transfer is over.
@@ -207,6 +330,8 @@ void sba_err_callback(uint32_t bus_id);
 static void sba_generic_callback(uint32_t bus_id, int8_t status)
 {
     DRIVER_API_RC rc = DRV_RC_OK;
+    sba_request_t *request;
+    sba_request_t *segment;
 
     // Little hack to get device because we cannot give a priv data to i2c/spi driver (only bus_id)
     struct bus *dev;
@@ -216,15 +341,32 @@ static void sba_generic_callback(uint32_t bus_id, int8_t status)
     }
     sba_dev = (struct sba_master_cfg_data*)dev->priv;
 
-    if ((sba_dev->current_request) == NULL) {
+    if ((request = sba_dev->current_request) == NULL) {
         panic(E_OS_ERR_UNKNOWN); // Panic because we should never reach this point.
     } else {
-        sba_dev->current_request->status = status;
-        if (NULL != sba_dev->current_request->callback){
-            sba_dev->current_request->callback(sba_dev->current_request);
+        // Chain the next segment of the transaction
+        segment = sba_dev->current_segment;
+        if (status == 0 && segment->chain != NULL) {
+            segment = segment->chain;
+            segment->bus_id = request->bus_id;
+            segment->addr = request->addr;
+            sba_dev->current_segment = segment;
+            if (execute_request(segment) == DRV_RC_OK) {
+                return;
+            }
+            status = -1;
+        }
+        if (sba_ops_table[bus_id]->release != NULL) {
+            sba_ops_table[bus_id]->release(bus_id);
         }
 
-        if ((sba_dev->current_request = (sba_request_t *)list_get(&sba_dev->request_list)) != NULL) {
+        request->status = status;
+        if (NULL != request->callback){
+            request->callback(request);
+        }
+
+        if ((sba_dev->current_request = sba_next_request(sba_dev)) != NULL) {
+            sba_dev->current_segment = sba_dev->current_request;
             rc = execute_request(sba_dev->current_request);
             if (rc != DRV_RC_OK) {
                 sba_err_callback(bus_id);
@@ -411,6 +553,13 @@ DRIVER_API_RC sba_exec_request(sba_request_t *request)
     if (sba_dev->controller_initialised != 1) {
         return DRV_RC_FAIL;
     }
+    if (request->priority >= SBA_PRIO_COUNT) {
+        return DRV_RC_INVALID_CONFIG;
+    }
+    if (sba_ops_table[request->bus_id] && sba_ops_table[request->bus_id]->check &&
+        (rc = sba_ops_table[request->bus_id]->check(request)) != DRV_RC_OK) {
+        return rc;
+    }
 
     uint32_t saved = interrupt_lock();
 
@@ -418,10 +567,11 @@ DRIVER_API_RC sba_exec_request(sba_request_t *request)
     sba_clock_enable(sba_dev);
     if (sba_dev->current_request == NULL) {
         sba_dev->current_request = request;
+        sba_dev->current_segment = request;
         interrupt_unlock(saved);
         rc = execute_request(request);
     } else {
-        list_add(&sba_dev->request_list, (list_t *)request);
+        list_add(&sba_dev->request_list[request->priority], (list_t *)request);
         interrupt_unlock(saved);
     }
     return rc;
@@ -442,109 +592,20 @@ DRIVER_API_RC sba_exec_request(sba_request_t *request)
 */
 static DRIVER_API_RC execute_request(sba_request_t *request)
 {
-    DRIVER_API_RC rc = DRV_RC_FAIL; // TODO Initialisation not needed when ifdef will be removed
+    const struct sba_bus_ops *ops;
+
+    if (((unsigned int)request->bus_id) >= NB_BUS || !(ops = sba_ops_table[request->bus_id])) {
+        return DRV_RC_INVALID_CONFIG;
+    }
 
     switch(request->request_type) {
         case SBA_RX:
-            switch(request->bus_id){
-#ifdef CONFIG_INTEL_QRK_SPI
-                case (SBA_SPI_MASTER_0):            //SPI_SOC
-                case (SBA_SPI_MASTER_1):
-                case (SBA_SPI_SLAVE_0):
-                    rc = soc_spi_transfer(  get_bus_id_from_sba(request->bus_id), NULL, 0, request->rx_buff, request->rx_len, request->full_duplex, request->addr.cs);
-                    break;
-#endif
-#ifdef CONFIG_INTEL_QRK_I2C
-                case (SBA_I2C_MASTER_0):            //I2C_SOC
-                case (SBA_I2C_MASTER_1):
-                    rc = soc_i2c_read(get_bus_id_from_sba(request->bus_id), request->rx_buff, request->rx_len, request->addr.slave_addr);
-                    break;
-#endif
-#ifdef CONFIG_SS_SPI
-                case (SBA_SS_SPI_MASTER_0):         //SPI_SS
-                case (SBA_SS_SPI_MASTER_1):
-                    rc = ss_spi_transfer(get_bus_id_from_sba(request->bus_id), NULL, 0, request->rx_buff, request->rx_len, request->addr.cs);
-                    break;
-#endif
-#ifdef CONFIG_SS_I2C
-                case (SBA_SS_I2C_MASTER_0):         //I2C_SS
-                case (SBA_SS_I2C_MASTER_1):
-                    rc = ss_i2c_read(get_bus_id_from_sba(request->bus_id), request->rx_buff, request->rx_len, request->addr.slave_addr);
-                    break;
-#endif
-                default:
-                    rc = DRV_RC_INVALID_CONFIG;
-                    break;
-            }
-            break;
+            return ops->exec(request, NULL, 0, request->rx_buff, request->rx_len);
         case SBA_TX:
-            switch(request->bus_id){
-#ifdef CONFIG_INTEL_QRK_SPI
-                case (SBA_SPI_MASTER_0):            //SPI_SOC
-                case (SBA_SPI_MASTER_1):
-                case (SBA_SPI_SLAVE_0):
-                    rc = soc_spi_transfer(  get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, NULL, 0, request->full_duplex, request->addr.cs);
-                    break;
-#endif
-#ifdef CONFIG_INTEL_QRK_I2C
-                case (SBA_I2C_MASTER_0):            //I2C_SOC
-                case (SBA_I2C_MASTER_1):
-                    rc = soc_i2c_write(get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, request->addr.slave_addr);
-                    break;
-#endif
-#ifdef CONFIG_SS_SPI
-                case (SBA_SS_SPI_MASTER_0):         //SPI_SS
-                case (SBA_SS_SPI_MASTER_1):
-                    rc = ss_spi_transfer(get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, NULL, 0, request->addr.cs);
-                    break;
-#endif
-#ifdef CONFIG_SS_I2C
-                case (SBA_SS_I2C_MASTER_0):         //I2C_SS
-                case (SBA_SS_I2C_MASTER_1):
-                    rc = ss_i2c_write(get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, request->addr.slave_addr);
-                    break;
-#endif
-                default:
-                    rc = DRV_RC_INVALID_CONFIG;
-                    break;
-            }
-            break;
+            return ops->exec(request, request->tx_buff, request->tx_len, NULL, 0);
         case SBA_TRANSFER:
-            switch(request->bus_id){
-#ifdef CONFIG_INTEL_QRK_SPI
-                case (SBA_SPI_MASTER_0):            //SPI_SOC
-                case (SBA_SPI_MASTER_1):
-                case (SBA_SPI_SLAVE_0):
-                    rc = soc_spi_transfer(  get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, request->rx_buff, request->rx_len, request->full_duplex, request->addr.cs);
-                    break;
-#endif
-#ifdef CONFIG_INTEL_QRK_I2C
-                case (SBA_I2C_MASTER_0):            //I2C_SOC
-                case (SBA_I2C_MASTER_1):
-                    rc = soc_i2c_transfer(get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, request->rx_buff, request->rx_len, request->addr.slave_addr);
-                    break;
-#endif
-#ifdef CONFIG_SS_SPI
-                case (SBA_SS_SPI_MASTER_0):         //SPI_SS
-                case (SBA_SS_SPI_MASTER_1):
-                    rc = ss_spi_transfer(get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, request->rx_buff, request->rx_len, request->addr.cs);
-                    break;
-#endif
-#ifdef CONFIG_SS_I2C
-                case (SBA_SS_I2C_MASTER_0):         //I2C_SS
-                case (SBA_SS_I2C_MASTER_1):
-                    rc = ss_i2c_transfer(get_bus_id_from_sba(request->bus_id), request->tx_buff, request->tx_len, request->rx_buff, request->rx_len, request->addr.slave_addr);
-                    break;
-#endif
-                default:
-                    rc = DRV_RC_INVALID_CONFIG;
-                    break;
-            }
-            break;
+            return ops->exec(request, request->tx_buff, request->tx_len, request->rx_buff, request->rx_len);
         default:
-            rc = DRV_RC_INVALID_OPERATION;
-            break;
+            return DRV_RC_INVALID_OPERATION;
     }
-
-    return rc;
 }
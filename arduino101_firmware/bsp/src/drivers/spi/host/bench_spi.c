@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file bench_spi.c
+ *
+ * Throughput of the SoC SPI master 0 driver for 4KB transfers, on the SPI
+ * model:
+ * - write only
+ * - read after a one byte command
+ * - full duplex
+ * - 8 byte reads after a one byte command, 4KB in total
+ *
+ * The interrupt is taken one frame time after it is raised. The bus time
+ * counts the frames clocked and the frame times the bus stalled, waiting for
+ * the driver. Register accesses and interrupts are what the driver costs
+ * the CPU.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "spi_model.h"
+#include "drivers/soc_spi.h"
+
+#define XFER_SIZE       4096
+#define SHORT_READ      8
+/* Bus clock of the figures in KB/s */
+#define SCK_KHZ         1000
+
+extern void soc_spi_mst0_ISR(void);
+
+static uint8_t tx[XFER_SIZE];
+static uint8_t rx[XFER_SIZE];
+static int done;
+
+struct bench_result {
+    uint32_t time;
+    uint32_t frames;
+    uint32_t stalls;
+    uint32_t regs;
+    uint32_t irqs;
+};
+
+static void xfer_done(uint32_t data)
+{
+    done = 1;
+}
+
+static void transfer(uint32_t tx_len, uint32_t rx_len, int fd,
+                     struct bench_result *r)
+{
+    done = 0;
+    if (soc_spi_transfer(SOC_SPI_MASTER_0, tx, tx_len, rx, rx_len, fd,
+                         SPI_SE_1) != DRV_RC_OK) {
+        printf("transfer failed\n");
+        return;
+    }
+    while (!done) {
+        spi_model_run(1);
+        if (spi_model_irq()) {
+            soc_spi_mst0_ISR();
+            r->irqs++;
+        }
+    }
+}
+
+static void report(const char *name, uint32_t bytes, struct bench_result *r,
+                   const struct spi_model_stats *start)
+{
+    const struct spi_model_stats *s = spi_model_get_stats();
+
+    r->time = s->time - start->time;
+    r->frames = s->frames - start->frames;
+    r->stalls = s->stalls - start->stalls;
+    r->regs = s->reg_reads + s->reg_writes - start->reg_reads -
+              start->reg_writes;
+    printf("%-20s %6u frames %5u stalls %6.2f regs/B %5u irqs %6.1f KB/s\n",
+           name, r->frames, r->stalls, (double)r->regs / bytes, r->irqs,
+           (double)bytes * SCK_KHZ * 1000 / 8 / r->time / 1024);
+}
+
+int main(void)
+{
+    spi_cfg_data_t cfg;
+    struct spi_model_stats start;
+    struct bench_result r;
+    int i;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.speed = SCK_KHZ;
+    cfg.txfr_mode = SPI_TX_RX;
+    cfg.data_frame_size = SPI_8_BIT;
+    cfg.bus_mode = SPI_BUSMODE_0;
+    cfg.cb_xfer = xfer_done;
+
+    spi_model_init();
+    soc_spi_set_config(SOC_SPI_MASTER_0, &cfg);
+
+    memset(&r, 0, sizeof(r));
+    start = *spi_model_get_stats();
+    transfer(XFER_SIZE, 0, 0, &r);
+    report("write", XFER_SIZE, &r, &start);
+
+    memset(&r, 0, sizeof(r));
+    start = *spi_model_get_stats();
+    transfer(1, XFER_SIZE, 0, &r);
+    report("command + read", XFER_SIZE, &r, &start);
+
+    memset(&r, 0, sizeof(r));
+    start = *spi_model_get_stats();
+    transfer(XFER_SIZE, XFER_SIZE, 1, &r);
+    report("full duplex", XFER_SIZE, &r, &start);
+
+    memset(&r, 0, sizeof(r));
+    start = *spi_model_get_stats();
+    for (i = 0; i < XFER_SIZE / SHORT_READ; i++) {
+        transfer(1, SHORT_READ, 0, &r);
+    }
+    report("command + 8B reads", XFER_SIZE, &r, &start);
+
+    if (spi_model_error()) {
+        printf("model error: %s\n", spi_model_error());
+        return 1;
+    }
+    return 0;
+}
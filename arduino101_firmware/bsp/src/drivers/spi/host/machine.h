@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host replacement of the machine header: the SoC definitions used by
+ * intel_qrk_spi.c, with the MMIO macros routed to the SPI model.
+ */
+
+#ifndef _MACHINE_H_
+#define _MACHINE_H_
+
+#include <stdint.h>
+#include "spi_model.h"
+
+#define SOC_GPIO_BASE_ADDR              0xB0000C00
+#define SOC_GPIO_SWPORTA_DR             0x00
+#define SOC_GPIO_SWPORTA_DDR            0x04
+
+#define SOC_MST_SPI0_REGISTER_BASE      (0xB0001000)
+#define SOC_MST_SPI1_REGISTER_BASE      (0xB0001400)
+#define SOC_SLV_SPI_REGISTER_BASE       (0xB0001800)
+
+#define SOC_SPIM0_INTERRUPT             (2)
+#define SOC_SPIM1_INTERRUPT             (3)
+#define SOC_SPIS0_INTERRUPT             (4)
+
+#define INT_SPI_MST_0_MASK              (0x454)
+#define INT_SPI_MST_1_MASK              (0x458)
+#define INT_SPI_SLV_MASK                (0x45C)
+
+#ifndef CLOCK_SPEED
+#define CLOCK_SPEED 32
+#endif
+
+/* The test calls the interrupt routines */
+#define SET_INTERRUPT_HANDLER(_vec_, _isr_)
+#define SOC_UNMASK_INTERRUPTS(_driver_)
+
+#define MMIO_REG_VAL_FROM_BASE(base, offset) \
+		spi_model_mmio((uint32_t)((base) + (offset)))
+
+#endif
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <deque>
+#include <vector>
+#include <string.h>
+#include "machine.h"
+
+extern "C" {
+#include "drivers/common_spi.h"
+#include "../soc_spi_priv.h"
+}
+
+#define SPI_BASE   SOC_MST_SPI0_REGISTER_BASE
+#define SPI_SIZE   0x100
+#define GPIO_DR    (SOC_GPIO_BASE_ADDR + SOC_GPIO_SWPORTA_DR)
+#define GPIO_DDR   (SOC_GPIO_BASE_ADDR + SOC_GPIO_SWPORTA_DDR)
+
+/* Raw interrupt status bits */
+#define RIS_TXEI   0x01
+#define RIS_RXFI   0x10
+
+/* Chip select GPIO of each slave enable bit */
+static const int cs_gpio[] = {
+    SPIM0_CS_1_GPIO24, SPIM0_CS_2_GPIO25, SPIM0_CS_3_GPIO26, SPIM0_CS_4_GPIO27
+};
+
+static struct {
+    /* GPIO */
+    uint32_t dr;
+    uint32_t ddr;
+
+    /* Controller */
+    uint32_t ctrl0;
+    uint32_t ctrl1;
+    uint32_t spien;
+    uint32_t ser;
+    uint32_t baudr;
+    uint32_t txftl;
+    uint32_t rxftl;
+    uint32_t imr;
+    std::deque<uint8_t> tx;
+    std::deque<uint8_t> rx;
+    uint32_t rx_left;   /* frames left to receive in EEPROM and RX modes */
+
+    /* Bus */
+    std::vector<uint8_t> mosi;
+
+    struct spi_model_stats stats;
+    const char *error;
+} m;
+
+static void model_error(const char *error)
+{
+    if (m.error == NULL) {
+        m.error = error;
+    }
+    m.stats.errors++;
+}
+
+static uint32_t tmod(void)
+{
+    return (m.ctrl0 & SPI_TMOD_MASK) >> SPI_TMOD_SHIFT;
+}
+
+static bool busy(void)
+{
+    return m.spien && m.ser && (m.rx_left || !m.tx.empty());
+}
+
+static uint32_t raw_status(void)
+{
+    return (m.tx.size() <= m.txftl ? RIS_TXEI : 0) |
+           (m.rx.size() > m.rxftl ? RIS_RXFI : 0);
+}
+
+static bool cs_asserted(int gpio)
+{
+    return (m.ddr & (1u << gpio)) && !(m.dr & (1u << gpio));
+}
+
+/* The slave addressed by SER must be the only one with its chip select low */
+static void check_cs(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(cs_gpio) / sizeof(cs_gpio[0]); i++) {
+        if (cs_asserted(cs_gpio[i]) != (m.ser == (1u << i))) {
+            model_error("frame clocked with a wrong chip select");
+        }
+    }
+}
+
+static void receive(void)
+{
+    if (m.rx.size() == SPI_MODEL_FIFO_DEPTH) {
+        model_error("RX FIFO overflow");
+        return;
+    }
+    m.rx.push_back(SPI_MODEL_MISO(m.stats.frames));
+}
+
+/* One frame time on the bus */
+static void model_frame(void)
+{
+    m.stats.time++;
+    if (!busy()) {
+        if (m.spien && m.ser && m.imr) {
+            m.stats.stalls++;
+        }
+        return;
+    }
+    check_cs();
+
+    if (!m.rx_left) {
+        if (tmod() == SPI_RX_ONLY) {
+            /* The frame written starts the reception, it is not sent */
+            m.tx.pop_front();
+            m.rx_left = m.ctrl1 + 1;
+        } else {
+            m.mosi.push_back(m.tx.front());
+            m.tx.pop_front();
+            if (tmod() == SPI_TX_RX) {
+                receive();
+            }
+            m.stats.frames++;
+            if (tmod() == SPI_EPROM_RD && m.tx.empty()) {
+                m.rx_left = m.ctrl1 + 1;
+            }
+            return;
+        }
+    }
+    receive();
+    m.stats.frames++;
+    m.rx_left--;
+}
+
+static void config_write(uint32_t *reg, uint32_t value)
+{
+    if (m.spien) {
+        model_error("configuration written while the controller is enabled");
+        return;
+    }
+    *reg = value;
+}
+
+static uint32_t spi_read(uint32_t offset)
+{
+    uint32_t value;
+
+    m.stats.reg_reads++;
+    switch (offset) {
+    case CTRL0:
+        return m.ctrl0;
+    case CTRL1:
+        return m.ctrl1;
+    case SPIEN:
+        return m.spien;
+    case SER:
+        return m.ser;
+    case BAUDR:
+        return m.baudr;
+    case TXFTL:
+        return m.txftl;
+    case RXFTL:
+        return m.rxftl;
+    case TXFL:
+        return m.tx.size();
+    case RXFL:
+        return m.rx.size();
+    case SR:
+        /* The driver polls the busy bit: let the bus move */
+        if (busy()) {
+            model_frame();
+        }
+        return (busy() ? SPI_STATUS_BUSY : 0) |
+               (m.tx.size() < SPI_MODEL_FIFO_DEPTH ? SPI_STATUS_TFNF : 0) |
+               (m.tx.empty() ? SPI_STATUS_TFE : 0) |
+               (m.rx.empty() ? 0 : SPI_STATUS_RFNE);
+    case IMR:
+        return m.imr;
+    case ISR:
+        return raw_status() & m.imr;
+    case RISR:
+        return raw_status();
+    case DR:
+        if (m.rx.empty()) {
+            model_error("RX FIFO underflow");
+            return 0;
+        }
+        value = m.rx.front();
+        m.rx.pop_front();
+        return value;
+    default:
+        /* Interrupt clear and identification registers */
+        return 0;
+    }
+}
+
+static void spi_write(uint32_t offset, uint32_t value)
+{
+    m.stats.reg_writes++;
+    switch (offset) {
+    case CTRL0:
+        config_write(&m.ctrl0, value);
+        break;
+    case CTRL1:
+        config_write(&m.ctrl1, value);
+        break;
+    case BAUDR:
+        config_write(&m.baudr, value);
+        break;
+    case TXFTL:
+        config_write(&m.txftl, value);
+        break;
+    case RXFTL:
+        config_write(&m.rxftl, value);
+        break;
+    case SPIEN:
+        m.spien = value & SPI_ENABLE;
+        if (!m.spien) {
+            /* Disabling the controller flushes the FIFOs */
+            m.tx.clear();
+            m.rx.clear();
+            m.rx_left = 0;
+        }
+        break;
+    case SER:
+        if (busy()) {
+            model_error("slave enable written during a transfer");
+        }
+        m.ser = value;
+        break;
+    case IMR:
+        m.imr = value;
+        break;
+    case DR:
+        if (!m.spien) {
+            model_error("data written while the controller is disabled");
+        } else if (m.tx.size() == SPI_MODEL_FIFO_DEPTH) {
+            model_error("TX FIFO overflow");
+        } else {
+            m.tx.push_back(value);
+        }
+        break;
+    default:
+        /* Read only registers */
+        break;
+    }
+}
+
+static uint32_t model_read(uint32_t addr)
+{
+    if (addr >= SPI_BASE && addr < SPI_BASE + SPI_SIZE) {
+        return spi_read(addr - SPI_BASE);
+    }
+    if (addr == GPIO_DR) {
+        return m.dr;
+    }
+    if (addr == GPIO_DDR) {
+        return m.ddr;
+    }
+    model_error("read of a register that is not modelled");
+    return 0;
+}
+
+static void model_write(uint32_t addr, uint32_t value)
+{
+    if (addr >= SPI_BASE && addr < SPI_BASE + SPI_SIZE) {
+        spi_write(addr - SPI_BASE, value);
+    } else if (addr == GPIO_DR) {
+        m.dr = value;
+    } else if (addr == GPIO_DDR) {
+        m.ddr = value;
+    } else {
+        model_error("write of a register that is not modelled");
+    }
+}
+
+spi_model_reg::~spi_model_reg()
+{
+    if (!used) {
+        model_read(addr);
+    }
+}
+
+spi_model_reg::operator uint32_t() const
+{
+    used = true;
+    return model_read(addr);
+}
+
+spi_model_reg &spi_model_reg::operator=(uint32_t value)
+{
+    used = true;
+    model_write(addr, value);
+    return *this;
+}
+
+spi_model_reg &spi_model_reg::operator|=(uint32_t value)
+{
+    used = true;
+    model_write(addr, model_read(addr) | value);
+    return *this;
+}
+
+spi_model_reg &spi_model_reg::operator&=(uint32_t value)
+{
+    used = true;
+    model_write(addr, model_read(addr) & value);
+    return *this;
+}
+
+void spi_model_init(void)
+{
+    m.dr = 0;
+    m.ddr = 0;
+    m.ctrl0 = 0;
+    m.ctrl1 = 0;
+    m.spien = 0;
+    m.ser = 0;
+    m.baudr = 0;
+    m.txftl = 0;
+    m.rxftl = 0;
+    m.imr = 0;
+    m.tx.clear();
+    m.rx.clear();
+    m.rx_left = 0;
+    m.mosi.clear();
+    memset(&m.stats, 0, sizeof(m.stats));
+    m.error = NULL;
+}
+
+const struct spi_model_stats *spi_model_get_stats(void)
+{
+    return &m.stats;
+}
+
+const char *spi_model_error(void)
+{
+    return m.error;
+}
+
+void spi_model_run(uint32_t count)
+{
+    while (count--) {
+        model_frame();
+    }
+}
+
+int spi_model_irq(void)
+{
+    return m.spien && (raw_status() & m.imr);
+}
+
+uint32_t spi_model_mosi(uint32_t first, uint8_t *buf, uint32_t size)
+{
+    uint32_t len = m.mosi.size();
+
+    if (first < len) {
+        memcpy(buf, m.mosi.data() + first,
+               len - first < size ? len - first : size);
+    }
+    return len;
+}
+
+int spi_model_gpio(int pin)
+{
+    return !(m.ddr & (1u << pin)) || (m.dr & (1u << pin));
+}
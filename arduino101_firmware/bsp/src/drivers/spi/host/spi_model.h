@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPI_MODEL_H
+#define SPI_MODEL_H
+
+/*
+ * Host model of the SoC SPI master 0 and of the slaves wired to it, to run
+ * the SPI driver on a host.
+ *
+ * The registers accessed by intel_qrk_spi.c are routed to the model by
+ * machine.h of this directory. The model has the 8 frames deep TX and RX
+ * FIFOs of the controller, its transfer modes and its interrupts, and the
+ * GPIOs used as chip selects. Time is counted in frames: the bus only
+ * moves in spi_model_run(), and while the driver polls the busy bit.
+ */
+
+#include <stdint.h>
+
+#define SPI_MODEL_FIFO_DEPTH 8
+
+/* Byte sent by the slave on the n-th frame clocked since spi_model_init() */
+#define SPI_MODEL_MISO(n) ((uint8_t)((n) * 13 + 7))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct spi_model_stats {
+    uint32_t frames;     /*!< frames clocked on the bus */
+    uint32_t time;       /*!< frame times elapsed */
+    uint32_t stalls;     /*!< frame times without a frame during a transfer */
+    uint32_t reg_reads;  /*!< controller register reads */
+    uint32_t reg_writes; /*!< controller register writes */
+    uint32_t errors;     /*!< FIFO overflows, underflows and misuses */
+};
+
+/** Resets the controller, the GPIOs and the slaves */
+void spi_model_init(void);
+
+/** Counters since spi_model_init() */
+const struct spi_model_stats *spi_model_get_stats(void);
+
+/** First error detected since spi_model_init(), NULL if none */
+const char *spi_model_error(void);
+
+/** Runs the bus for count frame times */
+void spi_model_run(uint32_t count);
+
+/** True while the controller raises its interrupt */
+int spi_model_irq(void);
+
+/**
+ * Number of bytes sent on MOSI since spi_model_init(). The bytes sent from
+ * the first one are copied to buf, up to size bytes.
+ */
+uint32_t spi_model_mosi(uint32_t first, uint8_t *buf, uint32_t size);
+
+/** Level driven on a GPIO, 1 when the GPIO is an input */
+int spi_model_gpio(int pin);
+
+#ifdef __cplusplus
+}
+
+/*
+ * A register of the SoC, accessed by the MMIO macros. A register expression
+ * that is neither read nor written, like "(void)REG;", is read when it goes
+ * out of scope, as a volatile access would be.
+ */
+class spi_model_reg {
+public:
+    explicit spi_model_reg(uint32_t addr) : addr(addr), used(false) {}
+    ~spi_model_reg();
+    operator uint32_t() const;
+    spi_model_reg &operator=(uint32_t value);
+    spi_model_reg &operator|=(uint32_t value);
+    spi_model_reg &operator&=(uint32_t value);
+private:
+    uint32_t addr;
+    mutable bool used;
+};
+
+static inline spi_model_reg spi_model_mmio(uint32_t addr)
+{
+    return spi_model_reg(addr);
+}
+#endif
+
+#endif /* SPI_MODEL_H */
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs random transfers of the SoC SPI master 0 driver against the SPI
+ * model: full duplex, write only, and reads after a command, with a random
+ * interrupt latency. Checks the bytes sent and received, the chip select,
+ * that the FIFOs never overflow, and that transfers that fit in the FIFOs
+ * take a single interrupt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spi_model.h"
+#include "drivers/soc_spi.h"
+
+#define TRANSFERS   20000
+#define MAX_LEN     300
+#define CS_GPIO     24
+
+extern void soc_spi_mst0_ISR(void);
+
+static int failures;
+static int done;
+static int irqs;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static void xfer_done(uint32_t data)
+{
+    done = 1;
+}
+
+static uint32_t rand_len(void)
+{
+    /* Mostly short transfers, that fit in the FIFOs */
+    return rand() % 4 ? rand() % 12 : rand() % MAX_LEN;
+}
+
+/*
+ * Interrupts are taken after 0 to 2 frame times, and sometimes after the
+ * FIFOs had time to fill up or drain.
+ */
+static int run(void)
+{
+    int guard;
+
+    for (guard = 0; !done && guard < 100 * MAX_LEN; guard++) {
+        spi_model_run(rand() % 16 ? rand() % 3 : 2 * SPI_MODEL_FIFO_DEPTH);
+        if (spi_model_irq()) {
+            soc_spi_mst0_ISR();
+            irqs++;
+        }
+    }
+    return done;
+}
+
+static void check_transfer(int fd, uint32_t tx_len, uint32_t rx_len, int hold)
+{
+    static uint8_t tx[MAX_LEN], rx[MAX_LEN + 1], mosi[2 * MAX_LEN];
+    uint32_t frame = spi_model_get_stats()->frames;
+    uint32_t sent = spi_model_mosi(0, NULL, 0);
+    uint32_t i, len;
+
+    for (i = 0; i < tx_len; i++) {
+        tx[i] = rand();
+    }
+    memset(rx, 0xee, sizeof(rx));
+    done = 0;
+    irqs = 0;
+
+    CHECK(soc_spi_cs_hold(SOC_SPI_MASTER_0, hold) == DRV_RC_OK);
+    CHECK(soc_spi_transfer(SOC_SPI_MASTER_0, tx, tx_len, rx, rx_len, fd,
+                           SPI_SE_1) == DRV_RC_OK);
+    if (!run()) {
+        printf("transfer not completed: fd %d tx %u rx %u\n", fd, tx_len,
+               rx_len);
+        failures++;
+        return;
+    }
+
+    /* Command bytes, then dummy frames until the read is complete */
+    len = spi_model_mosi(sent, mosi, sizeof(mosi)) - sent;
+    CHECK(len >= tx_len);
+    CHECK(memcmp(mosi, tx, tx_len) == 0);
+    for (i = tx_len; i < len; i++) {
+        CHECK(mosi[i] == 0);
+    }
+    for (i = 0; i < rx_len; i++) {
+        CHECK(rx[i] == SPI_MODEL_MISO(frame + i + (fd ? 0 : tx_len)));
+    }
+    CHECK(rx[rx_len] == 0xee);
+    CHECK(spi_model_get_stats()->frames - frame ==
+          (fd ? rx_len : tx_len + rx_len));
+    CHECK(spi_model_gpio(CS_GPIO) == !hold);
+    CHECK(soc_spi_status(SOC_SPI_MASTER_0) != SPI_BUSY);
+    if (tx_len <= SPI_MODEL_FIFO_DEPTH && rx_len <= SPI_MODEL_FIFO_DEPTH) {
+        CHECK(irqs == 1);
+    }
+}
+
+int main(void)
+{
+    spi_cfg_data_t cfg;
+    uint32_t tx_len, rx_len;
+    int i, fd;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.speed = 1000;
+    cfg.txfr_mode = SPI_TX_RX;
+    cfg.data_frame_size = SPI_8_BIT;
+    cfg.bus_mode = SPI_BUSMODE_0;
+    cfg.cb_xfer = xfer_done;
+
+    spi_model_init();
+    srand(1);
+    CHECK(soc_spi_set_config(SOC_SPI_MASTER_0, &cfg) == DRV_RC_OK);
+
+    /* A full duplex transfer reads at least what it writes */
+    CHECK(soc_spi_transfer(SOC_SPI_MASTER_0, NULL, 4, NULL, 2, 1, SPI_SE_1) ==
+          DRV_RC_INVALID_OPERATION);
+
+    for (i = 0; i < TRANSFERS; i++) {
+        fd = rand() % 3 == 0;
+        tx_len = rand_len();
+        rx_len = rand() % 4 ? rand_len() : 0;
+        if (fd && rx_len < tx_len) {
+            rx_len = tx_len;
+        }
+        if (tx_len == 0 && rx_len == 0) {
+            continue;
+        }
+        check_transfer(fd, tx_len, rx_len, rand() % 8 == 0);
+        /* Idle time between transfers */
+        spi_model_run(rand() % 3);
+    }
+
+    /* Releasing a held chip select */
+    check_transfer(0, 4, 0, 1);
+    CHECK(soc_spi_cs_hold(SOC_SPI_MASTER_0, 0) == DRV_RC_OK);
+    CHECK(spi_model_gpio(CS_GPIO) == 1);
+
+    CHECK(spi_model_error() == NULL);
+    if (spi_model_error()) {
+        printf("model error: %s\n", spi_model_error());
+    }
+    printf("%d transfers, %u frames\n", TRANSFERS,
+           spi_model_get_stats()->frames);
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures != 0;
+}
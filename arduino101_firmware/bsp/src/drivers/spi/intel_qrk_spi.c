@@ -80,6 +80,7 @@ static void copy_config_data(spi_cfg_data_t *cfg, SOC_SPI_CONTROLLER controller_
 /* IT subrountines */
 
 static void spi_fill_fifo(soc_spi_info_pt dev);
+static uint32_t spi_imr(soc_spi_info_pt dev);
 
 struct soc_spi_cfg_driver_data
 {
@@ -118,22 +119,22 @@ void soc_spi_slv_ISR()
  * Devices definition
  */
 static soc_spi_info_t soc_spi_devs[] = {
-            { .instID = SOC_SPI_MASTER_0,
-            .reg_base = SOC_MST_SPI0_REGISTER_BASE,
+            { .reg_base = SOC_MST_SPI0_REGISTER_BASE,
+            .instID = SOC_SPI_MASTER_0,
             .isr_vector = SOC_SPIM0_INTERRUPT,
             .isr = soc_spi_mst0_ISR,
             .fifo_depth = IO_SPI_MST0_FS,
             .spi_int_mask = INT_SPI_MST_0_MASK
             },
-            { .instID = SOC_SPI_MASTER_1,
-            .reg_base = SOC_MST_SPI1_REGISTER_BASE,
+            { .reg_base = SOC_MST_SPI1_REGISTER_BASE,
+            .instID = SOC_SPI_MASTER_1,
             .isr_vector = SOC_SPIM1_INTERRUPT,
             .isr = soc_spi_mst1_ISR,
             .fifo_depth = IO_SPI_MST1_FS,
             .spi_int_mask = INT_SPI_MST_1_MASK
             },
-            { .instID = SOC_SPI_SLAVE_0,
-            .reg_base = SOC_SLV_SPI_REGISTER_BASE,
+            { .reg_base = SOC_SLV_SPI_REGISTER_BASE,
+            .instID = SOC_SPI_SLAVE_0,
             .isr_vector = SOC_SPIS0_INTERRUPT,
             .isr = soc_spi_slv_ISR,
             .fifo_depth = IO_SPI_SLV_FS,
@@ -296,6 +297,8 @@ DRIVER_API_RC soc_spi_cs_hook(soc_spi_info_pt dev, int slave)
     /* If SPI_M0, use GPIO mode */
     if(dev->instID == SOC_SPI_MASTER_0)
     {
+        uint8_t held_gpio = dev->cs_gpio;
+
         switch(slave)
         {
             case SPI_SE_1:
@@ -323,8 +326,14 @@ DRIVER_API_RC soc_spi_cs_hook(soc_spi_info_pt dev, int slave)
                 return DRV_RC_INVALID_OPERATION;
             }
         }
+        if (dev->cs_held && held_gpio != dev->cs_gpio)
+        {
+            /* Another slave is addressed: release the held one */
+            cs_high(held_gpio);
+        }
         cs_config(dev->cs_gpio);
         cs_low(dev->cs_gpio);
+        dev->cs_held = 0;
     }
     return DRV_RC_OK;
 }
@@ -355,15 +364,55 @@ DRIVER_API_RC soc_spi_transfer(SOC_SPI_CONTROLLER controller_id, uint8_t *tx_dat
     dev->dummy_tx = 0;
 
     dev->full_duplex = full_duplex;
+    dev->tmod = dev->mode;
+
+    /* Half duplex master transfers let the controller skip the unused
+     * direction, instead of pushing dummy frames and discarding the
+     * received ones. Reads are only left to the controller when they fit
+     * in the RX FIFO, longer ones are paced by the dummy frames. */
+    if (controller_id != SOC_SPI_SLAVE_0 && dev->mode == SPI_TX_RX && !full_duplex)
+    {
+        if (rx_data_len == 0)
+        {
+            dev->tmod = SPI_TX_ONLY;
+        }
+        else if (rx_data_len <= dev->fifo_depth && tx_data_len <= dev->fifo_depth)
+        {
+            dev->tmod = tx_data_len ? SPI_EPROM_RD : SPI_RX_ONLY;
+            dev->discarded = tx_data_len;
+            dev->dummy_tx = rx_data_len;
+        }
+    }
 
     /* Disable device */
     MMIO_REG_VAL_FROM_BASE(dev->reg_base, SPIEN) &= SPI_DISABLE;
 
-    //TODO: This might be used when we use the hw driven CS / not GPIO.
-    //MMIO_REG_VAL_FROM_BASE(dev->reg_base, CTRL1) = dev->tx_len + dev->rx_len - 1;
+    MMIO_REG_VAL_FROM_BASE(dev->reg_base, CTRL0) =
+        (MMIO_REG_VAL_FROM_BASE(dev->reg_base, CTRL0) & ~SPI_TMOD_MASK) |
+        (dev->tmod << SPI_TMOD_SHIFT);
+    if (dev->tmod == SPI_EPROM_RD || dev->tmod == SPI_RX_ONLY)
+    {
+        /* Number of frames to receive */
+        MMIO_REG_VAL_FROM_BASE(dev->reg_base, CTRL1) = rx_data_len - 1;
+    }
 
-    /* Enable slave device */
-    MMIO_REG_VAL_FROM_BASE(dev->reg_base, SER) = slave;
+    /* Transfers that fit in the FIFOs are pushed at once and take a single
+     * interrupt, when the last frame is received or sent. Longer ones are
+     * refilled and drained in bursts. */
+    if (rx_data_len <= dev->fifo_depth && tx_data_len <= dev->fifo_depth)
+    {
+        MMIO_REG_VAL_FROM_BASE(dev->reg_base, TXFTL) = 0;
+        dev->rx_threshold = rx_data_len ? rx_data_len - 1 : 0;
+    }
+    else
+    {
+        MMIO_REG_VAL_FROM_BASE(dev->reg_base, TXFTL) = drv_config[controller_id].tx_threshold;
+        dev->rx_threshold = drv_config[controller_id].rx_threshold;
+    }
+    MMIO_REG_VAL_FROM_BASE(dev->reg_base, RXFTL) = dev->rx_threshold;
+
+    /* No slave selected: the transfer starts once the FIFO is filled */
+    MMIO_REG_VAL_FROM_BASE(dev->reg_base, SER) = 0;
 
     MMIO_REG_VAL_FROM_BASE(dev->reg_base, IMR) = SPI_DISABLE_INT;
     MMIO_REG_VAL_FROM_BASE(dev->reg_base, ICR);
@@ -379,11 +428,51 @@ DRIVER_API_RC soc_spi_transfer(SOC_SPI_CONTROLLER controller_id, uint8_t *tx_dat
     }
 #endif
 
-    spi_fill_fifo(dev);
-    MMIO_REG_VAL_FROM_BASE(dev->reg_base, IMR) = SPI_ENABLE_INT;
+    if (dev->tmod == SPI_RX_ONLY)
+    {
+        /* A dummy frame starts the reception */
+        MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR) = 0;
+    }
+    else
+    {
+        spi_fill_fifo(dev);
+    }
+
+    /* Enable slave device */
+    MMIO_REG_VAL_FROM_BASE(dev->reg_base, SER) = slave;
+
+    MMIO_REG_VAL_FROM_BASE(dev->reg_base, IMR) = spi_imr(dev);
     return DRV_RC_OK;
 }
 
+DRIVER_API_RC soc_spi_cs_hold(SOC_SPI_CONTROLLER controller_id, int hold)
+{
+    soc_spi_info_pt dev = &soc_spi_devs[controller_id];
+
+#ifdef QRK_SE_HW_V1
+    if(dev->instID == SOC_SPI_MASTER_0)
+    {
+        dev->cs_hold = hold;
+        if (!hold && dev->cs_held && soc_spi_status(controller_id) != SPI_BUSY)
+        {
+            cs_high(dev->cs_gpio);
+            dev->cs_held = 0;
+        }
+        return DRV_RC_OK;
+    }
+#endif
+    return hold ? DRV_RC_INVALID_OPERATION : DRV_RC_OK;
+}
+
+int soc_spi_cs_hold_supported(SOC_SPI_CONTROLLER controller_id)
+{
+#ifdef QRK_SE_HW_V1
+    return soc_spi_devs[controller_id].instID == SOC_SPI_MASTER_0;
+#else
+    return 0;
+#endif
+}
+
 DRIVER_SPI_STATUS_CODE soc_spi_status(SOC_SPI_CONTROLLER controller_id)
 {
     DRIVER_SPI_STATUS_CODE rc = SPI_OK;
@@ -440,7 +529,14 @@ void transfer_complete(soc_spi_info_pt dev)
 #ifdef QRK_SE_HW_V1
     if(dev->instID == SOC_SPI_MASTER_0)
     {
-        cs_high(dev->cs_gpio);
+        if (dev->cs_hold)
+        {
+            dev->cs_held = 1;
+        }
+        else
+        {
+            cs_high(dev->cs_gpio);
+        }
     }
 #endif
     if (dev->xfer_cb != NULL)
@@ -449,43 +545,69 @@ void transfer_complete(soc_spi_info_pt dev)
     }
 }
 
+/*
+ * Pushes as many frames as the FIFOs can take. The FIFO levels are read
+ * once per burst: each frame pushed will add one frame to the RX FIFO,
+ * except in transmit only mode.
+ */
 void spi_fill_fifo(soc_spi_info_pt dev)
 {
-    uint32_t status = MMIO_REG_VAL_FROM_BASE(dev->reg_base, SR);
-    DBG("%s: status: %x tc: %d rc: %d tlen: %d rlen: %d\n", __func__, status,
+    uint32_t level = MMIO_REG_VAL_FROM_BASE(dev->reg_base, TXFL);
+    uint32_t room;
+
+    if (dev->tmod != SPI_TX_ONLY)
+    {
+        level += MMIO_REG_VAL_FROM_BASE(dev->reg_base, RXFL);
+    }
+    room = (level < dev->fifo_depth) ? dev->fifo_depth - level : 0;
+
+    DBG("%s: room: %d tc: %d rc: %d tlen: %d rlen: %d\n", __func__, room,
             dev->tx_count, dev->rx_count, dev->tx_len, dev->rx_len);
-    while( (status & SPI_STATUS_TFNF) &&
-           ((MMIO_REG_VAL_FROM_BASE(dev->reg_base, RXFL) +
-                MMIO_REG_VAL_FROM_BASE(dev->reg_base, TXFL)) < dev->fifo_depth )) {
-        if (dev->tx_count < dev->tx_len)
-        {
-            DBG("push data\n");
-            MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR) = dev->tx_buf[dev->tx_count++];
-            if (dev->full_duplex)
-            {
-                dev->dummy_tx++;
-            }
-        }
-        else if (dev->dummy_tx < dev->rx_len)
-        {
-            DBG("push dummy\n");
-            MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR) = 0;
-            dev->dummy_tx ++;
-        }
-        else
+    while (room && dev->tx_count < dev->tx_len)
+    {
+        MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR) = dev->tx_buf[dev->tx_count++];
+        if (dev->full_duplex)
         {
-            /* xfer complete, wait for last tx_empty and wait for end of reception. */
-            break;
+            dev->dummy_tx++;
         }
-        status = MMIO_REG_VAL_FROM_BASE(dev->reg_base, SR);
+        room--;
     }
+    while (room && dev->dummy_tx < dev->rx_len)
+    {
+        MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR) = 0;
+        dev->dummy_tx++;
+        room--;
+    }
+    /* Otherwise xfer complete, wait for last tx_empty and wait for end of reception. */
 }
 
+/*
+ * Interrupts to unmask. Once all the frames are pushed, the TX FIFO empty
+ * interrupt would stay raised until the last frame is received: it is
+ * masked while the frames left to receive will raise the RX interrupt.
+ * Transmit only transfers complete on TX FIFO empty.
+ */
+static uint32_t spi_imr(soc_spi_info_pt dev)
+{
+    uint32_t rx_left = dev->rx_len - dev->rx_count;
+
+    if (!dev->full_duplex)
+    {
+        rx_left += dev->tx_len - dev->discarded;
+    }
+    if (dev->rx_len > 0 && dev->tx_count == dev->tx_len &&
+        dev->dummy_tx >= dev->rx_len && rx_left > dev->rx_threshold)
+    {
+        return SPI_ENABLE_INT & SPI_DISABLE_TX_INT;
+    }
+    return SPI_ENABLE_INT;
+}
 
 void soc_spi_ISR_proc(soc_spi_info_pt dev)
 {
     uint32_t status = MMIO_REG_VAL_FROM_BASE(dev->reg_base, ISR);
     uint32_t clear = MMIO_REG_VAL_FROM_BASE(dev->reg_base, ICR);
+    uint32_t level;
 #ifndef DEBUG_SPI_DRIVER
     (void)clear; /* Unused variable */
 #endif
@@ -499,27 +621,31 @@ void soc_spi_ISR_proc(soc_spi_info_pt dev)
     DBG("%s: status: %x tc: %d rc: %d tlen: %d rlen: %d\n", __func__, status,
             dev->tx_count, dev->rx_count, dev->tx_len, dev->rx_len);
 
-    /* Receive data */
-    while(MMIO_REG_VAL_FROM_BASE(dev->reg_base, RXFL) > 0)
+    /* Receive data, a burst of RXFL frames at a time */
+    while((level = MMIO_REG_VAL_FROM_BASE(dev->reg_base, RXFL)) > 0)
     {
-        if (!dev->full_duplex && (dev->discarded < dev->tx_len))
+        if (!dev->full_duplex)
         {
-            uint32_t tmp;
-            tmp = MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR);
-            DBG("discard %x\n", tmp);
-            dev->discarded++;
-        } else {
-            if( dev->rx_count < dev->rx_len)
+            /* Frames received while the command was sent */
+            for (; level && dev->discarded < dev->tx_len; level--)
             {
-                dev->rx_buf[dev->rx_count++] = MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR);
-                DBG("pop %x\n", dev->rx_buf[dev->rx_count -1 ]);
+                (void)MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR);
+                dev->discarded++;
             }
         }
+        for (; level && dev->rx_count < dev->rx_len; level--)
+        {
+            dev->rx_buf[dev->rx_count++] = MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR);
+        }
         if ((dev->rx_len > 0) && (dev->rx_count == dev->rx_len))
         {
             transfer_complete(dev);
             return;
         }
+        for (; level; level--)
+        {
+            (void)MMIO_REG_VAL_FROM_BASE(dev->reg_base, DR);
+        }
     }
 
     if (MMIO_REG_VAL_FROM_BASE(dev->reg_base, SR) & SPI_STATUS_TFE)
@@ -539,5 +665,5 @@ void soc_spi_ISR_proc(soc_spi_info_pt dev)
     DBG("%s: status: %x tc: %d rc: %d tl: %d rl: %d\n", __func__, status,
             dev->tx_count, dev->rx_count, dev->tx_len, dev->rx_len);
     MMIO_REG_VAL_FROM_BASE(dev->reg_base, IMR) = 0;
-    MMIO_REG_VAL_FROM_BASE(dev->reg_base, IMR) = SPI_ENABLE_INT;
+    MMIO_REG_VAL_FROM_BASE(dev->reg_base, IMR) = spi_imr(dev);
 }
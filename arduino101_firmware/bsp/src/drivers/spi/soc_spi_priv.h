@@ -44,9 +44,11 @@
 
 #include "drivers/data_type.h"
 
-/* SPI software configs */
-#define     SPI_TX_FIFO_THRESHOLD       (7)
-#define     SPI_RX_FIFO_THRESHOLD       (0)
+/* SPI software configs: the FIFOs of transfers longer than the FIFO depth
+ * are refilled and drained in bursts, the transfer stalls if the interrupt
+ * is taken more than 3 frames late */
+#define     SPI_TX_FIFO_THRESHOLD       (3)
+#define     SPI_RX_FIFO_THRESHOLD       (3)
 
 /* SPI FIFO Size */
 #define     IO_SPI_MST0_FS              (8)
@@ -101,6 +103,8 @@
 #define     SPI_TXE                     (0x1 << 5)          /* Transmission Error */
 #define     SPI_SLAVE_OD                (0x1 << 10)         /* Slave output disable */
 #define     SPI_SLAVE_OE                ~(SPI_SLAVE_OD)     /* Slave output enable */
+#define     SPI_TMOD_SHIFT              (8)                 /* Transfer mode field of CTRL0 */
+#define     SPI_TMOD_MASK               (0x3 << SPI_TMOD_SHIFT)
 
 #define     ENABLE_SOC_SPI_INTERRUPTS   (~0x1 << 8)
 #define     ENABLE_SPI_MASTER_0         (0x1 << 14)
@@ -164,9 +168,13 @@ typedef struct soc_spi_info_struct
     uint16_t *      rx_buf_16;
     uint8_t         state;
     uint8_t         mode;
+    uint8_t         tmod;       /* Transfer mode of the current transfer */
     uint8_t         cs_gpio;
+    uint8_t         cs_hold;    /* Keep the chip select asserted at the end of transfers */
+    uint8_t         cs_held;    /* The chip select was left asserted */
     uint8_t         instID;
     uint8_t         full_duplex;
+    uint8_t         rx_threshold; /* RX FIFO threshold of the current transfer */
     SLAVE_FULL_DUPLEX_ORDER fd_order;
     /* Data frame Size */
     uint8_t         dfs;
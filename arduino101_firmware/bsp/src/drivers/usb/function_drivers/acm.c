@@ -562,9 +562,6 @@ int acm_read(int idx, uint8_t * buffer, int len,
 	     void (*xfer_done)(int actual, void *data), void *data)
 {
 	int ret;
-	if (!list_empty(&acm_read_requests[idx])) {
-		return DRV_RC_BUSY;
-	}
 	struct acm_request * req = (struct acm_request *)balloc(sizeof(*req), NULL);
 	int flags = interrupt_lock();
 	req->state = STATE_READY;
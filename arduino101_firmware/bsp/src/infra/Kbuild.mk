@@ -7,6 +7,7 @@ obj-$(CONFIG_TCMD) += tcmd/
 obj-$(CONFIG_TCMD) += log_tcmd.o
 obj-$(CONFIG_TCMD) += panic_tcmd.o
 obj-$(CONFIG_FACTORY_DATA) += factory_data.o
+obj-$(CONFIG_FLASH_STORE) += flash_store.o
 obj-$(CONFIG_LOG) += log.o
 obj-$(CONFIG_LOG) += log_impl.o
 obj-$(CONFIG_VERSION) += version.o
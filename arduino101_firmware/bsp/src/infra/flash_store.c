@@ -0,0 +1,820 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "infra/flash_store.h"
+#ifdef CONFIG_SPI_FLASH_INTEL_QRK
+#include "drivers/spi_flash.h"
+#endif
+#ifdef CONFIG_SOC_FLASH
+#include "drivers/soc_flash.h"
+#include "quark_se_mapping.h"
+#endif
+
+/*
+ * Flash layout
+ *
+ * Each sector starts with a sector_header. A free sector has its magic and
+ * erase count programmed and its sequence number left erased. The sequence
+ * number is programmed when the sector becomes the head of the log: the
+ * order of the used sectors in the log is the order of their sequence
+ * numbers.
+ *
+ * Records follow the header, 4 bytes aligned. The last record of a key in
+ * log order is its current value, or a deletion. A record ends the sector
+ * when its header is erased or when its CRC does not match.
+ */
+
+#define FLASH_STORE_MAGIC       0x31534c46 /* "FLS1" */
+#define FLASH_STORE_FREE_SEQ    0xffffffff
+#define FLASH_STORE_DELETED     0xffff
+#define FLASH_STORE_NO_SECTOR   0xffff
+#define FLASH_STORE_NO_ADDR     0xffffffff
+#define FLASH_STORE_NO_COUNT    0xffffffff
+
+/* Free sectors below which flash_store_gc() reclaims one */
+#define FLASH_STORE_GC_FREE     3
+/* Erase count gap above which the collector moves cold data */
+#define FLASH_STORE_WEAR_DELTA  16
+
+#define REC_VALUE   0x5a
+#define REC_DELETE  0xa5
+
+struct sector_header {
+    uint32_t magic;
+    uint32_t erase_count;
+    uint32_t seq;
+    uint32_t reserved;
+};
+
+struct record_header {
+    uint16_t key;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t len;
+    uint16_t crc;       /* CRC of the fields above and of the value */
+};
+
+#define SECTOR_HDR_SIZE     sizeof(struct sector_header)
+#define REC_SIZE(len)       ((sizeof(struct record_header) + (len) + 3) & ~3)
+#define ENTRY_SIZE(len)     REC_SIZE((len) == FLASH_STORE_DELETED ? 0 : (len))
+#define SECTOR_ADDR(fs, s)  ((fs)->base + (uint32_t)(s) * (fs)->sector_size)
+#define SECTOR_OF(fs, a)    (((a) - (fs)->base) / (fs)->sector_size)
+#define IS_FREE(fs, s)      ((fs)->sectors[s].seq == FLASH_STORE_FREE_SEQ)
+
+/* Copy chunk size, on the stack */
+#define CHUNK_SIZE          32
+
+static const uint16_t crc16_tab[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+/* CRC-16/CCITT, one nibble at a time */
+static uint16_t crc16(uint16_t crc, const uint8_t *p, unsigned int len)
+{
+    while (len--) {
+        crc = (crc << 4) ^ crc16_tab[(crc >> 12) ^ (*p >> 4)];
+        crc = (crc << 4) ^ crc16_tab[(crc >> 12) ^ (*p++ & 0x0f)];
+    }
+    return crc;
+}
+
+/*
+ * Flash access
+ */
+
+static int fs_read(struct flash_store *fs, uint32_t addr, void *buf, unsigned int len)
+{
+    uint32_t start = fs->wbuf_addr + fs->wbuf_flushed;
+    uint32_t end = fs->wbuf_addr + fs->wbuf_fill;
+    uint8_t *p = buf;
+    unsigned int n;
+
+    // The end of the log that is not programmed yet is only in wbuf
+    if (addr + len <= start || addr >= end) {
+        return fs->ops->read(fs, addr, buf, len) ? -EIO : 0;
+    }
+    if (addr < start) {
+        n = start - addr;
+        if (fs->ops->read(fs, addr, p, n)) {
+            return -EIO;
+        }
+        addr += n;
+        p += n;
+        len -= n;
+    }
+    memcpy(p, &fs->wbuf[addr - fs->wbuf_addr], len);
+    return 0;
+}
+
+static int fs_program(struct flash_store *fs, uint32_t addr, const void *buf, unsigned int len)
+{
+    fs->stat_flash_bytes += len;
+    return fs->ops->program(fs, addr, buf, len) ? -EIO : 0;
+}
+
+static int fs_is_erased(struct flash_store *fs, uint32_t addr, unsigned int len)
+{
+    uint32_t buf[CHUNK_SIZE / 4];
+    unsigned int n, i;
+
+    for (; len; addr += n, len -= n) {
+        n = len < CHUNK_SIZE ? len : CHUNK_SIZE;
+        if (fs_read(fs, addr, buf, n)) {
+            return -EIO;
+        }
+        for (i = 0; i < n / 4; i++) {
+            if (buf[i] != 0xffffffff) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Erase a sector and make it free */
+static int fs_format(struct flash_store *fs, uint16_t s, uint32_t erase_count)
+{
+    struct sector_header hdr = {
+        .magic = FLASH_STORE_MAGIC,
+        .erase_count = erase_count + 1,
+    };
+
+    if (fs->ops->erase(fs, SECTOR_ADDR(fs, s))) {
+        return -EIO;
+    }
+    fs->stat_erases++;
+    fs->sectors[s].seq = FLASH_STORE_FREE_SEQ;
+    fs->sectors[s].erase_count = hdr.erase_count;
+    fs->sectors[s].live = 0;
+    fs->free_count++;
+    // Program the magic and erase count only, seq is set on first use
+    return fs_program(fs, SECTOR_ADDR(fs, s), &hdr, offsetof(struct sector_header, seq));
+}
+
+/*
+ * Write-combining buffer
+ */
+
+static void fs_wbuf_set(struct flash_store *fs, uint32_t addr)
+{
+    fs->wbuf_addr = addr & ~(FLASH_STORE_PAGE_SIZE - 1);
+    fs->wbuf_fill = fs->wbuf_flushed = addr - fs->wbuf_addr;
+    memset(fs->wbuf, 0xff, sizeof(fs->wbuf));
+}
+
+static int fs_flush(struct flash_store *fs)
+{
+    unsigned int n = fs->wbuf_fill - fs->wbuf_flushed;
+
+    if (n == 0) {
+        return 0;
+    }
+    if (fs_program(fs, fs->wbuf_addr + fs->wbuf_flushed, &fs->wbuf[fs->wbuf_flushed], n)) {
+        return -EIO;
+    }
+    fs->wbuf_flushed = fs->wbuf_fill;
+    return 0;
+}
+
+/* Append data at the end of the log, programming each page once complete */
+static int fs_put(struct flash_store *fs, const void *data, unsigned int len)
+{
+    const uint8_t *p = data;
+    unsigned int n;
+    int ret;
+
+    while (len) {
+        n = FLASH_STORE_PAGE_SIZE - fs->wbuf_fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&fs->wbuf[fs->wbuf_fill], p, n);
+        fs->wbuf_fill += n;
+        fs->head_off += n;
+        p += n;
+        len -= n;
+        if (fs->wbuf_fill == FLASH_STORE_PAGE_SIZE) {
+            if ((ret = fs_flush(fs)) != 0) {
+                return ret;
+            }
+            fs_wbuf_set(fs, fs->wbuf_addr + FLASH_STORE_PAGE_SIZE);
+        }
+    }
+    return 0;
+}
+
+/*
+ * RAM index, sorted by key
+ */
+
+static struct flash_store_entry *fs_find(struct flash_store *fs, uint16_t key, int *pos)
+{
+    int lo = 0, hi = fs->key_count, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (fs->index[mid].key == key) {
+            return &fs->index[mid];
+        }
+        if (fs->index[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (pos) {
+        *pos = lo;
+    }
+    return NULL;
+}
+
+static struct flash_store_entry *fs_insert(struct flash_store *fs, uint16_t key, int pos)
+{
+    struct flash_store_entry *e = &fs->index[pos];
+
+    if (fs->key_count == fs->max_keys) {
+        return NULL;
+    }
+    memmove(e + 1, e, (fs->key_count - pos) * sizeof(*e));
+    fs->key_count++;
+    e->key = key;
+    e->len = 0;
+    e->addr = FLASH_STORE_NO_ADDR;
+    return e;
+}
+
+static void fs_remove(struct flash_store *fs, struct flash_store_entry *e)
+{
+    fs->sectors[SECTOR_OF(fs, e->addr)].live -= ENTRY_SIZE(e->len);
+    fs->key_count--;
+    memmove(e, e + 1, (&fs->index[fs->key_count] - e) * sizeof(*e));
+}
+
+/* Make e point to the record at addr, and account for live data */
+static void fs_set_entry(struct flash_store *fs, struct flash_store_entry *e,
+                         uint16_t len, uint32_t addr)
+{
+    if (e->addr != FLASH_STORE_NO_ADDR) {
+        fs->sectors[SECTOR_OF(fs, e->addr)].live -= ENTRY_SIZE(e->len);
+    }
+    e->len = len;
+    e->addr = addr;
+    fs->sectors[SECTOR_OF(fs, addr)].live += ENTRY_SIZE(len);
+}
+
+/*
+ * Log management
+ */
+
+/* Make the least erased free sector the head of the log */
+static int fs_open_sector(struct flash_store *fs)
+{
+    uint16_t s, best = FLASH_STORE_NO_SECTOR;
+    uint32_t seq = fs->seq + 1;
+
+    for (s = 0; s < fs->sector_count; s++) {
+        if (IS_FREE(fs, s) && (best == FLASH_STORE_NO_SECTOR ||
+            fs->sectors[s].erase_count < fs->sectors[best].erase_count)) {
+            best = s;
+        }
+    }
+    if (best == FLASH_STORE_NO_SECTOR) {
+        return -ENOSPC;
+    }
+    if (fs_program(fs, SECTOR_ADDR(fs, best) + offsetof(struct sector_header, seq), &seq, sizeof(seq))) {
+        return -EIO;
+    }
+    fs->sectors[best].seq = fs->seq = seq;
+    fs->free_count--;
+    fs->head = best;
+    fs->head_off = SECTOR_HDR_SIZE;
+    fs_wbuf_set(fs, SECTOR_ADDR(fs, best) + SECTOR_HDR_SIZE);
+    return 0;
+}
+
+static int fs_collect(struct flash_store *fs);
+
+/*
+ * Make room for size bytes in the head sector and return their address.
+ * Unless called by the collector, keep a free sector for it.
+ */
+static int fs_reserve(struct flash_store *fs, unsigned int size, bool gc, uint32_t *addr)
+{
+    unsigned int tries = 0;
+    int ret;
+
+    while (fs->head == FLASH_STORE_NO_SECTOR || fs->head_off + size > fs->sector_size) {
+        if (!gc && fs->free_count < 2) {
+            if (tries++ == fs->sector_count) {
+                return -ENOSPC;
+            }
+            if ((ret = fs_collect(fs)) < 0) {
+                return ret;
+            }
+            continue;
+        }
+        if ((ret = fs_flush(fs)) != 0 || (ret = fs_open_sector(fs)) != 0) {
+            return ret;
+        }
+    }
+    *addr = SECTOR_ADDR(fs, fs->head) + fs->head_off;
+    return 0;
+}
+
+/* Copy the record of e to the head of the log */
+static int fs_move(struct flash_store *fs, struct flash_store_entry *e)
+{
+    uint32_t buf[CHUNK_SIZE / 4];
+    unsigned int size = ENTRY_SIZE(e->len);
+    unsigned int off, n;
+    uint32_t addr;
+    int ret;
+
+    if ((ret = fs_reserve(fs, size, true, &addr)) != 0) {
+        return ret;
+    }
+    for (off = 0; off < size; off += n) {
+        n = size - off < CHUNK_SIZE ? size - off : CHUNK_SIZE;
+        if (fs_read(fs, e->addr + off, buf, n) || (ret = fs_put(fs, buf, n)) != 0) {
+            return ret ? ret : -EIO;
+        }
+    }
+    fs_set_entry(fs, e, e->len, addr);
+    return 0;
+}
+
+/* Check the header and the CRC of the record at addr */
+static int fs_check_record(struct flash_store *fs, uint32_t addr, struct record_header *rec)
+{
+    uint32_t buf[CHUNK_SIZE / 4];
+    uint32_t off = (addr - fs->base) % fs->sector_size;
+    uint16_t crc;
+    unsigned int len, n;
+
+    if (rec->key == FLASH_STORE_INVALID_KEY ||
+        (rec->type != REC_VALUE && rec->type != REC_DELETE) ||
+        (rec->type == REC_DELETE && rec->len != 0) ||
+        off + REC_SIZE(rec->len) > fs->sector_size) {
+        return -EBADMSG;
+    }
+    crc = crc16(0xffff, (uint8_t *)rec, offsetof(struct record_header, crc));
+    addr += sizeof(*rec);
+    for (len = rec->len; len; len -= n, addr += n) {
+        n = len < CHUNK_SIZE ? len : CHUNK_SIZE;
+        if (fs_read(fs, addr, buf, n)) {
+            return -EIO;
+        }
+        crc = crc16(crc, (uint8_t *)buf, n);
+    }
+    return crc == rec->crc ? 0 : -EBADMSG;
+}
+
+/*
+ * Pick the sector to reclaim: the one with the least live data, or the least
+ * erased one when its wear lags behind. The oldest sector is preferred on
+ * ties as it is the only one where deletions can be dropped.
+ */
+static uint16_t fs_pick_victim(struct flash_store *fs, bool *wear)
+{
+    uint16_t s, victim = FLASH_STORE_NO_SECTOR;
+    uint16_t oldest = FLASH_STORE_NO_SECTOR, coldest = FLASH_STORE_NO_SECTOR;
+    uint32_t max_erase = 0;
+    struct flash_store_sector *sec = fs->sectors;
+
+    for (s = 0; s < fs->sector_count; s++) {
+        if (sec[s].erase_count > max_erase) {
+            max_erase = sec[s].erase_count;
+        }
+        if (IS_FREE(fs, s) || s == fs->head) {
+            continue;
+        }
+        if (oldest == FLASH_STORE_NO_SECTOR || sec[s].seq < sec[oldest].seq) {
+            oldest = s;
+        }
+        if (coldest == FLASH_STORE_NO_SECTOR || sec[s].erase_count < sec[coldest].erase_count) {
+            coldest = s;
+        }
+        if (victim == FLASH_STORE_NO_SECTOR || sec[s].live < sec[victim].live) {
+            victim = s;
+        }
+    }
+    *wear = false;
+    if (victim == FLASH_STORE_NO_SECTOR) {
+        return victim;
+    }
+    // Moving a full sector needs a free sector besides the reserved one
+    if (max_erase - sec[coldest].erase_count > FLASH_STORE_WEAR_DELTA && fs->free_count >= 2) {
+        *wear = true;
+        return coldest;
+    }
+    return sec[victim].live == sec[oldest].live ? oldest : victim;
+}
+
+/* Reclaim a sector, return 1 on success */
+static int fs_collect(struct flash_store *fs)
+{
+    struct record_header rec;
+    struct flash_store_entry *e;
+    uint16_t victim, s;
+    uint32_t addr, off;
+    bool wear, oldest = true;
+    int ret;
+
+    if ((victim = fs_pick_victim(fs, &wear)) == FLASH_STORE_NO_SECTOR) {
+        return -ENOSPC;
+    }
+    if (!wear && fs->sectors[victim].live + SECTOR_HDR_SIZE >= fs->sector_size) {
+        // Nothing to gain
+        return -ENOSPC;
+    }
+    for (s = 0; s < fs->sector_count; s++) {
+        if (!IS_FREE(fs, s) && fs->sectors[s].seq < fs->sectors[victim].seq) {
+            oldest = false;
+        }
+    }
+
+    // Move the current records out of the sector
+    addr = SECTOR_ADDR(fs, victim);
+    for (off = SECTOR_HDR_SIZE; fs->sectors[victim].live && off + sizeof(rec) <= fs->sector_size;
+         off += REC_SIZE(rec.len)) {
+        if (fs_read(fs, addr + off, &rec, sizeof(rec))) {
+            return -EIO;
+        }
+        if (rec.key == FLASH_STORE_INVALID_KEY) {
+            break;
+        }
+        if ((e = fs_find(fs, rec.key, NULL)) == NULL || e->addr != addr + off) {
+            continue;
+        }
+        // Nothing older can be shadowed by a deletion in the oldest sector
+        if (e->len == FLASH_STORE_DELETED && oldest) {
+            fs_remove(fs, e);
+        } else if ((ret = fs_move(fs, e)) != 0) {
+            return ret;
+        }
+    }
+
+    // The moved records must be on flash before their sector is erased
+    if ((ret = fs_flush(fs)) != 0 || (ret = fs_format(fs, victim, fs->sectors[victim].erase_count)) != 0) {
+        return ret;
+    }
+    return 1;
+}
+
+/* Index the records of a sector, return the offset where they end */
+static int fs_scan(struct flash_store *fs, uint16_t s, uint32_t *end)
+{
+    struct record_header rec;
+    struct flash_store_entry *e;
+    uint32_t addr = SECTOR_ADDR(fs, s);
+    uint32_t off;
+    int pos, ret;
+
+    for (off = SECTOR_HDR_SIZE; off + sizeof(rec) <= fs->sector_size; off += REC_SIZE(rec.len)) {
+        if (fs_read(fs, addr + off, &rec, sizeof(rec))) {
+            return -EIO;
+        }
+        if ((ret = fs_check_record(fs, addr + off, &rec)) == -EIO) {
+            return ret;
+        } else if (ret) {
+            // Erased or torn
+            break;
+        }
+        if ((e = fs_find(fs, rec.key, &pos)) == NULL &&
+            (e = fs_insert(fs, rec.key, pos)) == NULL) {
+            return -ENOMEM;
+        }
+        fs_set_entry(fs, e, rec.type == REC_DELETE ? FLASH_STORE_DELETED : rec.len, addr + off);
+    }
+    *end = off;
+    return 0;
+}
+
+static int fs_append(struct flash_store *fs, uint16_t key, uint8_t type,
+                     const void *data, unsigned int len, uint32_t *addr)
+{
+    struct record_header rec = {
+        .key = key,
+        .type = type,
+        .reserved = 0xff,
+        .len = len,
+    };
+    uint32_t pad = 0xffffffff;
+    int ret;
+
+    if ((ret = fs_reserve(fs, REC_SIZE(len), false, addr)) != 0) {
+        return ret;
+    }
+    rec.crc = crc16(crc16(0xffff, (uint8_t *)&rec, offsetof(struct record_header, crc)), data, len);
+    if ((ret = fs_put(fs, &rec, sizeof(rec))) != 0 ||
+        (ret = fs_put(fs, data, len)) != 0) {
+        return ret;
+    }
+    fs->stat_user_bytes += len;
+    return fs_put(fs, &pad, REC_SIZE(len) - sizeof(rec) - len);
+}
+
+/*
+ * API
+ */
+
+int flash_store_mount(struct flash_store *fs)
+{
+    struct sector_header hdr;
+    uint16_t *order;
+    uint16_t used = 0, s, i;
+    uint32_t max_erase = 0, end;
+    int ret = -EIO;
+
+    if (fs->ops == NULL || fs->sector_count < 3 || fs->max_keys == 0 ||
+        fs->sector_size % FLASH_STORE_PAGE_SIZE || fs->sector_size > 0x10000 ||
+        fs->base % FLASH_STORE_PAGE_SIZE) {
+        return -EINVAL;
+    }
+    // A sector is erased as a whole number of device erase units
+    if (fs->ops->erase_size(fs, &fs->erase_size)) {
+        return -EIO;
+    }
+    if (fs->erase_size == 0 || fs->sector_size % fs->erase_size ||
+        fs->base % fs->erase_size) {
+        return -EINVAL;
+    }
+    fs->sectors = balloc(fs->sector_count * sizeof(*fs->sectors), NULL);
+    fs->index = balloc(fs->max_keys * sizeof(*fs->index), NULL);
+    order = balloc(fs->sector_count * sizeof(*order), NULL);
+    if (fs->sectors == NULL || fs->index == NULL || order == NULL) {
+        ret = -ENOMEM;
+        goto exit;
+    }
+    fs->stat_user_bytes = fs->stat_flash_bytes = fs->stat_erases = 0;
+    fs->key_count = fs->free_count = 0;
+    fs->head = FLASH_STORE_NO_SECTOR;
+    fs->head_off = 0;
+    fs->seq = 0;
+    fs->wbuf_addr = fs->wbuf_fill = fs->wbuf_flushed = 0;
+
+    // Sort the used sectors in log order
+    for (s = 0; s < fs->sector_count; s++) {
+        if (fs->ops->read(fs, SECTOR_ADDR(fs, s), &hdr, sizeof(hdr))) {
+            goto exit;
+        }
+        fs->sectors[s].live = 0;
+        if (hdr.magic != FLASH_STORE_MAGIC) {
+            // Not formatted, or its erase was interrupted
+            fs->sectors[s].seq = FLASH_STORE_FREE_SEQ;
+            fs->sectors[s].erase_count = FLASH_STORE_NO_COUNT;
+            continue;
+        }
+        fs->sectors[s].seq = hdr.seq;
+        fs->sectors[s].erase_count = hdr.erase_count;
+        if (hdr.erase_count > max_erase) {
+            max_erase = hdr.erase_count;
+        }
+        if (hdr.seq == FLASH_STORE_FREE_SEQ) {
+            fs->free_count++;
+            continue;
+        }
+        for (i = used++; i > 0 && fs->sectors[order[i - 1]].seq > hdr.seq; i--) {
+            order[i] = order[i - 1];
+        }
+        order[i] = s;
+        if (hdr.seq > fs->seq) {
+            fs->seq = hdr.seq;
+        }
+    }
+
+    // Format the sectors that are not part of the store
+    for (s = 0; s < fs->sector_count; s++) {
+        if (fs->sectors[s].erase_count == FLASH_STORE_NO_COUNT &&
+            (ret = fs_format(fs, s, max_erase)) != 0) {
+            goto exit;
+        }
+    }
+
+    // Replay the log
+    for (i = 0; i < used; i++) {
+        if ((ret = fs_scan(fs, order[i], &end)) != 0) {
+            goto exit;
+        }
+    }
+    if (used) {
+        // Append after the last record, unless something was half programmed
+        fs->head = order[used - 1];
+        fs->head_off = end;
+        if ((ret = fs_is_erased(fs, SECTOR_ADDR(fs, fs->head) + end, fs->sector_size - end)) < 0) {
+            goto exit;
+        } else if (ret == 0) {
+            fs->head_off = fs->sector_size;
+        }
+        fs_wbuf_set(fs, SECTOR_ADDR(fs, fs->head) + fs->head_off);
+    }
+    ret = 0;
+
+exit:
+    bfree(order);
+    if (ret) {
+        bfree(fs->index);
+        bfree(fs->sectors);
+        fs->index = NULL;
+        fs->sectors = NULL;
+    }
+    return ret;
+}
+
+int flash_store_write(struct flash_store *fs, uint16_t key, const void *data,
+                      unsigned int len)
+{
+    struct flash_store_entry *e;
+    uint32_t addr;
+    int pos, ret;
+
+    if (key == FLASH_STORE_INVALID_KEY ||
+        len > fs->sector_size - SECTOR_HDR_SIZE - sizeof(struct record_header)) {
+        return -EINVAL;
+    }
+    if (fs_find(fs, key, NULL) == NULL && fs->key_count == fs->max_keys) {
+        return -ENOMEM;
+    }
+    if ((ret = fs_append(fs, key, REC_VALUE, data, len, &addr)) != 0) {
+        return ret;
+    }
+    // The collector may have changed the index
+    if ((e = fs_find(fs, key, &pos)) == NULL) {
+        e = fs_insert(fs, key, pos);
+    }
+    fs_set_entry(fs, e, len, addr);
+    return 0;
+}
+
+int flash_store_read(struct flash_store *fs, uint16_t key, void *data,
+                     unsigned int len)
+{
+    struct flash_store_entry *e = fs_find(fs, key, NULL);
+
+    if (e == NULL || e->len == FLASH_STORE_DELETED) {
+        return -ENOENT;
+    }
+    if (len > e->len) {
+        len = e->len;
+    }
+    if (fs_read(fs, e->addr + sizeof(struct record_header), data, len)) {
+        return -EIO;
+    }
+    return e->len;
+}
+
+int flash_store_delete(struct flash_store *fs, uint16_t key)
+{
+    struct flash_store_entry *e = fs_find(fs, key, NULL);
+    uint32_t addr;
+    int ret;
+
+    if (e == NULL || e->len == FLASH_STORE_DELETED) {
+        return -ENOENT;
+    }
+    if ((ret = fs_append(fs, key, REC_DELETE, NULL, 0, &addr)) != 0) {
+        return ret;
+    }
+    fs_set_entry(fs, fs_find(fs, key, NULL), FLASH_STORE_DELETED, addr);
+    return 0;
+}
+
+int flash_store_sync(struct flash_store *fs)
+{
+    return fs_flush(fs);
+}
+
+int flash_store_gc(struct flash_store *fs)
+{
+    if (fs->free_count >= FLASH_STORE_GC_FREE) {
+        return 0;
+    }
+    return fs_collect(fs);
+}
+
+/*
+ * Flash backends
+ */
+
+#ifdef CONFIG_SPI_FLASH_INTEL_QRK
+static int spi_store_read(struct flash_store *fs, uint32_t addr, void *buf, unsigned int len)
+{
+    unsigned int retlen;
+
+    return spi_flash_read_byte(fs->priv, addr, len, &retlen, buf) == DRV_RC_OK ? 0 : -EIO;
+}
+
+static int spi_store_program(struct flash_store *fs, uint32_t addr, const void *buf, unsigned int len)
+{
+    unsigned int retlen;
+
+    return spi_flash_write_byte(fs->priv, addr, len, &retlen, (uint8_t *)buf) == DRV_RC_OK ? 0 : -EIO;
+}
+
+static int spi_store_erase(struct flash_store *fs, uint32_t addr)
+{
+    return spi_flash_sector_erase(fs->priv, addr / fs->erase_size,
+                                  fs->sector_size / fs->erase_size) == DRV_RC_OK ? 0 : -EIO;
+}
+
+static int spi_store_erase_size(struct flash_store *fs, uint32_t *size)
+{
+    return spi_flash_ioctl(fs->priv, size, STORAGE_SECTOR_SIZE) == DRV_RC_OK ? 0 : -EIO;
+}
+
+const struct flash_store_ops flash_store_spi_ops = {
+    .read = spi_store_read,
+    .program = spi_store_program,
+    .erase = spi_store_erase,
+    .erase_size = spi_store_erase_size,
+};
+#endif
+
+#ifdef CONFIG_SOC_FLASH
+// The SOC flash is accessed by dwords, go through an aligned buffer
+static int soc_store_read(struct flash_store *fs, uint32_t addr, void *buf, unsigned int len)
+{
+    uint32_t words[CHUNK_SIZE / 4];
+    uint8_t *p = buf;
+    unsigned int n, skip, retlen;
+
+    for (; len; addr += n, p += n, len -= n) {
+        skip = addr & 3;
+        n = CHUNK_SIZE - skip < len ? CHUNK_SIZE - skip : len;
+        if (soc_flash_read(addr - skip, (skip + n + 3) / 4, &retlen, words) != DRV_RC_OK) {
+            return -EIO;
+        }
+        memcpy(p, (uint8_t *)words + skip, n);
+    }
+    return 0;
+}
+
+static int soc_store_program(struct flash_store *fs, uint32_t addr, const void *buf, unsigned int len)
+{
+    uint32_t words[CHUNK_SIZE / 4];
+    const uint8_t *p = buf;
+    unsigned int n, retlen;
+
+    for (; len; addr += n, p += n, len -= n) {
+        n = len < CHUNK_SIZE ? len : CHUNK_SIZE;
+        memcpy(words, p, n);
+        if (soc_flash_write(addr, n / 4, &retlen, words) != DRV_RC_OK) {
+            return -EIO;
+        }
+    }
+    return 0;
+}
+
+static int soc_store_erase(struct flash_store *fs, uint32_t addr)
+{
+    return soc_flash_block_erase(addr / fs->erase_size,
+                                 fs->sector_size / fs->erase_size) == DRV_RC_OK ? 0 : -EIO;
+}
+
+static int soc_store_erase_size(struct flash_store *fs, uint32_t *size)
+{
+    *size = EMBEDDED_FLASH_BLOCK_SIZE;
+    return 0;
+}
+
+const struct flash_store_ops flash_store_soc_ops = {
+    .read = soc_store_read,
+    .program = soc_store_program,
+    .erase = soc_store_erase,
+    .erase_size = soc_store_erase_size,
+};
+#endif
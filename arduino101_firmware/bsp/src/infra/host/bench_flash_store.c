@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark of flash_store.c on the RAM flash of flash_sim.c: random
+ * updates of small values, as settings or counters would be, stored
+ *  - in place, each update rewriting the 4 KiB sector holding them
+ *    (read, erase, program),
+ *  - in the store, synced after each update,
+ *  - in the store, synced every 16 updates.
+ *
+ * Write amplification is the bytes programmed to flash per byte of value
+ * updated. The simulated rate is the updates per second the W25Q16DV
+ * timings of flash_sim.h allow, the host rate is the cost of the store
+ * code alone, the RAM flash being free.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "flash_sim.h"
+
+#define KEYS        32
+#define UPDATES     20000
+#define SECTORS     8
+
+enum mode { IN_PLACE, SYNC_EACH, SYNC_16 };
+
+static const char *mode_names[] = { "sector rewrite", "store, sync each", "store, sync 16" };
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Update a value of the 4 KiB block at address 0 */
+static void update_in_place(unsigned int key, const uint8_t *value, unsigned int len)
+{
+    static uint8_t sector[4096];
+
+    flash_sim_ops.read(NULL, 0, sector, sizeof(sector));
+    memcpy(&sector[key * len], value, len);
+    flash_sim_erase(0, sizeof(sector));
+    flash_sim_ops.program(NULL, 0, sector, sizeof(sector));
+}
+
+static void run(enum mode mode, unsigned int len)
+{
+    struct flash_store fs = {
+        .ops = &flash_sim_ops,
+        .sector_size = 4096,
+        .sector_count = SECTORS,
+        .max_keys = KEYS,
+    };
+    struct flash_sim_stats start;
+    uint8_t value[128];
+    uint32_t seed = 1, max = 0, min = 0xffffffff;
+    uint64_t t0, t1;
+    unsigned int i, key;
+
+    flash_sim_init();
+    if (mode != IN_PLACE && flash_store_mount(&fs)) {
+        printf("mount failed\n");
+        return;
+    }
+    // Not counted: the first value of each key
+    for (key = 0; key < KEYS; key++) {
+        memset(value, key, len);
+        if (mode == IN_PLACE) {
+            update_in_place(key, value, len);
+        } else {
+            flash_store_write(&fs, key, value, len);
+        }
+    }
+    if (mode != IN_PLACE) {
+        flash_store_sync(&fs);
+    }
+    start = flash_sim_stats;
+
+    t0 = now_ns();
+    for (i = 0; i < UPDATES; i++) {
+        seed = seed * 1103515245 + 12345;
+        key = (seed >> 16) % KEYS;
+        memcpy(value, &i, sizeof(i));
+        if (mode == IN_PLACE) {
+            update_in_place(key, value, len);
+            continue;
+        }
+        if (flash_store_write(&fs, key, value, len)) {
+            printf("write failed\n");
+            return;
+        }
+        if (mode == SYNC_EACH || i % 16 == 15) {
+            flash_store_sync(&fs);
+        }
+        // The low priority collection of the firmware
+        if (i % 16 == 15) {
+            flash_store_gc(&fs);
+        }
+    }
+    t1 = now_ns();
+
+    for (i = 0; i < SECTORS; i++) {
+        if (flash_sim_erase_count[i] > max) {
+            max = flash_sim_erase_count[i];
+        }
+        if (flash_sim_erase_count[i] < min) {
+            min = flash_sim_erase_count[i];
+        }
+    }
+    printf("%-18s %5u %8.2f %10.1f %10.1f %12.0f %7u/%u\n", mode_names[mode], len,
+           (double)(flash_sim_stats.program_bytes - start.program_bytes) / ((uint64_t)UPDATES * len),
+           (flash_sim_stats.erases - start.erases) * 1000.0 / UPDATES,
+           UPDATES * 1e6 / (flash_sim_stats.busy_us - start.busy_us),
+           UPDATES * 1e9 / (t1 - t0), min, max);
+    free(fs.sectors);
+    free(fs.index);
+}
+
+int main(void)
+{
+    static const unsigned int lens[] = { 4, 16, 64, 120 };
+    unsigned int l;
+    enum mode mode;
+
+    printf("%u random updates of %u keys, store of %u sectors of 4 KiB\n\n",
+           UPDATES, KEYS, SECTORS);
+    printf("%-18s %5s %8s %10s %10s %12s %9s\n", "", "bytes", "write", "erases",
+           "sim", "host", "erases");
+    printf("%-18s %5s %8s %10s %10s %12s %9s\n", "", "", "ampl.", "/1000 op",
+           "ops/s", "ops/s", "min/max");
+    for (l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        for (mode = IN_PLACE; mode <= SYNC_16; mode++) {
+            run(mode, lens[l]);
+        }
+    }
+    return 0;
+}
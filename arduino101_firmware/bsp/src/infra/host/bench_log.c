@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark of log_impl_cbuffer.c built without and with
+ * CONFIG_LOG_CBUFFER_DEFERRED: cost of a log call, cost of the extraction
+ * of the message by the log task, and number of messages the log buffer
+ * holds, for messages of various formats.
+ */
+
+#include <stdio.h>
+#include "log_host.h"
+
+#define CALLS 1000000
+
+struct log_variant {
+    const char *name;
+    log_write_t write;
+    void (*flush)(void);
+    void (*init)(void);
+};
+
+#define DECLARE_LOG_VARIANT(v) \
+    extern uint32_t log_write_msg_##v(uint8_t level, uint8_t module, \
+                                      const char *format, va_list args); \
+    extern void log_flush_##v(void); \
+    extern void log_impl_init_##v(void);
+
+DECLARE_LOG_VARIANT(text)
+DECLARE_LOG_VARIANT(deferred)
+
+static const struct log_variant variants[] = {
+    { "text", log_write_msg_text, log_flush_text, log_impl_init_text },
+    { "deferred", log_write_msg_deferred, log_flush_deferred, log_impl_init_deferred },
+};
+
+static const char *formats[] = {
+    "boot done",
+    "conn %d: handle 0x%04x",
+    "spi%d: %u bytes in %u us, status %x",
+    "%d %d %d %d %d %d %d %d",
+    "name %s, id %d",
+};
+
+/* Logs formats[f] with arguments of the right types */
+static uint32_t log_format(const struct log_variant *v, unsigned int f)
+{
+    switch (f) {
+    case 0:
+        return log_host_printk(v->write, LOG_LEVEL_INFO, 0, formats[f]);
+    case 1:
+        return log_host_printk(v->write, LOG_LEVEL_INFO, 0, formats[f], 3, 0x42);
+    case 2:
+        return log_host_printk(v->write, LOG_LEVEL_INFO, 0, formats[f], 1, 4096, 1000, 0);
+    case 3:
+        return log_host_printk(v->write, LOG_LEVEL_INFO, 0, formats[f], 1, 2, 3, 4, 5, 6, 7, 8);
+    default:
+        return log_host_printk(v->write, LOG_LEVEL_INFO, 0, formats[f], "spi", 3);
+    }
+}
+
+static unsigned int outputs;
+
+static void count_output(const log_message_t *msg)
+{
+    outputs++;
+}
+
+int main(void)
+{
+    const struct log_variant *v;
+    unsigned int f, n, i;
+    uint64_t t0, call_ns, extract_ns;
+    uint32_t size;
+
+    log_host_output = count_output;
+    printf("%-36s %-8s %8s %8s %10s %9s\n", "format", "build", "ns/call",
+           "ns/read", "record B", "held");
+    for (f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        for (n = 0; n < sizeof(variants) / sizeof(variants[0]); n++) {
+            v = &variants[n];
+            v->init();
+
+            /* the buffer only ever holds one message, so nothing is dropped */
+            call_ns = extract_ns = 0;
+            for (i = 0; i < CALLS; i += 1000) {
+                unsigned int j;
+
+                t0 = now_ns();
+                for (j = 0; j < 1000; j++) {
+                    size = log_format(v, f);
+                    if (j % 16 == 15) {
+                        /* keep the write cost apart from the extraction cost */
+                        uint64_t t1 = now_ns();
+                        v->flush();
+                        extract_ns += now_ns() - t1;
+                        t0 += now_ns() - t1;
+                    }
+                }
+                call_ns += now_ns() - t0;
+                t0 = now_ns();
+                v->flush();
+                extract_ns += now_ns() - t0;
+            }
+
+            /* messages held by a full buffer */
+            outputs = 0;
+            for (i = 0; i < CONFIG_LOG_CBUFFER_SIZE; i++) {
+                log_format(v, f);
+            }
+            v->flush();
+
+            printf("%-36s %-8s %8.1f %8.1f %10u %9u\n", formats[f], v->name,
+                   (double)call_ns / CALLS, (double)extract_ns / CALLS,
+                   size + 1, outputs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * RAM flash of the flash_store.c host checks and benchmarks, and the OS
+ * services the store uses.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "os/os.h"
+#include "flash_sim.h"
+
+struct flash_sim_stats flash_sim_stats;
+uint8_t flash_sim_data[SIM_FLASH_SIZE];
+uint32_t flash_sim_erase_size = 4096;
+uint32_t flash_sim_erase_count[SIM_FLASH_SIZE / 4096];
+int32_t flash_sim_power_budget = -1;
+
+static int powered = 1;
+
+/* Time to shift len bytes on the SPI bus */
+static uint64_t bus_us(uint64_t len)
+{
+    return len * 8 * 1000 / SIM_SPI_KHZ;
+}
+
+static int sim_read(struct flash_store *fs, uint32_t addr, void *buf, unsigned int len)
+{
+    if (!powered || addr + len > SIM_FLASH_SIZE) {
+        return -EIO;
+    }
+    memcpy(buf, &flash_sim_data[addr], len);
+    flash_sim_stats.reads++;
+    flash_sim_stats.read_bytes += len;
+    flash_sim_stats.busy_us += bus_us(len);
+    return 0;
+}
+
+static int sim_program(struct flash_store *fs, uint32_t addr, const void *buf, unsigned int len)
+{
+    const uint8_t *p = buf;
+    unsigned int i, n;
+
+    if (!powered || addr + len > SIM_FLASH_SIZE) {
+        return -EIO;
+    }
+    if (addr % 4 || len % 4) {
+        flash_sim_stats.errors++;
+    }
+    // One page program command per page touched, as spi_flash_write_byte()
+    while (len) {
+        n = SIM_FLASH_PAGE - addr % SIM_FLASH_PAGE;
+        if (n > len) {
+            n = len;
+        }
+        flash_sim_stats.programs++;
+        flash_sim_stats.busy_us += SIM_PROGRAM_US + bus_us(n);
+        for (i = 0; i < n; i++, addr++, p++) {
+            if (flash_sim_power_budget == 0) {
+                powered = 0;
+                return -EIO;
+            }
+            if (flash_sim_power_budget > 0) {
+                flash_sim_power_budget--;
+            }
+            if (flash_sim_data[addr] != 0xff) {
+                flash_sim_stats.errors++;
+            }
+            flash_sim_data[addr] &= *p;
+        }
+        flash_sim_stats.program_bytes += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int flash_sim_erase(uint32_t addr, uint32_t len)
+{
+    if (!powered || addr + len > SIM_FLASH_SIZE) {
+        return -EIO;
+    }
+    if (addr % flash_sim_erase_size || len % flash_sim_erase_size) {
+        flash_sim_stats.errors++;
+        return -EIO;
+    }
+    memset(&flash_sim_data[addr], 0xff, len);
+    for (; len; addr += flash_sim_erase_size, len -= flash_sim_erase_size) {
+        flash_sim_erase_count[addr / 4096]++;
+        flash_sim_stats.erases++;
+        flash_sim_stats.busy_us += SIM_ERASE_US;
+    }
+    return 0;
+}
+
+static int sim_erase(struct flash_store *fs, uint32_t addr)
+{
+    return flash_sim_erase(addr, fs->sector_size);
+}
+
+static int sim_erase_size(struct flash_store *fs, uint32_t *size)
+{
+    *size = flash_sim_erase_size;
+    return 0;
+}
+
+const struct flash_store_ops flash_sim_ops = {
+    .read = sim_read,
+    .program = sim_program,
+    .erase = sim_erase,
+    .erase_size = sim_erase_size,
+};
+
+void flash_sim_init(void)
+{
+    memset(flash_sim_data, 0xff, sizeof(flash_sim_data));
+    memset(&flash_sim_stats, 0, sizeof(flash_sim_stats));
+    memset(flash_sim_erase_count, 0, sizeof(flash_sim_erase_count));
+    flash_sim_power_budget = -1;
+    powered = 1;
+}
+
+void flash_sim_power_on(void)
+{
+    flash_sim_power_budget = -1;
+    powered = 1;
+}
+
+/* OS layer */
+
+void *balloc(uint32_t size, OS_ERR_TYPE *err)
+{
+    return malloc(size);
+}
+
+OS_ERR_TYPE bfree(void *buffer)
+{
+    free(buffer);
+    return E_OS_OK;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * RAM flash for the host checks and benchmarks of flash_store.c.
+ *
+ * The flash behaves as a NOR flash: an erase sets a whole erase unit to
+ * 0xff, and a program can only clear bits. Programming a byte that is not
+ * erased, or an access that is not aligned as flash_store_ops requires, is
+ * counted as an error.
+ *
+ * The time the operations would take on the W25Q16DV of the board is
+ * accounted: a program takes SIM_PROGRAM_US per page it touches, an erase
+ * SIM_ERASE_US per erase unit, and the bytes read or programmed are shifted
+ * on the SPI bus at SIM_SPI_KHZ (the figures of the SPI flash model of
+ * drivers/mtd/host).
+ */
+
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+#include <stdint.h>
+#include "infra/flash_store.h"
+
+#define SIM_FLASH_SIZE      (128 * 1024)
+#define SIM_FLASH_PAGE      256
+#define SIM_SPI_KHZ         250
+#define SIM_PROGRAM_US      700
+#define SIM_ERASE_US        45000
+
+struct flash_sim_stats {
+    unsigned int reads;
+    unsigned int programs;      /* page program commands */
+    unsigned int erases;        /* erase units erased */
+    uint64_t read_bytes;
+    uint64_t program_bytes;
+    unsigned int errors;        /* dirty programs and misaligned accesses */
+    uint64_t busy_us;           /* time the flash operations take */
+};
+
+extern struct flash_sim_stats flash_sim_stats;
+
+/** Flash content */
+extern uint8_t flash_sim_data[SIM_FLASH_SIZE];
+
+/** Erase unit reported to the store, 4096 by default */
+extern uint32_t flash_sim_erase_size;
+
+/** Erase cycles of each 4 KiB of the flash */
+extern uint32_t flash_sim_erase_count[SIM_FLASH_SIZE / 4096];
+
+/**
+ * Bytes that can still be programmed before the power is cut, -1 for no
+ * power cut. Once the power is cut, the program in progress stops half way
+ * and all the operations fail until flash_sim_power_on().
+ */
+extern int32_t flash_sim_power_budget;
+
+/** Access functions of the RAM flash */
+extern const struct flash_store_ops flash_sim_ops;
+
+/**
+ * Erase the whole flash and reset the statistics and the erase counts.
+ */
+void flash_sim_init(void);
+
+/**
+ * Restore the power after a cut, keeping the flash content.
+ */
+void flash_sim_power_on(void);
+
+/**
+ * Erase len bytes from addr, aligned on the erase unit.
+ */
+int flash_sim_erase(uint32_t addr, uint32_t len);
+
+#endif /* __FLASH_SIM_H__ */
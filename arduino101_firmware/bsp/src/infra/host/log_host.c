@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Stubs of the platform services used by log_impl_cbuffer.c. The OS
+ * services are in log_host_os.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+/* The C library has POSIX timers of the same name as the os.h timers */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+#include "log_host.h"
+
+uint32_t log_host_uptime;
+void (*log_host_output)(const log_message_t *msg);
+
+uint32_t log_host_printk(log_write_t write, uint8_t level, uint8_t module,
+                         const char *format, ...)
+{
+    va_list args;
+    uint32_t ret;
+
+    va_start(args, format);
+    ret = write(level, module, format, args);
+    va_end(args);
+    return ret;
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t get_uptime_ms(void)
+{
+    return log_host_uptime;
+}
+
+void output_one_message(const log_message_t *msg)
+{
+    if (log_host_output) {
+        log_host_output(msg);
+    }
+}
+
+void panic(int err)
+{
+    printf("panic %d\n", err);
+    abort();
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Stubs of the OS and platform services used by log_impl_cbuffer.c on the
+ * host, without CONFIG_LOG_MULTI_CPU_SUPPORT.
+ */
+
+#ifndef __LOG_HOST_H__
+#define __LOG_HOST_H__
+
+#include <stdarg.h>
+#include <stdint.h>
+#include "os/os.h"
+#include "log_impl.h"
+
+/** Signature of log_write_msg(), of each build of log_impl_cbuffer.c */
+typedef uint32_t (*log_write_t)(uint8_t level, uint8_t module,
+                                const char *format, va_list args);
+
+/** Value returned by get_uptime_ms() */
+extern uint32_t log_host_uptime;
+
+/** Called by output_one_message() for each message extracted */
+extern void (*log_host_output)(const log_message_t *msg);
+
+/** Calls write as log_printk() calls log_write_msg() */
+uint32_t log_host_printk(log_write_t write, uint8_t level, uint8_t module,
+                         const char *format, ...);
+
+/** Monotonic host clock in ns */
+uint64_t now_ns(void);
+
+#endif /* __LOG_HOST_H__ */
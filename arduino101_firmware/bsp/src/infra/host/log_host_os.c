@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Interrupt lock and semaphores of the single threaded checks and
+ * benchmarks. Programs that run a simulated interrupt in another thread
+ * use the ones of the LINUX OS abstraction layer instead.
+ */
+
+#include <stddef.h>
+#include "log_host.h"
+
+uint32_t interrupt_lock(void)
+{
+    return 0;
+}
+
+void interrupt_unlock(uint32_t flags)
+{
+}
+
+T_SEMAPHORE semaphore_create(uint32_t initialCount, OS_ERR_TYPE *err)
+{
+    static int sem;
+
+    return &sem;
+}
+
+void semaphore_give(T_SEMAPHORE sem, OS_ERR_TYPE *err)
+{
+}
+
+OS_ERR_TYPE semaphore_take(T_SEMAPHORE sem, int timeout)
+{
+    return E_OS_ERR_TIMEOUT;
+}
+
+void error_management(OS_ERR_TYPE *err, OS_ERR_TYPE localErr)
+{
+    if (err != NULL) {
+        *err = localErr;
+    } else if (localErr != E_OS_OK) {
+        panic(localErr);
+    }
+}
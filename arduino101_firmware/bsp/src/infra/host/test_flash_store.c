@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks flash_store.c on the RAM flash of flash_sim.c:
+ *  - the sector geometry is checked against the erase unit of the device,
+ *  - values read back before and after a sync and a remount, deletions
+ *    persist,
+ *  - a power cut at any point of a write leaves, after a remount, each key
+ *    with a value that was written to it, at least the last synced one,
+ *  - the collector reclaims the sectors of overwritten values and levels
+ *    the wear of sectors holding cold data,
+ *  - nothing is programmed twice between erases.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flash_sim.h"
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static struct flash_store fs;
+
+static int mount(uint32_t base, uint32_t sector_size, uint16_t sector_count,
+                 uint16_t max_keys)
+{
+    free(fs.sectors);
+    free(fs.index);
+    memset(&fs, 0, sizeof(fs));
+    fs.ops = &flash_sim_ops;
+    fs.base = base;
+    fs.sector_size = sector_size;
+    fs.sector_count = sector_count;
+    fs.max_keys = max_keys;
+    return flash_store_mount(&fs);
+}
+
+static int remount(void)
+{
+    return mount(fs.base, fs.sector_size, fs.sector_count, fs.max_keys);
+}
+
+/* Value of a key at a version: the length and the bytes derive from both */
+static unsigned int make_value(uint16_t key, uint32_t version, uint8_t *buf)
+{
+    unsigned int len = 8 + (key * 13 + version * 7) % 120;
+    unsigned int i;
+
+    memcpy(buf, &version, 4);
+    for (i = 4; i < len; i++) {
+        buf[i] = key + version * 3 + i;
+    }
+    return len;
+}
+
+/* Return the version of the value of key, -1 if it is not a valid value */
+static int32_t value_version(uint16_t key)
+{
+    uint8_t buf[256], ref[256];
+    uint32_t version;
+    int len;
+
+    len = flash_store_read(&fs, key, buf, sizeof(buf));
+    if (len < 4) {
+        return -1;
+    }
+    memcpy(&version, buf, 4);
+    if ((unsigned int)len != make_value(key, version, ref) || memcmp(buf, ref, len)) {
+        return -1;
+    }
+    return version;
+}
+
+static void check_geometry(void)
+{
+    uint8_t buf[256];
+    unsigned int i;
+
+    flash_sim_init();
+    // A sector smaller than the 4 KiB erase unit of the SPI flash
+    CHECK(mount(0, 2048, 8, 16) == -EINVAL);
+    // Sectors that straddle two erase units
+    CHECK(mount(2048, 4096, 8, 16) == -EINVAL);
+    CHECK(flash_sim_stats.erases == 0);
+
+    // Sectors of two erase units are erased as a whole
+    CHECK(mount(0, 8192, 4, 16) == 0);
+    CHECK(flash_sim_stats.erases == 8);
+    for (i = 0; i < 500; i++) {
+        CHECK(flash_store_write(&fs, i % 4, buf, make_value(i % 4, i, buf)) == 0);
+    }
+    CHECK(flash_sim_stats.erases % 2 == 0 && fs.stat_erases * 2 == flash_sim_stats.erases);
+    for (i = 0; i < 4; i++) {
+        CHECK(value_version(i) == 496 + i);
+    }
+
+    // The 2 KiB pages of the SOC flash
+    flash_sim_init();
+    flash_sim_erase_size = 2048;
+    CHECK(mount(2048, 2048, 4, 16) == 0);
+    CHECK(flash_sim_stats.erases == 4);
+    flash_sim_erase_size = 4096;
+    CHECK(flash_sim_stats.errors == 0);
+}
+
+static void check_round_trip(void)
+{
+    uint8_t buf[256], small[4];
+    uint64_t programmed;
+    unsigned int i, len = 0;
+
+    flash_sim_init();
+    CHECK(mount(0, 4096, 8, 16) == 0);
+    CHECK(flash_store_read(&fs, 1, buf, sizeof(buf)) == -ENOENT);
+    CHECK(flash_store_write(&fs, FLASH_STORE_INVALID_KEY, buf, 4) == -EINVAL);
+    CHECK(flash_store_write(&fs, 1, buf, 4096) == -EINVAL);
+
+    // Read from the write-combining buffer
+    programmed = flash_sim_stats.program_bytes;
+    for (i = 0; i < 10; i++) {
+        len += make_value(i, 1, buf);
+        CHECK(flash_store_write(&fs, i, buf, make_value(i, 1, buf)) == 0);
+    }
+    CHECK(flash_sim_stats.program_bytes - programmed < len);
+    for (i = 0; i < 10; i++) {
+        CHECK(value_version(i) == 1);
+    }
+    CHECK(flash_store_read(&fs, 3, small, sizeof(small)) == (int)make_value(3, 1, buf));
+    CHECK(memcmp(small, buf, sizeof(small)) == 0);
+
+    CHECK(flash_store_delete(&fs, 3) == 0);
+    CHECK(flash_store_delete(&fs, 3) == -ENOENT);
+    CHECK(flash_store_write(&fs, 5, buf, make_value(5, 2, buf)) == 0);
+    CHECK(flash_store_sync(&fs) == 0);
+
+    CHECK(remount() == 0);
+    for (i = 0; i < 10; i++) {
+        CHECK(value_version(i) == (i == 3 ? -1 : i == 5 ? 2 : 1));
+    }
+    CHECK(flash_store_read(&fs, 3, buf, sizeof(buf)) == -ENOENT);
+    CHECK(flash_sim_stats.errors == 0);
+}
+
+/*
+ * Hot keys are written in turn and synced every few writes, until the power
+ * is cut after budget bytes programmed. After the remount, each key must
+ * hold a version between its last synced one and its last written one. The
+ * cold keys, written once, are moved by the collector.
+ */
+#define CUT_KEYS    12
+#define CUT_HOT     8
+
+static void power_cut(int32_t budget)
+{
+    uint32_t synced[CUT_KEYS], written[CUT_KEYS];
+    uint8_t buf[256];
+    uint32_t version;
+    int32_t v;
+    unsigned int i, key;
+
+    flash_sim_init();
+    CHECK(mount(0, 4096, 4, CUT_KEYS) == 0);
+    for (i = 0; i < CUT_KEYS; i++) {
+        CHECK(flash_store_write(&fs, i, buf, make_value(i, 0, buf)) == 0);
+        synced[i] = written[i] = 0;
+    }
+    CHECK(flash_store_sync(&fs) == 0);
+
+    flash_sim_power_budget = budget;
+    for (version = 1; ; version++) {
+        key = version * 5 % CUT_HOT;
+        written[key] = version;
+        if (flash_store_write(&fs, key, buf, make_value(key, version, buf))) {
+            break;
+        }
+        if (version % 4 == 0) {
+            if (flash_store_sync(&fs)) {
+                break;
+            }
+            memcpy(synced, written, sizeof(synced));
+        }
+    }
+
+    flash_sim_power_on();
+    CHECK(remount() == 0);
+    for (i = 0; i < CUT_KEYS; i++) {
+        v = value_version(i);
+        if (v < (int32_t)synced[i] || v > (int32_t)written[i]) {
+            printf("budget %d: key %u version %d not in [%u, %u]\n",
+                   budget, i, v, synced[i], written[i]);
+            failures++;
+        }
+    }
+
+    // The store goes on after the cut, without programming dirty bytes
+    for (i = 0; i < 200; i++) {
+        key = i % CUT_KEYS;
+        CHECK(flash_store_write(&fs, key, buf, make_value(key, version + i, buf)) == 0);
+    }
+    CHECK(flash_store_sync(&fs) == 0);
+    CHECK(remount() == 0);
+    for (i = 0; i < CUT_KEYS; i++) {
+        CHECK(value_version(i) >= (int32_t)(version + 188));
+    }
+    CHECK(flash_sim_stats.errors == 0);
+}
+
+/*
+ * The power is cut while flash_store_gc() reclaims the sector holding the
+ * cold keys: the records it moves must be programmed before it is erased.
+ */
+static void power_cut_gc(int32_t budget)
+{
+    uint32_t written[CUT_KEYS];
+    uint8_t buf[256];
+    uint32_t version;
+    unsigned int i, key;
+    int ret;
+
+    flash_sim_init();
+    CHECK(mount(0, 4096, 4, CUT_KEYS) == 0);
+    for (i = 0; i < CUT_KEYS; i++) {
+        CHECK(flash_store_write(&fs, i, buf, make_value(i, 0, buf)) == 0);
+        written[i] = 0;
+    }
+    for (version = 1; ; version++) {
+        key = version * 5 % CUT_HOT;
+        written[key] = version;
+        CHECK(flash_store_write(&fs, key, buf, make_value(key, version, buf)) == 0);
+        CHECK(flash_store_sync(&fs) == 0);
+        flash_sim_power_budget = budget;
+        if ((ret = flash_store_gc(&fs)) != 0) {
+            break;
+        }
+        flash_sim_power_budget = -1;
+    }
+    CHECK(ret == 1 || flash_sim_power_budget == 0);
+
+    flash_sim_power_on();
+    CHECK(remount() == 0);
+    for (i = 0; i < CUT_KEYS; i++) {
+        if (value_version(i) != (int32_t)written[i]) {
+            printf("gc budget %d: key %u version %d, not %u\n",
+                   budget, i, value_version(i), written[i]);
+            failures++;
+        }
+    }
+    CHECK(flash_sim_stats.errors == 0);
+}
+
+static void check_power_cut(void)
+{
+    int32_t budget;
+
+    // Through the first writes, then through collections
+    for (budget = 0; budget < 1024; budget += 4) {
+        power_cut(budget);
+        power_cut_gc(budget);
+    }
+    for (budget = 1024; budget < 128 * 1024; budget += 61) {
+        power_cut(budget);
+    }
+}
+
+/*
+ * A deletion is collected before the sector holding the value it deletes:
+ * it must be moved, or the value comes back at the next mount.
+ */
+static void check_delete_gc(void)
+{
+    static uint8_t big[3960];
+    uint8_t buf[256];
+    unsigned int i;
+
+    flash_sim_init();
+    CHECK(mount(0, 4096, 4, 4) == 0);
+    // Key 0 and the large value of key 1 fill sector 0
+    CHECK(flash_store_write(&fs, 0, buf, 100) == 0);
+    CHECK(flash_store_write(&fs, 1, big, sizeof(big)) == 0);
+    CHECK(flash_store_delete(&fs, 0) == 0);
+    CHECK(fs.head == 1);
+    // Overwritten values of key 2 fill sector 1, it has the least live data
+    for (i = 0; fs.head == 1; i++) {
+        CHECK(flash_store_write(&fs, 2, buf, make_value(2, i, buf)) == 0);
+    }
+    CHECK(flash_store_gc(&fs) == 1);
+    CHECK(flash_store_sync(&fs) == 0);
+    CHECK(remount() == 0);
+    CHECK(flash_store_read(&fs, 0, buf, sizeof(buf)) == -ENOENT);
+    CHECK(flash_store_read(&fs, 1, big, sizeof(big)) == sizeof(big));
+    CHECK(value_version(2) == (int32_t)i - 1);
+    CHECK(flash_sim_stats.errors == 0);
+}
+
+/*
+ * Cold keys fill a few sectors while a hot key is rewritten: the collector
+ * must keep finding free sectors, and move the cold data so that their
+ * sectors get erased too.
+ */
+static void check_gc_wear(void)
+{
+    uint8_t buf[256], big[2048];
+    uint32_t min = 0xffffffff, max = 0;
+    unsigned int i;
+
+    flash_sim_init();
+    CHECK(mount(0, 4096, 8, 64) == 0);
+    for (i = 1; i < 64; i++) {
+        CHECK(flash_store_write(&fs, i, buf, make_value(i, 0, buf)) == 0);
+    }
+    for (i = 1; i < 8; i++) {
+        CHECK(flash_store_delete(&fs, i) == 0);
+    }
+    for (i = 1; i <= 20000; i++) {
+        CHECK(flash_store_write(&fs, 0, buf, make_value(0, i, buf)) == 0);
+        if (i % 16 == 0) {
+            CHECK(flash_store_gc(&fs) >= 0);
+        }
+        if (i % 500 == 0) {
+            CHECK(flash_store_sync(&fs) == 0);
+            CHECK(remount() == 0);
+            CHECK(value_version(0) == i);
+            CHECK(flash_store_read(&fs, 1, buf, sizeof(buf)) == -ENOENT);
+        }
+    }
+    for (i = 1; i < 64; i++) {
+        CHECK(value_version(i) == (i < 8 ? -1 : 0));
+    }
+    for (i = 0; i < 8; i++) {
+        if (flash_sim_erase_count[i] < min) {
+            min = flash_sim_erase_count[i];
+        }
+        if (flash_sim_erase_count[i] > max) {
+            max = flash_sim_erase_count[i];
+        }
+    }
+    CHECK(min > 30 && max - min <= 24);
+    CHECK(flash_sim_stats.errors == 0);
+
+    // Grow the values until the store is full, the failed write is dropped
+    memset(big, 0x5a, sizeof(big));
+    for (i = 8; i < 64; i++) {
+        if (flash_store_write(&fs, i, big, sizeof(big)) != 0) {
+            break;
+        }
+    }
+    CHECK(i < 64 && flash_store_write(&fs, i, big, sizeof(big)) == -ENOSPC);
+    CHECK(flash_store_sync(&fs) == 0);
+CHECK(value_version(i) == 0 && value_version(0) == 20000);
+    CHECK(value_version(i) == 0 && value_version(0) == 20000);
+    CHECK(flash_store_read(&fs, 8, big, sizeof(big)) == sizeof(big));
+    CHECK(flash_sim_stats.errors == 0);
+}
+
+int main(void)
+{
+    check_geometry();
+    check_round_trip();
+    check_power_cut();
+    check_delete_gc();
+    check_gc_wear();
+
+    printf("%s test_flash_store\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
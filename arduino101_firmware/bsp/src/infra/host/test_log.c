@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks log_impl_cbuffer.c built with CONFIG_LOG_CBUFFER_DEFERRED:
+ *  - messages extracted from the log buffer have the text vsnprintf
+ *    gives, whether their formatting was deferred or not,
+ *  - deferred messages only store the format pointer and the argument
+ *    words,
+ *  - after filling the buffer past saturation, the memory of the program
+ *    is dumped to log_dump.bin with the lines the log task would output
+ *    in log_dump.txt, for tools/scripts/log/decode_log.py to be checked
+ *    against them (see the check target of the Makefile).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log_host.h"
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define HEADER_SIZE (sizeof(log_message_t) - LOG_MAX_MSG_LEN)
+
+static const char *module_names[] = {
+#define DEFINE_LOGGER_MODULE(_id, _name, ...) _name,
+#include "log_modules"
+#undef DEFINE_LOGGER_MODULE
+};
+
+static const char *level_names[] = { "ERROR", "WARN", "INFO", "DEBUG" };
+
+/* Formats of 32-bit arguments, stored as the format pointer and 8 words */
+static const struct {
+    const char *format;
+    int nargs;
+} deferred[] = {
+    { "boot done", 0 },
+    { "%d", 1 },
+    { "%u/%u bytes", 2 },
+    { "[%08x] %-5d| %+d", 3 },
+    { "%c%c%c", 3 },
+    { "%hd %hhu %hx", 3 },
+    { "%5.3d%%", 1 },
+    { "%*d|%-*x|", 4 },
+    { "%#o %#x %X", 3 },
+    { "%d %d %d %d %d %d %d %d", 8 },
+};
+
+static const uint32_t args[8] = {
+    0xfffffff6, 0x41, 0x8042, 0x7fffffff, 3, 0x80000000, 12345, 0xdeadbeef
+};
+
+/* Formats still formatted by the caller */
+static const char *immediate[] = {
+    "%s",
+    "%d %d %d %d %d %d %d %d %d",
+    "%lld",
+};
+
+static log_message_t last_msg;
+static unsigned int outputs;
+
+static void capture(const log_message_t *msg)
+{
+    last_msg = *msg;
+    outputs++;
+}
+
+static void check_message(const char *format, uint32_t expected_len)
+{
+    char expected[LOG_MAX_MSG_LEN];
+    uint32_t len;
+
+    snprintf(expected, sizeof(expected), format, args[0], args[1], args[2],
+             args[3], args[4], args[5], args[6], args[7], args[0]);
+    outputs = 0;
+    len = log_host_printk(log_write_msg, LOG_LEVEL_INFO, LOG_MODULE_MAIN,
+                          format, args[0], args[1], args[2], args[3],
+                          args[4], args[5], args[6], args[7], args[0]);
+    log_flush();
+
+    CHECK(outputs == 1);
+    CHECK(last_msg.buf_size == strlen(expected));
+    CHECK(memcmp(last_msg.buf, expected, last_msg.buf_size) == 0);
+    if (expected_len) {
+        CHECK(len == expected_len);
+    } else {
+        CHECK(len == HEADER_SIZE + strlen(expected));
+    }
+    if (failures) {
+        printf("\"%s\": \"%.*s\" instead of \"%s\"\n", format,
+               last_msg.buf_size, last_msg.buf, expected);
+    }
+}
+
+static void check_string(void)
+{
+    char text[] = "volatile";
+
+    outputs = 0;
+    log_host_printk(log_write_msg, LOG_LEVEL_INFO, LOG_MODULE_MAIN,
+                    "name %s", text);
+    /* the string is gone when the message is extracted */
+    strcpy(text, "changed");
+    log_flush();
+    CHECK(outputs == 1);
+    CHECK(last_msg.buf_size == strlen("name volatile"));
+    CHECK(memcmp(last_msg.buf, "name volatile", last_msg.buf_size) == 0);
+}
+
+/* Output of the log task, as decode_log.py prints it */
+static FILE *dump_text;
+
+static void write_line(const log_message_t *msg)
+{
+    if (msg->lost_messages_count) {
+        fprintf(dump_text, "-- %u log messages lost --\n",
+                msg->lost_messages_count);
+    }
+    fprintf(dump_text, "%9u|%3.3s|%8.8s|%5.5s| %.*s\n",
+            (unsigned int)msg->timestamp, "0", module_names[msg->module],
+            level_names[msg->level], msg->buf_size, msg->buf);
+}
+
+static void dump_buffer(void)
+{
+    extern char __data_start[], _end[];
+    FILE *f;
+    unsigned int i;
+
+    for (i = 0; i < 400; i++) {
+        log_host_uptime = i * 7;
+        if (i % 5 == 4) {
+            log_host_printk(log_write_msg, LOG_LEVEL_WARNING, i % 8,
+                            "text %s %d", "message", i);
+        } else {
+            log_host_printk(log_write_msg, i % 4, i % 8,
+                            deferred[i % 10].format, '0' + i % 64, args[1], args[2],
+                            args[3], args[4], args[5], args[6], args[7]);
+        }
+    }
+
+    f = fopen("log_dump.bin", "wb");
+    CHECK(f != NULL && fwrite(__data_start, _end - __data_start, 1, f) == 1);
+    fclose(f);
+    f = fopen("log_dump.addr", "w");
+    fprintf(f, "%p\n", (void *)__data_start);
+    fclose(f);
+
+    dump_text = fopen("log_dump.txt", "w");
+    log_host_output = write_line;
+    log_flush();
+    fclose(dump_text);
+}
+
+int main(void)
+{
+    unsigned int i;
+
+    log_impl_init();
+    log_host_output = capture;
+
+    for (i = 0; i < sizeof(deferred) / sizeof(deferred[0]); i++) {
+        check_message(deferred[i].format,
+                      HEADER_SIZE + sizeof(char *) + deferred[i].nargs * 4);
+    }
+    for (i = 0; i < sizeof(immediate) / sizeof(immediate[0]); i++) {
+        if (i == 0) {
+            check_string();
+        } else if (i == 2) {
+            /* the arguments of %lld are not 32-bit words */
+            log_host_printk(log_write_msg, 0, 0, immediate[i], (long long)-5);
+            log_flush();
+            CHECK(last_msg.buf_size == 2 && memcmp(last_msg.buf, "-5", 2) == 0);
+        } else {
+            check_message(immediate[i], 0);
+        }
+    }
+
+    dump_buffer();
+
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Floods the log buffer from a simulated interrupt, a thread that takes
+ * the interrupt lock of the LINUX OS abstraction layer and gives a
+ * semaphore for each record, while a reader drains it:
+ *  - through cb_push_record()/cb_pop_record(), records of all lengths are
+ *    read intact and in order, and every record written is either read or
+ *    counted in dropped,
+ *  - through log_impl_cbuffer.c, read by log_task(), messages are read
+ *    intact and in order, and the lost count reported with each message
+ *    matches the number of messages missing before it.
+ * The interrupt alternates floods with periods where it lets the reader
+ * run after each record.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#include <sched.h>
+#undef timer_create
+#undef timer_delete
+#include "infra/log_impl_cbuffer.h"
+#include "util/cbuffer.h"
+#include "log_host.h"
+
+#define RECORDS     2000000
+#define MESSAGES    1000000
+#define MAX_RECORD  60
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+static uint8_t storage[CONFIG_LOG_CBUFFER_SIZE];
+static cbuffer_t cb = { .buf = storage, .buf_size = CONFIG_LOG_CBUFFER_SIZE };
+
+static volatile int writer_done;
+static T_SEMAPHORE record_sem;
+
+/* Interrupts come in floods, then at a pace the reader keeps up with */
+static void isr_pace(uint32_t seq)
+{
+    if (seq % 4096 >= 2048) {
+        sched_yield();
+    }
+}
+
+/* Record seq: its length and content only depend on seq */
+static uint32_t record_fill(uint8_t *record, uint32_t seq)
+{
+    uint32_t len = sizeof(seq) + 1 + seq % (MAX_RECORD - sizeof(seq));
+    uint32_t i;
+
+    memcpy(record, &seq, sizeof(seq));
+    for (i = sizeof(seq); i < len; i++) {
+        record[i] = seq + i;
+    }
+    return len;
+}
+
+static void *record_isr(void *arg)
+{
+    uint8_t record[MAX_RECORD];
+    uint32_t seq, flags;
+
+    for (seq = 0; seq < RECORDS; seq++) {
+        uint32_t len = record_fill(record, seq);
+
+        flags = interrupt_lock();
+        cb_push_record(&cb, record, len);
+        interrupt_unlock(flags);
+        semaphore_give(record_sem, NULL);
+        isr_pace(seq);
+    }
+    writer_done = 1;
+    return NULL;
+}
+
+static void check_records(void)
+{
+    pthread_t isr;
+    uint8_t record[MAX_RECORD], expected[MAX_RECORD];
+    uint32_t next = 0, read = 0, dropped = 0, seq, flags;
+    int32_t len;
+    int done;
+
+    cb_init(&cb);
+    record_sem = semaphore_create(0, NULL);
+    writer_done = 0;
+    pthread_create(&isr, NULL, record_isr, NULL);
+    do {
+        semaphore_take(record_sem, OS_WAIT_FOREVER);
+        done = writer_done;
+        for (;;) {
+            flags = interrupt_lock();
+            len = cb_pop_record(&cb, record, sizeof(record));
+            dropped += cb.dropped;
+            cb.dropped = 0;
+            interrupt_unlock(flags);
+            if (len <= 0) {
+                CHECK(len == 0);
+                break;
+            }
+            memcpy(&seq, record, sizeof(seq));
+            CHECK(seq >= next && seq < RECORDS);
+            CHECK((uint32_t)len == record_fill(expected, seq));
+            CHECK(memcmp(record, expected, len) == 0);
+            /* the records dropped so far are the ones missing before seq */
+            CHECK(read + dropped == seq);
+            next = seq + 1;
+            read++;
+        }
+    } while (!done && failures < 10);
+    pthread_join(isr, NULL);
+
+    CHECK(read + dropped == RECORDS);
+    printf("records: %u written, %u read, %u dropped\n", RECORDS, read, dropped);
+}
+
+static void *log_isr(void *arg)
+{
+    static const char pad[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    uint32_t seq;
+
+    for (seq = 0; seq < MESSAGES; seq++) {
+        log_host_printk(log_write_msg, LOG_LEVEL_INFO, 0, "isr %u %.*s",
+                        seq, (int)(seq % sizeof(pad)), pad);
+        isr_pace(seq);
+    }
+    writer_done = 1;
+    return NULL;
+}
+
+static volatile uint32_t next_msg, read_msgs, lost_msgs, saturated;
+
+static void check_message(const log_message_t *msg)
+{
+    char expected[LOG_MAX_MSG_LEN];
+    unsigned int seq;
+    int len;
+
+    if (sscanf(msg->buf, "isr %u", &seq) != 1) {
+        CHECK(0);
+        return;
+    }
+    len = snprintf(expected, sizeof(expected), "isr %u %.*s", seq,
+                   (int)(seq % 37), "0123456789abcdefghijklmnopqrstuvwxyz");
+    CHECK(msg->buf_size == len && memcmp(msg->buf, expected, len) == 0);
+    CHECK(seq >= next_msg);
+    /* the lost count is saturated to 255 */
+    if (msg->lost_messages_count < 255) {
+        CHECK(seq - next_msg == msg->lost_messages_count);
+    } else {
+        CHECK(seq - next_msg >= 255);
+        saturated++;
+    }
+    CHECK(msg->has_saturated == (seq != next_msg));
+    lost_msgs += seq - next_msg;
+    next_msg = seq + 1;
+    read_msgs++;
+}
+
+static void *log_reader(void *arg)
+{
+    log_task();
+    return NULL;
+}
+
+static void check_messages(void)
+{
+    pthread_t isr, reader;
+    unsigned int ms;
+
+    log_impl_init();
+    log_host_output = check_message;
+    writer_done = 0;
+    pthread_create(&reader, NULL, log_reader, NULL);
+    pthread_create(&isr, NULL, log_isr, NULL);
+    pthread_join(isr, NULL);
+
+    /* the last message is never dropped */
+    for (ms = 0; next_msg != MESSAGES && ms < 10000; ms++) {
+        local_task_sleep(1);
+    }
+    CHECK(next_msg == MESSAGES);
+    CHECK(read_msgs + lost_msgs == next_msg);
+    printf("messages: %u written, %u read, %u lost (%u lost counts saturated)\n",
+           MESSAGES, read_msgs, MESSAGES - read_msgs, saturated);
+}
+
+int main(void)
+{
+    check_records();
+    check_messages();
+
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures ? 1 : 0;
+}
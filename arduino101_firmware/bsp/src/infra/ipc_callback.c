@@ -40,6 +40,7 @@
 #include "log_impl.h"
 #endif
 #include "infra/pm.h"
+#include "infra/ipc.h"
 
 int ipc_sync_callback(uint8_t cpu_id, int request, int param1, int param2,
 		void *ptr)
@@ -66,6 +67,11 @@ int ipc_sync_callback(uint8_t cpu_id, int request, int param1, int param2,
 		case IPC_MSG_TYPE_FREE:
 			message_free(ptr);
 			break;
+#ifdef CONFIG_IPC_MSG_RING
+		case IPC_REQUEST_MSG_RING:
+			ipc_msg_ring_drain();
+			break;
+#endif
 #ifdef CONFIG_PANIC
 		case IPC_PANIC_NOTIFICATION:
 			// Handle panic notification of core id "param1"
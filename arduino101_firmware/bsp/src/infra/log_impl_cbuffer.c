@@ -21,13 +21,14 @@
 #endif
 #include "infra/time.h"
 
-#define LOG_BUFFER_SIZE             CONFIG_LOG_CBUFFER_SIZE
+/* Kinds of message payload */
+#define LOG_MESSAGE_TEXT        0
+#define LOG_MESSAGE_DEFERRED    1
 
-/* First message magic number; */
-#define LOG_MESSAGE_MAGIC_A     0xFE
-
-/* Second message magic number; */
-#define LOG_MESSAGE_MAGIC_B     0xEE
+#ifdef CONFIG_LOG_CBUFFER_DEFERRED
+/* Maximum number of arguments of a message whose formatting is deferred */
+#define LOG_DEFERRED_MAX_ARGS   8
+#endif
 
 /* The main circular buffer where messages are transiently stored */
 static uint8_t logbuf[CONFIG_LOG_CBUFFER_SIZE];
@@ -124,7 +125,6 @@ void log_flush()
 /* Logger task. Should be lower prio than any other tasks that send messages. */
 void log_task()
 {
-	uint8_t lost_messages = 0;
 	/* Send an initial IPC request to tell the master that slave task
 	 * is ready. */
 	ipc_request_sync_int(IPC_REQUEST_LOGGER, 0, 0, NULL);
@@ -144,17 +144,10 @@ void log_task()
 			panic(E_OS_ERR);
 		}
 
-		/* Process next message */
+		/* Process next message. Nothing is read if it was dropped on
+		 * saturation, log_read_msg() reports it with the next one. */
 		log_message_t* p_msg = (log_message_t*)out_msg;
-		if (log_read_msg(p_msg)<=0) {
-			/* We were too late and the message has been overwritten (saturation)
-			 * Skip this message.. */
-			lost_messages++;
-		} else {
-			/* Use the message as a container to tell the master how many
-			 * messages we lost */
-			p_msg->lost_messages_count = lost_messages;
-			lost_messages = 0;
+		if (log_read_msg(p_msg) > 0) {
 			out_msg = NULL;
 			ipc_request_sync_int(IPC_REQUEST_LOGGER, 0, 0, NULL);
 		}
@@ -224,9 +217,104 @@ void log_impl_init(void)
 }
 
 
+/**
+ * @brief Fills the header of a message and pushes it into the logging queue.
+ *
+ * Each message is stored as one cbuffer record, only the used part of buf
+ * is copied.
+ *
+ * @param msg        message whose buf and buf_size are already set
+ * @param kind       kind of payload
+ *
+ * @retval Message's length.
+ */
+static uint32_t log_push_msg(log_message_t *msg, uint8_t level, uint8_t module,
+				uint8_t kind)
+{
+	/* Fill up the message contents */
+	/* Note that we abuse the lost_messages_count member to temporarily
+	 * store the kind of payload while the message is in the cbuffer.
+	 *
+	 * Both has_saturated and lost_messages_count will be properly set
+	 * at extraction time.
+	 */
+	msg->has_saturated = 0;
+	msg->lost_messages_count = kind;
+	msg->level = level;
+	msg->module = module;
+	msg->timestamp = get_uptime_ms();
+#ifdef CONFIG_LOG_MULTI_CPU_SUPPORT
+	msg->cpu_id = get_cpu_id();
+#else
+	msg->cpu_id = 0;
+#endif
+	uint32_t msg_len = sizeof(*msg) - sizeof(msg->buf) + msg->buf_size;
+
+	uint32_t saved = interrupt_lock();
+	cb_push_record(&log_buffer, (const uint8_t*)msg, msg_len);
+	interrupt_unlock(saved);
+
+	semaphore_give(new_msg_notif, NULL);
+
+	return msg_len;
+}
+
+#ifdef CONFIG_LOG_CBUFFER_DEFERRED
+/**
+ * @brief Counts the arguments of a format string whose formatting can be
+ * deferred.
+ *
+ * Only conversions taking a 32-bit argument can be deferred: the strings
+ * passed to %s may not exist anymore when the message is formatted, and
+ * 64-bit or floating point arguments cannot be stored as single words.
+ *
+ * @retval Number of arguments, -1 if the message must be formatted now.
+ */
+static int log_deferred_args_count(const char *format)
+{
+	int count = 0;
+
+	while (*format) {
+		if (*format++ != '%')
+			continue;
+		if (*format == '%') {
+			format++;
+			continue;
+		}
+		/* flags, field width and precision */
+		while (*format && strchr("-+ #0123456789.*", *format)) {
+			if (*format == '*')
+				count++;
+			format++;
+		}
+		/* length modifiers, a single 'l' is 32-bit on our targets */
+		if (*format == 'h' || *format == 'z') {
+			while (*format == 'h' || *format == 'z')
+				format++;
+		} else if (*format == 'l') {
+			format++;
+		}
+		switch (*format) {
+		case 'd': case 'i': case 'u': case 'x': case 'X':
+		case 'o': case 'c': case 'p':
+			count++;
+			format++;
+			break;
+		default:
+			return -1;
+		}
+	}
+	return (count <= LOG_DEFERRED_MAX_ARGS) ? count : -1;
+}
+#endif
+
 /**
  * @brief Creates and pushes a user's log message into the logging queue.
  *
+ * With CONFIG_LOG_CBUFFER_DEFERRED, messages whose arguments are all 32-bit
+ * integers are pushed as the format string pointer followed by the raw
+ * arguments, and formatted by the log task when they are extracted.
+ *
  * @retval Message's length if inserted, -1 if an error occurs, 0 if
  * message was discarded.
  */
@@ -235,6 +323,22 @@ uint32_t log_write_msg(uint8_t level, uint8_t module, const char *format,
 {
 	log_message_t msg;
 
+#ifdef CONFIG_LOG_CBUFFER_DEFERRED
+	int nargs = log_deferred_args_count(format);
+	if (nargs >= 0) {
+		int i;
+
+		memcpy(msg.buf, &format, sizeof(format));
+		for (i = 0; i < nargs; i++) {
+			uint32_t arg = va_arg(args, uint32_t);
+			memcpy(&msg.buf[sizeof(format) + i * sizeof(arg)], &arg,
+				sizeof(arg));
+		}
+		msg.buf_size = sizeof(format) + nargs * sizeof(uint32_t);
+		return log_push_msg(&msg, level, module, LOG_MESSAGE_DEFERRED);
+	}
+#endif
+
 	/* Contains the full text size not including the terminating \0 */
 	msg.buf_size = vsnprintf(msg.buf, sizeof(msg.buf), format, args);
 	if (msg.buf_size>=sizeof(msg.buf))
@@ -242,40 +346,44 @@ uint32_t log_write_msg(uint8_t level, uint8_t module, const char *format,
 	if (msg.buf_size<=0)
 		return 0;
 
-	/* Fill up the message contents */
-	/* Note that we abuse the has_saturated and lost_messages_count members
-	 * to temporarily store the magic numbers required to check message
-	 * consistency when extracting them from the cbuffer.
-	 *
-	 * Both variables will be properly reset at extraction time.
-	 */
-	msg.has_saturated = LOG_MESSAGE_MAGIC_A;
-	msg.lost_messages_count = LOG_MESSAGE_MAGIC_B;
-	msg.level = level;
-	msg.module = module;
-	msg.timestamp = get_uptime_ms();
-#ifdef CONFIG_LOG_MULTI_CPU_SUPPORT
-	msg.cpu_id = get_cpu_id();
-#else
-	msg.cpu_id = 0;
-#endif
-	uint32_t msg_len = sizeof(msg) - sizeof(msg.buf) + msg.buf_size;
-
-	uint32_t saved = interrupt_lock();
-	cb_push(&log_buffer, (const uint8_t*)&msg, msg_len);
-	interrupt_unlock(saved);
-
-	semaphore_give(new_msg_notif, NULL);
+	return log_push_msg(&msg, level, module, LOG_MESSAGE_TEXT);
+}
 
-	return msg_len;
+#ifdef CONFIG_LOG_CBUFFER_DEFERRED
+/**
+ * @brief Formats the payload of a deferred message into its text.
+ *
+ * The arguments are all passed as 32-bit words, which matches the variadic
+ * calling convention of the supported 32-bit targets.
+ */
+static void log_format_deferred(log_message_t *p_msg)
+{
+	const char *format;
+	uint32_t args[LOG_DEFERRED_MAX_ARGS] = { 0 };
+	int len;
+
+	memcpy(&format, p_msg->buf, sizeof(format));
+	memcpy(args, &p_msg->buf[sizeof(format)], p_msg->buf_size - sizeof(format));
+
+	len = snprintf(p_msg->buf, sizeof(p_msg->buf), format,
+			args[0], args[1], args[2], args[3],
+			args[4], args[5], args[6], args[7]);
+	if (len < 0)
+		len = 0;
+	if (len >= (int)sizeof(p_msg->buf))
+		len = sizeof(p_msg->buf) - 1;
+	p_msg->buf_size = len;
 }
+#endif
 
 /**
  * @brief Read a message in a circular buffer.
  *
  * @param p_msg  pointer on the message filled by the function:
- *   - p_msg->has_saturated is set to 1 if saturation occured, 0 otherwise
- *   - p_msg->lost_messages_count is set to 0
+ *   - p_msg->has_saturated is set to 1 if messages were dropped before this
+ *     one because of a saturation, 0 otherwise
+ *   - p_msg->lost_messages_count is set to the number of dropped messages,
+ *     saturated to 255
  *
  * @return  1  If no error,
  * @return  0  If no message has been found,
@@ -284,65 +392,28 @@ uint32_t log_write_msg(uint8_t level, uint8_t module, const char *format,
 static int32_t log_read_msg(log_message_t * p_msg)
 {
 	uint32_t it_flags;
-	int32_t ret;
-	int msg_len = 0;
-	int buf_len = 0;
-	int start_r = 0;	/* Start of the next message index */
-
-	if (log_buffer.r == log_buffer.w) {
-		/* No messages in cbuffer */
-		return 0;
-	}
-
-	/* Searching for the first magic number outside of critical section should be ok.
-	 * we check inside the critical section if the second magic number matches; if
-	 * the contents were changed during the search, the second magic number will not
-	 * match.
-	 *
-	 * if the first magic number isn't already under log_buffer.r, then it means that log_buffer.r
-	 * was pushed ahead because of a saturation; we should be able to find a message
-	 * 'to the right' within sizeof(log_message_t) characters. If none is found, then
-	 * something is not right => we set log_buffer.r = log_buffer.w = no messages.
-	 *
-	 * for a safer option: instead of sizeof(log_message_t) use LOG_BUFFER_SIZE
-	 */
-	start_r = cb_find(LOG_MESSAGE_MAGIC_A, &log_buffer,
-			log_buffer.r, log_buffer.w, sizeof(log_message_t));
+	int32_t len;
+	uint32_t lost = 0;
 
 	it_flags = interrupt_lock();
-
-	if (start_r < 0) {
-		log_buffer.r = log_buffer.w;	/* No message found; push r forward to speed up next search */
-		interrupt_unlock(it_flags);
-		return 0;
-	}
-
-	if (log_buffer.buf[(start_r + offsetof(log_message_t, lost_messages_count)) % LOG_BUFFER_SIZE] !=
-		LOG_MESSAGE_MAGIC_B) {
-		/* Something is not right, we can't match the second magic number; we'll advance r to speed up next search */
-		log_buffer.r = start_r;
-		interrupt_unlock(it_flags);
-		return -1;
-	}
-
-	buf_len = log_buffer.buf[((start_r + offsetof(log_message_t, buf_size))
-							% LOG_BUFFER_SIZE)];
-	msg_len = sizeof(*p_msg) - sizeof(p_msg->buf) + buf_len;
-
-	if (buf_len < 0 || msg_len < 0) {
-		/* Start_r doesn't look good.. we'll wait. */
-		interrupt_unlock(it_flags);
-		return -1;
+	len = cb_pop_record(&log_buffer, (uint8_t *)p_msg, sizeof(*p_msg));
+	if (len > 0) {
+		lost = log_buffer.dropped;
+		log_buffer.dropped = 0;
 	}
+	interrupt_unlock(it_flags);
 
-	uint8_t saturation = log_buffer.saturation_flag;
-	ret = cb_pop(&log_buffer, start_r, (unsigned char *)p_msg, msg_len);
+	if (len <= 0)
+		return len;
 
-	interrupt_unlock(it_flags);
+#ifdef CONFIG_LOG_CBUFFER_DEFERRED
+	if (p_msg->lost_messages_count == LOG_MESSAGE_DEFERRED)
+		log_format_deferred(p_msg);
+#endif
 
-	p_msg->has_saturated = saturation;
-	p_msg->lost_messages_count = 0;
-	return ret;
+	p_msg->has_saturated = (lost != 0);
+	p_msg->lost_messages_count = (lost > UINT8_MAX) ? UINT8_MAX : lost;
+	return 1;
 }
 
 /*
@@ -127,6 +127,186 @@ static struct port * get_port(uint16_t port_id)
 	return &ports[port_id - 1];
 }
 #endif
+#ifdef CONFIG_PORT_STATS
+/*
+ * Statistics are kept next to the port table, which may be shared with
+ * another cpu and must keep its layout.
+ */
+static struct port_stats port_stats[MAX_PORTS];
+
+/*
+ * Enqueue times of the messages, indexed by a hash of the message address.
+ * A collision only loses a latency sample. Blocks of a pool are a power of
+ * two apart, so the hash folds in the address bits above the block size.
+ */
+#define PORT_STATS_STAMPS 32
+static struct {
+	struct message * msg;
+	uint32_t time;
+} port_stats_stamps[PORT_STATS_STAMPS];
+
+#define PORT_STATS_STAMP(msg) \
+	(&port_stats_stamps[(((uintptr_t)(msg) >> 2) ^ ((uintptr_t)(msg) >> 7)) \
+			    % PORT_STATS_STAMPS])
+
+static void port_stats_sent(struct message * msg, bool queued)
+{
+	struct port_stats * st = &port_stats[MESSAGE_DST(msg) - 1];
+	uint16_t len = MESSAGE_LEN(msg);
+	int bucket = 0;
+	uint32_t flags;
+
+	while (bucket < PORT_STATS_LEN_BUCKETS - 1 && len > (16 << bucket)) {
+		bucket++;
+	}
+
+	flags = interrupt_lock();
+	st->sent++;
+	st->len_hist[bucket]++;
+	if (queued) {
+		/* max_depth is updated on dispatch, a drop would inflate it here */
+		st->depth++;
+		PORT_STATS_STAMP(msg)->msg = msg;
+		PORT_STATS_STAMP(msg)->time = (uint32_t)get_time_us();
+	}
+	interrupt_unlock(flags);
+}
+
+static void port_stats_dropped(struct message * msg)
+{
+	struct port_stats * st = &port_stats[MESSAGE_DST(msg) - 1];
+	uint32_t flags;
+
+	flags = interrupt_lock();
+	st->dropped++;
+	if (st->depth) {
+		st->depth--;
+	}
+	if (PORT_STATS_STAMP(msg)->msg == msg) {
+		PORT_STATS_STAMP(msg)->msg = NULL;
+	}
+	interrupt_unlock(flags);
+}
+
+static uint32_t port_stats_dispatch(struct message * msg)
+{
+	struct port_stats * st = &port_stats[MESSAGE_DST(msg) - 1];
+	uint32_t now = (uint32_t)get_time_us();
+	uint32_t flags;
+
+	flags = interrupt_lock();
+	st->received++;
+	if (st->depth > st->max_depth) {
+		st->max_depth = st->depth;
+	}
+	if (st->depth) {
+		st->depth--;
+	}
+	if (PORT_STATS_STAMP(msg)->msg == msg) {
+		uint32_t latency = now - PORT_STATS_STAMP(msg)->time;
+		PORT_STATS_STAMP(msg)->msg = NULL;
+		st->latency_count++;
+		st->latency_total += latency;
+		if (latency > st->latency_max) {
+			st->latency_max = latency;
+		}
+	}
+	interrupt_unlock(flags);
+	return now;
+}
+
+static void port_stats_handled(uint16_t port_id, uint16_t msg_id, uint32_t start)
+{
+	struct port_stats * st = &port_stats[port_id - 1];
+	uint32_t time = (uint32_t)get_time_us() - start;
+
+	if (time > st->handler_max) {
+		st->handler_max = time;
+		st->handler_max_msg_id = msg_id;
+	}
+}
+
+void port_stats_get(uint16_t port_id, struct port_stats * stats)
+{
+	uint32_t flags;
+
+	get_port(port_id);
+	flags = interrupt_lock();
+	*stats = port_stats[port_id - 1];
+	interrupt_unlock(flags);
+	if (stats->depth > stats->max_depth) {
+		stats->max_depth = stats->depth;
+	}
+}
+
+void port_stats_reset(void)
+{
+	uint32_t flags = interrupt_lock();
+	int i;
+
+	for (i = 0; i < MAX_PORTS; i++) {
+		uint16_t depth = port_stats[i].depth;
+		memset(&port_stats[i], 0, sizeof(port_stats[i]));
+		port_stats[i].depth = port_stats[i].max_depth = depth;
+	}
+	interrupt_unlock(flags);
+}
+
+void port_stats_dump(void)
+{
+	struct port_stats st;
+	int i;
+
+	for (i = 1; i <= MAX_PORTS; i++) {
+		port_stats_get(i, &st);
+		if (!st.sent && !st.received) {
+			continue;
+		}
+		pr_info(LOG_MODULE_MAIN, "port %d: tx %d rx %d drop %d depth %d/%d",
+				i, st.sent, st.received, st.dropped, st.depth,
+				st.max_depth);
+		pr_info(LOG_MODULE_MAIN, "  len %d/%d/%d/%d/%d/%d",
+				st.len_hist[0], st.len_hist[1], st.len_hist[2],
+				st.len_hist[3], st.len_hist[4], st.len_hist[5]);
+		pr_info(LOG_MODULE_MAIN, "  latency avg %d max %d handler max %d (msg 0x%x) us",
+				st.latency_count ? st.latency_total / st.latency_count : 0,
+				st.latency_max, st.handler_max, st.handler_max_msg_id);
+	}
+}
+
+int port_stats_snapshot(void * buf, int size)
+{
+	uint8_t * p = (uint8_t *)buf + sizeof(uint16_t);
+	uint16_t count = 0;
+	struct port_stats st;
+	uint16_t i;
+
+	if (size < (int)sizeof(uint16_t)) {
+		return -1;
+	}
+	for (i = 1; i <= MAX_PORTS; i++) {
+		port_stats_get(i, &st);
+		if (!st.sent && !st.received) {
+			continue;
+		}
+		if (p + sizeof(i) + sizeof(st) > (uint8_t *)buf + size) {
+			return -1;
+		}
+		memcpy(p, &i, sizeof(i));
+		memcpy(p + sizeof(i), &st, sizeof(st));
+		p += sizeof(i) + sizeof(st);
+		count++;
+	}
+	memcpy(buf, &count, sizeof(count));
+	return p - (uint8_t *)buf;
+}
+#else
+#define port_stats_sent(msg, queued) do {} while(0)
+#define port_stats_dispatch(msg) 0
+#define port_stats_handled(port_id, msg_id, start) ((void)(start))
+#define port_stats_dropped(msg) do {} while(0)
+#endif
+
 void port_set_queue(uint16_t port_id, void * queue)
 {
 	struct port * p = get_port(port_id);
@@ -188,11 +368,109 @@ struct message * message_alloc(int size, OS_ERR_TYPE * err)
 	return msg;
 }
 
+#ifdef CONFIG_PORT_SHARED_MESSAGES
+/* The reference count is stored after the message, at a word boundary */
+#define MESSAGE_REFCOUNT(msg) \
+	(*(uint32_t *)((uint8_t *)(msg) + ((MESSAGE_LEN(msg) + 3) & ~3)))
+
+struct message * message_share(const struct message * message, OS_ERR_TYPE * err)
+{
+	struct message * msg = message_alloc(((MESSAGE_LEN(message) + 3) & ~3) +
+			sizeof(uint32_t), err);
+	if (msg) {
+		memcpy(msg, message, MESSAGE_LEN(message));
+		msg->flags.f_shared = 1;
+		MESSAGE_REFCOUNT(msg) = 1;
+	}
+	return msg;
+}
+
+int port_send_message_ref(struct message * msg, uint16_t port_id)
+{
+	OS_ERR_TYPE err = E_OS_OK;
+	struct message_ref * ref;
+	uint32_t flags;
+
+	if (get_port(port_id)->cpu_id != get_cpu_id()) {
+		return E_OS_ERR_NOT_SUPPORTED;
+	}
+
+	ref = (struct message_ref *) message_alloc(sizeof(*ref), &err);
+	if (ref == NULL) {
+		return err;
+	}
+	MESSAGE_ID(&ref->m) = MESSAGE_ID(msg);
+	MESSAGE_SRC(&ref->m) = MESSAGE_SRC(msg);
+	MESSAGE_DST(&ref->m) = port_id;
+	MESSAGE_LEN(&ref->m) = sizeof(*ref);
+	MESSAGE_TYPE(&ref->m) = MESSAGE_TYPE(msg);
+	ref->m.flags.f_ref = 1;
+	ref->ref = msg;
+
+	flags = interrupt_lock();
+	MESSAGE_REFCOUNT(msg)++;
+	interrupt_unlock(flags);
+
+	err = port_send_message(&ref->m);
+	if (err != E_OS_OK) {
+		message_free(&ref->m);
+	}
+	return err;
+}
+
+/**
+ * Release a reference on a shared message, or on the message delivered
+ * by an envelope.
+ *
+ * Shared messages are always allocated on the local cpu, the last
+ * reference frees them directly.
+ *
+ * @param msg the message to release
+ *
+ * @return true if the message was shared and has been released
+ */
+static bool message_release_ref(struct message ** msg)
+{
+	uint32_t flags;
+	uint32_t refcount;
+
+	if ((*msg)->flags.f_ref) {
+		struct message * ref = ((struct message_ref *)*msg)->ref;
+		bfree(*msg);
+		*msg = ref;
+	}
+	if (!(*msg)->flags.f_shared) {
+		return false;
+	}
+	flags = interrupt_lock();
+	refcount = --MESSAGE_REFCOUNT(*msg);
+	interrupt_unlock(flags);
+	if (refcount == 0) {
+		bfree(*msg);
+	}
+	return true;
+}
+#endif
+
 void port_process_message(struct message * msg)
 {
 	struct port * p = get_port(msg->dst_port_id);
+#ifdef CONFIG_PORT_STATS
+	uint16_t port_id = msg->dst_port_id;
+	uint16_t msg_id = MESSAGE_ID(msg);
+#endif
+	uint32_t start = port_stats_dispatch(msg);
+#ifdef CONFIG_PORT_SHARED_MESSAGES
+	if (msg->flags.f_ref) {
+		/* Deliver the shared message, the envelope is not needed anymore */
+		struct message * ref = ((struct message_ref *)msg)->ref;
+		bfree(msg);
+		msg = ref;
+	}
+#endif
 	if (p->handle_message != NULL) {
 		p->handle_message(msg, p->handle_param);
+		port_stats_handled(port_id, msg_id, start);
 	}
 }
 
@@ -255,18 +533,29 @@ int port_send_message(struct message * message)
 #ifdef PORT_DEBUG
         pr_info(LOG_MODULE_MAIN, "Sending message %p to port %p(q:%p) ret: %d", message, port, port->queue, err);
 #endif
+        /* Count the message first, the receiver may run before we return */
+        port_stats_sent(message, true);
         queue_send_message(port->queue, message, &err);
+        if (err != E_OS_OK) {
+            port_stats_dropped(message);
+        }
         return err;
     } else {
 #ifdef PORT_DEBUG
         pr_info(LOG_MODULE_MAIN, "Remote port ! using: %p handler", ipc_handler[port->cpu_id].send_message);
 #endif
+        port_stats_sent(message, false);
         return ipc_handler[port->cpu_id].send_message(message);
     }
 }
 
 void message_free(struct message * msg)
 {
+#ifdef CONFIG_PORT_SHARED_MESSAGES
+    if (message_release_ref(&msg)) {
+        return;
+    }
+#endif
     struct port * port = get_port(MESSAGE_SRC(msg));
     pr_debug(LOG_MODULE_MAIN, "free message %p: port %p[%d] this %d id %d",
             msg, port, port->cpu_id, get_cpu_id(), MESSAGE_SRC(msg));
@@ -283,12 +572,21 @@ int port_send_message(struct message * msg)
 {
 	struct port * port = get_port(MESSAGE_DST(msg));
 	OS_ERR_TYPE err;
+	port_stats_sent(msg, true);
 	queue_send_message(port->queue, msg, &err);
+	if (err != E_OS_OK) {
+		port_stats_dropped(msg);
+	}
 	return err;
 }
 
 void message_free(struct message * msg)
 {
+#ifdef CONFIG_PORT_SHARED_MESSAGES
+	if (message_release_ref(&msg)) {
+		return;
+	}
+#endif
 	bfree(msg);
 }
 #endif
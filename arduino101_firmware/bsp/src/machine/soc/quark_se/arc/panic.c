@@ -100,9 +100,9 @@ void panic_notify(int timeout)
 #ifdef CONFIG_IPC
     // Send IPC panic notification
     if (!is_panic_notification) {
-        // On ARC core, ipc_request_sync_int is the equivalent to mailbox register write
+        // On ARC core, ipc_request_sync_poll is the equivalent to mailbox register write
         // and thus will generate an QRK interrupt as if it were a GPIO
-        ipc_request_sync_int(IPC_PANIC_NOTIFICATION, ARC_CORE, 0, NULL);
+        ipc_request_sync_poll(IPC_PANIC_NOTIFICATION, ARC_CORE, 0, NULL);
     }
 #endif
 }
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Latency and throughput of the IPC requests of ipc.c on the mailbox model,
+ * in simulated time: 1000 synchronous requests one after the other, and
+ * with CONFIG_IPC_ASYNC_REQUESTS, polled ones and 1000 requests queued at
+ * once. The CPU figure is the share of the time the local core is not idle
+ * in semaphore_take().
+ */
+
+#include <stdio.h>
+#include "mbx_model.h"
+#include "infra/ipc.h"
+
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+#define VARIANT "async"
+#else
+#define VARIANT "sync"
+#endif
+
+#define REQUESTS 1000
+
+static uint64_t start_ns;
+static struct mbx_model_stats start_stats;
+
+int ipc_sync_callback(uint8_t cpu_id, int request, int param1, int param2,
+                      void *ptr)
+{
+    return 0;
+}
+
+static void begin(void)
+{
+    struct mbx_model_peer peer = {
+        .seq = 1,
+        .ack_ns = MBX_MODEL_PEER_NS,
+    };
+
+    mbx_model_init(&peer, ipc_handle_message);
+    ipc_init(MBX_MODEL_TX, MBX_MODEL_RX, MBX_MODEL_TX_ACK, MBX_MODEL_RX_ACK, 1);
+    start_ns = mbx_model_now();
+    start_stats = *mbx_model_get_stats();
+}
+
+static void report(const char *name)
+{
+    const struct mbx_model_stats *stats = mbx_model_get_stats();
+    uint64_t ns = mbx_model_now() - start_ns;
+
+    printf("%-5s %-7s %6.1f us/request %7.0f requests/s %5.1f reg accesses/request %3.0f%% CPU\n",
+           VARIANT, name, ns / 1e3 / REQUESTS, REQUESTS / (ns / 1e9),
+           (double)(stats->reg_accesses - start_stats.reg_accesses) / REQUESTS,
+           100.0 * (ns - (stats->idle_ns - start_stats.idle_ns)) / ns);
+}
+
+static void sync_bench(int poll)
+{
+    int i;
+
+    begin();
+    for (i = 0; i < REQUESTS; i++) {
+        if ((poll ? ipc_request_sync_poll(i, 0, 0, NULL)
+                  : ipc_request_sync_int(i, 0, 0, NULL)) != i) {
+            printf("request %d failed\n", i);
+        }
+    }
+    report(poll ? "poll" : "int");
+}
+
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+static struct ipc_request requests[REQUESTS];
+static int pending;
+
+static void request_done(struct ipc_request *req)
+{
+    pending--;
+}
+
+static void queue_bench(void)
+{
+    int i;
+
+    begin();
+    pending = REQUESTS;
+    for (i = 0; i < REQUESTS; i++) {
+        requests[i].request_id = i;
+        requests[i].callback = request_done;
+        ipc_request_submit(&requests[i]);
+    }
+    while (pending) {
+        mbx_model_run(MBX_MODEL_PEER_NS);
+    }
+    report("queued");
+}
+#endif
+
+int main(void)
+{
+    sync_bench(0);
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+    sync_bench(1);
+    queue_bench();
+#endif
+    return 0;
+}
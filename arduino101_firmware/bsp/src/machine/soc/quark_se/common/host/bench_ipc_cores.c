@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Throughput of the messages between QRK and ARC on the two core model, in
+ * host time: each core sends 20000 messages to the other, with up to 256 of
+ * them not freed yet, through the message rings and through the mailbox.
+ * Also reports the mailbox requests and interrupts per message, which the
+ * rings are meant to save. Each case runs in its own process, as ipc.c keeps
+ * its state in statics.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "machine.h"
+#include "mbx_cores.h"
+#include "ipc_host.h"
+#include "os/os.h"
+#include "infra/ipc_requests.h"
+#include "infra/time.h"
+
+#define MESSAGES 20000
+#define IN_FLIGHT 256
+#define TIMEOUT_MS 60000
+
+struct bench_message {
+    struct message h;
+};
+
+static const struct ipc_host_core *ops[MBX_CORES];
+static volatile int arc_start;
+static volatile int done[MBX_CORES];
+/* Counters of each core, only updated by its thread */
+static uint32_t received[MBX_CORES];
+static uint32_t freed[MBX_CORES];
+
+int ipc_sync_callback(uint8_t cpu_id, int request, int param1, int param2,
+                      void *ptr)
+{
+    int self = mbx_cores_self();
+
+    switch (request) {
+    case IPC_MSG_TYPE_MESSAGE:
+        received[self]++;
+        ops[self]->free_message(ptr);
+        break;
+    case IPC_MSG_TYPE_FREE:
+        bfree(ptr);
+        freed[self]++;
+        break;
+    case IPC_REQUEST_MSG_RING:
+        if (ops[self]->msg_ring_drain)
+            ops[self]->msg_ring_drain();
+        break;
+    }
+    return 0;
+}
+
+static void qrk_isr(void)
+{
+    ops[MBX_CORE_QRK]->handle_message();
+}
+
+static void arc_isr(void)
+{
+    ops[MBX_CORE_ARC]->handle_message();
+}
+
+static void core_main(int core)
+{
+    const struct ipc_host_core *ipc = ops[core];
+    uint32_t start;
+    uint32_t i;
+
+    if (core == MBX_CORE_QRK) {
+        mbx_model_unmask(5);
+        ipc->init(0, 5, 1, 6, CPU_ID_ARC);
+        ipc->async_init(NULL);
+        arc_start = 1;
+        while (!shared_data->arc_ready)
+            mbx_cores_idle(1);
+    } else {
+        while (!arc_start)
+            mbx_cores_idle(1);
+        mbx_model_unmask(0);
+        ipc->init(5, 0, 6, 1, CPU_ID_QRK);
+        ipc->async_init(NULL);
+        shared_data->arc_ready = 1;
+    }
+
+    start = get_uptime_ms();
+    for (i = 0; i < MESSAGES; i++) {
+        while (i - freed[core] >= IN_FLIGHT)
+            mbx_cores_idle(1);
+        ipc->send_message(&((struct bench_message *)balloc(
+                    sizeof(struct bench_message), NULL))->h);
+    }
+    while (!done[MBX_CORE_QRK] || !done[MBX_CORE_ARC]) {
+        if (get_uptime_ms() - start > TIMEOUT_MS) {
+            printf("%s: timeout\n", core == MBX_CORE_QRK ? "QRK" : "ARC");
+            exit(1);
+        }
+        done[core] = received[core] == MESSAGES && freed[core] == MESSAGES;
+        mbx_cores_idle(1);
+    }
+}
+
+static void bench_case(const struct ipc_host_core *arc)
+{
+    void (*const isr[MBX_CORES])(void) = { qrk_isr, arc_isr };
+    const struct mbx_cores_stats *stats = mbx_cores_get_stats();
+    uint32_t start;
+    double s;
+
+    mbx_cores_init();
+    ops[MBX_CORE_QRK] = &ipc_host_qrk;
+    ops[MBX_CORE_ARC] = arc;
+    start = get_uptime_ms();
+    mbx_cores_run(core_main, isr);
+    s = (get_uptime_ms() - start) / 1e3;
+    printf("%-8s %8.0f messages/s %5.2f requests/message %5.2f irqs/message\n",
+           arc->msg_ring_drain ? "rings" : "mailbox", 2 * MESSAGES / s,
+           (double)(stats->posts[0] + stats->posts[5]) / (2 * MESSAGES),
+           (double)(stats->irqs[0] + stats->irqs[1]) / (2 * MESSAGES));
+}
+
+int main(void)
+{
+    const struct ipc_host_core *arc[] = { &ipc_host_arc, &ipc_host_arc_mbx };
+    int status;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(arc) / sizeof(arc[0]); i++) {
+        fflush(stdout);
+        if (fork() == 0) {
+            bench_case(arc[i]);
+            exit(0);
+        }
+        wait(&status);
+    }
+    return 0;
+}
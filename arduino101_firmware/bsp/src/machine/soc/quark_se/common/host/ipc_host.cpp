@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ipc.c built as C++, so that its mailbox accesses go to the mailbox model.
+ *
+ * With IPC_HOST_CORE set, the build goes in that namespace and exports its
+ * entry points as ipc_host_<IPC_HOST_CORE>, see ipc_host.h. Otherwise the
+ * functions keep their C names.
+ */
+
+#include "machine.h"
+
+#ifdef IPC_HOST_CORE
+/* The headers of ipc.c keep C linkage, out of the namespace */
+extern "C" {
+#include "os/os_types.h"
+#include "infra/ipc.h"
+#include "infra/port.h"
+#include "infra/message.h"
+#include "infra/log.h"
+#include "infra/time.h"
+#include "util/list.h"
+}
+#include "ipc_host.h"
+
+/* Calls within the namespace could otherwise reach the C declarations of
+ * infra/ipc.h */
+#define ipc_request_submit ipc_host_request_submit
+#define ipc_handle_message ipc_host_handle_message
+
+namespace IPC_HOST_CORE {
+void ipc_handle_message();
+#include "../ipc.c"
+}
+
+#define STRING(x) #x
+#define NAME(x) STRING(x)
+#define OPS_(core) ipc_host_ ## core
+#define OPS(core) OPS_(core)
+
+extern "C" const struct ipc_host_core OPS(IPC_HOST_CORE) = {
+    NAME(IPC_HOST_CORE),
+    IPC_HOST_CORE::ipc_init,
+    IPC_HOST_CORE::ipc_async_init,
+    IPC_HOST_CORE::ipc_handle_message,
+    IPC_HOST_CORE::ipc_async_send_message,
+    IPC_HOST_CORE::ipc_async_free_message,
+#ifdef CONFIG_IPC_MSG_RING
+    IPC_HOST_CORE::ipc_msg_ring_drain,
+#else
+    NULL,
+#endif
+};
+#else
+extern "C" {
+#include "../ipc.c"
+}
+#endif
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Builds of ipc.c for the cores of the two core model, see mbx_cores.h.
+ *
+ * Each build lives in its own namespace of ipc_host.cpp and is reached
+ * through its table of entry points.
+ */
+
+#ifndef IPC_HOST_H
+#define IPC_HOST_H
+
+#include <stdint.h>
+#include "os/os_types.h"
+#include "infra/message.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ipc_host_core {
+    const char *name;
+    void (*init)(int tx_channel, int rx_channel, int tx_ack_channel,
+                 int rx_ack_channel, uint8_t remote_cpu_id);
+    void (*async_init)(T_QUEUE queue);
+    void (*handle_message)(void);
+    int (*send_message)(struct message *message);
+    void (*free_message)(struct message *message);
+    /** NULL without CONFIG_IPC_MSG_RING */
+    void (*msg_ring_drain)(void);
+};
+
+/** QRK, with the message rings */
+extern const struct ipc_host_core ipc_host_qrk;
+/** ARC, with the message rings */
+extern const struct ipc_host_core ipc_host_arc;
+/** ARC, built without CONFIG_IPC_MSG_RING */
+extern const struct ipc_host_core ipc_host_arc_mbx;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPC_HOST_H */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host replacement of the machine header: the mailbox definitions used by
+ * ipc.c, with the registers routed to the mailbox model, and the shared
+ * memory block of the cores in host memory.
+ */
+
+#ifndef _MACHINE_H_
+#define _MACHINE_H_
+
+#include <stdint.h>
+#include "mbx_model.h"
+#include "machine/soc/quark_se/soc_config.h"
+
+#define MAILBOX_CTRL_OFFSET             (0x00)
+#define MAILBOX_DATA0_OFFSET            (0x04)
+#define MAILBOX_DATA1_OFFSET            (0x08)
+#define MAILBOX_DATA2_OFFSET            (0x0C)
+#define MAILBOX_DATA3_OFFSET            (0x10)
+#define MAILBOX_STATUS_OFFSET           (0x14)
+
+#define MBX_CTRL(_x_) mbx_model_reg(_x_, MAILBOX_CTRL_OFFSET)
+#define MBX_DAT0(_x_) mbx_model_reg(_x_, MAILBOX_DATA0_OFFSET)
+#define MBX_DAT1(_x_) mbx_model_reg(_x_, MAILBOX_DATA1_OFFSET)
+#define MBX_DAT2(_x_) mbx_model_reg(_x_, MAILBOX_DATA2_OFFSET)
+#define MBX_DAT3(_x_) mbx_model_reg(_x_, MAILBOX_DATA3_OFFSET)
+#define MBX_STS(_x_) mbx_model_reg(_x_, MAILBOX_STATUS_OFFSET)
+
+#define SOC_MBX_INT_UNMASK(channel) mbx_model_unmask(channel)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern struct platform_shared_block_ mbx_model_shared_block;
+#ifdef __cplusplus
+}
+#endif
+
+#undef shared_data
+#define shared_data \
+	((volatile struct platform_shared_block_ *)&mbx_model_shared_block)
+
+#endif
@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* time.h and os.h both declare timer_create() and timer_delete() */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "machine.h"
+#include "mbx_cores.h"
+
+extern "C" {
+#include "os/os.h"
+#include "infra/port.h"
+#include "infra/log.h"
+#include "infra/time.h"
+}
+
+#define MBX_CHANNELS 8
+#define MBX_POSTED   0x80000000
+
+#define BLOCK_SIZE   64
+#define BLOCKS       8192
+
+struct platform_shared_block_ mbx_model_shared_block;
+
+struct sim_semaphore {
+    uint32_t count;
+};
+
+/* The task and interrupt context of a core */
+struct core {
+    pthread_t thread;
+    pthread_cond_t cond;
+    void (*main)(int core);
+    void (*isr)(void);
+    uint32_t unmasked;
+    /* Only accessed by the thread of the core */
+    uint32_t locked;
+    int in_isr;
+    /* Port messages sent to the core, linked through their list member */
+    list_t *port_head;
+    list_t *port_tail;
+    void (*port_handler)(struct message *, void *);
+    void *port_param;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct core cores[MBX_CORES];
+static __thread int self = -1;
+
+static struct {
+    uint32_t ctrl;
+    uint32_t data[4];
+    uint32_t sts;
+    int poster;
+} chan[MBX_CHANNELS];
+
+static struct mbx_cores_stats stats;
+
+/* util/list.c locks interrupts, which must not happen with the lock held: the
+ * free blocks and the port queues are linked here */
+static uint8_t blocks[BLOCKS][BLOCK_SIZE] __attribute__((aligned(8)));
+static list_t *free_blocks;
+static uint32_t used_blocks;
+
+static void model_error(const char *error)
+{
+    fprintf(stderr, "two core model: %s\n", error);
+    exit(2);
+}
+
+/* Interrupts */
+
+/* Called with the lock held */
+static int irq_raised(int core)
+{
+    int i;
+
+    for (i = 0; i < MBX_CHANNELS; i++) {
+        if ((chan[i].sts & 2) && chan[i].poster != core &&
+            (cores[core].unmasked & (1 << i))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void check_irq(void)
+{
+    struct core *c = &cores[self];
+    int raised;
+
+    if (c->locked || c->in_isr) {
+        return;
+    }
+    for (;;) {
+        pthread_mutex_lock(&lock);
+        raised = irq_raised(self);
+        if (raised) {
+            stats.irqs[self]++;
+        }
+        pthread_mutex_unlock(&lock);
+        if (!raised) {
+            return;
+        }
+        c->in_isr = 1;
+        c->isr();
+        c->in_isr = 0;
+    }
+}
+
+/* Mailboxes */
+
+static uint32_t model_access(int i, int offset, const uint32_t *value)
+{
+    uint32_t ret = 0;
+    int posted = 0;
+    int busy = 0;
+
+    check_irq();
+    pthread_mutex_lock(&lock);
+    switch (offset) {
+    case MAILBOX_CTRL_OFFSET:
+        if (!value) {
+            ret = chan[i].ctrl;
+            busy = ret & MBX_POSTED;
+        } else if (chan[i].sts == 0) {
+            /* Posting a channel that is not free is ignored */
+            chan[i].ctrl = *value;
+            if (*value & MBX_POSTED) {
+                chan[i].sts = 3;
+                chan[i].poster = self;
+                stats.posts[i]++;
+                posted = 1;
+            }
+        }
+        break;
+    case MAILBOX_STATUS_OFFSET:
+        if (!value) {
+            ret = chan[i].sts;
+            busy = !ret;
+        } else {
+            chan[i].sts &= ~*value;
+            if (chan[i].sts == 0) {
+                chan[i].ctrl &= ~MBX_POSTED;
+            }
+        }
+        break;
+    default:
+        if (!value) {
+            ret = chan[i].data[(offset - MAILBOX_DATA0_OFFSET) / 4];
+        } else {
+            chan[i].data[(offset - MAILBOX_DATA0_OFFSET) / 4] = *value;
+        }
+        break;
+    }
+    if (posted) {
+        pthread_cond_signal(&cores[!self].cond);
+    }
+    pthread_mutex_unlock(&lock);
+    /* The cores run in parallel on the SoC: the other one gets to run while
+     * this one waits on a register */
+    if (posted || busy) {
+        sched_yield();
+    }
+    return ret;
+}
+
+mbx_model_reg::~mbx_model_reg()
+{
+    if (!used) {
+        model_access(chan, offset, NULL);
+    }
+}
+
+mbx_model_reg::operator uint32_t() const
+{
+    used = true;
+    return model_access(chan, offset, NULL);
+}
+
+mbx_model_reg &mbx_model_reg::operator=(uint32_t value)
+{
+    used = true;
+    model_access(chan, offset, &value);
+    return *this;
+}
+
+void mbx_model_unmask(int i)
+{
+    pthread_mutex_lock(&lock);
+    cores[self].unmasked |= 1 << i;
+    pthread_mutex_unlock(&lock);
+}
+
+/* Cores */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Waits for a signal of the core until the deadline, with the lock held */
+static void wait_until(uint64_t deadline)
+{
+    struct timespec ts;
+
+    ts.tv_sec = deadline / 1000000000;
+    ts.tv_nsec = deadline % 1000000000;
+    pthread_cond_timedwait(&cores[self].cond, &lock, &ts);
+}
+
+static void *core_thread(void *arg)
+{
+    self = (int)(intptr_t)arg;
+    cores[self].main(self);
+    return NULL;
+}
+
+void mbx_cores_init(void)
+{
+    pthread_condattr_t attr;
+    int i;
+
+    if ((uintptr_t)&blocks[BLOCKS - 1] >> 32) {
+        model_error("blocks above 4 GiB, link with -no-pie");
+    }
+    memset(&mbx_model_shared_block, 0, sizeof(mbx_model_shared_block));
+    memset(chan, 0, sizeof(chan));
+    memset(&stats, 0, sizeof(stats));
+    free_blocks = NULL;
+    for (i = BLOCKS - 1; i >= 0; i--) {
+        ((list_t *)blocks[i])->next = free_blocks;
+        free_blocks = (list_t *)blocks[i];
+    }
+    used_blocks = 0;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    for (i = 0; i < MBX_CORES; i++) {
+        memset(&cores[i], 0, sizeof(cores[i]));
+        pthread_cond_init(&cores[i].cond, &attr);
+    }
+    pthread_condattr_destroy(&attr);
+}
+
+void mbx_cores_run(void (*main)(int core), void (*const isr[MBX_CORES])(void))
+{
+    int i;
+
+    for (i = 0; i < MBX_CORES; i++) {
+        cores[i].main = main;
+        cores[i].isr = isr[i];
+    }
+    for (i = 0; i < MBX_CORES; i++) {
+        pthread_create(&cores[i].thread, NULL, core_thread, (void *)(intptr_t)i);
+    }
+    for (i = 0; i < MBX_CORES; i++) {
+        pthread_join(cores[i].thread, NULL);
+    }
+}
+
+int mbx_cores_self(void)
+{
+    return self;
+}
+
+void mbx_cores_idle(int ms)
+{
+    struct core *c = &cores[self];
+    list_t *msg;
+
+    check_irq();
+    pthread_mutex_lock(&lock);
+    if (!c->port_head && !irq_raised(self)) {
+        wait_until(now_ns() + (uint64_t)ms * 1000000);
+    }
+    while ((msg = c->port_head)) {
+        c->port_head = msg->next;
+        pthread_mutex_unlock(&lock);
+        c->port_handler((struct message *)msg, c->port_param);
+        pthread_mutex_lock(&lock);
+    }
+    pthread_mutex_unlock(&lock);
+    check_irq();
+}
+
+uint32_t mbx_cores_blocks(void)
+{
+    return used_blocks;
+}
+
+const struct mbx_cores_stats *mbx_cores_get_stats(void)
+{
+    return &stats;
+}
+
+/* OS layer */
+
+extern "C" {
+
+uint32_t interrupt_lock(void)
+{
+    return cores[self].locked++;
+}
+
+void interrupt_unlock(uint32_t key)
+{
+    cores[self].locked = key;
+    check_irq();
+}
+
+uint32_t get_uptime_ms(void)
+{
+    return now_ns() / 1000000;
+}
+
+void *balloc(uint32_t size, OS_ERR_TYPE *err)
+{
+    void *block;
+
+    if (size > BLOCK_SIZE) {
+        model_error("balloc() of a large block");
+    }
+    pthread_mutex_lock(&lock);
+    block = free_blocks;
+    if (block) {
+        free_blocks = free_blocks->next;
+        used_blocks++;
+    }
+    pthread_mutex_unlock(&lock);
+    if (err) {
+        *err = block ? E_OS_OK : E_OS_ERR_NO_MEMORY;
+    }
+    return block;
+}
+
+OS_ERR_TYPE bfree(void *buffer)
+{
+    pthread_mutex_lock(&lock);
+    ((list_t *)buffer)->next = free_blocks;
+    free_blocks = (list_t *)buffer;
+    used_blocks--;
+    pthread_mutex_unlock(&lock);
+    return E_OS_OK;
+}
+
+T_SEMAPHORE semaphore_create(uint32_t initialCount, OS_ERR_TYPE *err)
+{
+    struct sim_semaphore *sem = (struct sim_semaphore *)malloc(sizeof(*sem));
+
+    sem->count = initialCount;
+    if (err) {
+        *err = E_OS_OK;
+    }
+    return sem;
+}
+
+void semaphore_delete(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
+{
+    free(semaphore);
+}
+
+void semaphore_give(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
+{
+    int i;
+
+    pthread_mutex_lock(&lock);
+    ((struct sim_semaphore *)semaphore)->count++;
+    for (i = 0; i < MBX_CORES; i++) {
+        pthread_cond_signal(&cores[i].cond);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+OS_ERR_TYPE semaphore_take(T_SEMAPHORE semaphore, int timeout)
+{
+    struct sim_semaphore *sem = (struct sim_semaphore *)semaphore;
+    uint64_t deadline = now_ns() + (uint64_t)timeout * 1000000;
+    OS_ERR_TYPE ret = E_OS_OK;
+
+    if (timeout == OS_WAIT_FOREVER || cores[self].locked || cores[self].in_isr) {
+        model_error("semaphore taken forever or with interrupts locked");
+    }
+    pthread_mutex_lock(&lock);
+    while (sem->count == 0) {
+        if (irq_raised(self)) {
+            pthread_mutex_unlock(&lock);
+            check_irq();
+            pthread_mutex_lock(&lock);
+        } else if (now_ns() >= deadline) {
+            ret = E_OS_ERR_BUSY;
+            break;
+        } else {
+            wait_until(deadline);
+        }
+    }
+    if (ret == E_OS_OK) {
+        sem->count--;
+    }
+    pthread_mutex_unlock(&lock);
+    return ret;
+}
+
+uint16_t port_alloc(void *queue)
+{
+    return self + 1;
+}
+
+void port_set_handler(uint16_t port_id, void (*handler)(struct message *, void *),
+                      void *param)
+{
+    cores[port_id - 1].port_handler = handler;
+    cores[port_id - 1].port_param = param;
+}
+
+int port_send_message(struct message *msg)
+{
+    struct core *c = &cores[MESSAGE_DST(msg) - 1];
+
+    pthread_mutex_lock(&lock);
+    msg->l.next = NULL;
+    if (c->port_head) {
+        c->port_tail->next = &msg->l;
+    } else {
+        c->port_head = &msg->l;
+    }
+    c->port_tail = &msg->l;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&lock);
+    return E_OS_OK;
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    if (level == LOG_LEVEL_ERROR) {
+        pthread_mutex_lock(&lock);
+        stats.errors++;
+        pthread_mutex_unlock(&lock);
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MBX_CORES_H
+#define MBX_CORES_H
+
+/*
+ * Host model of QRK and ARC exchanging messages through ipc.c: a thread per
+ * core, each running its own build of ipc.c (see ipc_host.h) over the same
+ * mailboxes and shared memory block.
+ *
+ * The mailbox registers behave as in mbx_model.h, a channel raising the
+ * interrupt of the core that did not post it. The interrupt of a core runs
+ * on its thread, at its first register access, interrupt unlock or wait
+ * after the interrupt is raised with interrupts unlocked. Posting a channel,
+ * or reading a busy one, yields the host CPU so that the other core gets to
+ * run.
+ *
+ * A core thread is its task context: port messages (the IPC port task of
+ * ipc_async_init()) are handled in mbx_cores_idle(). Time is the host time.
+ * balloc() returns blocks below 4 GiB, as message pointers travel through
+ * 32 bit mailbox registers and ring entries.
+ */
+
+#include <stdint.h>
+
+#define MBX_CORES     2
+#define MBX_CORE_QRK  0
+#define MBX_CORE_ARC  1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mbx_cores_stats {
+    uint32_t posts[8];          /*!< posts of each channel */
+    uint32_t irqs[MBX_CORES];   /*!< mailbox interrupts of each core */
+    uint32_t errors;            /*!< error logs */
+};
+
+/** Resets the mailboxes, the shared memory block and the allocator */
+void mbx_cores_init(void);
+
+/**
+ * Runs main on a thread per core until both return.
+ *
+ * @param main entry point of the task context, given the core
+ * @param isr  mailbox interrupt routine of each core
+ */
+void mbx_cores_run(void (*main)(int core), void (*const isr[MBX_CORES])(void));
+
+/** Core of the calling thread */
+int mbx_cores_self(void);
+
+/**
+ * Handles the port messages of the calling core, or waits up to ms for one
+ * or for an interrupt.
+ */
+void mbx_cores_idle(int ms);
+
+/** Blocks allocated by balloc() and not freed */
+uint32_t mbx_cores_blocks(void);
+
+/** Counters since mbx_cores_init() */
+const struct mbx_cores_stats *mbx_cores_get_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBX_CORES_H */
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "machine.h"
+
+extern "C" {
+#include "os/os.h"
+#include "infra/port.h"
+#include "infra/ipc_requests.h"
+#include "infra/log.h"
+#include "infra/time.h"
+}
+
+#define MBX_CHANNELS 8
+#define MBX_POSTED   0x80000000
+#define MBX_SEQ(ctrl) (((ctrl) >> 8) & 0xffff)
+
+#define MAX_EVENTS   8
+
+enum event_type {
+    PEER_ACK,           /* the remote acks the request on MBX_MODEL_TX */
+    PEER_READ_ACK,      /* the remote reads the ack on MBX_MODEL_TX_ACK */
+};
+
+struct event {
+    uint64_t at;
+    enum event_type type;
+};
+
+struct sim_semaphore {
+    uint32_t count;
+};
+
+static struct {
+    struct {
+        uint32_t ctrl;
+        uint32_t data[4];
+        uint32_t sts;
+    } chan[MBX_CHANNELS];
+    uint32_t unmasked;
+
+    uint64_t now;
+    struct event events[MAX_EVENTS];
+    int event_count;
+
+    int locked;
+    int in_isr;
+    void (*isr)(void);
+
+    struct mbx_model_peer peer;
+    struct mbx_model_request last;
+    uint32_t *request_ret;
+    uint16_t *request_seq;
+
+    struct mbx_model_stats stats;
+} m;
+
+static void model_error(const char *error)
+{
+    fprintf(stderr, "mailbox model: %s\n", error);
+    exit(2);
+}
+
+/* Events */
+
+static void schedule(uint64_t at, enum event_type type)
+{
+    if (m.event_count == MAX_EVENTS) {
+        model_error("too many pending events");
+    }
+    m.events[m.event_count].at = at;
+    m.events[m.event_count].type = type;
+    m.event_count++;
+}
+
+/* Index of the next event, -1 if none */
+static int next_event(void)
+{
+    int next = -1;
+    int i;
+
+    for (i = 0; i < m.event_count; i++) {
+        if (next < 0 || m.events[i].at < m.events[next].at) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+static void post(int chan, uint32_t ctrl);
+
+static void peer_ack(void)
+{
+    uint32_t *data = m.chan[MBX_MODEL_TX].data;
+    uint16_t seq = MBX_SEQ(m.chan[MBX_MODEL_TX].ctrl);
+
+    m.last.data[0] = data[0];
+    m.last.data[1] = data[1];
+    m.last.data[2] = data[2];
+    m.last.data[3] = data[3];
+    m.last.seq = seq;
+
+    /* Same order as ipc_handle_message(): the ack, then the channel */
+    if (m.chan[MBX_MODEL_RX_ACK].sts) {
+        model_error("ack posted before the previous one was read");
+    }
+    m.chan[MBX_MODEL_RX_ACK].data[0] = data[0] + data[1];
+    post(MBX_MODEL_RX_ACK, MBX_POSTED | (m.peer.seq ? seq << 8 : 0));
+    m.stats.acks++;
+    m.chan[MBX_MODEL_TX].sts = 0;
+    m.chan[MBX_MODEL_TX].ctrl &= ~MBX_POSTED;
+}
+
+static void peer_read_ack(void)
+{
+    if (m.request_ret) {
+        *m.request_ret = m.chan[MBX_MODEL_TX_ACK].data[0];
+        *m.request_seq = MBX_SEQ(m.chan[MBX_MODEL_TX_ACK].ctrl);
+        m.request_ret = NULL;
+    }
+    m.chan[MBX_MODEL_TX_ACK].sts = 0;
+    m.chan[MBX_MODEL_TX_ACK].ctrl &= ~MBX_POSTED;
+}
+
+static void run_event(int i)
+{
+    enum event_type type = m.events[i].type;
+
+    m.events[i] = m.events[--m.event_count];
+    switch (type) {
+    case PEER_ACK:
+        peer_ack();
+        break;
+    case PEER_READ_ACK:
+        peer_read_ack();
+        break;
+    }
+}
+
+/* Local interrupt */
+
+static int irq_raised(void)
+{
+    return ((m.chan[MBX_MODEL_RX].sts & 2) && (m.unmasked & (1 << MBX_MODEL_RX))) ||
+           ((m.chan[MBX_MODEL_RX_ACK].sts & 2) &&
+            (m.unmasked & (1 << MBX_MODEL_RX_ACK)));
+}
+
+static void check_irq(void)
+{
+    int count = 0;
+
+    if (m.locked || m.in_isr) {
+        return;
+    }
+    while (irq_raised()) {
+        if (++count > 100) {
+            model_error("interrupt never cleared");
+        }
+        m.in_isr = 1;
+        m.stats.irqs++;
+        m.now += MBX_MODEL_IRQ_NS;
+        m.isr();
+        m.in_isr = 0;
+    }
+}
+
+/* Runs the events due, then the interrupt if raised */
+static void advance(uint64_t ns)
+{
+    int i;
+
+    m.now += ns;
+    while ((i = next_event()) >= 0 && m.events[i].at <= m.now) {
+        run_event(i);
+    }
+    check_irq();
+}
+
+static int run_next(uint64_t deadline)
+{
+    int i;
+
+    check_irq();
+    i = next_event();
+    if (i < 0 || m.events[i].at > deadline) {
+        if (deadline > m.now) {
+            m.stats.idle_ns += deadline - m.now;
+            m.now = deadline;
+        }
+        return 0;
+    }
+    if (m.events[i].at > m.now) {
+        m.stats.idle_ns += m.events[i].at - m.now;
+        m.now = m.events[i].at;
+    }
+    run_event(i);
+    check_irq();
+    return 1;
+}
+
+/* Mailboxes */
+
+static void post(int chan, uint32_t ctrl)
+{
+    m.chan[chan].ctrl = ctrl;
+    m.chan[chan].sts = 3;
+    if (chan == MBX_MODEL_TX) {
+        m.stats.requests++;
+        if (m.stats.requests == m.peer.late_request) {
+            schedule(m.now + m.peer.late_ns, PEER_ACK);
+        } else {
+            schedule(m.now + m.peer.ack_ns, PEER_ACK);
+        }
+    } else if (chan == MBX_MODEL_TX_ACK) {
+        schedule(m.now, PEER_READ_ACK);
+    }
+}
+
+static uint32_t model_read(int chan, int offset)
+{
+    m.stats.reg_accesses++;
+    advance(MBX_MODEL_REG_NS);
+    switch (offset) {
+    case MAILBOX_CTRL_OFFSET:
+        return m.chan[chan].ctrl;
+    case MAILBOX_STATUS_OFFSET:
+        return m.chan[chan].sts;
+    default:
+        return m.chan[chan].data[(offset - MAILBOX_DATA0_OFFSET) / 4];
+    }
+}
+
+static void model_write(int chan, int offset, uint32_t value)
+{
+    m.stats.reg_accesses++;
+    advance(MBX_MODEL_REG_NS);
+    switch (offset) {
+    case MAILBOX_CTRL_OFFSET:
+        if (chan != MBX_MODEL_TX && chan != MBX_MODEL_TX_ACK &&
+            chan != MBX_MODEL_RX) {
+            model_error("write of the CTRL of a remote channel");
+        }
+        /* Posting a channel that is not free is ignored */
+        if (m.chan[chan].sts == 0) {
+            if (value & MBX_POSTED) {
+                post(chan, value);
+            } else {
+                m.chan[chan].ctrl = value;
+            }
+        }
+        break;
+    case MAILBOX_STATUS_OFFSET:
+        m.chan[chan].sts &= ~value;
+        if (m.chan[chan].sts == 0) {
+            m.chan[chan].ctrl &= ~MBX_POSTED;
+        }
+        break;
+    default:
+        m.chan[chan].data[(offset - MAILBOX_DATA0_OFFSET) / 4] = value;
+        break;
+    }
+}
+
+mbx_model_reg::~mbx_model_reg()
+{
+    if (!used) {
+        model_read(chan, offset);
+    }
+}
+
+mbx_model_reg::operator uint32_t() const
+{
+    used = true;
+    return model_read(chan, offset);
+}
+
+mbx_model_reg &mbx_model_reg::operator=(uint32_t value)
+{
+    used = true;
+    model_write(chan, offset, value);
+    return *this;
+}
+
+void mbx_model_init(const struct mbx_model_peer *peer, void (*isr)(void))
+{
+    m = {};
+    m.peer = *peer;
+    m.isr = isr;
+}
+
+void mbx_model_unmask(int chan)
+{
+    m.unmasked |= 1 << chan;
+}
+
+uint64_t mbx_model_now(void)
+{
+    return m.now;
+}
+
+const struct mbx_model_stats *mbx_model_get_stats(void)
+{
+    return &m.stats;
+}
+
+const struct mbx_model_request *mbx_model_last_request(void)
+{
+    return &m.last;
+}
+
+void mbx_model_run(uint64_t ns)
+{
+    uint64_t deadline = m.now + ns;
+
+    while (run_next(deadline)) {
+    }
+}
+
+void mbx_model_peer_ack(uint32_t ret, uint16_t seq)
+{
+    m.chan[MBX_MODEL_RX_ACK].data[0] = ret;
+    post(MBX_MODEL_RX_ACK, MBX_POSTED | (uint32_t)seq << 8);
+}
+
+void mbx_model_peer_request(const uint32_t data[4], uint16_t seq,
+                            uint32_t *ret, uint16_t *ack_seq)
+{
+    int i;
+
+    if (m.chan[MBX_MODEL_RX].sts) {
+        model_error("request posted on a busy channel");
+    }
+    for (i = 0; i < 4; i++) {
+        m.chan[MBX_MODEL_RX].data[i] = data[i];
+    }
+    m.request_ret = ret;
+    m.request_seq = ack_seq;
+    post(MBX_MODEL_RX, MBX_POSTED | (uint32_t)seq << 8 | IPC_MSG_TYPE_SYNC);
+}
+
+/* OS layer */
+
+extern "C" {
+
+uint32_t interrupt_lock(void)
+{
+    return m.locked++;
+}
+
+void interrupt_unlock(uint32_t key)
+{
+    m.locked = key;
+    check_irq();
+}
+
+uint32_t get_uptime_ms(void)
+{
+    advance(MBX_MODEL_REG_NS);
+    return m.now / 1000000;
+}
+
+void *balloc(uint32_t size, OS_ERR_TYPE *err)
+{
+    if (err) {
+        *err = E_OS_OK;
+    }
+    return malloc(size);
+}
+
+OS_ERR_TYPE bfree(void *buffer)
+{
+    free(buffer);
+    return E_OS_OK;
+}
+
+T_SEMAPHORE semaphore_create(uint32_t initialCount, OS_ERR_TYPE *err)
+{
+    struct sim_semaphore *sem = (struct sim_semaphore *)malloc(sizeof(*sem));
+
+    sem->count = initialCount;
+    if (err) {
+        *err = E_OS_OK;
+    }
+    return sem;
+}
+
+void semaphore_delete(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
+{
+    free(semaphore);
+}
+
+void semaphore_give(T_SEMAPHORE semaphore, OS_ERR_TYPE *err)
+{
+    ((struct sim_semaphore *)semaphore)->count++;
+}
+
+OS_ERR_TYPE semaphore_take(T_SEMAPHORE semaphore, int timeout)
+{
+    struct sim_semaphore *sem = (struct sim_semaphore *)semaphore;
+    uint64_t deadline = (timeout == OS_WAIT_FOREVER) ? UINT64_MAX
+                        : m.now + (uint64_t)timeout * 1000000;
+    int blocked = 0;
+
+    if (m.locked || m.in_isr) {
+        model_error("semaphore taken with interrupts locked");
+    }
+    while (sem->count == 0) {
+        blocked = 1;
+        if (!run_next(deadline)) {
+            if (deadline == UINT64_MAX) {
+                model_error("deadlock: semaphore never given");
+            }
+            return E_OS_ERR_BUSY;
+        }
+    }
+    if (blocked) {
+        m.now += MBX_MODEL_WAKE_NS;
+    }
+    sem->count--;
+    return E_OS_OK;
+}
+
+/* Requests are serialized by the test */
+T_MUTEX mutex_create(OS_ERR_TYPE *err)
+{
+    return &m;
+}
+
+OS_ERR_TYPE mutex_lock(T_MUTEX mutex, int timeout)
+{
+    return E_OS_OK;
+}
+
+void mutex_unlock(T_MUTEX mutex, OS_ERR_TYPE *err)
+{
+}
+
+/* ipc_async_send_message() handlers run at once */
+static void (*port_handler)(struct message *, void *);
+
+uint16_t port_alloc(void *queue)
+{
+    return 1;
+}
+
+void port_set_handler(uint16_t port_id, void (*handler)(struct message *, void *),
+                      void *param)
+{
+    port_handler = handler;
+}
+
+int port_send_message(struct message *msg)
+{
+    port_handler(msg, NULL);
+    return E_OS_OK;
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    return 0;
+}
+
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MBX_MODEL_H
+#define MBX_MODEL_H
+
+/*
+ * Host model of the SoC mailboxes and of the remote core, to run ipc.c on a
+ * host.
+ *
+ * ipc.c runs as the QRK side of the IPC: it sends its requests on channel
+ * MBX_MODEL_TX, receives those of the remote on MBX_MODEL_RX, and the acks
+ * travel on MBX_MODEL_TX_ACK and MBX_MODEL_RX_ACK. The registers accessed by
+ * ipc.c are routed to the model by machine.h of this directory:
+ *  - writing CTRL with bit 31 set posts the channel: STS reads 3 and the
+ *    interrupt of the receiving core is raised,
+ *  - writing 1s to STS clears them. Once STS is clear, the channel is free
+ *    again and CTRL bit 31 reads 0.
+ *
+ * The remote core acks the requests posted to it like ipc_handle_message()
+ * does. It either echoes the sequence number of the request, or acks with a
+ * null one as firmwares predating them do.
+ *
+ * The model also provides the OS layer used by ipc.c. Time is simulated in
+ * ns. A register access and an uptime read take MBX_MODEL_REG_NS. A task
+ * blocked in semaphore_take() idles until the next event. The local mailbox
+ * interrupt runs at the first register access, uptime read or interrupt
+ * unlock after it is raised with interrupts unlocked.
+ */
+
+#include <stdint.h>
+
+#define MBX_MODEL_TX      0
+#define MBX_MODEL_TX_ACK  1
+#define MBX_MODEL_RX      5
+#define MBX_MODEL_RX_ACK  6
+
+/* Register access on the SoC bus */
+#define MBX_MODEL_REG_NS        100
+/* Local mailbox interrupt entry and exit */
+#define MBX_MODEL_IRQ_NS        2000
+/* Switch to a task woken by a semaphore */
+#define MBX_MODEL_WAKE_NS       10000
+/* Remote: from a posted request to its ack */
+#define MBX_MODEL_PEER_NS       20000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mbx_model_peer {
+    int seq;                /*!< echo the sequence numbers */
+    uint64_t ack_ns;        /*!< from a posted request to its ack */
+    /** Request acked after late_ns instead, counted from 1, 0 for none */
+    uint32_t late_request;
+    uint64_t late_ns;
+};
+
+struct mbx_model_stats {
+    uint32_t requests;      /*!< requests posted to the remote */
+    uint32_t acks;          /*!< acks sent by the remote */
+    uint32_t irqs;          /*!< local mailbox interrupts */
+    uint32_t reg_accesses;  /*!< local register accesses */
+    uint64_t idle_ns;       /*!< local time blocked in semaphore_take() */
+};
+
+/** A request received by the remote */
+struct mbx_model_request {
+    uint32_t data[4];
+    uint16_t seq;
+};
+
+/**
+ * Resets the mailboxes, the clock and the remote. The remote answers each
+ * request with its request id plus its first parameter.
+ *
+ * @param peer behaviour of the remote
+ * @param isr  local mailbox interrupt routine
+ */
+void mbx_model_init(const struct mbx_model_peer *peer, void (*isr)(void));
+
+/** Unmasks the local interrupt of a channel */
+void mbx_model_unmask(int chan);
+
+/** Current simulated time in ns */
+uint64_t mbx_model_now(void);
+
+/** Counters since mbx_model_init() */
+const struct mbx_model_stats *mbx_model_get_stats(void);
+
+/** Last request received by the remote */
+const struct mbx_model_request *mbx_model_last_request(void);
+
+/** Runs the model for ns, idle */
+void mbx_model_run(uint64_t ns);
+
+/**
+ * The remote posts an ack on MBX_MODEL_RX_ACK, as a stale or corrupted
+ * one would be.
+ */
+void mbx_model_peer_ack(uint32_t ret, uint16_t seq);
+
+/**
+ * The remote posts a request on MBX_MODEL_RX. Its ack is stored in *ret and
+ * *ack_seq when the local side sends it.
+ */
+void mbx_model_peer_request(const uint32_t data[4], uint16_t seq,
+                            uint32_t *ret, uint16_t *ack_seq);
+
+#ifdef __cplusplus
+}
+
+/*
+ * A mailbox register, accessed by the MBX macros. A register expression
+ * that is neither read nor written is read when it goes out of scope, as a
+ * volatile access would be.
+ */
+class mbx_model_reg {
+public:
+    mbx_model_reg(int chan, int offset) : chan(chan), offset(offset),
+                                          used(false) {}
+    ~mbx_model_reg();
+    operator uint32_t() const;
+    mbx_model_reg &operator=(uint32_t value);
+private:
+    int chan;
+    int offset;
+    mutable bool used;
+};
+#endif
+
+#endif /* MBX_MODEL_H */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks ipc.c against the mailbox model, built with and without
+ * CONFIG_IPC_ASYNC_REQUESTS:
+ *  - requests in both directions get their answer, with a remote echoing the
+ *    sequence numbers and with one predating them,
+ *  - a request the remote answers after the timeout fails, and its answer
+ *    is not taken for the one of the next request,
+ *  - stray acks are dropped once the remote echoed a sequence number, also
+ *    after the sequence numbers wrap,
+ *  - queued requests complete in submission order.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "mbx_model.h"
+#include "infra/ipc.h"
+
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+#define TEST_NAME "test_ipc"
+#else
+#define TEST_NAME "test_ipc_sync"
+#endif
+
+#define CPU_ID_REMOTE 1
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* The remote answers request + param1 */
+#define ANSWER(request, param1) ((request) + (param1))
+
+int ipc_sync_callback(uint8_t cpu_id, int request, int param1, int param2,
+                      void *ptr)
+{
+    return cpu_id == CPU_ID_REMOTE ? request * 2 + param2 : -1;
+}
+
+static void setup(int seq)
+{
+    struct mbx_model_peer peer = {
+        .seq = seq,
+        .ack_ns = MBX_MODEL_PEER_NS,
+    };
+
+    mbx_model_init(&peer, ipc_handle_message);
+    mbx_model_unmask(MBX_MODEL_RX);
+    ipc_init(MBX_MODEL_TX, MBX_MODEL_RX, MBX_MODEL_TX_ACK, MBX_MODEL_RX_ACK,
+             CPU_ID_REMOTE);
+}
+
+static void check_requests(int seq)
+{
+    const struct mbx_model_request *last = mbx_model_last_request();
+    uint32_t data[4] = { 21, 0, 4, 0 };
+    uint32_t ret = 0;
+    uint16_t ack_seq = 0;
+    int i;
+
+    setup(seq);
+    for (i = 0; i < 3; i++) {
+        CHECK(ipc_request_sync_int(10 + i, 100, 7, (void *)0x1234) ==
+              ANSWER(10 + i, 100));
+        CHECK(last->data[0] == 10 + i && last->data[2] == 7);
+        CHECK(last->data[3] == 0x1234);
+        CHECK(ipc_request_sync_poll(20 + i, 200, 0, NULL) == ANSWER(20 + i, 200));
+    }
+    CHECK(mbx_model_get_stats()->requests == 6);
+
+    /* The ack echoes the sequence number of the remote request */
+    mbx_model_peer_request(data, 0x1234, &ret, &ack_seq);
+    mbx_model_run(MBX_MODEL_PEER_NS);
+    CHECK(ret == 21 * 2 + 4);
+    CHECK(ack_seq == 0x1234);
+}
+
+static void check_late_ack(void)
+{
+    struct mbx_model_peer peer = {
+        .seq = 1,
+        .ack_ns = MBX_MODEL_PEER_NS,
+        .late_request = 2,
+        .late_ns = 1500000000ULL,
+    };
+
+    mbx_model_init(&peer, ipc_handle_message);
+    ipc_init(MBX_MODEL_TX, MBX_MODEL_RX, MBX_MODEL_TX_ACK, MBX_MODEL_RX_ACK,
+             CPU_ID_REMOTE);
+
+    CHECK(ipc_request_sync_int(1, 1, 0, NULL) == ANSWER(1, 1));
+    /* Times out, then its answer arrives while the next one is queued */
+    CHECK(ipc_request_sync_int(2, 2, 0, NULL) != ANSWER(2, 2));
+    CHECK(mbx_model_now() < 1500000000ULL);
+    CHECK(ipc_request_sync_int(3, 30, 0, NULL) == ANSWER(3, 30));
+    CHECK(ipc_request_sync_int(4, 40, 0, NULL) == ANSWER(4, 40));
+}
+
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+#define REQUESTS 8
+
+static int completed[REQUESTS];
+static int completions;
+
+static void request_done(struct ipc_request *req)
+{
+    completed[completions++] = (int)(intptr_t)req->priv;
+}
+
+static void init_requests(struct ipc_request *req, int count)
+{
+    int i;
+
+    memset(req, 0, count * sizeof(*req));
+    for (i = 0; i < count; i++) {
+        req[i].request_id = 40 + i;
+        req[i].param1 = i * 3;
+        req[i].callback = request_done;
+        req[i].priv = (void *)(intptr_t)i;
+    }
+    completions = 0;
+}
+
+static void check_stray_acks(void)
+{
+    struct ipc_request req[2];
+
+    setup(1);
+    init_requests(req, 2);
+
+    /* A null sequence number is no longer trusted once one was echoed */
+    CHECK(ipc_request_sync_int(1, 1, 0, NULL) == ANSWER(1, 1));
+    ipc_request_submit(&req[0]);
+    mbx_model_peer_ack(666, 0);
+    mbx_model_run(MBX_MODEL_PEER_NS / 2);
+    CHECK(completions == 0);
+    mbx_model_run(MBX_MODEL_PEER_NS);
+    CHECK(completions == 1 && req[0].ret == ANSWER(40, 0));
+
+    /* Nor is the one of another request */
+    ipc_request_submit(&req[1]);
+    mbx_model_peer_ack(667, mbx_model_last_request()->seq);
+    mbx_model_run(MBX_MODEL_PEER_NS / 2);
+    CHECK(completions == 1);
+    mbx_model_run(MBX_MODEL_PEER_NS);
+    CHECK(completions == 2 && req[1].ret == ANSWER(41, 3));
+}
+
+static void check_legacy_stray_ack(void)
+{
+    struct ipc_request req;
+
+    /* Without sequence numbers, any ack completes the request on the wire */
+    setup(0);
+    init_requests(&req, 1);
+    ipc_request_submit(&req);
+    mbx_model_peer_ack(666, 0);
+    mbx_model_run(MBX_MODEL_PEER_NS / 2);
+    CHECK(completions == 1 && req.ret == 666);
+    mbx_model_run(MBX_MODEL_PEER_NS);
+    CHECK(completions == 1);
+}
+
+static void check_seq_wrap(void)
+{
+    struct ipc_request req;
+    int failed = 0;
+    int i;
+
+    setup(1);
+    for (i = 0; i < 0xffff; i++) {
+        if (ipc_request_sync_int(i & 0xff, 1, 0, NULL) != ANSWER(i & 0xff, 1))
+            failed++;
+    }
+    CHECK(failed == 0);
+
+    /* The sequence number wraps, but not to the null one of a stray ack */
+    init_requests(&req, 1);
+    ipc_request_submit(&req);
+    mbx_model_peer_ack(666, 0);
+    mbx_model_run(2 * MBX_MODEL_PEER_NS);
+    CHECK(completions == 1 && req.ret == ANSWER(40, 0));
+}
+
+static void check_queue(void)
+{
+    struct ipc_request req[REQUESTS];
+    int i;
+
+    setup(1);
+    init_requests(req, REQUESTS);
+    for (i = 0; i < REQUESTS; i++) {
+        ipc_request_submit(&req[i]);
+    }
+    mbx_model_run(REQUESTS * 2 * MBX_MODEL_PEER_NS);
+    CHECK(completions == REQUESTS);
+    for (i = 0; i < REQUESTS; i++) {
+        CHECK(completed[i] == i);
+        CHECK(req[i].ret == ANSWER(40 + i, i * 3));
+    }
+    CHECK(mbx_model_get_stats()->requests == REQUESTS);
+}
+#endif
+
+int main(void)
+{
+    check_requests(1);
+    check_requests(0);
+    check_late_ack();
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+    check_stray_acks();
+    check_legacy_stray_ack();
+    check_seq_wrap();
+    check_queue();
+#endif
+
+    printf("%s %s\n", failures ? "FAIL" : "PASS", TEST_NAME);
+    return failures ? 1 : 0;
+}
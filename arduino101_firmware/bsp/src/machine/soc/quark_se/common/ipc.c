@@ -40,6 +40,17 @@
 
 #define MBX_IPC_SYNC_ARC_TO_QRK 5
 
+/* Timeout waiting for the remote acknowledge of a synchronous request */
+#define IPC_SYNC_TIMEOUT_MS 1000
+
+/* The request sequence number is carried in bits 8-23 of the tx CTRL register
+ * and echoed back by the remote in the ack CTRL register. */
+#define IPC_CTRL_SEQ_SHIFT 8
+#define IPC_CTRL_SEQ_MASK (0xffff << IPC_CTRL_SEQ_SHIFT)
+
+/* Number of reads of a busy tx channel before a request is left pending */
+#define IPC_TX_BUSY_SPIN 1000
+
 static int rx_chan = 0;
 static int tx_chan = 0;
 static int tx_ack_chan = 0;
@@ -53,7 +64,32 @@ static uint8_t remote_cpu = 0;
  *
  ****************************************************************************/
 
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+/*
+ * The data mailbox holds a single request, so requests are queued here and
+ * sent one at a time. The acknowledge raises an interrupt on this core, which
+ * completes the request on the wire and sends the next one: callers sleep
+ * instead of polling the ack mailbox.
+ */
+static list_head_t ipc_pending;
+static struct ipc_request *ipc_inflight;
+static uint16_t ipc_seq;
+/* Set once the remote echoed a sequence number. A remote that predates them
+ * acks every request with a null one, which is then matched to the request on
+ * the wire, as before. */
+static bool ipc_peer_seq;
+
+struct ipc_sync_wait {
+    T_SEMAPHORE sem;
+    volatile int done;
+};
+#else
 static T_MUTEX ipc_mutex;
+#endif
+
+#ifdef CONFIG_IPC_MSG_RING
+static void ipc_msg_ring_setup(void);
+#endif
 
 void ipc_init(int tx_channel, int rx_channel, int tx_ack_channel,
     int rx_ack_channel, uint8_t remote_cpu_id)
@@ -63,33 +99,363 @@ void ipc_init(int tx_channel, int rx_channel, int tx_ack_channel,
     tx_ack_chan = tx_ack_channel;
     rx_ack_chan = rx_ack_channel;
     remote_cpu = remote_cpu_id;
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+    list_init(&ipc_pending);
+    ipc_inflight = NULL;
+    ipc_seq = 0;
+    ipc_peer_seq = false;
+    MBX_STS(rx_ack_chan) = 3;
+    SOC_MBX_INT_UNMASK(rx_ack_chan);
+#ifdef CONFIG_IPC_MSG_RING
+    ipc_msg_ring_setup();
+#endif
+#else
     ipc_mutex = mutex_create(NULL);
+#endif
+}
+
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+/* Sends the first pending request if the wire is free. Called with
+ * interrupts locked. */
+static void ipc_tx_kick(void)
+{
+    struct ipc_request *req;
+    int spin = IPC_TX_BUSY_SPIN;
+
+    if (ipc_inflight || list_empty(&ipc_pending))
+        return;
+
+    /* The remote releases the data mailbox right after writing the previous
+     * ack. If it does not, the request stays pending and is sent by the next
+     * ipc_handle_message() call. */
+    while (MBX_CTRL(tx_chan) & 0x80000000) {
+        if (--spin == 0)
+            return;
+    }
+
+    req = (struct ipc_request *)list_get(&ipc_pending);
+    /* 0 is left for the acks of a remote without sequence numbers */
+    if (++ipc_seq == 0)
+        ipc_seq = 1;
+    req->seq = ipc_seq;
+    ipc_inflight = req;
+
+    MBX_STS(rx_ack_chan) = 3;
+
+    MBX_DAT0(tx_chan) = req->request_id;
+    MBX_DAT1(tx_chan) = req->param1;
+    MBX_DAT2(tx_chan) = req->param2;
+    MBX_DAT3(tx_chan) = (uint32_t)(uintptr_t)req->ptr;
+    MBX_CTRL(tx_chan) = 0x80000000 | (req->seq << IPC_CTRL_SEQ_SHIFT) |
+        IPC_MSG_TYPE_SYNC;
+}
+
+/* Completes the request on the wire if its ack was received */
+static void ipc_handle_ack(void)
+{
+    struct ipc_request *req = NULL;
+    uint32_t flags = interrupt_lock();
+
+    if (MBX_STS(rx_ack_chan)) {
+        uint16_t seq = (MBX_CTRL(rx_ack_chan) & IPC_CTRL_SEQ_MASK) >>
+            IPC_CTRL_SEQ_SHIFT;
+        int ret = MBX_DAT0(rx_ack_chan);
+
+        MBX_DAT0(rx_ack_chan) = 0;
+        MBX_STS(rx_ack_chan) = 3;
+        if (seq)
+            ipc_peer_seq = true;
+        /* Acks of timed out requests are dropped */
+        if (ipc_inflight &&
+            (ipc_inflight->seq == seq || (!seq && !ipc_peer_seq))) {
+            req = ipc_inflight;
+            req->ret = ret;
+            ipc_inflight = NULL;
+        }
+    }
+    ipc_tx_kick();
+    /* Completed under the lock: a waiter that timed out meanwhile either
+     * still sees its request on the wire, or sees it done, and never returns
+     * while its request is being used here. */
+    if (req)
+        req->callback(req);
+    interrupt_unlock(flags);
+}
+
+void ipc_request_submit(struct ipc_request *req)
+{
+    uint32_t flags = interrupt_lock();
+
+    list_add(&ipc_pending, &req->list);
+    ipc_tx_kick();
+    interrupt_unlock(flags);
+}
+
+/* Removes a timed out request from the pending list or from the wire */
+static void ipc_request_cancel(struct ipc_request *req)
+{
+    uint32_t flags = interrupt_lock();
+
+    if (ipc_inflight == req)
+        ipc_inflight = NULL;
+    else
+        list_remove(&ipc_pending, &req->list);
+    ipc_tx_kick();
+    interrupt_unlock(flags);
+}
+
+static void ipc_sync_done(struct ipc_request *req)
+{
+    struct ipc_sync_wait *wait = (struct ipc_sync_wait *)req->priv;
+
+    wait->done = 1;
+    if (wait->sem)
+        semaphore_give(wait->sem, NULL);
+}
+
+static int ipc_request_wait(int request_id, int param1, int param2,
+    void *ptr, bool poll)
+{
+    struct ipc_sync_wait wait = { .sem = NULL, .done = 0 };
+    struct ipc_request req = {
+        .request_id = request_id,
+        .param1 = param1,
+        .param2 = param2,
+        .ptr = ptr,
+        .ret = -1,
+        .callback = ipc_sync_done,
+        .priv = &wait,
+    };
+    uint32_t start;
+    OS_ERR_TYPE err = E_OS_OK;
+
+    /* Sleep on a semaphore when allowed, otherwise (interrupt context,
+     * exhausted semaphore pool, panic) poll the mailbox. */
+    if (!poll) {
+        wait.sem = semaphore_create(0, &err);
+        if (err != E_OS_OK)
+            wait.sem = NULL;
+    }
+
+    pr_debug(LOG_MODULE_MAIN, "send request %d from: %p", request_id, &req);
+    ipc_request_submit(&req);
+
+    if (wait.sem) {
+        semaphore_take(wait.sem, IPC_SYNC_TIMEOUT_MS);
+    } else {
+        start = get_uptime_ms();
+        while (!wait.done &&
+               (get_uptime_ms() - start) < IPC_SYNC_TIMEOUT_MS)
+            ipc_handle_message();
+    }
+
+    if (!wait.done) {
+        /* Last chance if the ack interrupt was missed */
+        ipc_handle_ack();
+    }
+    if (!wait.done) {
+        ipc_request_cancel(&req);
+        /* The ack may have completed the request before it was cancelled */
+        if (!wait.done)
+            pr_error(LOG_MODULE_MAIN, "Timeout waiting ack %p", request_id);
+    }
+    if (wait.sem)
+        semaphore_delete(wait.sem, NULL);
+
+    pr_debug(LOG_MODULE_MAIN, "ipc_request_sync returns: [%d] %p", rx_ack_chan,
+            req.ret);
+    return req.ret;
+}
+#endif
+
+#ifdef CONFIG_IPC_MSG_RING
+/* Ring entries are message pointers, with bit 0 set for a message free */
+#define IPC_MSG_RING_FREE 1
+
+#define ipc_barrier() __asm__ __volatile__("" ::: "memory")
+
+#ifdef CONFIG_QUARK
+static struct ipc_msg_rings ipc_msg_rings;
+#endif
+static struct ipc_msg_ring *ipc_tx_ring;
+static struct ipc_msg_ring *ipc_rx_ring;
+
+/* Messages and frees waiting for room in the tx ring */
+static list_head_t ipc_tx_overflow;
+static list_head_t ipc_free_overflow;
+
+/* A single doorbell is in flight: it covers all the entries posted before
+ * the remote acknowledges it. */
+static struct ipc_request ipc_doorbell;
+static bool ipc_doorbell_busy;
+static uint32_t ipc_doorbell_time;
+
+static int ipc_msg_ring_put(uint32_t entry)
+{
+    uint32_t head = ipc_tx_ring->head;
+
+    if (head - ipc_tx_ring->tail >= IPC_MSG_RING_SIZE)
+        return -1;
+    ipc_tx_ring->entries[head & (IPC_MSG_RING_SIZE - 1)] = entry;
+    ipc_barrier();
+    ipc_tx_ring->head = head + 1;
+    return 0;
+}
+
+/* Moves the waiting entries to the tx ring, and rings the doorbell if the
+ * remote has entries to read. Called with interrupts locked. */
+static void ipc_msg_ring_flush(void)
+{
+    list_t *l;
+
+    while ((l = ipc_free_overflow.head) &&
+           !ipc_msg_ring_put((uint32_t)(uintptr_t)l | IPC_MSG_RING_FREE))
+        list_get(&ipc_free_overflow);
+    while ((l = ipc_tx_overflow.head) &&
+           !ipc_msg_ring_put((uint32_t)(uintptr_t)l))
+        list_get(&ipc_tx_overflow);
+
+    if (ipc_tx_ring->head == ipc_tx_ring->tail)
+        return;
+    /* Ring again if the doorbell was lost, or its ack was dropped */
+    if (ipc_doorbell_busy &&
+        (get_uptime_ms() - ipc_doorbell_time) >= IPC_SYNC_TIMEOUT_MS) {
+        ipc_request_cancel(&ipc_doorbell);
+        ipc_doorbell_busy = false;
+    }
+    if (!ipc_doorbell_busy) {
+        ipc_doorbell_busy = true;
+        ipc_doorbell_time = get_uptime_ms();
+        ipc_request_submit(&ipc_doorbell);
+    }
 }
 
+static void ipc_doorbell_done(struct ipc_request *req)
+{
+    uint32_t flags = interrupt_lock();
+
+    /* The remote drained the ring before acknowledging: ring again only for
+     * the entries posted since. */
+    ipc_doorbell_busy = false;
+    ipc_msg_ring_flush();
+    interrupt_unlock(flags);
+}
+
+static void ipc_msg_ring_send(struct message *message, list_head_t *overflow)
+{
+    uint32_t flags = interrupt_lock();
+
+    list_add(overflow, &message->l);
+    ipc_msg_ring_flush();
+    interrupt_unlock(flags);
+}
+
+void ipc_msg_ring_drain(void)
+{
+    uint32_t tail;
+    uint32_t entry;
+
+    if (!ipc_rx_ring)
+        return;
+
+    tail = ipc_rx_ring->tail;
+    while (tail != ipc_rx_ring->head) {
+        ipc_barrier();
+        entry = ipc_rx_ring->entries[tail & (IPC_MSG_RING_SIZE - 1)];
+        ipc_rx_ring->tail = ++tail;
+        if (entry & IPC_MSG_RING_FREE)
+            ipc_sync_callback(remote_cpu, IPC_MSG_TYPE_FREE, 0, 0,
+                    (void *)(uintptr_t)(entry & ~IPC_MSG_RING_FREE));
+        else
+            ipc_sync_callback(remote_cpu, IPC_MSG_TYPE_MESSAGE, 0, 0,
+                    (void *)(uintptr_t)entry);
+    }
+}
+
+/* Returns true if messages are sent through the tx ring */
+static bool ipc_msg_ring_ready(void)
+{
+#ifdef CONFIG_QUARK
+    /* ARC sets the flag before it reports ready, so no message was sent to
+     * it through the mailbox before */
+    if (!ipc_tx_ring && shared_data->arc_ipc_msg_ring)
+        ipc_tx_ring = &ipc_msg_rings.ring[0];
+#endif
+    return ipc_tx_ring != NULL;
+}
+
+static void ipc_msg_ring_setup(void)
+{
+#ifdef CONFIG_QUARK
+    /* The tx ring is used once ARC tells it reads it */
+    ipc_tx_ring = NULL;
+    ipc_rx_ring = &ipc_msg_rings.ring[1];
+    shared_data->arc_ipc_msg_ring = 0;
+    shared_data->ipc_msg_rings = &ipc_msg_rings;
+#else
+    struct ipc_msg_rings *rings = shared_data->ipc_msg_rings;
+
+    /* Keep sending messages through the mailbox if QRK has no rings */
+    if (rings) {
+        ipc_tx_ring = &rings->ring[1];
+        ipc_rx_ring = &rings->ring[0];
+        shared_data->arc_ipc_msg_ring = 1;
+    }
+#endif
+    list_init(&ipc_tx_overflow);
+    list_init(&ipc_free_overflow);
+    ipc_doorbell.request_id = IPC_REQUEST_MSG_RING;
+    ipc_doorbell.callback = ipc_doorbell_done;
+}
+#endif
+
 void ipc_handle_message()
 {
     int ret = 0;
+    uint32_t seq;
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+    ipc_handle_ack();
+#endif
+#ifdef CONFIG_IPC_MSG_RING
+    if (ipc_tx_ring) {
+        uint32_t flags = interrupt_lock();
+        ipc_msg_ring_flush();
+        interrupt_unlock(flags);
+    }
+#endif
     if (!MBX_STS(rx_chan)) return;
     int request = MBX_DAT0(rx_chan);
     int param1 = MBX_DAT1(rx_chan);
     int param2 = MBX_DAT2(rx_chan);
-    void * ptr = (void *)MBX_DAT3(rx_chan);
+    void * ptr = (void *)(uintptr_t)MBX_DAT3(rx_chan);
+    seq = MBX_CTRL(rx_chan) & IPC_CTRL_SEQ_MASK;
 
     ret = ipc_sync_callback(remote_cpu, request, param1, param2, ptr);
 
     MBX_CTRL(rx_chan) = 0x80000000;
 
     MBX_DAT0(tx_ack_chan) = ret;
-    MBX_CTRL(tx_ack_chan) = 0x80000000;
+    MBX_CTRL(tx_ack_chan) = 0x80000000 | seq;
     pr_debug(LOG_MODULE_MAIN, "read message on %d : ack [%d] %p", rx_chan, tx_ack_chan,
             MBX_DAT0(tx_ack_chan));
     MBX_STS(rx_chan) = 3;
 }
 
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+int ipc_request_sync_int(int request_id, int param1, int param2, void * ptr)
+{
+    return ipc_request_wait(request_id, param1, param2, ptr, false);
+}
+
+int ipc_request_sync_poll(int request_id, int param1, int param2, void * ptr)
+{
+    return ipc_request_wait(request_id, param1, param2, ptr, true);
+}
+#else
 int ipc_request_sync_int(int request_id, int param1, int param2, void * ptr)
 {
     int ret;
-    int timeout;
+    uint32_t start;
     ret = mutex_lock(ipc_mutex, OS_WAIT_FOREVER);
     if (ret != E_OS_OK) {
         pr_error(LOG_MODULE_MAIN, "Error locking ipc %d", ret);
@@ -108,12 +474,12 @@ int ipc_request_sync_int(int request_id, int param1, int param2, void * ptr)
     MBX_DAT0(tx_chan) = request_id;
     MBX_DAT1(tx_chan) = param1;
     MBX_DAT2(tx_chan) = param2;
-    MBX_DAT3(tx_chan) = (unsigned int )ptr;
+    MBX_DAT3(tx_chan) = (uint32_t)(uintptr_t)ptr;
     MBX_CTRL(tx_chan) = 0x80000000 | IPC_MSG_TYPE_SYNC;
 
-    timeout = get_uptime_ms() + 1000;
+    start = get_uptime_ms();
     while(!MBX_STS(rx_ack_chan)) {
-        if (get_uptime_ms() > timeout) {
+        if ((get_uptime_ms() - start) >= IPC_SYNC_TIMEOUT_MS) {
             pr_error(LOG_MODULE_MAIN, "Timeout waiting ack %p", request_id);
             break;
         }
@@ -126,6 +492,12 @@ int ipc_request_sync_int(int request_id, int param1, int param2, void * ptr)
     return ret;
 }
 
+int ipc_request_sync_poll(int request_id, int param1, int param2, void * ptr)
+{
+    return ipc_request_sync_int(request_id, param1, param2, ptr);
+}
+#endif
+
 #define IPC_MESSAGE_SEND 1
 #define IPC_MESSAGE_FREE 2
 
@@ -189,11 +561,23 @@ static int ipc_request_send(uint16_t msgid, void * message)
 
 int ipc_async_send_message(struct message *message)
 {
+#ifdef CONFIG_IPC_MSG_RING
+	if (ipc_msg_ring_ready()) {
+		ipc_msg_ring_send(message, &ipc_tx_overflow);
+		return E_OS_OK;
+	}
+#endif
 	return ipc_request_send(IPC_MESSAGE_SEND, message);
 }
 
 void ipc_async_free_message(struct message *message)
 {
+#ifdef CONFIG_IPC_MSG_RING
+	if (ipc_msg_ring_ready()) {
+		ipc_msg_ring_send(message, &ipc_free_overflow);
+		return;
+	}
+#endif
 	ipc_request_send(IPC_MESSAGE_FREE, message);
 }
 
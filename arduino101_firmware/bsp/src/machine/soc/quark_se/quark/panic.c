@@ -195,7 +195,7 @@ void panic_notify(int timeout)
 #ifdef CONFIG_IPC
     if (!panic_core_status[ARC_CORE].is_panic) {
         // Send IPC notification to trigger panic on ARC
-        ipc_request_sync_int(IPC_PANIC_NOTIFICATION, 0, 0, NULL);
+        ipc_request_sync_poll(IPC_PANIC_NOTIFICATION, 0, 0, NULL);
     }
 #endif
 #ifdef CONFIG_IPC_UART
@@ -171,24 +171,33 @@ void mbx_out_channel()
 
 static void (*ipc_message_handler) () = NULL;
 
+/* Channel 6 carries the acknowledges of the IPC requests sent to ARC */
+#ifdef CONFIG_IPC_ASYNC_REQUESTS
+#define MBX_ISR_LAST_CHANNEL 7
+#define MBX_ISR_CHALL_MASK 0x1500
+#else
+#define MBX_ISR_LAST_CHANNEL 6
+#define MBX_ISR_CHALL_MASK 0x0500
+#endif
+
 void mbxIsr(int param)
 {
 	do {
 		int i;
-		for (i = 4; i < 6; i++) {
+		for (i = 4; i < MBX_ISR_LAST_CHANNEL; i++) {
 			int sts = MBX_STS(i);
 			if (MBX_STS(i) & 0x2) {
 				if (i == 4) {
 					mbx_out_channel();
 					MBX_STS(i) = sts;
-				} else if ((i == 5) && ipc_message_handler) {
+				} else if ((i >= 5) && ipc_message_handler) {
 					ipc_message_handler();
 				} else
 					MBX_STS(i) = sts;
 			} else
 				MBX_STS(i) = sts;
 		}
-	} while (MBX_CHALL_STS & 0x0500);
+	} while (MBX_CHALL_STS & MBX_ISR_CHALL_MASK);
 }
 
 void soc_setup(void (*handler) ())
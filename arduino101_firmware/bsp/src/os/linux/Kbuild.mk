@@ -0,0 +1,6 @@
+obj-y += balloc.o
+obj-y += common.o
+obj-y += interrupt.o
+obj-y += queue.o
+obj-y += sync.o
+obj-y += timer.o
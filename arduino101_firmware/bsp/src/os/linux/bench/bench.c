@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file bench.c
+ *
+ * Host benchmarks of the OS abstraction layer and of the port layer, on top
+ * of the LINUX port:
+ * - message round trip between two ports served by two threads
+ * - event fan-out to several ports, with a copy per port or a shared message
+ * - balloc/bfree and message_alloc/message_free
+ * - timer lateness of a periodic timer
+ *
+ * Numbers compare changes of the common code on the same host, they do not
+ * predict the timings on target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "os/os.h"
+#include "infra/port.h"
+#include "infra/log.h"
+#include "common.h"
+
+#define ROUND_TRIPS     10000
+#define FANOUT_PORTS    8
+#define FANOUT_EVENTS   2000
+#define ALLOC_COUNT     1000000
+#define TIMER_PERIOD_MS 2
+#define TIMER_TICKS     250
+#define QUEUE_SIZE      64
+
+#define MSG_STOP        0xffff
+
+struct bench_msg {
+    struct message m;
+    uint32_t payload[8];
+};
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    va_list args;
+
+    UNUSED(level);
+    UNUSED(module);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+void panic(int err)
+{
+    fprintf(stderr, "panic %d\n", err);
+    abort();
+}
+
+static void report(const char *name, uint64_t us, uint32_t count,
+                   const char *unit)
+{
+    printf("%-28s %8u %-10s %10.3f us/op %12.0f op/s\n", name, count, unit,
+           (double)us / count, count * 1000000.0 / (us ? us : 1));
+}
+
+/* A port served by its own thread, the thread stops on MSG_STOP */
+struct bench_port {
+    T_QUEUE   queue;
+    uint16_t  id;
+    pthread_t thread;
+    volatile bool stop;
+    volatile uint32_t received;
+};
+
+static void *bench_port_thread(void *arg)
+{
+    struct bench_port *p = arg;
+    OS_ERR_TYPE err;
+
+    while (!p->stop) {
+        queue_process_message_wait(p->queue, OS_WAIT_FOREVER, &err);
+    }
+    return NULL;
+}
+
+static void bench_port_init(struct bench_port *p,
+                            void (*handler)(struct message *, void *))
+{
+    p->queue = queue_create(QUEUE_SIZE, NULL);
+    p->id = port_alloc(p->queue);
+    p->stop = false;
+    p->received = 0;
+    port_set_handler(p->id, handler, p);
+}
+
+static void bench_port_start(struct bench_port *p)
+{
+    pthread_create(&p->thread, NULL, bench_port_thread, p);
+}
+
+/* Sends a message from its own port, retrying while the queue is full */
+static void bench_send(struct message *m, uint16_t dst)
+{
+    MESSAGE_DST(m) = dst;
+    while (port_send_message(m) != E_OS_OK) {
+        sched_yield();
+    }
+}
+
+static void bench_port_stop(struct bench_port *p)
+{
+    struct message *m = message_alloc(sizeof(*m), NULL);
+
+    MESSAGE_ID(m) = MSG_STOP;
+    MESSAGE_SRC(m) = p->id;
+    MESSAGE_LEN(m) = sizeof(*m);
+    bench_send(m, p->id);
+    pthread_join(p->thread, NULL);
+}
+
+static void bench_stop_handler(struct bench_port *p, struct message *m)
+{
+    if (MESSAGE_ID(m) == MSG_STOP) {
+        p->stop = true;
+    } else {
+        p->received++;
+    }
+    message_free(m);
+}
+
+/*
+ * Message round trip: the main thread sends a message to the echo port,
+ * which sends it back, ROUND_TRIPS times.
+ */
+static struct bench_port echo_port;
+static struct bench_port main_port;
+
+static void echo_handler(struct message *m, void *param)
+{
+    if (MESSAGE_ID(m) == MSG_STOP) {
+        bench_stop_handler(param, m);
+        return;
+    }
+    MESSAGE_SRC(m) = echo_port.id;
+    bench_send(m, main_port.id);
+}
+
+static void main_handler(struct message *m, void *param)
+{
+    UNUSED(param);
+    MESSAGE_ID(m)++;
+    main_port.received++;
+    if (main_port.received < ROUND_TRIPS) {
+        MESSAGE_SRC(m) = main_port.id;
+        bench_send(m, echo_port.id);
+    } else {
+        message_free(m);
+    }
+}
+
+static void bench_round_trip(void)
+{
+    struct bench_msg *m;
+    OS_ERR_TYPE err;
+    uint64_t start;
+
+    bench_port_init(&echo_port, echo_handler);
+    bench_port_init(&main_port, main_handler);
+    bench_port_start(&echo_port);
+
+    m = (struct bench_msg *)message_alloc(sizeof(*m), NULL);
+    MESSAGE_SRC(&m->m) = main_port.id;
+    MESSAGE_LEN(&m->m) = sizeof(*m);
+
+    start = get_time_us();
+    bench_send(&m->m, echo_port.id);
+    while (main_port.received < ROUND_TRIPS) {
+        queue_process_message_wait(main_port.queue, OS_WAIT_FOREVER, &err);
+    }
+    report("message round trip", get_time_us() - start, ROUND_TRIPS, "trips");
+
+    bench_port_stop(&echo_port);
+}
+
+/*
+ * Event fan-out: FANOUT_EVENTS events are sent to FANOUT_PORTS ports, each
+ * served by its own thread, first with a copy per port as cfw_send_event()
+ * does, then with a single shared message.
+ */
+static struct bench_port fanout_ports[FANOUT_PORTS];
+
+static void fanout_handler(struct message *m, void *param)
+{
+    bench_stop_handler(param, m);
+}
+
+static void fanout_wait(void)
+{
+    int i;
+
+    for (i = 0; i < FANOUT_PORTS; i++) {
+        while (fanout_ports[i].received < FANOUT_EVENTS) {
+            sched_yield();
+        }
+    }
+}
+
+static void bench_fanout(void)
+{
+    struct bench_msg event;
+    uint64_t start;
+    int i, j;
+
+    memset(&event, 0, sizeof(event));
+    MESSAGE_SRC(&event.m) = main_port.id;
+    MESSAGE_LEN(&event.m) = sizeof(event);
+
+    for (i = 0; i < FANOUT_PORTS; i++) {
+        bench_port_init(&fanout_ports[i], fanout_handler);
+        bench_port_start(&fanout_ports[i]);
+    }
+
+    start = get_time_us();
+    for (j = 0; j < FANOUT_EVENTS; j++) {
+        for (i = 0; i < FANOUT_PORTS; i++) {
+            struct message *m = message_alloc(sizeof(event), NULL);
+
+            memcpy(m, &event, sizeof(event));
+            bench_send(m, fanout_ports[i].id);
+        }
+    }
+    fanout_wait();
+    report("event fan-out, copies", get_time_us() - start, FANOUT_EVENTS,
+           "events");
+
+#ifdef CONFIG_PORT_SHARED_MESSAGES
+    for (i = 0; i < FANOUT_PORTS; i++) {
+        fanout_ports[i].received = 0;
+    }
+    start = get_time_us();
+    for (j = 0; j < FANOUT_EVENTS; j++) {
+        struct message *m = message_share(&event.m, NULL);
+
+        for (i = 0; i < FANOUT_PORTS; i++) {
+            while (port_send_message_ref(m, fanout_ports[i].id) != E_OS_OK) {
+                sched_yield();
+            }
+        }
+        message_free(m);
+    }
+    fanout_wait();
+    report("event fan-out, shared", get_time_us() - start, FANOUT_EVENTS,
+           "events");
+#endif
+
+    for (i = 0; i < FANOUT_PORTS; i++) {
+        bench_port_stop(&fanout_ports[i]);
+    }
+}
+
+/* Allocator: allocation and release pairs, then a window of live blocks */
+static void bench_alloc(void)
+{
+    static void *blocks[64];
+    uint64_t start;
+    int i;
+
+    start = get_time_us();
+    for (i = 0; i < ALLOC_COUNT; i++) {
+        bfree(balloc(sizeof(struct bench_msg), NULL));
+    }
+    report("balloc/bfree", get_time_us() - start, ALLOC_COUNT, "pairs");
+
+    memset(blocks, 0, sizeof(blocks));
+    start = get_time_us();
+    for (i = 0; i < ALLOC_COUNT; i++) {
+        void **b = &blocks[i % 64];
+
+        if (*b) {
+            message_free(*b);
+        }
+        *b = message_alloc(sizeof(struct bench_msg), NULL);
+        MESSAGE_LEN((struct message *)*b) = sizeof(struct bench_msg);
+    }
+    report("message_alloc/free, 64 live", get_time_us() - start, ALLOC_COUNT,
+           "pairs");
+    for (i = 0; i < 64; i++) {
+        message_free(blocks[i]);
+    }
+}
+
+/* Timer: lateness of the callbacks of a periodic timer */
+static T_SEMAPHORE timer_done;
+static volatile uint32_t timer_ticks;
+static uint64_t timer_start_us;
+static uint64_t timer_late_max;
+static uint64_t timer_late_total;
+
+static void timer_tick(void *priv)
+{
+    uint64_t expected, now = get_time_us();
+
+    UNUSED(priv);
+    timer_ticks++;
+    expected = timer_start_us + (uint64_t)timer_ticks * TIMER_PERIOD_MS * 1000;
+    if (now > expected) {
+        timer_late_total += now - expected;
+        if (now - expected > timer_late_max) {
+            timer_late_max = now - expected;
+        }
+    }
+    if (timer_ticks == TIMER_TICKS) {
+        semaphore_give(timer_done, NULL);
+    }
+}
+
+static void bench_timer(void)
+{
+    T_TIMER t;
+
+    timer_done = semaphore_create(0, NULL);
+    timer_start_us = get_time_us();
+    t = timer_create(timer_tick, NULL, TIMER_PERIOD_MS, true, true, NULL);
+    semaphore_take(timer_done, OS_WAIT_FOREVER);
+    timer_delete(t, NULL);
+    semaphore_delete(timer_done, NULL);
+
+    printf("%-28s %8u %-10s %10.3f us avg %10u us max\n", "timer lateness",
+           TIMER_TICKS, "ticks", (double)timer_late_total / TIMER_TICKS,
+           (unsigned int)timer_late_max);
+}
+
+int main(void)
+{
+    bench_round_trip();
+    bench_fanout();
+    bench_alloc();
+    bench_timer();
+    return 0;
+}
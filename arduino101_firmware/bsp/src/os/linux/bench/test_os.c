@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file test_os.c
+ *
+ * Host checks of the LINUX OS abstraction layer and of the port layer on
+ * top of it:
+ * - queues: order, overflow, empty queue, timeout and wake up
+ * - semaphores and mutexes: counts, timeouts and wake up
+ * - timers: one shot, periodic, stop, restart, and deletion during the
+ *   callback, from the callback itself or from another thread
+ * - messages between two ports served by two threads arrive in order
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "os/os.h"
+#include "infra/port.h"
+#include "infra/log.h"
+#include "common.h"
+
+#define QUEUE_SIZE 4
+#define TIMEOUT_MS 20
+#define MESSAGES   1000
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    UNUSED(level);
+    UNUSED(module);
+    UNUSED(format);
+    return 0;
+}
+
+void panic(int err)
+{
+    printf("panic %d\n", err);
+    abort();
+}
+
+/* Runs fn on a thread after delay ms */
+struct later {
+    pthread_t thread;
+    int delay;
+    void (*fn)(void *);
+    void *arg;
+};
+
+static void *later_thread(void *arg)
+{
+    struct later *l = arg;
+
+    local_task_sleep(l->delay);
+    l->fn(l->arg);
+    return NULL;
+}
+
+static void later_start(struct later *l, int delay, void (*fn)(void *),
+                        void *arg)
+{
+    l->delay = delay;
+    l->fn = fn;
+    l->arg = arg;
+    pthread_create(&l->thread, NULL, later_thread, l);
+}
+
+static void later_join(struct later *l)
+{
+    pthread_join(l->thread, NULL);
+}
+
+/* Queues */
+
+static void queue_send_later(void *arg)
+{
+    OS_ERR_TYPE err;
+
+    queue_send_message(arg, (T_QUEUE_MESSAGE)0x1234, &err);
+}
+
+static void check_queue(void)
+{
+    T_QUEUE q = queue_create(QUEUE_SIZE, NULL);
+    T_QUEUE_MESSAGE m;
+    struct later l;
+    OS_ERR_TYPE err;
+    uint32_t start;
+    uintptr_t i;
+
+    for (i = 1; i <= QUEUE_SIZE; i++) {
+        queue_send_message(q, (T_QUEUE_MESSAGE)i, &err);
+        CHECK(err == E_OS_OK);
+    }
+    queue_send_message(q, (T_QUEUE_MESSAGE)i, &err);
+    CHECK(err == E_OS_ERR_OVERFLOW);
+    for (i = 1; i <= QUEUE_SIZE; i++) {
+        queue_get_message(q, &m, OS_NO_WAIT, &err);
+        CHECK(err == E_OS_OK && m == (T_QUEUE_MESSAGE)i);
+    }
+    queue_get_message(q, &m, OS_NO_WAIT, &err);
+    CHECK(err == E_OS_ERR_EMPTY && m == NULL);
+
+    start = get_time_ms();
+    queue_get_message(q, &m, TIMEOUT_MS, &err);
+    CHECK(err == E_OS_ERR_TIMEOUT);
+    CHECK(get_time_ms() - start >= TIMEOUT_MS);
+
+    later_start(&l, TIMEOUT_MS, queue_send_later, q);
+    queue_get_message(q, &m, OS_WAIT_FOREVER, &err);
+    CHECK(err == E_OS_OK && m == (T_QUEUE_MESSAGE)0x1234);
+    later_join(&l);
+
+    queue_delete(q, &err);
+    CHECK(err == E_OS_OK);
+}
+
+/* Semaphores and mutexes */
+
+static void semaphore_give_later(void *arg)
+{
+    semaphore_give(arg, NULL);
+}
+
+static void mutex_unlock_later(void *arg)
+{
+    mutex_unlock(arg, NULL);
+}
+
+static void check_sync(void)
+{
+    T_SEMAPHORE sem = semaphore_create(2, NULL);
+    T_MUTEX mutex = mutex_create(NULL);
+    struct later l;
+    uint32_t start;
+
+    CHECK(semaphore_get_count(sem, NULL) == 2);
+    CHECK(semaphore_take(sem, OS_NO_WAIT) == E_OS_OK);
+    CHECK(semaphore_take(sem, OS_NO_WAIT) == E_OS_OK);
+    CHECK(semaphore_take(sem, OS_NO_WAIT) == E_OS_ERR_BUSY);
+    start = get_time_ms();
+    CHECK(semaphore_take(sem, TIMEOUT_MS) == E_OS_ERR_TIMEOUT);
+    CHECK(get_time_ms() - start >= TIMEOUT_MS);
+
+    later_start(&l, TIMEOUT_MS, semaphore_give_later, sem);
+    CHECK(semaphore_take(sem, OS_WAIT_FOREVER) == E_OS_OK);
+    later_join(&l);
+    CHECK(semaphore_get_count(sem, NULL) == 0);
+    semaphore_delete(sem, NULL);
+
+    /* A binary semaphore, unlocked by any thread */
+    CHECK(mutex_lock(mutex, OS_NO_WAIT) == E_OS_OK);
+    CHECK(mutex_lock(mutex, OS_NO_WAIT) == E_OS_ERR_BUSY);
+    later_start(&l, TIMEOUT_MS, mutex_unlock_later, mutex);
+    CHECK(mutex_lock(mutex, OS_WAIT_FOREVER) == E_OS_OK);
+    later_join(&l);
+    mutex_unlock(mutex, NULL);
+    mutex_unlock(mutex, NULL);
+    CHECK(mutex_lock(mutex, OS_NO_WAIT) == E_OS_OK);
+    CHECK(mutex_lock(mutex, OS_NO_WAIT) == E_OS_ERR_BUSY);
+    mutex_delete(mutex, NULL);
+}
+
+/* Timers */
+
+struct tick {
+    T_TIMER timer;
+    T_SEMAPHORE sem;
+    volatile uint32_t count;
+    volatile uint32_t first_ms;
+    int sleep_ms;         /* time spent in the callback */
+    bool delete_self;     /* the callback deletes its timer */
+    volatile bool in_callback;
+};
+
+static void tick_callback(void *priv)
+{
+    struct tick *t = priv;
+
+    t->in_callback = true;
+    if (t->count++ == 0) {
+        t->first_ms = get_time_ms();
+    }
+    local_task_sleep(t->sleep_ms);
+    if (t->delete_self) {
+        timer_delete(t->timer, NULL);
+    }
+    t->in_callback = false;
+    semaphore_give(t->sem, NULL);
+}
+
+static void tick_init(struct tick *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->sem = semaphore_create(0, NULL);
+}
+
+static void check_timer(void)
+{
+    struct tick t;
+    OS_ERR_TYPE err;
+    uint32_t start;
+    int i;
+
+    /* One shot, restarted once */
+    tick_init(&t);
+    start = get_time_ms();
+    t.timer = timer_create(tick_callback, &t, TIMEOUT_MS, false, true, &err);
+    CHECK(err == E_OS_OK);
+    timer_start(t.timer, TIMEOUT_MS, &err);
+    CHECK(err == E_OS_ERR_BUSY);
+    CHECK(semaphore_take(t.sem, 10 * TIMEOUT_MS) == E_OS_OK);
+    CHECK(t.first_ms - start >= TIMEOUT_MS);
+    CHECK(semaphore_take(t.sem, 2 * TIMEOUT_MS) == E_OS_ERR_TIMEOUT);
+    timer_start(t.timer, TIMEOUT_MS, &err);
+    CHECK(err == E_OS_OK);
+    CHECK(semaphore_take(t.sem, 10 * TIMEOUT_MS) == E_OS_OK);
+    CHECK(t.count == 2);
+
+    /* Stopped before it expires */
+    timer_start(t.timer, TIMEOUT_MS, NULL);
+    timer_stop(t.timer, NULL);
+    CHECK(semaphore_take(t.sem, 2 * TIMEOUT_MS) == E_OS_ERR_TIMEOUT);
+    CHECK(t.count == 2);
+    timer_delete(t.timer, NULL);
+    semaphore_delete(t.sem, NULL);
+
+    /* Periodic */
+    tick_init(&t);
+    t.timer = timer_create(tick_callback, &t, 2, true, true, NULL);
+    for (i = 0; i < 10; i++) {
+        CHECK(semaphore_take(t.sem, 10 * TIMEOUT_MS) == E_OS_OK);
+    }
+    timer_stop(t.timer, NULL);
+    /* A callback may have been running at stop time */
+    semaphore_take(t.sem, TIMEOUT_MS);
+    CHECK(semaphore_take(t.sem, 2 * TIMEOUT_MS) == E_OS_ERR_TIMEOUT);
+    timer_delete(t.timer, NULL);
+    semaphore_delete(t.sem, NULL);
+
+    /* Deleted by its own callback */
+    tick_init(&t);
+    t.delete_self = true;
+    t.timer = timer_create(tick_callback, &t, 2, true, true, NULL);
+    CHECK(semaphore_take(t.sem, 10 * TIMEOUT_MS) == E_OS_OK);
+    CHECK(semaphore_take(t.sem, 2 * TIMEOUT_MS) == E_OS_ERR_TIMEOUT);
+    CHECK(t.count == 1);
+    semaphore_delete(t.sem, NULL);
+
+    /* Deleted by another thread while its callback runs */
+    tick_init(&t);
+    t.sleep_ms = TIMEOUT_MS;
+    t.timer = timer_create(tick_callback, &t, 2, false, true, NULL);
+    while (!t.in_callback) {
+        local_task_sleep(1);
+    }
+    timer_delete(t.timer, NULL);
+    CHECK(!t.in_callback);
+    CHECK(semaphore_take(t.sem, OS_NO_WAIT) == E_OS_OK);
+    semaphore_delete(t.sem, NULL);
+}
+
+/* Ports */
+
+static T_QUEUE rx_queue;
+static uint16_t tx_port, rx_port;
+static volatile uint32_t received;
+static volatile uint32_t out_of_order;
+
+static void rx_handler(struct message *m, void *param)
+{
+    UNUSED(param);
+    if (MESSAGE_ID(m) != received) {
+        out_of_order++;
+    }
+    received++;
+    message_free(m);
+}
+
+static void *rx_thread(void *arg)
+{
+    OS_ERR_TYPE err;
+
+    UNUSED(arg);
+    while (received < MESSAGES) {
+        queue_process_message_wait(rx_queue, OS_WAIT_FOREVER, &err);
+    }
+    return NULL;
+}
+
+static void check_port(void)
+{
+    pthread_t thread;
+    uint32_t i;
+
+    rx_queue = queue_create(QUEUE_SIZE, NULL);
+    tx_port = port_alloc(NULL);
+    rx_port = port_alloc(rx_queue);
+    port_set_handler(rx_port, rx_handler, NULL);
+    pthread_create(&thread, NULL, rx_thread, NULL);
+
+    for (i = 0; i < MESSAGES; i++) {
+        struct message *m = message_alloc(sizeof(*m), NULL);
+
+        MESSAGE_ID(m) = i;
+        MESSAGE_SRC(m) = tx_port;
+        MESSAGE_DST(m) = rx_port;
+        MESSAGE_LEN(m) = sizeof(*m);
+        /* The queue is short, wait for the receiver when it is full */
+        while (port_send_message(m) != E_OS_OK) {
+            local_task_sleep(1);
+        }
+    }
+    pthread_join(thread, NULL);
+    CHECK(received == MESSAGES);
+    CHECK(out_of_order == 0);
+}
+
+int main(void)
+{
+    check_queue();
+    check_sync();
+    check_timer();
+    check_port();
+
+    printf("%s test_os\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
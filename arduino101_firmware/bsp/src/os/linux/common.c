@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @defgroup os_linux Linux OS Abstraction Layer
+ * @ingroup os
+ * @{
+ */
+
+/**
+ * @file common.c
+ *
+ * LINUX OS abstraction / common services (error management, time, sleep).
+ *
+ * Functions are exported by "os.h".
+ *
+ * The Linux port runs the framework as a host process: tasks and
+ * interrupt handlers are threads, and the interrupt lock is a global
+ * mutex.
+ */
+
+#include <errno.h>
+#include "os/os.h"
+#include "common.h"
+
+void error_management(OS_ERR_TYPE* err, OS_ERR_TYPE localErr)
+{
+    if (NULL != err) {
+        *err = localErr;
+    } else if (E_OS_OK != localErr) {
+        panic(localErr);
+    }
+}
+
+void os_linux_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+void os_linux_deadline(struct timespec *ts, int timeout)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    if (timeout > 0) {
+        ts->tv_sec += timeout / 1000;
+        ts->tv_nsec += (timeout % 1000) * 1000000L;
+        if (ts->tv_nsec >= 1000000000L) {
+            ts->tv_sec++;
+            ts->tv_nsec -= 1000000000L;
+        }
+    }
+}
+
+OS_ERR_TYPE os_linux_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                               const struct timespec *ts, int timeout)
+{
+    if (timeout == OS_WAIT_FOREVER) {
+        pthread_cond_wait(cond, mutex);
+        return E_OS_OK;
+    }
+    if (timeout == OS_NO_WAIT ||
+        pthread_cond_timedwait(cond, mutex, ts) == ETIMEDOUT) {
+        return E_OS_ERR_TIMEOUT;
+    }
+    return E_OS_OK;
+}
+
+uint32_t get_time_ms(void)
+{
+    return (uint32_t)(get_time_us() / 1000);
+}
+
+uint64_t get_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void local_task_sleep(int time)
+{
+    struct timespec ts;
+
+    if (time <= 0) {
+        return;
+    }
+    ts.tv_sec = time / 1000;
+    ts.tv_nsec = (time % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+}
+
+void os_init(void)
+{
+}
+
+/** @} */
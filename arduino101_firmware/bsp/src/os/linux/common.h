@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __OS_LINUX_COMMON_H__
+#define __OS_LINUX_COMMON_H__
+
+/* The C library has POSIX timers of the same name as the os.h timers */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+
+#include "os/os_types.h"
+
+/**
+ * Set the error variable of the caller, or panic if there is none and
+ * an error occurred.
+ *
+ * @param err      pointer to the caller's error variable, may be NULL
+ * @param localErr the error detected by the function
+ */
+void error_management(OS_ERR_TYPE* err, OS_ERR_TYPE localErr);
+
+/**
+ * Initialize a condition variable that waits on the monotonic clock.
+ *
+ * @param cond the condition variable to initialize
+ */
+void os_linux_cond_init(pthread_cond_t *cond);
+
+/**
+ * Compute the monotonic date at which a wait times out.
+ *
+ * @param ts      the date to fill
+ * @param timeout the timeout in ms
+ */
+void os_linux_deadline(struct timespec *ts, int timeout);
+
+/**
+ * Wait on a condition variable.
+ *
+ * @param cond    the condition variable
+ * @param mutex   the mutex locked by the caller
+ * @param ts      the date returned by os_linux_deadline()
+ * @param timeout the timeout in ms, or OS_WAIT_FOREVER
+ *
+ * @return E_OS_OK if the condition was signaled, E_OS_ERR_TIMEOUT otherwise
+ */
+OS_ERR_TYPE os_linux_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                               const struct timespec *ts, int timeout);
+
+#endif /* __OS_LINUX_COMMON_H__ */
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file interrupt.c
+ *
+ * LINUX OS abstraction / interrupt services.
+ *
+ * There are no interrupts on the host: interrupt_lock() takes a global
+ * recursive mutex, so that code run from other threads in place of
+ * interrupt handlers is serialized with it. disable_scheduling() uses the
+ * same mutex.
+ */
+
+#include "os/os.h"
+#include "common.h"
+
+static pthread_mutex_t interrupt_mutex;
+static pthread_once_t interrupt_once = PTHREAD_ONCE_INIT;
+
+static void interrupt_mutex_init(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&interrupt_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+uint32_t interrupt_lock(void)
+{
+    pthread_once(&interrupt_once, interrupt_mutex_init);
+    pthread_mutex_lock(&interrupt_mutex);
+    return 0;
+}
+
+void interrupt_unlock(uint32_t key)
+{
+    UNUSED(key);
+    pthread_mutex_unlock(&interrupt_mutex);
+}
+
+void disable_scheduling(void)
+{
+    interrupt_lock();
+}
+
+void enable_scheduling(void)
+{
+    interrupt_unlock(0);
+}
+
+void interrupt_enable(uint32_t irq)
+{
+    UNUSED(irq);
+}
+
+void interrupt_disable(uint32_t irq)
+{
+    UNUSED(irq);
+}
+
+void interrupt_set_nmi(uint32_t irq)
+{
+    UNUSED(irq);
+}
+
+void interrupt_set_isr(int irq, T_ENTRY_POINT isr, void* isrData, int priority, OS_ERR_TYPE* err)
+{
+    UNUSED(irq);
+    UNUSED(isr);
+    UNUSED(isrData);
+    UNUSED(priority);
+    error_management(err, E_OS_ERR_NOT_SUPPORTED);
+}
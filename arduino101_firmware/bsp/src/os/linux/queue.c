@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file queue.c
+ *
+ * LINUX OS abstraction / queue services.
+ *
+ * Functions are exported by "os.h".
+ */
+
+#include <stdlib.h>
+#include "os/os.h"
+#include "common.h"
+
+struct linux_queue {
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+    uint32_t         size;
+    uint32_t         head;
+    uint32_t         count;
+    T_QUEUE_MESSAGE  msgs[];
+};
+
+T_QUEUE queue_create(uint32_t maxSize, OS_ERR_TYPE* err)
+{
+    struct linux_queue *q;
+
+    q = malloc(sizeof(*q) + maxSize * sizeof(T_QUEUE_MESSAGE));
+    if (q == NULL || maxSize == 0) {
+        free(q);
+        error_management(err, E_OS_ERR);
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    os_linux_cond_init(&q->cond);
+    q->size = maxSize;
+    q->head = q->count = 0;
+    error_management(err, E_OS_OK);
+    return (T_QUEUE)q;
+}
+
+void queue_delete(T_QUEUE queue, OS_ERR_TYPE* err)
+{
+    struct linux_queue *q = (struct linux_queue *)queue;
+
+    if (q == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+    error_management(err, E_OS_OK);
+}
+
+void queue_get_message(T_QUEUE queue, T_QUEUE_MESSAGE* message, int timeout, OS_ERR_TYPE* err)
+{
+    struct linux_queue *q = (struct linux_queue *)queue;
+    OS_ERR_TYPE ret = E_OS_OK;
+    struct timespec ts;
+
+    if (q == NULL || message == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    os_linux_deadline(&ts, timeout);
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && ret == E_OS_OK) {
+        ret = os_linux_cond_wait(&q->cond, &q->lock, &ts, timeout);
+    }
+    if (q->count > 0) {
+        *message = q->msgs[q->head];
+        q->head = (q->head + 1) % q->size;
+        q->count--;
+        ret = E_OS_OK;
+    } else {
+        *message = NULL;
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    if (ret == E_OS_OK) {
+        error_management(err, E_OS_OK);
+    } else if (timeout == OS_NO_WAIT) {
+        /* Queue empty is a common use case, do not panic even if err == NULL */
+        if (err) {
+            *err = E_OS_ERR_EMPTY;
+        }
+    } else {
+        error_management(err, E_OS_ERR_TIMEOUT);
+    }
+}
+
+void queue_send_message(T_QUEUE queue, T_QUEUE_MESSAGE message, OS_ERR_TYPE* err)
+{
+    struct linux_queue *q = (struct linux_queue *)queue;
+    OS_ERR_TYPE ret = E_OS_OK;
+
+    if (q == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_mutex_lock(&q->lock);
+    if (q->count < q->size) {
+        q->msgs[(q->head + q->count) % q->size] = message;
+        q->count++;
+        pthread_cond_signal(&q->cond);
+    } else {
+        ret = E_OS_ERR_OVERFLOW;
+    }
+    pthread_mutex_unlock(&q->lock);
+    error_management(err, ret);
+}
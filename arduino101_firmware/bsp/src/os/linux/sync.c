@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file sync.c
+ *
+ * LINUX OS abstraction / synchronization services (semaphores, mutexes).
+ *
+ * Functions are exported by "os.h".
+ */
+
+#include <stdlib.h>
+#include "os/os.h"
+#include "common.h"
+
+struct linux_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int32_t         count;
+};
+
+T_SEMAPHORE semaphore_create(uint32_t initialCount, OS_ERR_TYPE* err)
+{
+    struct linux_sem *sem = malloc(sizeof(*sem));
+
+    if (sem == NULL) {
+        error_management(err, E_OS_ERR);
+        return NULL;
+    }
+    pthread_mutex_init(&sem->lock, NULL);
+    os_linux_cond_init(&sem->cond);
+    sem->count = initialCount;
+    error_management(err, E_OS_OK);
+    return (T_SEMAPHORE)sem;
+}
+
+void semaphore_delete(T_SEMAPHORE semaphore, OS_ERR_TYPE* err)
+{
+    struct linux_sem *sem = (struct linux_sem *)semaphore;
+
+    if (sem == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+    error_management(err, E_OS_OK);
+}
+
+void semaphore_give(T_SEMAPHORE semaphore, OS_ERR_TYPE* err)
+{
+    struct linux_sem *sem = (struct linux_sem *)semaphore;
+
+    if (sem == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_mutex_lock(&sem->lock);
+    sem->count++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    error_management(err, E_OS_OK);
+}
+
+OS_ERR_TYPE semaphore_take(T_SEMAPHORE semaphore, int timeout)
+{
+    struct linux_sem *sem = (struct linux_sem *)semaphore;
+    OS_ERR_TYPE ret = E_OS_OK;
+    struct timespec ts;
+
+    if (sem == NULL) {
+        return E_OS_ERR;
+    }
+    os_linux_deadline(&ts, timeout);
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && ret == E_OS_OK) {
+        ret = os_linux_cond_wait(&sem->cond, &sem->lock, &ts, timeout);
+    }
+    if (sem->count > 0) {
+        sem->count--;
+        ret = E_OS_OK;
+    } else if (timeout == OS_NO_WAIT) {
+        ret = E_OS_ERR_BUSY;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+int32_t semaphore_get_count(T_SEMAPHORE semaphore, OS_ERR_TYPE* err)
+{
+    struct linux_sem *sem = (struct linux_sem *)semaphore;
+    int32_t count;
+
+    if (sem == NULL) {
+        error_management(err, E_OS_ERR);
+        return 0;
+    }
+    pthread_mutex_lock(&sem->lock);
+    count = sem->count;
+    pthread_mutex_unlock(&sem->lock);
+    error_management(err, E_OS_OK);
+    return count;
+}
+
+/*
+ * Mutexes are binary semaphores, as on Zephyr: unlocking a free mutex is
+ * allowed and a mutex may be unlocked by another thread.
+ */
+T_MUTEX mutex_create(OS_ERR_TYPE* err)
+{
+    return (T_MUTEX)semaphore_create(1, err);
+}
+
+void mutex_delete(T_MUTEX mutex, OS_ERR_TYPE* err)
+{
+    semaphore_delete((T_SEMAPHORE)mutex, err);
+}
+
+void mutex_unlock(T_MUTEX mutex, OS_ERR_TYPE* err)
+{
+    struct linux_sem *sem = (struct linux_sem *)mutex;
+
+    if (sem == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_mutex_lock(&sem->lock);
+    sem->count = 1;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    error_management(err, E_OS_OK);
+}
+
+OS_ERR_TYPE mutex_lock(T_MUTEX mutex, int timeout)
+{
+    return semaphore_take((T_SEMAPHORE)mutex, timeout);
+}
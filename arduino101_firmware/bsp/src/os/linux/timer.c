@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file timer.c
+ *
+ * LINUX OS abstraction / timer services.
+ *
+ * Timer callbacks are called from a single timer thread, like the timer
+ * task of the Zephyr port.
+ *
+ * Functions are exported by "os.h".
+ */
+
+#include <stdlib.h>
+#include "os/os.h"
+#include "common.h"
+
+struct linux_timer {
+    struct linux_timer *next;
+    T_ENTRY_POINT       callback;
+    void               *priv;
+    uint32_t            delay;
+    bool                repeat;
+    bool                running;
+    bool                deleted;    /* freed when its callback returns */
+    uint64_t            expiration; /* in us */
+};
+
+static struct linux_timer *timers;
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+static pthread_t timer_tid;
+/* Timer whose callback runs, it is not freed before the callback returns */
+static struct linux_timer *timer_firing;
+static pthread_cond_t timer_idle;
+
+static void *timer_thread(void *arg)
+{
+    struct linux_timer *t, *next;
+
+    UNUSED(arg);
+    pthread_mutex_lock(&timer_lock);
+    while (1) {
+        uint64_t now = get_time_us();
+
+        /* Find the next timer to expire */
+        next = NULL;
+        for (t = timers; t; t = t->next) {
+            if (t->running &&
+                (next == NULL || t->expiration < next->expiration)) {
+                next = t;
+            }
+        }
+
+        if (next == NULL) {
+            pthread_cond_wait(&timer_cond, &timer_lock);
+        } else if (next->expiration > now) {
+            struct timespec ts;
+            uint64_t wait = next->expiration - now;
+
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            ts.tv_sec += wait / 1000000;
+            ts.tv_nsec += (wait % 1000000) * 1000;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&timer_cond, &timer_lock, &ts);
+        } else {
+            if (next->repeat) {
+                next->expiration += (uint64_t)next->delay * 1000;
+            } else {
+                next->running = false;
+            }
+            /* The callback may start, stop or delete timers */
+            timer_firing = next;
+            pthread_mutex_unlock(&timer_lock);
+            next->callback(next->priv);
+            pthread_mutex_lock(&timer_lock);
+            if (next->deleted) {
+                free(next);
+            }
+            timer_firing = NULL;
+            pthread_cond_broadcast(&timer_idle);
+        }
+    }
+    return NULL;
+}
+
+static void timer_init(void)
+{
+    os_linux_cond_init(&timer_cond);
+    os_linux_cond_init(&timer_idle);
+    pthread_create(&timer_tid, NULL, timer_thread, NULL);
+    pthread_detach(timer_tid);
+}
+
+T_TIMER timer_create(T_ENTRY_POINT callback, void* privData, uint32_t delay, bool repeat, bool startup, OS_ERR_TYPE* err)
+{
+    struct linux_timer *t;
+
+    if (callback == NULL || (t = calloc(1, sizeof(*t))) == NULL) {
+        error_management(err, E_OS_ERR);
+        return NULL;
+    }
+    pthread_once(&timer_once, timer_init);
+    t->callback = callback;
+    t->priv = privData;
+    t->delay = delay;
+    t->repeat = repeat;
+
+    pthread_mutex_lock(&timer_lock);
+    t->next = timers;
+    timers = t;
+    pthread_mutex_unlock(&timer_lock);
+
+    error_management(err, E_OS_OK);
+    if (startup) {
+        timer_start((T_TIMER)t, delay, err);
+    }
+    return (T_TIMER)t;
+}
+
+void timer_start(T_TIMER tmr, uint32_t delay, OS_ERR_TYPE* err)
+{
+    struct linux_timer *t = (struct linux_timer *)tmr;
+    OS_ERR_TYPE ret = E_OS_OK;
+
+    if (t == NULL || delay == 0) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_mutex_lock(&timer_lock);
+    if (t->running) {
+        ret = E_OS_ERR_BUSY;
+    } else {
+        t->delay = delay;
+        t->expiration = get_time_us() + (uint64_t)delay * 1000;
+        t->running = true;
+        pthread_cond_signal(&timer_cond);
+    }
+    pthread_mutex_unlock(&timer_lock);
+    error_management(err, ret);
+}
+
+void timer_stop(T_TIMER tmr, OS_ERR_TYPE* err)
+{
+    struct linux_timer *t = (struct linux_timer *)tmr;
+
+    if (t == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_mutex_lock(&timer_lock);
+    t->running = false;
+    pthread_mutex_unlock(&timer_lock);
+    error_management(err, E_OS_OK);
+}
+
+void timer_delete(T_TIMER tmr, OS_ERR_TYPE* err)
+{
+    struct linux_timer *t = (struct linux_timer *)tmr;
+    struct linux_timer **p;
+
+    if (t == NULL) {
+        error_management(err, E_OS_ERR);
+        return;
+    }
+    pthread_mutex_lock(&timer_lock);
+    for (p = &timers; *p && *p != t; p = &(*p)->next);
+    if (*p) {
+        *p = t->next;
+    }
+    if (timer_firing == t) {
+        if (pthread_equal(pthread_self(), timer_tid)) {
+            /* Deleted by its own callback */
+            t->deleted = true;
+            t = NULL;
+        } else {
+            while (timer_firing == t) {
+                pthread_cond_wait(&timer_idle, &timer_lock);
+            }
+        }
+    }
+    pthread_mutex_unlock(&timer_lock);
+    free(t);
+    error_management(err, E_OS_OK);
+}
@@ -80,8 +80,8 @@
 /** Descriptor for a memory pool */
 typedef struct {
     uint32_t* track;    /** block allocation tracker */
-    uint32_t  start;    /** start address of the pool */
-    uint32_t  end;      /** end address of the pool */
+    uintptr_t start;    /** start address of the pool */
+    uintptr_t end;      /** end address of the pool */
     uint16_t  count;    /** total number of blocks within the pool */
     uint16_t  size;     /** size of each memory block within the pool */
 #ifdef CONFIG_BALLOC_STATISTICS
@@ -123,8 +123,8 @@ T_POOL_DESC g_MemPool[] =
 #define DECLARE_MEMORY_POOL(index,size,count) \
 { \
 /* T_POOL_DESC.track */  g_MemBlock_alloc_track_##index,\
-/* T_POOL_DESC.start */  (uint32_t) g_MemBlock_##index, \
-/* T_POOL_DESC.end */    (uint32_t) g_MemBlock_##index + count * size, \
+/* T_POOL_DESC.start */  (uintptr_t) g_MemBlock_##index, \
+/* T_POOL_DESC.end */    (uintptr_t) g_MemBlock_##index + count * size, \
 /* T_POOL_DESC.count */  count, \
 /* T_POOL_DESC.size */   size, \
 /* T_POOL_DESC.owners */ g_MemBlock_owners_##index, \
@@ -137,8 +137,8 @@ T_POOL_DESC g_MemPool[] =
 #define DECLARE_MEMORY_POOL(index,size,count) \
 { \
 /* T_POOL_DESC.track */  g_MemBlock_alloc_track_##index,\
-/* T_POOL_DESC.start */  (uint32_t) g_MemBlock_##index, \
-/* T_POOL_DESC.end */    (uint32_t) g_MemBlock_##index + count * size, \
+/* T_POOL_DESC.start */  (uintptr_t) g_MemBlock_##index, \
+/* T_POOL_DESC.end */    (uintptr_t) g_MemBlock_##index + count * size, \
 /* T_POOL_DESC.count */  count, \
 /* T_POOL_DESC.size */   size, \
 /* T_POOL_DESC.max */    0, \
@@ -169,8 +169,8 @@ T_POOL_DESC g_MemPool [] =
 #define DECLARE_MEMORY_POOL(index,size,count) \
 { \
 /* T_POOL_DESC.track */  g_MemBlock_alloc_track_##index,\
-/* T_POOL_DESC.start */  (uint32_t) g_MemBlock_##index, \
-/* T_POOL_DESC.end */    (uint32_t) g_MemBlock_##index + count * size, \
+/* T_POOL_DESC.start */  (uintptr_t) g_MemBlock_##index, \
+/* T_POOL_DESC.end */    (uintptr_t) g_MemBlock_##index + count * size, \
 /* T_POOL_DESC.count */  count, \
 /* T_POOL_DESC.size */   size \
 },
@@ -190,6 +190,138 @@ T_POOL_DESC g_MemPool [] =
  ************** Private functions  ************************
  **********************************************************/
 
+#ifdef CONFIG_BALLOC_FAST
+
+/** Number of power of two size classes for a 32-bit size */
+#define NB_SIZE_CLASSES   (BITS_PER_UINT32 + 1)
+
+/** Index of the first pool able to hold any size of a given size class */
+static uint8_t g_PoolBySize[NB_SIZE_CLASSES];
+
+/** Pool indexes sorted by ascending start address */
+static uint8_t g_PoolByAddr[NB_MEMORY_POOLS];
+
+static volatile bool g_PoolTablesReady = false;
+
+/**
+ * Return the size class of a request: the smallest c such that
+ * size <= 2^c.
+ */
+static inline uint32_t memblock_size_class (uint32_t size)
+{
+    return (size <= 1) ? 0 : BITS_PER_UINT32 - __builtin_clz(size - 1);
+}
+
+/**
+ * Build the size class and address lookup tables.
+ *
+ * Pools must be declared by ascending block size in memory_pool_list.def.
+ * The tables are built once, on the first allocation.
+ */
+static void memblock_init_tables (void)
+{
+    uint32_t flags = interrupt_lock();
+    uint32_t cls, lower;
+    uint8_t idx, i, j;
+
+    if (!g_PoolTablesReady)
+    {
+        idx = 0;
+        for (cls = 0; cls < NB_SIZE_CLASSES; cls++)
+        {
+            /* smallest size belonging to this class */
+            lower = (cls == 0) ? 1 : (1U << (cls - 1)) + 1;
+            while (idx < NB_MEMORY_POOLS && g_MemPool[idx].size < lower)
+            {
+                idx++;
+            }
+            g_PoolBySize[cls] = idx;
+        }
+
+        /* insertion sort of the pools by start address */
+        for (i = 0; i < NB_MEMORY_POOLS; i++)
+        {
+            for (j = i; j > 0 && g_MemPool[g_PoolByAddr[j-1]].start > g_MemPool[i].start; j--)
+            {
+                g_PoolByAddr[j] = g_PoolByAddr[j-1];
+            }
+            g_PoolByAddr[j] = i;
+        }
+        g_PoolTablesReady = true;
+    }
+    interrupt_unlock(flags);
+}
+
+/**
+ * Return the index of the first free block of a pool.
+ *
+ * The tracker is scanned one word at a time, blocks being stored MSB first
+ * so that the first free block of a word is given by its count of leading
+ * ones.
+ *
+ * Must be called with interrupts locked.
+ *
+ * @param pool index of the pool in g_MemPool
+ *
+ * @return index of the free block, or g_MemPool[pool].count if the pool
+ *   is full
+ */
+static uint16_t memblock_find_free (uint32_t pool)
+{
+    uint32_t word;
+    uint32_t free_bits;
+    uint32_t block;
+
+    for (word = 0; word <= (g_MemPool[pool].count - 1U) / BITS_PER_UINT32; word++)
+    {
+        free_bits = ~(g_MemPool[pool].track)[word];
+        if (free_bits != 0)
+        {
+            block = word * BITS_PER_UINT32 + __builtin_clz(free_bits);
+            /* trailing bits of the last word do not map to real blocks */
+            return (block < g_MemPool[pool].count) ? block : g_MemPool[pool].count;
+        }
+    }
+    return g_MemPool[pool].count;
+}
+
+/**
+ * Return the pool a buffer belongs to.
+ *
+ * @param ptr address to look up
+ *
+ * @return index of the pool in g_MemPool, or NB_MEMORY_POOLS if ptr is not
+ *   within any pool
+ */
+static uint8_t memblock_find_pool (void* ptr)
+{
+    int32_t low = 0;
+    int32_t high = NB_MEMORY_POOLS - 1;
+    int32_t mid;
+    uint8_t pool;
+
+    while (low <= high)
+    {
+        mid = (low + high) / 2;
+        pool = g_PoolByAddr[mid];
+        if ((uintptr_t) ptr < g_MemPool[pool].start)
+        {
+            high = mid - 1;
+        }
+        else if ((uintptr_t) ptr >= g_MemPool[pool].end)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            return pool;
+        }
+    }
+    return NB_MEMORY_POOLS;
+}
+
+#endif /* CONFIG_BALLOC_FAST */
+
 /**
  * Return the next free block of a pool and
  *   mark it as reserved/allocated.
@@ -204,22 +336,31 @@ static void* memblock_alloc (uint32_t pool)
     uint16_t block;
     uint32_t flags = interrupt_lock();
 
+#ifdef CONFIG_BALLOC_FAST
+    block = memblock_find_free(pool);
+#else
     for (block = 0; block < g_MemPool[pool].count; block++)
     {
         if (((g_MemPool[pool].track)[block/BITS_PER_UINT32] & 1 << (BITS_PER_UINT32 - 1 - (block%BITS_PER_UINT32))) == 0)
         {
-            (g_MemPool[pool].track)[block/BITS_PER_UINT32] = (g_MemPool[pool].track)[block/BITS_PER_UINT32] | (1 << (BITS_PER_UINT32 - 1 - (block%BITS_PER_UINT32)));
+            break;
+        }
+    }
+#endif
+
+    if (block < g_MemPool[pool].count)
+    {
+        (g_MemPool[pool].track)[block/BITS_PER_UINT32] = (g_MemPool[pool].track)[block/BITS_PER_UINT32] | (1 << (BITS_PER_UINT32 - 1 - (block%BITS_PER_UINT32)));
 #ifdef CONFIG_BALLOC_STATISTICS
-            g_MemPool[pool].cur = g_MemPool[pool].cur +1;
+        g_MemPool[pool].cur = g_MemPool[pool].cur +1;
 #ifdef CONFIG_BALLOC_STATISTICS_TRACK_OWNER
-            g_MemPool[pool].owners[block] = __builtin_return_address(0);
+        g_MemPool[pool].owners[block] = __builtin_return_address(0);
 #endif
-            if (g_MemPool[pool].cur > g_MemPool[pool].max)
-                g_MemPool[pool].max = g_MemPool[pool].cur;
+        if (g_MemPool[pool].cur > g_MemPool[pool].max)
+            g_MemPool[pool].max = g_MemPool[pool].cur;
 #endif
-            interrupt_unlock(flags);
-            return (void*) ( g_MemPool[pool].start + g_MemPool[pool].size * block ) ;
-        }
+        interrupt_unlock(flags);
+        return (void*) ( g_MemPool[pool].start + g_MemPool[pool].size * block ) ;
     }
     interrupt_unlock(flags);
     return NULL;
@@ -241,7 +382,7 @@ static void memblock_free (uint32_t pool, void* ptr)
     uint16_t block ;
     uint32_t flags;
 
-    block = ((uint32_t)ptr - g_MemPool[pool].start) / g_MemPool[pool].size ;
+    block = ((uintptr_t)ptr - g_MemPool[pool].start) / g_MemPool[pool].size ;
     if (block < g_MemPool[pool].count)
     {
         flags = interrupt_lock();
@@ -274,7 +415,7 @@ static void memblock_free (uint32_t pool, void* ptr)
 static bool memblock_used (uint32_t pool, void* ptr)
 {
     uint16_t block ;
-    block = ((uint32_t)ptr - g_MemPool[pool].start) / g_MemPool[pool].size ;
+    block = ((uintptr_t)ptr - g_MemPool[pool].start) / g_MemPool[pool].size ;
     if (block < g_MemPool[pool].count)
     {
         if ( ((g_MemPool[pool].track)[block/BITS_PER_UINT32] & (1 << (BITS_PER_UINT32 - 1 -(block%BITS_PER_UINT32)))) != 0 )
@@ -300,6 +441,9 @@ static bool memblock_used (uint32_t pool, void* ptr)
  */
 void os_abstraction_init_malloc(void)
 {
+#ifdef CONFIG_BALLOC_FAST
+    memblock_init_tables();
+#endif
 }
 
 /**
@@ -341,7 +485,15 @@ void* balloc (uint32_t size, OS_ERR_TYPE* err)
     if (size > 0)
     {
         /* find the first block size greater or equal to requested size */
+#ifdef CONFIG_BALLOC_FAST
+        if (!g_PoolTablesReady)
+        {
+            memblock_init_tables();
+        }
+        poolIdx = g_PoolBySize[memblock_size_class(size)];
+#else
         poolIdx = 0;
+#endif
         while ( poolIdx < NB_MEMORY_POOLS &&
                ( size > g_MemPool[poolIdx].size ))
         {
@@ -424,12 +576,30 @@ OS_ERR_TYPE bfree(void* buffer)
     uint8_t poolIdx ;
 
     /* find which pool the buffer was allocated from */
+#ifdef CONFIG_BALLOC_FAST
+    if (( NULL != buffer ) && g_PoolTablesReady )
+    {
+        poolIdx = memblock_find_pool(buffer);
+        if ( poolIdx < NB_MEMORY_POOLS )
+        {
+            if ( false != memblock_used (poolIdx, buffer))
+            {
+                memblock_free (poolIdx, buffer);
+                err = E_OS_OK;
+            }
+#ifdef __DEBUG_OS_ABSTRACTION_BALLOC
+            else
+                _log ("ERR: memory_free: buffer %p is already free\n", buffer);
+#endif
+        }
+    }
+#else
     poolIdx = 0;
     while (( NULL != buffer ) && ( poolIdx < NB_MEMORY_POOLS ))
     {
         /* check if buffer is within g_MemPool[poolIdx] */
-        if ( ( (uint32_t) buffer >= g_MemPool[poolIdx].start ) &&
-             ( (uint32_t) buffer < g_MemPool[poolIdx].end ) )
+        if ( ( (uintptr_t) buffer >= g_MemPool[poolIdx].start ) &&
+             ( (uintptr_t) buffer < g_MemPool[poolIdx].end ) )
         {
             if ( false != memblock_used (poolIdx, buffer))
             {
@@ -448,6 +618,7 @@ OS_ERR_TYPE bfree(void* buffer)
             poolIdx ++;
         }
     }
+#endif
     return(err);
 }
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Stubs of the OS services used by balloc.c, and the table of the two
+ * builds of balloc.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+/* The C library has POSIX timers of the same name as the os.h timers */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+#include "balloc_host.h"
+#include "infra/log.h"
+
+#define DECLARE_BALLOC_VARIANT(v) \
+    extern void *balloc_##v(uint32_t size, OS_ERR_TYPE *err); \
+    extern OS_ERR_TYPE bfree_##v(void *buffer); \
+    extern void os_abstraction_init_malloc_##v(void); \
+    extern T_POOL_DESC g_MemPool_##v[];
+
+DECLARE_BALLOC_VARIANT(legacy)
+DECLARE_BALLOC_VARIANT(fast)
+
+struct balloc_variant balloc_variants[NB_VARIANTS] = {
+    { "legacy", balloc_legacy, bfree_legacy, os_abstraction_init_malloc_legacy, g_MemPool_legacy },
+    { "fast", balloc_fast, bfree_fast, os_abstraction_init_malloc_fast, g_MemPool_fast },
+};
+
+const unsigned int balloc_nb_pools = 0
+#define DECLARE_MEMORY_POOL(index,size,count) + 1
+#include "memory_pool_list.def"
+    ;
+
+struct irq_stats irq_stats;
+int irq_stats_enabled;
+unsigned int log_errors;
+
+static uint64_t irq_locked_at;
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t interrupt_lock(void)
+{
+    if (irq_stats_enabled) {
+        irq_locked_at = now_ns();
+    }
+    return 0;
+}
+
+void interrupt_unlock(uint32_t flags)
+{
+    uint64_t locked;
+
+    if (irq_stats_enabled) {
+        locked = now_ns() - irq_locked_at;
+        irq_stats.count++;
+        irq_stats.hist[locked < IRQ_HIST_NS ? locked : IRQ_HIST_NS - 1]++;
+    }
+}
+
+void panic(int err)
+{
+    printf("panic %d\n", err);
+    abort();
+}
+
+void error_management(OS_ERR_TYPE *err, OS_ERR_TYPE localErr)
+{
+    if (err != NULL) {
+        *err = localErr;
+    } else if (localErr != E_OS_OK) {
+        panic(localErr);
+    }
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    log_errors++;
+    return 0;
+}
+
+int balloc_find_block(const struct balloc_variant *v, void *ptr,
+                      unsigned int *pool, unsigned int *block)
+{
+    uintptr_t addr = (uintptr_t)ptr;
+    unsigned int i;
+
+    for (i = 0; i < balloc_nb_pools; i++) {
+        if (addr >= v->pools[i].start && addr < v->pools[i].end) {
+            if ((addr - v->pools[i].start) % v->pools[i].size) {
+                return -1;
+            }
+            *pool = i;
+            *block = (addr - v->pools[i].start) / v->pools[i].size;
+            return 0;
+        }
+    }
+    return -1;
+}
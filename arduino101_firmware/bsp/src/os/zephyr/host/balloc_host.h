@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of balloc.c. The Makefile builds it twice, without and with
+ * CONFIG_BALLOC_FAST, and suffixes the exported symbols of each build with
+ * _legacy or _fast so that both variants live in the same program.
+ */
+
+#ifndef __BALLOC_HOST_H__
+#define __BALLOC_HOST_H__
+
+#include "os/os.h"
+
+/** Pool descriptor of balloc.c, built without CONFIG_BALLOC_STATISTICS */
+typedef struct {
+    uint32_t* track;
+    uintptr_t start;
+    uintptr_t end;
+    uint16_t  count;
+    uint16_t  size;
+} T_POOL_DESC;
+
+/** A build of balloc.c */
+struct balloc_variant {
+    const char *name;
+    void *(*alloc)(uint32_t size, OS_ERR_TYPE *err);
+    OS_ERR_TYPE (*free)(void *buffer);
+    void (*init)(void);
+    T_POOL_DESC *pools;
+};
+
+#define NB_VARIANTS 2
+
+extern struct balloc_variant balloc_variants[NB_VARIANTS];
+
+/** Number of pools of memory_pool_list.def */
+extern const unsigned int balloc_nb_pools;
+
+/** Histogram size of the interrupt lock times, in ns */
+#define IRQ_HIST_NS 2048
+
+/** Time spent with interrupts locked, measured by the interrupt_lock() stub */
+struct irq_stats {
+    uint64_t count;
+    uint32_t hist[IRQ_HIST_NS]; /*!< lock counts per ns, the last one for longer locks */
+};
+
+extern struct irq_stats irq_stats;
+
+/** Set to measure the interrupt lock times */
+extern int irq_stats_enabled;
+
+/** Number of errors logged by balloc */
+extern unsigned int log_errors;
+
+/**
+ * Return the monotonic time in ns.
+ */
+uint64_t now_ns(void);
+
+/**
+ * Find the pool and block of a buffer returned by a variant.
+ *
+ * @return 0 if ptr is the start of a block of the variant, -1 otherwise
+ */
+int balloc_find_block(const struct balloc_variant *v, void *ptr,
+                      unsigned int *pool, unsigned int *block);
+
+#endif /* __BALLOC_HOST_H__ */
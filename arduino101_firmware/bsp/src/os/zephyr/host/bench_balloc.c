@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares the legacy and the constant-time builds of balloc.c on the
+ * pools of the arduino101 Quark image:
+ * - the time of an allocation and release pair
+ * - the time spent with interrupts locked per lock, median and 99th
+ *   percentile, less the cost of reading the clock
+ *
+ * The maximum lock time is not reported, it only shows the preemptions of
+ * the host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "balloc_host.h"
+
+#define PAIRS       1000000
+#define MIX_LIVE    64
+
+static void *held[256];
+static unsigned int held_count;
+
+/* Allocate all the blocks of the pool of size but its last one */
+static void fill_pool(const struct balloc_variant *v, uint32_t size)
+{
+    const T_POOL_DESC *pools = v->pools;
+    unsigned int i;
+
+    for (i = 0; i < balloc_nb_pools && pools[i].size < size; i++);
+    while (held_count < pools[i].count - 1U) {
+        held[held_count++] = v->alloc(size, NULL);
+    }
+}
+
+static void release_pools(const struct balloc_variant *v)
+{
+    while (held_count) {
+        v->free(held[--held_count]);
+    }
+}
+
+static void run_pairs(const struct balloc_variant *v, uint32_t size)
+{
+    unsigned int i;
+
+    for (i = 0; i < PAIRS; i++) {
+        v->free(v->alloc(size, NULL));
+    }
+}
+
+/* Random sizes, with up to MIX_LIVE buffers allocated */
+static void run_mix(const struct balloc_variant *v)
+{
+    static const uint32_t sizes[] = { 8, 12, 16, 24, 32, 48, 64, 100, 128, 200, 256, 512 };
+    static void *live[MIX_LIVE];
+    OS_ERR_TYPE err;
+    unsigned int i, slot;
+
+    srand(1);
+    for (i = 0; i < PAIRS; i++) {
+        slot = rand() % MIX_LIVE;
+        if (live[slot]) {
+            v->free(live[slot]);
+        }
+        live[slot] = v->alloc(sizes[rand() % (sizeof(sizes) / sizeof(sizes[0]))], &err);
+    }
+    for (slot = 0; slot < MIX_LIVE; slot++) {
+        if (live[slot]) {
+            v->free(live[slot]);
+            live[slot] = NULL;
+        }
+    }
+}
+
+/* Lock time, in ns, below which are the given part of the locks */
+static unsigned int irq_percentile(double part)
+{
+    uint64_t sum = 0;
+    unsigned int ns;
+
+    for (ns = 0; ns < IRQ_HIST_NS - 1; ns++) {
+        sum += irq_stats.hist[ns];
+        if (sum >= part * irq_stats.count) {
+            break;
+        }
+    }
+    return ns;
+}
+
+/* Lock time measured for an empty lock, which is the cost of the clock */
+static unsigned int irq_overhead(void)
+{
+    unsigned int i;
+
+    irq_stats = (struct irq_stats) { 0 };
+    irq_stats_enabled = 1;
+    for (i = 0; i < PAIRS; i++) {
+        interrupt_unlock(interrupt_lock());
+    }
+    irq_stats_enabled = 0;
+    return irq_percentile(0.5);
+}
+
+struct scenario {
+    const char *name;
+    uint32_t size;  /*!< size of the pairs, 0 for the random mix */
+    int fill;       /*!< only the last block of the pool is free */
+};
+
+static const struct scenario scenarios[] = {
+    { "8 B, empty pool", 8, 0 },
+    { "8 B, 1 free block", 8, 1 },
+    { "32 B, 1 free block", 32, 1 },
+    { "4096 B, last pool", 4096, 0 },
+    { "random mix, 64 live", 0, 0 },
+};
+
+int main(void)
+{
+    const struct scenario *s;
+    const struct balloc_variant *v;
+    uint64_t start, pair_ns;
+    unsigned int i;
+    int overhead;
+    int n;
+
+    for (n = 0; n < NB_VARIANTS; n++) {
+        balloc_variants[n].init();
+    }
+
+    overhead = irq_overhead();
+    printf("clock overhead %d ns\n", overhead);
+    printf("%-22s %-8s %12s %14s %14s\n", "scenario", "variant",
+           "ns/pair", "irq-off p50", "irq-off p99");
+    for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        s = &scenarios[i];
+        for (n = 0; n < NB_VARIANTS; n++) {
+            v = &balloc_variants[n];
+            if (s->fill) {
+                fill_pool(v, s->size);
+            }
+
+            /* Pair time, without the lock time measurement */
+            irq_stats_enabled = 0;
+            start = now_ns();
+            if (s->size) {
+                run_pairs(v, s->size);
+            } else {
+                run_mix(v);
+            }
+            pair_ns = now_ns() - start;
+
+            /* Lock times */
+            irq_stats = (struct irq_stats) { 0 };
+            irq_stats_enabled = 1;
+            if (s->size) {
+                run_pairs(v, s->size);
+            } else {
+                run_mix(v);
+            }
+            irq_stats_enabled = 0;
+
+            release_pools(v);
+            printf("%-22s %-8s %12.1f %11d ns %11d ns\n", s->name, v->name,
+                   (double)pair_ns / PAIRS,
+                   (int)irq_percentile(0.5) - overhead,
+                   (int)irq_percentile(0.99) - overhead);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark of the DECLARE_BLK_ALLOC pools of zephyr/common.h against the
+ * legacy macro, on pools of 100 blocks (the queue elements of the Quark
+ * image) and 256 blocks: time of an allocation and release pair
+ *  - with the first blocks of the pool held, for a hot pair on the next
+ *    free block,
+ *  - with half the pool held in FIFO order, freeing the oldest block, as
+ *    queue elements are,
+ *  - with half the pool held, freeing a random block (the time includes
+ *    the rand() call).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "blk_alloc_host.h"
+
+#define PAIRS 2000000
+
+struct pool {
+    const char *name;
+    unsigned int count;
+    uint32_t *(*alloc)(void);
+    void (*free)(uint32_t *b);
+};
+
+DECLARE_BLK_ALLOC(new100, uint32_t, 100)
+DECLARE_BLK_ALLOC_LEGACY(old100, uint32_t, 100)
+DECLARE_BLK_ALLOC(new256, uint32_t, 256)
+DECLARE_BLK_ALLOC_LEGACY(old256, uint32_t, 256)
+
+static const struct pool pools[] = {
+    { "legacy", 100, old100_alloc, old100_free },
+    { "word", 100, new100_alloc, new100_free },
+    { "legacy", 256, old256_alloc, old256_free },
+    { "word", 256, new256_alloc, new256_free },
+};
+
+static uint32_t *held[256];
+
+enum pattern { HOT, FIFO, RANDOM };
+
+static double run(const struct pool *p, enum pattern pattern, unsigned int live)
+{
+    unsigned int i, head = 0, slot;
+    uint64_t start;
+
+    for (i = 0; i < live; i++) {
+        held[i] = p->alloc();
+    }
+    start = now_ns();
+    for (i = 0; i < PAIRS; i++) {
+        switch (pattern) {
+        case HOT:
+            p->free(p->alloc());
+            break;
+        case FIFO:
+            // held[] is a ring of the live blocks, oldest at head
+            p->free(held[head]);
+            held[head] = p->alloc();
+            head = (head + 1) % live;
+            break;
+        case RANDOM:
+            slot = rand() % live;
+            p->free(held[slot]);
+            held[slot] = p->alloc();
+            break;
+        }
+    }
+    start = now_ns() - start;
+    for (i = 0; i < live; i++) {
+        p->free(held[i]);
+    }
+    return (double)start / PAIRS;
+}
+
+int main(void)
+{
+    unsigned int i;
+
+    printf("%-8s %6s %10s %10s %10s %10s %10s\n", "pool", "blocks", "hot 0%",
+           "hot 50%", "hot 90%", "fifo 50%", "rand 50%");
+    for (i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        const struct pool *p = &pools[i];
+
+        srand(1);
+        printf("%-8s %6u %7.1f ns %7.1f ns %7.1f ns %7.1f ns %7.1f ns\n",
+               p->name, p->count, run(p, HOT, 0), run(p, HOT, p->count / 2),
+               run(p, HOT, p->count * 9 / 10), run(p, FIFO, p->count / 2),
+               run(p, RANDOM, p->count / 2));
+    }
+    return 0;
+}
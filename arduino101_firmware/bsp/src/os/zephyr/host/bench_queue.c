@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark of both builds of queue.c, the list of pool elements and the
+ * CONFIG_QUEUE_RING ring:
+ *  - cost of a send/get pair in one thread, the queue holding a few
+ *    messages or none (the ring then gives the semaphore on each send),
+ *  - throughput and latency from 1, 2 and 4 producer threads to one
+ *    consumer thread. Producers wait for a free place on a semaphore given
+ *    by the consumer, so the figures include the thread switches of the
+ *    host, which dominate on a single CPU.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+/* The C library has POSIX timers of the same name as the os.h timers */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#undef timer_create
+#undef timer_delete
+#include "queue_host.h"
+
+#define PAIRS       1000000
+#define MESSAGES    200000      /* per run, split among the producers */
+#define CAPACITY    32
+
+#define MSG(p, n)   ((T_QUEUE_MESSAGE)(uintptr_t)(((p) << 24) | (n)))
+
+static uint64_t sent_at[4][MESSAGES];
+
+struct producer {
+    const struct queue_variant *v;
+    T_QUEUE q;
+    T_SEMAPHORE credits;
+    unsigned int id;
+    unsigned int count;
+};
+
+static void *producer(void *arg)
+{
+    struct producer *p = arg;
+    unsigned int n;
+
+    for (n = 0; n < p->count; n++) {
+        semaphore_take(p->credits, OS_WAIT_FOREVER);
+        sent_at[p->id][n] = now_ns();
+        p->v->send(p->q, MSG(p->id, n), NULL);
+    }
+    return NULL;
+}
+
+static double pair_ns(const struct queue_variant *v, unsigned int backlog)
+{
+    T_QUEUE q = v->create(CAPACITY, NULL);
+    T_QUEUE_MESSAGE msg;
+    uint64_t start;
+    unsigned int i;
+
+    for (i = 0; i < backlog; i++) {
+        v->send(q, MSG(0, i), NULL);
+    }
+    start = now_ns();
+    for (i = 0; i < PAIRS; i++) {
+        v->send(q, MSG(0, i), NULL);
+        v->get(q, &msg, OS_WAIT_FOREVER, NULL);
+    }
+    start = now_ns() - start;
+    for (i = 0; i < backlog; i++) {
+        v->get(q, &msg, OS_WAIT_FOREVER, NULL);
+    }
+    v->delete(q, NULL);
+    return (double)start / PAIRS;
+}
+
+static void run_producers(const struct queue_variant *v, unsigned int nb)
+{
+    struct producer producers[4];
+    pthread_t threads[4];
+    T_SEMAPHORE credits = semaphore_create(CAPACITY, NULL);
+    T_QUEUE q = v->create(CAPACITY, NULL);
+    T_QUEUE_MESSAGE msg;
+    uint64_t start, latency = 0, max = 0, t;
+    unsigned int i, count = MESSAGES / nb * nb;
+
+    start = now_ns();
+    for (i = 0; i < nb; i++) {
+        producers[i] = (struct producer){ v, q, credits, i, MESSAGES / nb };
+        pthread_create(&threads[i], NULL, producer, &producers[i]);
+    }
+    for (i = 0; i < count; i++) {
+        v->get(q, &msg, OS_WAIT_FOREVER, NULL);
+        t = now_ns() - sent_at[(uintptr_t)msg >> 24][(uintptr_t)msg & 0xffffff];
+        semaphore_give(credits, NULL);
+        latency += t;
+        if (t > max) {
+            max = t;
+        }
+    }
+    t = now_ns() - start;
+    for (i = 0; i < nb; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    printf("%u producer%s  %-6s %12.0f %12.1f %12.1f\n", nb, nb > 1 ? "s" : " ",
+           v->name, count * 1e9 / t, latency / 1000.0 / count, max / 1000.0);
+    v->delete(q, NULL);
+    semaphore_delete(credits, NULL);
+}
+
+int main(void)
+{
+    static const unsigned int producers[] = { 1, 2, 4 };
+    unsigned int i, p;
+
+    printf("%-12s %-6s %12s %12s\n", "send/get", "", "empty ns", "backlog ns");
+    for (i = 0; i < NB_QUEUE_VARIANTS; i++) {
+        printf("%-12s %-6s %12.1f %12.1f\n", "", queue_variants[i].name,
+               pair_ns(&queue_variants[i], 0), pair_ns(&queue_variants[i], 4));
+    }
+    printf("\n%-12s %-6s %12s %12s %12s\n", "threads", "", "msg/s", "avg lat us",
+           "max lat us");
+    for (p = 0; p < sizeof(producers) / sizeof(producers[0]); p++) {
+        for (i = 0; i < NB_QUEUE_VARIANTS; i++) {
+            run_producers(&queue_variants[i], producers[p]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark of timer.c, built with the timer wheel, on a simulated tick:
+ *  - cost of a timer_start/timer_stop pair while the other timers of the
+ *    pool are running, for delays hashed on each level of the wheel,
+ *  - wake-ups of timer_task per expiration, and host time per expiration,
+ *    for short and long repeating timers. The host time includes the two
+ *    thread switches of each simulated wake-up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "os/os.h"
+#include "zephyr/os_config.h"
+#include "timer_sim.h"
+
+#define PAIRS       200000
+#define TURN_TICKS  (TIMER_WHEEL_SLOTS << TIMER_WHEEL_SLOT_SHIFT)
+
+static T_TIMER timers[TIMER_POOL_SIZE];
+static unsigned int expirations;
+
+static void count_callback(void *data)
+{
+    expirations++;
+}
+
+static void stop_all(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < TIMER_POOL_SIZE; i++) {
+        timer_stop(timers[i], NULL);
+    }
+    sim_settle();
+}
+
+static void bench_start_stop(const char *name, uint32_t min, uint32_t range)
+{
+    unsigned int i;
+    uint32_t *delays = malloc(PAIRS * sizeof(*delays));
+    uint64_t t0;
+
+    /* the other timers expire first, so that no start signals timer_task */
+    for (i = 1; i < TIMER_POOL_SIZE; i++) {
+        timer_start(timers[i], 1 + rand() % (min / 2), NULL);
+    }
+    sim_settle();
+    for (i = 0; i < PAIRS; i++) {
+        delays[i] = min + rand() % range;
+    }
+
+    t0 = now_ns();
+    for (i = 0; i < PAIRS; i++) {
+        timer_start(timers[0], delays[i], NULL);
+        timer_stop(timers[0], NULL);
+    }
+    printf("start/stop, %-28s %6.1f ns/pair\n", name,
+           (double)(now_ns() - t0) / PAIRS);
+
+    free(delays);
+    stop_all();
+}
+
+static void bench_expire(const char *name, uint32_t min, uint32_t range, uint32_t ticks)
+{
+    unsigned int i;
+    unsigned int timeouts = sim_stats.timeouts;
+    uint64_t t0;
+
+    expirations = 0;
+    for (i = 0; i < TIMER_POOL_SIZE; i++) {
+        timer_delete(timers[i], NULL);
+        timers[i] = timer_create(count_callback, NULL, min + rand() % range,
+                                 true, true, NULL);
+    }
+
+    t0 = now_ns();
+    sim_advance(sim_now() + ticks);
+    timeouts = sim_stats.timeouts - timeouts;
+    printf("expire, %-32s %7u expirations, %.2f wake-ups/expiration, %.0f ns/expiration\n",
+           name, expirations, (double)timeouts / expirations,
+           (double)(now_ns() - t0) / expirations);
+
+    stop_all();
+    for (i = 0; i < TIMER_POOL_SIZE; i++) {
+        timer_delete(timers[i], NULL);
+        timers[i] = timer_create(count_callback, NULL, 0, false, false, NULL);
+    }
+}
+
+int main(void)
+{
+    unsigned int i;
+
+    sim_init();
+    srand(1);
+    for (i = 0; i < TIMER_POOL_SIZE; i++) {
+        timers[i] = timer_create(count_callback, NULL, 0, false, false, NULL);
+    }
+
+    printf("%u timers, %u slots of %u ticks per level\n", TIMER_POOL_SIZE,
+           TIMER_WHEEL_SLOTS, 1U << TIMER_WHEEL_SLOT_SHIFT);
+    bench_start_stop("level 0 (current turn)", 32, 32);
+    bench_start_stop("level 1", TURN_TICKS * 2, TURN_TICKS * (TIMER_WHEEL_SLOTS - 3));
+    bench_start_stop("level 1, beyond last turn", TURN_TICKS * TIMER_WHEEL_SLOTS * 2, 1000000);
+
+    bench_expire("repeating 1-64 ticks", 1, 64, 1000000);
+    bench_expire("repeating 1-10 s", 1000, 9000, 10000000);
+    bench_expire("repeating 10-60 s", 10000, 50000, 100000000);
+    return 0;
+}
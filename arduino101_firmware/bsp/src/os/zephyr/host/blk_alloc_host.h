@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of the DECLARE_BLK_ALLOC pools of zephyr/common.h, and of the
+ * macro as it was before the word search, testing the blocks one by one
+ * from the start of the pool, for comparison. The legacy copy has the
+ * interrupt lock of a double free released, and unsigned tracker bits.
+ */
+
+#ifndef __BLK_ALLOC_HOST_H__
+#define __BLK_ALLOC_HOST_H__
+
+#include <stdbool.h>
+#include "os/os.h"
+#include "zephyr/os_specific.h"
+#include "zephyr/common.h"
+
+/* Count the "Already free" logs of the pools instead of printing them */
+#undef _log
+#define _log(...) (blk_logs++)
+
+/** Number of logs of the pools */
+extern unsigned long blk_logs;
+
+#define DECLARE_BLK_ALLOC_LEGACY(var, type, count) \
+type var##_elements[count]; \
+unsigned int var##_track_alloc[count/INT_SIZE+1] = { 0 }; \
+unsigned int var##_alloc_max = 0; \
+unsigned int var##_alloc_cur = 0; \
+type * var##_alloc(void) { \
+    int i; \
+    INT_FLAGS flags = DISABLE_INT(); \
+    for ( i = 0; i < count; i++) { \
+        int wi = i/INT_SIZE; \
+        int bi = INT_SIZE - 1 - (i%INT_SIZE); \
+        if ((var##_track_alloc[wi] & 1u << bi) == 0) { \
+            var##_track_alloc[wi] |= 1u << (bi); \
+            var##_alloc_cur++; \
+            if (var##_alloc_cur > var##_alloc_max) var##_alloc_max = var##_alloc_cur;\
+            RESTORE_INT(flags); \
+            return &var##_elements[i]; \
+        } \
+    }\
+    RESTORE_INT(flags); \
+    return NULL; \
+} \
+void var##_free(type * ptr) { \
+   int index =  ptr - var##_elements; \
+   INT_FLAGS flags; \
+   if (index < count) { \
+       flags = DISABLE_INT(); \
+       if ((var##_track_alloc[index/INT_SIZE] & 1u << (INT_SIZE - 1 -(index%INT_SIZE))) == 0) { \
+           RESTORE_INT(flags); \
+           return; \
+       } \
+       var##_track_alloc[index/INT_SIZE] &= ~(1u << (INT_SIZE-1-(index%INT_SIZE))); \
+       RESTORE_INT(flags); \
+       var##_alloc_cur--; \
+   } \
+}
+
+/** Interrupt lock depth of the interrupt_lock() stub */
+extern int irq_depth;
+
+/** Number of interrupt_lock() calls */
+extern unsigned long irq_locks;
+
+/**
+ * Return the monotonic time in ns.
+ */
+uint64_t now_ns(void);
+
+#endif /* __BLK_ALLOC_HOST_H__ */
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host stand-in for the microkernel API used by the OS abstraction layer,
+ * implemented by timer_sim.c, and by queue_host.c for the mutexes.
+ */
+
+#ifndef __HOST_MICROKERNEL_H__
+#define __HOST_MICROKERNEL_H__
+
+#include <stdint.h>
+
+#define RC_OK   0
+#define RC_TIME 2
+
+typedef uint32_t ksem_t;
+typedef uint32_t ktask_t;
+typedef uint32_t kmutex_t;
+
+void task_sem_give(ksem_t sema);
+void fiber_sem_give(ksem_t sema, void *context);
+void isr_sem_give(ksem_t sema, void *context);
+int task_sem_take_wait_timeout(ksem_t sema, int32_t timeout);
+
+uint32_t task_tick_get_32(void);
+void task_start(ktask_t task);
+
+int task_mutex_lock_wait(kmutex_t mutex);
+void task_mutex_unlock(kmutex_t mutex);
+
+#endif /* __HOST_MICROKERNEL_H__ */
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Kernel services used by queue.c, and the table of the two builds of
+ * queue.c.
+ */
+
+#include <sched.h>
+#include <stdio.h>
+/* The C library has POSIX timers of the same name as the os.h timers */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+
+#include "queue_host.h"
+#include "atomic.h"
+#include "nanokernel.h"
+#include "microkernel.h"
+
+#define DECLARE_QUEUE_VARIANT(v) \
+    extern T_QUEUE queue_create_##v(uint32_t max_size, OS_ERR_TYPE *err); \
+    extern void queue_delete_##v(T_QUEUE queue, OS_ERR_TYPE *err); \
+    extern void queue_send_message_##v(T_QUEUE queue, T_QUEUE_MESSAGE message, OS_ERR_TYPE *err); \
+    extern void queue_get_message_##v(T_QUEUE queue, T_QUEUE_MESSAGE *message, int timeout, OS_ERR_TYPE *err);
+
+DECLARE_QUEUE_VARIANT(list)
+DECLARE_QUEUE_VARIANT(ring)
+
+const struct queue_variant queue_variants[NB_QUEUE_VARIANTS] = {
+    { "list", queue_create_list, queue_delete_list, queue_send_message_list, queue_get_message_list },
+    { "ring", queue_create_ring, queue_delete_ring, queue_send_message_ring, queue_get_message_ring },
+};
+
+unsigned int queue_panics;
+unsigned int queue_preempt;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void panic(int err)
+{
+    printf("panic %d\n", err);
+    queue_panics++;
+}
+
+int context_type_get(void)
+{
+    return NANO_CTX_TASK;
+}
+
+/* The pool lock of queue.c, the only mutex it uses */
+int task_mutex_lock_wait(kmutex_t mutex)
+{
+    pthread_mutex_lock(&pool_mutex);
+    return RC_OK;
+}
+
+void task_mutex_unlock(kmutex_t mutex)
+{
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+/* Let another thread run between the atomic operations, see queue_preempt */
+static void preempt(void)
+{
+    static unsigned int calls;
+
+    if (queue_preempt &&
+        __atomic_add_fetch(&calls, 1, __ATOMIC_RELAXED) % queue_preempt == 0) {
+        sched_yield();
+    }
+}
+
+atomic_val_t atomic_get(const atomic_t *target)
+{
+    atomic_val_t ret = __atomic_load_n(target, __ATOMIC_SEQ_CST);
+
+    preempt();
+    return ret;
+}
+
+atomic_val_t atomic_set(atomic_t *target, atomic_val_t value)
+{
+    atomic_val_t ret = __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+
+    preempt();
+    return ret;
+}
+
+int atomic_cas(atomic_t *target, atomic_val_t oldValue, atomic_val_t newValue)
+{
+    int ret = __atomic_compare_exchange_n(target, &oldValue, newValue, 0,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+
+    preempt();
+    return ret;
+}
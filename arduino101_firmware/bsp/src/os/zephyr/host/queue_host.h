@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of queue.c. The Makefile builds it twice for the microkernel,
+ * without and with CONFIG_QUEUE_RING, and suffixes the exported symbols of
+ * each build with _list or _ring so that both backends live in the same
+ * program. The semaphores, the interrupt lock and the clock are those of the
+ * LINUX OS abstraction layer.
+ */
+
+#ifndef __QUEUE_HOST_H__
+#define __QUEUE_HOST_H__
+
+#include "os/os.h"
+
+/** A build of queue.c */
+struct queue_variant {
+    const char *name;
+    T_QUEUE (*create)(uint32_t max_size, OS_ERR_TYPE *err);
+    void (*delete)(T_QUEUE queue, OS_ERR_TYPE *err);
+    void (*send)(T_QUEUE queue, T_QUEUE_MESSAGE message, OS_ERR_TYPE *err);
+    void (*get)(T_QUEUE queue, T_QUEUE_MESSAGE *message, int timeout, OS_ERR_TYPE *err);
+};
+
+#define NB_QUEUE_VARIANTS 2
+
+extern const struct queue_variant queue_variants[NB_QUEUE_VARIANTS];
+
+/** Number of panics, the queue functions return after them */
+extern unsigned int queue_panics;
+
+/**
+ * If not 0, the atomic operations yield the CPU once every queue_preempt
+ * calls, so that on a single CPU the threads also switch between the steps
+ * of the ring operations, not only when they block.
+ */
+extern unsigned int queue_preempt;
+
+/**
+ * Return the monotonic time in ns.
+ */
+uint64_t now_ns(void);
+
+#endif /* __QUEUE_HOST_H__ */
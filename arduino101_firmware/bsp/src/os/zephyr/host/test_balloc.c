@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs the same random allocations and releases through the legacy and
+ * the constant-time builds of balloc.c, and checks both against a model of
+ * the pools: the block returned is the first free block of the first pool
+ * large enough for the request that has one, errors are the same, and
+ * releases of free or foreign buffers are rejected.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "balloc_host.h"
+
+#define STEPS       200000
+#define MAX_LIVE    160
+#define MAX_BLOCKS  64
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* Model of the pools: block usage of each pool */
+static uint8_t model_used[16][MAX_BLOCKS];
+
+/* Live buffers of each variant, allocated in the same order */
+static void *live[NB_VARIANTS][MAX_LIVE];
+static unsigned int live_count;
+
+/*
+ * Return the block the model expects for a request, with the pool in
+ * *pool, or -1 with the expected error in *err.
+ */
+static int model_alloc(uint32_t size, unsigned int *pool, OS_ERR_TYPE *err)
+{
+    const T_POOL_DESC *pools = balloc_variants[0].pools;
+    unsigned int i, b;
+
+    if (size == 0) {
+        *err = E_OS_ERR;
+        return -1;
+    }
+    for (i = 0; i < balloc_nb_pools && size > pools[i].size; i++);
+    if (i == balloc_nb_pools) {
+        *err = E_OS_ERR_NOT_ALLOWED;
+        return -1;
+    }
+    /* Larger pools are used when a pool is full (MALLOC_ALLOW_OUTCLASS) */
+    for (; i < balloc_nb_pools; i++) {
+        for (b = 0; b < pools[i].count && model_used[i][b]; b++);
+        if (b < pools[i].count) {
+            *pool = i;
+            *err = E_OS_OK;
+            return b;
+        }
+    }
+    *err = E_OS_ERR_NO_MEMORY;
+    return -1;
+}
+
+/* Sizes of the pools, or just above them, and sometimes invalid sizes */
+static uint32_t rand_size(void)
+{
+    const T_POOL_DESC *pools = balloc_variants[0].pools;
+    unsigned int pool = rand() % balloc_nb_pools;
+
+    switch (rand() % 16) {
+        case 0:
+            return 0;
+        case 1:
+            return pools[balloc_nb_pools - 1].size + 1 + rand() % 100;
+        default:
+            return pools[pool].size - rand() % (pool ? pools[pool].size - pools[pool - 1].size : pools[0].size);
+    }
+}
+
+static void step_alloc(void)
+{
+    uint32_t size = rand_size();
+    unsigned int pool = 0, got_pool, got_block;
+    OS_ERR_TYPE expected, err;
+    int block, v;
+    void *ptr;
+
+    block = model_alloc(size, &pool, &expected);
+    for (v = 0; v < NB_VARIANTS; v++) {
+        ptr = balloc_variants[v].alloc(size, &err);
+        CHECK(err == expected);
+        if (block < 0) {
+            CHECK(ptr == NULL);
+            continue;
+        }
+        CHECK(ptr != NULL);
+        if (ptr == NULL) {
+            continue;
+        }
+        CHECK(balloc_find_block(&balloc_variants[v], ptr, &got_pool, &got_block) == 0);
+        CHECK(got_pool == pool && got_block == (unsigned int)block);
+        /* The block is writable over the requested size */
+        memset(ptr, 0xa5, size);
+        live[v][live_count] = ptr;
+    }
+    if (block >= 0) {
+        model_used[pool][block] = 1;
+        live_count++;
+    }
+}
+
+static void step_free(void)
+{
+    unsigned int i = rand() % live_count;
+    unsigned int pool, block;
+    int v;
+
+    for (v = 0; v < NB_VARIANTS; v++) {
+        CHECK(balloc_variants[v].free(live[v][i]) == E_OS_OK);
+        /* A second release is rejected */
+        if (rand() % 8 == 0) {
+            CHECK(balloc_variants[v].free(live[v][i]) == E_OS_ERR);
+        }
+    }
+    if (balloc_find_block(&balloc_variants[0], live[0][i], &pool, &block) == 0) {
+        model_used[pool][block] = 0;
+    }
+    live_count--;
+    for (v = 0; v < NB_VARIANTS; v++) {
+        live[v][i] = live[v][live_count];
+    }
+}
+
+/* Releases of buffers which were not returned by balloc */
+static void check_foreign(void)
+{
+    uint32_t local;
+    int v;
+
+    for (v = 0; v < NB_VARIANTS; v++) {
+        CHECK(balloc_variants[v].free(NULL) == E_OS_ERR);
+        CHECK(balloc_variants[v].free(&local) == E_OS_ERR);
+        CHECK(balloc_variants[v].free(&balloc_variants[v]) == E_OS_ERR);
+    }
+}
+
+/* Exhaust every pool, the largest first, then release everything */
+static void check_exhaust(void)
+{
+    const T_POOL_DESC *pools = balloc_variants[0].pools;
+    unsigned int i, b;
+    OS_ERR_TYPE err;
+    void *ptr;
+    int v;
+
+    for (v = 0; v < NB_VARIANTS; v++) {
+        for (i = balloc_nb_pools; i-- > 0;) {
+            for (b = 0; b < pools[i].count; b++) {
+                ptr = balloc_variants[v].alloc(pools[i].size, &err);
+                CHECK(ptr == (void *)(balloc_variants[v].pools[i].start + b * pools[i].size));
+            }
+            CHECK(balloc_variants[v].alloc(pools[i].size, &err) == NULL);
+            CHECK(err == E_OS_ERR_NO_MEMORY);
+        }
+        for (i = 0; i < balloc_nb_pools; i++) {
+            for (b = 0; b < pools[i].count; b++) {
+                ptr = (void *)(balloc_variants[v].pools[i].start + b * pools[i].size);
+                CHECK(balloc_variants[v].free(ptr) == E_OS_OK);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    unsigned int i;
+    int v;
+
+    for (i = 0; i < balloc_nb_pools; i++) {
+        if (i >= 16 || balloc_variants[0].pools[i].count > MAX_BLOCKS) {
+            printf("pool %u: too many blocks for the model\n", i);
+            return 1;
+        }
+    }
+    for (v = 0; v < NB_VARIANTS; v++) {
+        balloc_variants[v].init();
+    }
+
+    srand(1);
+    check_foreign();
+    check_exhaust();
+    for (i = 0; i < STEPS; i++) {
+        if (live_count < MAX_LIVE && (live_count == 0 || rand() % 2)) {
+            step_alloc();
+        } else {
+            step_free();
+        }
+        if (failures > 10) {
+            break;
+        }
+    }
+    while (live_count) {
+        step_free();
+    }
+    check_exhaust();
+
+    printf("%u steps, %u allocation failures logged\n", i, log_errors);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures ? 1 : 0;
+}
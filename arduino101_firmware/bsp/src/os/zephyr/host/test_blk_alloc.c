@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the DECLARE_BLK_ALLOC pools of zephyr/common.h, for pool sizes
+ * around and above the tracker word size, against the legacy macro run in
+ * lockstep: both must return the lowest free block, keep the same usage
+ * and high-water counts, ignore double frees and leave the interrupts
+ * unlocked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "blk_alloc_host.h"
+
+#define STEPS 200000
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+struct pool {
+    unsigned int count;
+    int (*alloc)(void);             /* index of the block, -1 if none */
+    void (*free)(unsigned int i);
+    bool (*used)(unsigned int i);
+    unsigned int *cur;
+    unsigned int *max;
+};
+
+#define DECLARE_POOL(var, count, macro) \
+    macro(var, uint32_t, count) \
+    static int var##_alloc_index(void) \
+    { \
+        uint32_t *b = var##_alloc(); \
+        return b ? b - var##_elements : -1; \
+    } \
+    static void var##_free_index(unsigned int i) \
+    { \
+        var##_free(&var##_elements[i]); \
+    }
+
+#define DECLARE_POOLS(n) \
+    DECLARE_POOL(new##n, n, DECLARE_BLK_ALLOC) \
+    static bool new##n##_used_index(unsigned int i) \
+    { \
+        return new##n##_used(&new##n##_elements[i]); \
+    } \
+    DECLARE_POOL(old##n, n, DECLARE_BLK_ALLOC_LEGACY)
+
+#define POOL_PAIR(n) \
+    { n, new##n##_alloc_index, new##n##_free_index, new##n##_used_index, \
+      &new##n##_alloc_cur, &new##n##_alloc_max }, \
+    { n, old##n##_alloc_index, old##n##_free_index, NULL, \
+      &old##n##_alloc_cur, &old##n##_alloc_max }
+
+DECLARE_POOLS(1)
+DECLARE_POOLS(31)
+DECLARE_POOLS(32)
+DECLARE_POOLS(33)
+DECLARE_POOLS(100)
+DECLARE_POOLS(256)
+
+static const struct pool pools[][2] = {
+    { POOL_PAIR(1) }, { POOL_PAIR(31) }, { POOL_PAIR(32) },
+    { POOL_PAIR(33) }, { POOL_PAIR(100) }, { POOL_PAIR(256) },
+};
+
+static void check_pool(const struct pool *p, const struct pool *ref)
+{
+    static bool model[256];
+    unsigned int step, i, live = 0, max = 0;
+    unsigned long logs;
+    int a, b;
+
+    for (i = 0; i < p->count; i++) {
+        model[i] = false;
+    }
+    for (step = 0; step < STEPS; step++) {
+        // Drift between empty and full, in phases
+        unsigned int fill = (step / 5000) % 2 ? 3 : 7;
+
+        i = rand() % p->count;
+        if (rand() % 10 < fill) {
+            a = p->alloc();
+            b = ref->alloc();
+            CHECK(a == b);
+            if (live == p->count) {
+                CHECK(a == -1);
+            } else if (a >= 0) {
+                CHECK(!model[a]);
+                model[a] = true;
+                if (++live > max) {
+                    max = live;
+                }
+            }
+        } else {
+            // Also frees free blocks, which must be ignored
+            logs = blk_logs;
+            p->free(i);
+            ref->free(i);
+            CHECK(blk_logs == logs + !model[i]);
+            if (model[i]) {
+                model[i] = false;
+                live--;
+            }
+        }
+        CHECK(irq_depth == 0);
+        CHECK(*p->cur == live && *ref->cur == live);
+        if (failures) {
+            printf("pool of %u blocks, step %u\n", p->count, step);
+            return;
+        }
+    }
+    CHECK(*p->max == max && *ref->max == max);
+    for (i = 0; i < p->count; i++) {
+        CHECK(p->used(i) == model[i]);
+    }
+}
+
+int main(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        check_pool(&pools[i][0], &pools[i][1]);
+    }
+
+    printf("%s test_blk_alloc\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks both builds of queue.c, the list of pool elements and the
+ * CONFIG_QUEUE_RING ring:
+ *  - messages are read in order, a full queue refuses messages, an empty
+ *    one times out,
+ *  - several producer threads sending to one consumer thread lose, repeat
+ *    or reorder no message of a producer, and never leave the consumer
+ *    asleep on a queue that holds messages, also when the threads are
+ *    switched in the middle of the ring operations (queue_preempt).
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+/* The C library has POSIX timers of the same name as the os.h timers */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#undef timer_create
+#undef timer_delete
+#include "queue_host.h"
+
+#define PRODUCERS   4
+#define MESSAGES    100000      /* per producer */
+#define CAPACITY    16
+#define LAPS        1000
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define MSG(p, n)   ((T_QUEUE_MESSAGE)(uintptr_t)(((p) << 24) | (n)))
+
+static void check_fifo(const struct queue_variant *v)
+{
+    T_QUEUE q;
+    T_QUEUE_MESSAGE msg;
+    OS_ERR_TYPE err;
+    uint64_t start;
+    unsigned int i, lap, panics = queue_panics;
+
+    q = v->create(5, &err);
+    CHECK(q != NULL && err == E_OS_OK);
+    v->get(q, &msg, OS_NO_WAIT, &err);
+    CHECK(err == E_OS_ERR_EMPTY);
+    start = now_ns();
+    v->get(q, &msg, 20, &err);
+    CHECK(err == E_OS_ERR_TIMEOUT && now_ns() - start >= 19000000);
+
+    // The ring has 8 slots, max_size still applies
+    for (i = 0; i < 5; i++) {
+        v->send(q, MSG(0, i), &err);
+        CHECK(err == E_OS_OK);
+    }
+    v->send(q, MSG(0, 5), &err);
+    CHECK(err == E_OS_ERR_OVERFLOW && queue_panics == panics + 1);
+    for (i = 0; i < 5; i++) {
+        v->get(q, &msg, OS_NO_WAIT, &err);
+        CHECK(err == E_OS_OK && msg == MSG(0, i));
+    }
+    v->get(q, &msg, OS_NO_WAIT, &err);
+    CHECK(err == E_OS_ERR_EMPTY);
+
+    // Many laps of the ring
+    for (lap = 0; lap < LAPS; lap++) {
+        for (i = 0; i < 3; i++) {
+            v->send(q, MSG(1, lap * 3 + i), NULL);
+        }
+        for (i = 0; i < 3; i++) {
+            v->get(q, &msg, OS_NO_WAIT, &err);
+            CHECK(err == E_OS_OK && msg == MSG(1, lap * 3 + i));
+        }
+    }
+
+    // Messages left in the queue are dropped with it
+    v->send(q, MSG(2, 0), NULL);
+    v->delete(q, &err);
+    CHECK(err == E_OS_OK);
+    q = v->create(CAPACITY, &err);
+    CHECK(q != NULL);
+    v->get(q, &msg, OS_NO_WAIT, &err);
+    CHECK(err == E_OS_ERR_EMPTY);
+    v->delete(q, &err);
+    CHECK(queue_panics == panics + 1);
+}
+
+struct stress {
+    const struct queue_variant *v;
+    T_QUEUE q;
+    T_SEMAPHORE credits;    /* free places in the queue */
+    unsigned int id;
+};
+
+static void *producer(void *arg)
+{
+    struct stress *s = arg;
+    OS_ERR_TYPE err;
+    unsigned int n;
+
+    for (n = 0; n < MESSAGES; n++) {
+        semaphore_take(s->credits, OS_WAIT_FOREVER);
+        s->v->send(s->q, MSG(s->id, n), &err);
+        if (err != E_OS_OK) {
+            printf("%s: producer %u: send error %d\n", s->v->name, s->id, err);
+            failures++;
+        }
+    }
+    return NULL;
+}
+
+static void check_producers(const struct queue_variant *v)
+{
+    struct stress stress[PRODUCERS];
+    pthread_t threads[PRODUCERS];
+    unsigned int next[PRODUCERS] = { 0 };
+    unsigned int i, p, n, errors = 0, panics = queue_panics;
+    T_SEMAPHORE credits = semaphore_create(CAPACITY, NULL);
+    T_QUEUE_MESSAGE msg;
+    OS_ERR_TYPE err;
+    T_QUEUE q = v->create(CAPACITY, NULL);
+
+    for (i = 0; i < PRODUCERS; i++) {
+        stress[i] = (struct stress){ v, q, credits, i };
+        pthread_create(&threads[i], NULL, producer, &stress[i]);
+    }
+    for (i = 0; i < PRODUCERS * MESSAGES; i++) {
+        // A message is always on its way: a timeout is a lost wake-up
+        v->get(q, &msg, 1000, &err);
+        if (err != E_OS_OK) {
+            // The producers may be blocked for good
+            printf("%s: message %u: error %d\nFAIL test_queue\n", v->name, i, err);
+            exit(1);
+        }
+        semaphore_give(credits, NULL);
+        p = (uintptr_t)msg >> 24;
+        n = (uintptr_t)msg & 0xffffff;
+        if (p >= PRODUCERS || n != next[p]) {
+            if (errors++ < 10) {
+                printf("%s: got %u:%u, expected %u:%u\n", v->name, p, n,
+                       p < PRODUCERS ? p : 0, p < PRODUCERS ? next[p] : 0);
+            }
+            failures++;
+        }
+        if (p < PRODUCERS) {
+            next[p] = n + 1;
+        }
+    }
+    for (i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+        CHECK(next[i] == MESSAGES);
+    }
+    v->get(q, &msg, OS_NO_WAIT, &err);
+    CHECK(err == E_OS_ERR_EMPTY);
+    CHECK(queue_panics == panics);
+    v->delete(q, NULL);
+    semaphore_delete(credits, NULL);
+}
+
+int main(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < NB_QUEUE_VARIANTS; i++) {
+        check_fifo(&queue_variants[i]);
+        check_producers(&queue_variants[i]);
+        queue_preempt = 3;
+        check_producers(&queue_variants[i]);
+        queue_preempt = 0;
+    }
+
+    printf("%s test_queue\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
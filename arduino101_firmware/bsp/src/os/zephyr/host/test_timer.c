@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Runs timer.c, built with the timer wheel, on a simulated tick and
+ * checks that:
+ *  - timers fire on their exact expiration tick, in expiration order, and
+ *    never after being stopped, against a model of the timers,
+ *  - timer_task only wakes up about once per turn of the second level of
+ *    the wheel while waiting for a far timer, and once for a timer due
+ *    within TIMER_WHEEL_SLOTS turns.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "os/os.h"
+#include "zephyr/os_config.h"
+#include "timer_sim.h"
+
+#define STEPS       50000
+
+#define TURN_TICKS  (TIMER_WHEEL_SLOTS << TIMER_WHEEL_SLOT_SHIFT)
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* Model of the timers of the pool */
+static struct {
+    T_TIMER timer;
+    int running;
+    int repeat;
+    uint32_t delay;
+    uint32_t expiration;
+    unsigned int fired;
+} model[TIMER_POOL_SIZE];
+
+static uint32_t last_fired;
+static unsigned int fired;
+
+static void model_callback(void *data)
+{
+    unsigned int i = (unsigned int)(uintptr_t)data;
+    uint32_t now = sim_now();
+
+    CHECK(model[i].running);
+    CHECK(now == model[i].expiration);
+    CHECK((int32_t)(now - last_fired) >= 0);
+    last_fired = now;
+    fired++;
+    model[i].fired++;
+    if (model[i].repeat) {
+        model[i].expiration += model[i].delay;
+    } else {
+        model[i].running = 0;
+    }
+}
+
+/* Delays in ticks, from within a slot to many turns of the second level */
+static uint32_t random_delay(void)
+{
+    static const uint32_t ranges[] = {
+        TIMER_WHEEL_SLOTS,
+        TURN_TICKS * 2,
+        TURN_TICKS * TIMER_WHEEL_SLOTS,
+        TURN_TICKS * TIMER_WHEEL_SLOTS * 8,
+    };
+
+    return 1 + rand() % ranges[rand() % 4];
+}
+
+static void check_far_timer(uint32_t delay, unsigned int max_wakeups)
+{
+    OS_ERR_TYPE err;
+    uint32_t start = sim_now();
+    unsigned int timeouts = sim_stats.timeouts;
+
+    model[0].repeat = 0;
+    model[0].delay = delay;
+    model[0].expiration = start + delay;
+    model[0].running = 1;
+    model[0].fired = 0;
+    timer_start(model[0].timer, delay, &err);
+    CHECK(err == E_OS_OK);
+
+    sim_advance(start + delay - 1);
+    CHECK(model[0].fired == 0);
+    sim_advance(start + delay);
+    CHECK(model[0].fired == 1);
+
+    timeouts = sim_stats.timeouts - timeouts;
+    printf("timer in %u ticks: %u wake-ups of timer_task\n", delay, timeouts);
+    CHECK(timeouts <= max_wakeups);
+}
+
+static void step(void)
+{
+    OS_ERR_TYPE err;
+    unsigned int i = rand() % TIMER_POOL_SIZE;
+
+    if (model[i].running) {
+        if (rand() % 4 == 0) {
+            timer_stop(model[i].timer, &err);
+            CHECK(err == E_OS_OK);
+            model[i].running = 0;
+        }
+    } else {
+        /* repeating timers are kept away from the tick rate */
+        model[i].repeat = rand() % 4 == 0;
+        model[i].delay = random_delay() + (model[i].repeat ? TURN_TICKS : 0);
+        model[i].expiration = sim_now() + model[i].delay;
+        model[i].running = 1;
+        /* the repeat flag is only set at creation */
+        timer_delete(model[i].timer, &err);
+        CHECK(err == E_OS_OK);
+        model[i].timer = timer_create(model_callback, (void *)(uintptr_t)i,
+                                      model[i].delay, model[i].repeat, true, &err);
+        CHECK(err == E_OS_OK);
+    }
+    sim_settle();
+    sim_advance(sim_now() + rand() % (rand() % 2 ? TIMER_WHEEL_SLOTS : TURN_TICKS * 4));
+}
+
+int main(void)
+{
+    OS_ERR_TYPE err;
+    unsigned int i;
+    uint32_t end;
+
+    sim_init();
+    srand(1);
+
+    for (i = 0; i < TIMER_POOL_SIZE; i++) {
+        model[i].timer = timer_create(model_callback, (void *)(uintptr_t)i, 0,
+                                      false, false, &err);
+        CHECK(err == E_OS_OK);
+    }
+
+    /* exact wake-up when due within the second level, then one per turn */
+    check_far_timer(TURN_TICKS + TURN_TICKS / 2, 1);
+    check_far_timer(TURN_TICKS * (TIMER_WHEEL_SLOTS - 1), 1);
+    check_far_timer(1000000, 1000000 / (TURN_TICKS * (TIMER_WHEEL_SLOTS - 1)) + 2);
+
+    for (i = 0; i < STEPS && failures <= 10; i++) {
+        step();
+    }
+
+    /* all the remaining one-shot timers fire on time */
+    for (i = 0; i < TIMER_POOL_SIZE; i++) {
+        if (model[i].running && model[i].repeat) {
+            timer_stop(model[i].timer, &err);
+            model[i].running = 0;
+        }
+    }
+    end = sim_now() + TURN_TICKS * TIMER_WHEEL_SLOTS * 8 + 1;
+    sim_advance(end);
+    for (i = 0; i < TIMER_POOL_SIZE; i++) {
+        CHECK(!model[i].running);
+    }
+
+    printf("%u steps, %u timers fired, %u wake-ups of timer_task on a timeout\n",
+           STEPS, fired, sim_stats.timeouts);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures ? 1 : 0;
+}
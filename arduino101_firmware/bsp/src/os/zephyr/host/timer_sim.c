@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Simulated tick and semaphore of timer_task, see timer_sim.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+/* The C library has POSIX timers of the same name as the os.h timers */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <pthread.h>
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+
+#include "os/os.h"
+#include "nanokernel.h"
+#include "microkernel.h"
+#include "timer_sim.h"
+
+extern void framework_init_timer(void);
+extern void timer_task(int dummy1, int dummy2);
+
+/* Timeouts on the current tick allowed in a row, before timer_task is deemed stuck */
+#define SIM_MAX_STALLED 1000
+
+int32_t sys_clock_ticks_per_sec = 1000;
+int32_t sys_clock_us_per_tick = 1000;
+
+struct sim_stats sim_stats;
+
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t sim_tick;
+static unsigned int sim_sem;
+static int sim_waiting;
+static int sim_has_deadline;
+static uint32_t sim_deadline;
+static unsigned int sim_stalled;
+static uint32_t sim_stalled_tick;
+
+static int sim_deadline_reached(void)
+{
+    return sim_has_deadline && (int32_t)(sim_tick - sim_deadline) >= 0;
+}
+
+static int sim_idle(void)
+{
+    return sim_waiting && 0 == sim_sem && !sim_deadline_reached();
+}
+
+uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int context_type_get(void)
+{
+    return NANO_CTX_TASK;
+}
+
+uint32_t task_tick_get_32(void)
+{
+    uint32_t tick;
+
+    pthread_mutex_lock(&sim_lock);
+    tick = sim_tick;
+    pthread_mutex_unlock(&sim_lock);
+    return tick;
+}
+
+void task_sem_give(ksem_t sema)
+{
+    pthread_mutex_lock(&sim_lock);
+    sim_sem++;
+    pthread_cond_broadcast(&sim_cond);
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void fiber_sem_give(ksem_t sema, void *context)
+{
+    task_sem_give(sema);
+}
+
+void isr_sem_give(ksem_t sema, void *context)
+{
+    task_sem_give(sema);
+}
+
+int task_sem_take_wait_timeout(ksem_t sema, int32_t timeout)
+{
+    int rc = RC_OK;
+
+    pthread_mutex_lock(&sim_lock);
+    if (0 == sim_sem) {
+        sim_waiting = 1;
+        sim_has_deadline = OS_WAIT_FOREVER != timeout;
+        sim_deadline = sim_tick + timeout;
+        pthread_cond_broadcast(&sim_cond);
+        while (0 == sim_sem && !sim_deadline_reached()) {
+            pthread_cond_wait(&sim_cond, &sim_lock);
+        }
+        sim_waiting = 0;
+    }
+    if (0 != sim_sem) {
+        sim_sem--;
+    } else {
+        rc = RC_TIME;
+        sim_stats.timeouts++;
+        /* a timer_task that keeps timing out on the same tick never sleeps */
+        sim_stalled = sim_tick == sim_stalled_tick ? sim_stalled + 1 : 0;
+        sim_stalled_tick = sim_tick;
+        if (sim_stalled > SIM_MAX_STALLED) {
+            printf("timer_task keeps waking up at tick %u\nFAIL\n", sim_tick);
+            exit(1);
+        }
+    }
+    sim_stats.wakeups++;
+    pthread_mutex_unlock(&sim_lock);
+    return rc;
+}
+
+static void *sim_timer_thread(void *arg)
+{
+    timer_task(0, 0);
+    return NULL;
+}
+
+void task_start(ktask_t task)
+{
+    pthread_t thread;
+
+    if (pthread_create(&thread, NULL, sim_timer_thread, NULL) != 0) {
+        abort();
+    }
+    pthread_detach(thread);
+}
+
+void sim_init(void)
+{
+    framework_init_timer();
+    sim_settle();
+    sim_stats.wakeups = 0;
+    sim_stats.timeouts = 0;
+}
+
+uint32_t sim_now(void)
+{
+    return task_tick_get_32();
+}
+
+void sim_settle(void)
+{
+    pthread_mutex_lock(&sim_lock);
+    while (!sim_idle()) {
+        pthread_cond_wait(&sim_cond, &sim_lock);
+    }
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void sim_advance(uint32_t tick)
+{
+    pthread_mutex_lock(&sim_lock);
+    for (;;) {
+        while (!sim_idle()) {
+            pthread_cond_wait(&sim_cond, &sim_lock);
+        }
+        if (!sim_has_deadline || (int32_t)(tick - sim_deadline) < 0) {
+            break;
+        }
+        /* jump to the timeout of timer_task and let it run */
+        sim_tick = sim_deadline;
+        pthread_cond_broadcast(&sim_cond);
+    }
+    sim_tick = tick;
+    pthread_mutex_unlock(&sim_lock);
+}
+
+void panic(int err)
+{
+    printf("panic %d\n", err);
+    abort();
+}
+
+void error_management(OS_ERR_TYPE *err, OS_ERR_TYPE localErr)
+{
+    if (err != NULL) {
+        *err = localErr;
+    } else if (localErr != E_OS_OK) {
+        panic(localErr);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Simulation of the kernel services used by timer.c on the host.
+ *
+ * timer_task runs in its own thread, and the disable_scheduling() lock is
+ * the one of the LINUX OS abstraction layer. The tick only moves when the
+ * test calls sim_advance(): the tick then jumps from one timeout of
+ * timer_task to the next, so that timers fire on their exact tick and the
+ * wake-ups of timer_task can be counted.
+ */
+
+#ifndef __TIMER_SIM_H__
+#define __TIMER_SIM_H__
+
+#include <stdint.h>
+
+/** Wake-ups of timer_task since sim_init() */
+struct sim_stats {
+    unsigned int wakeups;   /* returns from the semaphore wait */
+    unsigned int timeouts;  /* wake-ups on a timeout, without a signal */
+};
+
+extern struct sim_stats sim_stats;
+
+/** Initialize the timer services and start timer_task, at tick 0 */
+void sim_init(void);
+
+/** Return the current tick */
+uint32_t sim_now(void);
+
+/**
+ * Let timer_task run until it blocks again, with the tick frozen.
+ */
+void sim_settle(void);
+
+/**
+ * Move the tick forward to tick, waking timer_task on each of its
+ * timeouts on the way.
+ *
+ * @param tick tick to stop at, not before the current tick
+ */
+void sim_advance(uint32_t tick);
+
+/** Monotonic host clock in ns, for the benchmarks */
+uint64_t now_ns(void);
+
+#endif /* __TIMER_SIM_H__ */
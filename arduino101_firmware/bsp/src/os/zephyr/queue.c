@@ -67,6 +67,9 @@
 #define MTX_POOL_GENERIC 0x00010021
 
 #include "util/list.h"
+#ifdef CONFIG_QUEUE_RING
+#include <atomic.h>
+#endif
 
 /**********************************************************
  ************** Local definitions  ************************
@@ -75,6 +78,33 @@
 
 
 
+#ifdef CONFIG_QUEUE_RING
+/*
+ * Bounded multi-producer single-consumer ring.
+ *
+ * Each slot holds the index in the ring of the message it expects next: a
+ * producer may fill the slot when seq == index, the consumer may read it when
+ * seq == index + 1. Producers reserve a slot with a CAS on head and never wait
+ * for each other, so a producer interrupted between the reservation and the
+ * publication only delays the messages after its own.
+ */
+typedef struct
+{
+    atomic_t seq;                   // ring index of the expected message
+    void * data;
+}queue_slot;
+
+typedef struct
+{
+    queue_slot * ring;
+    uint32_t mask;                  // number of slots - 1
+    atomic_t head;                  // next index to be reserved by a producer
+    atomic_t tail;                  // next index to be read by the consumer
+    uint32_t max_size;
+    T_SEMAPHORE sema;         /* semaphore used by the listener to wait on the empty queue
+                              and given by the producer that fills the slot it waits on */
+}queue_impl_t;
+#else
 /* Warning 'next' must be the first element of the struct */
 typedef struct                     // element for linked-list
 {
@@ -90,13 +120,22 @@ typedef struct                    // a linked-list of list_element
   T_SEMAPHORE sema;         /* semaphore used by the listener to wait on new incoming data
                               and used by the producer to signal new incoming data in the queue */
 }queue_impl_t;
+#endif
 
 
 // equivalent to : queue_impl_t list_elements[QUEUE_POOL_SIZE];
 DECLARE_BLK_ALLOC(queue, queue_impl_t, QUEUE_POOL_SIZE) /* see common.h */
 
+#ifdef CONFIG_QUEUE_RING
+// Slots of the rings, shared by the queues
+static queue_slot queue_slots[QUEUE_RING_POOL_SIZE];
+static uint32_t queue_slots_used[(QUEUE_RING_POOL_SIZE + 31) / 32];
+#endif
+
+#ifndef CONFIG_QUEUE_RING
 // equivalent to : list_element element[QUEUE_ELEMENT_POOL_SIZE];
 DECLARE_BLK_ALLOC(element,  list_element, QUEUE_ELEMENT_POOL_SIZE) /* see common.h */
+#endif
 
 
 
@@ -117,7 +156,13 @@ static struct nano_sem QueuePoolLockSem;
  **********************************************************/
 void lock_pool(void);
 void unlock_pool(void);
+#ifdef CONFIG_QUEUE_RING
+static OS_ERR_TYPE ring_init(queue_impl_t * queue, uint32_t max_size);            // Allocate the ring of the queue
+static void ring_free(queue_impl_t * queue);                                       // Free the ring of the queue
+static OS_ERR_TYPE add_data(queue_impl_t * queue, void * data, bool * wakeup);    // Append data to the queue
+#else
 static OS_ERR_TYPE add_data(queue_impl_t * queue, void * data);                   // Append data to the queue
+#endif
 static OS_ERR_TYPE remove_data(queue_impl_t *queue, void **data);                 // Remove data to the queue
 
 
@@ -173,6 +218,9 @@ void queue_delete(T_QUEUE queue, OS_ERR_TYPE* err)
             {
                 semaphore_delete(q->sema, &_err);
                 q->sema = NULL;
+#ifdef CONFIG_QUEUE_RING
+                ring_free(q);
+#endif
                 if( _err == E_OS_OK)
                 {
                     queue_free(q);
@@ -233,7 +281,11 @@ T_QUEUE queue_create(uint32_t max_size, OS_ERR_TYPE* err)
     OS_ERR_TYPE _err;
 
 
+#ifdef CONFIG_QUEUE_RING
+    if(max_size==0 || max_size>QUEUE_RING_POOL_SIZE)
+#else
     if(max_size==0 || max_size>QUEUE_ELEMENT_POOL_SIZE)
+#endif
     {
         error_management (err, E_OS_ERR);
         return NULL;
@@ -245,19 +297,29 @@ T_QUEUE queue_create(uint32_t max_size, OS_ERR_TYPE* err)
         /* Block concurrent accesses to the pool of queue_list */
         lock_pool();
         q = queue_alloc();
+        _err = E_OS_ERR;
+#ifdef CONFIG_QUEUE_RING
+        if (q != NULL && (_err = ring_init(q, max_size)) != E_OS_OK)
+        {
+            queue_free(q);
+            q = NULL;
+        }
+#endif
         unlock_pool();
 
         if (q != NULL)
         {
+#ifndef CONFIG_QUEUE_RING
            list_init(&q->_list);  // replace the following commented code
            q->current_size = 0;
+#endif
            q->max_size = max_size;
            q->sema = semaphore_create(0, &_err);
            error_management (err, _err);
         }
         else
         {
-            error_management (err, E_OS_ERR);
+            error_management (err, _err);
         }
     }
     else
@@ -312,6 +374,33 @@ void queue_get_message (T_QUEUE queue, T_QUEUE_MESSAGE* message, int timeout, OS
     /* check execution level */
     if ((E_EXEC_LVL_FIBER == execLvl) || (E_EXEC_LVL_TASK == execLvl))
     {
+#ifdef CONFIG_QUEUE_RING
+        /* The semaphore is only given to wake the consumer up, and may have
+         * been given for messages already read: wait until one is there */
+        uint32_t start = get_time_ms();
+        int left = timeout;
+        while ((_err = remove_data(q, message)) != E_OS_OK)
+        {
+            if (timeout > 0)
+            {
+                left = timeout - (int)(get_time_ms() - start);
+                if (left <= 0)
+                {
+                    _err = E_OS_ERR_TIMEOUT;
+                    break;
+                }
+            }
+            if ((_err = semaphore_take(q->sema, left)) != E_OS_OK)
+            {
+                break;
+            }
+        }
+        switch(_err){
+
+        case E_OS_OK:
+            error_management (err, E_OS_OK);
+            break;
+#else
         _err = semaphore_take(q->sema, timeout);
         switch(_err){
 
@@ -323,6 +412,7 @@ void queue_get_message (T_QUEUE queue, T_QUEUE_MESSAGE* message, int timeout, OS
             error_management (err, E_OS_OK);
         }
             break;
+#endif
         case E_OS_ERR_TIMEOUT:
             error_management (err, E_OS_ERR_TIMEOUT);
             break;
@@ -373,6 +463,17 @@ void queue_send_message(T_QUEUE queue, T_QUEUE_MESSAGE message, OS_ERR_TYPE* err
     /* check input parameters */
     if( queue_used(q) && q->sema != NULL )
     {
+#ifdef CONFIG_QUEUE_RING
+        bool wakeup;
+        if((_err = add_data(q, message, &wakeup)) == E_OS_OK)
+        {
+            if (wakeup)
+            {
+                semaphore_give(q->sema, &_err);  // signal new message in the queue to the listener.
+            }
+            error_management (err, E_OS_OK);
+        }
+#else
         uint32_t it_mask = interrupt_lock();
         _err = add_data(q, message);
         interrupt_unlock(it_mask);
@@ -382,6 +483,7 @@ void queue_send_message(T_QUEUE queue, T_QUEUE_MESSAGE message, OS_ERR_TYPE* err
             semaphore_give(q->sema, &_err);  // signal new message in the queue to the listener.
             error_management (err, E_OS_OK);
         }
+#endif
         else
         {
             error_management (err, _err);
@@ -439,6 +541,109 @@ void unlock_pool(void)
 }
 
 
+#ifdef CONFIG_QUEUE_RING
+/* Reserve size slots of queue_slots, rings are aligned on their size.
+ * Called with the pool locked. */
+static OS_ERR_TYPE ring_init(queue_impl_t * q, uint32_t max_size)
+{
+    uint32_t size = 1, start, i;
+
+    while (size < max_size)
+    {
+        size <<= 1;
+    }
+    for (start = 0; start + size <= QUEUE_RING_POOL_SIZE; start += size)
+    {
+        for (i = start; i < start + size; i++)
+        {
+            if (queue_slots_used[i / 32] & (1u << (i % 32)))
+            {
+                break;
+            }
+        }
+        if (i == start + size)
+        {
+            break;
+        }
+    }
+    if (start + size > QUEUE_RING_POOL_SIZE)
+    {
+        return E_OS_ERR_NO_MEMORY;
+    }
+    q->ring = &queue_slots[start];
+    for (i = 0; i < size; i++)
+    {
+        queue_slots_used[(start + i) / 32] |= 1u << ((start + i) % 32);
+        q->ring[i].seq = i;
+    }
+    q->mask = size - 1;
+    q->head = 0;
+    q->tail = 0;
+    return E_OS_OK;
+}
+
+/* Called with the pool locked */
+static void ring_free(queue_impl_t * q)
+{
+    uint32_t start = q->ring - queue_slots, i;
+
+    for (i = start; i <= start + q->mask; i++)
+    {
+        queue_slots_used[i / 32] &= ~(1u << (i % 32));
+    }
+}
+
+static OS_ERR_TYPE add_data(queue_impl_t * q, void * data, bool * wakeup)
+{
+    queue_slot * slot;
+    atomic_val_t pos;
+
+    /* Reserve a slot */
+    for (;;)
+    {
+        pos = atomic_get(&q->head);
+        slot = &q->ring[pos & q->mask];
+        if ((uint32_t)(pos - atomic_get(&q->tail)) < q->max_size &&
+            atomic_get(&slot->seq) == pos)
+        {
+            if (atomic_cas(&q->head, pos, pos + 1))
+            {
+                break;
+            }
+        }
+        else if (atomic_get(&q->head) == pos)
+        {
+            panic(E_OS_ERR_OVERFLOW); /* Panic if max size reached */
+            return E_OS_ERR_OVERFLOW;
+        }
+        /* Otherwise another producer reserved pos after it was read, and
+         * tail or the slot may already be a lap ahead of it: retry */
+    }
+
+    /* Publish the message, then wake the consumer up if it waits on it. The
+     * atomic store orders the publication before the read of tail. */
+    slot->data = data;
+    atomic_set(&slot->seq, pos + 1);
+    *wakeup = (atomic_get(&q->tail) == pos);
+    return E_OS_OK;
+}
+
+static OS_ERR_TYPE remove_data(queue_impl_t *q, void **data)
+{
+    atomic_val_t pos = atomic_get(&q->tail);
+    queue_slot * slot = &q->ring[pos & q->mask];
+
+    if (atomic_get(&slot->seq) != pos + 1)
+    {
+        return E_OS_ERR_EMPTY;
+    }
+    *data = slot->data;
+    /* Give the slot back to the producers for the next lap of the ring */
+    atomic_set(&slot->seq, pos + q->mask + 1);
+    atomic_set(&q->tail, pos + 1);
+    return E_OS_OK;
+}
+#else
 static OS_ERR_TYPE add_data(queue_impl_t * list, void * data)
 {
     OS_ERR_TYPE err = E_OS_ERR_OVERFLOW;
@@ -483,5 +688,6 @@ static OS_ERR_TYPE remove_data(queue_impl_t *list, void **data)
     }
     return E_OS_OK;
 }
+#endif
 
 /** @} */
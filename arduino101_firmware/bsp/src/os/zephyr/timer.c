@@ -100,8 +100,19 @@ typedef struct _timer_list {
     T_TIMER_DESC desc;
     struct _timer_list* prev;
     struct _timer_list* next;
+#ifdef CONFIG_TIMER_WHEEL
+    struct _timer_wheel_list* list; /* wheel bucket or expired list holding the timer */
+#endif
 }T_TIMER_LIST_ELT;
 
+#ifdef CONFIG_TIMER_WHEEL
+/** List of timers of the wheel, in insertion order */
+typedef struct _timer_wheel_list {
+    T_TIMER_LIST_ELT* head;
+    T_TIMER_LIST_ELT* tail;
+} T_TIMER_WHEEL_LIST;
+#endif
+
 
 
 /**
@@ -144,8 +155,44 @@ static ksem_t g_TimerSem ;
 /** Pool of timers */
 DECLARE_BLK_ALLOC(g_TimerPool, T_TIMER_LIST_ELT, TIMER_POOL_SIZE) /* see common.h */
 
+#ifdef CONFIG_TIMER_WHEEL
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_SLOT_TICKS  (1U << TIMER_WHEEL_SLOT_SHIFT)
+/** Ticks covered by a full turn of the first level, i.e. by a slot of the second level */
+#define TIMER_WHEEL_TURN_TICKS  (TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOT_TICKS)
+
+#if (TIMER_WHEEL_SLOTS > 32) || (TIMER_WHEEL_SLOTS & (TIMER_WHEEL_SLOTS - 1))
+#error "TIMER_WHEEL_SLOTS must be a power of two not exceeding 32"
+#endif
+
+/**
+ * Buckets of active timers, on two levels:
+ *  - level 0 holds the timers due in the current turn, hashed according
+ *    to their expiration slot,
+ *  - level 1 holds the timers due in the next turns, hashed according to
+ *    their expiration turn. Timers due more than TIMER_WHEEL_SLOTS - 1
+ *    turns ahead are kept in the last bucket and moved again when their
+ *    bucket is reached.
+ */
+static T_TIMER_WHEEL_LIST g_TimerWheel[2][TIMER_WHEEL_SLOTS];
+/** Bitmaps of the non empty buckets of each level */
+static uint32_t g_WheelUsed[2];
+/** Expired timers whose callback has not been executed yet */
+static T_TIMER_WHEEL_LIST g_ExpiredTimers;
+/** First tick of the oldest slot that may still hold active timers */
+static uint32_t g_WheelTime;
+/** Number of timers in the wheel buckets */
+static uint32_t g_WheelCount;
+/** Expiration timer_task is waiting for, valid if g_WheelNextValid is true */
+static uint32_t g_WheelNextExpiration;
+static bool g_WheelNextValid;
+/** Next wheel expiration, valid if g_WheelEarliestValid is true */
+static uint32_t g_WheelEarliest;
+static bool g_WheelEarliestValid;
+#else
 /** Head of the chained list that sorts active timers according to their expiration date */
 T_TIMER_LIST_ELT* g_CurrentTimerHead;
+#endif
 
 /**********************************************************
  ************** Forward declarations **********************
@@ -155,6 +202,9 @@ static bool is_after_expiration (uint32_t tick, T_TIMER_DESC* tmrDesc);
 static void add_timer (T_TIMER_LIST_ELT* newTimer);
 static void remove_timer (T_TIMER_LIST_ELT* timerToRemove);
 static void execute_callback (T_TIMER_LIST_ELT* expiredTimer);
+static bool is_next_to_expire (T_TIMER_LIST_ELT* timer);
+static bool get_next_expiration (uint32_t* expiration);
+static T_TIMER_LIST_ELT* get_expired_timer (uint32_t tick);
 
 void timer_task(int dummy1, int dummy2);
 
@@ -203,7 +253,7 @@ static void signal_timer_task (void)
 }
 
 
-#ifdef __DEBUG_OS_ABSTRACTION_TIMER
+#if defined(__DEBUG_OS_ABSTRACTION_TIMER) && !defined(CONFIG_TIMER_WHEEL)
 /**
  *  Print the list of active timers, from tail (first to expire) to head (last to expire).
  */
@@ -254,6 +304,429 @@ static bool is_after_expiration (uint32_t tick, T_TIMER_DESC* tmrDesc)
 }
 
 
+#ifdef CONFIG_TIMER_WHEEL
+
+/**
+ * Append a timer at the tail of a list of the wheel, so that the timers
+ *    expiring on the same tick fire in start order.
+ *
+ * @param list bucket or expired list
+ * @param timer pointer on the timer to insert
+ */
+static void wheel_list_append (T_TIMER_WHEEL_LIST* list, T_TIMER_LIST_ELT* timer)
+{
+    timer->next = NULL;
+    timer->prev = list->tail;
+    if ( NULL != list->tail )
+    {
+        list->tail->next = timer;
+    }
+    else
+    {
+        list->head = timer;
+    }
+    list->tail = timer;
+    timer->list = list;
+}
+
+/**
+ * Insert an expired timer in g_ExpiredTimers, sorted on expiration date.
+ *
+ * The timers are collected in expiration order most of the time, so the
+ *    insertion point is found from the tail of the list.
+ *
+ * @param timer pointer on the timer to insert
+ */
+static void wheel_expired_insert (T_TIMER_LIST_ELT* timer)
+{
+    T_TIMER_LIST_ELT* prev = g_ExpiredTimers.tail;
+
+    while ( NULL != prev && (int32_t) (timer->desc.expiration - prev->desc.expiration) < 0 )
+    {
+        prev = prev->prev;
+    }
+    if ( prev == g_ExpiredTimers.tail )
+    {
+        wheel_list_append (&g_ExpiredTimers, timer);
+        return;
+    }
+    /* insert timer after prev, or at the head */
+    timer->prev = prev;
+    timer->next = ( NULL != prev ) ? prev->next : g_ExpiredTimers.head;
+    timer->next->prev = timer;
+    if ( NULL != prev )
+    {
+        prev->next = timer;
+    }
+    else
+    {
+        g_ExpiredTimers.head = timer;
+    }
+    timer->list = &g_ExpiredTimers;
+}
+
+/**
+ * Insert a timer in the bucket of the wheel that matches its expiration
+ *    date. Timers that are already due are inserted in the current slot.
+ *
+ * @param timer pointer on the timer to insert
+ */
+static void wheel_insert (T_TIMER_LIST_ELT* timer)
+{
+    uint32_t slotTick;
+    uint32_t turnStart;
+    uint32_t turns;
+    uint32_t level;
+    uint32_t bucket;
+
+    slotTick = timer->desc.expiration;
+    if ( (int32_t) (slotTick - g_WheelTime) < 0 )
+    {
+        slotTick = g_WheelTime;
+    }
+
+    turnStart = g_WheelTime & ~(TIMER_WHEEL_TURN_TICKS - 1);
+    turns = (slotTick - turnStart) / TIMER_WHEEL_TURN_TICKS;
+    if ( 0 == turns )
+    {
+        level = 0;
+        bucket = (slotTick / TIMER_WHEEL_SLOT_TICKS) & TIMER_WHEEL_MASK;
+    }
+    else
+    {
+        if ( turns > TIMER_WHEEL_MASK )
+        {
+            turns = TIMER_WHEEL_MASK;
+        }
+        level = 1;
+        bucket = (turnStart / TIMER_WHEEL_TURN_TICKS + turns) & TIMER_WHEEL_MASK;
+    }
+
+    wheel_list_append (&g_TimerWheel[level][bucket], timer);
+    g_WheelUsed[level] |= 1U << bucket;
+    g_WheelCount++;
+}
+
+/**
+ * Insert a timer in the wheel.
+ *
+ * @param newTimer pointer on the timer to insert
+ *
+ * WARNING: newTimer MUST NOT be null (rem: static function )
+ *
+ */
+static void add_timer (T_TIMER_LIST_ELT* newTimer)
+{
+#ifdef __DEBUG_OS_ABSTRACTION_TIMER
+    _log ("\nINFO : add_timer: adding 0x%x to expire at %d (now = %d - delay = %d)", (uint32_t) newTimer, newTimer->desc.expiration, _GET_TICK(), newTimer->desc.delay);
+#endif
+
+    if ( 0 == g_WheelCount )
+    {
+        /* no active timer: the wheel position may be stale, catch up */
+        g_WheelTime = _GET_TICK() & ~(TIMER_WHEEL_SLOT_TICKS - 1);
+    }
+
+    wheel_insert (newTimer);
+
+    if ( g_WheelEarliestValid &&
+         (int32_t) (newTimer->desc.expiration - g_WheelEarliest) < 0 )
+    {
+        g_WheelEarliest = newTimer->desc.expiration;
+    }
+
+    newTimer->desc.status = E_TIMER_RUNNING;
+}
+
+/**
+ * Remove a timer from its wheel bucket or from the list of expired timers.
+ *
+ * @param timerToRemove pointer on the timer to remove
+ *
+ * WARNING: timerToRemove MUST NOT be null (rem: static function )
+ *
+ */
+static void remove_timer (T_TIMER_LIST_ELT* timerToRemove)
+{
+    uint32_t bucket;
+
+#ifdef __DEBUG_OS_ABSTRACTION_TIMER
+    _log ("\nINFO : remove_timer: removing 0x%x to expire at %d (now = %d)", (uint32_t) timerToRemove, timerToRemove->desc.expiration, _GET_TICK());
+#endif
+
+    if ( NULL == timerToRemove->list )
+    {
+#ifdef __DEBUG_OS_ABSTRACTION_TIMER
+        _log ("\nERROR : remove_timer : timer is not active ");
+#endif
+        panic (E_OS_ERR);
+    }
+
+    if ( NULL != timerToRemove->next )
+    {
+        timerToRemove->next->prev = timerToRemove->prev ;
+    }
+    else
+    {
+        timerToRemove->list->tail = timerToRemove->prev;
+    }
+    if ( NULL != timerToRemove->prev )
+    {
+        timerToRemove->prev->next = timerToRemove->next ;
+    }
+    else
+    {
+        timerToRemove->list->head = timerToRemove->next;
+    }
+
+    if ( &g_ExpiredTimers != timerToRemove->list )
+    {
+        g_WheelCount--;
+        if ( NULL == timerToRemove->list->head )
+        {
+            bucket = timerToRemove->list - &g_TimerWheel[0][0];
+            g_WheelUsed[bucket / TIMER_WHEEL_SLOTS] &= ~(1U << (bucket & TIMER_WHEEL_MASK));
+        }
+        if ( g_WheelEarliestValid && timerToRemove->desc.expiration == g_WheelEarliest )
+        {
+            /* the next expiration may be later now */
+            g_WheelEarliestValid = false;
+        }
+    }
+
+    /* clean-up links */
+    timerToRemove->list = NULL;
+    timerToRemove->prev = NULL;
+    timerToRemove->next = NULL;
+    timerToRemove->desc.status = E_TIMER_READY;
+}
+
+/**
+ * Move all the timers that expired at tick from the wheel buckets
+ *    to g_ExpiredTimers.
+ *
+ * The buckets of the first level are visited up to the slot of tick or
+ *    to the end of the current turn. When tick is in a later turn, the
+ *    buckets of the second level for the elapsed turns are then emptied:
+ *    their timers are either expired or inserted again in the wheel,
+ *    relative to the new position.
+ *
+ * Must be called with scheduling disabled.
+ *
+ * @param tick current tick
+ */
+static void collect_expired_timers (uint32_t tick)
+{
+    uint32_t first;
+    uint32_t last;
+    uint32_t slot;
+    uint32_t turns;
+    uint32_t turn;
+    T_TIMER_WHEEL_LIST* list;
+    T_TIMER_LIST_ELT* timer;
+    T_TIMER_LIST_ELT* next;
+
+    turns = (tick - (g_WheelTime & ~(TIMER_WHEEL_TURN_TICKS - 1))) / TIMER_WHEEL_TURN_TICKS;
+    first = (g_WheelTime / TIMER_WHEEL_SLOT_TICKS) & TIMER_WHEEL_MASK;
+    last = ( 0 == turns ) ? (tick / TIMER_WHEEL_SLOT_TICKS) & TIMER_WHEEL_MASK : TIMER_WHEEL_MASK;
+
+    for ( slot = first; slot <= last && 0 != g_WheelUsed[0]; slot++ )
+    {
+        timer = g_TimerWheel[0][slot].head;
+        while ( NULL != timer )
+        {
+            next = timer->next;
+            if ( is_after_expiration (tick, &(timer->desc)) )
+            {
+                remove_timer (timer);
+                wheel_expired_insert (timer);
+                timer->desc.status = E_TIMER_RUNNING;
+            }
+            timer = next;
+        }
+    }
+
+    first = g_WheelTime / TIMER_WHEEL_TURN_TICKS;
+    g_WheelTime = tick & ~(TIMER_WHEEL_SLOT_TICKS - 1);
+
+    if ( turns > TIMER_WHEEL_SLOTS )
+    {
+        turns = TIMER_WHEEL_SLOTS;
+    }
+    for ( turn = 1; turn <= turns && 0 != g_WheelUsed[1]; turn++ )
+    {
+        /* detach the bucket, its timers may be inserted in it again */
+        slot = (first + turn) & TIMER_WHEEL_MASK;
+        list = &g_TimerWheel[1][slot];
+        timer = list->head;
+        list->head = NULL;
+        list->tail = NULL;
+        g_WheelUsed[1] &= ~(1U << slot);
+        while ( NULL != timer )
+        {
+            next = timer->next;
+            g_WheelCount--;
+            if ( is_after_expiration (tick, &(timer->desc)) )
+            {
+                wheel_expired_insert (timer);
+            }
+            else
+            {
+                wheel_insert (timer);
+            }
+            timer = next;
+        }
+    }
+
+    g_WheelEarliestValid = false;
+}
+
+/**
+ * Returns whether timer_task shall be signaled to take the
+ *    expiration of a newly added timer into account.
+ *
+ * @param timer pointer on the timer that was added
+ */
+static bool is_next_to_expire (T_TIMER_LIST_ELT* timer)
+{
+    return ( ( false == g_WheelNextValid ) ||
+             ( (int32_t) (timer->desc.expiration - g_WheelNextExpiration) < 0 ) );
+}
+
+/**
+ * Return the index, from bucket first, of the first non empty bucket
+ *    of a level of the wheel.
+ *
+ * @param used bitmap of the non empty buckets of the level, not null
+ * @param first index of the bucket to start from
+ */
+static uint32_t wheel_first_used (uint32_t used, uint32_t first)
+{
+    uint32_t rotated;
+
+    /* rotate the bitmap so that bit 0 is the bucket first */
+    rotated = used >> first;
+    if ( 0 != first )
+    {
+        rotated |= used << (TIMER_WHEEL_SLOTS - first);
+    }
+    return __builtin_ctz (rotated);
+}
+
+/**
+ * Compute the date of the next expiration of the timers of the wheel.
+ *
+ * The first non empty bucket is found with the bitmaps of the used
+ *    buckets, and only this bucket is visited. A bucket of the first level
+ *    only holds timers of its slot, so its earliest timer is the next to
+ *    expire. A bucket of the second level may only hold timers that were
+ *    too far to be hashed on their own turn: the start of its turn is then
+ *    returned, and timer_task wakes up once to move them further.
+ *
+ * Must be called with scheduling disabled, with at least one timer in the wheel.
+ *
+ * @return date of the next expiration, or an earlier date
+ */
+static uint32_t wheel_next_expiration (void)
+{
+    uint32_t level;
+    uint32_t first;
+    uint32_t start;
+    uint32_t end;
+    uint32_t offset;
+    uint32_t expiration;
+    T_TIMER_LIST_ELT* timer;
+
+    if ( 0 != g_WheelUsed[0] )
+    {
+        level = 0;
+        first = (g_WheelTime / TIMER_WHEEL_SLOT_TICKS) & TIMER_WHEEL_MASK;
+        offset = wheel_first_used (g_WheelUsed[0], first);
+        start = g_WheelTime + offset * TIMER_WHEEL_SLOT_TICKS;
+        end = start + TIMER_WHEEL_SLOT_TICKS;
+    }
+    else
+    {
+        level = 1;
+        start = g_WheelTime & ~(TIMER_WHEEL_TURN_TICKS - 1);
+        first = (start / TIMER_WHEEL_TURN_TICKS) & TIMER_WHEEL_MASK;
+        offset = wheel_first_used (g_WheelUsed[1], first);
+        start += offset * TIMER_WHEEL_TURN_TICKS;
+        end = start + TIMER_WHEEL_TURN_TICKS;
+    }
+
+    expiration = end;
+    for ( timer = g_TimerWheel[level][(first + offset) & TIMER_WHEEL_MASK].head; NULL != timer; timer = timer->next )
+    {
+        /* skip the timers that are due on a later turn */
+        if ( (int32_t) (timer->desc.expiration - expiration) < 0 )
+        {
+            expiration = timer->desc.expiration;
+        }
+    }
+    return ( expiration == end ) ? start : expiration;
+}
+
+/**
+ * Find the date of the next timer expiration.
+ *
+ * The date is cached and only computed again after a collection of the
+ *    expired timers or the removal of the next timer to expire.
+ *
+ * @param expiration (out): date of the next expiration
+ *
+ * @return true if at least one timer is active
+ */
+static bool get_next_expiration (uint32_t* expiration)
+{
+    bool found = true;
+
+    disable_scheduling();
+
+    if ( NULL != g_ExpiredTimers.head )
+    {
+        *expiration = g_ExpiredTimers.head->desc.expiration;
+    }
+    else if ( 0 != g_WheelCount )
+    {
+        if ( !g_WheelEarliestValid )
+        {
+            g_WheelEarliest = wheel_next_expiration();
+            g_WheelEarliestValid = true;
+        }
+        *expiration = g_WheelEarliest;
+    }
+    else
+    {
+        found = false;
+    }
+
+    g_WheelNextValid = found;
+    if ( found )
+    {
+        g_WheelNextExpiration = *expiration;
+    }
+
+    enable_scheduling();
+
+    return found;
+}
+
+/**
+ * Return the next timer whose callback shall be executed.
+ *
+ * @param tick current tick
+ *
+ * @return next expired timer, or NULL
+ */
+static T_TIMER_LIST_ELT* get_expired_timer (uint32_t tick)
+{
+    UNUSED(tick);
+    return g_ExpiredTimers.head;
+}
+
+#else
+
 /**
  * Insert a timer in the list of active timer,
  *    according to its expiration date.
@@ -400,6 +873,52 @@ static void remove_timer (T_TIMER_LIST_ELT* timerToRemove)
 
 
 
+/**
+ * Returns whether timer_task shall be signaled to take the
+ *    expiration of a newly added timer into account.
+ *
+ * @param timer pointer on the timer that was added
+ */
+static bool is_next_to_expire (T_TIMER_LIST_ELT* timer)
+{
+    return ( g_CurrentTimerHead == timer );
+}
+
+/**
+ * Find the date of the next timer expiration.
+ *
+ * @param expiration (out): date of the next expiration
+ *
+ * @return true if at least one timer is active
+ */
+static bool get_next_expiration (uint32_t* expiration)
+{
+    if ( NULL != g_CurrentTimerHead )
+    {
+        *expiration = g_CurrentTimerHead->desc.expiration;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Return the next timer whose callback shall be executed.
+ *
+ * @param tick current tick
+ *
+ * @return head timer if it is expired, or NULL
+ */
+static T_TIMER_LIST_ELT* get_expired_timer (uint32_t tick)
+{
+    if ( is_after_expiration (tick, &(g_CurrentTimerHead->desc)) )
+    {
+        return g_CurrentTimerHead;
+    }
+    return NULL;
+}
+
+#endif /* CONFIG_TIMER_WHEEL */
+
 /**
  * Execute the callback of a timer.
  *
@@ -472,7 +991,25 @@ void framework_init_timer(void)
 #endif
 
     /* start with empty list of active timers: */
+#ifdef CONFIG_TIMER_WHEEL
+    for (idx = 0; idx < TIMER_WHEEL_SLOTS; idx++)
+    {
+        g_TimerWheel[0][idx].head = NULL;
+        g_TimerWheel[0][idx].tail = NULL;
+        g_TimerWheel[1][idx].head = NULL;
+        g_TimerWheel[1][idx].tail = NULL;
+    }
+    g_ExpiredTimers.head = NULL;
+    g_ExpiredTimers.tail = NULL;
+    g_WheelUsed[0] = 0;
+    g_WheelUsed[1] = 0;
+    g_WheelTime = 0;
+    g_WheelCount = 0;
+    g_WheelNextValid = false;
+    g_WheelEarliestValid = false;
+#else
     g_CurrentTimerHead = NULL;
+#endif
 
     /* memset ( g_TimerPool_elements, 0 ):  */
     for (idx = 0; idx < TIMER_POOL_SIZE; idx++)
@@ -484,6 +1021,9 @@ void framework_init_timer(void)
         g_TimerPool_elements[idx].desc.repeat = false;
         g_TimerPool_elements[idx].prev = NULL;
         g_TimerPool_elements[idx].next = NULL;
+#ifdef CONFIG_TIMER_WHEEL
+        g_TimerPool_elements[idx].list = NULL;
+#endif
         /* hopefully, the init function is performed before
          *  timer_create and timer_stop can be called,
          *  hence there is no need for a critical section
@@ -581,7 +1121,7 @@ T_TIMER timer_create(T_ENTRY_POINT callback, void* privData, uint32_t delay, boo
                     timer->desc.expiration = _GET_TICK() + timer->desc.delay;
                     disable_scheduling();
                     add_timer(timer);
-                    if ( g_CurrentTimerHead == timer )
+                    if ( is_next_to_expire(timer) )
                     {
                         /* new timer is the next to expire, unblock timer_task to assess the change */
                         signal_timer_task();
@@ -646,7 +1186,7 @@ void timer_start(T_TIMER tmr, uint32_t delay, OS_ERR_TYPE* err)
                 add_timer(timer);
 
                 /* new timer is the next to expire, unblock timer_task to assess the change */
-                if (g_CurrentTimerHead == timer) {
+                if (is_next_to_expire(timer)) {
                      signal_timer_task();
                 }
                 enable_scheduling();
@@ -698,10 +1238,14 @@ void timer_stop(T_TIMER tmr, OS_ERR_TYPE* err)
             /* remove the timer */
             disable_scheduling();
 
+            /* with the timer wheel, timer_task wakes up at the former
+             * expiration and only finds nothing to do */
+#ifndef CONFIG_TIMER_WHEEL
             if ( g_CurrentTimerHead == timer )
             {
                 doSignal = true ;
             }
+#endif
 
             remove_timer(timer);
 
@@ -787,6 +1331,8 @@ void timer_task(int dummy1, int dummy2)
 {
     uint32_t timeout;
     uint32_t now;
+    uint32_t expiration;
+    T_TIMER_LIST_ELT* expiredTimer;
 
     UNUSED(dummy1);
     UNUSED(dummy2);
@@ -799,7 +1345,7 @@ void timer_task(int dummy1, int dummy2)
         /* block until g_TimerSem is signaled or until the next timeout expires */
         (void) task_sem_take_wait_timeout(g_TimerSem, timeout);
 #else
-        if (NULL == g_CurrentTimerHead)
+        if (false == get_next_expiration(&expiration))
         {
             /* Start a background timer with max positive delay */
             nano_fiber_timer_start (&g_NanoTimer, 0x7FFFFFFF);
@@ -808,23 +1354,30 @@ void timer_task(int dummy1, int dummy2)
         }
 #endif
         now = _GET_TICK();
+#ifdef CONFIG_TIMER_WHEEL
+        /* move all the expired timers out of the wheel in one pass */
+        disable_scheduling();
+        g_WheelNextValid = false;
+        collect_expired_timers(now);
+        enable_scheduling();
+#endif
         /* task is unblocked: check for expired timers */
-        while (is_after_expiration (now, &(g_CurrentTimerHead->desc)))
+        while (NULL != (expiredTimer = get_expired_timer(now)))
         {
-            execute_callback(g_CurrentTimerHead);
+            execute_callback(expiredTimer);
         }
         /* Compute timeout until the expiration of the next timer */
-        if ( NULL != g_CurrentTimerHead )
+        if ( get_next_expiration(&expiration) )
         {
             now = _GET_TICK();
             /* In micro kernel context, timeout = 0 or timeout < 0 works.
              * In nano kernel context timeout must be a positive value.
             */
 #ifdef CONFIG_NANOKERNEL
-            if (g_CurrentTimerHead->desc.expiration > now)
+            if (expiration > now)
             {
 #endif
-                timeout = g_CurrentTimerHead->desc.expiration - now;
+                timeout = expiration - now;
                 if (OS_WAIT_FOREVER == timeout)
                 { /* cannot have timeout = OS_WAIT_FOREVER while there is
                     still at least one active timer */
@@ -848,8 +1401,8 @@ void timer_task(int dummy1, int dummy2)
 #endif
 
 #ifdef __DEBUG_OS_ABSTRACTION_TIMER
-        if (NULL != g_CurrentTimerHead )
-            _log ("\nINFO : timer_task : now = %u, next timer expires at %u, timeout = %u", _GET_TICK() , g_CurrentTimerHead->desc.expiration, timeout );
+        if ( get_next_expiration(&expiration) )
+            _log ("\nINFO : timer_task : now = %u, next timer expires at %u, timeout = %u", _GET_TICK() , expiration, timeout );
         else
             _log ("\nINFO : timer_task : now = %u, no next timer, timeout = OS_WAIT_FOREVER", _GET_TICK() );
 #endif
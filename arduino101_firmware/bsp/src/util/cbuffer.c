@@ -123,6 +123,50 @@ int32_t cb_pop(cbuffer_t *src, const uint32_t offset, uint8_t *dst, const uint8_
 }
 
 
+int32_t cb_push_record(cbuffer_t *dst, const uint8_t *src, const uint8_t length)
+{
+    int32_t ret = 0;
+
+    /* one byte is always left free to tell a full buffer from an empty one */
+    if ( (length + 1 > CONFIG_LOG_CBUFFER_SIZE - 1) || (length <= 0) ) {
+        return -1;
+    }
+
+    /* drop the oldest records until the new one fits */
+    while ( ((dst->r - dst->w - 1) & (CONFIG_LOG_CBUFFER_SIZE - 1)) < (uint32_t)length + 1 ) {
+        dst->r = (dst->r + 1 + dst->buf[dst->r]) & (CONFIG_LOG_CBUFFER_SIZE - 1);
+        dst->dropped++;
+        dst->saturation_flag = 1;
+        ret = 1;
+    }
+
+    dst->buf[dst->w] = length;
+    cb_write(dst, (dst->w + 1) & (CONFIG_LOG_CBUFFER_SIZE - 1), src, length);
+    dst->w = (dst->w + 1 + length) & (CONFIG_LOG_CBUFFER_SIZE - 1);
+
+    return ret;
+}
+
+
+int32_t cb_pop_record(cbuffer_t *src, uint8_t *dst, const uint32_t max_length)
+{
+    uint8_t length;
+
+    if (src->r == src->w) {
+        return 0;
+    }
+
+    length = src->buf[src->r];
+    if (length <= max_length) {
+        cb_read(src, (src->r + 1) & (CONFIG_LOG_CBUFFER_SIZE - 1), dst, length);
+    }
+    src->r = (src->r + 1 + length) & (CONFIG_LOG_CBUFFER_SIZE - 1);
+    src->saturation_flag = 0;
+
+    return (length <= max_length) ? length : -1;
+}
+
+
 /**
  * Read from a cbuffer, starting from an offset. Pointers are not changed.
  *
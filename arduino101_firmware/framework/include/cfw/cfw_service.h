@@ -71,6 +71,8 @@ typedef struct cfw_conn_ {
 	void * priv_data;
 	/** Pointer to store the client-side specific handle. */
 	void * client_handle;
+	/** Events registered by the client, managed by the service manager. */
+	list_head_t registered_events;
 } conn_handle_t;
 
 /**
@@ -63,6 +63,14 @@
 #define MSG_ID_GPIO_LISTEN_REQ      (MSG_ID_GPIO_BASE + 3)
 /** service internal message ID for @ref gpio_unlisten */
 #define MSG_ID_GPIO_UNLISTEN_REQ    (MSG_ID_GPIO_BASE + 4)
+/** service internal message ID for @ref gpio_listen_port_req_msg */
+#define MSG_ID_GPIO_LISTEN_PORT_REQ (MSG_ID_GPIO_BASE + 5)
+/** service internal message ID for @ref gpio_configure_port_req_msg */
+#define MSG_ID_GPIO_CONFIGURE_PORT_REQ (MSG_ID_GPIO_BASE + 6)
+/** service internal message ID for @ref gpio_set_port_req_msg */
+#define MSG_ID_GPIO_SET_PORT_REQ    (MSG_ID_GPIO_BASE + 7)
+/** service internal message ID for @ref gpio_program_req_msg */
+#define MSG_ID_GPIO_PROGRAM_REQ     (MSG_ID_GPIO_BASE + 8)
 
 /** message ID of service response for @ref gpio_configure */
 #define MSG_ID_GPIO_CONFIGURE_RSP   (MSG_ID_GPIO_CONFIGURE_REQ | 0x40)
@@ -74,8 +82,18 @@
 #define MSG_ID_GPIO_LISTEN_RSP      (MSG_ID_GPIO_LISTEN_REQ | 0x40)
 /** message ID of service response for @ref gpio_unlisten */
 #define MSG_ID_GPIO_UNLISTEN_RSP    (MSG_ID_GPIO_UNLISTEN_REQ | 0x40)
+/** message ID of service response for @ref gpio_listen_port_req_msg */
+#define MSG_ID_GPIO_LISTEN_PORT_RSP (MSG_ID_GPIO_LISTEN_PORT_REQ | 0x40)
+/** message ID of service response for @ref gpio_configure_port_req_msg */
+#define MSG_ID_GPIO_CONFIGURE_PORT_RSP (MSG_ID_GPIO_CONFIGURE_PORT_REQ | 0x40)
+/** message ID of service response for @ref gpio_set_port_req_msg */
+#define MSG_ID_GPIO_SET_PORT_RSP    (MSG_ID_GPIO_SET_PORT_REQ | 0x40)
+/** message ID of service response for @ref gpio_program_req_msg */
+#define MSG_ID_GPIO_PROGRAM_RSP     (MSG_ID_GPIO_PROGRAM_REQ | 0x40)
 /** message ID of service response for GPIO events */
 #define MSG_ID_GPIO_EVT             (MSG_ID_GPIO_BASE | 0x80)
+/** message ID of the coalesced GPIO events of @ref gpio_listen_port_req_msg */
+#define MSG_ID_GPIO_PORT_EVT        (MSG_ID_GPIO_BASE | 0x81)
 
 /** GPIO interrupt types */
 typedef enum {
@@ -135,6 +153,36 @@ typedef struct gpio_listen_evt_msg {
     bool pin_state; /*!< current gpio state */
 } gpio_listen_evt_msg_t;
 
+/**
+ * Request message structure to monitor several GPIO pins.
+ *
+ * The interrupts of the pins are reported by @ref gpio_port_evt_msg events,
+ * one per batch of interrupts processed by the service. Only the SOC and AON
+ * GPIO services support it. The pins are released with @ref gpio_unlisten.
+ */
+typedef struct gpio_listen_port_req_msg {
+    struct cfw_message header;
+    uint32_t mask;                         /*!< mask of the GPIO pins to monitor */
+    gpio_service_isr_mode_t mode;          /*!< interrupt mode */
+    gpio_service_debounce_mode_t debounce; /*!< debounce mode */
+} gpio_listen_port_req_msg_t;
+
+/** Response message structure for @ref gpio_listen_port_req_msg */
+typedef struct gpio_listen_port_rsp_msg {
+    struct cfw_rsp_message rsp_header;
+    uint32_t mask;  /*!< mask of the GPIO pins to monitor */
+} gpio_listen_port_rsp_msg_t;
+
+/** Event message structure for @ref gpio_listen_port_req_msg */
+typedef struct gpio_port_evt_msg {
+    struct cfw_message header;
+    uint32_t changed;   /*!< mask of the monitored pins which triggered an interrupt */
+    uint32_t state;     /*!< state of the gpio port at the last interrupt of each pin */
+    uint32_t timestamp; /*!< time of the last interrupt (32 kHz ticks) */
+    uint32_t lost_irq;  /*!< interrupts dropped by the service since its start */
+    uint32_t lost_evt;  /*!< events dropped by the service since its start */
+} gpio_port_evt_msg_t;
+
 /** Request message structure for @ref gpio_unlisten */
 typedef struct gpio_unlisten_req_msg {
     struct cfw_message header;
@@ -147,12 +195,103 @@ typedef struct gpio_unlisten_rsp_msg {
     uint8_t index; /*!< index of GPIO to stop monitoring */
 } gpio_unlisten_rsp_msg_t;
 
+/**
+ * Request message structure to configure several GPIO pins.
+ *
+ * The pins are configured one by one, the first failure stops the request.
+ */
+typedef struct gpio_configure_port_req_msg {
+    struct cfw_message header;
+    uint32_t mask;  /*!< mask of the GPIO pins to configure */
+    uint8_t mode;   /*!< mode of the pins: 0 - input; 1 - output */
+} gpio_configure_port_req_msg_t;
+
+/** Response message structure for @ref gpio_configure_port_req_msg */
+typedef struct gpio_configure_port_rsp_msg {
+    struct cfw_rsp_message rsp_header;
+    uint32_t mask;  /*!< mask of the GPIO pins configured */
+} gpio_configure_port_rsp_msg_t;
+
+/** Operations on the outputs of a GPIO port */
+typedef enum {
+    GPIO_PORT_WRITE,  /*!< write value to the masked pins */
+    GPIO_PORT_SET,    /*!< set the masked pins to high level */
+    GPIO_PORT_CLEAR,  /*!< set the masked pins to low level */
+    GPIO_PORT_TOGGLE  /*!< invert the masked pins, SOC and AON GPIO only */
+} gpio_port_op_t;
+
+/**
+ * Request message structure to update several GPIO outputs at once.
+ *
+ * The pins outside of mask keep their state.
+ */
+typedef struct gpio_set_port_req_msg {
+    struct cfw_message header;
+    uint32_t mask;  /*!< mask of the GPIO pins to update */
+    uint32_t value; /*!< state of the pins for GPIO_PORT_WRITE */
+    uint8_t op;     /*!< operation, see @ref gpio_port_op_t */
+} gpio_set_port_req_msg_t;
+
+/** Response message structure for @ref gpio_set_port_req_msg */
+typedef struct gpio_set_port_rsp_msg {
+    struct cfw_rsp_message rsp_header;
+    uint32_t state; /*!< state of the gpio port after the update */
+} gpio_set_port_rsp_msg_t;
+
+/** Maximum number of steps of a @ref gpio_program_req_msg */
+#define GPIO_PROGRAM_MAX_STEPS      16
+
+/** Step of a @ref gpio_program_req_msg */
+typedef struct gpio_program_step {
+    uint8_t op;     /*!< GPIO_PORT_WRITE/SET/CLEAR/TOGGLE, or GPIO_STEP_READ */
+    uint8_t delay;  /*!< delay before the step (32 kHz ticks) */
+    uint32_t mask;  /*!< mask of the GPIO pins of the step */
+    uint32_t value; /*!< state of the pins for GPIO_PORT_WRITE */
+} gpio_program_step_t;
+
+/** Program step reading the masked pins into @ref gpio_program_rsp_msg */
+#define GPIO_STEP_READ              0x80
+
+/**
+ * Request message structure to run a sequence of GPIO operations.
+ *
+ * The steps are executed in order in a single service call, so that a client
+ * can drive a parallel bus without a message round trip per pin change.
+ * The delays are busy waited by the service, they should be kept short.
+ * Only the SOC and AON GPIO services support it.
+ *
+ * The message is allocated with room for count steps.
+ */
+typedef struct gpio_program_req_msg {
+    struct cfw_message header;
+    uint8_t count;                 /*!< number of steps, up to GPIO_PROGRAM_MAX_STEPS */
+    gpio_program_step_t steps[];   /*!< steps to execute */
+} gpio_program_req_msg_t;
+
+/**
+ * Response message structure for @ref gpio_program_req_msg
+ *
+ * The message is allocated with room for the result of each GPIO_STEP_READ
+ * step of the request.
+ */
+typedef struct gpio_program_rsp_msg {
+    struct cfw_rsp_message rsp_header;
+    uint8_t done;     /*!< number of steps executed */
+    uint8_t count;    /*!< number of read results */
+    uint32_t state[]; /*!< masked port state read by each GPIO_STEP_READ step */
+} gpio_program_rsp_msg_t;
+
 /** Request message structure for @ref gpio_get_state */
 typedef struct gpio_get_req_msg {
     struct cfw_message header;
 } gpio_get_req_msg_t;
 
-/** Response message structure @ref gpio_get_state */
+/**
+ * Response message structure @ref gpio_get_state
+ *
+ * It reads the whole port, whose state is also returned by
+ * @ref gpio_set_port_rsp_msg.
+ */
 typedef struct gpio_get_rsp_msg {
     struct cfw_rsp_message rsp_header;
     uint32_t state; /*!< state of the gpio port */
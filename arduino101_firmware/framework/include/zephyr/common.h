@@ -60,46 +60,63 @@
 #define INT_SIZE (sizeof(unsigned int) * 8)
 
 
+/* Allocation tracker bit of block i, blocks are tracked MSB first */
+#define BLK_ALLOC_BIT(i) (1u << (INT_SIZE - 1 - ((i)%INT_SIZE)))
+
+/*
+ * Pool of count blocks of type. Free blocks are found a tracker word at a
+ * time with __builtin_clz, starting from the lowest word that may have a
+ * free block (var##_alloc_hint), so that allocating a block that was just
+ * freed does not scan the pool.
+ */
 #define DECLARE_BLK_ALLOC(var, type, count) \
 type var##_elements[count]; \
 unsigned int var##_track_alloc[count/INT_SIZE+1] = { 0 }; \
 unsigned int var##_alloc_max = 0; \
 unsigned int var##_alloc_cur = 0; \
+unsigned int var##_alloc_hint = 0; \
 type * var##_alloc(void) { \
-    int i; \
+    unsigned int wi, i; \
     INT_FLAGS flags = DISABLE_INT(); \
-    for ( i = 0; i < count; i++) { \
-        int wi = i/INT_SIZE; \
-        int bi = INT_SIZE - 1 - (i%INT_SIZE); \
-        if ((var##_track_alloc[wi] & 1 << bi) == 0) { \
-            var##_track_alloc[wi] |= 1 << (bi); \
-            var##_alloc_cur++; \
-            if (var##_alloc_cur > var##_alloc_max) var##_alloc_max = var##_alloc_cur;\
-            RESTORE_INT(flags); \
-            return &var##_elements[i]; \
+    for (wi = var##_alloc_hint; wi < count/INT_SIZE+1; wi++) { \
+        if (~var##_track_alloc[wi] == 0) { \
+            continue; \
         } \
+        i = wi * INT_SIZE + __builtin_clz(~var##_track_alloc[wi]); \
+        if (i >= count) { \
+            break; \
+        } \
+        var##_track_alloc[wi] |= BLK_ALLOC_BIT(i); \
+        var##_alloc_hint = wi; \
+        var##_alloc_cur++; \
+        if (var##_alloc_cur > var##_alloc_max) var##_alloc_max = var##_alloc_cur;\
+        RESTORE_INT(flags); \
+        return &var##_elements[i]; \
     }\
+    var##_alloc_hint = wi; \
     RESTORE_INT(flags); \
     return NULL; \
 } \
 void var##_free(type * ptr) { \
    int index =  ptr - var##_elements; \
    INT_FLAGS flags; \
-   if (index < count) { \
+   if ( (index >= 0) && (index < count) ) { \
        flags = DISABLE_INT(); \
-       if ((var##_track_alloc[index/INT_SIZE] & 1 << (INT_SIZE - 1 -(index%INT_SIZE))) == 0) { \
+       if ((var##_track_alloc[index/INT_SIZE] & BLK_ALLOC_BIT(index)) == 0) { \
+           RESTORE_INT(flags); \
            _log("Already free"); \
            return; \
        } \
-       var##_track_alloc[index/INT_SIZE] &= ~(1 << (INT_SIZE-1-(index%INT_SIZE))); \
-       RESTORE_INT(flags); \
+       var##_track_alloc[index/INT_SIZE] &= ~BLK_ALLOC_BIT(index); \
+       if (index/INT_SIZE < var##_alloc_hint) var##_alloc_hint = index/INT_SIZE; \
        var##_alloc_cur--; \
+       RESTORE_INT(flags); \
    } \
 } \
 bool var##_used(type * ptr) { \
    int index =  ptr - var##_elements; \
    if ( (index >= 0) && (index<count) ) { \
-       if ((var##_track_alloc[index/INT_SIZE] & (1 << (INT_SIZE - 1 -(index%INT_SIZE)))) != 0) { \
+       if ((var##_track_alloc[index/INT_SIZE] & BLK_ALLOC_BIT(index)) != 0) { \
            return true; \
        } \
    } \
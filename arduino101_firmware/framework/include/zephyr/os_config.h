@@ -44,11 +44,13 @@
 
 #ifndef CONFIG_ARC_OS_UNIT_TESTS
 #define QUEUE_ELEMENT_POOL_SIZE     (100)   /** Total number of element shared by the queues */
+#define QUEUE_RING_POOL_SIZE        (128)   /** Total number of ring slots shared by the queues -- CONFIG_QUEUE_RING only */
 /*------------ Settings for the TIMERS */
 #define TIMER_POOL_SIZE              20   /* Total number of timers provided by the abstraction layer */
 
 #else
 #define QUEUE_ELEMENT_POOL_SIZE     (30)   /** Total number of element shared by the queues */
+#define QUEUE_RING_POOL_SIZE        (32)   /** Total number of ring slots shared by the queues -- CONFIG_QUEUE_RING only */
 /*------------ Settings for the TIMERS */
 #define TIMER_POOL_SIZE              8   /* Total number of timers provided by the abstraction layer */
 #endif
@@ -56,6 +58,8 @@
 #define TIMER_CBK_TASK_STACK_SIZE   600   /* Size in bytes of the stack for the Timer callback task -- NOT USED BY ZEPHYR MICROKERNEL */
 #define TIMER_CBK_TASK_PRIORITY      10   /* Priority of the Timer callback task  -- NOT USED BY ZEPHYR MICROKERNEL */
 #define TIMER_CBK_TASK_OPTIONS        0   /* Fiber options for the Timer callback task - 0 -> floating point is not supported  -- NOT USED BY ZEPHYR MICROKERNEL */
+#define TIMER_WHEEL_SLOTS            16   /* Number of buckets of each level of the timer wheel, must be a power of two -- CONFIG_TIMER_WHEEL only */
+#define TIMER_WHEEL_SLOT_SHIFT        4   /* log2 of the number of ticks covered by a bucket of the first level of the timer wheel, a bucket of the second level covers TIMER_WHEEL_SLOTS times more -- CONFIG_TIMER_WHEEL only */
 
 /*------------ Settings for the INTERRUPTS */
 
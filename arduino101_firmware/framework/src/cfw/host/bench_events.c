@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares the delivery of an event to 1 to 16 clients of the local cpu by
+ * the two builds of cfw_send_event(): a copy per client, and a shared copy
+ * with CONFIG_CFW_SHARED_EVENTS. Each event is dispatched to the clients and
+ * released before the next one is sent. Reports, per event:
+ *  - the time to send, dispatch and release it, best of RUNS runs,
+ *  - the number of blocks allocated and the bytes requested from the pools.
+ * Then profiles the ports during the delivery of shared events to all the
+ * clients, from the port statistics of port.c.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cfw_host.h"
+#include "cfw/cfw.h"
+#include "cfw/cfw_service.h"
+#include "infra/port.h"
+
+#define MAX_CLIENTS 16
+#define EVENTS      20000
+#define RUNS        3
+#define EVT_ID      0x1234
+
+/* The build of service_manager.c without CONFIG_CFW_SHARED_EVENTS */
+extern void cfw_send_event_copy(struct cfw_message *msg);
+extern void _cfw_register_event_copy(conn_handle_t *h, int msg_id);
+extern void _cfw_unregister_event_copy(conn_handle_t *h);
+
+static const struct {
+    const char *name;
+    void (*send_event)(struct cfw_message *msg);
+    void (*register_event)(conn_handle_t *h, int msg_id);
+    void (*unregister_event)(conn_handle_t *h);
+} variants[] = {
+    { "copy", cfw_send_event_copy, _cfw_register_event_copy,
+      _cfw_unregister_event_copy },
+    { "shared", cfw_send_event, _cfw_register_event, _cfw_unregister_event },
+};
+
+#define NB_VARIANTS (sizeof(variants) / sizeof(variants[0]))
+
+/* Event sizes, both served from the 64 bytes pool in the host build */
+static const uint16_t sizes[] = {
+    sizeof(struct cfw_message) + 8, sizeof(struct cfw_message) + 24,
+};
+
+static conn_handle_t conns[MAX_CLIENTS];
+static T_QUEUE queue;
+static uint16_t svc_port;
+static unsigned int received;
+
+static void client_handler(struct cfw_message *msg, void *param)
+{
+    received++;
+    cfw_msg_free(msg);
+}
+
+static void deliver(void)
+{
+    T_QUEUE_MESSAGE m;
+    OS_ERR_TYPE err;
+
+    for (;;) {
+        queue_get_message(queue, &m, OS_NO_WAIT, &err);
+        if (err != E_OS_OK) {
+            break;
+        }
+        port_process_message(m);
+    }
+}
+
+struct result {
+    double ns;
+    double allocs;
+    double bytes;
+};
+
+static void run(unsigned int v, uint16_t size, int n, struct result *r)
+{
+    struct cfw_message *evt;
+    unsigned int allocs = 0;
+    uint64_t bytes = 0, start, elapsed = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        variants[v].register_event(&conns[i], EVT_ID);
+    }
+    received = 0;
+    for (i = 0; i < EVENTS; i++) {
+        evt = (struct cfw_message *)message_alloc(size, NULL);
+        CFW_MESSAGE_ID(evt) = EVT_ID;
+        CFW_MESSAGE_LEN(evt) = size;
+        CFW_MESSAGE_SRC(evt) = svc_port;
+        CFW_MESSAGE_TYPE(evt) = TYPE_EVT;
+        host_allocs = 0;
+        host_alloc_bytes = 0;
+        start = now_ns();
+        variants[v].send_event(evt);
+        cfw_msg_free(evt);
+        deliver();
+        elapsed += now_ns() - start;
+        allocs += host_allocs;
+        bytes += host_alloc_bytes;
+    }
+    for (i = 0; i < n; i++) {
+        variants[v].unregister_event(&conns[i]);
+    }
+    if (received != (unsigned int)n * EVENTS) {
+        printf("%s: %u events received out of %u\n", variants[v].name,
+               received, n * EVENTS);
+    }
+    r->ns = (double)elapsed / EVENTS;
+    r->allocs = (double)allocs / EVENTS;
+    r->bytes = (double)bytes / EVENTS;
+}
+
+static void profile(void)
+{
+    uint8_t snap[sizeof(uint16_t) +
+                 (MAX_CLIENTS + 1) * (sizeof(uint16_t) + sizeof(struct port_stats))];
+    uint8_t *p = snap + sizeof(uint16_t);
+    struct port_stats st;
+    struct result r;
+    uint16_t count, id;
+
+    port_stats_reset();
+    run(NB_VARIANTS - 1, sizes[0], MAX_CLIENTS, &r);
+    if (port_stats_snapshot(snap, sizeof(snap)) < 0) {
+        printf("port statistics snapshot failed\n");
+        return;
+    }
+    memcpy(&count, snap, sizeof(count));
+    printf("shared events of %u bytes to %d clients, per port:\n", sizes[0],
+           MAX_CLIENTS);
+    printf("port      tx      rx  drop  max depth   timed  latency avg/max us  handler max us\n");
+    while (count--) {
+        memcpy(&id, p, sizeof(id));
+        memcpy(&st, p + sizeof(id), sizeof(st));
+        p += sizeof(id) + sizeof(st);
+        printf("%4u  %6u  %6u  %4u  %9u  %6u  %11.1f/%-6u  %14u\n", id,
+               st.sent, st.received, st.dropped, st.max_depth, st.latency_count,
+               st.latency_count ? (double)st.latency_total / st.latency_count : 0,
+               st.latency_max, st.handler_max);
+    }
+}
+
+int main(void)
+{
+    struct result r[NB_VARIANTS], best[NB_VARIANTS];
+    unsigned int s, v;
+    int i, n, k;
+
+    cfw_host_pool_init();
+    queue = queue_create(2 * MAX_CLIENTS, NULL);
+    svc_port = port_alloc(queue);
+    for (i = 0; i < MAX_CLIENTS; i++) {
+        list_init(&conns[i].registered_events);
+        conns[i].client_port = port_alloc(queue);
+        port_set_handler(conns[i].client_port,
+                         (void (*)(struct message *, void *))client_handler, NULL);
+    }
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        printf("event of %u bytes    ns/event         blocks/event   bytes/event\n",
+               sizes[s]);
+        printf("clients           copy  shared      copy  shared   copy  shared\n");
+        for (n = 1; n <= MAX_CLIENTS; n++) {
+            for (k = 0; k < RUNS; k++) {
+                for (v = 0; v < NB_VARIANTS; v++) {
+                    run(v, sizes[s], n, &r[v]);
+                    if (k == 0 || r[v].ns < best[v].ns) {
+                        best[v] = r[v];
+                    }
+                }
+            }
+            printf("%7d       %6.0f  %6.0f    %6.1f  %6.1f  %5.0f  %6.0f\n", n,
+                   best[0].ns, best[1].ns, best[0].allocs, best[1].allocs,
+                   best[0].bytes, best[1].bytes);
+        }
+        printf("\n");
+    }
+    profile();
+    return 0;
+}
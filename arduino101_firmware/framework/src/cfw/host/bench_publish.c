@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Publish latency of cfw_send_event() as the number of distinct event ids
+ * registered grows, with the event index hashed on the message id, and in
+ * a single list (-DEVT_HASH_SIZE=1) as before the index was hashed.
+ * A client is registered to each id, spread over several services. Reports
+ * the time per event:
+ *  - published to its client, round robin over the ids, dispatched and
+ *    released,
+ *  - published for an id no client registered to.
+ */
+
+#include <stdio.h>
+#include "cfw_host.h"
+#include "cfw/cfw.h"
+#include "cfw/cfw_service.h"
+#include "infra/port.h"
+
+#define MAX_IDS     1024
+#define EVENTS      100000
+#define RUNS        3
+
+/* The build of service_manager.c with a single list of events */
+extern void cfw_send_event_linear(struct cfw_message *msg);
+extern void _cfw_register_event_linear(conn_handle_t *h, int msg_id);
+extern void _cfw_unregister_event_linear(conn_handle_t *h);
+
+static const struct {
+    const char *name;
+    void (*send_event)(struct cfw_message *msg);
+    void (*register_event)(conn_handle_t *h, int msg_id);
+    void (*unregister_event)(conn_handle_t *h);
+} variants[] = {
+    { "hashed", cfw_send_event, _cfw_register_event, _cfw_unregister_event },
+    { "linear", cfw_send_event_linear, _cfw_register_event_linear,
+      _cfw_unregister_event_linear },
+};
+
+#define NB_VARIANTS (sizeof(variants) / sizeof(variants[0]))
+
+static const int nb_ids[] = { 1, 4, 16, 64, 256, 1024 };
+
+static conn_handle_t conn;
+static T_QUEUE queue;
+static uint16_t svc_port;
+
+/* Event ids of 32 services, 0x80 onwards in each */
+static int event_id(int i)
+{
+    return ((i % 32) << 10) | (0x80 + i / 32);
+}
+
+static void client_handler(struct cfw_message *msg, void *param)
+{
+    cfw_msg_free(msg);
+}
+
+static void deliver(void)
+{
+    T_QUEUE_MESSAGE m;
+    OS_ERR_TYPE err;
+
+    for (;;) {
+        queue_get_message(queue, &m, OS_NO_WAIT, &err);
+        if (err != E_OS_OK) {
+            break;
+        }
+        port_process_message(m);
+    }
+}
+
+/* Publish EVENTS events to ids first to first + n - 1, return ns per event */
+static double publish(unsigned int v, int first, int n)
+{
+    struct cfw_message *evt;
+    uint64_t start, elapsed = 0;
+    int i;
+
+    for (i = 0; i < EVENTS; i++) {
+        evt = (struct cfw_message *)message_alloc(sizeof(*evt), NULL);
+        CFW_MESSAGE_ID(evt) = event_id(first + i % n);
+        CFW_MESSAGE_LEN(evt) = sizeof(*evt);
+        CFW_MESSAGE_SRC(evt) = svc_port;
+        CFW_MESSAGE_TYPE(evt) = TYPE_EVT;
+        start = now_ns();
+        variants[v].send_event(evt);
+        cfw_msg_free(evt);
+        deliver();
+        elapsed += now_ns() - start;
+    }
+    return (double)elapsed / EVENTS;
+}
+
+int main(void)
+{
+    double hit[NB_VARIANTS], miss[NB_VARIANTS], ns;
+    unsigned int s, v;
+    int i, k;
+
+    queue = queue_create(4, NULL);
+    svc_port = port_alloc(queue);
+    list_init(&conn.registered_events);
+    conn.client_port = port_alloc(queue);
+    port_set_handler(conn.client_port,
+                     (void (*)(struct message *, void *))client_handler, NULL);
+
+    printf("event ids   published ns/event   unregistered ns/event\n");
+    printf("             hashed   linear        hashed   linear\n");
+    for (s = 0; s < sizeof(nb_ids) / sizeof(nb_ids[0]); s++) {
+        for (v = 0; v < NB_VARIANTS; v++) {
+            for (i = 0; i < nb_ids[s]; i++) {
+                variants[v].register_event(&conn, event_id(i));
+            }
+            for (k = 0; k < RUNS; k++) {
+                ns = publish(v, 0, nb_ids[s]);
+                if (k == 0 || ns < hit[v]) {
+                    hit[v] = ns;
+                }
+                ns = publish(v, MAX_IDS, 1);
+                if (k == 0 || ns < miss[v]) {
+                    miss[v] = ns;
+                }
+            }
+            variants[v].unregister_event(&conn);
+        }
+        printf("%9d   %8.0f %8.0f      %8.0f %8.0f\n", nb_ids[s], hit[0],
+               hit[1], miss[0], miss[1]);
+    }
+    return 0;
+}
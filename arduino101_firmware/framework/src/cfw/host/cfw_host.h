@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of the service manager, on the port layer and the LINUX OS
+ * abstraction layer.
+ *
+ * With cfw_host_pool.o, blocks come from the pools of the arduino101 Quark
+ * image: balloc() counts them and can be made to fail, to exercise the
+ * paths taken when the pools are exhausted.
+ */
+
+#ifndef __CFW_HOST_H__
+#define __CFW_HOST_H__
+
+#include <stdint.h>
+#include "os/os.h"
+
+/* cfw_host_pool.o */
+
+/** Number of allocations so far */
+extern unsigned int host_allocs;
+
+/** Number of blocks allocated and not released */
+extern int host_blocks;
+
+/** Bytes requested by the allocations so far */
+extern uint64_t host_alloc_bytes;
+
+/** Allocations host_fail_first to host_fail_first + host_fail_count - 1 fail */
+extern unsigned int host_fail_first;
+extern unsigned int host_fail_count;
+
+/**
+ * Initialize the pools of cfw_host_pool.o.
+ */
+void cfw_host_pool_init(void);
+
+/* cfw_host.o */
+
+/** Number of warnings logged by the framework */
+extern unsigned int host_warnings;
+
+/**
+ * Return the monotonic time in ns.
+ */
+uint64_t now_ns(void);
+
+#endif /* __CFW_HOST_H__ */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Blocks allocated from the pools of the arduino101 Quark image by the
+ * constant-time build of balloc.c, counted, and failed on request.
+ */
+
+#include "common.h" /* LINUX OS abstraction layer */
+#include "cfw_host.h"
+
+/* balloc.c built with CONFIG_BALLOC_FAST, its API suffixed with _pool */
+extern void *balloc_pool(uint32_t size, OS_ERR_TYPE *err);
+extern OS_ERR_TYPE bfree_pool(void *buffer);
+extern void os_abstraction_init_malloc_pool(void);
+
+unsigned int host_allocs;
+int host_blocks;
+uint64_t host_alloc_bytes;
+unsigned int host_fail_first = -1U;
+unsigned int host_fail_count;
+
+void cfw_host_pool_init(void)
+{
+    os_abstraction_init_malloc_pool();
+}
+
+void *balloc(uint32_t size, OS_ERR_TYPE *err)
+{
+    unsigned int n = host_allocs++;
+    void *buffer;
+
+    if (n >= host_fail_first && n - host_fail_first < host_fail_count) {
+        error_management(err, E_OS_ERR_NO_MEMORY);
+        return NULL;
+    }
+    buffer = balloc_pool(size, err);
+    if (buffer != NULL) {
+        host_blocks++;
+        host_alloc_bytes += size;
+    }
+    return buffer;
+}
+
+OS_ERR_TYPE bfree(void *buffer)
+{
+    host_blocks--;
+    return bfree_pool(buffer);
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the delivery of the events of cfw_send_event() to 1 to 16 clients
+ * of the local cpu:
+ *  - every client receives one intact copy of each event,
+ *  - a shared event costs a single copy plus one envelope per client, and a
+ *    single client still gets a plain copy,
+ *  - when allocations fail, at any point of the delivery, the service
+ *    manager does not panic: each client receives the event or is reported
+ *    as dropped, and no block is leaked,
+ *  - when the pools are really exhausted, the same holds.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cfw_host.h"
+#include "cfw/cfw.h"
+#include "cfw/cfw_service.h"
+#include "infra/port.h"
+
+#define MAX_CLIENTS 16
+#define EVT_ID      0x1234
+#define PAYLOAD     8   /* the pools hold a copy of the event per client */
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+struct test_evt {
+    struct cfw_message header;
+    uint32_t seq;
+    uint8_t payload[PAYLOAD];
+};
+
+struct client {
+    conn_handle_t conn;
+    unsigned int received;
+};
+
+static struct client clients[MAX_CLIENTS];
+static T_QUEUE queue;
+static uint16_t svc_port;
+static uint32_t seq;
+
+static void client_handler(struct cfw_message *msg, void *param)
+{
+    struct client *c = param;
+    struct test_evt *evt = (struct test_evt *)msg;
+    int i;
+
+    CHECK(CFW_MESSAGE_ID(msg) == EVT_ID);
+    CHECK(CFW_MESSAGE_LEN(msg) == sizeof(*evt));
+    CHECK(CFW_MESSAGE_SRC(msg) == svc_port);
+    CHECK(evt->seq == seq);
+    for (i = 0; i < PAYLOAD; i++) {
+        CHECK(evt->payload[i] == (uint8_t)(seq + i));
+    }
+    c->received++;
+    cfw_msg_free(msg);
+}
+
+static void init_clients(void)
+{
+    int i;
+
+    for (i = 0; i < MAX_CLIENTS; i++) {
+        list_init(&clients[i].conn.registered_events);
+        clients[i].conn.client_port = port_alloc(queue);
+        port_set_handler(clients[i].conn.client_port,
+                         (void (*)(struct message *, void *))client_handler,
+                         &clients[i]);
+    }
+}
+
+static void register_clients(int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        _cfw_register_event(&clients[i].conn, EVT_ID);
+    }
+}
+
+static void unregister_clients(int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        _cfw_unregister_event(&clients[i].conn);
+    }
+}
+
+/*
+ * Send an event, failing the allocations fail_first to fail_first +
+ * fail_count - 1 of cfw_send_event(). Return the number of allocations it
+ * made.
+ */
+static unsigned int send_event(unsigned int fail_first, unsigned int fail_count)
+{
+    struct test_evt *evt;
+    unsigned int allocs;
+    int i;
+
+    evt = (struct test_evt *)message_alloc(sizeof(*evt), NULL);
+    CFW_MESSAGE_ID(&evt->header) = EVT_ID;
+    CFW_MESSAGE_LEN(&evt->header) = sizeof(*evt);
+    CFW_MESSAGE_SRC(&evt->header) = svc_port;
+    CFW_MESSAGE_TYPE(&evt->header) = TYPE_EVT;
+    evt->seq = ++seq;
+    for (i = 0; i < PAYLOAD; i++) {
+        evt->payload[i] = (uint8_t)(seq + i);
+    }
+    host_allocs = 0;
+    host_fail_first = fail_first;
+    host_fail_count = fail_count;
+    cfw_send_event(&evt->header);
+    host_fail_first = -1U;
+    allocs = host_allocs;
+    cfw_msg_free(&evt->header);
+    return allocs;
+}
+
+/* Dispatch the queued events, return the number of clients served */
+static int deliver(int n)
+{
+    T_QUEUE_MESSAGE m;
+    OS_ERR_TYPE err;
+    int i, served = 0;
+
+    for (i = 0; i < n; i++) {
+        clients[i].received = 0;
+    }
+    for (;;) {
+        queue_get_message(queue, &m, OS_NO_WAIT, &err);
+        if (err != E_OS_OK) {
+            break;
+        }
+        port_process_message(m);
+    }
+    for (i = 0; i < n; i++) {
+        CHECK(clients[i].received <= 1);
+        served += clients[i].received;
+    }
+    return served;
+}
+
+static void check_delivery(int n)
+{
+    int blocks = host_blocks;
+    unsigned int allocs;
+
+    allocs = send_event(-1U, 0);
+    CHECK(deliver(n) == n);
+    CHECK(allocs == (n == 1 ? 1U : n + 1U));
+    CHECK(host_blocks == blocks);
+}
+
+static void check_failures(int n)
+{
+    static const unsigned int counts[] = { 1, 2, -1U };
+    unsigned int first, c, warnings;
+    int blocks, served;
+
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        for (first = 0; first <= n + 1U; first++) {
+            blocks = host_blocks;
+            warnings = host_warnings;
+            send_event(first, counts[c]);
+            served = deliver(n);
+            /* Each client is either served or reported as dropped */
+            CHECK(served + (int)(host_warnings - warnings) == n);
+            /* A single failure is recovered with a copy */
+            if (counts[c] == 1 && n > 1) {
+                CHECK(served == n);
+            }
+            CHECK(host_blocks == blocks);
+        }
+    }
+}
+
+static void check_exhausted(int n)
+{
+    static void *held[256];
+    unsigned int held_count = 0, warnings = host_warnings;
+    OS_ERR_TYPE err = E_OS_OK;
+    int blocks = host_blocks;
+    int served;
+
+    /* Hold every block but enough for the event of the sender */
+    while (held_count < sizeof(held) / sizeof(held[0])) {
+        held[held_count] = balloc(8, &err);
+        if (held[held_count] == NULL) {
+            break;
+        }
+        held_count++;
+    }
+    CHECK(held_count > 0 && held_count < sizeof(held) / sizeof(held[0]));
+    bfree(held[--held_count]);
+    bfree(held[--held_count]);
+
+    send_event(-1U, 0);
+    served = deliver(n);
+    CHECK(served + (int)(host_warnings - warnings) == n);
+
+    while (held_count > 0) {
+        bfree(held[--held_count]);
+    }
+    CHECK(host_blocks == blocks);
+}
+
+int main(void)
+{
+    int n;
+
+    cfw_host_pool_init();
+    queue = queue_create(2 * MAX_CLIENTS, NULL);
+    svc_port = port_alloc(queue);
+    init_clients();
+
+    for (n = 1; n <= MAX_CLIENTS; n++) {
+        register_clients(n);
+        check_delivery(n);
+        check_failures(n);
+        check_exhausted(n);
+        unregister_clients(n);
+    }
+
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the per-port statistics of port.c built with CONFIG_PORT_STATS:
+ *  - sent and received messages, the length histogram and the queue depth,
+ *  - messages that do not fit in the queue are counted as dropped,
+ *  - the enqueue to dispatch latency and the slowest handler,
+ *  - the binary snapshot layout, and a reset that keeps queued messages.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cfw_host.h"
+#include "infra/port.h"
+
+#define QUEUE_SIZE 4
+/* Page aligned buffers of 512 bytes get distinct enqueue time entries */
+#define BUF_SIZE   512
+#define BUFS       8
+#define SLOW_MSG   0x42
+#define SLOW_US    2000
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+/* Messages are not freed by the handlers, they come from here */
+static uint8_t bufs[BUFS][BUF_SIZE] __attribute__((aligned(4096)));
+static T_QUEUE queue;
+static uint16_t fast_port, slow_port;
+static unsigned int handled;
+
+static void wait_us(uint32_t us)
+{
+    uint64_t start = get_time_us();
+
+    while (get_time_us() - start < us) {
+    }
+}
+
+static void handler(struct message *msg, void *param)
+{
+    if (MESSAGE_ID(msg) == SLOW_MSG) {
+        wait_us(SLOW_US);
+    }
+    handled++;
+}
+
+static struct message *msg_init(int buf, uint16_t port, uint16_t id,
+                                uint16_t len)
+{
+    struct message *msg = (struct message *)bufs[buf];
+
+    memset(msg, 0, sizeof(*msg));
+    MESSAGE_ID(msg) = id;
+    MESSAGE_DST(msg) = port;
+    MESSAGE_SRC(msg) = port;
+    MESSAGE_LEN(msg) = len;
+    return msg;
+}
+
+static void process_all(void)
+{
+    OS_ERR_TYPE err;
+
+    do {
+        queue_process_message_wait(queue, OS_NO_WAIT, &err);
+    } while (err == E_OS_OK);
+}
+
+static void check_counters(void)
+{
+    static const uint16_t lens[] = { 8, 40, 300 };
+    struct port_stats st;
+    unsigned int i;
+
+    port_stats_reset();
+    for (i = 0; i < 3; i++) {
+        CHECK(port_send_message(msg_init(i, fast_port, i, lens[i])) == E_OS_OK);
+    }
+    port_stats_get(fast_port, &st);
+    CHECK(st.sent == 3);
+    CHECK(st.received == 0);
+    CHECK(st.depth == 3 && st.max_depth == 3);
+    CHECK(st.len_hist[0] == 1 && st.len_hist[2] == 1 && st.len_hist[5] == 1);
+    CHECK(st.len_hist[1] == 0 && st.len_hist[3] == 0 && st.len_hist[4] == 0);
+
+    wait_us(1000);
+    process_all();
+    port_stats_get(fast_port, &st);
+    CHECK(st.received == 3);
+    CHECK(st.depth == 0 && st.max_depth == 3);
+    CHECK(st.latency_count == 3);
+    CHECK(st.latency_max >= 1000 && st.latency_total >= 3000);
+    CHECK(st.dropped == 0);
+
+    port_stats_get(slow_port, &st);
+    CHECK(st.sent == 0 && st.received == 0);
+}
+
+static void check_drops(void)
+{
+    struct port_stats st;
+    int i;
+
+    port_stats_reset();
+    for (i = 0; i < QUEUE_SIZE + 1; i++) {
+        OS_ERR_TYPE err = port_send_message(msg_init(i, fast_port, i, 16));
+
+        CHECK((err == E_OS_OK) == (i < QUEUE_SIZE));
+    }
+    port_stats_get(fast_port, &st);
+    CHECK(st.sent == QUEUE_SIZE + 1);
+    CHECK(st.dropped == 1);
+    CHECK(st.depth == QUEUE_SIZE && st.max_depth == QUEUE_SIZE);
+
+    handled = 0;
+    process_all();
+    port_stats_get(fast_port, &st);
+    CHECK(handled == QUEUE_SIZE);
+    CHECK(st.received == QUEUE_SIZE);
+    CHECK(st.latency_count == QUEUE_SIZE);
+    CHECK(st.depth == 0);
+}
+
+static void check_handler_time(void)
+{
+    struct port_stats st;
+
+    port_stats_reset();
+    port_send_message(msg_init(0, slow_port, SLOW_MSG - 1, 16));
+    port_send_message(msg_init(1, slow_port, SLOW_MSG, 16));
+    port_send_message(msg_init(2, slow_port, SLOW_MSG + 1, 16));
+    process_all();
+    port_stats_get(slow_port, &st);
+    CHECK(st.received == 3);
+    CHECK(st.handler_max >= SLOW_US);
+    CHECK(st.handler_max_msg_id == SLOW_MSG);
+    /* The last message waited for the slow handler */
+    CHECK(st.latency_max >= SLOW_US);
+}
+
+static void check_snapshot(void)
+{
+    uint8_t snap[2 * (sizeof(uint16_t) + sizeof(struct port_stats)) +
+                 sizeof(uint16_t)];
+    struct port_stats st, expected;
+    uint16_t count, id;
+
+    port_stats_reset();
+    port_send_message(msg_init(0, fast_port, 1, 16));
+    port_send_message(msg_init(1, slow_port, 2, 64));
+    process_all();
+
+    CHECK(port_stats_snapshot(snap, 1) == -1);
+    CHECK(port_stats_snapshot(snap, sizeof(snap) - 1) == -1);
+    CHECK(port_stats_snapshot(snap, sizeof(snap)) == sizeof(snap));
+
+    memcpy(&count, snap, sizeof(count));
+    CHECK(count == 2);
+    memcpy(&id, snap + 2, sizeof(id));
+    memcpy(&st, snap + 4, sizeof(st));
+    port_stats_get(fast_port, &expected);
+    CHECK(id == fast_port);
+    CHECK(memcmp(&st, &expected, sizeof(st)) == 0);
+    memcpy(&id, snap + 4 + sizeof(st), sizeof(id));
+    memcpy(&st, snap + 6 + sizeof(st), sizeof(st));
+    port_stats_get(slow_port, &expected);
+    CHECK(id == slow_port);
+    CHECK(memcmp(&st, &expected, sizeof(st)) == 0);
+
+    /* Ports without traffic are left out */
+    port_stats_reset();
+    CHECK(port_stats_snapshot(snap, sizeof(uint16_t)) == sizeof(uint16_t));
+    memcpy(&count, snap, sizeof(count));
+    CHECK(count == 0);
+}
+
+static void check_reset(void)
+{
+    struct port_stats st;
+
+    port_send_message(msg_init(0, fast_port, 1, 16));
+    port_send_message(msg_init(1, fast_port, 2, 16));
+    port_stats_reset();
+    port_stats_get(fast_port, &st);
+    CHECK(st.sent == 0);
+    CHECK(st.depth == 2 && st.max_depth == 2);
+
+    process_all();
+    port_stats_get(fast_port, &st);
+    CHECK(st.received == 2);
+    CHECK(st.depth == 0);
+    /* Enqueued before the reset, still timed */
+    CHECK(st.latency_count == 2);
+}
+
+int main(void)
+{
+    queue = queue_create(QUEUE_SIZE, NULL);
+    fast_port = port_alloc(queue);
+    slow_port = port_alloc(queue);
+    port_set_handler(fast_port, handler, NULL);
+    port_set_handler(slow_port, handler, NULL);
+
+    check_counters();
+    check_drops();
+    check_handler_time();
+    check_snapshot();
+    check_reset();
+    port_stats_dump();
+
+    printf("%s test_port_stats\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -29,7 +29,9 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string.h>
 #include "util/list.h"
+#include "util/misc.h"
 #include "os/os.h"
 #include "cfw/cfw.h"
 #include "cfw/cfw_debug.h"
@@ -86,6 +88,7 @@ void internal_handle_message(struct message * m, void * param) {
             conn_handle->priv_data = NULL;
             conn_handle->svc = svc;
             conn_handle->client_handle = req->client_handle;
+            list_init(&conn_handle->registered_events);
             /* For OPEN_SERVICE, conn is not know yet, it is just alloc'ed.
              * set it here.*/
             req->header.conn = conn_handle;
@@ -189,8 +192,10 @@ uint16_t cfw_port_alloc(void * queue) {
  * Holds a list of receivers.
  */
 typedef struct {
-    list_t list;
+    list_t list;                       /*! Link in the list of clients of the event */
+    list_t conn_list;                  /*! Link in the list of events of the client */
     conn_handle_t * conn_handle;
+    struct registered_evt_list_ * evt; /*! Event registered to */
 } indication_list_t;
 
 /**
@@ -204,12 +209,21 @@ typedef struct registered_evt_list_ {
     int ind;         /*! Indication message id */
 } registered_evt_list_t;
 
-list_head_t registered_evt_list;
+#ifndef EVT_HASH_SIZE
+#define EVT_HASH_SIZE 16 /*!< Number of buckets of the event index, power of 2 */
+#endif
 
+/* Message ids are (service_id << 10 | id), fold the service id in the hash */
+#define EVT_HASH(msg_id) (((msg_id) ^ ((msg_id) >> 10)) & (EVT_HASH_SIZE - 1))
 
+/**
+ * Registered events, hashed on their message id.
+ */
+list_head_t registered_evt_list[EVT_HASH_SIZE];
 
 registered_evt_list_t * get_event_registered_list(int msg_id) {
-    registered_evt_list_t * l = (registered_evt_list_t*)registered_evt_list.head;
+    registered_evt_list_t * l =
+        (registered_evt_list_t*)registered_evt_list[EVT_HASH(msg_id)].head;
     while(l) {
         if (l->ind == msg_id) {
             return l;
@@ -226,6 +240,96 @@ list_head_t * get_event_list(int msg_id) {
     return NULL;
 }
 
+#ifdef CONFIG_CFW_SHARED_EVENTS
+struct send_event_param {
+    struct cfw_message * msg;
+    struct message * shared; /*! Copy delivered to the local clients */
+    bool no_share; /*! The shared copy could not be allocated */
+    int local_clients; /*! Number of local clients seen so far */
+    uint16_t first_port; /*! First local client, served once a second one is seen */
+};
+
+/**
+ * Deliver a copy of the event to a client.
+ *
+ * The event is dropped for this client if the pools are exhausted.
+ */
+static void send_event_copy(struct cfw_message * msg, uint16_t port_id) {
+    OS_ERR_TYPE err = E_OS_OK;
+    struct cfw_message * m = (struct cfw_message *) message_alloc(
+            CFW_MESSAGE_LEN(msg), &err);
+
+    if (m == NULL) {
+        pr_warning(LOG_MODULE_CFW, "%s: event %x dropped for port %d", __func__,
+                CFW_MESSAGE_ID(msg), port_id);
+        return;
+    }
+    memcpy(m, msg, CFW_MESSAGE_LEN(msg));
+    CFW_MESSAGE_DST(m) = port_id;
+    cfw_send_message(m);
+}
+
+/**
+ * Deliver the shared copy of the event to a local client.
+ *
+ * The client gets a copy of its own if the shared copy or its envelope
+ * cannot be allocated.
+ */
+static void send_event_shared(struct send_event_param * p, uint16_t port_id) {
+    OS_ERR_TYPE err = E_OS_OK;
+
+    if (p->shared == NULL && !p->no_share) {
+        p->shared = message_share(CFW_MESSAGE_HEADER(p->msg), &err);
+        p->no_share = (p->shared == NULL);
+    }
+    if (p->shared != NULL) {
+        err = port_send_message_ref(p->shared, port_id);
+        if (err != E_OS_ERR_NO_MEMORY) {
+            return;
+        }
+    }
+    send_event_copy(p->msg, port_id);
+}
+
+static void send_event_callback(void * item, void * param) {
+    struct send_event_param * p = (struct send_event_param *) param;
+    indication_list_t * ind = (indication_list_t *)item;
+    uint16_t port_id = ind->conn_handle->client_port;
+
+    if (port_get_cpu_id(port_id) != get_cpu_id()) {
+        /* Shared messages never cross the IPC */
+        send_event_copy(p->msg, port_id);
+        return;
+    }
+    /* Sharing only pays from the second local client */
+    if (++p->local_clients == 1) {
+        p->first_port = port_id;
+        return;
+    }
+    if (p->local_clients == 2) {
+        send_event_shared(p, p->first_port);
+    }
+    send_event_shared(p, port_id);
+}
+
+void cfw_send_event(struct cfw_message * msg) {
+#ifdef SVC_MANAGER_DEBUG
+    pr_debug(LOG_MODULE_CFW, "%s : msg:%d", __func__, CFW_MESSAGE_ID(msg));
+#endif
+    struct send_event_param p = { msg, NULL, false, 0, 0 };
+    list_head_t * list = get_event_list(CFW_MESSAGE_ID(msg));
+    if (list != NULL) {
+        list_foreach(list, send_event_callback, &p);
+        if (p.local_clients == 1) {
+            send_event_copy(msg, p.first_port);
+        }
+        if (p.shared != NULL) {
+            /* Drop the reference held by the sender */
+            message_free(p.shared);
+        }
+    }
+}
+#else
 static void send_event_callback(void * item, void * param) {
     struct cfw_message * msg = (struct cfw_message *) param;
     indication_list_t * ind = (indication_list_t *)item;
@@ -245,21 +349,25 @@ void cfw_send_event(struct cfw_message * msg) {
         list_foreach(list, send_event_callback, msg);
     }
 }
+#endif
 
-static int unregister_events_cb(void * element, void * param) {
-    indication_list_t * e = (indication_list_t *) element;
+void _cfw_unregister_event(conn_handle_t * h) {
+    list_t * l;
 
-    if ( e->conn_handle == param ) {
-        return 1;
+    if (h == NULL) {
+        return;
     }
-    return 0;
-}
-
-void _cfw_unregister_event(conn_handle_t * h) {
-    registered_evt_list_t * l = (registered_evt_list_t*)registered_evt_list.head;
-    while (l) {
-        list_foreach_del(&l->lh, unregister_events_cb, h);
-        l = (registered_evt_list_t*) l->list.next;
+    /* Only visit the events the client registered to */
+    while ((l = list_get(&h->registered_events)) != NULL) {
+        indication_list_t * e = container_of(l, indication_list_t, conn_list);
+        registered_evt_list_t * evt = e->evt;
+
+        list_remove(&evt->lh, &e->list);
+        bfree(e);
+        if (list_empty(&evt->lh)) {
+            list_remove(&registered_evt_list[EVT_HASH(evt->ind)], &evt->list);
+            bfree(evt);
+        }
     }
 }
 
@@ -281,13 +389,15 @@ void _cfw_register_event(conn_handle_t * h, int msg_id) {
         ind = (registered_evt_list_t *) balloc(sizeof(*ind), NULL);
         ind->ind = msg_id;
         list_init(&ind->lh);
-        list_add(&registered_evt_list, &ind->list);
+        list_add(&registered_evt_list[EVT_HASH(msg_id)], &ind->list);
     }
 
     if (!list_find_first(&ind->lh, check_duplicate_handle_cb, h)) {
         indication_list_t * e = (indication_list_t *)balloc(sizeof(*e), NULL);
         e->conn_handle = h;
-        list_add(&ind->lh, (list_t *)e);
+        e->evt = ind;
+        list_add(&ind->lh, &e->list);
+        list_add(&h->registered_events, &e->conn_list);
     }
 }
 
@@ -45,30 +45,87 @@
 #include "services/gpio_service.h"
 #include "infra/log.h"
 #include "infra/device.h"
+#include "infra/time.h"
+#include "util/list.h"
+#include "util/compiler.h"
 
 #include "machine.h"
 
+#ifdef CONFIG_GPIO_SERVICE_EVT_RING_SIZE
+#define GPIO_EVT_RING_SIZE CONFIG_GPIO_SERVICE_EVT_RING_SIZE
+#else
+#define GPIO_EVT_RING_SIZE 32
+#endif
+#if (GPIO_EVT_RING_SIZE & (GPIO_EVT_RING_SIZE - 1))
+#error "GPIO_SERVICE_EVT_RING_SIZE must be a power of 2"
+#endif
+
+#ifdef CONFIG_GPIO_SERVICE_EVT_WINDOW
+#define GPIO_EVT_WINDOW CONFIG_GPIO_SERVICE_EVT_WINDOW
+#else
+#define GPIO_EVT_WINDOW 0
+#endif
+
+/** delay in ms before a new attempt to schedule the processing, without window */
+#define GPIO_EVT_RETRY_DELAY 10
+#if GPIO_EVT_WINDOW > 0
+#define GPIO_EVT_TIMER_DELAY GPIO_EVT_WINDOW
+#else
+#define GPIO_EVT_TIMER_DELAY GPIO_EVT_RETRY_DELAY
+#endif
+
+/** service internal message ID to process the recorded interrupts */
+#define MSG_ID_GPIO_EVT_DRAIN (MSG_ID_GPIO_BASE + 0x3f)
+
+/**
+ * \brief interrupt record, pins are numbered as in the service requests
+ */
+struct gpio_evt {
+    uint32_t pins;      /*!< pins which triggered the interrupt */
+    uint32_t levels;    /*!< pin levels at the interrupt */
+    uint32_t timestamp; /*!< 32 kHz uptime of the interrupt */
+};
+
 /**
  * \brief gpio service management structure
+ *
+ * The interrupt handlers record the interrupts in evt_ring, and the service
+ * processes them in batches. Only the handlers write evt_head and only the
+ * service writes evt_tail, so the ring needs no lock.
  */
 struct gpio_service_data {
     service_t svc;
     struct device **gpio_devs;
+    struct gpio_evt *evt_ring;      /*!< recorded interrupts */
+    volatile uint16_t evt_head;     /*!< next record to write */
+    volatile uint16_t evt_tail;     /*!< next record to process */
+    volatile uint8_t drain_pending; /*!< processing of the records is scheduled */
+    T_TIMER evt_timer;              /*!< coalescing window and retry timer */
+    uint32_t port_mask;             /*!< pins reported by the port callback */
+    uint32_t levels;                /*!< pin levels at the last processed interrupts */
+    list_head_t listeners;          /*!< gpio_service_listen_priv of the listening clients */
+    uint32_t lost_irq;              /*!< interrupts dropped, the ring being full */
+    uint32_t lost_evt;              /*!< events dropped, the message pool being empty */
 };
 
 /**
  * \brief gpio listen management structure
  */
 struct gpio_service_listen_priv {
+    list_t         list;
+    struct gpio_service_data *svc;
     conn_handle_t *conn;
     void          *priv;
-    uint8_t        pin;
+    uint32_t       mask;     /*!< pins listened */
+    uint8_t        pin;      /*!< first pin listened */
+    uint8_t        port_evt; /*!< report gpio_port_evt_msg_t events */
 };
 
 
 static void gpio_client_connected(conn_handle_t * instance);
 static void gpio_client_disconnected(conn_handle_t * instance);
 static void gpio_handle_message(struct cfw_message * msg, void * param);
+static void gpio_evt_timer_callback(void *priv);
 
 /****************************************************************************************
  ************************** SERVICE INITIALIZATION **************************************
@@ -81,7 +138,8 @@ static struct gpio_service_data ss_gpio_service = {
         .client_disconnected = gpio_client_disconnected,
     },
     // ss_gpio service handles ss_gpio_8b0 and ss_gpio_8b1 devices
-    .gpio_devs = (struct device*[2]) {NULL}
+    .gpio_devs = (struct device*[2]) {NULL},
+    .evt_ring = (struct gpio_evt[GPIO_EVT_RING_SIZE]) {{0}}
 };
 #endif
 #ifdef CONFIG_SOC_GPIO_32
@@ -90,7 +148,8 @@ static struct gpio_service_data soc_gpio_service = {
         .client_connected = gpio_client_connected,
         .client_disconnected = gpio_client_disconnected,
     },
-    .gpio_devs = (struct device*[1]) {NULL}
+    .gpio_devs = (struct device*[1]) {NULL},
+    .evt_ring = (struct gpio_evt[GPIO_EVT_RING_SIZE]) {{0}}
 };
 #endif
 #ifdef CONFIG_SOC_GPIO_AON
@@ -99,7 +158,8 @@ static struct gpio_service_data aon_gpio_service = {
         .client_connected = gpio_client_connected,
         .client_disconnected = gpio_client_disconnected,
     },
-    .gpio_devs = (struct device*[1]) {NULL}
+    .gpio_devs = (struct device*[1]) {NULL},
+    .evt_ring = (struct gpio_evt[GPIO_EVT_RING_SIZE]) {{0}}
 };
 #endif
 
@@ -107,6 +167,16 @@ static struct gpio_service_data aon_gpio_service = {
  ************************** SERVICE IMPLEMENTATION **************************************
  ****************************************************************************************/
 
+static void gpio_evt_init(struct gpio_service_data *svc)
+{
+    OS_ERR_TYPE err;
+
+    svc->evt_timer = timer_create(gpio_evt_timer_callback, svc, GPIO_EVT_TIMER_DELAY, false, false, &err);
+    if (svc->evt_timer == NULL) {
+        pr_error(LOG_MODULE_GPIO_SVC, "gpio service %d: timer creation failed", svc->svc.service_id);
+    }
+}
+
 void gpio_service_init(void * queue, int service_id) {
     switch (service_id) {
 #ifdef CONFIG_SS_GPIO
@@ -122,6 +192,7 @@ void gpio_service_init(void * queue, int service_id) {
             ss_gpio_service.svc.service_id = service_id;
             // Register service
             cfw_register_service(queue, &ss_gpio_service.svc, gpio_handle_message, &ss_gpio_service);
+            gpio_evt_init(&ss_gpio_service);
             pr_debug(LOG_MODULE_GPIO_SVC, "register ss_gpio service %d", service_id);
             break;
 #endif
@@ -137,6 +208,7 @@ void gpio_service_init(void * queue, int service_id) {
             soc_gpio_service.svc.service_id = service_id;
             // Register service
             cfw_register_service(queue, &soc_gpio_service.svc, gpio_handle_message, &soc_gpio_service);
+            gpio_evt_init(&soc_gpio_service);
             pr_debug(LOG_MODULE_GPIO_SVC, "register soc_gpio_32 service %d", service_id);
             break;
 #endif
@@ -152,6 +224,7 @@ void gpio_service_init(void * queue, int service_id) {
             aon_gpio_service.svc.service_id = service_id;
             // Register service
             cfw_register_service(queue, &aon_gpio_service.svc, gpio_handle_message, &aon_gpio_service);
+            gpio_evt_init(&aon_gpio_service);
             pr_debug(LOG_MODULE_GPIO_SVC, "register soc_gpio_aon service %d", service_id);
             break;
 #endif
@@ -181,28 +254,182 @@ static void gpio_set_default_config(gpio_cfg_data_t *config)
     config->gpio_cb_arg = NULL;
 }
 
+/**
+ * Post the message which makes the service process the recorded interrupts.
+ */
+static void gpio_evt_send_drain(struct gpio_service_data *svc)
+{
+    OS_ERR_TYPE err;
+    struct cfw_message *msg;
+
+    if ((msg = cfw_alloc_message(sizeof(*msg), &err)) == NULL) {
+        // The records stay in the ring, retry when the timer expires
+        timer_start(svc->evt_timer, GPIO_EVT_TIMER_DELAY, &err);
+        if (err != E_OS_OK) {
+            // Retried at the next interrupt
+            svc->drain_pending = 0;
+        }
+        return;
+    }
+    CFW_MESSAGE_LEN(msg) = sizeof(*msg);
+    CFW_MESSAGE_ID(msg) = MSG_ID_GPIO_EVT_DRAIN;
+    CFW_MESSAGE_TYPE(msg) = TYPE_INT;
+    CFW_MESSAGE_SRC(msg) = svc->svc.port_id;
+    CFW_MESSAGE_DST(msg) = svc->svc.port_id;
+    CFW_MESSAGE_PRIV(msg) = NULL;
+    CFW_MESSAGE_CONN(msg) = NULL;
+    cfw_send_message(msg);
+}
+
+static void gpio_evt_timer_callback(void *priv)
+{
+    gpio_evt_send_drain((struct gpio_service_data *)priv);
+}
+
+/**
+ * Record an interrupt, called from the interrupt handlers only.
+ */
+static void gpio_evt_push(struct gpio_service_data *svc, uint32_t pins, uint32_t levels)
+{
+    uint16_t head = svc->evt_head;
+    struct gpio_evt *evt;
+
+    if ((uint16_t)(head - svc->evt_tail) >= GPIO_EVT_RING_SIZE) {
+        svc->lost_irq++;
+    } else {
+        evt = &svc->evt_ring[head & (GPIO_EVT_RING_SIZE - 1)];
+        evt->pins = pins;
+        evt->levels = levels;
+        evt->timestamp = get_uptime_32k();
+        BARRIER();
+        svc->evt_head = head + 1;
+    }
+
+    if (!svc->drain_pending) {
+        svc->drain_pending = 1;
+#if GPIO_EVT_WINDOW > 0
+        OS_ERR_TYPE err;
+        timer_start(svc->evt_timer, GPIO_EVT_WINDOW, &err);
+        if (err != E_OS_OK) {
+            gpio_evt_send_drain(svc);
+        }
+#else
+        gpio_evt_send_drain(svc);
+#endif
+    }
+}
+
+/**
+ * Port callback of the SOC GPIO ports, pins are numbered as in the service.
+ */
+static void gpio_service_port_callback(uint32_t pins, uint32_t levels, void *priv)
+{
+    gpio_evt_push((struct gpio_service_data *)priv, pins, levels);
+}
+
+/**
+ * Pin callback, used by the ports without port callback.
+ */
 static void gpio_service_callback(bool state, void *priv)
 {
     struct gpio_service_listen_priv *service_priv = (struct gpio_service_listen_priv*)priv;
+    // The two SS GPIO ports share the ring of the service
+    uint32_t saved = interrupt_lock();
+
+    gpio_evt_push(service_priv->svc, 1u << service_priv->pin, (uint32_t)state << service_priv->pin);
+    interrupt_unlock(saved);
+}
 
+static void gpio_send_pin_evt(struct gpio_service_listen_priv *listener, uint32_t levels)
+{
     OS_ERR_TYPE err;
     gpio_listen_evt_msg_t *msg;
+
     if((msg = (gpio_listen_evt_msg_t*)
-                cfw_alloc_message(sizeof(*msg), &err)) != NULL) {
-        CFW_MESSAGE_LEN((struct cfw_message *)msg) = sizeof(*msg);
-        CFW_MESSAGE_ID((struct cfw_message *)msg) = MSG_ID_GPIO_EVT;
-        CFW_MESSAGE_TYPE((struct cfw_message *)msg) = TYPE_EVT;
-        CFW_MESSAGE_SRC((struct cfw_message *)msg) = service_priv->conn->svc->port_id;
-        CFW_MESSAGE_DST((struct cfw_message *)msg) = service_priv->conn->client_port;
-        CFW_MESSAGE_PRIV((struct cfw_message *)msg) = service_priv->priv;
-        CFW_MESSAGE_CONN((struct cfw_message *)msg) = service_priv->conn;
-        msg->pin_state = state;
-        msg->index = service_priv->pin;
-
-        cfw_send_message(msg);
-    } else {
-        pr_error(LOG_MODULE_GPIO_SVC, "%s: Error: cfw allocation failed for message", __func__);
-        panic(E_OS_ERR_UNKNOWN); // Panic because we should never reach this point.
+                cfw_alloc_message(sizeof(*msg), &err)) == NULL) {
+        listener->svc->lost_evt++;
+        return;
+    }
+    CFW_MESSAGE_LEN((struct cfw_message *)msg) = sizeof(*msg);
+    CFW_MESSAGE_ID((struct cfw_message *)msg) = MSG_ID_GPIO_EVT;
+    CFW_MESSAGE_TYPE((struct cfw_message *)msg) = TYPE_EVT;
+    CFW_MESSAGE_SRC((struct cfw_message *)msg) = listener->conn->svc->port_id;
+    CFW_MESSAGE_DST((struct cfw_message *)msg) = listener->conn->client_port;
+    CFW_MESSAGE_PRIV((struct cfw_message *)msg) = listener->priv;
+    CFW_MESSAGE_CONN((struct cfw_message *)msg) = listener->conn;
+    msg->pin_state = !!(levels & (1u << listener->pin));
+    msg->index = listener->pin;
+
+    cfw_send_message(msg);
+}
+
+static void gpio_send_port_evt(struct gpio_service_listen_priv *listener, uint32_t changed,
+        uint32_t levels, uint32_t timestamp)
+{
+    OS_ERR_TYPE err;
+    gpio_port_evt_msg_t *msg;
+
+    if((msg = (gpio_port_evt_msg_t*)
+                cfw_alloc_message(sizeof(*msg), &err)) == NULL) {
+        listener->svc->lost_evt++;
+        return;
+    }
+    CFW_MESSAGE_LEN((struct cfw_message *)msg) = sizeof(*msg);
+    CFW_MESSAGE_ID((struct cfw_message *)msg) = MSG_ID_GPIO_PORT_EVT;
+    CFW_MESSAGE_TYPE((struct cfw_message *)msg) = TYPE_EVT;
+    CFW_MESSAGE_SRC((struct cfw_message *)msg) = listener->conn->svc->port_id;
+    CFW_MESSAGE_DST((struct cfw_message *)msg) = listener->conn->client_port;
+    CFW_MESSAGE_PRIV((struct cfw_message *)msg) = listener->priv;
+    CFW_MESSAGE_CONN((struct cfw_message *)msg) = listener->conn;
+    msg->changed = changed;
+    msg->state = levels;
+    msg->timestamp = timestamp;
+    msg->lost_irq = listener->svc->lost_irq;
+    msg->lost_evt = listener->svc->lost_evt;
+
+    cfw_send_message(msg);
+}
+
+/**
+ * Process the recorded interrupts: pin listeners get an event per interrupt
+ * of their pin, with the level recorded at that interrupt. Port listeners get
+ * a single event for all the interrupts of their pins.
+ */
+static void handle_evt_drain(struct gpio_service_data *svc)
+{
+    struct gpio_evt *evt;
+    struct gpio_service_listen_priv *listener;
+    uint32_t changed = 0;
+    uint32_t levels = svc->levels;
+    uint32_t timestamp = 0;
+    uint16_t tail = svc->evt_tail;
+
+    // Interrupts recorded from now on schedule a new processing
+    svc->drain_pending = 0;
+    BARRIER();
+
+    while (tail != svc->evt_head) {
+        evt = &svc->evt_ring[tail & (GPIO_EVT_RING_SIZE - 1)];
+        for (listener = (struct gpio_service_listen_priv *)svc->listeners.head; listener != NULL;
+                listener = (struct gpio_service_listen_priv *)listener->list.next) {
+            if (!listener->port_evt && (evt->pins & listener->mask)) {
+                gpio_send_pin_evt(listener, evt->levels);
+            }
+        }
+        changed |= evt->pins;
+        levels = (levels & ~evt->pins) | (evt->levels & evt->pins);
+        timestamp = evt->timestamp;
+        tail++;
+    }
+    BARRIER();
+    svc->evt_tail = tail;
+    svc->levels = levels;
+
+    for (listener = (struct gpio_service_listen_priv *)svc->listeners.head; listener != NULL;
+            listener = (struct gpio_service_listen_priv *)listener->list.next) {
+        if (listener->port_evt && (changed & listener->mask)) {
+            gpio_send_port_evt(listener, changed & listener->mask, levels & listener->mask, timestamp);
+        }
     }
 }
 
@@ -253,28 +480,30 @@ static struct device* get_gpio_dev(struct gpio_service_data *svc, uint8_t *pin)
     return NULL;
 }
 
-void handle_configure(struct cfw_message *msg, struct gpio_service_data *svc)
+/**
+ * Configure a pin of the service port as an input or an output.
+ *
+ * @param svc   service data
+ * @param pin   index of the pin in the service port
+ * @param mode  0 - input, 1 - output
+ */
+static DRIVER_API_RC gpio_configure_pin(struct gpio_service_data *svc, uint8_t pin, uint8_t mode)
 {
     DRIVER_API_RC ret;
     gpio_cfg_data_t config;
 
-    gpio_configure_req_msg_t * req = (gpio_configure_req_msg_t*) msg;
-    gpio_configure_rsp_msg_t *resp = (gpio_configure_rsp_msg_t *) cfw_alloc_rsp_msg(msg,
-         MSG_ID_GPIO_CONFIGURE_RSP, sizeof(*resp));
-
-    uint8_t index = req->index;
+    uint8_t index = pin;
     struct device *gpio_dev = get_gpio_dev(svc, &index);
 
     if (!gpio_dev) {
         // gpio device not found or pin not available
-        resp->rsp_header.status = DRV_RC_INVALID_CONFIG;
-        goto send_rsp;
+        return DRV_RC_INVALID_CONFIG;
     }
 
     // Default configuration for interrupts
     gpio_set_default_config(&config);
 
-    config.gpio_type = req->mode == 0 ? GPIO_INPUT : GPIO_OUTPUT;
+    config.gpio_type = mode == 0 ? GPIO_INPUT : GPIO_OUTPUT;
 
     switch (svc->svc.service_id) {
 #if defined(CONFIG_SS_GPIO)
@@ -292,67 +521,90 @@ void handle_configure(struct cfw_message *msg, struct gpio_service_data *svc)
             ret = DRV_RC_INVALID_CONFIG;
             break;
     }
-    resp->rsp_header.status = ret;
-
-send_rsp:
-    cfw_send_message(resp);
+    return ret;
 }
 
-void handle_set(struct cfw_message *msg, struct gpio_service_data *svc)
+/**
+ * Apply a @ref gpio_port_op_t operation to the masked outputs of the service port.
+ */
+static DRIVER_API_RC gpio_update_port(struct gpio_service_data *svc, uint8_t op,
+        uint32_t mask, uint32_t value)
 {
     DRIVER_API_RC ret;
 
-    gpio_set_req_msg_t * req = (gpio_set_req_msg_t *) msg;
-    gpio_set_rsp_msg_t * resp = (gpio_set_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
-            MSG_ID_GPIO_SET_RSP, sizeof(*resp));
-
-    uint8_t index = req->index;
-    struct device *gpio_dev = get_gpio_dev(svc, &index);
-
-    if (!gpio_dev) {
-        // gpio device not found or pin not available
-        resp->rsp_header.status = DRV_RC_INVALID_CONFIG;
-        goto send_rsp;
+    switch (op) {
+        case GPIO_PORT_WRITE:
+        case GPIO_PORT_TOGGLE:
+            break;
+        case GPIO_PORT_SET:
+            value = ~0u;
+            break;
+        case GPIO_PORT_CLEAR:
+            value = 0;
+            break;
+        default:
+            return DRV_RC_INVALID_CONFIG;
     }
 
     switch (svc->svc.service_id) {
 #if defined(CONFIG_SS_GPIO)
         case SS_GPIO_SERVICE_ID:
-            ret = ss_gpio_write(gpio_dev, index, req->state);
+            {
+            // The SS GPIO driver has no masked port access, update the pins one by one
+            struct device *gpio_dev;
+            uint32_t pins;
+            uint8_t index;
+
+            if (op == GPIO_PORT_TOGGLE) {
+                return DRV_RC_INVALID_OPERATION;
+            }
+            // Check the whole mask first, so that an invalid pin leaves the port unchanged
+            for (pins = mask; pins; pins &= pins - 1) {
+                index = __builtin_ctz(pins);
+                if (!get_gpio_dev(svc, &index)) {
+                    return DRV_RC_INVALID_CONFIG;
+                }
+            }
+            ret = DRV_RC_OK;
+            for (pins = mask; pins && (ret == DRV_RC_OK); pins &= pins - 1) {
+                index = __builtin_ctz(pins);
+                gpio_dev = get_gpio_dev(svc, &index);
+                ret = ss_gpio_write(gpio_dev, index, !!(value & pins & -pins));
+            }
+            }
             break;
 #endif
 #if defined(CONFIG_SOC_GPIO_32) || defined(CONFIG_SOC_GPIO_AON)
         case SOC_GPIO_SERVICE_ID:
         case AON_GPIO_SERVICE_ID:
-            ret = soc_gpio_write(gpio_dev, index, req->state);
+            if (op == GPIO_PORT_TOGGLE) {
+                ret = soc_gpio_toggle_port(svc->gpio_devs[0], mask);
+            } else {
+                ret = soc_gpio_write_port_masked(svc->gpio_devs[0], mask, value);
+            }
             break;
 #endif
         default:
             ret = DRV_RC_INVALID_CONFIG;
             break;
     }
-    resp->rsp_header.status = ret;
-
-send_rsp:
-    cfw_send_message(resp);
+    return ret;
 }
 
-void handle_get(struct cfw_message *msg, struct gpio_service_data *svc)
+/**
+ * Read the state of the whole service port.
+ */
+static DRIVER_API_RC gpio_read_port(struct gpio_service_data *svc, uint32_t *port_state)
 {
     DRIVER_API_RC ret = DRV_RC_OK;
-    uint32_t port_state;
-    // get_gpio is currently for a gpio port only, no need to use an index
+    // the port is read as a whole, no need to use an index
     uint8_t index = 0;
 
-    gpio_get_rsp_msg_t * resp = (gpio_get_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
-            MSG_ID_GPIO_GET_RSP, sizeof(*resp));
-
     struct device *gpio_dev = get_gpio_dev(svc, &index);
 
     if (!gpio_dev) {
         // gpio device not found or pin not available
-        resp->rsp_header.status = DRV_RC_INVALID_CONFIG;
-        goto send_rsp;
+        return DRV_RC_INVALID_CONFIG;
     }
 
     switch (svc->svc.service_id) {
@@ -363,10 +615,10 @@ void handle_get(struct cfw_message *msg, struct gpio_service_data *svc)
             if (svc->gpio_devs[0]) {
                 ret = ss_gpio_read_port(svc->gpio_devs[0], &val);
             }
-            port_state = val & ((1 << SS_GPIO_8B0_BITS) - 1);
+            *port_state = val & ((1 << SS_GPIO_8B0_BITS) - 1);
             if ((ret == DRV_RC_OK) && svc->gpio_devs[1]) {
                 ret = ss_gpio_read_port(svc->gpio_devs[1], &val);
-                ((uint8_t*)(&port_state))[1] = val;
+                ((uint8_t*)(port_state))[1] = val;
             }
             }
             break;
@@ -374,32 +626,55 @@ void handle_get(struct cfw_message *msg, struct gpio_service_data *svc)
 #if defined(CONFIG_SOC_GPIO_32) || defined(CONFIG_SOC_GPIO_AON)
         case SOC_GPIO_SERVICE_ID:
         case AON_GPIO_SERVICE_ID:
-            ret = soc_gpio_read_port(gpio_dev, &port_state);
+            ret = soc_gpio_read_port(gpio_dev, port_state);
             break;
 #endif
         default:
             ret = DRV_RC_INVALID_CONFIG;
             break;
     }
+    return ret;
+}
 
+void handle_configure(struct cfw_message *msg, struct gpio_service_data *svc)
+{
+    gpio_configure_req_msg_t * req = (gpio_configure_req_msg_t*) msg;
+    gpio_configure_rsp_msg_t *resp = (gpio_configure_rsp_msg_t *) cfw_alloc_rsp_msg(msg,
+         MSG_ID_GPIO_CONFIGURE_RSP, sizeof(*resp));
+
+    resp->rsp_header.status = gpio_configure_pin(svc, req->index, req->mode);
+
+    cfw_send_message(resp);
+}
+
+void handle_configure_port(struct cfw_message *msg, struct gpio_service_data *svc)
+{
+    DRIVER_API_RC ret = DRV_RC_OK;
+    uint32_t pins;
+
+    gpio_configure_port_req_msg_t * req = (gpio_configure_port_req_msg_t*) msg;
+    gpio_configure_port_rsp_msg_t *resp = (gpio_configure_port_rsp_msg_t *) cfw_alloc_rsp_msg(msg,
+         MSG_ID_GPIO_CONFIGURE_PORT_RSP, sizeof(*resp));
+
+    resp->mask = 0;
+    for (pins = req->mask; pins; pins &= pins - 1) {
+        if ((ret = gpio_configure_pin(svc, __builtin_ctz(pins), req->mode)) != DRV_RC_OK) {
+            break;
+        }
+        resp->mask |= pins & -pins;
+    }
     resp->rsp_header.status = ret;
-    resp->state = ((ret == DRV_RC_OK) ? port_state:0);
 
-send_rsp:
     cfw_send_message(resp);
 }
 
-void handle_unlisten(struct cfw_message *msg, struct gpio_service_data *svc)
+void handle_set(struct cfw_message *msg, struct gpio_service_data *svc)
 {
-    struct gpio_service_listen_priv *priv = NULL;
     DRIVER_API_RC ret;
-    gpio_cfg_data_t config;
-    gpio_unlisten_req_msg_t * req = (gpio_unlisten_req_msg_t *) msg;
-
-    gpio_unlisten_rsp_msg_t * resp = (gpio_unlisten_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
-            MSG_ID_GPIO_UNLISTEN_RSP, sizeof(*resp));
 
-    resp->index = req->index;
+    gpio_set_req_msg_t * req = (gpio_set_req_msg_t *) msg;
+    gpio_set_rsp_msg_t * resp = (gpio_set_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
+            MSG_ID_GPIO_SET_RSP, sizeof(*resp));
 
     uint8_t index = req->index;
     struct device *gpio_dev = get_gpio_dev(svc, &index);
@@ -410,24 +685,225 @@ void handle_unlisten(struct cfw_message *msg, struct gpio_service_data *svc)
         goto send_rsp;
     }
 
-    // Get priv pointer
     switch (svc->svc.service_id) {
 #if defined(CONFIG_SS_GPIO)
         case SS_GPIO_SERVICE_ID:
-            priv = ss_gpio_get_callback_arg(gpio_dev, index);
+            ret = ss_gpio_write(gpio_dev, index, req->state);
             break;
 #endif
 #if defined(CONFIG_SOC_GPIO_32) || defined(CONFIG_SOC_GPIO_AON)
         case SOC_GPIO_SERVICE_ID:
         case AON_GPIO_SERVICE_ID:
-            priv = soc_gpio_get_callback_arg(gpio_dev, index);
+            ret = soc_gpio_write(gpio_dev, index, req->state);
             break;
 #endif
         default:
             ret = DRV_RC_INVALID_CONFIG;
-            goto send_rsp;
             break;
     }
+    resp->rsp_header.status = ret;
+
+send_rsp:
+    cfw_send_message(resp);
+}
+
+void handle_get(struct cfw_message *msg, struct gpio_service_data *svc)
+{
+    DRIVER_API_RC ret;
+    uint32_t port_state;
+
+    gpio_get_rsp_msg_t * resp = (gpio_get_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
+            MSG_ID_GPIO_GET_RSP, sizeof(*resp));
+
+    ret = gpio_read_port(svc, &port_state);
+
+    resp->rsp_header.status = ret;
+    resp->state = ((ret == DRV_RC_OK) ? port_state:0);
+
+    cfw_send_message(resp);
+}
+
+void handle_set_port(struct cfw_message *msg, struct gpio_service_data *svc)
+{
+    DRIVER_API_RC ret;
+    uint32_t port_state = 0;
+
+    gpio_set_port_req_msg_t * req = (gpio_set_port_req_msg_t *) msg;
+    gpio_set_port_rsp_msg_t * resp = (gpio_set_port_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
+            MSG_ID_GPIO_SET_PORT_RSP, sizeof(*resp));
+
+    ret = gpio_update_port(svc, req->op, req->mask, req->value);
+    if (ret == DRV_RC_OK) {
+        ret = gpio_read_port(svc, &port_state);
+    }
+
+    resp->rsp_header.status = ret;
+    resp->state = ((ret == DRV_RC_OK) ? port_state:0);
+
+    cfw_send_message(resp);
+}
+
+void handle_program(struct cfw_message *msg, struct gpio_service_data *svc)
+{
+    DRIVER_API_RC ret = DRV_RC_OK;
+    gpio_program_step_t *step;
+    uint32_t port_state;
+    uint32_t start;
+    uint8_t reads = 0;
+    uint8_t count;
+    uint8_t i;
+
+    gpio_program_req_msg_t * req = (gpio_program_req_msg_t *) msg;
+    gpio_program_rsp_msg_t * resp;
+
+    count = req->count;
+    if ((count > GPIO_PROGRAM_MAX_STEPS) ||
+        (CFW_MESSAGE_LEN(msg) < sizeof(*req) + count * sizeof(req->steps[0]))) {
+        count = 0;
+        ret = DRV_RC_INVALID_CONFIG;
+    }
+
+    // Size the response for the read results
+    for (i = 0; i < count; i++) {
+        if (req->steps[i].op == GPIO_STEP_READ) {
+            reads++;
+        }
+    }
+    resp = (gpio_program_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
+            MSG_ID_GPIO_PROGRAM_RSP, sizeof(*resp) + reads * sizeof(resp->state[0]));
+    resp->done = 0;
+    resp->count = 0;
+
+    // Only the ports with masked port accesses support it
+    if ((svc->svc.service_id != SOC_GPIO_SERVICE_ID) && (svc->svc.service_id != AON_GPIO_SERVICE_ID)) {
+        ret = DRV_RC_INVALID_OPERATION;
+        count = 0;
+    }
+
+    for (i = 0; i < count; i++) {
+        step = &req->steps[i];
+        if (step->delay) {
+            start = get_uptime_32k();
+            while ((uint32_t)(get_uptime_32k() - start) < step->delay);
+        }
+        if (step->op == GPIO_STEP_READ) {
+            if ((ret = gpio_read_port(svc, &port_state)) == DRV_RC_OK) {
+                resp->state[resp->count++] = port_state & step->mask;
+            }
+        } else {
+            ret = gpio_update_port(svc, step->op, step->mask, step->value);
+        }
+        if (ret != DRV_RC_OK) {
+            break;
+        }
+        resp->done++;
+    }
+    resp->rsp_header.status = ret;
+
+    cfw_send_message(resp);
+}
+
+/**
+ * Get the listener of a pin, NULL if the pin is not listened.
+ */
+static struct gpio_service_listen_priv *gpio_get_listener(struct gpio_service_data *svc,
+        struct device *gpio_dev, uint8_t index)
+{
+    switch (svc->svc.service_id) {
+#if defined(CONFIG_SS_GPIO)
+        case SS_GPIO_SERVICE_ID:
+            return ss_gpio_get_callback_arg(gpio_dev, index);
+#endif
+#if defined(CONFIG_SOC_GPIO_32) || defined(CONFIG_SOC_GPIO_AON)
+        case SOC_GPIO_SERVICE_ID:
+        case AON_GPIO_SERVICE_ID:
+            return soc_gpio_get_callback_arg(gpio_dev, index);
+#endif
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Configure a pin to report its interrupts to a listener.
+ */
+static DRIVER_API_RC gpio_listen_pin(struct gpio_service_data *svc, uint8_t pin,
+        struct gpio_service_listen_priv *listener, gpio_service_isr_mode_t mode, uint8_t debounce)
+{
+    DRIVER_API_RC ret;
+    gpio_cfg_data_t config;
+    uint8_t index = pin;
+    struct device *gpio_dev = get_gpio_dev(svc, &index);
+
+    if (!gpio_dev) {
+        return DRV_RC_INVALID_CONFIG;
+    }
+
+    // Default configuration for interrupts
+    gpio_set_default_config(&config);
+
+    config.gpio_type = GPIO_INTERRUPT;
+    config.int_debounce = debounce;
+    config.gpio_cb_arg = listener;
+
+    switch (mode) {
+        case RISING_EDGE:
+            config.int_type = EDGE;
+            config.int_polarity = ACTIVE_HIGH;
+            break;
+        case FALLING_EDGE:
+            config.int_type = EDGE;
+            config.int_polarity = ACTIVE_LOW;
+            break;
+        case DOUBLE_EDGE:
+            config.int_type = DOUBLE_EDGE;
+            config.int_polarity = ACTIVE_HIGH;
+            break;
+        default:
+            pr_error(LOG_MODULE_GPIO_SVC, "%s: unknown mode %d", __FILE__, mode);
+            return DRV_RC_INVALID_CONFIG;
+    }
+
+    switch (svc->svc.service_id) {
+#ifdef CONFIG_SS_GPIO
+        case SS_GPIO_SERVICE_ID:
+            config.gpio_cb = gpio_service_callback;
+            ret = ss_gpio_set_config(gpio_dev, index, &config);
+            break;
+#endif
+#if defined(CONFIG_SOC_GPIO_32) || defined(CONFIG_SOC_GPIO_AON)
+        case SOC_GPIO_SERVICE_ID:
+        case AON_GPIO_SERVICE_ID:
+            // Interrupts are reported by the port callback
+            svc->port_mask |= 1u << pin;
+            soc_gpio_set_port_callback(gpio_dev, svc->port_mask, gpio_service_port_callback, svc);
+            ret = soc_gpio_set_config(gpio_dev, index, &config);
+            if (ret != DRV_RC_OK) {
+                svc->port_mask &= ~(1u << pin);
+                soc_gpio_set_port_callback(gpio_dev, svc->port_mask, gpio_service_port_callback, svc);
+            }
+            break;
+#endif
+        default:
+            ret = DRV_RC_INVALID_CONFIG;
+            break;
+    }
+    return ret;
+}
+
+/**
+ * Stop reporting the interrupts of a pin.
+ */
+static DRIVER_API_RC gpio_unlisten_pin(struct gpio_service_data *svc, uint8_t pin)
+{
+    DRIVER_API_RC ret;
+    gpio_cfg_data_t config;
+    uint8_t index = pin;
+    struct device *gpio_dev = get_gpio_dev(svc, &index);
+
+    if (!gpio_dev) {
+        return DRV_RC_INVALID_CONFIG;
+    }
 
     // Default configuration for interrupts
     gpio_set_default_config(&config);
@@ -442,22 +918,55 @@ void handle_unlisten(struct cfw_message *msg, struct gpio_service_data *svc)
         case SOC_GPIO_SERVICE_ID:
         case AON_GPIO_SERVICE_ID:
             ret = soc_gpio_set_config(gpio_dev, index, &config);
+            if (ret == DRV_RC_OK) {
+                svc->port_mask &= ~(1u << pin);
+                soc_gpio_set_port_callback(gpio_dev, svc->port_mask, gpio_service_port_callback, svc);
+            }
             break;
 #endif
         default:
             ret = DRV_RC_INVALID_CONFIG;
             break;
     }
+    return ret;
+}
 
-    if (ret != DRV_RC_OK) {
+void handle_unlisten(struct cfw_message *msg, struct gpio_service_data *svc)
+{
+    struct gpio_service_listen_priv *priv = NULL;
+    DRIVER_API_RC ret;
+    gpio_unlisten_req_msg_t * req = (gpio_unlisten_req_msg_t *) msg;
+
+    gpio_unlisten_rsp_msg_t * resp = (gpio_unlisten_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
+            MSG_ID_GPIO_UNLISTEN_RSP, sizeof(*resp));
+
+    resp->index = req->index;
+
+    uint8_t index = req->index;
+    struct device *gpio_dev = get_gpio_dev(svc, &index);
+
+    if (!gpio_dev) {
+        // gpio device not found or pin not available
+        resp->rsp_header.status = DRV_RC_INVALID_CONFIG;
+        goto send_rsp;
+    }
+
+    // Get priv pointer
+    priv = gpio_get_listener(svc, gpio_dev, index);
+
+    if ((ret = gpio_unlisten_pin(svc, req->index)) != DRV_RC_OK) {
         // Configuration failed
         resp->rsp_header.status = ret;
         goto send_rsp;
     }
 
-    // Listen is now disabled, free callback argument
+    // Listen is now disabled, free callback argument with its last pin
     if (priv != NULL) {
-        bfree(priv);
+        priv->mask &= ~(1u << req->index);
+        if (priv->mask == 0) {
+            list_remove(&svc->listeners, &priv->list);
+            bfree(priv);
+        }
     }
     resp->rsp_header.status = DRV_RC_OK;
 
@@ -470,7 +979,6 @@ void handle_listen(struct cfw_message *msg, struct gpio_service_data *svc)
     struct gpio_service_listen_priv *priv;
     DRIVER_API_RC ret = DRV_RC_OK;
     OS_ERR_TYPE err;
-    gpio_cfg_data_t config;
     gpio_listen_req_msg_t * req = (gpio_listen_req_msg_t *) msg;
 
     gpio_listen_rsp_msg_t * resp = (gpio_listen_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
@@ -488,24 +996,7 @@ void handle_listen(struct cfw_message *msg, struct gpio_service_data *svc)
     }
 
     // Check that callback argument is NULL for the gpio to listen
-    switch (svc->svc.service_id) {
-#if defined(CONFIG_SS_GPIO)
-        case SS_GPIO_SERVICE_ID:
-            priv = ss_gpio_get_callback_arg(gpio_dev, index);
-            break;
-#endif
-#if defined(CONFIG_SOC_GPIO_32) || defined(CONFIG_SOC_GPIO_AON)
-        case SOC_GPIO_SERVICE_ID:
-        case AON_GPIO_SERVICE_ID:
-            priv = soc_gpio_get_callback_arg(gpio_dev, index);
-            break;
-#endif
-        default:
-            resp->rsp_header.status = DRV_RC_INVALID_CONFIG;
-            goto send_rsp;
-    }
-
-    if (priv != NULL) {
+    if (gpio_get_listener(svc, gpio_dev, index) != NULL) {
         // GPIO pin is already listening, abort
         resp->rsp_header.status = DRV_RC_CONTROLLER_IN_USE;
         goto send_rsp;
@@ -517,63 +1008,93 @@ void handle_listen(struct cfw_message *msg, struct gpio_service_data *svc)
         goto send_rsp;
     }
 
-    priv->priv = ((gpio_listen_req_msg_t*)(msg))->header.priv;
-    priv->conn = ((gpio_listen_req_msg_t*)(msg))->header.conn;
+    priv->svc = svc;
+    priv->priv = req->header.priv;
+    priv->conn = req->header.conn;
     priv->pin = req->index;
+    priv->mask = 1u << req->index;
+    priv->port_evt = 0;
 
-    // Default configuration for interrupts
-    gpio_set_default_config(&config);
+    ret = gpio_listen_pin(svc, req->index, priv, req->mode, req->debounce);
+    if (ret != DRV_RC_OK) {
+        pr_error(LOG_MODULE_GPIO_SVC, "gpio_svc: Failed to configure gpio %d (err=%d)\n", svc->svc.service_id, ret);
+        bfree(priv);
+    } else {
+        list_add(&svc->listeners, &priv->list);
+    }
 
-    config.gpio_type = GPIO_INTERRUPT;
-    config.int_debounce = ((gpio_listen_req_msg_t*)(msg))->debounce;
-    config.gpio_cb = gpio_service_callback;
-    config.gpio_cb_arg = priv;
+    resp->rsp_header.status = ret;
 
-    switch (((gpio_listen_req_msg_t*)(msg))->mode) {
-        case RISING_EDGE:
-            config.int_type = EDGE;
-            config.int_polarity = ACTIVE_HIGH;
-            break;
-        case FALLING_EDGE:
-            config.int_type = EDGE;
-            config.int_polarity = ACTIVE_LOW;
-            break;
-        case DOUBLE_EDGE:
-            config.int_type = DOUBLE_EDGE;
-            config.int_polarity = ACTIVE_HIGH;
-            break;
-        default:
-            pr_error(LOG_MODULE_GPIO_SVC, "%s: unknown mode %d", __FILE__, ((gpio_listen_req_msg_t*)(msg))->mode);
-            ret = DRV_RC_INVALID_CONFIG;
-            goto exit_free_priv;
+send_rsp:
+    cfw_send_message(resp);
+}
+
+void handle_listen_port(struct cfw_message *msg, struct gpio_service_data *svc)
+{
+    struct gpio_service_listen_priv *priv;
+    DRIVER_API_RC ret = DRV_RC_OK;
+    OS_ERR_TYPE err;
+    struct device *gpio_dev;
+    uint32_t pins;
+    uint8_t index;
+    gpio_listen_port_req_msg_t * req = (gpio_listen_port_req_msg_t *) msg;
+
+    gpio_listen_port_rsp_msg_t * resp = (gpio_listen_port_rsp_msg_t * ) cfw_alloc_rsp_msg(msg,
+            MSG_ID_GPIO_LISTEN_PORT_RSP, sizeof(*resp));
+
+    resp->mask = req->mask;
+
+    // Only the ports with a port callback support it
+    if ((svc->svc.service_id != SOC_GPIO_SERVICE_ID) && (svc->svc.service_id != AON_GPIO_SERVICE_ID)) {
+        resp->rsp_header.status = DRV_RC_INVALID_OPERATION;
+        goto send_rsp;
+    }
+    if (req->mask == 0) {
+        resp->rsp_header.status = DRV_RC_INVALID_CONFIG;
+        goto send_rsp;
     }
 
-    switch (svc->svc.service_id) {
-#ifdef CONFIG_SS_GPIO
-        case SS_GPIO_SERVICE_ID:
-            ret = ss_gpio_set_config(gpio_dev, index, &config);
-            break;
-#endif
-#if defined(CONFIG_SOC_GPIO_32) || defined(CONFIG_SOC_GPIO_AON)
-        case SOC_GPIO_SERVICE_ID:
-        case AON_GPIO_SERVICE_ID:
-            ret = soc_gpio_set_config(gpio_dev, index, &config);
-            break;
-#endif
-        default:
-            ret = DRV_RC_INVALID_CONFIG;
-            break;
+    // Check that the pins exist and are not listened yet
+    for (pins = req->mask; pins; pins &= pins - 1) {
+        index = __builtin_ctz(pins);
+        if (!(gpio_dev = get_gpio_dev(svc, &index))) {
+            resp->rsp_header.status = DRV_RC_INVALID_CONFIG;
+            goto send_rsp;
+        }
+        if (gpio_get_listener(svc, gpio_dev, index) != NULL) {
+            resp->rsp_header.status = DRV_RC_CONTROLLER_IN_USE;
+            goto send_rsp;
+        }
     }
 
-    if (ret != DRV_RC_OK) {
-        pr_error(LOG_MODULE_GPIO_SVC, "gpio_svc: Failed to configure gpio %d (err=%d)\n", svc->svc.service_id, ret);
+    // Alloc priv data for service, shared by the pins
+    if((priv = balloc(sizeof(struct gpio_service_listen_priv), &err)) == NULL) {
+        resp->rsp_header.status = err;
+        goto send_rsp;
     }
 
-    resp->rsp_header.status = ret;
-    goto send_rsp;
+    priv->svc = svc;
+    priv->priv = req->header.priv;
+    priv->conn = req->header.conn;
+    priv->pin = __builtin_ctz(req->mask);
+    priv->mask = req->mask;
+    priv->port_evt = 1;
+
+    for (pins = req->mask; pins; pins &= pins - 1) {
+        index = __builtin_ctz(pins);
+        if ((ret = gpio_listen_pin(svc, index, priv, req->mode, req->debounce)) != DRV_RC_OK) {
+            // Release the pins already configured
+            for (pins = req->mask & ((1u << index) - 1); pins; pins &= pins - 1) {
+                gpio_unlisten_pin(svc, __builtin_ctz(pins));
+            }
+            bfree(priv);
+            resp->rsp_header.status = ret;
+            goto send_rsp;
+        }
+    }
+    list_add(&svc->listeners, &priv->list);
+    resp->rsp_header.status = DRV_RC_OK;
 
-exit_free_priv:
-    bfree(priv);
 send_rsp:
     cfw_send_message(resp);
 }
@@ -586,18 +1107,33 @@ static void gpio_handle_message(struct cfw_message * msg, void * param)
     case MSG_ID_GPIO_CONFIGURE_REQ:
         handle_configure(msg, gpio_svc);
         break;
+    case MSG_ID_GPIO_CONFIGURE_PORT_REQ:
+        handle_configure_port(msg, gpio_svc);
+        break;
     case MSG_ID_GPIO_SET_REQ:
         handle_set(msg, gpio_svc);
         break;
     case MSG_ID_GPIO_GET_REQ:
         handle_get(msg, gpio_svc);
         break;
+    case MSG_ID_GPIO_SET_PORT_REQ:
+        handle_set_port(msg, gpio_svc);
+        break;
+    case MSG_ID_GPIO_PROGRAM_REQ:
+        handle_program(msg, gpio_svc);
+        break;
     case MSG_ID_GPIO_LISTEN_REQ:
         handle_listen(msg, gpio_svc);
         break;
     case MSG_ID_GPIO_UNLISTEN_REQ:
         handle_unlisten(msg, gpio_svc);
         break;
+    case MSG_ID_GPIO_LISTEN_PORT_REQ:
+        handle_listen_port(msg, gpio_svc);
+        break;
+    case MSG_ID_GPIO_EVT_DRAIN:
+        handle_evt_drain(gpio_svc);
+        break;
     default:
         pr_error(LOG_MODULE_GPIO_SVC, "gpio_srv %d: unexpected message id: %x",
                 ((conn_handle_t*)(msg->conn))->svc->service_id, CFW_MESSAGE_ID(msg));
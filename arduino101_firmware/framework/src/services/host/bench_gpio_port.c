@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Throughput of the GPIO service for a bit banged serial bus, on the
+ * models of gpio_sim.c, in simulated time: a clock pin, a data output and
+ * a data input, a device model shifting a bit in at each rising edge of the
+ * clock and the next bit out at each falling edge. The client sends a
+ * request once it has the response to the previous one, as a sketch does:
+ *  - per pin: a set request per pin change, a get request per bit read,
+ *  - port: masked port writes, the response of the clock rising one
+ *    giving the port state to sample,
+ *  - program: the steps of a byte (half a byte when reading) in a single
+ *    program request.
+ * Each bit takes three pin operations (data or read, clock high, clock
+ * low), which give the pin ops/s. The time of the service code is not
+ * modelled, the task wakeups (SIM_WAKEUP_US) dominating it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gpio_sim.h"
+#include "services/gpio_service.h"
+
+#define CLK_PIN      0
+#define MOSI_PIN     1
+#define MISO_PIN     2
+#define CLK          (1u << CLK_PIN)
+#define MOSI         (1u << MOSI_PIN)
+#define MISO         (1u << MISO_PIN)
+
+#define BYTES        1000
+#define BITS         (BYTES * 8)
+
+enum mode {
+    MODE_PIN,
+    MODE_PORT,
+    MODE_PROGRAM,
+};
+
+static const char *const mode_names[] = { "per pin", "port", "program" };
+
+/* Client */
+static enum mode mode;
+static int reading;
+static unsigned int bit;        /* next bit of the transfer */
+static unsigned int phase;      /* next request of the bit */
+static unsigned int requests;
+static int done;
+static uint64_t done_us;
+static uint8_t rx[BYTES];       /* bytes read by the client */
+
+/* Device */
+static uint32_t clk;
+static unsigned int dev_bit;
+static uint8_t dev_rx[BYTES];   /* bytes written by the client */
+
+static uint8_t pattern(unsigned int byte)
+{
+    return byte * 37 + 11;
+}
+
+static int bit_of(unsigned int n)
+{
+    return (pattern(n / 8) >> (7 - n % 8)) & 1;
+}
+
+static void device(uint32_t levels)
+{
+    if ((levels & CLK) && !clk) {
+        if (dev_bit < BITS && (levels & MOSI)) {
+            dev_rx[dev_bit / 8] |= 0x80 >> (dev_bit % 8);
+        }
+    } else if (!(levels & CLK) && clk) {
+        dev_bit++;
+        sim_edges(MISO, dev_bit < BITS && bit_of(dev_bit) ? MISO : 0);
+    }
+    clk = levels & CLK;
+}
+
+static void sample(uint32_t state)
+{
+    if (state & MISO) {
+        rx[bit / 8] |= 0x80 >> (bit % 8);
+    }
+}
+
+static void *request(int size)
+{
+    OS_ERR_TYPE err;
+    void *req = cfw_alloc_message(size, &err);
+
+    if (req == NULL) {
+        printf("no message for a request\n");
+        exit(1);
+    }
+    requests++;
+    return req;
+}
+
+static void set_pin(uint8_t index, uint8_t state)
+{
+    gpio_set_req_msg_t *req = request(sizeof(*req));
+
+    req->index = index;
+    req->state = state;
+    sim_request(&req->header, MSG_ID_GPIO_SET_REQ, sizeof(*req));
+}
+
+static void set_port(uint8_t op, uint32_t mask, uint32_t value)
+{
+    gpio_set_port_req_msg_t *req = request(sizeof(*req));
+
+    req->op = op;
+    req->mask = mask;
+    req->value = value;
+    sim_request(&req->header, MSG_ID_GPIO_SET_PORT_REQ, sizeof(*req));
+}
+
+static void program(void)
+{
+    unsigned int bits = reading ? 4 : 8;
+    unsigned int steps = reading ? 3 * bits : 2 * bits;
+    gpio_program_req_msg_t *req = request(sizeof(*req) + steps * sizeof(req->steps[0]));
+    gpio_program_step_t *step = req->steps;
+    unsigned int i;
+
+    for (i = bit; i < bit + bits; i++) {
+        if (reading) {
+            *step++ = (gpio_program_step_t) { .op = GPIO_PORT_SET, .mask = CLK };
+            *step++ = (gpio_program_step_t) { .op = GPIO_STEP_READ, .mask = MISO };
+            *step++ = (gpio_program_step_t) { .op = GPIO_PORT_CLEAR, .mask = CLK };
+        } else {
+            // Data with the clock low, then the clock high
+            *step++ = (gpio_program_step_t) { .op = GPIO_PORT_WRITE, .mask = CLK | MOSI,
+                                              .value = bit_of(i) ? MOSI : 0 };
+            *step++ = (gpio_program_step_t) { .op = GPIO_PORT_SET, .mask = CLK };
+        }
+    }
+    req->count = steps;
+    sim_request(&req->header, MSG_ID_GPIO_PROGRAM_REQ,
+                sizeof(*req) + steps * sizeof(req->steps[0]));
+}
+
+/* Send the next request, the bit or the phase being already advanced */
+static void send_next(void)
+{
+    if (bit == BITS) {
+        if (mode != MODE_PIN && !reading && phase == 0) {
+            // Clock low after the last bit
+            set_port(GPIO_PORT_CLEAR, CLK, 0);
+            phase = 1;
+        } else {
+            done = 1;
+            done_us = sim_now();
+        }
+        return;
+    }
+    switch (mode) {
+    case MODE_PIN:
+        if (phase == 0) {
+            if (reading) {
+                set_pin(CLK_PIN, 1);
+            } else {
+                set_pin(MOSI_PIN, bit_of(bit));
+            }
+        } else if (phase == 1) {
+            if (reading) {
+                gpio_get_req_msg_t *req = request(sizeof(*req));
+
+                sim_request(&req->header, MSG_ID_GPIO_GET_REQ, sizeof(*req));
+            } else {
+                set_pin(CLK_PIN, 1);
+            }
+        } else {
+            set_pin(CLK_PIN, 0);
+        }
+        break;
+    case MODE_PORT:
+        if (reading) {
+            set_port(phase == 0 ? GPIO_PORT_SET : GPIO_PORT_CLEAR, CLK, 0);
+        } else if (phase == 0) {
+            set_port(GPIO_PORT_WRITE, CLK | MOSI, bit_of(bit) ? MOSI : 0);
+        } else {
+            set_port(GPIO_PORT_SET, CLK, 0);
+        }
+        break;
+    case MODE_PROGRAM:
+        program();
+        break;
+    }
+}
+
+static void client(struct cfw_message *msg)
+{
+    struct cfw_rsp_message *rsp = (struct cfw_rsp_message *)msg;
+    gpio_program_rsp_msg_t *prog = (gpio_program_rsp_msg_t *)msg;
+    unsigned int phases;
+    unsigned int i;
+
+    if (rsp->status != DRV_RC_OK) {
+        printf("request %x failed: %d\n", CFW_MESSAGE_ID(msg), rsp->status);
+        exit(1);
+    }
+    if (bit == BITS) {
+        phase++;
+        cfw_msg_free(msg);
+        send_next();
+        return;
+    }
+    switch (CFW_MESSAGE_ID(msg)) {
+    case MSG_ID_GPIO_CONFIGURE_PORT_RSP:
+        // The transfer starts once the pins are configured
+        cfw_msg_free(msg);
+        return;
+    case MSG_ID_GPIO_GET_RSP:
+        sample(((gpio_get_rsp_msg_t *)msg)->state);
+        phase++;
+        break;
+    case MSG_ID_GPIO_SET_PORT_RSP:
+        if (reading && phase == 0) {
+            sample(((gpio_set_port_rsp_msg_t *)msg)->state);
+        }
+        phase++;
+        break;
+    case MSG_ID_GPIO_PROGRAM_RSP:
+        for (i = 0; i < prog->count; i++, bit++) {
+            sample(prog->state[i]);
+        }
+        if (!reading) {
+            bit += 8;
+        }
+        break;
+    default:
+        phase++;
+        break;
+    }
+    phases = mode == MODE_PIN ? 3 : 2;
+    if (phase == phases) {
+        phase = 0;
+        bit++;
+    }
+    if (bit == BITS) {
+        phase = 0;
+    }
+    cfw_msg_free(msg);
+    send_next();
+}
+
+static void run(enum mode m, int read)
+{
+    gpio_configure_port_req_msg_t *req;
+    unsigned int errors = 0;
+    uint64_t start;
+    unsigned int accesses;
+    double us;
+    unsigned int i;
+
+    if (sim_init(client) != 0) {
+        printf("simulator initialization failed\n");
+        exit(1);
+    }
+    mode = m;
+    reading = read;
+    bit = 0;
+    phase = 0;
+    done = 0;
+    memset(rx, 0, sizeof(rx));
+    memset(dev_rx, 0, sizeof(dev_rx));
+    clk = 0;
+    dev_bit = 0;
+    sim_watch_outputs(device);
+    sim_edges(MISO, bit_of(0) ? MISO : 0);
+
+    req = request(sizeof(*req));
+    req->mask = CLK | MOSI;
+    req->mode = 1;
+    sim_request(&req->header, MSG_ID_GPIO_CONFIGURE_PORT_REQ, sizeof(*req));
+    sim_run_until(1000);
+
+    start = sim_now();
+    requests = 0;
+    accesses = sim_stats.reg_accesses;
+    send_next();
+    while (!done) {
+        sim_run_until(sim_now() + 1000);
+    }
+    us = done_us - start;
+
+    for (i = 0; i < BYTES; i++) {
+        if ((read ? rx[i] : dev_rx[i]) != pattern(i)) {
+            errors++;
+        }
+    }
+    if (dev_bit != BITS) {
+        errors++;
+    }
+    printf("%-8s %-5s %6.0f pin ops/s, %6.1f bytes/s, %5.2f requests/byte, "
+           "%5.1f register accesses/byte\n",
+           mode_names[m], read ? "read" : "write", 3.0 * BITS * 1000000 / us,
+           BYTES * 1000000 / us, (double)requests / BYTES,
+           (double)(sim_stats.reg_accesses - accesses) / BYTES);
+    if (errors) {
+        printf("%u bytes corrupted\n", errors);
+        exit(1);
+    }
+}
+
+int main(void)
+{
+    int read;
+
+    for (read = 0; read <= 1; read++) {
+        run(MODE_PIN, read);
+        run(MODE_PORT, read);
+        run(MODE_PROGRAM, read);
+    }
+    return 0;
+}
@@ -0,0 +1,499 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * GPIO port, task and component framework models for the host build of
+ * soc_gpio.c and gpio_service.c, see gpio_sim.h.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gpio_sim.h"
+#include "machine.h"
+#include "drivers/soc_gpio.h"
+#include "services/gpio_service.h"
+#include "services/services_ids.h"
+#include "infra/log.h"
+#include "infra/time.h"
+#include "os/os.h"
+
+#define MAX_EVENTS      16
+#define SERVICE_PORT    1
+#define CLIENT_PORT     2
+
+struct sim_event {
+    uint64_t at;
+    uint64_t seq;               /* events due at the same time run in order */
+    void (*fn)(void *arg);
+    void *arg;
+};
+
+struct sim_task {
+    list_head_t queue;
+    int scheduled;
+    uint64_t stall_until;
+    void (*handler)(struct cfw_message *msg, void *data);
+    void *data;
+};
+
+struct sim_timer {
+    T_ENTRY_POINT callback;
+    void *priv;
+    int event;                  /* pending event, -1 if stopped */
+};
+
+struct sim_stats sim_stats;
+conn_handle_t sim_conn;
+
+static struct sim_event events[MAX_EVENTS];
+static int event_count;
+static uint64_t event_seq;
+static uint64_t now_us;
+
+static uint32_t regs[0x80 / 4];
+static uint32_t inputs;
+static uint32_t outputs;
+static void (*watch_outputs)(uint32_t levels);
+
+static struct sim_task service_task;
+static struct sim_task client_task;
+static void (*client_handler)(struct cfw_message *msg);
+static unsigned int messages_used;
+
+static gpio_callback_fn gpio_cb[SOC_GPIO_32_BITS];
+static void *gpio_cb_arg[SOC_GPIO_32_BITS];
+static gpio_info_t gpio_info = {
+    .reg_base = SOC_GPIO_BASE_ADDR,
+    .no_bits = SOC_GPIO_32_BITS,
+    .gpio_int_mask = INT_GPIO_MASK,
+    .vector = SOC_GPIO_INTERRUPT,
+    .gpio_isr = gpio_isr,
+    .gpio_cb = gpio_cb,
+    .gpio_cb_arg = gpio_cb_arg
+};
+static struct device gpio_dev = {
+    .id = SOC_GPIO_32_ID,
+    .driver = &soc_gpio_driver,
+    .priv = &gpio_info
+};
+
+static void sim_error(const char *error)
+{
+    fprintf(stderr, "gpio simulator: %s\n", error);
+    exit(2);
+}
+
+/* Events */
+
+static int schedule(uint64_t at, void (*fn)(void *), void *arg)
+{
+    int i;
+
+    if (event_count == MAX_EVENTS) {
+        sim_error("too many pending events");
+    }
+    for (i = 0; i < MAX_EVENTS; i++) {
+        if (events[i].fn == NULL) {
+            events[i].at = at < now_us ? now_us : at;
+            events[i].seq = event_seq++;
+            events[i].fn = fn;
+            events[i].arg = arg;
+            event_count++;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void cancel(int event)
+{
+    events[event].fn = NULL;
+    event_count--;
+}
+
+/* Run the next event if it is due before the deadline, return 0 if none */
+static int run_next(uint64_t deadline)
+{
+    void (*fn)(void *);
+    void *arg;
+    int next = -1;
+    int i;
+
+    for (i = 0; i < MAX_EVENTS; i++) {
+        if (events[i].fn != NULL &&
+            (next < 0 || events[i].at < events[next].at ||
+             (events[i].at == events[next].at && events[i].seq < events[next].seq))) {
+            next = i;
+        }
+    }
+    if (next < 0 || events[next].at > deadline) {
+        return 0;
+    }
+    now_us = events[next].at;
+    fn = events[next].fn;
+    arg = events[next].arg;
+    cancel(next);
+    fn(arg);
+    return 1;
+}
+
+uint64_t sim_now(void)
+{
+    return now_us;
+}
+
+void sim_at(uint64_t at, void (*fn)(void *), void *arg)
+{
+    schedule(at, fn, arg);
+}
+
+void sim_run_until(uint64_t end)
+{
+    while (run_next(end)) {
+    }
+    now_us = end;
+}
+
+/* GPIO port */
+
+/* Report the last write of the data register */
+static void check_outputs(void)
+{
+    if (regs[SOC_GPIO_SWPORTA_DR / 4] != outputs) {
+        outputs = regs[SOC_GPIO_SWPORTA_DR / 4];
+        if (watch_outputs) {
+            watch_outputs(outputs);
+        }
+    }
+}
+
+volatile uint32_t *gpio_sim_reg(uint32_t addr)
+{
+    uint32_t offset = addr - SOC_GPIO_BASE_ADDR;
+    uint32_t *r = regs;
+
+    if (offset >= sizeof(regs) || (offset & 3)) {
+        sim_error("access outside of the GPIO registers");
+    }
+    check_outputs();
+    sim_stats.reg_accesses++;
+    if (offset == SOC_GPIO_EXT_PORTA) {
+        sim_stats.port_reads++;
+        r[SOC_GPIO_EXT_PORTA / 4] = (inputs & ~r[SOC_GPIO_SWPORTA_DDR / 4]) |
+            (r[SOC_GPIO_SWPORTA_DR / 4] & r[SOC_GPIO_SWPORTA_DDR / 4]);
+    }
+    return &r[offset / 4];
+}
+
+void sim_watch_outputs(void (*fn)(uint32_t levels))
+{
+    watch_outputs = fn;
+}
+
+void sim_edges(uint32_t mask, uint32_t levels)
+{
+    uint32_t *r = regs;
+    uint32_t old = inputs;
+    uint32_t new = (old & ~mask) | (levels & mask);
+    uint32_t rising = new & ~old;
+    uint32_t falling = old & ~new;
+    uint32_t edge = r[SOC_GPIO_INTEN / 4] & r[SOC_GPIO_INTTYPE_LEVEL / 4];
+    uint32_t both = r[SOC_GPIO_INT_BOTHEDGE / 4];
+    uint32_t high = r[SOC_GPIO_INTPOLARITY / 4];
+
+    inputs = new;
+    r[SOC_GPIO_INTSTATUS / 4] |= edge & ((rising & (both | high)) | (falling & (both | ~high)));
+    r[SOC_GPIO_INTSTATUS / 4] &= ~r[SOC_GPIO_INTMASK / 4];
+
+    if (r[SOC_GPIO_INTSTATUS / 4]) {
+        sim_stats.irqs++;
+        gpio_isr();
+        // End of interrupt: the bits written to EOI are cleared
+        r[SOC_GPIO_INTSTATUS / 4] &= ~r[SOC_GPIO_PORTA_EOI / 4];
+        r[SOC_GPIO_PORTA_EOI / 4] = 0;
+    }
+}
+
+/* Tasks */
+
+static void task_run(void *arg)
+{
+    struct sim_task *task = arg;
+    struct message *msg;
+
+    if (now_us < task->stall_until) {
+        schedule(task->stall_until, task_run, task);
+        return;
+    }
+    task->scheduled = 0;
+    if (task == &service_task) {
+        sim_stats.service_runs++;
+    }
+    while ((msg = (struct message *)list_get(&task->queue)) != NULL) {
+        task->handler((struct cfw_message *)msg, task->data);
+        check_outputs();
+    }
+}
+
+static void task_post(struct sim_task *task, struct cfw_message *msg)
+{
+    list_add(&task->queue, &msg->m.l);
+    if (!task->scheduled) {
+        task->scheduled = 1;
+        schedule(now_us + SIM_WAKEUP_US, task_run, task);
+    }
+}
+
+void sim_stall_service(uint64_t until)
+{
+    service_task.stall_until = until;
+}
+
+void sim_stall_client(uint64_t until)
+{
+    client_task.stall_until = until;
+}
+
+static void client_handle_message(struct cfw_message *msg, void *data)
+{
+    client_handler(msg);
+}
+
+/* Component framework */
+
+int cfw_register_service(T_QUEUE queue, service_t *svc,
+                         handle_msg_cb_t handle_message, void *data)
+{
+    svc->port_id = SERVICE_PORT;
+    service_task.handler = handle_message;
+    service_task.data = data;
+    sim_conn.svc = svc;
+    return 0;
+}
+
+struct cfw_message *cfw_alloc_message(int size, OS_ERR_TYPE *err)
+{
+    struct cfw_message *msg = NULL;
+
+    if (messages_used < SIM_MESSAGES) {
+        msg = calloc(1, size);
+        messages_used++;
+        sim_stats.messages++;
+        if (messages_used > sim_stats.max_messages) {
+            sim_stats.max_messages = messages_used;
+        }
+    } else {
+        sim_stats.no_message++;
+    }
+    if (err) {
+        *err = msg ? E_OS_OK : E_OS_ERR_NO_MEMORY;
+    }
+    return msg;
+}
+
+struct cfw_rsp_message *cfw_alloc_rsp_msg(const struct cfw_message *req, int msg_id, int size)
+{
+    struct cfw_rsp_message *rsp = (struct cfw_rsp_message *)cfw_alloc_message(size, NULL);
+
+    if (rsp == NULL) {
+        sim_error("no message for a response");
+    }
+    CFW_MESSAGE_TYPE(&rsp->header) = TYPE_RSP;
+    CFW_MESSAGE_ID(&rsp->header) = msg_id;
+    CFW_MESSAGE_LEN(&rsp->header) = size;
+    CFW_MESSAGE_DST(&rsp->header) = CFW_MESSAGE_SRC(req);
+    CFW_MESSAGE_SRC(&rsp->header) = CFW_MESSAGE_DST(req);
+    rsp->header.priv = req->priv;
+    rsp->header.conn = NULL;
+    return rsp;
+}
+
+void cfw_msg_free(struct cfw_message *msg)
+{
+    free(msg);
+    messages_used--;
+}
+
+int _cfw_send_message(struct cfw_message *msg)
+{
+    switch (CFW_MESSAGE_DST(msg)) {
+    case SERVICE_PORT:
+        task_post(&service_task, msg);
+        break;
+    case CLIENT_PORT:
+        task_post(&client_task, msg);
+        break;
+    default:
+        sim_error("message to an unknown port");
+    }
+    return 0;
+}
+
+void sim_request(struct cfw_message *msg, uint16_t msg_id, int len)
+{
+    CFW_MESSAGE_ID(msg) = msg_id;
+    CFW_MESSAGE_LEN(msg) = len;
+    CFW_MESSAGE_TYPE(msg) = TYPE_REQ;
+    CFW_MESSAGE_SRC(msg) = CLIENT_PORT;
+    CFW_MESSAGE_DST(msg) = SERVICE_PORT;
+    CFW_MESSAGE_CONN(msg) = &sim_conn;
+    CFW_MESSAGE_PRIV(msg) = NULL;
+    _cfw_send_message(msg);
+}
+
+/* OS layer and infra */
+
+uint32_t interrupt_lock(void)
+{
+    return 0;
+}
+
+void interrupt_unlock(uint32_t key)
+{
+}
+
+void *balloc(uint32_t size, OS_ERR_TYPE *err)
+{
+    if (err) {
+        *err = E_OS_OK;
+    }
+    return malloc(size);
+}
+
+OS_ERR_TYPE bfree(void *buffer)
+{
+    free(buffer);
+    return E_OS_OK;
+}
+
+uint32_t get_uptime_ms(void)
+{
+    return now_us / 1000;
+}
+
+uint32_t get_uptime_32k(void)
+{
+    return now_us * 32768 / 1000000;
+}
+
+static void timer_expire(void *arg)
+{
+    struct sim_timer *timer = arg;
+
+    timer->event = -1;
+    timer->callback(timer->priv);
+}
+
+T_TIMER timer_create(T_ENTRY_POINT callback, void *privData, uint32_t delay,
+                     bool repeat, bool startup, OS_ERR_TYPE *err)
+{
+    struct sim_timer *timer = calloc(1, sizeof(*timer));
+
+    timer->callback = callback;
+    timer->priv = privData;
+    timer->event = -1;
+    if (startup) {
+        timer_start(timer, delay, err);
+    } else if (err) {
+        *err = E_OS_OK;
+    }
+    return timer;
+}
+
+void timer_start(T_TIMER tmr, uint32_t delay, OS_ERR_TYPE *err)
+{
+    struct sim_timer *timer = tmr;
+
+    if (timer->event >= 0) {
+        cancel(timer->event);
+    }
+    timer->event = schedule(now_us + (uint64_t)delay * 1000, timer_expire, timer);
+    if (err) {
+        *err = E_OS_OK;
+    }
+}
+
+void timer_stop(T_TIMER tmr, OS_ERR_TYPE *err)
+{
+    struct sim_timer *timer = tmr;
+
+    if (timer->event >= 0) {
+        cancel(timer->event);
+        timer->event = -1;
+    }
+}
+
+struct device *get_device(uint8_t id)
+{
+    return id == SOC_GPIO_32_ID ? &gpio_dev : NULL;
+}
+
+void panic(int err)
+{
+    sim_stats.panics++;
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    return 0;
+}
+
+/* Setup */
+
+int sim_init(void (*handler)(struct cfw_message *msg))
+{
+    memset(events, 0, sizeof(events));
+    event_count = 0;
+    event_seq = 0;
+    now_us = 0;
+    memset(regs, 0, sizeof(regs));
+    inputs = 0;
+    outputs = 0;
+    watch_outputs = NULL;
+    memset(&sim_stats, 0, sizeof(sim_stats));
+    messages_used = 0;
+
+    memset(&service_task, 0, sizeof(service_task));
+    memset(&client_task, 0, sizeof(client_task));
+    client_task.handler = client_handle_message;
+    client_handler = handler;
+    memset(&sim_conn, 0, sizeof(sim_conn));
+    sim_conn.client_port = CLIENT_PORT;
+
+    if (gpio_dev.driver->init(&gpio_dev) != 0) {
+        return -1;
+    }
+    gpio_service_init(NULL, SOC_GPIO_SERVICE_ID);
+    return sim_conn.svc != NULL ? 0 : -1;
+}
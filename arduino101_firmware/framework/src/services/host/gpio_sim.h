@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of soc_gpio.c and gpio_service.c: the SOC 32 bits GPIO port is
+ * modelled on a simulated clock, with the service and its client as tasks
+ * exchanging messages through a stub of the component framework.
+ *
+ * sim_edges() changes the levels of the input pins: the pins configured for
+ * an interrupt on that edge raise the port interrupt, which runs at once
+ * unless another event is running. The output pins read back the data
+ * register, and sim_watch_outputs() reports their changes. A message sent to a task makes it run SIM_WAKEUP_US
+ * later, handling its queued messages in order. Messages come from a pool
+ * of SIM_MESSAGES blocks, as the 32 byte pool of the arduino101 Quark
+ * image, other blocks from the C library heap. Timers expire after their
+ * delay in ms, as with the 1 ms system tick.
+ *
+ * Each event runs to completion: an interrupt does not preempt a task.
+ */
+
+#ifndef __GPIO_SIM_H__
+#define __GPIO_SIM_H__
+
+#include <stdint.h>
+#include "cfw/cfw.h"
+#include "cfw/cfw_service.h"
+
+#define SIM_WAKEUP_US     50
+#define SIM_MESSAGES      32
+
+struct sim_stats {
+    unsigned int irqs;          /* port interrupts */
+    unsigned int port_reads;    /* EXT_PORTA reads */
+    unsigned int reg_accesses;  /* GPIO register accesses */
+    unsigned int messages;      /* messages allocated */
+    unsigned int max_messages;  /* messages allocated at once */
+    unsigned int no_message;    /* failed message allocations */
+    unsigned int service_runs;  /* wakeups of the service task */
+    unsigned int panics;
+};
+
+extern struct sim_stats sim_stats;
+
+/** Connection of the client to the service */
+extern conn_handle_t sim_conn;
+
+/**
+ * Return the simulated time in us.
+ */
+uint64_t sim_now(void);
+
+/**
+ * Run fn(arg) at the simulated time at.
+ */
+void sim_at(uint64_t at, void (*fn)(void *arg), void *arg);
+
+/**
+ * Run the pending events due before end, then set the time to end.
+ */
+void sim_run_until(uint64_t end);
+
+/**
+ * Set the levels of the pins of mask, interrupting on the configured edges.
+ */
+void sim_edges(uint32_t mask, uint32_t levels);
+
+/**
+ * Call fn with the output levels after each change of the data register,
+ * NULL to stop. A change is reported at the next register access, or when
+ * the task which made it has handled its message.
+ */
+void sim_watch_outputs(void (*fn)(uint32_t levels));
+
+/**
+ * Keep the service (or the client) task from running until the time until.
+ */
+void sim_stall_service(uint64_t until);
+void sim_stall_client(uint64_t until);
+
+/**
+ * Send a request of the client to the service.
+ */
+void sim_request(struct cfw_message *msg, uint16_t msg_id, int len);
+
+/**
+ * Reset the clock, the port and the statistics, and initialize the GPIO
+ * driver and service. handler receives the messages of the service to the
+ * client, and frees them.
+ *
+ * @return 0 on success
+ */
+int sim_init(void (*handler)(struct cfw_message *msg));
+
+#endif /* __GPIO_SIM_H__ */
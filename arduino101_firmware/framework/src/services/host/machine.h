@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host replacement of the machine header: the SoC definitions used by
+ * soc_gpio.c and gpio_service.c, with the GPIO registers of the SOC 32 bits
+ * port routed to the model of gpio_sim.c.
+ */
+
+#ifndef _MACHINE_H_
+#define _MACHINE_H_
+
+#include <stdint.h>
+#include "soc_config.h"
+
+#define SOC_GPIO_BASE_ADDR              0xB0000C00
+#define SOC_GPIO_SWPORTA_DR             0x00
+#define SOC_GPIO_SWPORTA_DDR            0x04
+#define SOC_GPIO_SWPORTA_CTL            0x08
+#define SOC_GPIO_INTEN                  0x30
+#define SOC_GPIO_INTMASK                0x34
+#define SOC_GPIO_INTTYPE_LEVEL          0x38
+#define SOC_GPIO_INTPOLARITY            0x3c
+#define SOC_GPIO_INTSTATUS              0x40
+#define SOC_GPIO_RAW_INTSTATUS          0x44
+#define SOC_GPIO_DEBOUNCE               0x48
+#define SOC_GPIO_PORTA_EOI              0x4c
+#define SOC_GPIO_EXT_PORTA              0x50
+#define SOC_GPIO_LS_SYNC                0x60
+#define SOC_GPIO_INT_BOTHEDGE           0x68
+#define SOC_GPIO_CONFIG_REG2            0x70
+#define SOC_GPIO_CONFIG_REG1            0x74
+
+#define SOC_GPIO_INTERRUPT              (8)
+#define INT_GPIO_MASK                   (0x46C)
+
+/* The simulator calls the interrupt routine */
+#define DECLARE_INTERRUPT_HANDLER
+#define SET_INTERRUPT_HANDLER(_vec_, _isr_)
+#define SOC_UNMASK_INTERRUPTS(_driver_)
+
+/** Register of the GPIO model at the SoC address, see gpio_sim.h */
+volatile uint32_t *gpio_sim_reg(uint32_t addr);
+
+#define MMIO_REG_VAL_FROM_BASE(base, offset) \
+		(*gpio_sim_reg((uint32_t)((base) + (offset))))
+
+/* The callers cast a 32 bits SoC address to a pointer */
+#define MMIO_BIT(reg, expr) \
+	do { \
+		_Pragma("GCC diagnostic push") \
+		_Pragma("GCC diagnostic ignored \"-Wint-to-pointer-cast\"") \
+		*gpio_sim_reg((uint32_t)(uintptr_t)(reg)) expr; \
+		_Pragma("GCC diagnostic pop") \
+	} while (0)
+
+#define SET_MMIO_BIT(reg, bit)      MMIO_BIT(reg, |= 1u << (bit))
+#define CLEAR_MMIO_BIT(reg, bit)    MMIO_BIT(reg, &= ~(1u << (bit)))
+
+#endif
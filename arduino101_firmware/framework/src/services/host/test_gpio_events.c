@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Load test of the GPIO interrupt event path of soc_gpio.c and
+ * gpio_service.c, on the models of gpio_sim.c, with edges at 100 kHz on a
+ * pin, built with and without a coalescing window
+ * (CONFIG_GPIO_SERVICE_EVT_WINDOW):
+ *  - a port listener gets one event per batch of interrupts, with no
+ *    interrupt or event lost, the levels of the last interrupt, and the
+ *    changes of a slower pin of the port; the port is read once per
+ *    interrupt,
+ *  - a pin listener gets an event per interrupt, with the level at that
+ *    interrupt (without window only),
+ *  - when the client or the service stalls, the lost events and interrupts
+ *    are counted instead of a panic, and the events resume afterwards.
+ * Each case runs in its own process, as the service keeps its state in
+ * statics.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "gpio_sim.h"
+#include "services/gpio_service.h"
+
+#ifdef CONFIG_GPIO_SERVICE_EVT_WINDOW
+#define TEST_NAME "test_gpio_events_window"
+#else
+#define TEST_NAME "test_gpio_events"
+#endif
+
+#define FAST_PIN     3
+#define SLOW_PIN     7
+#define FAST_US      10         /* 100 kHz */
+#define SLOW_US      500
+#define DURATION_US  1000000
+/* Time for the pending interrupts to be reported */
+#define SETTLE_US    20000
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* Edges */
+static uint64_t edges_end;
+static uint32_t levels;
+static unsigned int fast_edges;
+static unsigned int slow_edges;
+
+/* Events received */
+static unsigned int responses;
+static unsigned int port_events;
+static unsigned int slow_events;
+static unsigned int pin_events;
+static unsigned int pin_errors;
+static gpio_port_evt_msg_t last;
+static uint32_t last_timestamp;
+static unsigned int timestamp_errors;
+
+static void toggle(void *arg)
+{
+    uint32_t mask = 1u << FAST_PIN;
+
+    fast_edges++;
+    if (sim_now() % SLOW_US == 0) {
+        mask |= 1u << SLOW_PIN;
+        slow_edges++;
+    }
+    levels ^= mask;
+    sim_edges(mask, levels);
+    if (sim_now() + FAST_US < edges_end) {
+        sim_at(sim_now() + FAST_US, toggle, NULL);
+    }
+}
+
+static void client(struct cfw_message *msg)
+{
+    gpio_port_evt_msg_t *port_evt = (gpio_port_evt_msg_t *)msg;
+    gpio_listen_evt_msg_t *pin_evt = (gpio_listen_evt_msg_t *)msg;
+
+    switch (CFW_MESSAGE_ID(msg)) {
+    case MSG_ID_GPIO_LISTEN_RSP:
+    case MSG_ID_GPIO_LISTEN_PORT_RSP:
+        CHECK(((struct cfw_rsp_message *)msg)->status == DRV_RC_OK);
+        responses++;
+        break;
+    case MSG_ID_GPIO_PORT_EVT:
+        port_events++;
+        if (port_evt->changed & (1u << SLOW_PIN)) {
+            slow_events++;
+        }
+        if (port_evt->timestamp < last_timestamp) {
+            timestamp_errors++;
+        }
+        last_timestamp = port_evt->timestamp;
+        last = *port_evt;
+        break;
+    case MSG_ID_GPIO_EVT:
+        // The fast pin toggles at each interrupt, starting low
+        if (pin_evt->index != FAST_PIN || pin_evt->pin_state != !(pin_events & 1)) {
+            pin_errors++;
+        }
+        pin_events++;
+        break;
+    default:
+        CHECK(0);
+        break;
+    }
+    cfw_msg_free(msg);
+}
+
+static void setup(int port)
+{
+    OS_ERR_TYPE err;
+
+    CHECK(sim_init(client) == 0);
+    if (port) {
+        gpio_listen_port_req_msg_t *req = (gpio_listen_port_req_msg_t *)
+            cfw_alloc_message(sizeof(*req), &err);
+
+        req->mask = (1u << FAST_PIN) | (1u << SLOW_PIN);
+        req->mode = BOTH_EDGE;
+        req->debounce = DEB_OFF;
+        sim_request(&req->header, MSG_ID_GPIO_LISTEN_PORT_REQ, sizeof(*req));
+    } else {
+        gpio_listen_req_msg_t *req = (gpio_listen_req_msg_t *)
+            cfw_alloc_message(sizeof(*req), &err);
+
+        req->index = FAST_PIN;
+        req->mode = BOTH_EDGE;
+        req->debounce = DEB_OFF;
+        sim_request(&req->header, MSG_ID_GPIO_LISTEN_REQ, sizeof(*req));
+    }
+    sim_run_until(1000);
+    CHECK(responses == 1);
+}
+
+/* Edges from now on for duration us, then the events are reported */
+static void run_edges(uint64_t duration)
+{
+    edges_end = sim_now() + duration;
+    sim_at(sim_now(), toggle, NULL);
+    sim_run_until(edges_end + SETTLE_US);
+}
+
+static void check_port_load(void)
+{
+    uint32_t mask = (1u << FAST_PIN) | (1u << SLOW_PIN);
+
+    setup(1);
+    run_edges(DURATION_US);
+
+    CHECK(fast_edges == DURATION_US / FAST_US);
+    CHECK(sim_stats.irqs == fast_edges);
+    CHECK(sim_stats.port_reads == sim_stats.irqs);
+    CHECK(sim_stats.panics == 0 && sim_stats.no_message == 0);
+    CHECK(last.lost_irq == 0 && last.lost_evt == 0);
+    CHECK((last.state & mask) == (levels & mask));
+    CHECK(timestamp_errors == 0);
+#if CONFIG_GPIO_SERVICE_EVT_WINDOW
+    // An event per window, each window but the last holding edges of the
+    // slow pin
+    CHECK(port_events <= DURATION_US / 1000 / CONFIG_GPIO_SERVICE_EVT_WINDOW + 1);
+    CHECK(slow_events + 1 >= port_events);
+#else
+    // An event per service wakeup, which reports several interrupts
+    CHECK(slow_events == slow_edges);
+    CHECK(port_events == sim_stats.service_runs - 1);
+    CHECK(port_events <= sim_stats.irqs / (SIM_WAKEUP_US / FAST_US) + 1);
+#endif
+    CHECK(sim_stats.max_messages <= 3);
+}
+
+#ifndef CONFIG_GPIO_SERVICE_EVT_WINDOW
+static void check_pin_load(void)
+{
+    setup(0);
+    run_edges(DURATION_US / 10);
+
+    CHECK(sim_stats.irqs == fast_edges);
+    CHECK(sim_stats.panics == 0 && sim_stats.no_message == 0);
+    CHECK(pin_events == sim_stats.irqs);
+    CHECK(pin_errors == 0);
+}
+#endif
+
+static void stall_client(void *arg)
+{
+    sim_stall_client(sim_now() + 40000);
+}
+
+static void stall_service(void *arg)
+{
+    sim_stall_service(sim_now() + 5000);
+}
+
+static void check_overflow(void)
+{
+    uint32_t mask = (1u << FAST_PIN) | (1u << SLOW_PIN);
+    unsigned int events;
+
+    setup(1);
+    sim_at(sim_now() + 10000, stall_client, NULL);
+    sim_at(sim_now() + 50000, stall_service, NULL);
+    run_edges(DURATION_US / 10);
+
+    CHECK(sim_stats.panics == 0);
+    // The pool ran out while the client was stalled
+    CHECK(sim_stats.no_message > 0);
+    CHECK(last.lost_evt > 0);
+    // The ring filled while the service was stalled
+    CHECK(last.lost_irq > 0 && last.lost_irq < 5000 / FAST_US);
+    CHECK((last.state & mask) == (levels & mask));
+    CHECK(sim_stats.max_messages == SIM_MESSAGES);
+
+    // Events are delivered again
+    events = port_events;
+    run_edges(DURATION_US / 100);
+    CHECK(port_events > events);
+    CHECK((last.state & mask) == (levels & mask));
+}
+
+int main(void)
+{
+    void (*const cases[])(void) = {
+        check_port_load,
+#ifndef CONFIG_GPIO_SERVICE_EVT_WINDOW
+        check_pin_load,
+#endif
+        check_overflow,
+    };
+    unsigned int i;
+    int status;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        fflush(stdout);
+        if (fork() == 0) {
+            cases[i]();
+            exit(failures ? 1 : 0);
+        }
+        wait(&status);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+    }
+
+    printf("%s %s\n", failures ? "FAIL" : "PASS", TEST_NAME);
+    return failures ? 1 : 0;
+}
@@ -1,2 +1,3 @@
 obj-y += main.o
+obj-y += cdc_acm.o
 subdir-cflags-y += -I$(T)/arduino101_firmware/bsp/bootable/bootloader/include/usb/
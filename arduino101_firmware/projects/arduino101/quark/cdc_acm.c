@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "infra/log.h"
+#include "drivers/usb_acm.h"
+#include "machine.h"
+
+#include "cdc_acm.h"
+
+static void acm_rx_done(int actual, void *data);
+static void acm_tx_done(int actual, void *data);
+
+/**
+ * Use the following defines just to make the tips of your finger happier.
+ */
+#define Rx_BUFF cdc_acm_shared_rx_buffer.data
+#define Rx_HEAD cdc_acm_shared_rx_buffer.head
+#define Rx_TAIL cdc_acm_shared_rx_buffer.tail
+#define Tx_BUFF cdc_acm_shared_tx_buffer.data
+#define Tx_HEAD cdc_acm_shared_tx_buffer.head
+#define Tx_TAIL cdc_acm_shared_tx_buffer.tail
+#define SBS     SERIAL_BUFFER_SIZE
+#define SBM     (SERIAL_BUFFER_SIZE - 1)
+
+/* Make sure BUFFER_LENGTH is not bigger then shared ring buffers */
+#define BUFFER_LENGTH		64
+/* Number of USB transfers kept queued in each direction */
+#define ACM_XFERS		2
+
+static struct cdc_ring_buffer cdc_acm_shared_rx_buffer;
+static struct cdc_ring_buffer cdc_acm_shared_tx_buffer;
+static struct cdc_acm_shared_data cdc_acm_buffers;
+
+static uint8_t read_buffer[ACM_XFERS][BUFFER_LENGTH];
+
+typedef enum {
+	ACM_RX_DISABLED,
+	ACM_RX_READY
+} acm_rx_states;
+
+typedef enum {
+	ACM_TX_DISABLED,
+	ACM_TX_READY
+} acm_tx_states;
+
+static volatile uint32_t acm_rx_state = ACM_RX_DISABLED;
+static volatile uint32_t acm_tx_state = ACM_TX_DISABLED;
+
+/* Rx reads are counted from the start: read n uses read_buffer[n % ACM_XFERS]
+ * and completes in order. */
+static volatile uint32_t acm_rx_queued;
+static volatile uint32_t acm_rx_completed;
+static uint32_t acm_rx_copied;
+static uint32_t acm_rx_offset;
+static volatile int32_t acm_rx_len[ACM_XFERS];
+
+/* Tx writes are sent straight from the Tx ring: the tail only moves forward
+ * once the bytes are on the bus. */
+static volatile uint32_t acm_tx_inflight;
+static volatile int32_t acm_tx_inflight_bytes;
+
+void cdc_acm_init(void)
+{
+	cdc_acm_buffers.rx_buffer = &cdc_acm_shared_rx_buffer;
+	cdc_acm_buffers.tx_buffer = &cdc_acm_shared_tx_buffer;
+	shared_data->cdc_acm_buffers = &cdc_acm_buffers;
+}
+
+void cdc_acm_event(int event, int param)
+{
+	switch (event) {
+		case ACM_EVENT_CONNECTED: /* 1 */
+			acm_rx_state = ACM_RX_READY;
+			pr_info(LOG_MODULE_MAIN, "acm_rx_state = ACM_RX_READY");
+			break;
+		case ACM_EVENT_DISCONNECTED: /* 0 */
+			acm_rx_state = ACM_RX_DISABLED;
+			acm_tx_state = ACM_TX_DISABLED;
+			/* Endpoints are disabled: queued transfers are dropped */
+			acm_rx_queued = acm_rx_completed = acm_rx_copied = 0;
+			acm_rx_offset = 0;
+			acm_tx_inflight = 0;
+			acm_tx_inflight_bytes = 0;
+			break;
+		case ACM_SET_CONTROL_LINE_STATE: /* 3 */
+			switch (param) {
+				case ACM_CTRL_DCD | ACM_CTRL_CTS:
+				case ACM_CTRL_DCD:
+					acm_tx_state = ACM_TX_READY;
+					// Inform the ARC that we have a connected host
+					cdc_acm_buffers.host_open = true;
+					break;
+				case ACM_CTRL_CTS:
+				case ACM_CTRL_DISC:
+					acm_tx_state = ACM_TX_DISABLED;
+					cdc_acm_buffers.host_open = false;
+					break;
+				default:
+					pr_warning(LOG_MODULE_MAIN,
+					"Unknown param for ACM_SET_CONTROL_LINE_STATE event: %d",
+					param);
+					break;
+			}
+			break;
+	}
+}
+
+static void acm_tx_done(int actual, void *data)
+{
+	int len = (int)(uintptr_t)data;
+
+	Tx_TAIL = (Tx_TAIL + len) & SBM;
+	acm_tx_inflight_bytes -= len;
+	acm_tx_inflight--;
+}
+
+static void acm_rx_done(int actual, void *data)
+{
+	if (actual <= 0) {
+		pr_info(LOG_MODULE_MAIN, "No data!!! actual: %d", actual);
+		actual = 0;
+	}
+	if (actual > BUFFER_LENGTH) {
+		pr_error(LOG_MODULE_MAIN, "!!To much data! actual: %d", actual);
+		actual = BUFFER_LENGTH;
+	}
+	acm_rx_len[(int)(uintptr_t)data] = actual;
+	acm_rx_completed++;
+}
+
+/**
+ * Copies as much of buf as fits in the Rx ring, in at most two chunks.
+ *
+ * @return the number of bytes copied
+ */
+static int cdc_acm_rx_put(const uint8_t *buf, int len)
+{
+	int head = Rx_HEAD;
+	int room = (Rx_TAIL - head - 1) & SBM;
+	int first;
+
+	if (len > room)
+		len = room;
+	first = SBS - head;
+	if (first > len)
+		first = len;
+	memcpy(&Rx_BUFF[head], buf, first);
+	memcpy(&Rx_BUFF[0], buf + first, len - first);
+	/* Data must be in place before ARC sees the new head */
+	__asm__ __volatile__("" ::: "memory");
+	Rx_HEAD = (head + len) & SBM;
+	return len;
+}
+
+/**
+ * Tx Flow:
+ *  If ARC wrote something in the Tx buffer and the ACM is opened send data
+ *  directly from the ring, otherwise just forward the tail.
+ * Rx Flow:
+ *  Copy the completed reads into Rx buffer while there is room in it, and
+ *  keep ACM_XFERS read requests queued to ACM driver.
+ */
+void cdc_acm_process_message(void)
+{
+	uint32_t ret;
+	uint32_t flags;
+
+/* TX Handling */
+	if (Tx_HEAD == Tx_TAIL)
+		goto rx_flow;
+	flags = interrupt_lock();
+	if (acm_tx_state == ACM_TX_READY) {
+		/* Send the unsent part of Tx buffer, without crossing its end */
+		while (acm_tx_inflight < ACM_XFERS) {
+			int start = (Tx_TAIL + acm_tx_inflight_bytes) & SBM;
+			int cnt = (Tx_HEAD - start) & SBM;
+
+			if (!cnt)
+				break;
+			if (cnt > SBS - start)
+				cnt = SBS - start;
+			if (cnt > BUFFER_LENGTH)
+				cnt = BUFFER_LENGTH;
+
+			ret = acm_write(0, &Tx_BUFF[start], cnt, acm_tx_done,
+					(void *)(uintptr_t)cnt);
+			if (0 != ret) {
+				pr_error(LOG_MODULE_MAIN,
+					"acm_write() failed; ret: %d", ret);
+				break;
+			}
+			acm_tx_inflight++;
+			acm_tx_inflight_bytes += cnt;
+		}
+	} else if (acm_tx_state == ACM_TX_DISABLED && !acm_tx_inflight) {
+		/* Just move forward the tail of Tx buffer and drop the
+		 * bytes */
+		Tx_TAIL = Tx_HEAD;
+	}
+	interrupt_unlock(flags);
+
+rx_flow:
+/* RX Handling */
+	/* Consume completed reads into Rx ring buffer */
+	while (acm_rx_copied != acm_rx_completed) {
+		int slot = acm_rx_copied % ACM_XFERS;
+		int len = acm_rx_len[slot];
+
+		if (!cdc_acm_buffers.device_open) {
+			/* ARC is not ready to receive this data - discard it */
+			acm_rx_offset = len;
+		} else {
+			acm_rx_offset += cdc_acm_rx_put(
+				&read_buffer[slot][acm_rx_offset],
+				len - acm_rx_offset);
+		}
+		if (acm_rx_offset < len) {
+			/* Move on and give ARC time to consume
+			 * some Rx buffer */
+			break;
+		}
+		acm_rx_offset = 0;
+		acm_rx_copied++;
+	}
+	/* Queue read requests on the processed buffers */
+	flags = interrupt_lock();
+	while (acm_rx_state == ACM_RX_READY &&
+	       acm_rx_queued - acm_rx_copied < ACM_XFERS) {
+		int slot = acm_rx_queued % ACM_XFERS;
+
+		pr_debug(LOG_MODULE_MAIN, "queuing acm_read()");
+		ret = acm_read(0, read_buffer[slot], BUFFER_LENGTH,
+				acm_rx_done, (void *)(uintptr_t)slot);
+		if (0 != ret) {
+			pr_error(LOG_MODULE_MAIN,
+					"acm_read() failed; ret: %d", ret);
+			break;
+		}
+		acm_rx_queued++;
+	}
+	interrupt_unlock(flags);
+}
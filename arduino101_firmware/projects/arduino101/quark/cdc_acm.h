@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CDC_ACM_H__
+#define __CDC_ACM_H__
+
+/**
+ * Serial transport between the USB CDC-ACM interface and ARC.
+ *
+ * Bytes go through the two cdc_ring_buffer rings of the shared block: Rx
+ * reads are copied into the Rx ring, Tx writes are sent straight from the
+ * Tx ring written by ARC.
+ */
+
+/**
+ * Publishes the rings in the shared block. Called prior to starting ARC.
+ */
+void cdc_acm_init(void);
+
+/**
+ * Updates the transport on an ACM event of acm_init().
+ *
+ * @param event the ACM_EVENT_* or ACM_SET_CONTROL_LINE_STATE event
+ * @param param its parameter
+ */
+void cdc_acm_event(int event, int param);
+
+/**
+ * Moves the data of both directions, called from the main loop.
+ */
+void cdc_acm_process_message(void);
+
+#endif /* __CDC_ACM_H__ */
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sustained throughput of the serial transport on the model of cdc_sim.h,
+ * over 1 s of simulated time: ARC writing as fast as it can, the host
+ * sending full packets, and both at once. ARC empties the Rx ring every
+ * 100 us. Also reports the host time cdc_acm_process_message() takes per
+ * byte moved.
+ */
+
+#include <stdio.h>
+#include "cdc_sim.h"
+#include "machine.h"
+
+#ifndef VARIANT
+#define VARIANT "bulk"
+#endif
+
+#define RUN_US 1000000
+
+static void bench(const char *name, int rx_packet, int tx)
+{
+    struct sim_config config = {
+        .rx_packet = rx_packet,
+        .tx = tx,
+        .arc_poll_us = 100,
+        .arc_read = 1 << 30,
+    };
+    const struct sim_stats *stats;
+    uint64_t bytes;
+
+    sim_init(&config);
+    sim_run(RUN_US);
+    stats = sim_get_stats();
+    bytes = stats->rx_bytes + stats->tx_bytes;
+    printf("%-6s %4d B ring %-5s %7.1f KB/s Rx %7.1f KB/s Tx %5.1f ns/byte%s\n",
+           VARIANT, SERIAL_BUFFER_SIZE, name,
+           stats->rx_bytes / 1e3 / (RUN_US / 1e6),
+           stats->tx_bytes / 1e3 / (RUN_US / 1e6),
+           bytes ? (double)stats->process_ns / bytes : 0.0,
+           stats->errors ? " (errors)" : "");
+}
+
+int main(void)
+{
+    bench("tx", 0, 1);
+    bench("rx", SIM_MAX_PACKET, 0);
+    bench("both", SIM_MAX_PACKET, 1);
+    return 0;
+}
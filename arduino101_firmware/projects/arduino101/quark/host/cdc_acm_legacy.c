@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * cdc_acm_process_message() as it was before the ring transfers were done in
+ * bulk, for bench_cdc_acm: a single transfer in each direction, and the bytes
+ * moved one at a time through a staging buffer.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "infra/log.h"
+#include "drivers/usb_acm.h"
+#include "machine.h"
+
+#include "cdc_acm.h"
+
+static void acm_rx_done(int actual, void *data);
+static void acm_tx_done(int actual, void *data);
+
+#define Rx_BUFF cdc_acm_shared_rx_buffer.data
+#define Rx_HEAD cdc_acm_shared_rx_buffer.head
+#define Rx_TAIL cdc_acm_shared_rx_buffer.tail
+#define Tx_BUFF cdc_acm_shared_tx_buffer.data
+#define Tx_HEAD cdc_acm_shared_tx_buffer.head
+#define Tx_TAIL cdc_acm_shared_tx_buffer.tail
+#define SBS     SERIAL_BUFFER_SIZE
+
+#define BUFFER_LENGTH		64
+
+static struct cdc_ring_buffer cdc_acm_shared_rx_buffer;
+static struct cdc_ring_buffer cdc_acm_shared_tx_buffer;
+static struct cdc_acm_shared_data cdc_acm_buffers;
+
+static uint8_t read_buffer[BUFFER_LENGTH*2];
+static uint8_t write_buffer[BUFFER_LENGTH*2];
+
+typedef enum {
+	ACM_RX_DISABLED,
+	ACM_RX_READY,
+	ACM_RX_PENDING
+} acm_rx_states;
+
+typedef enum {
+	ACM_TX_DISABLED,
+	ACM_TX_READY,
+	ACM_TX_PENDING
+} acm_tx_states;
+
+static volatile uint32_t acm_rx_state = ACM_RX_DISABLED;
+static volatile uint32_t acm_tx_state = ACM_TX_DISABLED;
+
+static volatile  int32_t acm_rx_data;
+
+void cdc_acm_init(void)
+{
+	cdc_acm_buffers.rx_buffer = &cdc_acm_shared_rx_buffer;
+	cdc_acm_buffers.tx_buffer = &cdc_acm_shared_tx_buffer;
+	shared_data->cdc_acm_buffers = &cdc_acm_buffers;
+}
+
+void cdc_acm_event(int event, int param)
+{
+	switch (event) {
+		case ACM_EVENT_CONNECTED: /* 1 */
+			acm_rx_state = ACM_RX_READY;
+			break;
+		case ACM_EVENT_DISCONNECTED: /* 0 */
+			acm_rx_state = ACM_RX_DISABLED;
+			acm_tx_state = ACM_TX_DISABLED;
+			break;
+		case ACM_SET_CONTROL_LINE_STATE: /* 3 */
+			switch (param) {
+				case ACM_CTRL_DCD | ACM_CTRL_CTS:
+				case ACM_CTRL_DCD:
+					acm_tx_state = ACM_TX_READY;
+					cdc_acm_buffers.host_open = true;
+					break;
+				case ACM_CTRL_CTS:
+				case ACM_CTRL_DISC:
+					acm_tx_state = ACM_TX_DISABLED;
+					cdc_acm_buffers.host_open = false;
+					break;
+			}
+			break;
+	}
+}
+
+static void acm_tx_done(int actual, void *data)
+{
+	acm_tx_state = ACM_TX_READY;
+}
+
+static void acm_rx_done(int actual, void *data)
+{
+	if (acm_rx_data != 0) {
+		pr_warning(LOG_MODULE_MAIN,
+			"Unprocessed Rx data: %d, possible buffer overflow!",
+			acm_rx_data);
+	}
+	acm_rx_state = ACM_RX_READY;
+	pr_debug(LOG_MODULE_MAIN, "%s: acm_rx_state = ACM_RX_READY", __func__);
+	if (actual <= 0) {
+		pr_info(LOG_MODULE_MAIN, "No data!!! actual: %d", actual);
+	}
+	if (actual > BUFFER_LENGTH)
+		pr_error(LOG_MODULE_MAIN, "!!To much data! actual: %d", actual);
+	acm_rx_data = actual;
+}
+
+/**
+ * Tx Flow:
+ *  If ARC wrote something in the Tx buffer and the ACM is opened send data,
+ *  otherwise just forward the tail.
+ * Rx Flow:
+ *  If read_buffer has data and there is room in Rx buffer, consume
+ *  read_buffer into Rx buffer and queue a new read request to ACM driver.
+ */
+void cdc_acm_process_message(void)
+{
+	uint32_t ret;
+	static uint32_t i = 0;
+	uint32_t new_head;
+	uint32_t flags;
+
+/* TX Handling */
+	if (Tx_HEAD == Tx_TAIL)
+		goto rx_flow;
+	flags = interrupt_lock();
+	if (acm_tx_state == ACM_TX_READY) {
+		/* Process Tx buffer */
+		if ((Tx_HEAD != Tx_TAIL)) {
+			int cnt = 0, index = Tx_TAIL;
+			for (; (index != Tx_HEAD) &&
+					(cnt < BUFFER_LENGTH);cnt++) {
+				write_buffer[cnt] = Tx_BUFF[index];
+				index = (index + 1) % SBS;
+			}
+			Tx_TAIL = (Tx_TAIL + cnt) % SBS;
+
+			ret = acm_write(0, write_buffer, cnt, acm_tx_done,
+							(void *)write_buffer);
+			if (0 != ret) {
+				pr_error(LOG_MODULE_MAIN,
+					"acm_write() failed; ret: %d", ret);
+			} else {
+				acm_tx_state = ACM_TX_PENDING;
+			}
+		}
+	} else if (acm_tx_state == ACM_TX_DISABLED) {
+		/* Just move forward the tail of Tx buffer and drop the
+		 * bytes */
+		Tx_TAIL = Tx_HEAD;
+	}
+	interrupt_unlock(flags);
+
+rx_flow:
+/* RX Handling */
+	/* Consume read_buffer into Rx ring buffer */
+	while (acm_rx_data > 0) {
+		if (!cdc_acm_buffers.device_open) {
+			/* ARC is not ready to receive this data - discard it */
+			acm_rx_data = 0;
+			break;
+		}
+
+		/* Check room in Rx buffer */
+		new_head = (Rx_HEAD + 1) % SBS;
+		if (new_head != Rx_TAIL) {
+			Rx_BUFF[Rx_HEAD] = *(read_buffer + i);
+			Rx_HEAD = new_head;
+			i++;
+			acm_rx_data--;
+		} else {
+			/* Move on and give ARC time to consume
+			 * some Rx buffer */
+			break;
+		}
+	}
+	/* read_buffer processed => reset Rx counter and queue a new read
+	 * request */
+	flags = interrupt_lock();
+	if (acm_rx_state == ACM_RX_READY && !acm_rx_data) {
+		i = 0;
+		pr_debug(LOG_MODULE_MAIN, "queuing acm_read()");
+		ret = acm_read(0, read_buffer, BUFFER_LENGTH,
+				acm_rx_done, (void *)read_buffer);
+		if (0 != ret) {
+			pr_error(LOG_MODULE_MAIN,
+					"acm_read() failed; ret: %d", ret);
+		} else {
+			acm_rx_state = ACM_RX_PENDING;
+			pr_debug(LOG_MODULE_MAIN, "%s: acm_rx_state = ACM_RX_PENDING",
+					__func__ );
+		}
+	}
+	interrupt_unlock(flags);
+}
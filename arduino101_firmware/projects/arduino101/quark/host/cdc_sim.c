@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * USB bus, ARC and OS layer models for the host build of cdc_acm.c, see
+ * cdc_sim.h.
+ */
+
+/* time.h and os.h both declare timer_create() and timer_delete() */
+#define timer_create posix_timer_create
+#define timer_delete posix_timer_delete
+#include <time.h>
+#undef timer_create
+#undef timer_delete
+#include <string.h>
+
+#include "cdc_sim.h"
+#include "cdc_acm.h"
+#include "drivers/usb_acm.h"
+#include "infra/log.h"
+#include "os/os.h"
+#include "machine.h"
+
+/* Transfers queued on an endpoint */
+#define SIM_XFERS 8
+
+struct sim_xfer {
+    uint8_t *buffer;
+    int len;
+    int done;
+    void (*xfer_done)(int, void *);
+    void *data;
+};
+
+/* Endpoint: FIFO of transfers */
+struct sim_ep {
+    struct sim_xfer xfers[SIM_XFERS];
+    unsigned int first;
+    unsigned int count;
+};
+
+struct platform_shared_block_ sim_shared_block;
+
+static struct sim_config config;
+static struct sim_stats stats;
+static uint64_t now_ns;
+static uint64_t loop_ns;
+static uint64_t arc_ns;
+
+static int connected;
+static struct sim_ep ep_out;        /* host to device: reads */
+static struct sim_ep ep_in;         /* device to host: writes */
+/* The packet on the bus, 0 if none */
+static struct sim_ep *bus_ep;
+static int bus_len;
+static uint64_t bus_end_ns;
+static int bus_prefer_in;
+
+static uint32_t rx_packets;
+static uint8_t rx_sent;         /* next byte sent by the host */
+static uint8_t rx_expected;     /* next byte read by ARC */
+static int rx_sync;             /* ARC takes the next byte as expected */
+static uint8_t tx_written;      /* next byte written by ARC */
+static uint8_t tx_expected;     /* next byte received by the host */
+static int tx_sync;             /* the host takes the next byte as expected */
+
+static struct cdc_acm_shared_data *arc_buffers(void)
+{
+    return shared_data->cdc_acm_buffers;
+}
+
+/* USB bus */
+
+static int rx_packet_len(void)
+{
+    if (config.rx_packet == SIM_RX_VARYING)
+        return rx_packets % SIM_MAX_PACKET + 1;
+    return config.rx_packet;
+}
+
+static int ep_queue(struct sim_ep *ep, uint8_t *buffer, int len,
+                    void (*xfer_done)(int, void *), void *data)
+{
+    struct sim_xfer *xfer;
+
+    if (!connected || ep->count == SIM_XFERS || len <= 0) {
+        stats.errors++;
+        return -1;
+    }
+    xfer = &ep->xfers[(ep->first + ep->count++) % SIM_XFERS];
+    xfer->buffer = buffer;
+    xfer->len = len;
+    xfer->done = 0;
+    xfer->xfer_done = xfer_done;
+    xfer->data = data;
+    return 0;
+}
+
+static void ep_complete(struct sim_ep *ep)
+{
+    struct sim_xfer xfer = ep->xfers[ep->first];
+
+    ep->first = (ep->first + 1) % SIM_XFERS;
+    ep->count--;
+    xfer.xfer_done(xfer.done, xfer.data);
+}
+
+/* Starts the next packet if the bus is free */
+static void bus_start(void)
+{
+    int in = ep_in.count > 0;
+    int out = ep_out.count > 0 && config.rx_packet;
+    struct sim_xfer *xfer;
+
+    if (bus_ep || !connected || (!in && !out))
+        return;
+    if (in && (!out || bus_prefer_in)) {
+        xfer = &ep_in.xfers[ep_in.first];
+        bus_ep = &ep_in;
+        bus_len = xfer->len - xfer->done;
+        if (bus_len > SIM_MAX_PACKET)
+            bus_len = SIM_MAX_PACKET;
+    } else {
+        xfer = &ep_out.xfers[ep_out.first];
+        bus_ep = &ep_out;
+        bus_len = rx_packet_len();
+        if (bus_len > xfer->len)
+            bus_len = xfer->len;
+    }
+    bus_prefer_in = bus_ep == &ep_out;
+    bus_end_ns = now_ns + SIM_PACKET_NS + (uint64_t)bus_len * SIM_BYTE_NS;
+}
+
+static void bus_end(void)
+{
+    struct sim_xfer *xfer = &bus_ep->xfers[bus_ep->first];
+    int i;
+
+    if (bus_ep == &ep_in) {
+        for (i = 0; i < bus_len; i++) {
+            if (tx_sync)
+                tx_expected = xfer->buffer[xfer->done + i];
+            tx_sync = 0;
+            if (xfer->buffer[xfer->done + i] != tx_expected++)
+                stats.errors++;
+        }
+        stats.tx_bytes += bus_len;
+        xfer->done += bus_len;
+        bus_ep = NULL;
+        if (xfer->done == xfer->len)
+            ep_complete(&ep_in);
+    } else {
+        /* A packet shorter than the transfer ends it */
+        for (i = 0; i < bus_len; i++)
+            xfer->buffer[i] = rx_sent++;
+        xfer->done = bus_len;
+        rx_packets++;
+        bus_ep = NULL;
+        ep_complete(&ep_out);
+    }
+}
+
+int acm_read(int idx, uint8_t *buffer, int len,
+             void (*xfer_done)(int, void *), void *data)
+{
+    return ep_queue(&ep_out, buffer, len, xfer_done, data);
+}
+
+int acm_write(int idx, uint8_t *buffer, int len,
+              void (*xfer_done)(int, void *), void *data)
+{
+    return ep_queue(&ep_in, buffer, len, xfer_done, data);
+}
+
+/* ARC */
+
+static void arc_poll(void)
+{
+    struct cdc_ring_buffer *rx = arc_buffers()->rx_buffer;
+    struct cdc_ring_buffer *tx = arc_buffers()->tx_buffer;
+    int n;
+
+    for (n = 0; n < config.arc_read && rx->tail != rx->head; n++) {
+        if (rx_sync)
+            rx_expected = rx->data[rx->tail];
+        rx_sync = 0;
+        if (rx->data[rx->tail] != rx_expected++)
+            stats.errors++;
+        rx->tail = (rx->tail + 1) % SERIAL_BUFFER_SIZE;
+        stats.rx_bytes++;
+    }
+    if (!config.tx || !arc_buffers()->host_open)
+        return;
+    for (n = 0; (!config.arc_write || n < config.arc_write) &&
+         (tx->head + 1) % SERIAL_BUFFER_SIZE != tx->tail; n++) {
+        tx->data[tx->head] = tx_written++;
+        tx->head = (tx->head + 1) % SERIAL_BUFFER_SIZE;
+    }
+}
+
+/* QRK */
+
+static void qrk_loop(void)
+{
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    cdc_acm_process_message();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    stats.process_ns += (end.tv_sec - start.tv_sec) * 1000000000ULL +
+        end.tv_nsec - start.tv_nsec;
+}
+
+/* Model */
+
+void sim_connect(int connect)
+{
+    if (connect) {
+        connected = 1;
+        /* Both counters start over: the bytes in flight were lost */
+        rx_sync = tx_sync = 1;
+        cdc_acm_event(ACM_EVENT_CONNECTED, 0);
+        cdc_acm_event(ACM_SET_CONTROL_LINE_STATE, ACM_CTRL_DCD);
+    } else {
+        connected = 0;
+        /* The controller drops the queued transfers */
+        memset(&ep_in, 0, sizeof(ep_in));
+        memset(&ep_out, 0, sizeof(ep_out));
+        bus_ep = NULL;
+        cdc_acm_event(ACM_SET_CONTROL_LINE_STATE, ACM_CTRL_DISC);
+        cdc_acm_event(ACM_EVENT_DISCONNECTED, 0);
+    }
+}
+
+void sim_init(const struct sim_config *cfg)
+{
+    /* The transport drops its transfers on the disconnection */
+    if (connected)
+        sim_connect(0);
+    config = *cfg;
+    memset(&stats, 0, sizeof(stats));
+    memset(&sim_shared_block, 0, sizeof(sim_shared_block));
+    now_ns = 0;
+    loop_ns = (uint64_t)SIM_LOOP_US * 1000;
+    arc_ns = (uint64_t)config.arc_poll_us * 1000;
+    rx_packets = 0;
+    rx_sent = rx_expected = tx_written = tx_expected = 0;
+
+    cdc_acm_init();
+    /* The rings start empty, as after a reset */
+    memset(arc_buffers()->rx_buffer, 0, sizeof(struct cdc_ring_buffer));
+    memset(arc_buffers()->tx_buffer, 0, sizeof(struct cdc_ring_buffer));
+    arc_buffers()->device_open = 1;
+    sim_connect(1);
+}
+
+void sim_run(uint32_t us)
+{
+    uint64_t end = now_ns + (uint64_t)us * 1000;
+
+    for (;;) {
+        uint64_t next = loop_ns < arc_ns ? loop_ns : arc_ns;
+
+        bus_start();
+        if (bus_ep && bus_end_ns < next)
+            next = bus_end_ns;
+        if (next > end)
+            break;
+        now_ns = next;
+        if (bus_ep && now_ns == bus_end_ns) {
+            bus_end();
+        } else if (now_ns == arc_ns) {
+            arc_poll();
+            arc_ns += (uint64_t)config.arc_poll_us * 1000;
+        } else {
+            qrk_loop();
+            loop_ns += (uint64_t)SIM_LOOP_US * 1000;
+        }
+    }
+    now_ns = end;
+}
+
+const struct sim_stats *sim_get_stats(void)
+{
+    return &stats;
+}
+
+/* OS layer */
+
+uint32_t interrupt_lock(void)
+{
+    return 0;
+}
+
+void interrupt_unlock(uint32_t key)
+{
+}
+
+int8_t log_printk(uint8_t level, uint8_t module, const char *format, ...)
+{
+    if (level == LOG_LEVEL_ERROR)
+        stats.errors++;
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host model of the serial transport of cdc_acm.c, on a simulated clock:
+ *  - the USB full speed bus carries one bulk packet at a time, taking
+ *    SIM_PACKET_NS plus SIM_BYTE_NS per byte (12 Mbit/s). The host always
+ *    has data for the device, in packets of sim_config.rx_packet bytes, and
+ *    always takes the data sent to it,
+ *  - QRK calls cdc_acm_process_message() every SIM_LOOP_US, as the timer of
+ *    its main loop does. Transfers complete between two calls, as
+ *    interrupts,
+ *  - every arc_poll_us, ARC reads up to arc_read bytes from the Rx ring and
+ *    writes up to arc_write bytes to the Tx ring, or fills it, as a sketch
+ *    writing as fast as it can.
+ *
+ * The bytes of each direction follow a counter, so that a byte lost,
+ * duplicated or reordered is an error. The counters restart after a
+ * disconnection, which drops the queued transfers.
+ */
+
+#ifndef __CDC_SIM_H__
+#define __CDC_SIM_H__
+
+#include <stdint.h>
+
+#define SIM_LOOP_US       1000
+#define SIM_PACKET_NS     10000
+#define SIM_BYTE_NS       667
+#define SIM_MAX_PACKET    64
+
+/* rx_packet for packets of 1 to SIM_MAX_PACKET bytes in turn */
+#define SIM_RX_VARYING    -1
+
+struct sim_config {
+    int rx_packet;      /* bytes per packet sent by the host, 0 for none */
+    int tx;             /* ARC writes to the host */
+    int arc_poll_us;    /* period of ARC */
+    int arc_read;       /* bytes read by ARC per period */
+    int arc_write;      /* bytes written by ARC per period, 0 to fill the
+                           Tx ring */
+};
+
+struct sim_stats {
+    uint64_t rx_bytes;      /* bytes read by ARC */
+    uint64_t tx_bytes;      /* bytes received by the host */
+    uint32_t errors;        /* bytes out of sequence, driver misuse and
+                               error logs */
+    uint64_t process_ns;    /* host time spent in cdc_acm_process_message() */
+};
+
+/**
+ * Resets the model, sets up the transport with ARC ready and connects the
+ * host.
+ */
+void sim_init(const struct sim_config *config);
+
+/** Runs the model for us of simulated time */
+void sim_run(uint32_t us);
+
+/** Disconnects the host, or connects it again */
+void sim_connect(int connected);
+
+/** Counters since sim_init() */
+const struct sim_stats *sim_get_stats(void);
+
+#endif /* __CDC_SIM_H__ */
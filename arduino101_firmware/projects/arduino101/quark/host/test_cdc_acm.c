@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2016, Intel Corporation
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks the serial transport of cdc_acm.c on the model of cdc_sim.h: every
+ * byte goes through once and in order, in each direction and in both at
+ * once, with the rings wrapping, short packets and an ARC slower than the
+ * host, and again after the host disconnected with transfers queued.
+ */
+
+#include <stdio.h>
+#include "cdc_sim.h"
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* Runs 100 ms of traffic, every byte in sequence */
+static void check_traffic(const struct sim_config *config)
+{
+    const struct sim_stats *stats = sim_get_stats();
+    uint64_t rx = stats->rx_bytes;
+    uint64_t tx = stats->tx_bytes;
+
+    sim_run(100000);
+    CHECK(stats->errors == 0);
+    /* At least a packet per loop in each direction used, a full one when
+     * ARC fills the Tx ring */
+    CHECK(!config->rx_packet || stats->rx_bytes - rx >= 100);
+    CHECK(!config->tx || config->arc_write ||
+          stats->tx_bytes - tx >= 100 * SIM_MAX_PACKET);
+}
+
+static void check_directions(void)
+{
+    struct sim_config tx = { .tx = 1, .arc_poll_us = 100, .arc_read = 1 << 30 };
+    struct sim_config rx = { .rx_packet = SIM_MAX_PACKET, .arc_poll_us = 100,
+                             .arc_read = 1 << 30 };
+    struct sim_config both = { .rx_packet = SIM_MAX_PACKET, .tx = 1,
+                               .arc_poll_us = 100, .arc_read = 1 << 30 };
+
+    sim_init(&tx);
+    check_traffic(&tx);
+    CHECK(sim_get_stats()->rx_bytes == 0);
+    sim_init(&rx);
+    check_traffic(&rx);
+    CHECK(sim_get_stats()->tx_bytes == 0);
+    sim_init(&both);
+    check_traffic(&both);
+}
+
+/* ARC reads 10 bytes and writes 7 every 300 us: the reads wait for room in
+ * the Rx ring, the writes cross the end of the Tx ring */
+static void check_slow_arc(void)
+{
+    struct sim_config config = { .rx_packet = SIM_RX_VARYING, .tx = 1,
+                                 .arc_poll_us = 300, .arc_read = 10,
+                                 .arc_write = 7 };
+
+    sim_init(&config);
+    check_traffic(&config);
+    /* ARC is the bottleneck: it finds bytes to read at most of its periods */
+    CHECK(sim_get_stats()->rx_bytes >= 100000 / 300 * 10 * 9 / 10);
+    CHECK(sim_get_stats()->tx_bytes >= 100000 / 300 * 7 - SIM_MAX_PACKET);
+}
+
+static void check_reconnect(void)
+{
+    struct sim_config config = { .rx_packet = SIM_RX_VARYING, .tx = 1,
+                                 .arc_poll_us = 100, .arc_read = 1 << 30 };
+    const struct sim_stats *stats = sim_get_stats();
+    uint64_t rx, tx;
+
+    sim_init(&config);
+    sim_run(10350);
+    sim_connect(0);
+    sim_run(5000);
+    rx = stats->rx_bytes;
+    tx = stats->tx_bytes;
+    sim_run(5000);
+    /* Nothing moves while disconnected */
+    CHECK(stats->rx_bytes == rx && stats->tx_bytes == tx);
+    sim_connect(1);
+    check_traffic(&config);
+}
+
+int main(void)
+{
+    check_directions();
+    check_slow_arc();
+    check_reconnect();
+
+    printf("%s test_cdc_acm\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -74,6 +74,7 @@
 #include "machine/soc/quark_se/quark/log_backend_uart.h"
 
 #include "usb.h"
+#include "cdc_acm.h"
 
 /* in order to shut off debug logs just make sure
    CONFIG_ARDUINO101_NO_DEBUG_PRINTS is set to y */
@@ -97,54 +98,12 @@ extern void *services;
 /* Factory Data */
 const struct customer_data* otp_data_ptr = (struct customer_data*)(FACTORY_DATA_ADDR + 0x200);
 
-/* Local Functions declarations */
-static void acm_rx_done(int actual, void *data);
-static void acm_tx_done(int actual, void *data);
-
-/**
- * Use the following defines just to make the tips of your finger happier.
- */
-#define Rx_BUFF cdc_acm_shared_rx_buffer.data
-#define Rx_HEAD cdc_acm_shared_rx_buffer.head
-#define Rx_TAIL cdc_acm_shared_rx_buffer.tail
-#define Tx_BUFF cdc_acm_shared_tx_buffer.data
-#define Tx_HEAD cdc_acm_shared_tx_buffer.head
-#define Tx_TAIL cdc_acm_shared_tx_buffer.tail
-#define SBS     SERIAL_BUFFER_SIZE
-
-/* Make sure BUFFER_LENGTH is not bigger then shared ring buffers */
-#define BUFFER_LENGTH		64
-
 #define LOOP_INTERVAL_MS 1
 #define USB_ACM_TIMEOUT_MS (250)
 
 #define USB_CONNECTED	    0x04
 #define USB_DISCONNECTED    0x05
 
-static struct cdc_ring_buffer cdc_acm_shared_rx_buffer;
-static struct cdc_ring_buffer cdc_acm_shared_tx_buffer;
-static struct cdc_acm_shared_data cdc_acm_buffers;
-
-static uint8_t read_buffer[BUFFER_LENGTH*2];
-static uint8_t write_buffer[BUFFER_LENGTH*2];
-
-typedef enum {
-	ACM_RX_DISABLED,
-	ACM_RX_READY,
-	ACM_RX_PENDING
-} acm_rx_states;
-
-typedef enum {
-	ACM_TX_DISABLED,
-	ACM_TX_READY,
-	ACM_TX_PENDING
-} acm_tx_states;
-
-static volatile uint32_t acm_rx_state = ACM_RX_DISABLED;
-static volatile uint32_t acm_tx_state = ACM_TX_DISABLED;
-
-static volatile  int32_t acm_rx_data;
-
 /* Indicates the state of the ACM port;
  *  acm_open == 1 => a serial client is listening at the other end
  *  acm_open == 0 => nobody listens us => drop data */
@@ -288,32 +247,9 @@ void acm_event(int event, int param)
 			baud_rate = param;
 			break;
 		case ACM_EVENT_CONNECTED: /* 1 */
-			acm_rx_state = ACM_RX_READY;
-			pr_info(LOG_MODULE_MAIN, "acm_rx_state = ACM_RX_READY");
-			break;
 		case ACM_EVENT_DISCONNECTED: /* 0 */
-			acm_rx_state = ACM_RX_DISABLED;
-			acm_tx_state = ACM_TX_DISABLED;
-			break;
 		case ACM_SET_CONTROL_LINE_STATE: /* 3 */
-			switch (param) {
-				case ACM_CTRL_DCD | ACM_CTRL_CTS:
-				case ACM_CTRL_DCD:
-					acm_tx_state = ACM_TX_READY;
-					// Inform the ARC that we have a connected host
-					cdc_acm_buffers.host_open = true;
-					break;
-				case ACM_CTRL_CTS:
-				case ACM_CTRL_DISC:
-					acm_tx_state = ACM_TX_DISABLED;
-					cdc_acm_buffers.host_open = false;
-					break;
-				default:
-					pr_warning(LOG_MODULE_MAIN,
-					"Unknown param for ACM_SET_CONTROL_LINE_STATE event: %d",
-					param);
-					break;
-			}
+			cdc_acm_event(event, param);
 			break;
 		default:
 			pr_debug(LOG_MODULE_MAIN,
@@ -335,117 +271,6 @@ void acm_event(int event, int param)
 	}
 }
 
-static void acm_tx_done(int actual, void *data)
-{
-	acm_tx_state = ACM_TX_READY;
-}
-
-static void acm_rx_done(int actual, void *data)
-{
-	if (acm_rx_data != 0) {
-		pr_warning(LOG_MODULE_MAIN,
-			"Unprocessed Rx data: %d, possible buffer overflow!",
-			acm_rx_data);
-	}
-	acm_rx_state = ACM_RX_READY;
-	pr_debug(LOG_MODULE_MAIN, "%s: acm_rx_state = ACM_RX_READY", __func__);
-	if (actual <= 0) {
-		pr_info(LOG_MODULE_MAIN, "No data!!! actual: %d", actual);
-	}
-	if (actual > BUFFER_LENGTH)
-		pr_error(LOG_MODULE_MAIN, "!!To much data! actual: %d", actual);
-	acm_rx_data = actual;
-}
-
-/**
- * Tx Flow:
- *  If ARC wrote something in the Tx buffer and the ACM is opened send data,
- *  otherwise just forward the tail.
- * Rx Flow:
- *  If read_buffer has data and there is room in Rx buffer, consume
- *  read_buffer into Rx buffer and queue a new read request to ACM driver.
- */
-void cdc_acm_process_message(void)
-{
-	uint32_t ret;
-	static uint32_t i = 0;
-	uint32_t new_head;
-	int flags;
-
-/* TX Handling */
-	if (Tx_HEAD == Tx_TAIL)
-		goto rx_flow;
-	flags = irq_lock();
-	if (acm_tx_state == ACM_TX_READY) {
-		/* Process Tx buffer */
-		if ((Tx_HEAD != Tx_TAIL)) {
-			int cnt = 0, index = Tx_TAIL;
-			for (; (index != Tx_HEAD) &&
-					(cnt < BUFFER_LENGTH);cnt++) {
-				write_buffer[cnt] = Tx_BUFF[index];
-				index = (index + 1) % SBS;
-			}
-			Tx_TAIL = (Tx_TAIL + cnt) % SBS;
-
-			ret = acm_write(0, write_buffer, cnt, acm_tx_done,
-							(void *)write_buffer);
-			if (0 != ret) {
-				pr_error(LOG_MODULE_MAIN,
-					"acm_write() failed; ret: %d", ret);
-			} else {
-				acm_tx_state = ACM_TX_PENDING;
-			}
-		}
-	} else if (acm_tx_state == ACM_TX_DISABLED) {
-		/* Just move forward the tail of Tx buffer and drop the
-		 * bytes */
-		Tx_TAIL = Tx_HEAD;
-	}
-	irq_unlock(flags);
-
-rx_flow:
-/* RX Handling */
-	/* Consume read_buffer into Rx ring buffer */
-	while (acm_rx_data > 0) {
-		if (!cdc_acm_buffers.device_open) {
-			/* ARC is not ready to receive this data - discard it */
-			acm_rx_data = 0;
-			break;
-		}
-
-		/* Check room in Rx buffer */
-		new_head = (Rx_HEAD + 1) % SBS;
-		if (new_head != Rx_TAIL) {
-			Rx_BUFF[Rx_HEAD] = *(read_buffer + i);
-			Rx_HEAD = new_head;
-			i++;
-			acm_rx_data--;
-		} else {
-			/* Move on and give ARC time to consume
-			 * some Rx buffer */
-			break;
-		}
-	}
-	/* read_buffer processed => reset Rx counter and queue a new read
-	 * request */
-	flags = irq_lock();
-	if (acm_rx_state == ACM_RX_READY && !acm_rx_data) {
-		i = 0;
-		pr_debug(LOG_MODULE_MAIN, "queuing acm_read()");
-		ret = acm_read(0, read_buffer, BUFFER_LENGTH,
-				acm_rx_done, (void *)read_buffer);
-		if (0 != ret) {
-			pr_error(LOG_MODULE_MAIN,
-					"acm_read() failed; ret: %d", ret);
-		} else {
-			acm_rx_state = ACM_RX_PENDING;
-			pr_debug(LOG_MODULE_MAIN, "%s: acm_rx_state = ACM_RX_PENDING",
-					__func__ );
-		}
-	}
-	irq_unlock(flags);
-}
-
 void main_task(void *param)
 {
 	T_TIMER timer_task;
@@ -534,9 +359,7 @@ void main_task(void *param)
 #endif
 
 	/* Configure CDC-ACM Shared Buffers prior to starting ARC */
-	cdc_acm_buffers.rx_buffer = &cdc_acm_shared_rx_buffer;
-	cdc_acm_buffers.tx_buffer = &cdc_acm_shared_tx_buffer;
-	shared_data->cdc_acm_buffers = &cdc_acm_buffers;
+	cdc_acm_init();
 
 	pr_info(LOG_MODULE_MAIN, "Start the ARC core");
 	start_arc(0);
@@ -0,0 +1,292 @@
+#!/usr/bin/python
+# -*- coding: utf-8 -*-
+
+#
+# Copyright (c) 2016, Intel Corporation
+# All rights reserved.
+# 
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+# 
+# 1. Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the following disclaimer.
+# 
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+# 
+# 3. Neither the name of the copyright holder nor the names of its
+# contributors may be used to endorse or promote products derived from this
+# software without specific prior written permission.
+# 
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""
+Generate a patch stream for a differential DFU download.
+
+The patch turns the image currently in a flash partition into a new one,
+it is applied in place by the bootloader, see
+bsp/bootable/bootloader/include/dfu_delta.h for the format.
+"""
+
+import argparse
+import struct
+import sys
+
+PAGE_SIZE = 2048
+MAGIC = 0x32544c44
+SRC_BLANK = 0xffffffff
+BACKUP_PAGES = 2
+# Header of the patch in progress, then one page per backup
+JOURNAL_PAGES = BACKUP_PAGES + 2
+# Length of the byte sequences used to find a window in the old image
+ANCHOR_SIZE = 16
+# Distance between two anchors of a new page
+ANCHOR_STEP = 128
+# Runs closer than this are merged, a run header costs 4 bytes
+RUN_MERGE_GAP = 4
+
+
+def pad(data):
+    """Pad an image with erased bytes up to a page boundary."""
+    data = bytearray(data)
+    if len(data) % PAGE_SIZE:
+        data += b'\xff' * (PAGE_SIZE - len(data) % PAGE_SIZE)
+    return data
+
+
+def checksum(data):
+    """Sum of the little endian words of data."""
+    words = struct.unpack('<%dI' % (len(data) // 4), bytes(data))
+    return sum(words) & 0xffffffff
+
+
+def page_checksum(data):
+    """Position dependent sum of the words of a page."""
+    total = 0
+    for word in struct.unpack('<%dI' % (PAGE_SIZE // 4), bytes(data)):
+        total = (total * 33 + word) & 0xffffffff
+    return total
+
+
+def diff_runs(window, page):
+    """List of (offset, bytes) replacing the differences of window."""
+    runs = []
+    i = 0
+    while i < PAGE_SIZE:
+        if window[i] == page[i]:
+            i += 1
+            continue
+        start = i
+        end = i + 1
+        while end < PAGE_SIZE:
+            if window[end] != page[end]:
+                end += 1
+                continue
+            gap = end
+            while gap < PAGE_SIZE and gap - end < RUN_MERGE_GAP \
+                    and window[gap] == page[gap]:
+                gap += 1
+            if gap < PAGE_SIZE and gap - end < RUN_MERGE_GAP:
+                end = gap
+            else:
+                break
+        runs.append((start, page[start:end]))
+        i = end
+    return runs
+
+
+def runs_cost(runs):
+    return 8 + sum(4 + len(data) for _, data in runs)
+
+
+class Base(object):
+    """Old partition content, indexed by anchors."""
+
+    def __init__(self, data):
+        self.data = data
+        self.index = {}
+        for off in range(0, len(data) - ANCHOR_SIZE + 1):
+            key = bytes(data[off:off + ANCHOR_SIZE])
+            self.index.setdefault(key, []).append(off)
+
+    def window(self, src):
+        if src == SRC_BLANK:
+            return bytearray(b'\xff' * PAGE_SIZE)
+        return self.data[src:src + PAGE_SIZE]
+
+    def candidates(self, page, dest):
+        """Windows of the old image that may match a new page."""
+        lowest = max(0, (dest - BACKUP_PAGES) * PAGE_SIZE)
+        highest = len(self.data) - PAGE_SIZE
+        found = set([SRC_BLANK])
+        if dest * PAGE_SIZE <= highest:
+            found.add(dest * PAGE_SIZE)
+        for i in range(0, PAGE_SIZE - ANCHOR_SIZE + 1, ANCHOR_STEP):
+            for off in self.index.get(bytes(page[i:i + ANCHOR_SIZE]), []):
+                src = off - i
+                if lowest <= src <= highest:
+                    found.add(src)
+        return found
+
+
+def make_patch(old, new):
+    old = pad(old)
+    new = pad(new)
+    base = Base(old)
+    page_count = len(new) // PAGE_SIZE
+    out = bytearray(struct.pack('<IHHII', MAGIC, page_count,
+                                len(old) // PAGE_SIZE, checksum(old),
+                                checksum(new)))
+    for dest in range(page_count):
+        page = new[dest * PAGE_SIZE:(dest + 1) * PAGE_SIZE]
+        best = None
+        for src in base.candidates(page, dest):
+            runs = diff_runs(base.window(src), page)
+            cost = runs_cost(runs)
+            if best is None or cost < best[0]:
+                best = (cost, src, runs)
+        _, src, runs = best
+        old_sum = 0
+        if dest * PAGE_SIZE < len(old):
+            old_sum = page_checksum(old[dest * PAGE_SIZE:
+                                        (dest + 1) * PAGE_SIZE])
+        out += struct.pack('<IHHII', src, len(runs), 0, old_sum,
+                           page_checksum(page))
+        for offset, data in runs:
+            out += struct.pack('<HH', offset, len(data)) + data
+    return out
+
+
+def apply_patch(old, partition_pages, patch, cut=None):
+    """
+    Apply a patch in place as the bootloader does, on a partition holding
+    old. When cut is set, the power is lost after cut page writes, the patch
+    is then applied again from the flash content left.
+    """
+    flash = pad(old)
+    flash += b'\xff' * (partition_pages * PAGE_SIZE - len(flash))
+    writes = [0]
+
+    def write(page, data):
+        if cut is not None and writes[0] == cut:
+            # Half erased page
+            flash[page * PAGE_SIZE:page * PAGE_SIZE + PAGE_SIZE // 2] = \
+                b'\xff' * (PAGE_SIZE // 2)
+            raise EOFError
+        writes[0] += 1
+        flash[page * PAGE_SIZE:(page + 1) * PAGE_SIZE] = data
+
+    try:
+        _apply(flash, partition_pages, patch, write)
+    except EOFError:
+        cut = None
+        _apply(flash, partition_pages, patch, write)
+    return flash
+
+
+def _apply(flash, partition_pages, patch, write):
+    def page_at(page):
+        return flash[page * PAGE_SIZE:(page + 1) * PAGE_SIZE]
+
+    header = patch[:16]
+    magic, page_count, base_pages, base_sum, new_sum = \
+        struct.unpack_from('<IHHII', header, 0)
+    assert magic == MAGIC
+    assert page_count + JOURNAL_PAGES <= partition_pages
+    assert base_pages + JOURNAL_PAGES <= partition_pages
+    journal = partition_pages - JOURNAL_PAGES
+    slots = BACKUP_PAGES + 1
+    if page_at(journal)[:16] != header and \
+            checksum(flash[:page_count * PAGE_SIZE]) != new_sum:
+        assert checksum(flash[:base_pages * PAGE_SIZE]) == base_sum
+        write(journal, header + b'\xff' * (PAGE_SIZE - 16))
+    pos = 16
+    backup = {}
+    for dest in range(page_count):
+        src, run_count, _, old_sum, page_sum = \
+            struct.unpack_from('<IHHII', patch, pos)
+        pos += 16
+        current = page_at(dest)
+        saved = page_at(journal + 1 + dest % slots)
+        lost = False
+        if dest >= base_pages:
+            lost = True
+        elif page_checksum(current) == old_sum:
+            backup[dest] = current
+        elif page_checksum(saved) == old_sum:
+            backup[dest] = saved
+        else:
+            lost = True
+        skip = page_checksum(current) == page_sum
+        if skip:
+            page = None
+        elif src == SRC_BLANK:
+            page = bytearray(b'\xff' * PAGE_SIZE)
+        else:
+            assert src // PAGE_SIZE + BACKUP_PAGES >= dest
+            assert src + PAGE_SIZE <= base_pages * PAGE_SIZE
+            page = bytearray(PAGE_SIZE)
+            for i in range(PAGE_SIZE):
+                off = src + i
+                if off // PAGE_SIZE <= dest and \
+                        off // PAGE_SIZE in backup:
+                    page[i] = backup[off // PAGE_SIZE][off % PAGE_SIZE]
+                else:
+                    assert off // PAGE_SIZE > dest
+                    page[i] = flash[off]
+        for _ in range(run_count):
+            offset, length = struct.unpack_from('<HH', patch, pos)
+            pos += 4
+            if page is not None:
+                page[offset:offset + length] = patch[pos:pos + length]
+            pos += length
+        backup.pop(dest - BACKUP_PAGES, None)
+        if page is None or page == current:
+            continue
+        if not lost:
+            write(journal + 1 + dest % slots, backup[dest])
+        write(dest, page)
+    assert checksum(flash[:page_count * PAGE_SIZE]) == new_sum
+    write(journal, b'\xff' * PAGE_SIZE)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="""Generate a patch
+        stream turning the image of a flash partition into a new one.""")
+    parser.add_argument('--partition_pages', type=int, default=0,
+        help='size of the partition in pages, checks that the patch applies')
+    parser.add_argument('old', help='image currently in the partition')
+    parser.add_argument('new', help='new image')
+    parser.add_argument('patch', help='output patch file')
+    args = parser.parse_args(argv)
+
+    old = bytearray(open(args.old, 'rb').read())
+    new = bytearray(open(args.new, 'rb').read())
+    patch = make_patch(old, new)
+
+    if args.partition_pages:
+        flash = apply_patch(old, args.partition_pages, patch)
+        assert flash[:len(new)] == new
+        # Power loss in the middle of the patch
+        flash = apply_patch(old, args.partition_pages, patch, cut=5)
+        assert flash[:len(new)] == new
+
+    open(args.patch, 'wb').write(patch)
+    print("%s: %d bytes, %d%% of the new image" %
+          (args.patch, len(patch), 100 * len(patch) // max(len(new), 1)))
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,232 @@
+#!/usr/bin/python
+# -*- coding: utf-8 -*-
+
+#
+# Copyright (c) 2016, Intel Corporation
+# All rights reserved.
+# 
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+# 
+# 1. Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the following disclaimer.
+# 
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+# 
+# 3. Neither the name of the copyright holder nor the names of its
+# contributors may be used to endorse or promote products derived from this
+# software without specific prior written permission.
+# 
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+"""
+Decode the log messages still in the circular log buffer of a RAM dump.
+
+The buffer is found through the log_buffer symbol of the ELF image. With
+CONFIG_LOG_CBUFFER_DEFERRED, messages taking only integer arguments are
+stored as a pointer on their format string followed by the raw argument
+words: the format strings are read from the ELF image and the messages are
+formatted here, as log_format_deferred() does on the target.
+
+Usage: decode_log.py [--modules FILE] ELF DUMP ADDRESS
+    ELF      image the dump was taken from
+    DUMP     raw memory dump holding log_buffer and its storage
+    ADDRESS  address of the first byte of DUMP
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+# Kinds of message payload, see log_impl_cbuffer.c
+LOG_MESSAGE_TEXT = 0
+LOG_MESSAGE_DEFERRED = 1
+
+# Packed log_message_t header, see log_impl.h
+LOG_HEADER = struct.Struct("<BBBBIBB")
+
+# Size of the text of a message, see log.h
+LOG_MAX_MSG_LEN = 80
+
+LEVELS = ["ERROR", "WARN", "INFO", "DEBUG"]
+
+HEADER_FORMAT = "%9u|%3.3s|%8.8s|%5.5s| "
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\*|[0-9]*)(\.(?:\*|[0-9]*))?(hh|h|z|l)?([diuxXocp%])")
+
+class ElfImage(object):
+    """
+    Sections and symbols of a little-endian ELF image
+    """
+
+    def __init__(self, path):
+        with open(path, "rb") as elf:
+            self.data = elf.read()
+        if self.data[:4] != b"\x7fELF" or bytearray(self.data)[5] != 1:
+            raise ValueError("%s is not a little-endian ELF image" % path)
+        self.is64 = bytearray(self.data)[4] == 2
+        self.pointer_size = 8 if self.is64 else 4
+        if self.is64:
+            shoff, = struct.unpack_from("<Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x3a)
+            shdr = struct.Struct("<IIQQQQIIQQ")
+        else:
+            shoff, = struct.unpack_from("<I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2e)
+            shdr = struct.Struct("<IIIIIIIIII")
+        # (type, addr, offset, size, link, entsize)
+        self.sections = []
+        for i in range(shnum):
+            _, stype, _, addr, offset, size, link, _, _, entsize = \
+                shdr.unpack_from(self.data, shoff + i * shentsize)
+            self.sections.append((stype, addr, offset, size, link, entsize))
+
+    def symbol(self, name):
+        """ Return the address of a symbol, or None """
+        sym = struct.Struct("<IBBHQQ" if self.is64 else "<IIIBBH")
+        for stype, _, offset, size, link, entsize in self.sections:
+            if stype != 2: # SHT_SYMTAB
+                continue
+            strtab = self.sections[link]
+            for pos in range(offset, offset + size, entsize):
+                fields = sym.unpack_from(self.data, pos)
+                value = fields[4] if self.is64 else fields[1]
+                start = strtab[2] + fields[0]
+                end = self.data.index(b"\0", start)
+                if self.data[start:end] == name.encode():
+                    return value
+        return None
+
+    def string(self, address):
+        """ Return the C string at address, or None """
+        for stype, addr, offset, size, _, _ in self.sections:
+            if stype == 1 and addr <= address < addr + size: # SHT_PROGBITS
+                start = offset + address - addr
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("latin-1")
+        return None
+
+def read_modules(path):
+    """ Return the module names declared in a log_modules file """
+    names = []
+    with open(path) as modules:
+        for line in modules:
+            match = re.match(r'\s*DEFINE_LOGGER_MODULE\(\s*\w+\s*,\s*"([^"]*)"', line)
+            if match:
+                names.append(match.group(1))
+    return names
+
+def format_deferred(fmt, args):
+    """ Format 32-bit argument words as printf would on the target """
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    def convert(match):
+        flags, width, precision, length, conv = match.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(struct.unpack("<i", struct.pack("<I", next_arg()))[0])
+        if precision == ".*":
+            precision = "." + str(struct.unpack("<i", struct.pack("<I", next_arg()))[0])
+        value = next_arg()
+        bits = {"hh": 8, "h": 16}.get(length, 32)
+        value &= (1 << bits) - 1
+        if conv in "di":
+            if value >= 1 << (bits - 1):
+                value -= 1 << bits
+            conv = "d"
+        elif conv == "u":
+            conv = "d"
+        elif conv == "c":
+            value &= 0xff
+        elif conv == "p":
+            flags, conv = "#", "x"
+        elif conv == "o" and "#" in flags:
+            # C prefixes a single 0, python prefixes 0o
+            digits = ("%" + (precision or "") + "o") % value
+            if not digits.startswith("0"):
+                digits = "0" + digits
+            width = int(width or 0)
+            if "-" in flags:
+                return digits.ljust(width)
+            return digits.zfill(width) if "0" in flags else digits.rjust(width)
+        return ("%" + flags + width + (precision or "") + conv) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+def decode(elf, dump, base, modules):
+    """ Yield the lines of the messages of the log buffer """
+    def read(address, size):
+        start = address - base
+        if start < 0 or start + size > len(dump):
+            raise ValueError("0x%x is not in the dump" % address)
+        return dump[start:start + size]
+
+    cbuffer = elf.symbol("log_buffer")
+    if cbuffer is None:
+        raise ValueError("no log_buffer symbol, is CONFIG_LOG_CBUFFER set?")
+    # cbuffer_t, see util/cbuffer.h
+    if elf.is64:
+        r, w, _, buf, buf_size, dropped = struct.unpack("<IIB7xQII", read(cbuffer, 32))
+    else:
+        r, w, _, buf, buf_size, dropped = struct.unpack("<IIB3xIII", read(cbuffer, 24))
+    storage = bytearray(read(buf, buf_size))
+    if dropped:
+        # the log task reports the count in a byte
+        yield "-- %u log messages lost --" % min(dropped, 255)
+
+    while r != w:
+        length = storage[r]
+        record = bytearray((storage + storage)[r + 1:r + 1 + length])
+        r = (r + 1 + length) % buf_size
+
+        _, size, level, module, timestamp, cpu_id, kind = LOG_HEADER.unpack_from(record)
+        payload = record[LOG_HEADER.size:LOG_HEADER.size + size]
+        if kind == LOG_MESSAGE_DEFERRED:
+            address = struct.unpack_from("<Q" if elf.is64 else "<I", payload)[0]
+            words = struct.unpack_from("<%dI" % ((size - elf.pointer_size) // 4),
+                                       payload, elf.pointer_size)
+            fmt = elf.string(address)
+            # snprintf truncates the text to the size of the message
+            text = format_deferred(fmt, words)[:LOG_MAX_MSG_LEN - 1] if fmt is not None \
+                else "<format at 0x%x not found>" % address
+        else:
+            text = payload.decode("latin-1")
+
+        module = modules[module] if module < len(modules) else str(module)
+        level = LEVELS[level] if level < len(LEVELS) else str(level)
+        yield HEADER_FORMAT % (timestamp, str(cpu_id), module, level) + text
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the log buffer of a RAM dump")
+    parser.add_argument("--modules", help="log_modules file giving the module names")
+    parser.add_argument("elf", help="ELF image the dump was taken from")
+    parser.add_argument("dump", help="raw memory dump")
+    parser.add_argument("address", help="address of the first byte of the dump")
+    args = parser.parse_args(sys.argv[1:])
+
+    elf = ElfImage(args.elf)
+    with open(args.dump, "rb") as dump:
+        data = dump.read()
+    modules = read_modules(args.modules) if args.modules else []
+    for line in decode(elf, data, int(args.address, 0), modules):
+        print(line)
+
+if __name__ == "__main__":
+    main()